@@ -365,6 +365,26 @@ DEPENDENCY_REPOSITORIES_SPEC = dict(
         use_category = ["dataplane"],
         cpe = "cpe:2.3:a:gnu:zlib:*",
     ),
+    org_brotli = dict(
+        project_name = "brotli",
+        project_url = "https://brotli.org",
+        version = "1.0.9",
+        sha256 = "f9e8d81d0405ba66d181529af42a3354f838c939095ff99930da6aa9cdf6fe46",
+        strip_prefix = "brotli-{version}",
+        urls = ["https://github.com/google/brotli/archive/v{version}.tar.gz"],
+        use_category = ["dataplane"],
+        cpe = "cpe:2.3:a:google:brotli:*",
+    ),
+    com_github_facebook_zstd = dict(
+        project_name = "zstd",
+        project_url = "https://facebook.github.io/zstd",
+        version = "1.4.5",
+        sha256 = "98e91c7c6bf162bf90e4e70fdbc41a8188b9fa8de5ad840c401198014406ce9e",
+        strip_prefix = "zstd-{version}",
+        urls = ["https://github.com/facebook/zstd/releases/download/v{version}/zstd-{version}.tar.gz"],
+        use_category = ["dataplane"],
+        cpe = "N/A",
+    ),
     com_github_jbeder_yaml_cpp = dict(
         project_name = "yaml-cpp",
         project_url = "https://github.com/jbeder/yaml-cpp",
@@ -55,6 +55,22 @@ public:
    * absl::nullopt.
    */
   virtual Http::Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() PURE;
+
+  /**
+   * Generates the next chunk of a chunked response by appending it to the supplied buffer.
+   * @return bool true if more chunks follow, false if the response is complete.
+   */
+  using ChunkGenerator = std::function<bool(Buffer::Instance& response)>;
+
+  /**
+   * Sends the remainder of the response in chunks produced by the generator, one chunk per
+   * dispatcher iteration, so that large responses do not block the main thread and are not
+   * buffered in full. Chunks are paused while the downstream connection is above its write buffer
+   * high watermark. Whatever the handler wrote to the response buffer is sent first. Must be
+   * called from within the handler.
+   * @param generator supplies the generator of the remaining chunks.
+   */
+  virtual void setChunkedResponse(ChunkGenerator generator) PURE;
 };
 
 /**
@@ -58,6 +58,22 @@ public:
   virtual const SymbolTable& constSymbolTable() const PURE;
   virtual SymbolTable& symbolTable() PURE;
 
+  /**
+   * Starts tracking the counters and gauges which change, so that they can be collected with
+   * collectChangedStats(). All the existing counters and gauges are considered changed. Tracking
+   * can't be stopped, and calling this again has no effect.
+   */
+  virtual void trackChangedStats() PURE;
+
+  /**
+   * Collects the counters and gauges which changed since the previous collection, and clears their
+   * changed state. trackChangedStats() must have been called.
+   * @param counters supplies the vector to which the changed counters are added.
+   * @param gauges supplies the vector to which the changed gauges are added.
+   */
+  virtual void collectChangedStats(std::vector<CounterSharedPtr>& counters,
+                                   std::vector<GaugeSharedPtr>& gauges) PURE;
+
   // TODO(jmarantz): create a parallel mechanism to instantiate histograms. At
   // the moment, histograms don't fit the same pattern of counters and gauges
   // as they are not actually created in the context of a stats allocator.
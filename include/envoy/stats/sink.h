@@ -55,6 +55,15 @@ public:
    */
   virtual void flush(MetricSnapshot& snapshot) PURE;
 
+  /**
+   * Called before each flush. A sink which only needs the metrics which changed since the
+   * previous flush gets a snapshot of the changed counters and gauges, and of the histograms which
+   * have samples in the last interval, which is cheaper to build for large configurations. Text
+   * readouts are always all in the snapshot.
+   * @return whether the next flush may only contain the changed metrics.
+   */
+  virtual bool changedMetricsOnly() const { return false; }
+
   /**
    * Flush a single histogram sample. Note: this call is called synchronously as a part of recording
    * the metric, so implementations must be thread-safe.
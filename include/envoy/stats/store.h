@@ -48,6 +48,29 @@ public:
    * @return a list of all known histograms.
    */
   virtual std::vector<ParentHistogramSharedPtr> histograms() const PURE;
+
+  /**
+   * The counters and gauges which changed since the previous collection.
+   */
+  struct ChangedMetrics {
+    std::vector<CounterSharedPtr> counters_;
+    std::vector<GaugeSharedPtr> gauges_;
+  };
+
+  /**
+   * Starts tracking the counters and gauges which change, so that they can be collected with
+   * collectChangedMetrics(). Tracking costs a little on the first update of a stat after each
+   * collection, and can't be stopped. Calling this again has no effect.
+   */
+  virtual void trackChangedMetrics() PURE;
+
+  /**
+   * Collects the counters and gauges which changed since the previous collection. The first
+   * collection after trackChangedMetrics() returns all the counters and gauges. As for gauges(),
+   * gauges whose import mode is not initialized yet are not returned.
+   * @return the changed counters and gauges.
+   */
+  virtual ChangedMetrics collectChangedMetrics() PURE;
 };
 
 using StorePtr = std::unique_ptr<Store>;
@@ -174,6 +174,15 @@ public:
    * @param key baggage value
    */
   virtual void setBaggage(absl::string_view key, absl::string_view value) PURE;
+
+  /**
+   * A span which is not recording, e.g. a span of a trace which is not sampled which is only used
+   * to propagate the trace context, ignores its operation name, tags and logs, so that the callers
+   * may skip computing them. A span may start recording once setSampled(true) is called, so the
+   * callers should check this before computing them rather than keep its earlier result.
+   * @return whether the span currently records its operation name, tags and logs.
+   */
+  virtual bool isRecording() const PURE;
 };
 
 /**
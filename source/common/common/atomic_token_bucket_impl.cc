@@ -0,0 +1,75 @@
+#include "common/common/atomic_token_bucket_impl.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+
+AtomicTokenBucketImpl::AtomicTokenBucketImpl(uint64_t max_tokens, TimeSource& time_source,
+                                             double fill_rate)
+    : max_tokens_(max_tokens), fill_rate_(std::abs(fill_rate)), time_source_(time_source),
+      empty_time_(timeNowInSeconds() - max_tokens_ / fill_rate_) {
+  ASSERT(fill_rate_ > 0);
+}
+
+uint64_t AtomicTokenBucketImpl::consume(uint64_t tokens, bool allow_partial) {
+  const double now = timeNowInSeconds();
+  // Relaxed consistency is used for all operations because we don't care about ordering, just the
+  // final atomic correctness.
+  double expected_empty_time = empty_time_.load(std::memory_order_relaxed);
+  double new_empty_time;
+  uint64_t consumed;
+  do {
+    // expected_empty_time is either initialized above or reloaded during the CAS failure below.
+    const double available = tokensAt(now, expected_empty_time);
+    consumed = tokens;
+    if (available < tokens) {
+      if (!allow_partial) {
+        return 0;
+      }
+      consumed = static_cast<uint64_t>(std::floor(available));
+    }
+    if (consumed == 0) {
+      return 0;
+    }
+    // The bucket holds available - consumed tokens from now on, so it was empty that many fill
+    // periods ago.
+    new_empty_time = now - (available - consumed) / fill_rate_;
+
+    // Testing hook.
+    synchronizer_.syncPoint("consume_pre_cas");
+
+    // Loop while the weak CAS fails trying to update the empty time.
+  } while (!empty_time_.compare_exchange_weak(expected_empty_time, new_empty_time,
+                                              std::memory_order_relaxed));
+
+  return consumed;
+}
+
+std::chrono::milliseconds AtomicTokenBucketImpl::nextTokenAvailable() {
+  const double available =
+      tokensAt(timeNowInSeconds(), empty_time_.load(std::memory_order_relaxed));
+  // If there are tokens available, return immediately.
+  if (available >= 1) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(
+      static_cast<uint64_t>(std::ceil((1 - available) / fill_rate_ * 1000)));
+}
+
+void AtomicTokenBucketImpl::reset(uint64_t num_tokens) {
+  ASSERT(num_tokens <= max_tokens_);
+  empty_time_.store(timeNowInSeconds() - num_tokens / fill_rate_, std::memory_order_relaxed);
+}
+
+double AtomicTokenBucketImpl::timeNowInSeconds() const {
+  return std::chrono::duration<double>(time_source_.monotonicTime().time_since_epoch()).count();
+}
+
+double AtomicTokenBucketImpl::tokensAt(double now, double empty_time) const {
+  return std::min((now - empty_time) * fill_rate_, max_tokens_);
+}
+
+} // namespace Envoy
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+#include "envoy/common/time.h"
+#include "envoy/common/token_bucket.h"
+
+#include "common/common/thread_synchronizer.h"
+
+namespace Envoy {
+
+/**
+ * A class that implements token bucket interface, which is thread-safe without a lock, so that a
+ * single bucket can be shared by all the workers.
+ *
+ * The whole state of the bucket is the time at which it was empty, in a single atomic. The number
+ * of tokens is derived from it: the time elapsed since, multiplied by the fill rate, up to the
+ * maximum. Consuming tokens moves that time forward with a compare and swap, so the bucket is
+ * refilled continuously by every consumer and needs no timer.
+ */
+class AtomicTokenBucketImpl : public TokenBucket {
+public:
+  /**
+   * @param max_tokens supplies the maximum number of tokens in the bucket. The bucket starts full.
+   * @param time_source supplies the time source.
+   * @param fill_rate supplies the number of tokens that will return to the bucket on each second.
+   * It must be greater than 0. The default is 1.
+   */
+  explicit AtomicTokenBucketImpl(uint64_t max_tokens, TimeSource& time_source,
+                                 double fill_rate = 1);
+
+  // TokenBucket
+  uint64_t consume(uint64_t tokens, bool allow_partial) override;
+  std::chrono::milliseconds nextTokenAvailable() override;
+  void reset(uint64_t num_tokens) override;
+
+  Thread::ThreadSynchronizer& synchronizer() { return synchronizer_; } // Used for testing only.
+
+private:
+  double timeNowInSeconds() const;
+  double tokensAt(double now, double empty_time) const;
+
+  const double max_tokens_;
+  const double fill_rate_;
+  TimeSource& time_source_;
+  // The time at which the bucket was empty, in seconds of the monotonic clock.
+  std::atomic<double> empty_time_;
+  Thread::ThreadSynchronizer synchronizer_;
+};
+
+} // namespace Envoy
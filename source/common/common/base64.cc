@@ -1,13 +1,23 @@
 #include "common/common/base64.h"
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
+#include "common/common/macros.h"
 
 #include "absl/container/fixed_array.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BASE64_SIMD_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define BASE64_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Envoy {
 namespace {
 
@@ -140,6 +150,385 @@ inline void encodeLast(uint64_t pos, uint8_t last_char, std::string& ret,
   }
 }
 
+// Vectorized encoding and decoding of the bulk of the input. They handle whole groups of 3 bytes
+// and 4 characters, from the start of the input, and stop early when the rest is too short for a
+// full block, or, when decoding, at the first block with a character outside of the alphabet.
+// The scalar functions above carry on from where they stop, so that the result, including the
+// rejection of invalid input, is the same as if the whole input went through the scalar functions.
+// Both alphabets differ only in their two last characters, which are passed to the vector code.
+
+#if defined(BASE64_SIMD_X86)
+
+// SSSE3 and AVX2 aren't part of the x86-64 baseline, so they are compiled for their target only and
+// picked at runtime.
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+
+enum class SimdLevel { None, Ssse3, Avx2 };
+
+SimdLevel detectSimdLevel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::Avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return SimdLevel::Ssse3;
+  }
+  return SimdLevel::None;
+}
+
+SimdLevel simdLevel() {
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+// Spreads the first 12 bytes of the input over 16 bytes holding 6 bits each, as described in
+// http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html.
+BASE64_TARGET_SSSE3 inline __m128i encodeUnpack(__m128i input) {
+  input = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  const __m128i high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)),
+                                       _mm_set1_epi32(0x04000040));
+  const __m128i low = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)),
+                                      _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(high, low);
+}
+
+// Maps 6 bit values to characters, by adding the offset of the range of the alphabet they fall in.
+BASE64_TARGET_SSSE3 inline __m128i encodeTranslate(__m128i indices, char c62, char c63) {
+  __m128i offset = _mm_set1_epi8('A');
+  offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(25)),
+                                              _mm_set1_epi8('a' - 26 - 'A')));
+  offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(51)),
+                                              _mm_set1_epi8('0' - 52 - ('a' - 26))));
+  offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(62)),
+                                              _mm_set1_epi8(c62 - 62 - ('0' - 52))));
+  offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(63)),
+                                              _mm_set1_epi8(c63 - 63 - ('0' - 52))));
+  return _mm_add_epi8(indices, offset);
+}
+
+// Returns a mask of the bytes of the input which are in [lo, hi].
+BASE64_TARGET_SSSE3 inline __m128i inRange(__m128i input, char lo, char hi) {
+  const __m128i shifted = _mm_sub_epi8(input, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(hi - lo)), shifted);
+}
+
+// Maps characters to their 6 bit values. Returns false if any character is not in the alphabet.
+BASE64_TARGET_SSSE3 inline bool decodeTranslate(__m128i chars, char c62, char c63,
+                                                __m128i& values) {
+  const __m128i upper = inRange(chars, 'A', 'Z');
+  const __m128i lower = inRange(chars, 'a', 'z');
+  const __m128i digit = inRange(chars, '0', '9');
+  const __m128i is62 = _mm_cmpeq_epi8(chars, _mm_set1_epi8(c62));
+  const __m128i is63 = _mm_cmpeq_epi8(chars, _mm_set1_epi8(c63));
+  const __m128i valid =
+      _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, is62)), is63);
+  if (_mm_movemask_epi8(valid) != 0xffff) {
+    return false;
+  }
+  const __m128i offset = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                   _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+      _mm_or_si128(_mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                                _mm_and_si128(is62, _mm_set1_epi8(62 - c62))),
+                   _mm_and_si128(is63, _mm_set1_epi8(63 - c63))));
+  values = _mm_add_epi8(chars, offset);
+  return true;
+}
+
+// Packs 16 6 bit values into the first 12 bytes of the result.
+BASE64_TARGET_SSSE3 inline __m128i decodePack(__m128i values) {
+  const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)),
+                                        _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(merged,
+                          _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+inline void store12(uint8_t* dst, __m128i bytes) {
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), bytes);
+  const uint32_t high = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+  memcpy(dst + 8, &high, sizeof(high));
+}
+
+BASE64_TARGET_SSSE3 size_t encodeSsse3(const uint8_t* src, size_t length, char* dst, char c62,
+                                       char c63) {
+  size_t i = 0;
+  // Each block loads 16 bytes and encodes the first 12 of them.
+  for (; i + 16 <= length; i += 12, dst += 16) {
+    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     encodeTranslate(encodeUnpack(input), c62, c63));
+  }
+  return i;
+}
+
+BASE64_TARGET_SSSE3 size_t decodeSsse3(const char* src, size_t length, uint8_t* dst, char c62,
+                                       char c63) {
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16, dst += 12) {
+    __m128i values;
+    if (!decodeTranslate(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), c62, c63,
+                         values)) {
+      break;
+    }
+    store12(dst, decodePack(values));
+  }
+  return i;
+}
+
+// The AVX2 versions work on two 128 bit lanes, each of them like the SSSE3 versions above.
+
+BASE64_TARGET_AVX2 inline __m256i encodeUnpack(__m256i input) {
+  input = _mm256_shuffle_epi8(input, _mm256_broadcastsi128_si256(_mm_setr_epi8(
+                                         1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)));
+  const __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)),
+                                          _mm256_set1_epi32(0x04000040));
+  const __m256i low = _mm256_mullo_epi16(_mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)),
+                                         _mm256_set1_epi32(0x01000010));
+  return _mm256_or_si256(high, low);
+}
+
+BASE64_TARGET_AVX2 inline __m256i encodeTranslate(__m256i indices, char c62, char c63) {
+  __m256i offset = _mm256_set1_epi8('A');
+  offset = _mm256_add_epi8(
+      offset, _mm256_and_si256(_mm256_cmpgt_epi8(indices, _mm256_set1_epi8(25)),
+                               _mm256_set1_epi8('a' - 26 - 'A')));
+  offset = _mm256_add_epi8(
+      offset, _mm256_and_si256(_mm256_cmpgt_epi8(indices, _mm256_set1_epi8(51)),
+                               _mm256_set1_epi8('0' - 52 - ('a' - 26))));
+  offset = _mm256_add_epi8(
+      offset, _mm256_and_si256(_mm256_cmpeq_epi8(indices, _mm256_set1_epi8(62)),
+                               _mm256_set1_epi8(c62 - 62 - ('0' - 52))));
+  offset = _mm256_add_epi8(
+      offset, _mm256_and_si256(_mm256_cmpeq_epi8(indices, _mm256_set1_epi8(63)),
+                               _mm256_set1_epi8(c63 - 63 - ('0' - 52))));
+  return _mm256_add_epi8(indices, offset);
+}
+
+BASE64_TARGET_AVX2 inline __m256i inRange(__m256i input, char lo, char hi) {
+  const __m256i shifted = _mm256_sub_epi8(input, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(hi - lo)), shifted);
+}
+
+BASE64_TARGET_AVX2 inline bool decodeTranslate(__m256i chars, char c62, char c63,
+                                               __m256i& values) {
+  const __m256i upper = inRange(chars, 'A', 'Z');
+  const __m256i lower = inRange(chars, 'a', 'z');
+  const __m256i digit = inRange(chars, '0', '9');
+  const __m256i is62 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c62));
+  const __m256i is63 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c63));
+  const __m256i valid = _mm256_or_si256(
+      _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, is62)), is63);
+  if (_mm256_movemask_epi8(valid) != -1) {
+    return false;
+  }
+  const __m256i offset = _mm256_or_si256(
+      _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                      _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+      _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                                      _mm256_and_si256(is62, _mm256_set1_epi8(62 - c62))),
+                      _mm256_and_si256(is63, _mm256_set1_epi8(63 - c63))));
+  values = _mm256_add_epi8(chars, offset);
+  return true;
+}
+
+BASE64_TARGET_AVX2 inline __m256i decodePack(__m256i values) {
+  const __m256i merged =
+      _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+                        _mm256_set1_epi32(0x00011000));
+  return _mm256_shuffle_epi8(merged, _mm256_broadcastsi128_si256(_mm_setr_epi8(
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+}
+
+BASE64_TARGET_AVX2 size_t encodeAvx2(const uint8_t* src, size_t length, char* dst, char c62,
+                                     char c63) {
+  size_t i = 0;
+  // Each block loads 16 bytes at offsets 0 and 12, and encodes the 24 first bytes.
+  for (; i + 28 <= length; i += 24, dst += 32) {
+    const __m256i input = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12)), 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        encodeTranslate(encodeUnpack(input), c62, c63));
+  }
+  return i + encodeSsse3(src + i, length - i, dst, c62, c63);
+}
+
+BASE64_TARGET_AVX2 size_t decodeAvx2(const char* src, size_t length, uint8_t* dst, char c62,
+                                     char c63) {
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32, dst += 24) {
+    __m256i values;
+    if (!decodeTranslate(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), c62,
+                         c63, values)) {
+      break;
+    }
+    const __m256i bytes = decodePack(values);
+    store12(dst, _mm256_castsi256_si128(bytes));
+    store12(dst + 12, _mm256_extracti128_si256(bytes, 1));
+  }
+  return i + decodeSsse3(src + i, length - i, dst, c62, c63);
+}
+
+constexpr size_t MIN_SIMD_ENCODE_LENGTH = 16;
+constexpr size_t MIN_SIMD_DECODE_LENGTH = 16;
+
+size_t encodeSimd(const uint8_t* src, size_t length, char* dst, const char* const char_table) {
+  switch (simdLevel()) {
+  case SimdLevel::Avx2:
+    return encodeAvx2(src, length, dst, char_table[62], char_table[63]);
+  case SimdLevel::Ssse3:
+    return encodeSsse3(src, length, dst, char_table[62], char_table[63]);
+  case SimdLevel::None:
+    break;
+  }
+  return 0;
+}
+
+size_t decodeSimd(const char* src, size_t length, uint8_t* dst, const char* const char_table) {
+  switch (simdLevel()) {
+  case SimdLevel::Avx2:
+    return decodeAvx2(src, length, dst, char_table[62], char_table[63]);
+  case SimdLevel::Ssse3:
+    return decodeSsse3(src, length, dst, char_table[62], char_table[63]);
+  case SimdLevel::None:
+    break;
+  }
+  return 0;
+}
+
+#define BASE64_SIMD
+
+#elif defined(BASE64_SIMD_NEON)
+
+// NEON is part of the AArch64 baseline. The interleaving loads and stores split and merge the 3
+// byte groups and the 4 character groups, so that each vector holds one byte of each group.
+
+inline uint8x16_t inRange(uint8x16_t input, uint8_t lo, uint8_t hi) {
+  return vcleq_u8(vsubq_u8(input, vdupq_n_u8(lo)), vdupq_n_u8(hi - lo));
+}
+
+// Maps characters to their 6 bit values, and clears the bytes of `valid` for the characters which
+// are not in the alphabet.
+inline uint8x16_t decodeTranslate(uint8x16_t chars, uint8_t c62, uint8_t c63, uint8x16_t& valid) {
+  const uint8x16_t upper = inRange(chars, 'A', 'Z');
+  const uint8x16_t lower = inRange(chars, 'a', 'z');
+  const uint8x16_t digit = inRange(chars, '0', '9');
+  const uint8x16_t is62 = vceqq_u8(chars, vdupq_n_u8(c62));
+  const uint8x16_t is63 = vceqq_u8(chars, vdupq_n_u8(c63));
+  valid = vandq_u8(valid, vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, is62)), is63));
+  const uint8x16_t offset = vorrq_u8(
+      vorrq_u8(vandq_u8(upper, vdupq_n_u8(static_cast<uint8_t>(-'A'))),
+               vandq_u8(lower, vdupq_n_u8(static_cast<uint8_t>(26 - 'a')))),
+      vorrq_u8(vorrq_u8(vandq_u8(digit, vdupq_n_u8(52 - '0')),
+                        vandq_u8(is62, vdupq_n_u8(static_cast<uint8_t>(62 - c62)))),
+               vandq_u8(is63, vdupq_n_u8(static_cast<uint8_t>(63 - c63)))));
+  return vaddq_u8(chars, offset);
+}
+
+size_t encodeNeon(const uint8_t* src, size_t length, char* dst, const char* const char_table) {
+  const uint8_t* const table_bytes = reinterpret_cast<const uint8_t*>(char_table);
+  const uint8x16x4_t table = {{vld1q_u8(table_bytes), vld1q_u8(table_bytes + 16),
+                               vld1q_u8(table_bytes + 32), vld1q_u8(table_bytes + 48)}};
+  const uint8x16_t mask = vdupq_n_u8(0x3f);
+  size_t i = 0;
+  for (; i + 48 <= length; i += 48, dst += 64) {
+    const uint8x16x3_t input = vld3q_u8(src + i);
+    uint8x16x4_t output;
+    output.val[0] = vqtbl4q_u8(table, vshrq_n_u8(input.val[0], 2));
+    output.val[1] = vqtbl4q_u8(
+        table, vandq_u8(vorrq_u8(vshlq_n_u8(input.val[0], 4), vshrq_n_u8(input.val[1], 4)), mask));
+    output.val[2] = vqtbl4q_u8(
+        table, vandq_u8(vorrq_u8(vshlq_n_u8(input.val[1], 2), vshrq_n_u8(input.val[2], 6)), mask));
+    output.val[3] = vqtbl4q_u8(table, vandq_u8(input.val[2], mask));
+    vst4q_u8(reinterpret_cast<uint8_t*>(dst), output);
+  }
+  return i;
+}
+
+size_t decodeNeon(const char* src, size_t length, uint8_t* dst, const char* const char_table) {
+  const uint8_t c62 = char_table[62];
+  const uint8_t c63 = char_table[63];
+  size_t i = 0;
+  for (; i + 64 <= length; i += 64, dst += 48) {
+    const uint8x16x4_t input = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+    uint8x16_t valid = vdupq_n_u8(0xff);
+    const uint8x16_t a = decodeTranslate(input.val[0], c62, c63, valid);
+    const uint8x16_t b = decodeTranslate(input.val[1], c62, c63, valid);
+    const uint8x16_t c = decodeTranslate(input.val[2], c62, c63, valid);
+    const uint8x16_t d = decodeTranslate(input.val[3], c62, c63, valid);
+    if (vminvq_u8(valid) == 0) {
+      break;
+    }
+    uint8x16x3_t output;
+    output.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+    output.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+    output.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+    vst3q_u8(dst, output);
+  }
+  return i;
+}
+
+constexpr size_t MIN_SIMD_ENCODE_LENGTH = 48;
+constexpr size_t MIN_SIMD_DECODE_LENGTH = 64;
+
+size_t encodeSimd(const uint8_t* src, size_t length, char* dst, const char* const char_table) {
+  return encodeNeon(src, length, dst, char_table);
+}
+
+size_t decodeSimd(const char* src, size_t length, uint8_t* dst, const char* const char_table) {
+  return decodeNeon(src, length, dst, char_table);
+}
+
+#define BASE64_SIMD
+
+#endif
+
+// Encodes the bulk of the input, and appends it to ret. Returns the number of bytes encoded, which
+// is a multiple of 3.
+inline uint64_t encodeBulk(const uint8_t* input, uint64_t length, std::string& ret,
+                           const char* const char_table) {
+#if defined(BASE64_SIMD)
+  if (length < MIN_SIMD_ENCODE_LENGTH) {
+    return 0;
+  }
+  const size_t start = ret.size();
+  ret.resize(start + length / 3 * 4);
+  const uint64_t encoded = encodeSimd(input, length, &ret[start], char_table);
+  ret.resize(start + encoded / 3 * 4);
+  return encoded;
+#else
+  UNREFERENCED_PARAMETER(input);
+  UNREFERENCED_PARAMETER(length);
+  UNREFERENCED_PARAMETER(ret);
+  UNREFERENCED_PARAMETER(char_table);
+  return 0;
+#endif
+}
+
+// Decodes the bulk of the input, and appends it to ret. Returns the number of characters decoded,
+// which is a multiple of 4. The input must start at a group of 4 characters.
+inline uint64_t decodeBulk(const char* input, uint64_t length, std::string& ret,
+                           const char* const char_table) {
+#if defined(BASE64_SIMD)
+  if (length < MIN_SIMD_DECODE_LENGTH) {
+    return 0;
+  }
+  const size_t start = ret.size();
+  ret.resize(start + length / 4 * 3);
+  const uint64_t decoded =
+      decodeSimd(input, length, reinterpret_cast<uint8_t*>(&ret[start]), char_table);
+  ret.resize(start + decoded / 4 * 3);
+  return decoded;
+#else
+  UNREFERENCED_PARAMETER(input);
+  UNREFERENCED_PARAMETER(length);
+  UNREFERENCED_PARAMETER(ret);
+  UNREFERENCED_PARAMETER(char_table);
+  return 0;
+#endif
+}
+
 } // namespace
 
 std::string Base64::decode(const std::string& input) {
@@ -162,6 +551,9 @@ std::string Base64::decodeWithoutPadding(absl::string_view input) {
       n--;
     }
   }
+  if (n == 0) {
+    return EMPTY_STRING;
+  }
   // Last position before "valid" padding character.
   uint64_t last = n - 1;
   // Determine output length.
@@ -175,7 +567,7 @@ std::string Base64::decodeWithoutPadding(absl::string_view input) {
 
   std::string ret;
   ret.reserve(max_length);
-  for (uint64_t i = 0; i < last; ++i) {
+  for (uint64_t i = decodeBulk(input.data(), last, ret, CHAR_TABLE); i < last; ++i) {
     if (!decodeBase(input[i], i, ret, REVERSE_LOOKUP_TABLE)) {
       return EMPTY_STRING;
     }
@@ -199,7 +591,12 @@ std::string Base64::encode(const Buffer::Instance& buffer, uint64_t length) {
   for (const Buffer::RawSlice& slice : buffer.getRawSlices()) {
     const uint8_t* slice_mem = static_cast<const uint8_t*>(slice.mem_);
 
-    for (uint64_t i = 0; i < slice.len_ && j < length; ++i, ++j) {
+    uint64_t i = 0;
+    if (j % 3 == 0) {
+      i = encodeBulk(slice_mem, std::min<uint64_t>(slice.len_, length - j), ret, CHAR_TABLE);
+      j += i;
+    }
+    for (; i < slice.len_ && j < length; ++i, ++j) {
       encodeBase(slice_mem[i], j, next_c, ret, CHAR_TABLE);
     }
 
@@ -222,10 +619,10 @@ std::string Base64::encode(const char* input, uint64_t length, bool add_padding)
   std::string ret;
   ret.reserve(output_length);
 
-  uint64_t pos = 0;
+  uint64_t pos = encodeBulk(reinterpret_cast<const uint8_t*>(input), length, ret, CHAR_TABLE);
   uint8_t next_c = 0;
 
-  for (uint64_t i = 0; i < length; ++i) {
+  for (uint64_t i = pos; i < length; ++i) {
     encodeBase(input[i], pos++, next_c, ret, CHAR_TABLE);
   }
 
@@ -243,7 +640,7 @@ std::string Base64Url::decode(const std::string& input) {
   ret.reserve(input.length() / 4 * 3 + 3);
 
   uint64_t last = input.length() - 1;
-  for (uint64_t i = 0; i < last; ++i) {
+  for (uint64_t i = decodeBulk(input.data(), last, ret, URL_CHAR_TABLE); i < last; ++i) {
     if (!decodeBase(input[i], i, ret, URL_REVERSE_LOOKUP_TABLE)) {
       return EMPTY_STRING;
     }
@@ -261,10 +658,10 @@ std::string Base64Url::encode(const char* input, uint64_t length) {
   std::string ret;
   ret.reserve(output_length);
 
-  uint64_t pos = 0;
+  uint64_t pos = encodeBulk(reinterpret_cast<const uint8_t*>(input), length, ret, URL_CHAR_TABLE);
   uint8_t next_c = 0;
 
-  for (uint64_t i = 0; i < length; ++i) {
+  for (uint64_t i = pos; i < length; ++i) {
     encodeBase(input[i], pos++, next_c, ret, URL_CHAR_TABLE);
   }
 
@@ -39,6 +39,7 @@ DispatcherImpl::DispatcherImpl(const std::string& name, Api::Api& api,
 DispatcherImpl::DispatcherImpl(const std::string& name, Buffer::WatermarkFactoryPtr&& factory,
                                Api::Api& api, Event::TimeSystem& time_system)
     : name_(name), api_(api), buffer_factory_(std::move(factory)),
+      slow_callback_tracer_(name, api.timeSource()),
       scheduler_(time_system.createScheduler(base_scheduler_, base_scheduler_)),
       deferred_delete_cb_(base_scheduler_.createSchedulableCallback(
           [this]() -> void { clearDeferredDeleteList(); })),
@@ -46,6 +47,7 @@ DispatcherImpl::DispatcherImpl(const std::string& name, Buffer::WatermarkFactory
       current_to_delete_(&to_delete_1_) {
   ASSERT(!name_.empty());
   FatalErrorHandler::registerFatalErrorHandler(*this);
+  base_scheduler_.setSlowCallbackTracer(&slow_callback_tracer_);
   updateApproximateMonotonicTimeInternal();
   base_scheduler_.registerOnPrepareCallback(
       std::bind(&DispatcherImpl::updateApproximateMonotonicTime, this));
@@ -76,6 +78,8 @@ void DispatcherImpl::clearDeferredDeleteList() {
   }
 
   ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
+  SlowCallbackTracer::CallbackScope slow_callback_scope(
+      &slow_callback_tracer_, SlowCallbackTracer::CallbackType::DeferredDelete);
 
   // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
   // use the other vector. We will get another callback to delete that vector.
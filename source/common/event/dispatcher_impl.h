@@ -18,6 +18,7 @@
 #include "common/common/thread.h"
 #include "common/event/libevent.h"
 #include "common/event/libevent_scheduler.h"
+#include "common/event/slow_callback_tracer.h"
 #include "common/signal/fatal_error_handler.h"
 
 namespace Envoy {
@@ -74,12 +75,20 @@ public:
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
   const ScopeTrackedObject* setTrackedObject(const ScopeTrackedObject* object) override {
     const ScopeTrackedObject* return_object = current_object_;
+    if (slow_callback_tracer_.active()) {
+      slow_callback_tracer_.onTrackedObjectChange(current_object_);
+    }
     current_object_ = object;
     return return_object;
   }
   MonotonicTime approximateMonotonicTime() const override;
   void updateApproximateMonotonicTime() override;
 
+  /**
+   * @return SlowCallbackTracer& the tracer of the callbacks run by this dispatcher.
+   */
+  SlowCallbackTracer& slowCallbackTracer() { return slow_callback_tracer_; }
+
   // FatalErrorInterface
   void onFatalError(std::ostream& os) const override {
     // Dump the state of the tracked object if it is in the current thread. This generally results
@@ -109,6 +118,7 @@ private:
   DispatcherStatsPtr stats_;
   Thread::ThreadId run_tid_;
   Buffer::WatermarkFactoryPtr buffer_factory_;
+  SlowCallbackTracer slow_callback_tracer_;
   LibeventScheduler base_scheduler_;
   SchedulerPtr scheduler_;
   SchedulableCallbackPtr deferred_delete_cb_;
@@ -13,7 +13,7 @@ namespace Event {
 
 FileEventImpl::FileEventImpl(DispatcherImpl& dispatcher, os_fd_t fd, FileReadyCb cb,
                              FileTriggerType trigger, uint32_t events)
-    : cb_(cb), fd_(fd), trigger_(trigger),
+    : cb_(cb), slow_callback_tracer_(dispatcher.slowCallbackTracer()), fd_(fd), trigger_(trigger),
       activate_fd_events_next_event_loop_(
           // Only read the runtime feature if the runtime loader singleton has already been created.
           // Attempts to access runtime features too early in the initialization sequence triggers
@@ -122,6 +122,8 @@ void FileEventImpl::setEnabled(uint32_t events) {
 }
 
 void FileEventImpl::mergeInjectedEventsAndRunCb(uint32_t events) {
+  SlowCallbackTracer::CallbackScope slow_callback_scope(
+      &slow_callback_tracer_, SlowCallbackTracer::CallbackType::FileEvent);
   if (activate_fd_events_next_event_loop_ && injected_activation_events_ != 0) {
     events |= injected_activation_events_;
     injected_activation_events_ = 0;
@@ -28,6 +28,7 @@ private:
   void mergeInjectedEventsAndRunCb(uint32_t events);
 
   FileReadyCb cb_;
+  SlowCallbackTracer& slow_callback_tracer_;
   os_fd_t fd_;
   FileTriggerType trigger_;
 
@@ -36,7 +36,7 @@ LibeventScheduler::LibeventScheduler() {
 }
 
 TimerPtr LibeventScheduler::createTimer(const TimerCb& cb, Dispatcher& dispatcher) {
-  return std::make_unique<TimerImpl>(libevent_, cb, dispatcher);
+  return std::make_unique<TimerImpl>(libevent_, cb, dispatcher, slow_callback_tracer_);
 };
 
 SchedulableCallbackPtr
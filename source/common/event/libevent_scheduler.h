@@ -7,6 +7,7 @@
 #include "envoy/event/timer.h"
 
 #include "common/event/libevent.h"
+#include "common/event/slow_callback_tracer.h"
 
 #include "event2/event.h"
 #include "event2/watch.h"
@@ -103,6 +104,11 @@ public:
    */
   void initializeStats(DispatcherStats* stats);
 
+  /**
+   * Sets the tracer of the timers created from now on. |tracer| must outlive the timers.
+   */
+  void setSlowCallbackTracer(SlowCallbackTracer* tracer) { slow_callback_tracer_ = tracer; }
+
 private:
   static void onPrepareForCallback(evwatch*, const evwatch_prepare_cb_info* info, void* arg);
   static void onPrepareForStats(evwatch*, const evwatch_prepare_cb_info* info, void* arg);
@@ -126,6 +132,7 @@ private:
   timeval prepare_time_{};   // timestamp immediately before polling
   timeval check_time_{};     // timestamp immediately after polling
   OnPrepareCallback callback_; // callback to be called from onPrepareForCallback()
+  SlowCallbackTracer* slow_callback_tracer_{}; // tracer owned by the containing DispatcherImpl
 };
 
 } // namespace Event
@@ -0,0 +1,128 @@
+#include "common/event/slow_callback_tracer.h"
+
+#include <list>
+#include <sstream>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+
+#include "absl/debugging/stacktrace.h"
+
+namespace Envoy {
+namespace Event {
+
+namespace {
+
+ABSL_CONST_INIT absl::Mutex registry_mutex(absl::kConstInit);
+
+using TracerList = std::list<SlowCallbackTracer*>;
+TracerList& tracers() { MUTABLE_CONSTRUCT_ON_FIRST_USE(TracerList); }
+
+} // namespace
+
+std::atomic<bool> SlowCallbackTracer::enabled_{false};
+std::atomic<uint64_t> SlowCallbackTracer::threshold_us_{0};
+
+SlowCallbackTracer::SlowCallbackTracer(const std::string& name, TimeSource& time_source)
+    : name_(name), time_source_(time_source) {
+  absl::MutexLock lock(&registry_mutex);
+  tracers().push_back(this);
+}
+
+SlowCallbackTracer::~SlowCallbackTracer() {
+  absl::MutexLock lock(&registry_mutex);
+  tracers().remove(this);
+}
+
+void SlowCallbackTracer::enable(std::chrono::microseconds threshold) {
+  absl::MutexLock lock(&registry_mutex);
+  for (SlowCallbackTracer* tracer : tracers()) {
+    tracer->clear();
+  }
+  threshold_us_.store(threshold.count(), std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void SlowCallbackTracer::disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+void SlowCallbackTracer::forEachTracer(
+    const std::function<void(const SlowCallbackTracer&)>& cb) {
+  absl::MutexLock lock(&registry_mutex);
+  for (const SlowCallbackTracer* tracer : tracers()) {
+    cb(*tracer);
+  }
+}
+
+absl::string_view SlowCallbackTracer::callbackTypeName(CallbackType type) {
+  switch (type) {
+  case CallbackType::FileEvent:
+    return "file_event";
+  case CallbackType::Timer:
+    return "timer";
+  case CallbackType::DeferredDelete:
+    return "deferred_delete";
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+void SlowCallbackTracer::onTrackedObjectChange(const ScopeTrackedObject* object) {
+  if (captured_ || object == nullptr || !exceededThreshold()) {
+    return;
+  }
+  captured_ = true;
+  std::ostringstream os;
+  object->dumpState(os);
+  scope_ = os.str();
+  stack_depth_ = absl::GetStackTrace(stack_, MaxStackDepth, /* skip_count = */ 1);
+}
+
+std::vector<SlowCallbackTracer::SlowCallback> SlowCallbackTracer::slowCallbacks() const {
+  absl::MutexLock lock(&mutex_);
+  return {slow_callbacks_.begin(), slow_callbacks_.end()};
+}
+
+void SlowCallbackTracer::onCallbackStart(CallbackType type) {
+  active_ = true;
+  type_ = type;
+  captured_ = false;
+  start_ = time_source_.monotonicTime();
+}
+
+void SlowCallbackTracer::onCallbackEnd() {
+  active_ = false;
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+      time_source_.monotonicTime() - start_);
+  if (static_cast<uint64_t>(duration.count()) < threshold_us_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  SlowCallback slow_callback{type_,
+                             time_source_.systemTime() - duration,
+                             duration,
+                             captured_ ? std::move(scope_) : std::string(),
+                             {}};
+  if (captured_) {
+    slow_callback.stack_.assign(stack_, stack_ + stack_depth_);
+  }
+  scope_.clear();
+
+  absl::MutexLock lock(&mutex_);
+  if (slow_callbacks_.size() == MaxSlowCallbacks) {
+    slow_callbacks_.pop_front();
+  }
+  slow_callbacks_.push_back(std::move(slow_callback));
+}
+
+bool SlowCallbackTracer::exceededThreshold() const {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   time_source_.monotonicTime() - start_)
+                                   .count()) >= threshold_us_.load(std::memory_order_relaxed);
+}
+
+void SlowCallbackTracer::clear() {
+  absl::MutexLock lock(&mutex_);
+  slow_callbacks_.clear();
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "envoy/common/scope_tracker.h"
+#include "envoy/common/time.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * Records the dispatcher callbacks that block an event loop for longer than a threshold. Each
+ * dispatcher owns one tracer, which keeps the most recent slow callbacks of its thread in a ring.
+ * Tracing is enabled and disabled for all dispatchers at once, and costs one relaxed atomic load
+ * per callback while disabled.
+ *
+ * The callback duration is only known once the callback returns, when the objects it worked on may
+ * be gone. So while a callback runs, the tracer is told about every change of the dispatcher's
+ * tracked object; the first change after the threshold has been exceeded captures the state of the
+ * tracked object being replaced and a stack sample of the callback.
+ */
+class SlowCallbackTracer {
+public:
+  enum class CallbackType { FileEvent, Timer, DeferredDelete };
+
+  struct SlowCallback {
+    CallbackType type_;
+    SystemTime start_time_;
+    std::chrono::microseconds duration_;
+    // The dumped state of the tracked object, empty if no object was tracked past the threshold.
+    std::string scope_;
+    // Raw return addresses, symbolized when the ring is dumped.
+    std::vector<void*> stack_;
+  };
+
+  /**
+   * Times one dispatcher callback for the lifetime of the object. Nested callbacks are attributed
+   * to the outermost one.
+   */
+  class CallbackScope {
+  public:
+    CallbackScope(SlowCallbackTracer* tracer, CallbackType type)
+        : tracer_(tracer != nullptr && enabled() && !tracer->active() ? tracer : nullptr) {
+      if (tracer_ != nullptr) {
+        tracer_->onCallbackStart(type);
+      }
+    }
+    ~CallbackScope() {
+      if (tracer_ != nullptr) {
+        tracer_->onCallbackEnd();
+      }
+    }
+
+  private:
+    SlowCallbackTracer* const tracer_;
+  };
+
+  SlowCallbackTracer(const std::string& name, TimeSource& time_source);
+  ~SlowCallbackTracer();
+
+  /**
+   * Enables tracing on all dispatchers and clears the slow callbacks recorded so far.
+   * @param threshold supplies the duration above which a callback is recorded.
+   */
+  static void enable(std::chrono::microseconds threshold);
+
+  /**
+   * Disables tracing on all dispatchers. The recorded slow callbacks are kept.
+   */
+  static void disable();
+
+  /**
+   * @return bool whether tracing is enabled.
+   */
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * Calls the supplied callback with every live tracer. Tracers are not destroyed while it runs.
+   */
+  static void forEachTracer(const std::function<void(const SlowCallbackTracer&)>& cb);
+
+  /**
+   * @return the name of a callback type, as shown by the admin endpoint.
+   */
+  static absl::string_view callbackTypeName(CallbackType type);
+
+  /**
+   * @return bool whether a callback is being timed. Must be called on the dispatcher thread.
+   */
+  bool active() const { return active_; }
+
+  /**
+   * Must be called on the dispatcher thread, while active(), before the tracked object of the
+   * dispatcher is replaced.
+   * @param object supplies the tracked object that is being replaced.
+   */
+  void onTrackedObjectChange(const ScopeTrackedObject* object);
+
+  /**
+   * @return the recorded slow callbacks, oldest first. May be called from any thread.
+   */
+  std::vector<SlowCallback> slowCallbacks() const;
+
+  const std::string& name() const { return name_; }
+
+  // The maximum number of slow callbacks kept per dispatcher.
+  static constexpr size_t MaxSlowCallbacks = 64;
+  static constexpr int MaxStackDepth = 32;
+
+private:
+  void onCallbackStart(CallbackType type);
+  void onCallbackEnd();
+  bool exceededThreshold() const;
+  void clear();
+
+  static std::atomic<bool> enabled_;
+  static std::atomic<uint64_t> threshold_us_;
+
+  const std::string name_;
+  TimeSource& time_source_;
+
+  // State of the callback being timed, only accessed on the dispatcher thread.
+  bool active_{};
+  CallbackType type_{};
+  MonotonicTime start_;
+  bool captured_{};
+  std::string scope_;
+  void* stack_[MaxStackDepth];
+  int stack_depth_{};
+
+  mutable absl::Mutex mutex_;
+  std::deque<SlowCallback> slow_callbacks_ ABSL_GUARDED_BY(mutex_);
+};
+
+} // namespace Event
+} // namespace Envoy
@@ -10,8 +10,9 @@
 namespace Envoy {
 namespace Event {
 
-TimerImpl::TimerImpl(Libevent::BasePtr& libevent, TimerCb cb, Dispatcher& dispatcher)
-    : cb_(cb), dispatcher_(dispatcher),
+TimerImpl::TimerImpl(Libevent::BasePtr& libevent, TimerCb cb, Dispatcher& dispatcher,
+                     SlowCallbackTracer* slow_callback_tracer)
+    : cb_(cb), dispatcher_(dispatcher), slow_callback_tracer_(slow_callback_tracer),
       activate_timers_next_event_loop_(
           // Only read the runtime feature if the runtime loader singleton has already been created.
           // Accessing runtime features too early in the initialization sequence triggers logging
@@ -26,6 +27,8 @@ TimerImpl::TimerImpl(Libevent::BasePtr& libevent, TimerCb cb, Dispatcher& dispat
       &raw_event_, libevent.get(),
       [](evutil_socket_t, short, void* arg) -> void {
         TimerImpl* timer = static_cast<TimerImpl*>(arg);
+        SlowCallbackTracer::CallbackScope slow_callback_scope(
+            timer->slow_callback_tracer_, SlowCallbackTracer::CallbackType::Timer);
         if (timer->object_ == nullptr) {
           timer->cb_();
           return;
@@ -8,6 +8,7 @@
 #include "common/common/utility.h"
 #include "common/event/event_impl_base.h"
 #include "common/event/libevent.h"
+#include "common/event/slow_callback_tracer.h"
 
 namespace Envoy {
 namespace Event {
@@ -52,7 +53,8 @@ public:
  */
 class TimerImpl : public Timer, ImplBase {
 public:
-  TimerImpl(Libevent::BasePtr& libevent, TimerCb cb, Event::Dispatcher& dispatcher);
+  TimerImpl(Libevent::BasePtr& libevent, TimerCb cb, Event::Dispatcher& dispatcher,
+            SlowCallbackTracer* slow_callback_tracer = nullptr);
 
   // Timer
   void disableTimer() override;
@@ -67,6 +69,7 @@ private:
   void internalEnableTimer(const timeval& tv, const ScopeTrackedObject* scope);
   TimerCb cb_;
   Dispatcher& dispatcher_;
+  SlowCallbackTracer* const slow_callback_tracer_;
   // This has to be atomic for alarms which are handled out of thread, for
   // example if the DispatcherImpl::post is called by two threads, they race to
   // both set this to null.
@@ -0,0 +1,488 @@
+#include "common/formatter/compiled_formatter.h"
+
+#include <map>
+#include <regex>
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/formatter/substitution_formatter.h"
+#include "common/protobuf/utility.h"
+#include "common/stream_info/utility.h"
+
+#include "absl/strings/match.h"
+
+namespace Envoy {
+namespace Formatter {
+
+namespace {
+
+constexpr absl::string_view UnspecifiedValueString{"-"};
+
+// Output adapters so that the same plan can be written to a Buffer::Instance or a std::string.
+class BufferOutput {
+public:
+  explicit BufferOutput(Buffer::Instance& buffer) : buffer_(buffer) {}
+  void add(absl::string_view data) { buffer_.add(data); }
+
+private:
+  Buffer::Instance& buffer_;
+};
+
+class StringOutput {
+public:
+  explicit StringOutput(std::string& str) : str_(str) {}
+  void add(absl::string_view data) { str_.append(data.data(), data.size()); }
+
+private:
+  std::string& str_;
+};
+
+// Writes the value as the body of a JSON string, without the surrounding quotes. Runs of
+// characters that need no escaping are written in one piece. As with the protobuf JSON printer,
+// '<', '>' and DEL are escaped as well, so that a document served as a local reply body can't be
+// mistaken for markup.
+template <class Output> void appendJsonEscaped(absl::string_view value, Output& output) {
+  static constexpr char Hex[] = "0123456789abcdef";
+  size_t start = 0;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const unsigned char c = value[i];
+    absl::string_view escaped;
+    char unicode_escape[6];
+    switch (c) {
+    case '"':
+      escaped = "\\\"";
+      break;
+    case '\\':
+      escaped = "\\\\";
+      break;
+    case '\b':
+      escaped = "\\b";
+      break;
+    case '\f':
+      escaped = "\\f";
+      break;
+    case '\n':
+      escaped = "\\n";
+      break;
+    case '\r':
+      escaped = "\\r";
+      break;
+    case '\t':
+      escaped = "\\t";
+      break;
+    default:
+      if (c >= 0x20 && c != '<' && c != '>' && c != 0x7f) {
+        continue;
+      }
+      unicode_escape[0] = '\\';
+      unicode_escape[1] = 'u';
+      unicode_escape[2] = '0';
+      unicode_escape[3] = '0';
+      unicode_escape[4] = Hex[c >> 4];
+      unicode_escape[5] = Hex[c & 0xf];
+      escaped = absl::string_view(unicode_escape, sizeof(unicode_escape));
+      break;
+    }
+    output.add(value.substr(start, i - start));
+    output.add(escaped);
+    start = i + 1;
+  }
+  output.add(value.substr(start));
+}
+
+enum class ValueMode {
+  // Values are written as is.
+  Text,
+  // Values are written escaped, as part of a JSON string opened and closed by the caller.
+  JsonString,
+  // Values are written as complete JSON values, preserving numbers and null.
+  TypedJson,
+};
+
+// Receives the values produced by the steps of a plan and writes them according to the mode.
+template <class Output> class ValueWriter {
+public:
+  ValueWriter(Output& output, ValueMode mode) : output_(output), mode_(mode) {}
+
+  bool typed() const { return mode_ == ValueMode::TypedJson; }
+
+  void string(absl::string_view value) {
+    switch (mode_) {
+    case ValueMode::Text:
+      output_.add(value);
+      break;
+    case ValueMode::JsonString:
+      appendJsonEscaped(value, output_);
+      break;
+    case ValueMode::TypedJson:
+      output_.add("\"");
+      appendJsonEscaped(value, output_);
+      output_.add("\"");
+      break;
+    }
+  }
+
+  template <class T> void number(T value) {
+    const fmt::format_int formatted(value);
+    output_.add(absl::string_view(formatted.data(), formatted.size()));
+  }
+
+  void unspecified() {
+    if (typed()) {
+      output_.add("null");
+    } else {
+      string(UnspecifiedValueString);
+    }
+  }
+
+  void value(const ProtobufWkt::Value& proto_value) {
+    ASSERT(typed());
+    switch (proto_value.kind_case()) {
+    case ProtobufWkt::Value::kStringValue:
+      string(proto_value.string_value());
+      break;
+    case ProtobufWkt::Value::kNullValue:
+      output_.add("null");
+      break;
+    default:
+      output_.add(MessageUtil::getJsonStringFromMessage(proto_value, false, true));
+      break;
+    }
+  }
+
+private:
+  Output& output_;
+  const ValueMode mode_;
+};
+
+// Matches a command at the start of the search space. Kept in sync with
+// SubstitutionFormatParser::parse().
+const std::regex& getCommandPattern() {
+  CONSTRUCT_ON_FIRST_USE(std::regex, R"EOF(^%([A-Z]|_)+(\([^\)]*\))?(:[0-9]+)?(%))EOF");
+}
+
+} // namespace
+
+CompiledFormat::CompiledFormat(const std::string& format) {
+  std::string current_literal;
+  for (size_t pos = 0; pos < format.length(); ++pos) {
+    if (format[pos] != '%') {
+      current_literal += format[pos];
+      continue;
+    }
+
+    addLiteral(current_literal);
+    current_literal.clear();
+
+    std::smatch m;
+    const std::string search_space = format.substr(pos);
+    if (!std::regex_search(search_space, m, getCommandPattern())) {
+      throw EnvoyException(
+          fmt::format("Incorrect configuration: {}. Couldn't find valid command at position {}",
+                      format, pos));
+    }
+    const std::string command = m.str(0);
+    addCommand(command);
+    pos += command.length() - 1;
+  }
+  addLiteral(current_literal);
+}
+
+size_t CompiledFormat::providerSteps() const {
+  size_t count = 0;
+  for (const Step& step : steps_) {
+    if (step.type_ == StepType::Provider) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+const CompiledFormat::StepTypeMap& CompiledFormat::streamInfoSteps() {
+  CONSTRUCT_ON_FIRST_USE(
+      StepTypeMap, {"BYTES_RECEIVED", StepType::BytesReceived},
+      {"BYTES_SENT", StepType::BytesSent}, {"RESPONSE_CODE", StepType::ResponseCode},
+      {"DURATION", StepType::Duration}, {"REQUEST_DURATION", StepType::RequestDuration},
+      {"RESPONSE_DURATION", StepType::ResponseDuration}, {"PROTOCOL", StepType::Protocol},
+      {"RESPONSE_FLAGS", StepType::ResponseFlags}, {"UPSTREAM_HOST", StepType::UpstreamHost},
+      {"DOWNSTREAM_LOCAL_ADDRESS", StepType::DownstreamLocalAddress},
+      {"DOWNSTREAM_LOCAL_ADDRESS_WITHOUT_PORT", StepType::DownstreamLocalAddressWithoutPort},
+      {"DOWNSTREAM_REMOTE_ADDRESS", StepType::DownstreamRemoteAddress},
+      {"DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT", StepType::DownstreamRemoteAddressWithoutPort},
+      {"LOCAL_REPLY_BODY", StepType::LocalReplyBody});
+}
+
+void CompiledFormat::addLiteral(absl::string_view literal) {
+  if (literal.empty()) {
+    return;
+  }
+  if (!steps_.empty() && steps_.back().type_ == StepType::Literal) {
+    steps_.back().literal_.append(literal.data(), literal.size());
+    return;
+  }
+  steps_.emplace_back(StepType::Literal);
+  steps_.back().literal_ = std::string(literal);
+}
+
+void CompiledFormat::addCommand(const std::string& command) {
+  // The command includes the surrounding '%' characters.
+  const std::string token = command.substr(1, command.length() - 2);
+
+  struct HeaderCommand {
+    absl::string_view prefix_;
+    StepType type_;
+  };
+  static constexpr HeaderCommand HeaderCommands[] = {
+      {"REQ(", StepType::RequestHeader},
+      {"RESP(", StepType::ResponseHeader},
+      {"TRAILER(", StepType::ResponseTrailer},
+  };
+
+  const auto stream_info_step = streamInfoSteps().find(token);
+  if (stream_info_step != streamInfoSteps().end()) {
+    steps_.emplace_back(stream_info_step->second);
+    return;
+  }
+
+  for (const HeaderCommand& header_command : HeaderCommands) {
+    if (absl::StartsWith(token, header_command.prefix_)) {
+      std::string main_header, alternative_header;
+      absl::optional<size_t> max_length;
+      SubstitutionFormatParser::parseCommandHeader(token, header_command.prefix_.size(),
+                                                   main_header, alternative_header, max_length);
+      steps_.emplace_back(header_command.type_, main_header, alternative_header);
+      steps_.back().max_length_ = max_length;
+      return;
+    }
+  }
+
+  // Everything else is evaluated by the provider the parser creates for the command. Parsing the
+  // command on its own also reports configuration errors exactly as parse() would.
+  std::vector<FormatterProviderPtr> providers = SubstitutionFormatParser::parse(command);
+  ASSERT(providers.size() == 1);
+  steps_.emplace_back(StepType::Provider);
+  steps_.back().provider_ = std::move(providers.front());
+}
+
+template <class Writer>
+void CompiledFormat::appendStep(const Step& step, const Context& context, Writer& writer) const {
+  const StreamInfo::StreamInfo& stream_info = context.stream_info_;
+
+  const auto append_header = [&step, &writer](const Http::HeaderMap& headers) {
+    const Http::HeaderEntry* header = headers.get(step.main_header_);
+    if (!header && !step.alternative_header_.get().empty()) {
+      header = headers.get(step.alternative_header_);
+    }
+    if (!header) {
+      writer.unspecified();
+      return;
+    }
+    absl::string_view value = header->value().getStringView();
+    if (step.max_length_) {
+      value = value.substr(0, step.max_length_.value());
+    }
+    writer.string(value);
+  };
+  const auto append_duration = [&writer](absl::optional<std::chrono::nanoseconds> duration) {
+    if (!duration) {
+      writer.unspecified();
+      return;
+    }
+    writer.number(std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count());
+  };
+  const auto append_address = [&writer](const Network::Address::Instance* address,
+                                        bool with_port) {
+    if (address == nullptr) {
+      writer.unspecified();
+    } else if (with_port) {
+      writer.string(address->asStringView());
+    } else {
+      writer.string(StreamInfo::Utility::formatDownstreamAddressNoPort(*address));
+    }
+  };
+
+  switch (step.type_) {
+  case StepType::Literal:
+    writer.string(step.literal_);
+    break;
+  case StepType::RequestHeader:
+    append_header(context.request_headers_);
+    break;
+  case StepType::ResponseHeader:
+    append_header(context.response_headers_);
+    break;
+  case StepType::ResponseTrailer:
+    append_header(context.response_trailers_);
+    break;
+  case StepType::LocalReplyBody:
+    writer.string(context.local_reply_body_);
+    break;
+  case StepType::BytesReceived:
+    writer.number(stream_info.bytesReceived());
+    break;
+  case StepType::BytesSent:
+    writer.number(stream_info.bytesSent());
+    break;
+  case StepType::ResponseCode: {
+    const absl::optional<uint32_t> response_code = stream_info.responseCode();
+    writer.number(response_code ? response_code.value() : 0);
+    break;
+  }
+  case StepType::Duration:
+    append_duration(stream_info.requestComplete());
+    break;
+  case StepType::RequestDuration:
+    append_duration(stream_info.lastDownstreamRxByteReceived());
+    break;
+  case StepType::ResponseDuration:
+    append_duration(stream_info.firstUpstreamRxByteReceived());
+    break;
+  case StepType::Protocol:
+    writer.string(SubstitutionFormatUtils::protocolToString(stream_info.protocol()));
+    break;
+  case StepType::ResponseFlags:
+    writer.string(StreamInfo::ResponseFlagUtils::toShortString(stream_info));
+    break;
+  case StepType::UpstreamHost: {
+    const Upstream::HostDescriptionConstSharedPtr host = stream_info.upstreamHost();
+    append_address(host ? host->address().get() : nullptr, true);
+    break;
+  }
+  case StepType::DownstreamLocalAddress:
+    append_address(stream_info.downstreamLocalAddress().get(), true);
+    break;
+  case StepType::DownstreamLocalAddressWithoutPort:
+    append_address(stream_info.downstreamLocalAddress().get(), false);
+    break;
+  case StepType::DownstreamRemoteAddress:
+    append_address(stream_info.downstreamRemoteAddress().get(), true);
+    break;
+  case StepType::DownstreamRemoteAddressWithoutPort:
+    append_address(stream_info.downstreamRemoteAddress().get(), false);
+    break;
+  case StepType::Provider:
+    if (writer.typed()) {
+      writer.value(step.provider_->formatValue(context.request_headers_, context.response_headers_,
+                                               context.response_trailers_, stream_info,
+                                               context.local_reply_body_));
+    } else {
+      writer.string(step.provider_->format(context.request_headers_, context.response_headers_,
+                                           context.response_trailers_, stream_info,
+                                           context.local_reply_body_));
+    }
+    break;
+  }
+}
+
+template <class Output>
+void CompiledFormat::appendText(const Context& context, Output& output) const {
+  ValueWriter<Output> writer(output, ValueMode::Text);
+  for (const Step& step : steps_) {
+    appendStep(step, context, writer);
+  }
+}
+
+template <class Output>
+void CompiledFormat::appendJsonValue(const Context& context, Output& output,
+                                     bool preserve_types) const {
+  if (preserve_types && steps_.size() == 1) {
+    ValueWriter<Output> writer(output, ValueMode::TypedJson);
+    appendStep(steps_.front(), context, writer);
+    return;
+  }
+
+  // Multiple steps force string output.
+  ValueWriter<Output> writer(output, ValueMode::JsonString);
+  output.add("\"");
+  for (const Step& step : steps_) {
+    appendStep(step, context, writer);
+  }
+  output.add("\"");
+}
+
+CompiledFormatter::CompiledFormatter(const std::string& format) : format_(format) {}
+
+void CompiledFormatter::formatToBuffer(const Http::RequestHeaderMap& request_headers,
+                                       const Http::ResponseHeaderMap& response_headers,
+                                       const Http::ResponseTrailerMap& response_trailers,
+                                       const StreamInfo::StreamInfo& stream_info,
+                                       absl::string_view local_reply_body,
+                                       Buffer::Instance& output) const {
+  BufferOutput buffer_output(output);
+  format_.appendText({request_headers, response_headers, response_trailers, stream_info,
+                      local_reply_body},
+                     buffer_output);
+}
+
+std::string CompiledFormatter::format(const Http::RequestHeaderMap& request_headers,
+                                      const Http::ResponseHeaderMap& response_headers,
+                                      const Http::ResponseTrailerMap& response_trailers,
+                                      const StreamInfo::StreamInfo& stream_info,
+                                      absl::string_view local_reply_body) const {
+  std::string log_line;
+  log_line.reserve(256);
+  StringOutput string_output(log_line);
+  format_.appendText({request_headers, response_headers, response_trailers, stream_info,
+                      local_reply_body},
+                     string_output);
+  return log_line;
+}
+
+CompiledJsonFormatter::CompiledJsonFormatter(
+    const absl::flat_hash_map<std::string, std::string>& format_mapping, bool preserve_types)
+    : preserve_types_(preserve_types) {
+  // Sort the keys so that the output is stable regardless of the hash map's iteration order.
+  const std::map<absl::string_view, absl::string_view> sorted_mapping(format_mapping.begin(),
+                                                                       format_mapping.end());
+  fields_.reserve(sorted_mapping.size());
+  for (const auto& pair : sorted_mapping) {
+    std::string prefix = fields_.empty() ? "{\"" : ",\"";
+    StringOutput prefix_output(prefix);
+    appendJsonEscaped(pair.first, prefix_output);
+    prefix.append("\":");
+    fields_.push_back({std::move(prefix), CompiledFormat(std::string(pair.second))});
+  }
+}
+
+template <class Output>
+void CompiledJsonFormatter::appendDocument(const CompiledFormat::Context& context,
+                                           Output& output) const {
+  if (fields_.empty()) {
+    output.add("{}\n");
+    return;
+  }
+  for (const Field& field : fields_) {
+    output.add(field.prefix_);
+    field.format_.appendJsonValue(context, output, preserve_types_);
+  }
+  output.add("}\n");
+}
+
+void CompiledJsonFormatter::formatToBuffer(const Http::RequestHeaderMap& request_headers,
+                                           const Http::ResponseHeaderMap& response_headers,
+                                           const Http::ResponseTrailerMap& response_trailers,
+                                           const StreamInfo::StreamInfo& stream_info,
+                                           absl::string_view local_reply_body,
+                                           Buffer::Instance& output) const {
+  BufferOutput buffer_output(output);
+  appendDocument({request_headers, response_headers, response_trailers, stream_info,
+                  local_reply_body},
+                 buffer_output);
+}
+
+std::string CompiledJsonFormatter::format(const Http::RequestHeaderMap& request_headers,
+                                          const Http::ResponseHeaderMap& response_headers,
+                                          const Http::ResponseTrailerMap& response_trailers,
+                                          const StreamInfo::StreamInfo& stream_info,
+                                          absl::string_view local_reply_body) const {
+  std::string log_line;
+  log_line.reserve(256);
+  StringOutput string_output(log_line);
+  appendDocument({request_headers, response_headers, response_trailers, stream_info,
+                  local_reply_body},
+                 string_output);
+  return log_line;
+}
+
+} // namespace Formatter
+} // namespace Envoy
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/formatter/substitution_formatter.h"
+#include "envoy/http/header_map.h"
+#include "envoy/stream_info/stream_info.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Formatter {
+
+/**
+ * A substitution format string compiled into a flat plan of steps. Literals and the most commonly
+ * logged commands (headers, trailers, byte counts, durations, response code, protocol, response
+ * flags and addresses) are evaluated inline and written straight to the output without building
+ * intermediate strings. Every other command falls back to the FormatterProvider created by
+ * SubstitutionFormatParser, so the supported grammar and the produced values are identical to
+ * those of FormatterImpl.
+ */
+class CompiledFormat {
+public:
+  /**
+   * @param format supplies the format string.
+   * @throw EnvoyException if the format string is invalid.
+   */
+  explicit CompiledFormat(const std::string& format);
+
+  /**
+   * @return size_t the number of steps in the plan. Adjacent literals are merged into one step.
+   */
+  size_t size() const { return steps_.size(); }
+
+  /**
+   * @return size_t the number of steps that fall back to a FormatterProvider.
+   */
+  size_t providerSteps() const;
+
+private:
+  friend class CompiledFormatter;
+  friend class CompiledJsonFormatter;
+
+  enum class StepType : uint8_t {
+    Literal,
+    RequestHeader,
+    ResponseHeader,
+    ResponseTrailer,
+    LocalReplyBody,
+    BytesReceived,
+    BytesSent,
+    ResponseCode,
+    Duration,
+    RequestDuration,
+    ResponseDuration,
+    Protocol,
+    ResponseFlags,
+    UpstreamHost,
+    DownstreamLocalAddress,
+    DownstreamLocalAddressWithoutPort,
+    DownstreamRemoteAddress,
+    DownstreamRemoteAddressWithoutPort,
+    Provider,
+  };
+
+  struct Step {
+    explicit Step(StepType type, const std::string& main_header = "",
+                  const std::string& alternative_header = "")
+        : type_(type), main_header_(main_header), alternative_header_(alternative_header) {}
+
+    StepType type_;
+    std::string literal_;
+    Http::LowerCaseString main_header_;
+    Http::LowerCaseString alternative_header_;
+    absl::optional<size_t> max_length_;
+    FormatterProviderPtr provider_;
+  };
+
+  struct Context {
+    const Http::RequestHeaderMap& request_headers_;
+    const Http::ResponseHeaderMap& response_headers_;
+    const Http::ResponseTrailerMap& response_trailers_;
+    const StreamInfo::StreamInfo& stream_info_;
+    absl::string_view local_reply_body_;
+  };
+
+  // Commands without arguments that are evaluated inline, keyed by command name.
+  using StepTypeMap = absl::flat_hash_map<absl::string_view, StepType>;
+  static const StepTypeMap& streamInfoSteps();
+
+  void addLiteral(absl::string_view literal);
+  void addCommand(const std::string& command);
+
+  // Writes the value of every step. Instantiated in the .cc file for Buffer::Instance and
+  // std::string outputs only.
+  template <class Output> void appendText(const Context& context, Output& output) const;
+  // Writes the steps as one JSON value: a typed value when the plan has exactly one step and types
+  // are preserved, otherwise a JSON string of the concatenated step values.
+  template <class Output>
+  void appendJsonValue(const Context& context, Output& output, bool preserve_types) const;
+  template <class Writer>
+  void appendStep(const Step& step, const Context& context, Writer& writer) const;
+
+  std::vector<Step> steps_;
+};
+
+/**
+ * Text formatter backed by a CompiledFormat. Produces exactly the same output as FormatterImpl.
+ */
+class CompiledFormatter : public Formatter {
+public:
+  explicit CompiledFormatter(const std::string& format);
+
+  /**
+   * Append a formatted line to the supplied buffer. The buffer may be reused across calls so that
+   * formatting does not allocate per line.
+   */
+  void formatToBuffer(const Http::RequestHeaderMap& request_headers,
+                      const Http::ResponseHeaderMap& response_headers,
+                      const Http::ResponseTrailerMap& response_trailers,
+                      const StreamInfo::StreamInfo& stream_info,
+                      absl::string_view local_reply_body, Buffer::Instance& output) const;
+
+  // Formatter::format
+  std::string format(const Http::RequestHeaderMap& request_headers,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const Http::ResponseTrailerMap& response_trailers,
+                     const StreamInfo::StreamInfo& stream_info,
+                     absl::string_view local_reply_body) const override;
+
+  const CompiledFormat& compiledFormat() const { return format_; }
+
+private:
+  const CompiledFormat format_;
+};
+
+/**
+ * JSON formatter backed by one CompiledFormat per key. The JSON document is written directly
+ * instead of being built as a ProtobufWkt::Struct and serialized. The produced document has the
+ * same keys and values as the one produced by JsonFormatterImpl; keys are emitted in sorted order,
+ * and integers are written exactly rather than as doubles.
+ */
+class CompiledJsonFormatter : public Formatter {
+public:
+  CompiledJsonFormatter(const absl::flat_hash_map<std::string, std::string>& format_mapping,
+                        bool preserve_types);
+
+  /**
+   * Append a formatted JSON line to the supplied buffer.
+   */
+  void formatToBuffer(const Http::RequestHeaderMap& request_headers,
+                      const Http::ResponseHeaderMap& response_headers,
+                      const Http::ResponseTrailerMap& response_trailers,
+                      const StreamInfo::StreamInfo& stream_info,
+                      absl::string_view local_reply_body, Buffer::Instance& output) const;
+
+  // Formatter::format
+  std::string format(const Http::RequestHeaderMap& request_headers,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const Http::ResponseTrailerMap& response_trailers,
+                     const StreamInfo::StreamInfo& stream_info,
+                     absl::string_view local_reply_body) const override;
+
+private:
+  struct Field {
+    // The escaped key with its leading separator and trailing colon, e.g. ',"key":'.
+    std::string prefix_;
+    CompiledFormat format_;
+  };
+
+  template <class Output>
+  void appendDocument(const CompiledFormat::Context& context, Output& output) const;
+
+  const bool preserve_types_;
+  std::vector<Field> fields_;
+};
+
+} // namespace Formatter
+} // namespace Envoy
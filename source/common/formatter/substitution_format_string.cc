@@ -1,5 +1,6 @@
 #include "common/formatter/substitution_format_string.h"
 
+#include "common/formatter/compiled_formatter.h"
 #include "common/formatter/substitution_formatter.h"
 
 namespace Envoy {
@@ -24,14 +25,14 @@ FormatterPtr
 SubstitutionFormatStringUtils::createJsonFormatter(const ProtobufWkt::Struct& struct_format,
                                                    bool preserve_types) {
   auto json_format_map = convertJsonFormatToMap(struct_format);
-  return std::make_unique<JsonFormatterImpl>(json_format_map, preserve_types);
+  return std::make_unique<CompiledJsonFormatter>(json_format_map, preserve_types);
 }
 
 FormatterPtr SubstitutionFormatStringUtils::fromProtoConfig(
     const envoy::config::core::v3::SubstitutionFormatString& config) {
   switch (config.format_case()) {
   case envoy::config::core::v3::SubstitutionFormatString::FormatCase::kTextFormat:
-    return std::make_unique<FormatterImpl>(config.text_format());
+    return std::make_unique<CompiledFormatter>(config.text_format());
   case envoy::config::core::v3::SubstitutionFormatString::FormatCase::kJsonFormat: {
     return createJsonFormatter(config.json_format(), true);
   }
@@ -24,7 +24,6 @@ class SubstitutionFormatParser {
 public:
   static std::vector<FormatterProviderPtr> parse(const std::string& format);
 
-private:
   /**
    * Parse a header format rule of the form: %REQ(X?Y):Z% .
    * Will populate a main_header and an optional alternative header if specified.
@@ -35,6 +34,7 @@ private:
                                  std::string& main_header, std::string& alternative_header,
                                  absl::optional<size_t>& max_length);
 
+private:
   /**
    * General parse command utility. Will parse token from start position. Token is expected to end
    * with ')'. An optional ":max_length" may be specified after the closing ')' char. Token may
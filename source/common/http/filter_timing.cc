@@ -0,0 +1,160 @@
+#include "common/http/filter_timing.h"
+
+#include <time.h>
+
+#include "common/common/assert.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Http {
+
+FilterTimingConfig::FilterTimingConfig(
+    const envoy::config::core::v3::RuntimeFractionalPercent& sampling,
+    const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+    TimeSource& time_source)
+    : sampling_(sampling), stat_prefix_(stat_prefix + "filter_timing."), scope_(scope),
+      runtime_(runtime), time_source_(time_source) {}
+
+bool FilterTimingConfig::sampleStream() const {
+  return runtime_.snapshot().featureEnabled(sampling_.runtime_key(), sampling_.default_value());
+}
+
+void FilterTimingConfig::registerFilter(absl::string_view filter_name) {
+  if (filter_stats_.contains(filter_name)) {
+    return;
+  }
+  const std::string prefix = absl::StrCat(stat_prefix_, filter_name, ".");
+  filter_stats_.emplace(std::string(filter_name),
+                        std::make_unique<FilterTimingStats>(FilterTimingStats{
+                            ALL_FILTER_TIMING_STATS(POOL_HISTOGRAM_PREFIX(scope_, prefix))}));
+}
+
+const FilterTimingStats& FilterTimingConfig::statsForFilter(absl::string_view filter_name) const {
+  const auto it = filter_stats_.find(filter_name);
+  ASSERT(it != filter_stats_.end());
+  return *it->second;
+}
+
+std::chrono::nanoseconds threadCpuTime() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+  }
+#endif
+  return std::chrono::nanoseconds(0);
+}
+
+TimedStreamFilter::CallbackTimer::CallbackTimer(TimeSource& time_source,
+                                                Stats::Histogram& wall_us,
+                                                Stats::Histogram& cpu_us)
+    : time_source_(time_source), wall_us_(wall_us), cpu_us_(cpu_us),
+      wall_start_(time_source.monotonicTime()), cpu_start_(threadCpuTime()) {}
+
+TimedStreamFilter::CallbackTimer::~CallbackTimer() {
+  cpu_us_.recordValue(
+      std::chrono::duration_cast<std::chrono::microseconds>(threadCpuTime() - cpu_start_).count());
+  wall_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                           time_source_.monotonicTime() - wall_start_)
+                           .count());
+}
+
+TimedStreamFilter::TimedStreamFilter(StreamDecoderFilterSharedPtr decoder_filter,
+                                     StreamEncoderFilterSharedPtr encoder_filter,
+                                     const FilterTimingStats& stats, TimeSource& time_source)
+    : decoder_filter_(std::move(decoder_filter)), encoder_filter_(std::move(encoder_filter)),
+      stats_(stats), time_source_(time_source) {
+  ASSERT(decoder_filter_ != nullptr || encoder_filter_ != nullptr);
+}
+
+void TimedStreamFilter::onDestroy() {
+  // A dual filter is shared by both pointers and must only be destroyed once.
+  if (decoder_filter_ != nullptr) {
+    decoder_filter_->onDestroy();
+  } else {
+    encoder_filter_->onDestroy();
+  }
+}
+
+FilterHeadersStatus TimedStreamFilter::decodeHeaders(RequestHeaderMap& headers, bool end_stream) {
+  const CallbackTimer timer = decodeTimer();
+  return decoder_filter_->decodeHeaders(headers, end_stream);
+}
+
+FilterDataStatus TimedStreamFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  const CallbackTimer timer = decodeTimer();
+  return decoder_filter_->decodeData(data, end_stream);
+}
+
+FilterTrailersStatus TimedStreamFilter::decodeTrailers(RequestTrailerMap& trailers) {
+  const CallbackTimer timer = decodeTimer();
+  return decoder_filter_->decodeTrailers(trailers);
+}
+
+FilterMetadataStatus TimedStreamFilter::decodeMetadata(MetadataMap& metadata_map) {
+  const CallbackTimer timer = decodeTimer();
+  return decoder_filter_->decodeMetadata(metadata_map);
+}
+
+void TimedStreamFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) {
+  decoder_filter_->setDecoderFilterCallbacks(callbacks);
+}
+
+void TimedStreamFilter::decodeComplete() { decoder_filter_->decodeComplete(); }
+
+FilterHeadersStatus TimedStreamFilter::encode100ContinueHeaders(ResponseHeaderMap& headers) {
+  const CallbackTimer timer = encodeTimer();
+  return encoder_filter_->encode100ContinueHeaders(headers);
+}
+
+FilterHeadersStatus TimedStreamFilter::encodeHeaders(ResponseHeaderMap& headers, bool end_stream) {
+  const CallbackTimer timer = encodeTimer();
+  return encoder_filter_->encodeHeaders(headers, end_stream);
+}
+
+FilterDataStatus TimedStreamFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  const CallbackTimer timer = encodeTimer();
+  return encoder_filter_->encodeData(data, end_stream);
+}
+
+FilterTrailersStatus TimedStreamFilter::encodeTrailers(ResponseTrailerMap& trailers) {
+  const CallbackTimer timer = encodeTimer();
+  return encoder_filter_->encodeTrailers(trailers);
+}
+
+FilterMetadataStatus TimedStreamFilter::encodeMetadata(MetadataMap& metadata_map) {
+  const CallbackTimer timer = encodeTimer();
+  return encoder_filter_->encodeMetadata(metadata_map);
+}
+
+void TimedStreamFilter::setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) {
+  encoder_filter_->setEncoderFilterCallbacks(callbacks);
+}
+
+void TimedStreamFilter::encodeComplete() { encoder_filter_->encodeComplete(); }
+
+void TimedFilterChainFactoryCallbacks::addStreamDecoderFilter(StreamDecoderFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  parent_.addStreamDecoderFilter(
+      std::make_shared<TimedStreamFilter>(std::move(filter), nullptr, *stats_, time_source_));
+}
+
+void TimedFilterChainFactoryCallbacks::addStreamEncoderFilter(StreamEncoderFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  parent_.addStreamEncoderFilter(
+      std::make_shared<TimedStreamFilter>(nullptr, std::move(filter), *stats_, time_source_));
+}
+
+void TimedFilterChainFactoryCallbacks::addStreamFilter(StreamFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  parent_.addStreamFilter(
+      std::make_shared<TimedStreamFilter>(filter, filter, *stats_, time_source_));
+}
+
+void TimedFilterChainFactoryCallbacks::addAccessLogHandler(AccessLog::InstanceSharedPtr handler) {
+  parent_.addAccessLogHandler(std::move(handler));
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/config/core/v3/base.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All per filter timing stats. @see stats_macros.h
+ */
+#define ALL_FILTER_TIMING_STATS(HISTOGRAM)                                                         \
+  HISTOGRAM(decode_cpu_us, Microseconds)                                                           \
+  HISTOGRAM(decode_wall_us, Microseconds)                                                          \
+  HISTOGRAM(encode_cpu_us, Microseconds)                                                           \
+  HISTOGRAM(encode_wall_us, Microseconds)
+
+/**
+ * Struct definition for the timing stats of one HTTP filter. @see stats_macros.h
+ */
+struct FilterTimingStats {
+  ALL_FILTER_TIMING_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Sampled timing of HTTP filter callbacks. When a stream is sampled, its filters are wrapped by
+ * TimedStreamFilter as the filter chain is created, and the wall clock and thread CPU time of every
+ * decoder and encoder callback are recorded in the histograms of the filter. Streams that are not
+ * sampled get the unwrapped filters, so they run exactly the same code as without timing.
+ *
+ * The recorded time of a callback includes the time spent in any filter callback it triggers
+ * synchronously, e.g. the encoder filters run by a local reply sent from decodeHeaders().
+ */
+class FilterTimingConfig {
+public:
+  FilterTimingConfig(const envoy::config::core::v3::RuntimeFractionalPercent& sampling,
+                     const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+                     TimeSource& time_source);
+
+  /**
+   * @return bool whether the filter callbacks of a new stream should be timed.
+   */
+  bool sampleStream() const;
+
+  /**
+   * Creates the timing stats of a filter unless they already exist. Must be called on the main
+   * thread for every filter of the filter chain when the filter chain is configured.
+   * @param filter_name supplies the configured name of the filter.
+   */
+  void registerFilter(absl::string_view filter_name);
+
+  /**
+   * @param filter_name supplies the configured name of a registered filter.
+   * @return const FilterTimingStats& the timing stats of the filter.
+   */
+  const FilterTimingStats& statsForFilter(absl::string_view filter_name) const;
+
+  TimeSource& timeSource() const { return time_source_; }
+
+private:
+  const envoy::config::core::v3::RuntimeFractionalPercent sampling_;
+  const std::string stat_prefix_;
+  Stats::Scope& scope_;
+  Runtime::Loader& runtime_;
+  TimeSource& time_source_;
+  absl::flat_hash_map<std::string, std::unique_ptr<FilterTimingStats>> filter_stats_;
+};
+
+using FilterTimingConfigPtr = std::unique_ptr<FilterTimingConfig>;
+
+/**
+ * @return std::chrono::nanoseconds the CPU time consumed by the calling thread, or zero if the
+ * platform has no per thread CPU clock.
+ */
+std::chrono::nanoseconds threadCpuTime();
+
+/**
+ * A filter wrapper that records the time taken by each callback of the wrapped decoder and/or
+ * encoder filter. Only the callbacks of the filter types that are set are ever invoked, as the
+ * wrapper is added to the filter chain with the same type as the wrapped filter.
+ */
+class TimedStreamFilter : public StreamFilter {
+public:
+  TimedStreamFilter(StreamDecoderFilterSharedPtr decoder_filter,
+                    StreamEncoderFilterSharedPtr encoder_filter, const FilterTimingStats& stats,
+                    TimeSource& time_source);
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(RequestHeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus decodeTrailers(RequestTrailerMap& trailers) override;
+  FilterMetadataStatus decodeMetadata(MetadataMap& metadata_map) override;
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override;
+  void decodeComplete() override;
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encode100ContinueHeaders(ResponseHeaderMap& headers) override;
+  FilterHeadersStatus encodeHeaders(ResponseHeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(ResponseTrailerMap& trailers) override;
+  FilterMetadataStatus encodeMetadata(MetadataMap& metadata_map) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override;
+  void encodeComplete() override;
+
+private:
+  /**
+   * Measures one filter callback for the lifetime of the object.
+   */
+  class CallbackTimer {
+  public:
+    CallbackTimer(TimeSource& time_source, Stats::Histogram& wall_us, Stats::Histogram& cpu_us);
+    ~CallbackTimer();
+
+  private:
+    TimeSource& time_source_;
+    Stats::Histogram& wall_us_;
+    Stats::Histogram& cpu_us_;
+    const MonotonicTime wall_start_;
+    const std::chrono::nanoseconds cpu_start_;
+  };
+
+  CallbackTimer decodeTimer() {
+    return {time_source_, stats_.decode_wall_us_, stats_.decode_cpu_us_};
+  }
+  CallbackTimer encodeTimer() {
+    return {time_source_, stats_.encode_wall_us_, stats_.encode_cpu_us_};
+  }
+
+  const StreamDecoderFilterSharedPtr decoder_filter_;
+  const StreamEncoderFilterSharedPtr encoder_filter_;
+  const FilterTimingStats& stats_;
+  TimeSource& time_source_;
+};
+
+/**
+ * Filter chain factory callbacks that add the filters of a sampled stream wrapped by
+ * TimedStreamFilter to the filter chain of the stream.
+ */
+class TimedFilterChainFactoryCallbacks : public FilterChainFactoryCallbacks {
+public:
+  TimedFilterChainFactoryCallbacks(FilterChainFactoryCallbacks& parent, TimeSource& time_source)
+      : parent_(parent), time_source_(time_source) {}
+
+  /**
+   * Sets the stats that the filters added from now on are timed into.
+   */
+  void setFilterStats(const FilterTimingStats& stats) { stats_ = &stats; }
+
+  // Http::FilterChainFactoryCallbacks
+  void addStreamDecoderFilter(StreamDecoderFilterSharedPtr filter) override;
+  void addStreamEncoderFilter(StreamEncoderFilterSharedPtr filter) override;
+  void addStreamFilter(StreamFilterSharedPtr filter) override;
+  void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override;
+
+private:
+  FilterChainFactoryCallbacks& parent_;
+  TimeSource& time_source_;
+  const FilterTimingStats* stats_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,293 @@
+#include "common/network/udp_batch_writer.h"
+
+#include <cstring>
+
+#include "envoy/buffer/buffer.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/assert.h"
+#include "common/network/address_impl.h"
+#include "common/network/io_socket_error_impl.h"
+#include "common/network/utility.h"
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+
+// Maximum number of segments the kernel accepts in a single UDP GSO send. See UDP_MAX_SEGMENTS in
+// include/linux/udp.h.
+constexpr uint64_t MaxGsoSegments = 64;
+
+// Largest UDP payload carried by a single IPv4 datagram. A GSO message must not exceed it.
+constexpr uint64_t MaxGsoMessageSize = 65507;
+
+Api::IoCallUint64Result ioErrorResult(int sys_errno) {
+  return Api::IoCallUint64Result(
+      /*rc=*/0, sys_errno == SOCKET_ERROR_AGAIN
+                    ? Api::IoErrorPtr(IoSocketError::getIoSocketEagainInstance(),
+                                      IoSocketError::deleteIoError)
+                    : Api::IoErrorPtr(new IoSocketError(sys_errno), IoSocketError::deleteIoError));
+}
+
+} // namespace
+
+UdpBatchWriter::UdpBatchWriter(IoHandle& io_handle, Stats::Scope& scope,
+                               uint32_t max_batched_datagrams)
+    : io_handle_(io_handle), stats_(generateStats(scope)),
+      max_batched_datagrams_(max_batched_datagrams),
+      batch_mode_(Api::OsSysCallsSingleton::get().supportsMmsg()),
+      gso_supported_(batch_mode_ && Api::OsSysCallsSingleton::get().supportsUdpGso()) {
+  ASSERT(max_batched_datagrams_ > 0);
+  if (batch_mode_) {
+    datagrams_.reserve(max_batched_datagrams_);
+    messages_.resize(max_batched_datagrams_);
+    iovecs_.resize(max_batched_datagrams_);
+    control_.resize(max_batched_datagrams_ * controlSpacePerMessage());
+    message_ends_.resize(max_batched_datagrams_);
+  }
+}
+
+UdpBatchWriter::~UdpBatchWriter() = default;
+
+UdpBatchWriterStats UdpBatchWriter::generateStats(Stats::Scope& scope) {
+  return {UDP_BATCH_WRITER_STATS(POOL_COUNTER_PREFIX(scope, "udp_batch_writer."),
+                                 POOL_GAUGE_PREFIX(scope, "udp_batch_writer."),
+                                 POOL_HISTOGRAM_PREFIX(scope, "udp_batch_writer."))};
+}
+
+size_t UdpBatchWriter::controlSpacePerMessage() {
+  // Room for a source address packet info header plus a UDP_SEGMENT header.
+  return CMSG_SPACE(sizeof(in6_pktinfo)) + CMSG_SPACE(sizeof(uint16_t));
+}
+
+Api::IoCallUint64Result UdpBatchWriter::writePacket(const Buffer::Instance& buffer,
+                                                    const Address::Ip* local_ip,
+                                                    const Address::Instance& peer_address) {
+  if (!batch_mode_) {
+    ASSERT(!write_blocked_, "Cannot write while IO handle is blocked.");
+    Api::IoCallUint64Result result =
+        Utility::writeToSocket(io_handle_, buffer, local_ip, peer_address);
+    if (result.err_ && result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+      write_blocked_ = true;
+    }
+    return result;
+  }
+
+  if (write_blocked_) {
+    // The datagrams buffered so far could not be handed to the kernel. Drop this one rather than
+    // growing the buffer without bound; the caller accounts for it as a failed send.
+    return ioErrorResult(SOCKET_ERROR_AGAIN);
+  }
+
+  const uint64_t length = buffer.length();
+  if (buffer_.empty()) {
+    // Allocate lazily so that idle writers (e.g. one per proxied UDP session) stay small.
+    buffer_.resize(static_cast<size_t>(max_batched_datagrams_) * MAX_UDP_PACKET_SIZE);
+  }
+  if (datagrams_.size() == max_batched_datagrams_ || buffer_used_ + length > buffer_.size()) {
+    flush();
+    if (!datagrams_.empty()) {
+      // The socket became write blocked while making room.
+      return ioErrorResult(SOCKET_ERROR_AGAIN);
+    }
+  }
+  if (length > buffer_.size()) {
+    // Larger than the whole batch buffer. Everything older has been flushed above so ordering is
+    // preserved by sending it directly.
+    Api::IoCallUint64Result result =
+        Utility::writeToSocket(io_handle_, buffer, local_ip, peer_address);
+    if (result.err_ && result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+      write_blocked_ = true;
+    }
+    return result;
+  }
+
+  const auto* address_base = dynamic_cast<const Address::InstanceBase*>(&peer_address);
+  ASSERT(address_base != nullptr);
+  datagrams_.emplace_back();
+  BatchedDatagram& datagram = datagrams_.back();
+  datagram.offset_ = buffer_used_;
+  datagram.length_ = length;
+  datagram.peer_len_ = address_base->sockAddrLen();
+  memcpy(&datagram.peer_, address_base->sockAddr(), datagram.peer_len_);
+  if (local_ip != nullptr) {
+    datagram.self_ip_version_ = local_ip->version();
+    if (local_ip->version() == Address::IpVersion::v4) {
+      datagram.self_ipv4_ = local_ip->ipv4()->address();
+    } else {
+      datagram.self_ipv6_ = local_ip->ipv6()->address();
+    }
+  }
+  buffer.copyOut(0, length, buffer_.data() + buffer_used_);
+  buffer_used_ += length;
+  stats_.buffered_bytes_.set(buffer_used_);
+
+  Api::IoCallUint64Result result = Api::ioCallUint64ResultNoError();
+  result.rc_ = length;
+  return result;
+}
+
+bool UdpBatchWriter::sameRoute(const BatchedDatagram& lhs, const BatchedDatagram& rhs) {
+  if (lhs.peer_len_ != rhs.peer_len_ || memcmp(&lhs.peer_, &rhs.peer_, lhs.peer_len_) != 0 ||
+      lhs.self_ip_version_ != rhs.self_ip_version_) {
+    return false;
+  }
+  if (!lhs.self_ip_version_.has_value()) {
+    return true;
+  }
+  return lhs.self_ip_version_.value() == Address::IpVersion::v4 ? lhs.self_ipv4_ == rhs.self_ipv4_
+                                                                : lhs.self_ipv6_ == rhs.self_ipv6_;
+}
+
+bool UdpBatchWriter::canCoalesce(const BatchedDatagram& first, const BatchedDatagram& last,
+                                 const BatchedDatagram& next, uint64_t run_length) const {
+  // With UDP_SEGMENT the kernel splits the payload into gso_size sized datagrams, so only the
+  // final datagram of a run may be shorter than the first one.
+  return gso_supported_ && first.length_ > 0 && last.length_ == first.length_ &&
+         next.length_ <= first.length_ && run_length + next.length_ <= MaxGsoMessageSize &&
+         sameRoute(first, next);
+}
+
+size_t UdpBatchWriter::buildMessages(size_t first_datagram) {
+  size_t num_messages = 0;
+  size_t current = first_datagram;
+  const size_t control_space = controlSpacePerMessage();
+  while (current < datagrams_.size() && num_messages < messages_.size()) {
+    const BatchedDatagram& first = datagrams_[current];
+    size_t end = current + 1;
+    uint64_t run_length = first.length_;
+    while (end < datagrams_.size() && end - current < MaxGsoSegments &&
+           canCoalesce(first, datagrams_[end - 1], datagrams_[end], run_length)) {
+      run_length += datagrams_[end].length_;
+      ++end;
+    }
+
+    iovec& iov = iovecs_[num_messages];
+    iov.iov_base = buffer_.data() + first.offset_;
+    iov.iov_len = run_length;
+
+    mmsghdr& message = messages_[num_messages];
+    memset(&message, 0, sizeof(message));
+    msghdr& hdr = message.msg_hdr;
+    hdr.msg_name = const_cast<sockaddr_storage*>(&first.peer_);
+    hdr.msg_namelen = first.peer_len_;
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+
+#if ENVOY_MMSG_MORE
+    char* cbuf = control_.data() + num_messages * control_space;
+    memset(cbuf, 0, control_space);
+    hdr.msg_control = cbuf;
+    hdr.msg_controllen = control_space;
+    size_t control_used = 0;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    if (first.self_ip_version_.has_value()) {
+      if (first.self_ip_version_.value() == Address::IpVersion::v4) {
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+        auto pktinfo = reinterpret_cast<in_pktinfo*>(CMSG_DATA(cmsg));
+        pktinfo->ipi_spec_dst.s_addr = first.self_ipv4_;
+        control_used += CMSG_SPACE(sizeof(in_pktinfo));
+      } else {
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+        auto pktinfo = reinterpret_cast<in6_pktinfo*>(CMSG_DATA(cmsg));
+        memcpy(pktinfo->ipi6_addr.s6_addr, &first.self_ipv6_, sizeof(first.self_ipv6_));
+        control_used += CMSG_SPACE(sizeof(in6_pktinfo));
+      }
+      cmsg = CMSG_NXTHDR(&hdr, cmsg);
+    }
+    if (end - current > 1) {
+      ASSERT(cmsg != nullptr);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      *reinterpret_cast<uint16_t*>(CMSG_DATA(cmsg)) = static_cast<uint16_t>(first.length_);
+      control_used += CMSG_SPACE(sizeof(uint16_t));
+    }
+    hdr.msg_controllen = control_used;
+    if (control_used == 0) {
+      hdr.msg_control = nullptr;
+    }
+#else
+    UNREFERENCED_PARAMETER(control_space);
+#endif
+
+    message_ends_[num_messages] = end;
+    ++num_messages;
+    current = end;
+  }
+  return num_messages;
+}
+
+void UdpBatchWriter::consumeDatagrams(size_t count) {
+  if (count == datagrams_.size()) {
+    datagrams_.clear();
+    buffer_used_ = 0;
+  } else if (count > 0) {
+    // Rare: the socket became write blocked in the middle of a flush. Slide the remainder to the
+    // front so that later writes keep appending contiguously.
+    const uint64_t consumed_bytes = datagrams_[count].offset_;
+    memmove(buffer_.data(), buffer_.data() + consumed_bytes, buffer_used_ - consumed_bytes);
+    buffer_used_ -= consumed_bytes;
+    datagrams_.erase(datagrams_.begin(), datagrams_.begin() + count);
+    for (BatchedDatagram& datagram : datagrams_) {
+      datagram.offset_ -= consumed_bytes;
+    }
+  }
+  stats_.buffered_bytes_.set(buffer_used_);
+}
+
+Api::IoCallUint64Result UdpBatchWriter::flush() {
+  if (datagrams_.empty()) {
+    return Api::ioCallUint64ResultNoError();
+  }
+  stats_.datagrams_per_flush_.recordValue(datagrams_.size());
+
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  uint64_t bytes_sent = 0;
+  int last_errno = 0;
+  size_t next = 0;
+  while (next < datagrams_.size()) {
+    const size_t num_messages = buildMessages(next);
+    const Api::SysCallIntResult result =
+        os_sys_calls.sendmmsg(io_handle_.fd(), messages_.data(), num_messages, 0);
+    stats_.tx_syscalls_.inc();
+    if (result.rc_ < 0) {
+      if (result.errno_ == SOCKET_ERROR_AGAIN) {
+        write_blocked_ = true;
+        last_errno = result.errno_;
+        break;
+      }
+      // The first message of the batch was rejected. UDP offers no delivery guarantee so drop it
+      // and carry on with the rest of the batch.
+      ENVOY_LOG(debug, "sendmmsg failed: {}", errorDetails(result.errno_));
+      stats_.tx_errors_.add(message_ends_[0] - next);
+      last_errno = result.errno_;
+      next = message_ends_[0];
+      continue;
+    }
+    ASSERT(result.rc_ > 0);
+    for (int i = 0; i < result.rc_; ++i) {
+      bytes_sent += messages_[i].msg_len;
+    }
+    const size_t sent_end = message_ends_[result.rc_ - 1];
+    stats_.tx_datagrams_.add(sent_end - next);
+    next = sent_end;
+  }
+  stats_.tx_bytes_.add(bytes_sent);
+  consumeDatagrams(next);
+
+  if (last_errno != 0) {
+    return ioErrorResult(last_errno);
+  }
+  Api::IoCallUint64Result result = Api::ioCallUint64ResultNoError();
+  result.rc_ = bytes_sent;
+  return result;
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/common/platform.h"
+#include "envoy/network/address.h"
+#include "envoy/network/io_handle.h"
+#include "envoy/network/udp_packet_writer_handler.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+#include "absl/numeric/int128.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All stats for the UdpBatchWriter. @see stats_macros.h
+ *
+ * @tx_bytes: total payload bytes handed to the kernel by flush().
+ * @tx_datagrams: total datagrams handed to the kernel by flush().
+ * @tx_errors: datagrams dropped because the kernel rejected them with an error other than
+ *   EAGAIN/EWOULDBLOCK.
+ * @tx_syscalls: number of sendmmsg() calls issued. tx_datagrams / tx_syscalls is the achieved
+ *   batching factor.
+ * @buffered_bytes: bytes currently held in the internal buffer waiting for the next flush().
+ * @datagrams_per_flush: number of datagrams buffered at the time of each non-empty flush().
+ */
+#define UDP_BATCH_WRITER_STATS(COUNTER, GAUGE, HISTOGRAM)                                          \
+  COUNTER(tx_bytes)                                                                                \
+  COUNTER(tx_datagrams)                                                                            \
+  COUNTER(tx_errors)                                                                               \
+  COUNTER(tx_syscalls)                                                                             \
+  GAUGE(buffered_bytes, NeverImport)                                                               \
+  HISTOGRAM(datagrams_per_flush, Unspecified)
+
+/**
+ * Wrapper struct for udp batch writer stats. @see stats_macros.h
+ */
+struct UdpBatchWriterStats {
+  UDP_BATCH_WRITER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Generic UdpPacketWriter that accumulates the datagrams written during an event loop iteration
+ * in an internal buffer and hands them to the kernel with as few sendmmsg() calls as possible
+ * when flush() is called. Runs of consecutive datagrams to the same peer in which every datagram
+ * but the last has the same size are coalesced into a single UDP GSO (UDP_SEGMENT) message when
+ * the kernel supports it.
+ *
+ * On platforms without sendmmsg() the writer degrades to pass-through mode and behaves like
+ * UdpDefaultWriter.
+ */
+class UdpBatchWriter : public UdpPacketWriter, protected Logger::Loggable<Logger::Id::udp> {
+public:
+  // Default number of datagrams buffered before a flush is forced.
+  static constexpr uint32_t DefaultMaxBatchedDatagrams = 64;
+
+  UdpBatchWriter(IoHandle& io_handle, Stats::Scope& scope,
+                 uint32_t max_batched_datagrams = DefaultMaxBatchedDatagrams);
+  ~UdpBatchWriter() override;
+
+  // Network::UdpPacketWriter
+  Api::IoCallUint64Result writePacket(const Buffer::Instance& buffer, const Address::Ip* local_ip,
+                                      const Address::Instance& peer_address) override;
+  bool isWriteBlocked() const override { return write_blocked_; }
+  void setWritable() override { write_blocked_ = false; }
+  uint64_t getMaxPacketSize(const Address::Instance& /*peer_address*/) const override {
+    return Network::UdpMaxOutgoingPacketSize;
+  }
+  bool isBatchMode() const override { return batch_mode_; }
+  Network::UdpPacketWriterBuffer
+  getNextWriteLocation(const Address::Ip* /*local_ip*/,
+                       const Address::Instance& /*peer_address*/) override {
+    return {nullptr, 0, nullptr};
+  }
+  Api::IoCallUint64Result flush() override;
+
+  /**
+   * @return the number of datagrams waiting for the next flush().
+   */
+  size_t bufferedDatagrams() const { return datagrams_.size(); }
+
+private:
+  struct BatchedDatagram {
+    // Location of the payload in buffer_.
+    uint64_t offset_;
+    uint64_t length_;
+    sockaddr_storage peer_;
+    socklen_t peer_len_;
+    // Source address requested by the caller, if any.
+    absl::optional<Address::IpVersion> self_ip_version_;
+    uint32_t self_ipv4_{};
+    absl::uint128 self_ipv6_{};
+  };
+
+  static UdpBatchWriterStats generateStats(Stats::Scope& scope);
+  static size_t controlSpacePerMessage();
+  static bool sameRoute(const BatchedDatagram& lhs, const BatchedDatagram& rhs);
+
+  bool canCoalesce(const BatchedDatagram& first, const BatchedDatagram& last,
+                   const BatchedDatagram& next, uint64_t run_length) const;
+  size_t buildMessages(size_t first_datagram);
+  void consumeDatagrams(size_t count);
+
+  IoHandle& io_handle_;
+  UdpBatchWriterStats stats_;
+  const uint32_t max_batched_datagrams_;
+  const bool batch_mode_;
+  const bool gso_supported_;
+  bool write_blocked_{false};
+  // Contiguous payload storage. Datagrams are appended back to back so that a GSO run is always a
+  // single contiguous region.
+  std::vector<uint8_t> buffer_;
+  uint64_t buffer_used_{0};
+  std::vector<BatchedDatagram> datagrams_;
+  // Scratch space reused by every flush().
+  std::vector<mmsghdr> messages_;
+  std::vector<iovec> iovecs_;
+  std::vector<char> control_;
+  // Index one past the last datagram carried by each entry of messages_.
+  std::vector<size_t> message_ends_;
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,39 @@
+#include "common/network/udp_batch_writer_config.h"
+
+#include <memory>
+#include <string>
+
+#include "envoy/config/listener/v3/udp_batch_writer_config.pb.h"
+#include "envoy/config/listener/v3/udp_batch_writer_config.pb.validate.h"
+
+#include "common/network/udp_batch_writer.h"
+#include "common/protobuf/message_validator_impl.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Network {
+
+UdpPacketWriterPtr UdpBatchWriterFactory::createUdpPacketWriter(Network::IoHandle& io_handle,
+                                                                Stats::Scope& scope) {
+  return std::make_unique<UdpBatchWriter>(io_handle, scope, max_batched_datagrams_);
+}
+
+ProtobufTypes::MessagePtr UdpBatchWriterConfigFactory::createEmptyConfigProto() {
+  return std::make_unique<envoy::config::listener::v3::UdpBatchWriterOptions>();
+}
+
+UdpPacketWriterFactoryPtr
+UdpBatchWriterConfigFactory::createUdpPacketWriterFactory(const Protobuf::Message& message) {
+  const auto& options =
+      MessageUtil::downcastAndValidate<const envoy::config::listener::v3::UdpBatchWriterOptions&>(
+          message, ProtobufMessage::getStrictValidationVisitor());
+  return std::make_unique<UdpBatchWriterFactory>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      options, max_batched_datagrams, UdpBatchWriter::DefaultMaxBatchedDatagrams));
+}
+
+std::string UdpBatchWriterConfigFactory::name() const { return "udp_batch_writer"; }
+
+REGISTER_FACTORY(UdpBatchWriterConfigFactory, Network::UdpPacketWriterConfigFactory);
+
+} // namespace Network
+} // namespace Envoy
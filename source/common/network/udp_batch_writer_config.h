@@ -0,0 +1,37 @@
+#pragma once
+
+#include "envoy/network/udp_packet_writer_config.h"
+#include "envoy/network/udp_packet_writer_handler.h"
+#include "envoy/registry/registry.h"
+
+namespace Envoy {
+namespace Network {
+
+class UdpBatchWriterFactory : public Network::UdpPacketWriterFactory {
+public:
+  explicit UdpBatchWriterFactory(uint32_t max_batched_datagrams)
+      : max_batched_datagrams_(max_batched_datagrams) {}
+
+  Network::UdpPacketWriterPtr createUdpPacketWriter(Network::IoHandle& io_handle,
+                                                    Stats::Scope& scope) override;
+
+private:
+  const uint32_t max_batched_datagrams_;
+};
+
+// UdpPacketWriterConfigFactory to create UdpBatchWriterFactory based on given protobuf.
+class UdpBatchWriterConfigFactory : public UdpPacketWriterConfigFactory {
+public:
+  // UdpPacketWriterConfigFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  Network::UdpPacketWriterFactoryPtr
+  createUdpPacketWriterFactory(const Protobuf::Message& message) override;
+
+  std::string name() const override;
+};
+
+DECLARE_FACTORY(UdpBatchWriterConfigFactory);
+
+} // namespace Network
+} // namespace Envoy
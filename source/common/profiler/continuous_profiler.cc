@@ -0,0 +1,398 @@
+#include "common/profiler/continuous_profiler.h"
+
+#include <atomic>
+#include <cerrno>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/profiler/profiler.h"
+#include "common/protobuf/utility.h"
+
+#include "absl/debugging/stacktrace.h"
+#include "absl/debugging/symbolize.h"
+#include "absl/strings/str_format.h"
+
+#ifndef WIN32
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Envoy {
+namespace Profiler {
+
+namespace {
+
+// The longest time between two drains of the per-thread buffers.
+constexpr std::chrono::milliseconds MaxCollectInterval{1000};
+
+// Drains the buffers often enough that a thread busy on a CPU fills at most half of its buffer in
+// between, which at the default frequency is once a second.
+std::chrono::milliseconds collectInterval(uint32_t frequency_hz) {
+  return std::min(MaxCollectInterval,
+                  std::chrono::milliseconds(1000 * ContinuousProfiler::SamplesPerThread /
+                                            (2 * frequency_hz)));
+}
+
+struct Sample {
+  int depth_;
+  void* stack_[ContinuousProfiler::MaxStackDepth];
+};
+
+// Single producer, single consumer ring: the owning thread pushes from the signal handler, the
+// main thread pops in collectSamples(). Both indices only grow, the slot is the index modulo the
+// capacity.
+struct ThreadBuffer {
+  // The id of the thread the buffer belongs to, 0 while the buffer is free.
+  std::atomic<int32_t> owner_{0};
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  Sample samples_[ContinuousProfiler::SamplesPerThread];
+};
+
+// The buffers are allocated by the first profiler and never freed, since a signal may still be
+// handled on another thread while a profiler is destroyed. A thread claims a buffer the first time
+// it is sampled and keeps it for its lifetime; collectSamples() frees the buffers of the threads
+// which exited.
+ThreadBuffer* thread_buffers = nullptr;
+std::atomic<uint64_t> dropped_samples{0};
+std::atomic<bool> profiler_running{false};
+// The binary is linked statically, so accessing this from the signal handler does not allocate.
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+#ifdef __linux__
+int32_t currentThreadId() { return static_cast<int32_t>(syscall(SYS_gettid)); }
+
+bool threadExited(int32_t thread_id) {
+  return syscall(SYS_tgkill, getpid(), thread_id, 0) != 0 && errno == ESRCH;
+}
+#else
+// Without a way to tell whether a thread exited, buffers are kept for the process lifetime.
+int32_t currentThreadId() { return 1; }
+
+bool threadExited(int32_t) { return false; }
+#endif
+
+#ifndef WIN32
+struct sigaction previous_action;
+
+// Called from the signal handler the first time a thread is sampled.
+ThreadBuffer* claimThreadBuffer() {
+  const int32_t thread_id = currentThreadId();
+  for (uint32_t i = 0; i < ContinuousProfiler::MaxThreads; ++i) {
+    int32_t owner = 0;
+    if (thread_buffers[i].owner_.load(std::memory_order_relaxed) == 0 &&
+        thread_buffers[i].owner_.compare_exchange_strong(owner, thread_id,
+                                                         std::memory_order_acq_rel)) {
+      return &thread_buffers[i];
+    }
+  }
+  return nullptr;
+}
+
+// Must stay async-signal-safe: no allocation, no locks.
+void onSigprof(int, siginfo_t*, void* ucontext) {
+  const int saved_errno = errno;
+  ThreadBuffer* buffer = thread_buffer;
+  if (buffer == nullptr) {
+    buffer = thread_buffer = claimThreadBuffer();
+    if (buffer == nullptr) {
+      dropped_samples.fetch_add(1, std::memory_order_relaxed);
+      errno = saved_errno;
+      return;
+    }
+  }
+
+  const uint32_t head = buffer->head_.load(std::memory_order_relaxed);
+  if (head - buffer->tail_.load(std::memory_order_acquire) ==
+      ContinuousProfiler::SamplesPerThread) {
+    dropped_samples.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    Sample& sample = buffer->samples_[head % ContinuousProfiler::SamplesPerThread];
+    sample.depth_ = absl::GetStackTraceWithContext(sample.stack_, ContinuousProfiler::MaxStackDepth,
+                                                   /* skip_count = */ 1, ucontext, nullptr);
+    buffer->head_.store(head + 1, std::memory_order_release);
+  }
+  errno = saved_errno;
+}
+
+void setProfileTimer(uint32_t frequency_hz) {
+  struct itimerval timer {};
+  if (frequency_hz > 0) {
+    const uint32_t interval_us = 1000000 / frequency_hz;
+    timer.it_interval.tv_sec = interval_us / 1000000;
+    timer.it_interval.tv_usec = interval_us % 1000000;
+    timer.it_value = timer.it_interval;
+  }
+  RELEASE_ASSERT(setitimer(ITIMER_PROF, &timer, nullptr) == 0, "");
+}
+#endif
+
+// Minimal writer of the protobuf wire format, enough for the pprof profile.proto messages without
+// depending on their generated code.
+class ProtoWriter {
+public:
+  void varint(uint32_t field, uint64_t value) {
+    tag(field, 0);
+    raw(value);
+  }
+  void bytes(uint32_t field, absl::string_view value) {
+    tag(field, 2);
+    raw(value.size());
+    out_.append(value.data(), value.size());
+  }
+  void message(uint32_t field, const ProtoWriter& message) { bytes(field, message.data()); }
+  void packed(uint32_t field, const std::vector<uint64_t>& values) {
+    ProtoWriter packed;
+    for (const uint64_t value : values) {
+      packed.raw(value);
+    }
+    bytes(field, packed.data());
+  }
+
+  const std::string& data() const { return out_; }
+
+private:
+  void tag(uint32_t field, uint32_t wire_type) { raw((field << 3) | wire_type); }
+  void raw(uint64_t value) {
+    while (value >= 0x80) {
+      out_.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+  }
+
+  std::string out_;
+};
+
+// Interns the strings of a pprof profile; index 0 is the empty string.
+class StringTable {
+public:
+  StringTable() { index(""); }
+
+  uint64_t index(const std::string& value) {
+    const auto it = indexes_.try_emplace(value, strings_.size());
+    if (it.second) {
+      strings_.push_back(value);
+    }
+    return it.first->second;
+  }
+
+  const std::vector<std::string>& strings() const { return strings_; }
+
+private:
+  absl::flat_hash_map<std::string, uint64_t> indexes_;
+  std::vector<std::string> strings_;
+};
+
+ProtoWriter valueType(StringTable& strings, const std::string& type, const std::string& unit) {
+  ProtoWriter value_type;
+  value_type.varint(1, strings.index(type)); // type
+  value_type.varint(2, strings.index(unit)); // unit
+  return value_type;
+}
+
+} // namespace
+
+ContinuousProfiler::ContinuousProfiler(
+    const envoy::config::bootstrap::v3::Admin::ContinuousProfiler& config,
+    Event::Dispatcher& dispatcher, TimeSource& time_source)
+    : frequency_hz_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, frequency_hz, 19)),
+      window_duration_(PROTOBUF_GET_MS_OR_DEFAULT(config, window_duration, 10000)),
+      window_count_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, window_count, 6)),
+      collect_interval_(collectInterval(frequency_hz_)), time_source_(time_source),
+      collect_timer_(dispatcher.createTimer([this]() {
+        collectSamples();
+        collect_timer_->enableTimer(collect_interval_);
+      })) {
+#ifdef WIN32
+  throw EnvoyException("the continuous profiler is not supported on this platform");
+#else
+  if (Cpu::profilerEnabled()) {
+    throw EnvoyException("the continuous profiler cannot run with the CPU profiler");
+  }
+  if (profiler_running.exchange(true)) {
+    throw EnvoyException("a continuous profiler is already running");
+  }
+  if (thread_buffers == nullptr) {
+    thread_buffers = new ThreadBuffer[MaxThreads];
+  }
+  // Discard what an earlier profiler left behind.
+  for (uint32_t i = 0; i < MaxThreads; ++i) {
+    thread_buffers[i].tail_.store(thread_buffers[i].head_.load(std::memory_order_acquire),
+                                  std::memory_order_release);
+  }
+
+  windows_.push_back({time_source_.monotonicTime(), {}});
+  struct sigaction action {};
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  action.sa_sigaction = onSigprof;
+  sigemptyset(&action.sa_mask);
+  RELEASE_ASSERT(sigaction(SIGPROF, &action, &previous_action) == 0, "");
+  setProfileTimer(frequency_hz_);
+  collect_timer_->enableTimer(collect_interval_);
+#endif
+}
+
+ContinuousProfiler::~ContinuousProfiler() {
+#ifndef WIN32
+  setProfileTimer(0);
+  RELEASE_ASSERT(sigaction(SIGPROF, &previous_action, nullptr) == 0, "");
+  profiler_running.store(false);
+#endif
+}
+
+bool ContinuousProfiler::running() { return profiler_running.load(); }
+
+uint64_t ContinuousProfiler::droppedSamples() {
+  return dropped_samples.load(std::memory_order_relaxed);
+}
+
+uint32_t ContinuousProfiler::threadBuffersInUse() {
+  uint32_t in_use = 0;
+  for (uint32_t i = 0; thread_buffers != nullptr && i < MaxThreads; ++i) {
+    if (thread_buffers[i].owner_.load(std::memory_order_relaxed) != 0) {
+      ++in_use;
+    }
+  }
+  return in_use;
+}
+
+void ContinuousProfiler::collectSamples() {
+  rotateWindows();
+  for (uint32_t i = 0; i < MaxThreads; ++i) {
+    ThreadBuffer& buffer = thread_buffers[i];
+    const int32_t owner = buffer.owner_.load(std::memory_order_acquire);
+    if (owner == 0) {
+      continue;
+    }
+    // Checked before draining, so that nothing the thread pushed before it exited is lost.
+    const bool exited = threadExited(owner);
+    uint32_t tail = buffer.tail_.load(std::memory_order_relaxed);
+    const uint32_t head = buffer.head_.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      const Sample& sample = buffer.samples_[tail % SamplesPerThread];
+      Stack stack;
+      stack.reserve(sample.depth_);
+      for (int j = 0; j < sample.depth_; ++j) {
+        stack.push_back(reinterpret_cast<uintptr_t>(sample.stack_[j]));
+      }
+      addSample(std::move(stack));
+    }
+    buffer.tail_.store(tail, std::memory_order_release);
+    if (exited) {
+      buffer.owner_.store(0, std::memory_order_release);
+    }
+  }
+}
+
+void ContinuousProfiler::addSample(Stack&& stack) { ++windows_.back().samples_[std::move(stack)]; }
+
+void ContinuousProfiler::rotateWindows() {
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (now - windows_.back().start_ >= maxDuration()) {
+    // Nothing was collected for longer than all the windows cover.
+    windows_.clear();
+    windows_.push_back({now, {}});
+    return;
+  }
+  while (now - windows_.back().start_ >= window_duration_) {
+    windows_.push_back({windows_.back().start_ + window_duration_, {}});
+  }
+  while (windows_.size() > window_count_) {
+    windows_.pop_front();
+  }
+}
+
+const std::string& ContinuousProfiler::symbolize(uintptr_t address) {
+  auto it = symbols_.find(address);
+  if (it == symbols_.end()) {
+    char symbol[1024];
+    it = symbols_
+             .emplace(address, absl::Symbolize(reinterpret_cast<void*>(address), symbol,
+                                               sizeof(symbol))
+                                   ? std::string(symbol)
+                                   : absl::StrFormat("0x%x", address))
+             .first;
+  }
+  return it->second;
+}
+
+void ContinuousProfiler::writeProfile(std::chrono::milliseconds duration,
+                                      Buffer::Instance& output) {
+  collectSamples();
+  const size_t windows = std::min<size_t>(
+      windows_.size(),
+      std::max<size_t>(1, (duration.count() + window_duration_.count() - 1) /
+                              window_duration_.count()));
+  absl::flat_hash_map<Stack, uint64_t> samples;
+  for (auto window = windows_.end() - windows; window != windows_.end(); ++window) {
+    for (const auto& sample : window->samples_) {
+      samples[sample.first] += sample.second;
+    }
+  }
+
+  // Field numbers are those of the perftools.profiles.Profile message. Repeated fields don't need
+  // to be contiguous, so the messages are written in the order they are built.
+  ProtoWriter profile;
+  StringTable strings;
+  const uint64_t period_ns = 1000000000 / frequency_hz_;
+  profile.message(1, valueType(strings, "samples", "count"));    // sample_type
+  profile.message(1, valueType(strings, "cpu", "nanoseconds"));  // sample_type
+  profile.message(11, valueType(strings, "cpu", "nanoseconds")); // period_type
+  profile.varint(12, period_ns);                                 // period
+  const auto profile_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      time_source_.monotonicTime() - windows_[windows_.size() - windows].start_);
+  profile.varint(9, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        time_source_.systemTime().time_since_epoch() - profile_duration)
+                        .count());              // time_nanos
+  profile.varint(10, profile_duration.count()); // duration_nanos
+
+  absl::flat_hash_map<uintptr_t, uint64_t> location_ids;
+  absl::flat_hash_map<std::string, uint64_t> function_ids;
+  for (const auto& sample : samples) {
+    std::vector<uint64_t> sample_location_ids;
+    sample_location_ids.reserve(sample.first.size());
+    for (const uintptr_t address : sample.first) {
+      auto location = location_ids.find(address);
+      if (location == location_ids.end()) {
+        const std::string& name = symbolize(address);
+        auto function = function_ids.find(name);
+        if (function == function_ids.end()) {
+          function = function_ids.emplace(name, function_ids.size() + 1).first;
+          ProtoWriter function_message;
+          function_message.varint(1, function->second);    // id
+          function_message.varint(2, strings.index(name)); // name
+          function_message.varint(3, strings.index(name)); // system_name
+          profile.message(5, function_message);            // function
+        }
+        location = location_ids.emplace(address, location_ids.size() + 1).first;
+        ProtoWriter line;
+        line.varint(1, function->second); // function_id
+        ProtoWriter location_message;
+        location_message.varint(1, location->second); // id
+        location_message.varint(3, address);          // address
+        location_message.message(4, line);            // line
+        profile.message(4, location_message);         // location
+      }
+      sample_location_ids.push_back(location->second);
+    }
+    ProtoWriter sample_message;
+    sample_message.packed(1, sample_location_ids);                        // location_id
+    sample_message.packed(2, {sample.second, sample.second * period_ns}); // value
+    profile.message(2, sample_message);                                   // sample
+  }
+
+  for (const std::string& string : strings.strings()) {
+    profile.bytes(6, string); // string_table
+  }
+  output.add(profile.data());
+}
+
+} // namespace Profiler
+} // namespace Envoy
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/time.h"
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+
+namespace Envoy {
+namespace Profiler {
+
+/**
+ * Always-on sampling CPU profiler. The process CPU time is sampled with SIGPROF at a low fixed
+ * frequency. The signal handler only records the raw return addresses of the interrupted thread
+ * into a lock-free buffer owned by that thread. A timer on the main dispatcher periodically
+ * drains the buffers into a rolling set of windows, and the addresses are only symbolized when a
+ * profile is written, in the pprof format.
+ *
+ * SIGPROF and ITIMER_PROF are process wide, so at most one profiler can run at a time, and not
+ * while the gperftools CPU profiler is running.
+ */
+class ContinuousProfiler {
+public:
+  /**
+   * Starts sampling. Throws EnvoyException if sampling could not be started.
+   * @param config supplies the profiler configuration.
+   * @param dispatcher supplies the main dispatcher, which drains the samples.
+   * @param time_source supplies the time source used to rotate the windows.
+   */
+  ContinuousProfiler(const envoy::config::bootstrap::v3::Admin::ContinuousProfiler& config,
+                     Event::Dispatcher& dispatcher, TimeSource& time_source);
+  ~ContinuousProfiler();
+
+  /**
+   * @return whether a continuous profiler is running in this process.
+   */
+  static bool running();
+
+  /**
+   * Moves the samples taken since the last call from the per-thread buffers to the current
+   * window. Called periodically on the main thread.
+   */
+  void collectSamples();
+
+  /**
+   * Writes an uncompressed pprof profile of the samples taken over the supplied duration, rounded
+   * up to whole windows and capped to maxDuration(). Must be called on the main thread.
+   */
+  void writeProfile(std::chrono::milliseconds duration, Buffer::Instance& output);
+
+  /**
+   * @return the longest duration a profile can cover.
+   */
+  std::chrono::milliseconds maxDuration() const { return window_duration_ * window_count_; }
+
+  /**
+   * @return the number of samples lost because a thread buffer was full or no buffer was left.
+   */
+  static uint64_t droppedSamples();
+
+  /**
+   * @return the number of thread buffers currently owned by a thread.
+   */
+  static uint32_t threadBuffersInUse();
+
+  // The number of samples a thread buffer holds between two collections.
+  static constexpr uint32_t SamplesPerThread = 64;
+  // The number of live threads samples can be recorded for.
+  static constexpr uint32_t MaxThreads = 128;
+  static constexpr int MaxStackDepth = 48;
+
+private:
+  friend class ContinuousProfilerPeer;
+
+  using Stack = std::vector<uintptr_t>;
+
+  struct Window {
+    MonotonicTime start_;
+    absl::flat_hash_map<Stack, uint64_t> samples_;
+  };
+
+  void addSample(Stack&& stack);
+  void rotateWindows();
+  const std::string& symbolize(uintptr_t address);
+
+  const uint32_t frequency_hz_;
+  const std::chrono::milliseconds window_duration_;
+  const uint32_t window_count_;
+  const std::chrono::milliseconds collect_interval_;
+  TimeSource& time_source_;
+  const Event::TimerPtr collect_timer_;
+  // Oldest first. The last window is the one samples are added to.
+  std::deque<Window> windows_;
+  // Symbols are kept across profiles, addresses of the binary don't change.
+  absl::node_hash_map<uintptr_t, std::string> symbols_;
+};
+
+using ContinuousProfilerPtr = std::unique_ptr<ContinuousProfiler>;
+
+} // namespace Profiler
+} // namespace Envoy
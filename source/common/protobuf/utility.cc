@@ -930,6 +930,15 @@ uint64_t DurationUtil::durationToSeconds(const ProtobufWkt::Duration& duration)
   return Protobuf::util::TimeUtil::DurationToSeconds(duration);
 }
 
+Protobuf::ArenaOptions ArenaUtil::options(std::vector<char>& initial_block,
+                                          uint64_t max_block_size) {
+  Protobuf::ArenaOptions options;
+  options.initial_block = initial_block.data();
+  options.initial_block_size = initial_block.size();
+  options.max_block_size = max_block_size;
+  return options;
+}
+
 void TimestampUtil::systemClockToTimestamp(const SystemTime system_clock_time,
                                            ProtobufWkt::Timestamp& timestamp) {
   // Converts to millisecond-precision Timestamp by explicitly casting to millisecond-precision
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <numeric>
+#include <vector>
 
 #include "envoy/api/api.h"
 #include "envoy/common/exception.h"
@@ -578,6 +579,19 @@ public:
   static uint64_t durationToSeconds(const ProtobufWkt::Duration& duration);
 };
 
+class ArenaUtil {
+public:
+  /**
+   * Options of an arena whose first block is a buffer owned by the caller, so that the memory of
+   * the block is reused whenever the arena is reset.
+   * @param initial_block supplies the first block of the arena, which must outlive the arena.
+   * @param max_block_size supplies the size of the largest block the arena allocates once the
+   *        first one is full.
+   * @return the options of the arena.
+   */
+  static Protobuf::ArenaOptions options(std::vector<char>& initial_block, uint64_t max_block_size);
+};
+
 class TimestampUtil {
 public:
   /**
@@ -1,6 +1,8 @@
 #include "common/stats/allocator_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <thread>
 
 #include "envoy/stats/stats.h"
 #include "envoy/stats/symbol_table.h"
@@ -22,9 +24,110 @@ namespace Stats {
 
 const char AllocatorImpl::DecrementToZeroSyncPoint[] = "decrement-zero";
 
+/**
+ * The stats which changed since the log was last drained. Any thread appends to it without locking,
+ * while it is drained by one thread at a time. The stats are kept in fixed size segments, which are
+ * chained when they fill up and reused once drained, so a log only grows to the largest number of
+ * stats which changed between two drains.
+ */
+template <class StatType> class ChangedStatLog {
+public:
+  ChangedStatLog() : head_(new Segment()) {}
+
+  ~ChangedStatLog() {
+    for (Segment* segment = head_.load(); segment != nullptr;) {
+      Segment* next = segment->next_;
+      delete segment;
+      segment = next;
+    }
+  }
+
+  void append(StatType* stat) {
+    Segment* segment = head_.load(std::memory_order_acquire);
+    while (true) {
+      const uint64_t index = segment->size_.fetch_add(1, std::memory_order_relaxed);
+      if (index < SegmentSize) {
+        segment->stats_[index].store(stat, std::memory_order_release);
+        return;
+      }
+      // The segment is full, or was replaced to be drained.
+      Segment* head = head_.load(std::memory_order_acquire);
+      if (head != segment) {
+        segment = head;
+        continue;
+      }
+      auto new_segment = std::make_unique<Segment>();
+      new_segment->stats_[0].store(stat, std::memory_order_relaxed);
+      new_segment->size_.store(1, std::memory_order_relaxed);
+      new_segment->next_ = segment;
+      // On failure, segment is set to the head another thread installed.
+      if (head_.compare_exchange_strong(segment, new_segment.get(), std::memory_order_release,
+                                        std::memory_order_acquire)) {
+        new_segment.release();
+        return;
+      }
+    }
+  }
+
+  void drain(absl::flat_hash_set<StatType*>& drained) {
+    Segment* empty_segment;
+    if (free_segments_.empty()) {
+      empty_segment = new Segment();
+    } else {
+      empty_segment = free_segments_.back().release();
+      free_segments_.pop_back();
+      empty_segment->size_.store(0, std::memory_order_relaxed);
+    }
+    Segment* segment = head_.exchange(empty_segment, std::memory_order_acq_rel);
+    while (segment != nullptr) {
+      // Marking the segment full sends the later appends to the new head. The appends which
+      // already have a slot in it are waited for, which only takes a few instructions each.
+      const uint64_t size =
+          std::min(segment->size_.exchange(SegmentSize, std::memory_order_acq_rel), SegmentSize);
+      for (uint64_t i = 0; i < size; ++i) {
+        StatType* stat;
+        while ((stat = segment->stats_[i].exchange(nullptr, std::memory_order_acquire)) ==
+               nullptr) {
+          std::this_thread::yield();
+        }
+        drained.insert(stat);
+      }
+      Segment* next = segment->next_;
+      segment->next_ = nullptr;
+      // A thread which is late to see the new head may still increment the size of the segment,
+      // so segments are never freed while the log is in use.
+      free_segments_.emplace_back(segment);
+      segment = next;
+    }
+  }
+
+private:
+  static constexpr uint64_t SegmentSize = 1024;
+
+  struct Segment {
+    Segment() {
+      for (auto& stat : stats_) {
+        stat.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    // The number of slots taken, which may exceed SegmentSize once the segment is full.
+    std::atomic<uint64_t> size_{0};
+    std::atomic<StatType*> stats_[SegmentSize];
+    // The segment which was the head before this one, only written before it is the head.
+    Segment* next_{};
+  };
+
+  std::atomic<Segment*> head_;
+  // Only used by drain().
+  std::vector<std::unique_ptr<Segment>> free_segments_;
+};
+
 AllocatorImpl::~AllocatorImpl() {
   ASSERT(counters_.empty());
   ASSERT(gauges_.empty());
+  ASSERT(drained_counters_.empty());
+  ASSERT(drained_gauges_.empty());
 }
 
 #ifndef ENVOY_CONFIG_COVERAGE
@@ -66,6 +169,8 @@ public:
   SymbolTable& symbolTable() final { return alloc_.symbolTable(); }
   bool used() const override { return flags_ & Metric::Flags::Used; }
 
+  void clearChanged() { flags_ &= ~Metric::Flags::Changed; }
+
   // RefcountInterface
   void incRefCount() override { ++ref_count_; }
   bool decRefCount() override {
@@ -99,6 +204,28 @@ public:
   virtual void removeFromSetLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) PURE;
 
 protected:
+  /**
+   * Sets flags, and marks the stat changed if the allocator tracks the changed stats. This must be
+   * called after the value is updated: a collection clears the changed flag before the value is
+   * read, so the new value is either seen by the collection or the stat is marked again.
+   *
+   * The flags are only written when some are missing, so that updating a stat which is already
+   * marked does not contend on the cache line with the other threads updating it. The thread which
+   * sets the changed flag appends the stat to the changed log, without taking any lock.
+   */
+  void markChanged(uint16_t flags, ChangedStatLog<BaseClass>* changed_log) {
+    if (alloc_.track_changed_stats_) {
+      flags |= Metric::Flags::Changed;
+    }
+    if ((flags_ & flags) == flags) {
+      return;
+    }
+    const uint16_t old_flags = flags_.fetch_or(flags);
+    if ((flags & ~old_flags) & Metric::Flags::Changed) {
+      changed_log->append(this);
+    }
+  }
+
   AllocatorImpl& alloc_;
 
   // ref_count_ can be incremented as an atomic, without taking a new lock, as
@@ -124,6 +251,11 @@ public:
   void removeFromSetLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
     const size_t count = alloc_.counters_.erase(statName());
     ASSERT(count == 1);
+    if (flags_ & Flags::Changed) {
+      // The counter can't be found in the changed log, so the log is drained to remove it.
+      alloc_.changed_counters_->drain(alloc_.drained_counters_);
+      alloc_.drained_counters_.erase(this);
+    }
   }
 
   // Stats::Counter
@@ -132,14 +264,21 @@ public:
     // used(). From a system perspective this should be eventually consistent.
     value_ += amount;
     pending_increment_ += amount;
-    flags_ |= Flags::Used;
+    markChanged(Flags::Used);
   }
   void inc() override { add(1); }
   uint64_t latch() override { return pending_increment_.exchange(0); }
-  void reset() override { value_ = 0; }
+  void reset() override {
+    value_ = 0;
+    markChanged(0);
+  }
   uint64_t value() const override { return value_; }
 
 private:
+  void markChanged(uint16_t flags) {
+    StatsSharedImpl::markChanged(flags, alloc_.changed_counters_.get());
+  }
+
   std::atomic<uint64_t> value_{0};
   std::atomic<uint64_t> pending_increment_{0};
 };
@@ -168,23 +307,28 @@ public:
   void removeFromSetLockHeld() override ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) {
     const size_t count = alloc_.gauges_.erase(statName());
     ASSERT(count == 1);
+    if (flags_ & Flags::Changed) {
+      alloc_.changed_gauges_->drain(alloc_.drained_gauges_);
+      alloc_.drained_gauges_.erase(this);
+    }
   }
 
   // Stats::Gauge
   void add(uint64_t amount) override {
     child_value_ += amount;
-    flags_ |= Flags::Used;
+    markChanged(Flags::Used);
   }
   void dec() override { sub(1); }
   void inc() override { add(1); }
   void set(uint64_t value) override {
     child_value_ = value;
-    flags_ |= Flags::Used;
+    markChanged(Flags::Used);
   }
   void sub(uint64_t amount) override {
     ASSERT(child_value_ >= amount);
     ASSERT(used() || amount == 0);
     child_value_ -= amount;
+    markChanged(0);
   }
   uint64_t value() const override { return child_value_ + parent_value_; }
 
@@ -207,7 +351,7 @@ public:
     case ImportMode::Uninitialized:
       // mergeImportNode(ImportMode::Uninitialized) is called when merging an
       // existing stat with importMode() == Accumulate or NeverImport.
-      break;
+      return;
     case ImportMode::Accumulate:
       ASSERT(current == ImportMode::Uninitialized);
       flags_ |= Flags::LogicAccumulate;
@@ -222,11 +366,21 @@ public:
       flags_ |= Flags::NeverImport;
       break;
     }
+    // The store doesn't collect the gauges whose import mode is uninitialized, so the gauge is
+    // marked again to be collected with its import mode.
+    markChanged(0);
   }
 
-  void setParentValue(uint64_t value) override { parent_value_ = value; }
+  void setParentValue(uint64_t value) override {
+    parent_value_ = value;
+    markChanged(0);
+  }
 
 private:
+  void markChanged(uint16_t flags) {
+    StatsSharedImpl::markChanged(flags, alloc_.changed_gauges_.get());
+  }
+
   std::atomic<uint64_t> parent_value_{0};
   std::atomic<uint64_t> child_value_{0};
 };
@@ -303,6 +457,62 @@ TextReadoutSharedPtr AllocatorImpl::makeTextReadout(StatName name, StatName tag_
   return text_readout;
 }
 
+void AllocatorImpl::trackChangedStats() {
+  Thread::LockGuard lock(mutex_);
+  if (track_changed_stats_) {
+    return;
+  }
+  changed_counters_ = std::make_unique<ChangedStatLog<Counter>>();
+  changed_gauges_ = std::make_unique<ChangedStatLog<Gauge>>();
+  all_stats_changed_ = true;
+  // Set last, as the stats append to the logs once they see it set.
+  track_changed_stats_ = true;
+}
+
+void AllocatorImpl::collectChangedStats(std::vector<CounterSharedPtr>& counters,
+                                        std::vector<GaugeSharedPtr>& gauges) {
+  ASSERT(track_changed_stats_);
+  // Holding mutex_ keeps the changed stats from being freed until we hold references to them.
+  Thread::LockGuard lock(mutex_);
+  changed_counters_->drain(drained_counters_);
+  changed_gauges_->drain(drained_gauges_);
+  absl::flat_hash_set<Counter*> changed_counters;
+  absl::flat_hash_set<Gauge*> changed_gauges;
+  changed_counters.swap(drained_counters_);
+  changed_gauges.swap(drained_gauges_);
+
+  // Only the stats which marked themselves are in the changed logs, so these are not wrapped by a
+  // derived allocator such as the one of the integration tests.
+  for (Counter* counter : changed_counters) {
+    static_cast<CounterImpl*>(counter)->clearChanged();
+  }
+  for (Gauge* gauge : changed_gauges) {
+    static_cast<GaugeImpl*>(gauge)->clearChanged();
+  }
+
+  if (all_stats_changed_) {
+    all_stats_changed_ = false;
+    counters.reserve(counters.size() + counters_.size());
+    for (Counter* counter : counters_) {
+      counters.emplace_back(counter);
+    }
+    gauges.reserve(gauges.size() + gauges_.size());
+    for (Gauge* gauge : gauges_) {
+      gauges.emplace_back(gauge);
+    }
+    return;
+  }
+
+  counters.reserve(counters.size() + changed_counters.size());
+  for (Counter* counter : changed_counters) {
+    counters.emplace_back(counter);
+  }
+  gauges.reserve(gauges.size() + changed_gauges.size());
+  for (Gauge* gauge : changed_gauges) {
+    gauges.emplace_back(gauge);
+  }
+}
+
 bool AllocatorImpl::isMutexLockedForTest() {
   bool locked = mutex_.tryLock();
   if (locked) {
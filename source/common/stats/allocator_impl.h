@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "envoy/stats/allocator.h"
@@ -15,6 +17,8 @@
 namespace Envoy {
 namespace Stats {
 
+template <class StatType> class ChangedStatLog;
+
 class AllocatorImpl : public Allocator {
 public:
   static const char DecrementToZeroSyncPoint[];
@@ -32,6 +36,9 @@ public:
                                        const StatNameTagVector& stat_name_tags) override;
   SymbolTable& symbolTable() override { return symbol_table_; }
   const SymbolTable& constSymbolTable() const override { return symbol_table_; }
+  void trackChangedStats() override;
+  void collectChangedStats(std::vector<CounterSharedPtr>& counters,
+                           std::vector<GaugeSharedPtr>& gauges) override;
 
 #ifndef ENVOY_CONFIG_COVERAGE
   void debugPrint();
@@ -74,6 +81,23 @@ private:
   // protected by locks.
   Thread::MutexBasicLockable mutex_;
 
+  // Whether the counters and gauges mark themselves changed. Once set, the stats which changed are
+  // appended to changed_counters_ and changed_gauges_ the first time they change after a
+  // collection.
+  std::atomic<bool> track_changed_stats_{false};
+  // Set until the first collection after trackChangedStats(), as the stats which changed before the
+  // tracking started are not in the changed logs.
+  bool all_stats_changed_ ABSL_GUARDED_BY(mutex_){false};
+
+  // Logs of the changed stats, only allocated once the changed stats are tracked, so that the stats
+  // themselves don't take any space for it. The worker threads append to them without locking, as
+  // a stat changes far more often than stats are allocated or freed. The logs are only drained with
+  // mutex_ held, into the drained sets, from which a changed stat is removed when it's freed.
+  std::unique_ptr<ChangedStatLog<Counter>> changed_counters_;
+  std::unique_ptr<ChangedStatLog<Gauge>> changed_gauges_;
+  absl::flat_hash_set<Counter*> drained_counters_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_set<Gauge*> drained_gauges_ ABSL_GUARDED_BY(mutex_);
+
   Thread::ThreadSynchronizer sync_;
 };
 
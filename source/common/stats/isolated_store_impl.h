@@ -186,6 +186,12 @@ public:
   std::vector<TextReadoutSharedPtr> textReadouts() const override {
     return text_readouts_.toVector();
   }
+  void trackChangedMetrics() override { alloc_.trackChangedStats(); }
+  ChangedMetrics collectChangedMetrics() override {
+    ChangedMetrics changed;
+    alloc_.collectChangedStats(changed.counters_, changed.gauges_);
+    return changed;
+  }
 
   Counter& counterFromString(const std::string& name) override {
     StatNameManagedStorage storage(name, symbolTable());
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "absl/strings/str_join.h"
+
 namespace Envoy {
 namespace Stats {
 
@@ -92,8 +94,7 @@ void StatMerger::mergeGauges(const Protobuf::Map<std::string, uint64_t>& gauges,
     //
     // 1. Child thinks gauge is Accumulate : data is combined in
     //    gauge_ref.add() below.
-    // 2. Child thinks gauge is NeverImport: we skip this loop entry via
-    //    'continue'.
+    // 2. Child thinks gauge is NeverImport: mergeGauge() skips it.
     // 3. Child has not yet initialized gauge yet -- this merge is the
     //    first time the child learns of the gauge. It's possible the child
     //    will think the gauge is NeverImport due to a code change. But for
@@ -108,37 +109,113 @@ void StatMerger::mergeGauges(const Protobuf::Map<std::string, uint64_t>& gauges,
     //     retained.
 
     StatMerger::DynamicContext dynamic_context(temp_scope_->symbolTable());
-    StatName stat_name = dynamic_context.makeDynamicStatName(gauge.first, dynamic_map);
-    GaugeOptConstRef gauge_opt = temp_scope_->findGauge(stat_name);
-
-    Gauge::ImportMode import_mode = Gauge::ImportMode::Uninitialized;
-    if (gauge_opt) {
-      import_mode = gauge_opt->get().importMode();
-      if (import_mode == Gauge::ImportMode::NeverImport) {
-        continue;
-      }
+    mergeGauge(dynamic_context.makeDynamicStatName(gauge.first, dynamic_map), gauge.second);
+  }
+}
+
+void StatMerger::mergeGauge(StatName stat_name, uint64_t parent_value) {
+  GaugeOptConstRef gauge_opt = temp_scope_->findGauge(stat_name);
+
+  Gauge::ImportMode import_mode = Gauge::ImportMode::Uninitialized;
+  if (gauge_opt) {
+    import_mode = gauge_opt->get().importMode();
+    if (import_mode == Gauge::ImportMode::NeverImport) {
+      return;
     }
+  }
+
+  // TODO(snowp): Propagate tag values during hot restarts.
+  auto& gauge_ref = temp_scope_->gaugeFromStatName(stat_name, import_mode);
+  if (gauge_ref.importMode() == Gauge::ImportMode::NeverImport) {
+    // On the first iteration through the loop, the gauge will not be loaded into the scope
+    // cache even though it might exist in another scope. Thus, we need to check again for
+    // the import status to see if we should skip this gauge.
+    //
+    // TODO(mattklein123): There is a race condition here. It's technically possible that
+    // between the time we created this stat, the stat might be created by the child as a
+    // never import stat, making the below math invalid. A follow up solution is to take the
+    // store lock starting from gaugeFromStatName() to the end of this function, but this will
+    // require adding some type of mergeGauge() function to the scope and dealing with recursive
+    // lock acquisition, etc. so we will leave this as a follow up. This race should be incredibly
+    // rare.
+    return;
+  }
+
+  parent_gauges_.insert(gauge_ref.statName());
+  gauge_ref.setParentValue(parent_value);
+}
 
-    // TODO(snowp): Propagate tag values during hot restarts.
-    auto& gauge_ref = temp_scope_->gaugeFromStatName(stat_name, import_mode);
-    if (gauge_ref.importMode() == Gauge::ImportMode::NeverImport) {
-      // On the first iteration through the loop, the gauge will not be loaded into the scope
-      // cache even though it might exist in another scope. Thus, we need to check again for
-      // the import status to see if we should skip this gauge.
-      //
-      // TODO(mattklein123): There is a race condition here. It's technically possible that
-      // between the time we created this stat, the stat might be created by the child as a
-      // never import stat, making the below math invalid. A follow up solution is to take the
-      // store lock starting from gaugeFromStatName() to the end of this function, but this will
-      // require adding some type of mergeGauge() function to the scope and dealing with recursive
-      // lock acquisition, etc. so we will leave this as a follow up. This race should be incredibly
-      // rare.
+void StatMerger::mergeSnapshot(const StatsSnapshot& snapshot) {
+  ASSERT(snapshot.valid());
+  SymbolTable& symbol_table = temp_scope_->symbolTable();
+  StatNamePool symbolic_pool(symbol_table);
+  StatNameDynamicPool dynamic_pool(symbol_table);
+  // The StatName of each token, looked up on first use. A token may be used both as a symbolic
+  // and as a dynamic segment.
+  std::vector<StatName> symbolic_tokens(snapshot.numTokens());
+  std::vector<StatName> dynamic_tokens(snapshot.numTokens());
+
+  StatNameVec segments;
+  std::vector<absl::string_view> dynamic_segments;
+  for (const StatsSnapshot::Record& record : snapshot.records()) {
+    if (record.type_ == StatsSnapshot::RecordType::Counter && record.value_ == 0) {
+      // Counters that did not change since they were last latched, as mergeCounters() never sees.
       continue;
     }
+    segments.clear();
+    bool has_empty_symbolic = false;
+    bool has_dynamic = false;
+    const absl::Span<const uint32_t> token_refs = snapshot.tokenRefs(record);
+    for (size_t i = 0; i < token_refs.size(); ++i) {
+      const uint32_t index = token_refs[i] & StatsSnapshot::TokenIndexMask;
+      has_dynamic |= (token_refs[i] & StatsSnapshot::Dynamic) != 0;
+      if (!(token_refs[i] & StatsSnapshot::Dynamic)) {
+        if (symbolic_tokens[index].empty()) {
+          symbolic_tokens[index] = symbolic_pool.add(snapshot.token(index));
+        }
+        has_empty_symbolic |= snapshot.token(index).empty();
+        segments.push_back(symbolic_tokens[index]);
+      } else if (i + 1 == token_refs.size() ||
+                 (token_refs[i + 1] & (StatsSnapshot::Dynamic | StatsSnapshot::DynamicSpanStart)) !=
+                     StatsSnapshot::Dynamic) {
+        // A dynamic span of a single segment, the common case.
+        if (dynamic_tokens[index].empty()) {
+          dynamic_tokens[index] = dynamic_pool.add(snapshot.token(index));
+        }
+        segments.push_back(dynamic_tokens[index]);
+      } else {
+        // A dynamic span of several segments, which were split on '.' by the parent.
+        dynamic_segments.clear();
+        dynamic_segments.push_back(snapshot.token(index));
+        while (i + 1 < token_refs.size() &&
+               (token_refs[i + 1] & (StatsSnapshot::Dynamic | StatsSnapshot::DynamicSpanStart)) ==
+                   StatsSnapshot::Dynamic) {
+          ++i;
+          dynamic_segments.push_back(snapshot.token(token_refs[i] & StatsSnapshot::TokenIndexMask));
+        }
+        segments.push_back(dynamic_pool.add(absl::StrJoin(dynamic_segments, ".")));
+      }
+    }
 
-    const uint64_t new_parent_value = gauge.second;
-    parent_gauges_.insert(gauge_ref.statName());
-    gauge_ref.setParentValue(new_parent_value);
+    SymbolTable::StoragePtr storage;
+    StatName stat_name;
+    if (has_empty_symbolic && !has_dynamic) {
+      // An empty token can't be joined as a segment, but a fully symbolic name with empty segments
+      // like "a..b" is encoded with them, as mergeStats() does.
+      std::vector<absl::string_view> tokens;
+      for (const uint32_t token_ref : token_refs) {
+        tokens.push_back(snapshot.token(token_ref & StatsSnapshot::TokenIndexMask));
+      }
+      stat_name = symbolic_pool.add(absl::StrJoin(tokens, "."));
+    } else {
+      storage = symbol_table.join(segments);
+      stat_name = StatName(storage.get());
+    }
+    if (record.type_ == StatsSnapshot::RecordType::Counter) {
+      temp_scope_->counterFromStatName(stat_name).add(record.value_);
+    } else {
+      mergeGauge(stat_name, record.value_);
+    }
   }
 }
 
@@ -3,6 +3,7 @@
 #include "envoy/stats/store.h"
 
 #include "common/protobuf/protobuf.h"
+#include "common/stats/stats_snapshot.h"
 #include "common/stats/symbol_table_impl.h"
 
 #include "absl/container/flat_hash_map.h"
@@ -56,6 +57,15 @@ public:
                   const Protobuf::Map<std::string, uint64_t>& gauges,
                   const DynamicsMap& dynamics = DynamicsMap());
 
+  /**
+   * Merge the values of a snapshot into stats_store, like mergeStats(). Each distinct name token
+   * of the snapshot is looked up in the symbol table once, and names are built by joining the
+   * tokens rather than by parsing strings.
+   *
+   * @param snapshot a valid snapshot of counter changes and gauge values from parent.
+   */
+  void mergeSnapshot(const StatsSnapshot& snapshot);
+
   /**
    * Indicates that a gauge's value from the hot-restart parent should be
    * retained, combining it with the child data. By default, data is transferred
@@ -76,6 +86,7 @@ private:
                      const DynamicsMap& dynamics_map);
   void mergeGauges(const Protobuf::Map<std::string, uint64_t>& gauges,
                    const DynamicsMap& dynamics_map);
+  void mergeGauge(StatName stat_name, uint64_t parent_value);
 
   StatNameHashSet parent_gauges_;
   // A stats Scope for our in-the-merging-process counters to live in. Scopes conceptually hold
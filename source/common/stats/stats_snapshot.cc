@@ -0,0 +1,134 @@
+#include "common/stats/stats_snapshot.h"
+
+#include <cstring>
+#include <limits>
+
+#include "common/common/assert.h"
+
+#include "absl/strings/str_split.h"
+
+namespace Envoy {
+namespace Stats {
+
+uint32_t StatsSnapshot::Builder::add(StatName name, uint64_t value, RecordType type) {
+  const std::string string_name = symbol_table_.toString(name);
+  const DynamicSpans spans = symbol_table_.getDynamicSpans(name);
+  auto span = spans.begin();
+
+  Record record{value, static_cast<uint32_t>(token_refs_.size()), 0, type, 0};
+  uint32_t segment_index = 0;
+  for (absl::string_view segment : absl::StrSplit(string_name, '.')) {
+    uint32_t token_ref = tokenIndex(segment);
+    if (span != spans.end() && segment_index >= span->first) {
+      token_ref |= Dynamic;
+      if (segment_index == span->first) {
+        token_ref |= DynamicSpanStart;
+      }
+      if (segment_index == span->second) {
+        ++span;
+      }
+    }
+    token_refs_.push_back(token_ref);
+    ++segment_index;
+  }
+  ASSERT(span == spans.end());
+  RELEASE_ASSERT(segment_index <= std::numeric_limits<uint16_t>::max(), "stat name too long");
+  record.num_token_refs_ = segment_index;
+  records_.push_back(record);
+  return records_.size() - 1;
+}
+
+uint32_t StatsSnapshot::Builder::tokenIndex(absl::string_view token) {
+  const auto it = token_indexes_.find(token);
+  if (it != token_indexes_.end()) {
+    return it->second;
+  }
+  const uint32_t index = token_ends_.size();
+  RELEASE_ASSERT(index <= TokenIndexMask, "too many distinct stat name tokens");
+  characters_.append(token.data(), token.size());
+  token_ends_.push_back(characters_.size());
+  token_indexes_.emplace(token, index);
+  return index;
+}
+
+uint64_t StatsSnapshot::Builder::size() const {
+  return align(sizeof(Header)) + align(records_.size() * sizeof(Record)) +
+         align(token_refs_.size() * sizeof(uint32_t)) +
+         align(token_ends_.size() * sizeof(uint32_t)) + align(characters_.size());
+}
+
+void StatsSnapshot::Builder::write(uint8_t* output) const {
+  ASSERT(reinterpret_cast<uintptr_t>(output) % alignof(uint64_t) == 0);
+  RELEASE_ASSERT(characters_.size() <= std::numeric_limits<uint32_t>::max(),
+                 "stat name tokens too long");
+  const Header header{Magic, static_cast<uint32_t>(records_.size()),
+                      static_cast<uint32_t>(token_refs_.size()),
+                      static_cast<uint32_t>(token_ends_.size()),
+                      static_cast<uint32_t>(characters_.size())};
+  auto append = [&output](const void* data, uint64_t size) {
+    if (size > 0) {
+      memcpy(output, data, size);
+    }
+    memset(output + size, 0, align(size) - size);
+    output += align(size);
+  };
+  append(&header, sizeof(header));
+  append(records_.data(), records_.size() * sizeof(Record));
+  append(token_refs_.data(), token_refs_.size() * sizeof(uint32_t));
+  append(token_ends_.data(), token_ends_.size() * sizeof(uint32_t));
+  append(characters_.data(), characters_.size());
+}
+
+StatsSnapshot::StatsSnapshot(absl::Span<const uint8_t> bytes) {
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint64_t) != 0 ||
+      bytes.size() < sizeof(Header)) {
+    return;
+  }
+  const Header& header = *reinterpret_cast<const Header*>(bytes.data());
+  if (header.magic_ != Magic) {
+    return;
+  }
+  // The counts are 32 bits, so none of these overflows.
+  const uint64_t records_offset = align(sizeof(Header));
+  const uint64_t token_refs_offset =
+      records_offset + align(uint64_t(header.num_records_) * sizeof(Record));
+  const uint64_t token_ends_offset =
+      token_refs_offset + align(uint64_t(header.num_token_refs_) * sizeof(uint32_t));
+  const uint64_t characters_offset =
+      token_ends_offset + align(uint64_t(header.num_tokens_) * sizeof(uint32_t));
+  if (characters_offset + header.num_characters_ > bytes.size()) {
+    return;
+  }
+  records_ = absl::MakeConstSpan(
+      reinterpret_cast<const Record*>(bytes.data() + records_offset), header.num_records_);
+  token_refs_ = absl::MakeConstSpan(
+      reinterpret_cast<const uint32_t*>(bytes.data() + token_refs_offset), header.num_token_refs_);
+  token_ends_ = absl::MakeConstSpan(
+      reinterpret_cast<const uint32_t*>(bytes.data() + token_ends_offset), header.num_tokens_);
+  characters_ = absl::string_view(reinterpret_cast<const char*>(bytes.data() + characters_offset),
+                                  header.num_characters_);
+
+  // Check every reference once here, so that readers can index without bounds checks.
+  uint32_t previous_end = 0;
+  for (const uint32_t end : token_ends_) {
+    if (end < previous_end || end > characters_.size()) {
+      return;
+    }
+    previous_end = end;
+  }
+  for (const uint32_t token_ref : token_refs_) {
+    if ((token_ref & TokenIndexMask) >= token_ends_.size()) {
+      return;
+    }
+  }
+  for (const Record& record : records_) {
+    if (uint64_t(record.first_token_ref_) + record.num_token_refs_ > token_refs_.size() ||
+        (record.type_ != RecordType::Counter && record.type_ != RecordType::Gauge)) {
+      return;
+    }
+  }
+  valid_ = true;
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/symbol_table.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Flat snapshot of counter deltas and gauge values, exchanged between hot restart parent and child
+ * through shared memory. Unlike the HotRestartMessage stats maps, the snapshot is read in place,
+ * without parsing, and names are not repeated in full: each distinct dot-separated segment is
+ * stored once in a token table, and each name is an array of references into it. This lets the
+ * receiver look each token up in its own symbol table only once.
+ *
+ * Layout, with every section aligned to 8 bytes:
+ *   Header
+ *   Record[num_records_]
+ *   uint32_t token_refs[num_token_refs_]   (the names of the records)
+ *   uint32_t token_ends[num_tokens_]       (end offset of each token in the characters)
+ *   char characters[]
+ */
+class StatsSnapshot {
+public:
+  enum class RecordType : uint8_t { Counter, Gauge };
+
+  struct Record {
+    uint64_t value_;
+    // The name is token_refs[first_token_ref_, first_token_ref_ + num_token_refs_).
+    uint32_t first_token_ref_;
+    uint16_t num_token_refs_;
+    RecordType type_;
+    uint8_t reserved_;
+  };
+
+  // A token reference is a token index, plus flags recording which segments of the name are
+  // dynamic. A dynamic span of several segments starts with DynamicSpanStart and is followed by
+  // references with only Dynamic set.
+  static constexpr uint32_t Dynamic = 1u << 31;
+  static constexpr uint32_t DynamicSpanStart = 1u << 30;
+  static constexpr uint32_t TokenIndexMask = DynamicSpanStart - 1;
+
+  /**
+   * Accumulates stats and writes them in the snapshot format.
+   */
+  class Builder {
+  public:
+    explicit Builder(const SymbolTable& symbol_table) : symbol_table_(symbol_table) {}
+
+    /**
+     * Add a record. The value can be changed with setValue() until the snapshot is written.
+     * @return the index of the record.
+     */
+    uint32_t addCounter(StatName name, uint64_t delta) {
+      return add(name, delta, RecordType::Counter);
+    }
+    uint32_t addGauge(StatName name, uint64_t value) { return add(name, value, RecordType::Gauge); }
+
+    void setValue(uint32_t record, uint64_t value) { records_[record].value_ = value; }
+
+    /**
+     * @return the size in bytes of the snapshot.
+     */
+    uint64_t size() const;
+
+    /**
+     * Writes the snapshot.
+     * @param output supplies size() bytes of 8 byte aligned memory.
+     */
+    void write(uint8_t* output) const;
+
+  private:
+    uint32_t add(StatName name, uint64_t value, RecordType type);
+    uint32_t tokenIndex(absl::string_view token);
+
+    const SymbolTable& symbol_table_;
+    std::vector<Record> records_;
+    std::vector<uint32_t> token_refs_;
+    absl::flat_hash_map<std::string, uint32_t> token_indexes_;
+    std::vector<uint32_t> token_ends_;
+    std::string characters_;
+  };
+
+  /**
+   * Views a snapshot, which must outlive this object.
+   * @param bytes supplies the 8 byte aligned snapshot.
+   */
+  explicit StatsSnapshot(absl::Span<const uint8_t> bytes);
+
+  /**
+   * @return whether the snapshot is well formed. No other method may be called otherwise.
+   */
+  bool valid() const { return valid_; }
+
+  absl::Span<const Record> records() const { return records_; }
+  absl::Span<const uint32_t> tokenRefs(const Record& record) const {
+    return token_refs_.subspan(record.first_token_ref_, record.num_token_refs_);
+  }
+  uint32_t numTokens() const { return token_ends_.size(); }
+  absl::string_view token(uint32_t index) const {
+    const uint32_t begin = index == 0 ? 0 : token_ends_[index - 1];
+    return characters_.substr(begin, token_ends_[index] - begin);
+  }
+
+  // Identifies the format. The last byte is the format version.
+  static constexpr uint64_t Magic = 0x5354415453534e01;
+
+private:
+  struct Header {
+    uint64_t magic_;
+    uint32_t num_records_;
+    uint32_t num_token_refs_;
+    uint32_t num_tokens_;
+    uint32_t num_characters_;
+  };
+
+  static uint64_t align(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+  bool valid_{};
+  absl::Span<const Record> records_;
+  absl::Span<const uint32_t> token_refs_;
+  absl::Span<const uint32_t> token_ends_;
+  absl::string_view characters_;
+};
+
+} // namespace Stats
+} // namespace Envoy
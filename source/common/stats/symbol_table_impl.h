@@ -1,7 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <stack>
 #include <string>
@@ -21,8 +24,10 @@
 
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 
 namespace Envoy {
 namespace Stats {
@@ -208,11 +213,68 @@ private:
   struct SharedSymbol {
     SharedSymbol(Symbol symbol) : symbol_(symbol), ref_count_(1) {}
 
+    // flat_hash_map moves its values when it rehashes, which only happens while the owning shard's
+    // mutex is held exclusively, so a relaxed copy of the count is sufficient.
+    SharedSymbol(SharedSymbol&& src) noexcept
+        : symbol_(src.symbol_), ref_count_(src.ref_count_.load(std::memory_order_relaxed)) {}
+    SharedSymbol& operator=(SharedSymbol&& src) noexcept {
+      symbol_ = src.symbol_;
+      ref_count_.store(src.ref_count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      return *this;
+    }
+
     Symbol symbol_;
-    uint32_t ref_count_;
+    // Incremented with the shard's mutex held shared. A count only ever drops to zero with the
+    // mutex held exclusively, at which point the entry is erased, so lookups can never observe or
+    // resurrect an unreferenced symbol.
+    std::atomic<uint32_t> ref_count_;
   };
 
-  // This must be held during both encode() and free().
+  // Bitmap implementation.
+  // The encode map stores both the symbol and the ref count of that symbol.
+  // Using absl::string_view lets us only store the complete string once, in the decode map.
+  using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbol>;
+  using DecodeMap = absl::flat_hash_map<Symbol, InlineStringPtr>;
+
+  // The string->symbol and symbol->string maps are split into independently locked shards so
+  // that threads encoding or freeing unrelated names do not contend. Encoding a token that is
+  // already in the table only takes its shard's mutex in shared mode. Shards are cache-line aligned
+  // to avoid false sharing between their mutexes.
+  //
+  // Lock ordering: an EncodeShard mutex may be held while acquiring a DecodeShard mutex, and either
+  // may be held while acquiring lock_. Never the reverse.
+  static constexpr uint32_t NumShardBits = 4;
+  static constexpr uint32_t NumShards = 1 << NumShardBits;
+
+  struct alignas(64) EncodeShard {
+    mutable absl::Mutex mutex_;
+    EncodeMap map_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  struct alignas(64) DecodeShard {
+    mutable absl::Mutex mutex_;
+    DecodeMap map_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  static size_t encodeShardIndex(absl::string_view token) {
+    // The maps hash the same key with the same hash function and consume its low bits, so the
+    // shard is selected from the high bits.
+    return absl::Hash<absl::string_view>()(token) >>
+           (std::numeric_limits<size_t>::digits - NumShardBits);
+  }
+  EncodeShard& encodeShard(absl::string_view token) {
+    return encode_shards_[encodeShardIndex(token)];
+  }
+  const EncodeShard& encodeShard(absl::string_view token) const {
+    return encode_shards_[encodeShardIndex(token)];
+  }
+  DecodeShard& decodeShard(Symbol symbol) { return decode_shards_[symbol & (NumShards - 1)]; }
+  const DecodeShard& decodeShard(Symbol symbol) const {
+    return decode_shards_[symbol & (NumShards - 1)];
+  }
+
+  // Guards symbol allocation and the free pool. It is only taken when a token is added to or
+  // removed from the table.
   mutable Thread::MutexBasicLockable lock_;
 
   /**
@@ -236,20 +298,38 @@ private:
    * @param sv the individual string to be encoded as a symbol.
    * @return Symbol the encoded string.
    */
-  Symbol toSymbol(absl::string_view sv) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Symbol toSymbol(absl::string_view sv);
 
   /**
-   * Convenience function for decode(), decoding one symbol at a time.
+   * Convenience function for decode(), decoding one symbol at a time. The caller must hold a
+   * reference to the symbol for as long as it uses the returned string.
    *
    * @param symbol the individual symbol to be decoded.
    * @return absl::string_view the decoded string.
    */
-  absl::string_view fromSymbol(Symbol symbol) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  absl::string_view fromSymbol(Symbol symbol) const;
+
+  /**
+   * Drops one reference to a symbol, removing it from the table if it was the last one.
+   *
+   * @param symbol the symbol to release.
+   */
+  void releaseSymbol(Symbol symbol);
+
+  /**
+   * @return Symbol the symbol to use for a newly inserted token.
+   */
+  Symbol allocateSymbol();
 
   /**
    * Stages a new symbol for use. To be called after a successful insertion.
    */
-  void newSymbol();
+  void newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /**
+   * Records a lookup of name for the admin recent-lookups endpoint.
+   */
+  void recordLookup(absl::string_view name);
 
   /**
    * Tokenizes name, finds or allocates symbols for each token, and adds them
@@ -270,21 +350,22 @@ private:
   Symbol next_symbol_ ABSL_GUARDED_BY(lock_);
 
   // If the free pool is exhausted, we monotonically increase this counter.
-  Symbol monotonic_counter_;
+  Symbol monotonic_counter_ ABSL_GUARDED_BY(lock_);
 
-  // Bitmap implementation.
-  // The encode map stores both the symbol and the ref count of that symbol.
-  // Using absl::string_view lets us only store the complete string once, in the decode map.
-  using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbol>;
-  using DecodeMap = absl::flat_hash_map<Symbol, InlineStringPtr>;
-  EncodeMap encode_map_ ABSL_GUARDED_BY(lock_);
-  DecodeMap decode_map_ ABSL_GUARDED_BY(lock_);
+  std::array<EncodeShard, NumShards> encode_shards_;
+  std::array<DecodeShard, NumShards> decode_shards_;
 
   // Free pool of symbols for re-use.
   // TODO(ambuc): There might be an optimization here relating to storing ranges of freed symbols
   // using an Envoy::IntervalSet.
   std::stack<Symbol> pool_ ABSL_GUARDED_BY(lock_);
-  RecentLookups recent_lookups_ ABSL_GUARDED_BY(lock_);
+
+  // Recent lookups are only recorded while a capacity is configured. Otherwise every encode() just
+  // bumps untracked_lookups_, so the lookup count stays available without serializing encodes.
+  mutable Thread::MutexBasicLockable recent_lookups_lock_;
+  RecentLookups recent_lookups_ ABSL_GUARDED_BY(recent_lookups_lock_);
+  std::atomic<bool> track_recent_lookups_{false};
+  std::atomic<uint64_t> untracked_lookups_{0};
 };
 
 // Base class for holding the backing-storing for a StatName. The two derived
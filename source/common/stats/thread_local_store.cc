@@ -1,5 +1,6 @@
 #include "common/stats/thread_local_store.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -152,6 +153,21 @@ std::vector<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   return ret;
 }
 
+Store::ChangedMetrics ThreadLocalStoreImpl::collectChangedMetrics() {
+  // The allocator holds each stat once, so unlike counters() and gauges() there is no de-dup. As
+  // for gauges(), the gauges whose import mode is uninitialized are skipped, until the allocator
+  // marks them changed again when their import mode is set.
+  ChangedMetrics changed;
+  alloc_.collectChangedStats(changed.counters_, changed.gauges_);
+  changed.gauges_.erase(std::remove_if(changed.gauges_.begin(), changed.gauges_.end(),
+                                       [](const GaugeSharedPtr& gauge) {
+                                         return gauge->importMode() ==
+                                                Gauge::ImportMode::Uninitialized;
+                                       }),
+                        changed.gauges_.end());
+  return changed;
+}
+
 std::vector<TextReadoutSharedPtr> ThreadLocalStoreImpl::textReadouts() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<TextReadoutSharedPtr> ret;
@@ -242,6 +242,8 @@ public:
   std::vector<GaugeSharedPtr> gauges() const override;
   std::vector<TextReadoutSharedPtr> textReadouts() const override;
   std::vector<ParentHistogramSharedPtr> histograms() const override;
+  void trackChangedMetrics() override { alloc_.trackChangedStats(); }
+  ChangedMetrics collectChangedMetrics() override;
 
   // Stats::StoreRoot
   void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
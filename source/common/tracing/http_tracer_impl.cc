@@ -158,6 +158,11 @@ void HttpTracerUtility::finalizeDownstreamSpan(Span& span,
                                                const Http::ResponseTrailerMap* response_trailers,
                                                const StreamInfo::StreamInfo& stream_info,
                                                const Config& tracing_config) {
+  if (!span.isRecording()) {
+    span.finishSpan();
+    return;
+  }
+
   // Pre response data.
   if (request_headers) {
     if (request_headers->RequestId()) {
@@ -211,6 +216,11 @@ void HttpTracerUtility::finalizeUpstreamSpan(Span& span,
                                              const Http::ResponseTrailerMap* response_trailers,
                                              const StreamInfo::StreamInfo& stream_info,
                                              const Config& tracing_config) {
+  if (!span.isRecording()) {
+    span.finishSpan();
+    return;
+  }
+
   span.setTag(Tracing::Tags::get().HttpProtocol,
               Formatter::SubstitutionFormatUtils::protocolToString(stream_info.protocol()));
 
@@ -289,7 +299,7 @@ SpanPtr HttpTracerImpl::startSpan(const Config& config, Http::RequestHeaderMap&
                                            stream_info.startTime(), tracing_decision);
 
   // Set tags related to the local environment
-  if (active_span) {
+  if (active_span && active_span->isRecording()) {
     active_span->setTag(Tracing::Tags::get().NodeId, local_info_.nodeName());
     active_span->setTag(Tracing::Tags::get().Zone, local_info_.zoneName());
   }
@@ -175,6 +175,24 @@ public:
     return SpanPtr{new NullSpan()};
   }
   void setSampled(bool) override {}
+  bool isRecording() const override { return false; }
+};
+
+/**
+ * Base class of the lightweight spans which drivers may start for the traces which are not
+ * sampled. Such a span is not recording: it only carries what the driver needs to propagate the
+ * trace context, and it is up to the driver to inject the context and to spawn the children.
+ */
+class PropagationSpan : public Span {
+public:
+  // Tracing::Span
+  void setOperation(absl::string_view) override {}
+  void setTag(absl::string_view, absl::string_view) override {}
+  void log(SystemTime, const std::string&) override {}
+  void finishSpan() override {}
+  void setBaggage(absl::string_view, absl::string_view) override {}
+  std::string getBaggage(absl::string_view) override { return std::string(); }
+  bool isRecording() const override { return false; }
 };
 
 class HttpNullTracer : public HttpTracer {
@@ -1,5 +1,7 @@
 #include "extensions/access_loggers/grpc/grpc_access_log_impl.h"
 
+#include <algorithm>
+
 #include "envoy/data/accesslog/v3/accesslog.pb.h"
 #include "envoy/extensions/access_loggers/grpc/v3/als.pb.h"
 #include "envoy/upstream/upstream.h"
@@ -7,6 +9,7 @@
 #include "common/common/assert.h"
 #include "common/grpc/typed_async_client.h"
 #include "common/network/utility.h"
+#include "common/protobuf/utility.h"
 #include "common/runtime/runtime_features.h"
 #include "common/stream_info/utility.h"
 
@@ -15,6 +18,16 @@ namespace Extensions {
 namespace AccessLoggers {
 namespace GrpcCommon {
 
+namespace {
+
+// The first block of the batch arena is sized after the flush threshold, within these bounds. A
+// batch takes more memory than its serialized size, so it may grow the arena past its first block,
+// by blocks of at most MaxArenaBlockSize.
+constexpr uint64_t MinArenaBlockSize = 1024;
+constexpr uint64_t MaxArenaBlockSize = 64 * 1024;
+
+} // namespace
+
 void GrpcAccessLoggerImpl::LocalStream::onRemoteClose(Grpc::Status::GrpcStatus,
                                                       const std::string&) {
   ASSERT(parent_.stream_ != absl::nullopt);
@@ -38,7 +51,14 @@ GrpcAccessLoggerImpl::GrpcAccessLoggerImpl(
         flush();
         flush_timer_->enableTimer(buffer_flush_interval_msec_);
       })),
-      max_buffer_size_bytes_(max_buffer_size_bytes), local_info_(local_info),
+      max_buffer_size_bytes_(max_buffer_size_bytes),
+      arena_initial_block_(
+          std::max(MinArenaBlockSize, std::min(max_buffer_size_bytes, MaxArenaBlockSize))),
+      arena_(ArenaUtil::options(arena_initial_block_, MaxArenaBlockSize)),
+      message_(
+          Protobuf::Arena::CreateMessage<envoy::service::accesslog::v3::StreamAccessLogsMessage>(
+              &arena_)),
+      local_info_(local_info),
       service_method_(
           Grpc::VersionedMethods("envoy.service.accesslog.v3.AccessLogService.StreamAccessLogs",
                                  "envoy.service.accesslog.v2.AccessLogService.StreamAccessLogs")
@@ -65,27 +85,43 @@ bool GrpcAccessLoggerImpl::canLogMore() {
   return true;
 }
 
-void GrpcAccessLoggerImpl::log(envoy::data::accesslog::v3::HTTPAccessLogEntry&& entry) {
+void GrpcAccessLoggerImpl::log(const HttpLogEntryBuilder& build) {
   if (!canLogMore()) {
     return;
   }
-  approximate_message_size_bytes_ += entry.ByteSizeLong();
-  message_.mutable_http_logs()->mutable_log_entry()->Add(std::move(entry));
-  if (approximate_message_size_bytes_ >= max_buffer_size_bytes_) {
-    flush();
-  }
+  auto* entry = message_->mutable_http_logs()->add_log_entry();
+  build(*entry);
+  addedEntry(entry->ByteSizeLong());
+}
+
+void GrpcAccessLoggerImpl::log(const TcpLogEntryBuilder& build) {
+  auto* entry = message_->mutable_tcp_logs()->add_log_entry();
+  build(*entry);
+  addedEntry(entry->ByteSizeLong());
+}
+
+void GrpcAccessLoggerImpl::log(envoy::data::accesslog::v3::HTTPAccessLogEntry&& entry) {
+  // The entry isn't on the arena of the batch, so it is copied.
+  log([&entry](envoy::data::accesslog::v3::HTTPAccessLogEntry& batched_entry) {
+    batched_entry = std::move(entry);
+  });
 }
 
 void GrpcAccessLoggerImpl::log(envoy::data::accesslog::v3::TCPAccessLogEntry&& entry) {
-  approximate_message_size_bytes_ += entry.ByteSizeLong();
-  message_.mutable_tcp_logs()->mutable_log_entry()->Add(std::move(entry));
+  log([&entry](envoy::data::accesslog::v3::TCPAccessLogEntry& batched_entry) {
+    batched_entry = std::move(entry);
+  });
+}
+
+void GrpcAccessLoggerImpl::addedEntry(uint64_t entry_size_bytes) {
+  approximate_message_size_bytes_ += entry_size_bytes;
   if (approximate_message_size_bytes_ >= max_buffer_size_bytes_) {
     flush();
   }
 }
 
 void GrpcAccessLoggerImpl::flush() {
-  if (!message_.has_http_logs() && !message_.has_tcp_logs()) {
+  if (!message_->has_http_logs() && !message_->has_tcp_logs()) {
     // Nothing to flush.
     return;
   }
@@ -98,7 +134,7 @@ void GrpcAccessLoggerImpl::flush() {
     stream_->stream_ =
         client_->start(service_method_, *stream_, Http::AsyncClient::StreamOptions());
 
-    auto* identifier = message_.mutable_identifier();
+    auto* identifier = message_->mutable_identifier();
     *identifier->mutable_node() = local_info_.node();
     identifier->set_log_name(log_name_);
   }
@@ -107,15 +143,23 @@ void GrpcAccessLoggerImpl::flush() {
     if (stream_->stream_->isAboveWriteBufferHighWatermark()) {
       return;
     }
-    stream_->stream_->sendMessage(message_, transport_api_version_, false);
+    stream_->stream_->sendMessage(*message_, transport_api_version_, false);
   } else {
     // Clear out the stream data due to stream creation failure.
     stream_.reset();
   }
 
   // Clear the message regardless of the success.
+  clearMessage();
+}
+
+void GrpcAccessLoggerImpl::clearMessage() {
   approximate_message_size_bytes_ = 0;
-  message_.Clear();
+  // Frees the whole batch at once, rather than message by message.
+  arena_.Reset();
+  message_ =
+      Protobuf::Arena::CreateMessage<envoy::service::accesslog::v3::StreamAccessLogsMessage>(
+          &arena_);
 }
 
 GrpcAccessLoggerCacheImpl::GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager,
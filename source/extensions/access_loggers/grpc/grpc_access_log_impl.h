@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -35,6 +36,12 @@ struct GrpcAccessLoggerStats {
   ALL_GRPC_ACCESS_LOGGER_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * Functions filling in an access log entry, which the logger allocated in its pending batch.
+ */
+using HttpLogEntryBuilder = std::function<void(envoy::data::accesslog::v3::HTTPAccessLogEntry&)>;
+using TcpLogEntryBuilder = std::function<void(envoy::data::accesslog::v3::TCPAccessLogEntry&)>;
+
 /**
  * Interface for an access logger. The logger provides abstraction on top of gRPC stream, deals with
  * reconnects and performs batching.
@@ -43,6 +50,20 @@ class GrpcAccessLogger {
 public:
   virtual ~GrpcAccessLogger() = default;
 
+  /**
+   * Log http access entry, built in place in the pending batch. This saves copying the entry into
+   * the batch, so it is preferred over passing a complete entry.
+   * @param build supplies the function filling in the entry. It is not called if the entry is
+   *        dropped.
+   */
+  virtual void log(const HttpLogEntryBuilder& build) PURE;
+
+  /**
+   * Log tcp access entry, built in place in the pending batch.
+   * @param build supplies the function filling in the entry.
+   */
+  virtual void log(const TcpLogEntryBuilder& build) PURE;
+
   /**
    * Log http access entry.
    * @param entry supplies the access log to send.
@@ -89,6 +110,8 @@ public:
                        envoy::config::core::v3::ApiVersion transport_api_version);
 
   // Extensions::AccessLoggers::GrpcCommon::GrpcAccessLogger
+  void log(const HttpLogEntryBuilder& build) override;
+  void log(const TcpLogEntryBuilder& build) override;
   void log(envoy::data::accesslog::v3::HTTPAccessLogEntry&& entry) override;
   void log(envoy::data::accesslog::v3::TCPAccessLogEntry&& entry) override;
 
@@ -110,6 +133,8 @@ private:
   };
 
   void flush();
+  void clearMessage();
+  void addedEntry(uint64_t entry_size_bytes);
 
   bool canLogMore();
 
@@ -122,7 +147,11 @@ private:
   const Event::TimerPtr flush_timer_;
   const uint64_t max_buffer_size_bytes_;
   uint64_t approximate_message_size_bytes_ = 0;
-  envoy::service::accesslog::v3::StreamAccessLogsMessage message_;
+  // The pending batch is allocated on an arena, which is reset once the batch is sent. The first
+  // block of the arena is kept, so that building a batch usually doesn't allocate memory.
+  std::vector<char> arena_initial_block_;
+  Protobuf::Arena arena_;
+  envoy::service::accesslog::v3::StreamAccessLogsMessage* message_;
   absl::optional<LocalStream> stream_;
   const LocalInfo::LocalInfo& local_info_;
   const Protobuf::MethodDescriptor& service_method_;
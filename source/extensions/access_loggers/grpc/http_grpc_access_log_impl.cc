@@ -52,9 +52,21 @@ void HttpGrpcAccessLog::emitLog(const Http::RequestHeaderMap& request_headers,
                                 const Http::ResponseHeaderMap& response_headers,
                                 const Http::ResponseTrailerMap& response_trailers,
                                 const StreamInfo::StreamInfo& stream_info) {
+  // The entry is built in place in the batch of the logger.
+  tls_slot_->getTyped<ThreadLocalLogger>().logger_->log(
+      [&](envoy::data::accesslog::v3::HTTPAccessLogEntry& log_entry) {
+        buildLogEntry(log_entry, request_headers, response_headers, response_trailers,
+                      stream_info);
+      });
+}
+
+void HttpGrpcAccessLog::buildLogEntry(envoy::data::accesslog::v3::HTTPAccessLogEntry& log_entry,
+                                      const Http::RequestHeaderMap& request_headers,
+                                      const Http::ResponseHeaderMap& response_headers,
+                                      const Http::ResponseTrailerMap& response_trailers,
+                                      const StreamInfo::StreamInfo& stream_info) const {
   // Common log properties.
   // TODO(mattklein123): Populate sample_rate field.
-  envoy::data::accesslog::v3::HTTPAccessLogEntry log_entry;
   GrpcCommon::Utility::extractCommonAccessLogProperties(*log_entry.mutable_common_properties(),
                                                         stream_info, config_.common_config());
 
@@ -153,8 +165,6 @@ void HttpGrpcAccessLog::emitLog(const Http::RequestHeaderMap& request_headers,
       }
     }
   }
-
-  tls_slot_->getTyped<ThreadLocalLogger>().logger_->log(std::move(log_entry));
 }
 
 } // namespace HttpGrpc
@@ -49,6 +49,12 @@ private:
                const Http::ResponseTrailerMap& response_trailers,
                const StreamInfo::StreamInfo& stream_info) override;
 
+  void buildLogEntry(envoy::data::accesslog::v3::HTTPAccessLogEntry& log_entry,
+                     const Http::RequestHeaderMap& request_headers,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const Http::ResponseTrailerMap& response_trailers,
+                     const StreamInfo::StreamInfo& stream_info) const;
+
   Stats::Scope& scope_;
   const envoy::extensions::access_loggers::grpc::v3::HttpGrpcAccessLogConfig config_;
   const ThreadLocal::SlotPtr tls_slot_;
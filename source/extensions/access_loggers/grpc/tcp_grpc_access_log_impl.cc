@@ -33,18 +33,20 @@ TcpGrpcAccessLog::TcpGrpcAccessLog(
 void TcpGrpcAccessLog::emitLog(const Http::RequestHeaderMap&, const Http::ResponseHeaderMap&,
                                const Http::ResponseTrailerMap&,
                                const StreamInfo::StreamInfo& stream_info) {
-  // Common log properties.
-  envoy::data::accesslog::v3::TCPAccessLogEntry log_entry;
-  GrpcCommon::Utility::extractCommonAccessLogProperties(*log_entry.mutable_common_properties(),
-                                                        stream_info, config_.common_config());
-
-  envoy::data::accesslog::v3::ConnectionProperties& connection_properties =
-      *log_entry.mutable_connection_properties();
-  connection_properties.set_received_bytes(stream_info.bytesReceived());
-  connection_properties.set_sent_bytes(stream_info.bytesSent());
-
-  // request_properties->set_request_body_bytes(stream_info.bytesReceived());
-  tls_slot_->getTyped<ThreadLocalLogger>().logger_->log(std::move(log_entry));
+  // The entry is built in place in the batch of the logger.
+  tls_slot_->getTyped<ThreadLocalLogger>().logger_->log(
+      [&](envoy::data::accesslog::v3::TCPAccessLogEntry& log_entry) {
+        // Common log properties.
+        GrpcCommon::Utility::extractCommonAccessLogProperties(
+            *log_entry.mutable_common_properties(), stream_info, config_.common_config());
+
+        envoy::data::accesslog::v3::ConnectionProperties& connection_properties =
+            *log_entry.mutable_connection_properties();
+        connection_properties.set_received_bytes(stream_info.bytesReceived());
+        connection_properties.set_sent_bytes(stream_info.bytesSent());
+
+        // request_properties->set_request_body_bytes(stream_info.bytesReceived());
+      });
 }
 
 } // namespace TcpGrpc
@@ -87,6 +87,11 @@ absl::string_view NullVm::getPrecompiledSectionName() {
   return {};
 }
 
+std::string NullVm::getPrecompiledModule() {
+  // Return nothing: the plugin is compiled into Envoy.
+  return {};
+}
+
 } // namespace Null
 } // namespace Wasm
 } // namespace Common
@@ -39,6 +39,7 @@ struct NullVm : public WasmVmBase {
   bool getWord(uint64_t pointer, Word* data) override;
   absl::string_view getCustomSection(absl::string_view name) override;
   absl::string_view getPrecompiledSectionName() override;
+  std::string getPrecompiledModule() override;
 
 #define _FORWARD_GET_FUNCTION(_T)                                                                  \
   void getFunction(absl::string_view function_name, _T* f) override {                              \
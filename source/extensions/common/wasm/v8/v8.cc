@@ -1,6 +1,7 @@
 #include "extensions/common/wasm/v8/v8.h"
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -45,6 +46,7 @@ public:
   bool load(const std::string& code, bool allow_precompiled) override;
   absl::string_view getCustomSection(absl::string_view name) override;
   absl::string_view getPrecompiledSectionName() override;
+  std::string getPrecompiledModule() override;
   void link(absl::string_view debug_name) override;
 
   Cloneable cloneable() override { return Cloneable::CompiledBytecode; }
@@ -182,6 +184,14 @@ static bool equalValTypes(const wasm::ownvec<wasm::ValType>& left,
   return true;
 }
 
+static void appendVarint(uint32_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(0x80 | (value & 0x7f)));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
 static uint32_t parseVarint(const byte_t*& pos, const byte_t* end) {
   uint32_t n = 0;
   uint32_t shift = 0;
@@ -391,6 +401,35 @@ absl::string_view V8::getPrecompiledSectionName() {
 #endif
 }
 
+std::string V8::getPrecompiledModule() {
+  ENVOY_LOG(trace, "getPrecompiledModule()");
+  ASSERT(module_ != nullptr);
+
+  const auto section_name = getPrecompiledSectionName();
+  if (section_name.empty()) {
+    return "";
+  }
+  const auto serialized = module_->serialize();
+  if (!serialized) {
+    return "";
+  }
+
+  // The custom sections are dropped, like when compiling, which also drops any stale precompiled
+  // section.
+  const auto stripped_source = getStrippedSource();
+  const auto& source = stripped_source ? stripped_source : source_;
+  std::string name_len;
+  appendVarint(section_name.size(), name_len);
+
+  std::string precompiled(source.get(), source.size());
+  precompiled.push_back(0 /* custom section */);
+  appendVarint(name_len.size() + section_name.size() + serialized.size(), precompiled);
+  precompiled.append(name_len);
+  precompiled.append(section_name.data(), section_name.size());
+  precompiled.append(serialized.get(), serialized.size());
+  return precompiled;
+}
+
 void V8::link(absl::string_view debug_name) {
   ENVOY_LOG(trace, "link(\"{}\")", debug_name);
   ASSERT(module_ != nullptr);
@@ -0,0 +1,369 @@
+#include "extensions/common/wasm/wasm.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/common/byte_order.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+
+Context::Context(Wasm& wasm) : wasm_(wasm), id_(wasm.nextContextId()), root_context_id_(0) {}
+
+Context::Context(Wasm& wasm, uint32_t root_context_id)
+    : wasm_(wasm), id_(wasm.nextContextId()), root_context_id_(root_context_id) {}
+
+void Context::log(uint32_t level, absl::string_view message) {
+  switch (level) {
+  case 0:
+    ENVOY_LOG(trace, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  case 1:
+    ENVOY_LOG(debug, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  case 2:
+    ENVOY_LOG(info, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  case 3:
+    ENVOY_LOG(warn, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  case 4:
+    ENVOY_LOG(error, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  default:
+    ENVOY_LOG(critical, "wasm log {}: {}", wasm_.debugName(), message);
+    break;
+  }
+}
+
+Http::HeaderMap* Context::getMap(WasmHeaderMapType) { return nullptr; }
+
+WasmResult Context::sendLocalResponse(uint32_t, absl::string_view,
+                                      std::vector<std::pair<std::string, std::string>>,
+                                      absl::optional<uint32_t>, absl::string_view) {
+  return WasmResult::Unimplemented;
+}
+
+Wasm::Wasm(WasmVmPtr vm, std::string vm_configuration, std::string plugin_configuration,
+           TimeSource& time_source)
+    : vm_(std::move(vm)), vm_configuration_(std::move(vm_configuration)),
+      plugin_configuration_(std::move(plugin_configuration)), time_source_(time_source) {}
+
+void Wasm::initialize(absl::string_view debug_name) {
+  debug_name_ = std::string(debug_name);
+
+#define _REGISTER_EXPORT(_name, _f)                                                                \
+  vm_->registerCallback("env", _name, &Exports::_f, CONVERT_FUNCTION_WORD_TO_UINT32(Exports::_f))
+  _REGISTER_EXPORT("proxy_log", log);
+  _REGISTER_EXPORT("proxy_get_buffer_bytes", getBufferBytes);
+  _REGISTER_EXPORT("proxy_get_header_map_value", getHeaderMapValue);
+  _REGISTER_EXPORT("proxy_add_header_map_value", addHeaderMapValue);
+  _REGISTER_EXPORT("proxy_replace_header_map_value", replaceHeaderMapValue);
+  _REGISTER_EXPORT("proxy_remove_header_map_value", removeHeaderMapValue);
+  _REGISTER_EXPORT("proxy_send_local_response", sendLocalResponse);
+  _REGISTER_EXPORT("proxy_get_current_time_nanoseconds", getCurrentTimeNanoseconds);
+#undef _REGISTER_EXPORT
+  vm_->link(debug_name);
+
+  vm_->getFunction("_start", &start_);
+  vm_->getFunction("malloc", &malloc_);
+  vm_->getFunction("proxy_on_vm_start", &on_vm_start_);
+  vm_->getFunction("proxy_on_configure", &on_configure_);
+  vm_->getFunction("proxy_on_context_create", &on_context_create_);
+  vm_->getFunction("proxy_on_request_headers", &on_request_headers_);
+  vm_->getFunction("proxy_on_response_headers", &on_response_headers_);
+  vm_->getFunction("proxy_on_done", &on_done_);
+  vm_->getFunction("proxy_on_delete", &on_delete_);
+
+  root_context_ = std::make_unique<Context>(*this);
+  Context* root_context = root_context_.get();
+  SaveRestoreContext saved_context(root_context);
+  try {
+    if (start_) {
+      start_(root_context);
+    }
+    if (on_context_create_) {
+      on_context_create_(root_context, root_context->id(), 0);
+    }
+    if (on_vm_start_ &&
+        on_vm_start_(root_context, root_context->id(), vm_configuration_.size()).u64_ == 0) {
+      throw WasmException(fmt::format("Wasm module {} rejected its VM configuration", debug_name));
+    }
+    if (on_configure_ &&
+        on_configure_(root_context, root_context->id(), plugin_configuration_.size()).u64_ == 0) {
+      throw WasmException(
+          fmt::format("Wasm module {} rejected its plugin configuration", debug_name));
+    }
+  } catch (const WasmException&) {
+    failed_ = true;
+    throw;
+  }
+}
+
+void Wasm::onContextCreate(Context& context) {
+  if (failed_ || !on_context_create_) {
+    return;
+  }
+  SaveRestoreContext saved_context(&context);
+  try {
+    on_context_create_(&context, context.id(), context.rootContextId());
+  } catch (const WasmException& e) {
+    fail("proxy_on_context_create", e);
+  }
+}
+
+FilterHeadersStatus Wasm::onRequestHeaders(Context& context, uint32_t headers, bool end_stream) {
+  return onHeaders(on_request_headers_, context, headers, end_stream);
+}
+
+FilterHeadersStatus Wasm::onResponseHeaders(Context& context, uint32_t headers, bool end_stream) {
+  return onHeaders(on_response_headers_, context, headers, end_stream);
+}
+
+FilterHeadersStatus Wasm::onHeaders(const WasmCallWord<3>& function, Context& context,
+                                    uint32_t headers, bool end_stream) {
+  if (failed_ || !function) {
+    return FilterHeadersStatus::Continue;
+  }
+  SaveRestoreContext saved_context(&context);
+  try {
+    return function(&context, context.id(), headers, end_stream).u64_ == 0
+               ? FilterHeadersStatus::Continue
+               : FilterHeadersStatus::StopIteration;
+  } catch (const WasmException& e) {
+    fail("header callback", e);
+    return FilterHeadersStatus::Continue;
+  }
+}
+
+void Wasm::onDone(Context& context) {
+  if (failed_) {
+    return;
+  }
+  SaveRestoreContext saved_context(&context);
+  try {
+    if (on_done_) {
+      on_done_(&context, context.id());
+    }
+    if (on_delete_) {
+      on_delete_(&context, context.id());
+    }
+  } catch (const WasmException& e) {
+    fail("proxy_on_done", e);
+  }
+}
+
+bool Wasm::copyToModule(Context& context, absl::string_view data, uint64_t address_pointer,
+                        uint64_t size_pointer) {
+  if (failed_ || !malloc_) {
+    return false;
+  }
+  uint64_t address;
+  try {
+    address = malloc_(&context, data.size()).u64_;
+  } catch (const WasmException& e) {
+    fail("malloc", e);
+    return false;
+  }
+  return address != 0 && vm_->setMemory(address, data.size(), data.data()) &&
+         vm_->setWord(address_pointer, address) && vm_->setWord(size_pointer, data.size());
+}
+
+void Wasm::fail(absl::string_view function, const WasmException& e) {
+  ENVOY_LOG(error, "Wasm module {} failed in {}: {}", debug_name_, function, e.what());
+  failed_ = true;
+}
+
+namespace Exports {
+
+namespace {
+
+Word result(WasmResult result) { return static_cast<uint32_t>(result); }
+
+Context& currentContext() {
+  ASSERT(current_context_ != nullptr);
+  return *current_context_;
+}
+
+absl::optional<absl::string_view> getMemory(Word pointer, Word size) {
+  return currentContext().wasm().vm().getMemory(pointer.u64_, size.u64_);
+}
+
+// Parses headers serialized as by proxy-wasm: the number of headers, the sizes of each name and
+// value, then the names and values, each followed by a null character. Sizes are 32 bit little
+// endian.
+absl::optional<std::vector<std::pair<std::string, std::string>>>
+parseHeaders(absl::string_view data) {
+  std::vector<std::pair<std::string, std::string>> headers;
+  if (data.empty()) {
+    return headers;
+  }
+  auto read_size = [&data](uint64_t offset) {
+    uint32_t size;
+    memcpy(&size, data.data() + offset, sizeof(size));
+    return fromEndianness<ByteOrder::LittleEndian>(size);
+  };
+  if (data.size() < sizeof(uint32_t)) {
+    return absl::nullopt;
+  }
+  const uint64_t count = read_size(0);
+  uint64_t sizes_offset = sizeof(uint32_t);
+  uint64_t offset = sizes_offset + count * 2 * sizeof(uint32_t);
+  if (offset > data.size()) {
+    return absl::nullopt;
+  }
+  for (uint64_t i = 0; i < count; ++i) {
+    const uint64_t name_size = read_size(sizes_offset);
+    const uint64_t value_size = read_size(sizes_offset + sizeof(uint32_t));
+    sizes_offset += 2 * sizeof(uint32_t);
+    if (offset + name_size + value_size + 2 > data.size()) {
+      return absl::nullopt;
+    }
+    std::string name(data.substr(offset, name_size));
+    offset += name_size + 1;
+    std::string value(data.substr(offset, value_size));
+    offset += value_size + 1;
+    headers.emplace_back(std::move(name), std::move(value));
+  }
+  return headers;
+}
+
+} // namespace
+
+Word log(void*, Word level, Word message_ptr, Word message_size) {
+  const auto message = getMemory(message_ptr, message_size);
+  if (!message) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  currentContext().log(level.u32(), message.value());
+  return result(WasmResult::Ok);
+}
+
+Word getBufferBytes(void*, Word type, Word start, Word length, Word ptr_ptr, Word size_ptr) {
+  Context& context = currentContext();
+  absl::string_view buffer;
+  switch (static_cast<WasmBufferType>(type.u32())) {
+  case WasmBufferType::VmConfiguration:
+    buffer = context.wasm().vmConfiguration();
+    break;
+  case WasmBufferType::PluginConfiguration:
+    buffer = context.wasm().pluginConfiguration();
+    break;
+  default:
+    return result(WasmResult::BadArgument);
+  }
+  if (start.u64_ > buffer.size()) {
+    return result(WasmResult::BadArgument);
+  }
+  if (!context.wasm().copyToModule(context, buffer.substr(start.u64_, length.u64_), ptr_ptr.u64_,
+                                   size_ptr.u64_)) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  return result(WasmResult::Ok);
+}
+
+Word getHeaderMapValue(void*, Word type, Word key_ptr, Word key_size, Word value_ptr_ptr,
+                       Word value_size_ptr) {
+  Context& context = currentContext();
+  Http::HeaderMap* map = context.getMap(static_cast<WasmHeaderMapType>(type.u32()));
+  if (map == nullptr) {
+    return result(WasmResult::BadArgument);
+  }
+  const auto key = getMemory(key_ptr, key_size);
+  if (!key) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  const Http::HeaderEntry* entry = map->get(Http::LowerCaseString(std::string(key.value())));
+  if (entry == nullptr) {
+    return result(WasmResult::NotFound);
+  }
+  if (!context.wasm().copyToModule(context, entry->value().getStringView(), value_ptr_ptr.u64_,
+                                   value_size_ptr.u64_)) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  return result(WasmResult::Ok);
+}
+
+Word addHeaderMapValue(void*, Word type, Word key_ptr, Word key_size, Word value_ptr,
+                       Word value_size) {
+  Http::HeaderMap* map = currentContext().getMap(static_cast<WasmHeaderMapType>(type.u32()));
+  if (map == nullptr) {
+    return result(WasmResult::BadArgument);
+  }
+  const auto key = getMemory(key_ptr, key_size);
+  const auto value = getMemory(value_ptr, value_size);
+  if (!key || !value) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  map->addCopy(Http::LowerCaseString(std::string(key.value())), value.value());
+  return result(WasmResult::Ok);
+}
+
+Word replaceHeaderMapValue(void*, Word type, Word key_ptr, Word key_size, Word value_ptr,
+                           Word value_size) {
+  Http::HeaderMap* map = currentContext().getMap(static_cast<WasmHeaderMapType>(type.u32()));
+  if (map == nullptr) {
+    return result(WasmResult::BadArgument);
+  }
+  const auto key = getMemory(key_ptr, key_size);
+  const auto value = getMemory(value_ptr, value_size);
+  if (!key || !value) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  map->setCopy(Http::LowerCaseString(std::string(key.value())), value.value());
+  return result(WasmResult::Ok);
+}
+
+Word removeHeaderMapValue(void*, Word type, Word key_ptr, Word key_size) {
+  Http::HeaderMap* map = currentContext().getMap(static_cast<WasmHeaderMapType>(type.u32()));
+  if (map == nullptr) {
+    return result(WasmResult::BadArgument);
+  }
+  const auto key = getMemory(key_ptr, key_size);
+  if (!key) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  map->remove(Http::LowerCaseString(std::string(key.value())));
+  return result(WasmResult::Ok);
+}
+
+Word sendLocalResponse(void*, Word status, Word details_ptr, Word details_size, Word body_ptr,
+                       Word body_size, Word headers_ptr, Word headers_size, Word grpc_status) {
+  const auto details = getMemory(details_ptr, details_size);
+  const auto body = getMemory(body_ptr, body_size);
+  const auto serialized_headers = getMemory(headers_ptr, headers_size);
+  if (!details || !body || !serialized_headers) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  auto headers = parseHeaders(serialized_headers.value());
+  if (!headers) {
+    return result(WasmResult::BadArgument);
+  }
+  // A negative gRPC status means none.
+  const int32_t grpc_status_code = static_cast<int32_t>(grpc_status.u32());
+  return result(currentContext().sendLocalResponse(
+      status.u32(), body.value(), std::move(headers.value()),
+      grpc_status_code < 0 ? absl::nullopt : absl::make_optional<uint32_t>(grpc_status_code),
+      details.value()));
+}
+
+Word getCurrentTimeNanoseconds(void*, Word result_ptr) {
+  Context& context = currentContext();
+  const uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           context.wasm().timeSource().systemTime().time_since_epoch())
+                           .count();
+  if (!context.wasm().vm().setMemory(result_ptr.u64_, sizeof(now), &now)) {
+    return result(WasmResult::InvalidMemoryAccess);
+  }
+  return result(WasmResult::Ok);
+}
+
+} // namespace Exports
+
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
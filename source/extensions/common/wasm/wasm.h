@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/common/wasm/wasm_vm.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+
+// The types below are from the subset of the proxy-wasm ABI (https://github.com/proxy-wasm/spec)
+// that Envoy implements.
+
+// Results of the host functions.
+enum class WasmResult : uint32_t {
+  Ok = 0,
+  NotFound = 1,
+  BadArgument = 2,
+  InvalidMemoryAccess = 6,
+  Unimplemented = 12,
+};
+
+enum class WasmHeaderMapType : uint32_t {
+  RequestHeaders = 0,
+  RequestTrailers = 1,
+  ResponseHeaders = 2,
+  ResponseTrailers = 3,
+};
+
+enum class WasmBufferType : uint32_t {
+  VmConfiguration = 6,
+  PluginConfiguration = 7,
+};
+
+// Returned by the module from the header callbacks.
+enum class FilterHeadersStatus : uint32_t { Continue = 0, StopIteration = 1 };
+
+class Wasm;
+
+/**
+ * The host side of a context of the module: either the root context, which receives the
+ * configuration, or the context of a stream. The host functions the module calls act on the
+ * current context, see SaveRestoreContext.
+ */
+class Context : public Logger::Loggable<Logger::Id::wasm> {
+public:
+  /**
+   * Creates the root context.
+   */
+  explicit Context(Wasm& wasm);
+
+  /**
+   * Creates the context of a stream.
+   */
+  Context(Wasm& wasm, uint32_t root_context_id);
+
+  virtual ~Context() = default;
+
+  Wasm& wasm() const { return wasm_; }
+  uint32_t id() const { return id_; }
+  // 0 for the root context.
+  uint32_t rootContextId() const { return root_context_id_; }
+
+  // Host functions.
+  void log(uint32_t level, absl::string_view message);
+
+  /**
+   * @return the header map of the supplied type, or nullptr if the context has none.
+   */
+  virtual Http::HeaderMap* getMap(WasmHeaderMapType type);
+
+  /**
+   * Sends a local reply instead of the upstream response.
+   */
+  virtual WasmResult sendLocalResponse(uint32_t status, absl::string_view body,
+                                       std::vector<std::pair<std::string, std::string>> headers,
+                                       absl::optional<uint32_t> grpc_status,
+                                       absl::string_view details);
+
+private:
+  Wasm& wasm_;
+  const uint32_t id_;
+  const uint32_t root_context_id_;
+};
+
+using ContextPtr = std::unique_ptr<Context>;
+
+/**
+ * An instance of a module on one thread: a linked VM, its root context, and the entry points of
+ * the module.
+ */
+class Wasm : public Logger::Loggable<Logger::Id::wasm> {
+public:
+  Wasm(WasmVmPtr vm, std::string vm_configuration, std::string plugin_configuration,
+       TimeSource& time_source);
+
+  /**
+   * Links the module to the host functions and starts it: calls its start function, then creates
+   * the root context and passes it the VM and plugin configurations. Throws WasmException or
+   * WasmVmException if the module can't be started or rejects its configuration.
+   * @param debug_name supplies the name of the module in log and error messages.
+   */
+  void initialize(absl::string_view debug_name);
+
+  WasmVm& vm() { return *vm_; }
+  TimeSource& timeSource() { return time_source_; }
+  const std::string& debugName() const { return debug_name_; }
+  absl::string_view vmConfiguration() const { return vm_configuration_; }
+  absl::string_view pluginConfiguration() const { return plugin_configuration_; }
+  uint32_t rootContextId() const { return root_context_->id(); }
+
+  /**
+   * @return whether the module failed to start, or trapped. The module is not called anymore then.
+   */
+  bool failed() const { return failed_; }
+
+  // Calls into the module. Once the module failed, they do nothing and return Continue.
+  void onContextCreate(Context& context);
+  FilterHeadersStatus onRequestHeaders(Context& context, uint32_t headers, bool end_stream);
+  FilterHeadersStatus onResponseHeaders(Context& context, uint32_t headers, bool end_stream);
+  void onDone(Context& context);
+
+  /**
+   * Copies data to memory allocated by the module, and writes its address and size at the
+   * supplied addresses of the module memory.
+   * @return whether the data could be copied.
+   */
+  bool copyToModule(Context& context, absl::string_view data, uint64_t address_pointer,
+                    uint64_t size_pointer);
+
+private:
+  friend class Context;
+
+  uint32_t nextContextId() { return next_context_id_++; }
+  FilterHeadersStatus onHeaders(const WasmCallWord<3>& function, Context& context,
+                                uint32_t headers, bool end_stream);
+  void fail(absl::string_view function, const WasmException& e);
+
+  const WasmVmPtr vm_;
+  const std::string vm_configuration_;
+  const std::string plugin_configuration_;
+  TimeSource& time_source_;
+  std::string debug_name_;
+  uint32_t next_context_id_{1};
+  bool failed_{};
+  ContextPtr root_context_;
+
+  WasmCallVoid<0> start_;
+  WasmCallWord<1> malloc_;
+  WasmCallWord<2> on_vm_start_;
+  WasmCallWord<2> on_configure_;
+  WasmCallVoid<2> on_context_create_;
+  WasmCallWord<3> on_request_headers_;
+  WasmCallWord<3> on_response_headers_;
+  WasmCallWord<1> on_done_;
+  WasmCallVoid<1> on_delete_;
+};
+
+using WasmSharedPtr = std::shared_ptr<Wasm>;
+
+// The host functions, registered with the VM under their proxy-wasm names. Null VM plugins call
+// them directly.
+namespace Exports {
+
+Word log(void* raw_context, Word level, Word message_ptr, Word message_size);
+Word getBufferBytes(void* raw_context, Word type, Word start, Word length, Word ptr_ptr,
+                    Word size_ptr);
+Word getHeaderMapValue(void* raw_context, Word type, Word key_ptr, Word key_size,
+                       Word value_ptr_ptr, Word value_size_ptr);
+Word addHeaderMapValue(void* raw_context, Word type, Word key_ptr, Word key_size, Word value_ptr,
+                       Word value_size);
+Word replaceHeaderMapValue(void* raw_context, Word type, Word key_ptr, Word key_size,
+                           Word value_ptr, Word value_size);
+Word removeHeaderMapValue(void* raw_context, Word type, Word key_ptr, Word key_size);
+Word sendLocalResponse(void* raw_context, Word status, Word details_ptr, Word details_size,
+                       Word body_ptr, Word body_size, Word headers_ptr, Word headers_size,
+                       Word grpc_status);
+Word getCurrentTimeNanoseconds(void* raw_context, Word result_ptr);
+
+} // namespace Exports
+
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
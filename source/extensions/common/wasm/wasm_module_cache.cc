@@ -0,0 +1,150 @@
+#include "extensions/common/wasm/wasm_module_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
+#include "common/crypto/utility.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+
+namespace {
+
+// Whether the file is owned by the process user and not writable by group or others, so that no
+// other user can have written it.
+bool ownedAndNotShared(const std::string& path) {
+  struct stat info;
+  return ::stat(path.c_str(), &info) == 0 && info.st_uid == geteuid() &&
+         (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+} // namespace
+
+WasmModule::WasmModule(WasmVmPtr vm, const std::string& code, bool allow_precompiled,
+                       const Stats::ScopeSharedPtr& scope)
+    : vm_(std::move(vm)), runtime_(std::string(vm_->runtime())),
+      code_(vm_->cloneable() == Cloneable::NotCloneable ? code : ""),
+      allow_precompiled_(allow_precompiled), scope_(scope) {}
+
+WasmVmPtr WasmModule::createVm() const {
+  if (vm_->cloneable() != Cloneable::NotCloneable) {
+    return vm_->clone();
+  }
+  WasmVmPtr vm = createWasmVm(runtime_, scope_);
+  if (!vm->load(code_, allow_precompiled_)) {
+    throw WasmException(fmt::format("Failed to load Wasm code with the {} runtime", runtime_));
+  }
+  return vm;
+}
+
+WasmModuleCache::WasmModuleCache(Stats::Scope& scope, Api::Api& api)
+    : api_(api), vm_scope_(scope.createScope("wasm.")),
+      stats_{ALL_WASM_MODULE_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "wasm.module_cache."))} {}
+
+WasmModuleSharedPtr WasmModuleCache::getOrLoad(absl::string_view runtime, const std::string& code,
+                                               bool allow_precompiled,
+                                               absl::string_view cache_directory) {
+  const std::string digest = Hex::encode(
+      Envoy::Common::Crypto::UtilitySingleton::get().getSha256Digest(Buffer::OwnedImpl(code)));
+  const std::string key = absl::StrCat(runtime, allow_precompiled ? ".precompiled." : ".", digest);
+  const auto it = modules_.find(key);
+  if (it != modules_.end()) {
+    WasmModuleSharedPtr module = it->second.lock();
+    if (module != nullptr) {
+      stats_.hit_.inc();
+      return module;
+    }
+  }
+  stats_.miss_.inc();
+
+  // Forget the modules that no configuration uses anymore.
+  for (auto module_it = modules_.begin(); module_it != modules_.end();) {
+    if (module_it->second.expired()) {
+      modules_.erase(module_it++);
+    } else {
+      ++module_it;
+    }
+  }
+
+  auto module = std::make_shared<const WasmModule>(
+      load(runtime, code, allow_precompiled, std::string(cache_directory), digest), code,
+      allow_precompiled, vm_scope_);
+  modules_[key] = module;
+  return module;
+}
+
+WasmVmPtr WasmModuleCache::load(absl::string_view runtime, const std::string& code,
+                                bool allow_precompiled, const std::string& cache_directory,
+                                const std::string& digest) {
+  WasmVmPtr vm = createWasmVm(runtime, vm_scope_);
+  const absl::string_view section_name = vm->getPrecompiledSectionName();
+  std::string precompiled_path;
+  if (!cache_directory.empty() && !section_name.empty()) {
+    // The section name identifies the runtime version and the platform.
+    precompiled_path = absl::StrCat(cache_directory, "/", digest, "_", section_name, ".wasm");
+    if (api_.fileSystem().fileExists(precompiled_path) &&
+        (!ownedAndNotShared(cache_directory) || !ownedAndNotShared(precompiled_path))) {
+      // Precompiled code is loaded without being verified, so it must not come from another user.
+      stats_.disk_untrusted_.inc();
+      ENVOY_LOG(warn,
+                "ignoring compiled Wasm module {}: it or its directory is not owned by this user "
+                "or is writable by others",
+                precompiled_path);
+    } else if (api_.fileSystem().fileExists(precompiled_path)) {
+      try {
+        // The file was written by Envoy, so its precompiled code is trusted.
+        if (vm->load(api_.fileSystem().fileReadToEnd(precompiled_path), true)) {
+          stats_.disk_hit_.inc();
+          return vm;
+        }
+      } catch (const EnvoyException& e) {
+        ENVOY_LOG(debug, "cannot read compiled Wasm module {}: {}", precompiled_path, e.what());
+      }
+      ENVOY_LOG(warn, "cannot load compiled Wasm module {}, compiling it again", precompiled_path);
+      vm = createWasmVm(runtime, vm_scope_);
+    }
+  }
+
+  if (!vm->load(code, allow_precompiled)) {
+    throw WasmException(fmt::format("Failed to load Wasm code with the {} runtime", runtime));
+  }
+  if (!precompiled_path.empty()) {
+    writeCacheFile(precompiled_path, vm->getPrecompiledModule());
+  }
+  return vm;
+}
+
+void WasmModuleCache::writeCacheFile(const std::string& path, const std::string& precompiled) {
+  if (precompiled.empty()) {
+    return;
+  }
+  // Write a temporary file and rename it, so that other processes never see a partial file.
+  const std::string temporary_path = absl::StrCat(path, ".", getpid(), ".tmp");
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(precompiled.data(), precompiled.size());
+    file.close();
+    // Cached files are only loaded again if no other user can write them, see load().
+    if (file && ::chmod(temporary_path.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0 &&
+        std::rename(temporary_path.c_str(), path.c_str()) == 0) {
+      return;
+    }
+  }
+  stats_.disk_write_failed_.inc();
+  ENVOY_LOG(warn, "cannot write compiled Wasm module {}", path);
+  std::remove(temporary_path.c_str());
+}
+
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
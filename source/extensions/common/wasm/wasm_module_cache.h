@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/api/api.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/common/wasm/wasm_vm.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+
+/**
+ * All Wasm module cache stats. @see stats_macros.h
+ */
+#define ALL_WASM_MODULE_CACHE_STATS(COUNTER)                                                       \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(disk_hit)                                                                                \
+  COUNTER(disk_untrusted)                                                                          \
+  COUNTER(disk_write_failed)
+
+/**
+ * Struct definition for all Wasm module cache stats. @see stats_macros.h
+ */
+struct WasmModuleCacheStats {
+  ALL_WASM_MODULE_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * A Wasm module loaded once, which VMs are created from on every worker.
+ */
+class WasmModule {
+public:
+  WasmModule(WasmVmPtr vm, const std::string& code, bool allow_precompiled,
+             const Stats::ScopeSharedPtr& scope);
+
+  absl::string_view runtime() const { return runtime_; }
+
+  /**
+   * @return a new VM for the module, which still needs to be link()ed. The VM is cloned from the
+   *         loaded one if the runtime supports it, and loaded from scratch otherwise. Thread safe.
+   */
+  WasmVmPtr createVm() const;
+
+private:
+  const WasmVmPtr vm_;
+  const std::string runtime_;
+  // Only kept for runtimes which can't clone VMs.
+  const std::string code_;
+  const bool allow_precompiled_;
+  const Stats::ScopeSharedPtr scope_;
+};
+
+using WasmModuleSharedPtr = std::shared_ptr<const WasmModule>;
+
+/**
+ * Loads each distinct Wasm module once per process. A loaded module is kept while any
+ * configuration uses it, so that configuration reloads don't compile it again. Optionally, the
+ * compiled code is also kept in a directory, keyed by the hash of the module and by the runtime
+ * version, so that restarts don't compile it again either. Compiled code is only loaded from the
+ * directory if both its file and the directory are owned by the process user and not writable by
+ * group or others. Must be used on the main thread.
+ */
+class WasmModuleCache : public Singleton::Instance, Logger::Loggable<Logger::Id::wasm> {
+public:
+  WasmModuleCache(Stats::Scope& scope, Api::Api& api);
+
+  /**
+   * Returns the loaded module. Throws WasmException if the module can't be loaded.
+   * @param runtime supplies the name of the runtime.
+   * @param code supplies the module, or the name of the plugin for the null runtime.
+   * @param allow_precompiled supplies whether code may contain precompiled code, see
+   *        WasmVm::load().
+   * @param cache_directory supplies the directory to keep compiled code in, or an empty string.
+   */
+  WasmModuleSharedPtr getOrLoad(absl::string_view runtime, const std::string& code,
+                                bool allow_precompiled, absl::string_view cache_directory);
+
+private:
+  WasmVmPtr load(absl::string_view runtime, const std::string& code, bool allow_precompiled,
+                 const std::string& cache_directory, const std::string& digest);
+  void writeCacheFile(const std::string& path, const std::string& precompiled);
+
+  Api::Api& api_;
+  const Stats::ScopeSharedPtr vm_scope_;
+  WasmModuleCacheStats stats_;
+  absl::flat_hash_map<std::string, std::weak_ptr<const WasmModule>> modules_;
+};
+
+using WasmModuleCacheSharedPtr = std::shared_ptr<WasmModuleCache>;
+
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
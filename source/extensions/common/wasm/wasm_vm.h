@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include "envoy/common/exception.h"
 #include "envoy/stats/scope.h"
@@ -241,6 +242,15 @@ public:
    */
   virtual absl::string_view getPrecompiledSectionName() PURE;
 
+  /**
+   * Get the loaded module in a form that load() accepts with allow_precompiled, such that loading
+   * it skips the compilation: the module without its custom sections, followed by a custom section
+   * named getPrecompiledSectionName() that contains the compiled code. The compiled code is only
+   * valid for the same VM version and platform, which is part of the section name.
+   * @return the precompiled module, or an empty string if the VM can't precompile modules.
+   */
+  virtual std::string getPrecompiledModule() PURE;
+
   /**
    * Get typed function exported by the WASM module.
    */
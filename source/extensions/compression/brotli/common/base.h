@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/buffer/buffer.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Common {
+
+/**
+ * Input and output positions of a brotli stream, shared between the compressor and the
+ * decompressor. brotli writes its output to a chunk of chunk_size bytes, which is moved to the
+ * output buffer when it is full or the stream is flushed.
+ */
+class Base {
+public:
+  Base(uint32_t chunk_size);
+
+protected:
+  void setInput(const Buffer::RawSlice& input_slice);
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  const uint32_t chunk_size_;
+  const std::unique_ptr<uint8_t[]> chunk_ptr_;
+  const uint8_t* next_in_{};
+  size_t avail_in_{};
+  uint8_t* next_out_;
+  size_t avail_out_;
+};
+
+} // namespace Common
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,66 @@
+#include "extensions/compression/brotli/compressor/brotli_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Compressor {
+
+BrotliCompressorImpl::BrotliCompressorImpl(uint32_t quality, uint32_t window_bits,
+                                           uint32_t input_block_bits,
+                                           bool disable_literal_context_modeling,
+                                           EncoderMode mode, uint32_t chunk_size)
+    : Common::Base(chunk_size),
+      state_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr),
+             &BrotliEncoderDestroyInstance) {
+  RELEASE_ASSERT(state_ != nullptr, "");
+  const auto set_parameter = [this](BrotliEncoderParameter parameter, uint32_t value) {
+    RELEASE_ASSERT(BrotliEncoderSetParameter(state_.get(), parameter, value), "");
+  };
+  set_parameter(BROTLI_PARAM_QUALITY, quality);
+  set_parameter(BROTLI_PARAM_LGWIN, window_bits);
+  set_parameter(BROTLI_PARAM_LGBLOCK, input_block_bits);
+  set_parameter(BROTLI_PARAM_DISABLE_LITERAL_CONTEXT_MODELING, disable_literal_context_modeling);
+  set_parameter(BROTLI_PARAM_MODE, static_cast<uint32_t>(mode));
+}
+
+void BrotliCompressorImpl::compress(Buffer::Instance& buffer,
+                                    Envoy::Compression::Compressor::State state) {
+  for (const Buffer::RawSlice& input_slice : buffer.getRawSlices()) {
+    setInput(input_slice);
+    // As for zlib, the output is added to the end of the buffer, and the input is drained from its
+    // beginning once it has been taken in by the encoder.
+    while (avail_in_ > 0) {
+      process(buffer, BROTLI_OPERATION_PROCESS);
+    }
+    buffer.drain(input_slice.len_);
+  }
+
+  const BrotliEncoderOperation operation = state == Envoy::Compression::Compressor::State::Finish
+                                               ? BROTLI_OPERATION_FINISH
+                                               : BROTLI_OPERATION_FLUSH;
+  do {
+    process(buffer, operation);
+  } while (operation == BROTLI_OPERATION_FINISH ? !BrotliEncoderIsFinished(state_.get())
+                                                : BrotliEncoderHasMoreOutput(state_.get()));
+
+  updateOutput(buffer);
+}
+
+void BrotliCompressorImpl::process(Buffer::Instance& output_buffer,
+                                   BrotliEncoderOperation operation) {
+  const BROTLI_BOOL result = BrotliEncoderCompressStream(
+      state_.get(), operation, &avail_in_, &next_in_, &avail_out_, &next_out_, nullptr);
+  RELEASE_ASSERT(result == BROTLI_TRUE, "");
+  if (avail_out_ == 0) {
+    updateOutput(output_buffer);
+  }
+}
+
+} // namespace Compressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "envoy/compression/compressor/compressor.h"
+
+#include "common/common/non_copyable.h"
+
+#include "extensions/compression/brotli/common/base.h"
+
+#include "brotli/encode.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface.
+ */
+class BrotliCompressorImpl : public Common::Base,
+                             public Envoy::Compression::Compressor::Compressor,
+                             NonCopyable {
+public:
+  /**
+   * Enum values are used for tuning the encoder for the kind of content. @see BrotliEncoderMode
+   * in brotli's encode.h.
+   */
+  enum class EncoderMode : uint32_t {
+    Generic = BROTLI_MODE_GENERIC,
+    Text = BROTLI_MODE_TEXT,
+    Font = BROTLI_MODE_FONT,
+    Default = BROTLI_MODE_GENERIC,
+  };
+
+  /**
+   * @param quality sets the compression quality, from 0 (fastest) to 11 (best compression).
+   * @param window_bits sets the base two logarithm of the size of the sliding window.
+   * @param input_block_bits sets the base two logarithm of the maximum input block size.
+   * @param disable_literal_context_modeling disables literal context modeling, which speeds up
+   *        decoding at the expense of compression ratio.
+   * @param mode @see EncoderMode enum.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  BrotliCompressorImpl(uint32_t quality, uint32_t window_bits, uint32_t input_block_bits,
+                       bool disable_literal_context_modeling, EncoderMode mode,
+                       uint32_t chunk_size);
+
+  // Compression::Compressor::Compressor
+  void compress(Buffer::Instance& buffer, Envoy::Compression::Compressor::State state) override;
+
+private:
+  void process(Buffer::Instance& output_buffer, BrotliEncoderOperation operation);
+
+  const std::unique_ptr<BrotliEncoderState, decltype(&BrotliEncoderDestroyInstance)> state_;
+};
+
+} // namespace Compressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
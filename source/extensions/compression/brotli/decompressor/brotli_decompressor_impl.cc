@@ -0,0 +1,61 @@
+#include "extensions/compression/brotli/decompressor/brotli_decompressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Decompressor {
+
+BrotliDecompressorImpl::BrotliDecompressorImpl(Stats::Scope& scope,
+                                               const std::string& stats_prefix,
+                                               bool disable_ring_buffer_reallocation,
+                                               uint32_t chunk_size)
+    : Common::Base(chunk_size), stats_(generateStats(stats_prefix, scope)),
+      state_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+             &BrotliDecoderDestroyInstance) {
+  RELEASE_ASSERT(state_ != nullptr, "");
+  RELEASE_ASSERT(BrotliDecoderSetParameter(state_.get(),
+                                           BROTLI_DECODER_PARAM_DISABLE_RING_BUFFER_REALLOCATION,
+                                           disable_ring_buffer_reallocation),
+                 "");
+}
+
+void BrotliDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                        Buffer::Instance& output_buffer) {
+  for (const Buffer::RawSlice& input_slice : input_buffer.getRawSlices()) {
+    setInput(input_slice);
+    while (process(output_buffer)) {
+    }
+  }
+
+  // Flush the output chunk, so that its content is not carried over to the next call.
+  updateOutput(output_buffer);
+}
+
+bool BrotliDecompressorImpl::process(Buffer::Instance& output_buffer) {
+  const BrotliDecoderResult result = BrotliDecoderDecompressStream(
+      state_.get(), &avail_in_, &next_in_, &avail_out_, &next_out_, nullptr);
+  if (result == BROTLI_DECODER_RESULT_ERROR) {
+    decompression_error_ = true;
+    ENVOY_LOG(trace, "brotli decompression error: {}",
+              BrotliDecoderErrorString(BrotliDecoderGetErrorCode(state_.get())));
+    stats_.brotli_error_.inc();
+    return false;
+  }
+
+  if (avail_out_ == 0) {
+    updateOutput(output_buffer);
+  }
+
+  // The decoder stops either when it needs more input, which is fed by the next slice, or when the
+  // stream is complete.
+  return result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT;
+}
+
+} // namespace Decompressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "envoy/compression/decompressor/decompressor.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+#include "common/common/non_copyable.h"
+
+#include "extensions/compression/brotli/common/base.h"
+
+#include "brotli/decode.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Decompressor {
+
+/**
+ * All brotli decompressor stats. @see stats_macros.h
+ */
+#define ALL_BROTLI_DECOMPRESSOR_STATS(COUNTER) COUNTER(brotli_error)
+
+/**
+ * Struct definition for brotli decompressor stats. @see stats_macros.h
+ */
+struct BrotliDecompressorStats {
+  ALL_BROTLI_DECOMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Implementation of decompressor's interface.
+ */
+class BrotliDecompressorImpl : public Common::Base,
+                               public Envoy::Compression::Decompressor::Decompressor,
+                               public Logger::Loggable<Logger::Id::decompression>,
+                               NonCopyable {
+public:
+  /**
+   * @param disable_ring_buffer_reallocation allocates the ring buffer for the whole window up
+   *        front, rather than growing it with the content.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  BrotliDecompressorImpl(Stats::Scope& scope, const std::string& stats_prefix,
+                         bool disable_ring_buffer_reallocation, uint32_t chunk_size);
+
+  // Compression::Decompressor::Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+
+  // Flag to track whether an error occurred during decompression.
+  bool decompression_error_{false};
+
+private:
+  static BrotliDecompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return BrotliDecompressorStats{
+        ALL_BROTLI_DECOMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  bool process(Buffer::Instance& output_buffer);
+
+  const BrotliDecompressorStats stats_;
+  const std::unique_ptr<BrotliDecoderState, decltype(&BrotliDecoderDestroyInstance)> state_;
+};
+
+} // namespace Decompressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
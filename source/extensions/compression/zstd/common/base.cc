@@ -0,0 +1,32 @@
+#include "extensions/compression/zstd/common/base.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Common {
+
+Base::Base(uint32_t chunk_size)
+    : chunk_ptr_{std::make_unique<uint8_t[]>(chunk_size)}, input_{nullptr, 0, 0},
+      output_{chunk_ptr_.get(), chunk_size, 0} {}
+
+void Base::setInput(const Buffer::RawSlice& input_slice) {
+  input_.src = input_slice.mem_;
+  input_.size = input_slice.len_;
+  input_.pos = 0;
+}
+
+void Base::updateOutput(Buffer::Instance& output_buffer) {
+  if (output_.pos == 0) {
+    return;
+  }
+
+  output_buffer.add(static_cast<void*>(chunk_ptr_.get()), output_.pos);
+  output_.pos = 0;
+}
+
+} // namespace Common
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/buffer/buffer.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Common {
+
+/**
+ * Input and output buffers of a zstd stream, shared between the compressor and the decompressor.
+ * zstd writes its output to a chunk of chunk_size bytes, which is moved to the output buffer when
+ * it is full or the stream is flushed.
+ */
+class Base {
+public:
+  Base(uint32_t chunk_size);
+
+protected:
+  void setInput(const Buffer::RawSlice& input_slice);
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  const std::unique_ptr<uint8_t[]> chunk_ptr_;
+  ZSTD_inBuffer input_;
+  ZSTD_outBuffer output_;
+};
+
+} // namespace Common
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
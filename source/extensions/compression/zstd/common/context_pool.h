@@ -0,0 +1,73 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Common {
+
+/**
+ * Per worker pool of zstd contexts. A stream takes a context from the pool of its worker and
+ * gives it back when it ends, so that the streams of a worker reuse the contexts of the streams
+ * which ended before them, with their parameters, dictionary and allocated memory, instead of
+ * creating and initializing their own. Contexts must be reset before they are given back. At most
+ * max_idle contexts are kept in the pool; the others are freed.
+ * It is not thread safe; each worker has its own instance.
+ */
+template <class Context, size_t (*FreeContext)(Context*)>
+class ContextPool : public ThreadLocal::ThreadLocalObject, NonCopyable {
+public:
+  struct ContextDeleter {
+    void operator()(Context* context) const { FreeContext(context); }
+  };
+  using ContextPtr = std::unique_ptr<Context, ContextDeleter>;
+  using CreateContextCb = std::function<ContextPtr()>;
+
+  ContextPool(CreateContextCb create_context, uint32_t max_idle)
+      : create_context_(std::move(create_context)), max_idle_(max_idle) {}
+
+  /**
+   * @return an idle context, or a new one if there is none.
+   */
+  ContextPtr acquire() {
+    if (idle_.empty()) {
+      return create_context_();
+    }
+    ContextPtr context = std::move(idle_.back());
+    idle_.pop_back();
+    return context;
+  }
+
+  /**
+   * Gives a reset context back to the pool.
+   */
+  void release(ContextPtr&& context) {
+    if (idle_.size() < max_idle_) {
+      idle_.push_back(std::move(context));
+    }
+  }
+
+  /**
+   * @return the number of idle contexts in the pool.
+   */
+  size_t idleSize() const { return idle_.size(); }
+
+private:
+  const CreateContextCb create_context_;
+  const uint32_t max_idle_;
+  std::vector<ContextPtr> idle_;
+};
+
+} // namespace Common
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,105 @@
+#include "extensions/compression/zstd/compressor/config.h"
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/config/datasource.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+namespace {
+// Default output chunk size.
+const uint32_t DefaultChunkSize = 4096;
+
+// Maximum number of idle contexts kept by each worker.
+const uint32_t MaxIdleContexts = 8;
+
+using DictionarySharedPtr = std::shared_ptr<const ZSTD_CDict>;
+
+CompressorContextPool::ContextPtr createContext(int compression_level, bool enable_checksum,
+                                                int strategy,
+                                                const DictionarySharedPtr& dictionary) {
+  CompressorContextPool::ContextPtr context(ZSTD_createCCtx());
+  RELEASE_ASSERT(context != nullptr, "");
+  const auto set_parameter = [&context](ZSTD_cParameter parameter, int value) {
+    const size_t result = ZSTD_CCtx_setParameter(context.get(), parameter, value);
+    RELEASE_ASSERT(!ZSTD_isError(result), ZSTD_getErrorName(result));
+  };
+  set_parameter(ZSTD_c_compressionLevel, compression_level);
+  set_parameter(ZSTD_c_checksumFlag, enable_checksum);
+  // The values of the strategy enum are those of ZSTD_strategy, 0 leaving the strategy of the
+  // compression level.
+  if (strategy != 0) {
+    set_parameter(ZSTD_c_strategy, strategy);
+  }
+  if (dictionary != nullptr) {
+    const size_t result = ZSTD_CCtx_refCDict(context.get(), dictionary.get());
+    RELEASE_ASSERT(!ZSTD_isError(result), ZSTD_getErrorName(result));
+  }
+  return context;
+}
+} // namespace
+
+ZstdCompressorFactory::ZstdCompressorFactory(
+    const envoy::extensions::compression::zstd::compressor::v3::Zstd& zstd, Api::Api& api,
+    ThreadLocal::SlotAllocator& tls)
+    : chunk_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, chunk_size, DefaultChunkSize)),
+      tls_slot_(tls.allocateSlot()) {
+  const int compression_level =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, compression_level, ZSTD_CLEVEL_DEFAULT);
+  const bool enable_checksum = zstd.enable_checksum();
+  const int strategy = zstd.strategy();
+
+  // The digested dictionary is read only once created, and shared by the contexts of all workers.
+  DictionarySharedPtr dictionary;
+  if (zstd.has_dictionary()) {
+    const std::string content = Config::DataSource::read(zstd.dictionary(), false, api);
+    // The ID is written in the frame headers, for the decompressor to select the dictionary.
+    if (ZSTD_getDictID_fromDict(content.data(), content.size()) == 0) {
+      throw EnvoyException("zstd compressor: the dictionary must have an ID");
+    }
+    dictionary = DictionarySharedPtr(
+        ZSTD_createCDict(content.data(), content.size(), compression_level), &ZSTD_freeCDict);
+    if (dictionary == nullptr) {
+      throw EnvoyException("zstd compressor: failed to load dictionary");
+    }
+  }
+
+  tls_slot_->set([compression_level, enable_checksum, strategy,
+                  dictionary](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CompressorContextPool>(
+        [compression_level, enable_checksum, strategy, dictionary]() {
+          return createContext(compression_level, enable_checksum, strategy, dictionary);
+        },
+        MaxIdleContexts);
+  });
+}
+
+Envoy::Compression::Compressor::CompressorPtr ZstdCompressorFactory::createCompressor() {
+  return std::make_unique<ZstdCompressorImpl>(
+      std::dynamic_pointer_cast<CompressorContextPool>(tls_slot_->get()), chunk_size_);
+}
+
+Envoy::Compression::Compressor::CompressorFactoryPtr
+ZstdCompressorLibraryFactory::createCompressorFactoryFromProtoTyped(
+    const envoy::extensions::compression::zstd::compressor::v3::Zstd& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  return std::make_unique<ZstdCompressorFactory>(proto_config, context.api(),
+                                                 context.threadLocal());
+}
+
+/**
+ * Static registration for the zstd compressor library. @see NamedCompressorLibraryConfigFactory.
+ */
+REGISTER_FACTORY(ZstdCompressorLibraryFactory,
+                 Envoy::Compression::Compressor::NamedCompressorLibraryConfigFactory);
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,55 @@
+#include "extensions/compression/zstd/compressor/zstd_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+ZstdCompressorImpl::ZstdCompressorImpl(CompressorContextPoolSharedPtr pool, uint32_t chunk_size)
+    : Common::Base(chunk_size), pool_(std::move(pool)), context_(pool_->acquire()) {
+  RELEASE_ASSERT(context_ != nullptr, "");
+}
+
+ZstdCompressorImpl::~ZstdCompressorImpl() {
+  // Drops any unfinished frame, but keeps the parameters and dictionary of the context.
+  ZSTD_CCtx_reset(context_.get(), ZSTD_reset_session_only);
+  pool_->release(std::move(context_));
+}
+
+void ZstdCompressorImpl::compress(Buffer::Instance& buffer,
+                                  Envoy::Compression::Compressor::State state) {
+  for (const Buffer::RawSlice& input_slice : buffer.getRawSlices()) {
+    setInput(input_slice);
+    // As for zlib, the output is added to the end of the buffer, and the input is drained from its
+    // beginning once it has been taken in by the compressor.
+    process(buffer, ZSTD_e_continue);
+    buffer.drain(input_slice.len_);
+  }
+
+  process(buffer, state == Envoy::Compression::Compressor::State::Finish ? ZSTD_e_end
+                                                                          : ZSTD_e_flush);
+  updateOutput(buffer);
+}
+
+void ZstdCompressorImpl::process(Buffer::Instance& output_buffer, ZSTD_EndDirective mode) {
+  bool done;
+  do {
+    const size_t remaining = ZSTD_compressStream2(context_.get(), &output_, &input_, mode);
+    RELEASE_ASSERT(!ZSTD_isError(remaining), ZSTD_getErrorName(remaining));
+    if (output_.pos == output_.size) {
+      updateOutput(output_buffer);
+    }
+    // Input is taken in until it has all been consumed. Flushing and ending the frame are
+    // complete once no data is left in the context.
+    done = mode == ZSTD_e_continue ? input_.pos == input_.size : remaining == 0;
+  } while (!done);
+}
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
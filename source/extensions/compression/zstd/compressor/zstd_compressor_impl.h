@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/compression/compressor/compressor.h"
+
+#include "common/common/non_copyable.h"
+
+#include "extensions/compression/zstd/common/base.h"
+#include "extensions/compression/zstd/common/context_pool.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+using CompressorContextPool = Common::ContextPool<ZSTD_CCtx, ZSTD_freeCCtx>;
+using CompressorContextPoolSharedPtr = std::shared_ptr<CompressorContextPool>;
+
+/**
+ * Implementation of compressor's interface. The compression context, and so the compression
+ * parameters and dictionary, come from a pool of contexts; the context is reset and given back to
+ * the pool when the compressor is destroyed.
+ */
+class ZstdCompressorImpl : public Common::Base,
+                           public Envoy::Compression::Compressor::Compressor,
+                           NonCopyable {
+public:
+  /**
+   * @param pool supplies the pool of the worker the compressor is used on.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  ZstdCompressorImpl(CompressorContextPoolSharedPtr pool, uint32_t chunk_size);
+  ~ZstdCompressorImpl() override;
+
+  // Compression::Compressor::Compressor
+  void compress(Buffer::Instance& buffer, Envoy::Compression::Compressor::State state) override;
+
+private:
+  void process(Buffer::Instance& output_buffer, ZSTD_EndDirective mode);
+
+  const CompressorContextPoolSharedPtr pool_;
+  CompressorContextPool::ContextPtr context_;
+};
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
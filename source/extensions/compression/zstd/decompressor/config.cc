@@ -0,0 +1,91 @@
+#include "extensions/compression/zstd/decompressor/config.h"
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/config/datasource.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+namespace {
+const uint32_t DefaultChunkSize = 4096;
+
+// Largest window HTTP decoders are expected to support, see RFC 8878 section 3.1.1.1.2.
+const uint32_t DefaultWindowLogMax = 23;
+
+// Maximum number of idle contexts kept by each worker.
+const uint32_t MaxIdleContexts = 8;
+} // namespace
+
+ZstdDecompressorFactory::ZstdDecompressorFactory(
+    const envoy::extensions::compression::zstd::decompressor::v3::Zstd& zstd, Stats::Scope& scope,
+    Api::Api& api, ThreadLocal::SlotAllocator& tls)
+    : scope_(scope),
+      chunk_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, chunk_size, DefaultChunkSize)),
+      tls_slot_(tls.allocateSlot()) {
+  auto dictionaries = std::make_shared<DictionaryMap>();
+  for (const auto& source : zstd.dictionaries()) {
+    const std::string content = Config::DataSource::read(source, false, api);
+    std::shared_ptr<const ZSTD_DDict> dictionary(ZSTD_createDDict(content.data(), content.size()),
+                                                 &ZSTD_freeDDict);
+    if (dictionary == nullptr) {
+      throw EnvoyException("zstd decompressor: failed to load dictionary");
+    }
+    const uint32_t dictionary_id = ZSTD_getDictID_fromDDict(dictionary.get());
+    if (dictionary_id == 0) {
+      throw EnvoyException("zstd decompressor: the dictionaries must have an ID");
+    }
+    if (!dictionaries->emplace(dictionary_id, std::move(dictionary)).second) {
+      throw EnvoyException(
+          fmt::format("zstd decompressor: duplicate dictionary ID {}", dictionary_id));
+    }
+  }
+  dictionaries_ = std::move(dictionaries);
+
+  const int window_log_max =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, window_log_max, DefaultWindowLogMax);
+  tls_slot_->set([window_log_max](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<DecompressorContextPool>(
+        [window_log_max]() {
+          DecompressorContextPool::ContextPtr context(ZSTD_createDCtx());
+          RELEASE_ASSERT(context != nullptr, "");
+          const size_t result =
+              ZSTD_DCtx_setParameter(context.get(), ZSTD_d_windowLogMax, window_log_max);
+          RELEASE_ASSERT(!ZSTD_isError(result), ZSTD_getErrorName(result));
+          return context;
+        },
+        MaxIdleContexts);
+  });
+}
+
+Envoy::Compression::Decompressor::DecompressorPtr
+ZstdDecompressorFactory::createDecompressor(const std::string& stats_prefix) {
+  return std::make_unique<ZstdDecompressorImpl>(
+      scope_, stats_prefix, std::dynamic_pointer_cast<DecompressorContextPool>(tls_slot_->get()),
+      dictionaries_, chunk_size_);
+}
+
+Envoy::Compression::Decompressor::DecompressorFactoryPtr
+ZstdDecompressorLibraryFactory::createDecompressorFactoryFromProtoTyped(
+    const envoy::extensions::compression::zstd::decompressor::v3::Zstd& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  return std::make_unique<ZstdDecompressorFactory>(proto_config, context.scope(), context.api(),
+                                                   context.threadLocal());
+}
+
+/**
+ * Static registration for the zstd decompressor. @see NamedDecompressorLibraryConfigFactory.
+ */
+REGISTER_FACTORY(ZstdDecompressorLibraryFactory,
+                 Envoy::Compression::Decompressor::NamedDecompressorLibraryConfigFactory);
+
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,181 @@
+#include "extensions/compression/zstd/decompressor/zstd_decompressor_impl.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/common/assert.h"
+
+#include "zstd_errors.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+namespace {
+
+// Size of the magic number and frame header descriptor, which give the size of the rest of the
+// frame header.
+constexpr size_t FrameHeaderPrefixSize = 5;
+
+// Returns the size of the frame header starting with the prefix. The prefix of anything other
+// than a zstd frame is returned as is: it has no dictionary ID, and fails or is skipped when
+// decompressed.
+size_t frameHeaderSize(const uint8_t* prefix) {
+  const uint32_t magic_number =
+      prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+  if (magic_number != ZSTD_MAGICNUMBER) {
+    return FrameHeaderPrefixSize;
+  }
+  static constexpr size_t DictionaryIdSizes[] = {0, 1, 2, 4};
+  static constexpr size_t ContentSizeSizes[] = {0, 2, 4, 8};
+  const uint8_t descriptor = prefix[4];
+  const bool single_segment = descriptor & 0x20;
+  const size_t content_size_size =
+      (descriptor >> 6) == 0 && single_segment ? 1 : ContentSizeSizes[descriptor >> 6];
+  return FrameHeaderPrefixSize + (single_segment ? 0 : 1) + DictionaryIdSizes[descriptor & 3] +
+         content_size_size;
+}
+
+} // namespace
+
+ZstdDecompressorImpl::ZstdDecompressorImpl(Stats::Scope& scope, const std::string& stats_prefix,
+                                           DecompressorContextPoolSharedPtr pool,
+                                           DictionaryMapConstSharedPtr dictionaries,
+                                           uint32_t chunk_size)
+    : Common::Base(chunk_size), stats_(generateStats(stats_prefix, scope)),
+      pool_(std::move(pool)), dictionaries_(std::move(dictionaries)), context_(pool_->acquire()) {
+  RELEASE_ASSERT(context_ != nullptr, "");
+}
+
+ZstdDecompressorImpl::~ZstdDecompressorImpl() {
+  // Keeps the parameters the context was created with, such as the window size limit, but drops
+  // the dictionary referenced for the last frame so that the next stream starts without one.
+  ZSTD_DCtx_reset(context_.get(), ZSTD_reset_session_only);
+  ZSTD_DCtx_refDDict(context_.get(), nullptr);
+  pool_->release(std::move(context_));
+}
+
+void ZstdDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                      Buffer::Instance& output_buffer) {
+  for (const Buffer::RawSlice& input_slice : input_buffer.getRawSlices()) {
+    setInput(input_slice);
+    while (process(output_buffer)) {
+    }
+  }
+
+  // Flush the output chunk, so that its content is not carried over to the next call.
+  updateOutput(output_buffer);
+}
+
+bool ZstdDecompressorImpl::startFrame() {
+  if (dictionaries_->empty()) {
+    in_frame_ = true;
+    return true;
+  }
+
+  const uint8_t* input = static_cast<const uint8_t*>(input_.src);
+  if (header_size_ == 0 && input_.size - input_.pos >= FrameHeaderPrefixSize) {
+    const size_t header_size = frameHeaderSize(input + input_.pos);
+    if (input_.size - input_.pos >= header_size) {
+      // Common case: the whole header is in the current slice.
+      selectDictionary(input + input_.pos, header_size);
+      in_frame_ = true;
+      return true;
+    }
+  }
+
+  // Buffer the header until it is complete. The prefix is needed to know the header size.
+  size_t header_size = FrameHeaderPrefixSize;
+  while (header_size_ < header_size) {
+    if (input_.pos == input_.size) {
+      return false;
+    }
+    const size_t size = std::min(header_size - header_size_, input_.size - input_.pos);
+    memcpy(header_ + header_size_, input + input_.pos, size);
+    header_size_ += size;
+    input_.pos += size;
+    if (header_size_ == FrameHeaderPrefixSize) {
+      header_size = frameHeaderSize(header_);
+    }
+  }
+
+  selectDictionary(header_, header_size_);
+  in_frame_ = true;
+  // The header alone never completes a frame nor produces output: the context keeps it until the
+  // first block arrives.
+  ZSTD_inBuffer header{header_, header_size_, 0};
+  header_size_ = 0;
+  const size_t result = ZSTD_decompressStream(context_.get(), &output_, &header);
+  if (ZSTD_isError(result)) {
+    onError(result);
+    return false;
+  }
+  ASSERT(header.pos == header.size && result != 0);
+  return true;
+}
+
+void ZstdDecompressorImpl::selectDictionary(const uint8_t* header, size_t header_size) {
+  const uint32_t dictionary_id = ZSTD_getDictID_fromFrame(header, header_size);
+  // A frame without a dictionary ID is decompressed without a dictionary. One whose dictionary is
+  // not configured fails to decompress.
+  const auto it = dictionaries_->find(dictionary_id);
+  const size_t result =
+      ZSTD_DCtx_refDDict(context_.get(), it != dictionaries_->end() ? it->second.get() : nullptr);
+  RELEASE_ASSERT(!ZSTD_isError(result), ZSTD_getErrorName(result));
+}
+
+bool ZstdDecompressorImpl::process(Buffer::Instance& output_buffer) {
+  if (!in_frame_ && input_.pos < input_.size && !startFrame()) {
+    return false;
+  }
+
+  const size_t result = ZSTD_decompressStream(context_.get(), &output_, &input_);
+  if (ZSTD_isError(result)) {
+    onError(result);
+    return false;
+  }
+
+  const bool output_full = output_.pos == output_.size;
+  if (output_full) {
+    updateOutput(output_buffer);
+  }
+  if (result == 0) {
+    // The frame is complete; the next one may be compressed with another dictionary.
+    in_frame_ = false;
+  }
+
+  // More output may be pending in the context when the output chunk was filled.
+  return input_.pos < input_.size || output_full;
+}
+
+void ZstdDecompressorImpl::onError(size_t result) {
+  decompression_error_ = true;
+  ENVOY_LOG(trace, "zstd decompression error: {}", ZSTD_getErrorName(result));
+  chargeErrorStats(result);
+}
+
+void ZstdDecompressorImpl::chargeErrorStats(size_t result) {
+  switch (ZSTD_getErrorCode(result)) {
+  case ZSTD_error_dictionary_corrupted:
+  case ZSTD_error_dictionary_wrong:
+    stats_.zstd_dictionary_error_.inc();
+    break;
+  case ZSTD_error_checksum_wrong:
+    stats_.zstd_checksum_wrong_error_.inc();
+    break;
+  case ZSTD_error_memory_allocation:
+    stats_.zstd_memory_error_.inc();
+    break;
+  default:
+    stats_.zstd_generic_error_.inc();
+    break;
+  }
+}
+
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
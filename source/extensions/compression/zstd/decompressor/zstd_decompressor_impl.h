@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/compression/decompressor/decompressor.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+#include "common/common/non_copyable.h"
+
+#include "extensions/compression/zstd/common/base.h"
+#include "extensions/compression/zstd/common/context_pool.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+/**
+ * All zstd decompressor stats. @see stats_macros.h
+ */
+#define ALL_ZSTD_DECOMPRESSOR_STATS(COUNTER)                                                       \
+  COUNTER(zstd_generic_error)                                                                      \
+  COUNTER(zstd_dictionary_error)                                                                   \
+  COUNTER(zstd_checksum_wrong_error)                                                               \
+  COUNTER(zstd_memory_error)
+
+/**
+ * Struct definition for zstd decompressor stats. @see stats_macros.h
+ */
+struct ZstdDecompressorStats {
+  ALL_ZSTD_DECOMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+using DecompressorContextPool = Common::ContextPool<ZSTD_DCtx, ZSTD_freeDCtx>;
+using DecompressorContextPoolSharedPtr = std::shared_ptr<DecompressorContextPool>;
+
+/**
+ * Digested dictionaries, by dictionary ID.
+ */
+using DictionaryMap = absl::flat_hash_map<uint32_t, std::shared_ptr<const ZSTD_DDict>>;
+using DictionaryMapConstSharedPtr = std::shared_ptr<const DictionaryMap>;
+
+/**
+ * Implementation of decompressor's interface. The decompression context comes from a pool of
+ * contexts; it is reset and given back to the pool when the decompressor is destroyed.
+ */
+class ZstdDecompressorImpl : public Common::Base,
+                             public Envoy::Compression::Decompressor::Decompressor,
+                             public Logger::Loggable<Logger::Id::decompression>,
+                             NonCopyable {
+public:
+  /**
+   * @param pool supplies the pool of the worker the decompressor is used on.
+   * @param dictionaries supplies the dictionaries frames may have been compressed with.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  ZstdDecompressorImpl(Stats::Scope& scope, const std::string& stats_prefix,
+                       DecompressorContextPoolSharedPtr pool,
+                       DictionaryMapConstSharedPtr dictionaries, uint32_t chunk_size);
+  ~ZstdDecompressorImpl() override;
+
+  // Compression::Decompressor::Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+
+  // Flag to track whether an error occurred during decompression.
+  bool decompression_error_{false};
+
+private:
+  // Size of the longest zstd frame header: magic number, frame header descriptor, window
+  // descriptor, 4 bytes dictionary ID and 8 bytes frame content size.
+  static constexpr size_t MaxFrameHeaderSize = 18;
+
+  static ZstdDecompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return ZstdDecompressorStats{ALL_ZSTD_DECOMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  // Selects the dictionary of the frame starting at the input. Returns false if more input is
+  // needed to complete the frame header, or on error.
+  bool startFrame();
+  void selectDictionary(const uint8_t* header, size_t header_size);
+  bool process(Buffer::Instance& output_buffer);
+  void onError(size_t result);
+  void chargeErrorStats(size_t result);
+
+  const ZstdDecompressorStats stats_;
+  const DecompressorContextPoolSharedPtr pool_;
+  const DictionaryMapConstSharedPtr dictionaries_;
+  DecompressorContextPool::ContextPtr context_;
+  // Whether a frame is being decompressed. The dictionary of each frame is selected from its
+  // header, when the frame starts.
+  bool in_frame_{false};
+  // Start of a frame header split across input slices. It is held back from the context until it
+  // is complete, since the dictionary can only be referenced before the frame starts.
+  uint8_t header_[MaxFrameHeaderSize];
+  size_t header_size_{0};
+};
+
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
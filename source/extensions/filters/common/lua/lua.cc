@@ -12,6 +12,16 @@ namespace Filters {
 namespace Common {
 namespace Lua {
 
+namespace {
+
+// lua_Writer which appends the dumped bytecode to the std::string passed as data.
+int appendBytecode(lua_State*, const void* chunk, size_t size, void* data) {
+  static_cast<std::string*>(data)->append(static_cast<const char*>(chunk), size);
+  return 0;
+}
+
+} // namespace
+
 Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state)
     : coroutine_state_(new_thread_state, false) {}
 
@@ -49,18 +59,31 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
 ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls)
     : tls_slot_(tls.allocateSlot()) {
 
-  // First verify that the supplied code can be parsed.
+  // First verify that the supplied code can be parsed and run.
   CSmartPtr<lua_State, lua_close> state(lua_open());
   RELEASE_ASSERT(state.get() != nullptr, "unable to create new Lua state object");
   luaL_openlibs(state.get());
 
-  if (0 != luaL_dostring(state.get(), code.c_str())) {
+  // The code is used as the chunk name, as luaL_dostring() does, so that error messages refer to
+  // the script the same way.
+  if (0 != luaL_loadbuffer(state.get(), code.data(), code.size(), code.c_str())) {
+    throw LuaException(fmt::format("script load error: {}", lua_tostring(state.get(), -1)));
+  }
+
+  // The parsed script is dumped as bytecode, which all workers load without parsing it again. The
+  // bytecode keeps the chunk name and line information. If it can't be dumped, workers load the
+  // source as before.
+  std::string bytecode;
+  const bool dumped = 0 == lua_dump(state.get(), appendBytecode, &bytecode) && !bytecode.empty();
+  auto chunk = std::make_shared<const std::string>(dumped ? std::move(bytecode) : code);
+
+  if (0 != lua_pcall(state.get(), 0, LUA_MULTRET, 0)) {
     throw LuaException(fmt::format("script load error: {}", lua_tostring(state.get(), -1)));
   }
 
   // Now initialize on all threads.
-  tls_slot_->set([code](Event::Dispatcher&) {
-    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(code)};
+  tls_slot_->set([chunk, code](Event::Dispatcher&) {
+    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(*chunk, code)};
   });
 }
 
@@ -92,10 +115,14 @@ CoroutinePtr ThreadLocalState::createCoroutine() {
   return std::make_unique<Coroutine>(std::make_pair(lua_newthread(state), state));
 }
 
-ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code) : state_(lua_open()) {
+ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& chunk,
+                                                 const std::string& chunk_name)
+    : state_(lua_open()) {
   RELEASE_ASSERT(state_.get() != nullptr, "unable to create new Lua state object");
   luaL_openlibs(state_.get());
-  int rc = luaL_dostring(state_.get(), code.c_str());
+  // luaL_loadbuffer() accepts both bytecode and source.
+  int rc = luaL_loadbuffer(state_.get(), chunk.data(), chunk.size(), chunk_name.c_str()) ||
+           lua_pcall(state_.get(), 0, LUA_MULTRET, 0);
   ASSERT(rc == 0);
 }
 
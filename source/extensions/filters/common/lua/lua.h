@@ -357,6 +357,7 @@ using CoroutinePtr = std::unique_ptr<Coroutine>;
  * This class wraps a Lua state that can be used safely across threads. The model is that every
  * worker gets its own independent state. There is no truly global state that a script can access.
  * This is something that might be provided in the future via an API (not via Lua itself).
+ * The script is parsed once on the main thread, and workers load the resulting bytecode.
  */
 class ThreadLocalState : Logger::Loggable<Logger::Id::lua> {
 public:
@@ -410,7 +411,11 @@ public:
 
 private:
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
-    LuaThreadLocal(const std::string& code);
+    /**
+     * @param chunk supplies the bytecode of the script, or its source.
+     * @param chunk_name supplies the name used in error messages if chunk is source.
+     */
+    LuaThreadLocal(const std::string& chunk, const std::string& chunk_name);
 
     CSmartPtr<lua_State, lua_close> state_;
     std::vector<int> global_slots_;
@@ -65,6 +65,50 @@ int BufferWrapper::luaGetBytes(lua_State* state) {
   return 1;
 }
 
+int BufferWrapper::luaSearch(lua_State* state) {
+  size_t size;
+  const char* needle = luaL_checklstring(state, 2, &size);
+  const int start = luaL_optint(state, 3, 0);
+  if (start < 0) {
+    luaL_error(state, "index must be >= 0");
+  }
+
+  const ssize_t index = data_.search(needle, size, start);
+  if (index < 0) {
+    return 0;
+  }
+  lua_pushnumber(state, index);
+  return 1;
+}
+
+int BufferWrapper::luaSlices(lua_State* state) {
+  if (iterator_.get() != nullptr) {
+    luaL_error(state, "cannot create a second iterator before completing the first");
+  }
+
+  iterator_.reset(BufferSliceIterator::create(state, *this), true);
+  lua_pushcclosure(state, BufferSliceIterator::static_luaSlicesIterator, 1);
+  return 1;
+}
+
+BufferSliceIterator::BufferSliceIterator(BufferWrapper& parent)
+    : parent_{parent}, slices_{parent.data_.getRawSlices()} {}
+
+int BufferSliceIterator::luaSlicesIterator(lua_State* state) {
+  if (current_ == slices_.size()) {
+    parent_.iterator_.reset();
+    return 0;
+  }
+
+  // The slice is not copied into a Lua string. Scripts read it through the pointer, e.g. with
+  // ffi.cast("const uint8_t*", pointer).
+  lua_pushlightuserdata(state, slices_[current_].mem_);
+  lua_pushnumber(state, slices_[current_].len_);
+
+  current_++;
+  return 2;
+}
+
 void MetadataMapHelper::setValue(lua_State* state, const ProtobufWkt::Value& value) {
   ProtobufWkt::Value::KindCase kind = value.kind_case();
 
@@ -12,6 +12,25 @@ namespace Filters {
 namespace Common {
 namespace Lua {
 
+class BufferWrapper;
+
+/**
+ * Iterator over the slices of a buffer.
+ */
+class BufferSliceIterator : public BaseLuaObject<BufferSliceIterator> {
+public:
+  BufferSliceIterator(BufferWrapper& parent);
+
+  static ExportedFunctions exportedFunctions() { return {}; }
+
+  DECLARE_LUA_CLOSURE(BufferSliceIterator, luaSlicesIterator);
+
+private:
+  BufferWrapper& parent_;
+  const Buffer::RawSliceVector slices_;
+  size_t current_{};
+};
+
 /**
  * A wrapper for a constant buffer which cannot be modified by Lua.
  */
@@ -20,7 +39,10 @@ public:
   BufferWrapper(const Buffer::Instance& data) : data_(data) {}
 
   static ExportedFunctions exportedFunctions() {
-    return {{"length", static_luaLength}, {"getBytes", static_luaGetBytes}};
+    return {{"length", static_luaLength},
+            {"getBytes", static_luaGetBytes},
+            {"search", static_luaSearch},
+            {"slices", static_luaSlices}};
   }
 
 private:
@@ -37,7 +59,31 @@ private:
    */
   DECLARE_LUA_FUNCTION(BufferWrapper, luaGetBytes);
 
+  /**
+   * Search the buffer for a string without copying it out, across slice boundaries.
+   * @param 1 (string) the string to search for.
+   * @param 2 (int) optional index to start the search at. Defaults to 0.
+   * @return int the index of the first match, or nil if there is none.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaSearch);
+
+  /**
+   * Iterate over the slices of the buffer without linearizing or copying it. Each iteration
+   * returns a light userdata pointing to the bytes of the slice, which LuaJIT's FFI can cast,
+   * and the length of the slice. The pointers are only valid until the script yields.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaSlices);
+
+  // Envoy::Lua::BaseLuaObject
+  void onMarkDead() override {
+    // Iterators do not survive yields.
+    iterator_.reset();
+  }
+
   const Buffer::Instance& data_;
+  LuaDeathRef<BufferSliceIterator> iterator_;
+
+  friend class BufferSliceIterator;
 };
 
 class MetadataMapWrapper;
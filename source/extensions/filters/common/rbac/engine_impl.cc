@@ -21,9 +21,17 @@ RoleBasedAccessControlEngineImpl::RoleBasedAccessControlEngineImpl(
     }
   }
 
+  std::map<std::string, const envoy::config::rbac::v3::Policy*> sorted_policies;
   for (const auto& policy : rules.policies()) {
-    policies_.emplace(policy.first, std::make_unique<PolicyMatcher>(policy.second, builder_.get()));
+    sorted_policies.emplace(policy.first, &policy.second);
   }
+  std::vector<const envoy::config::rbac::v3::Policy*> indexed_policies;
+  for (const auto& policy : sorted_policies) {
+    policies_.emplace_back(policy.first,
+                           std::make_unique<PolicyMatcher>(*policy.second, builder_.get()));
+    indexed_policies.push_back(policy.second);
+  }
+  index_ = std::make_unique<PolicyIndex>(indexed_policies);
 }
 
 bool RoleBasedAccessControlEngineImpl::handleAction(const Network::Connection& connection,
@@ -65,15 +73,18 @@ bool RoleBasedAccessControlEngineImpl::checkPolicyMatch(
     const Envoy::Http::RequestHeaderMap& headers, std::string* effective_policy_id) const {
   bool matched = false;
 
-  for (const auto& policy : policies_) {
+  // Only the policies which may match according to the index are evaluated, in the same order.
+  index_->candidates(connection, headers, info).forEach([&](size_t index) {
+    const auto& policy = policies_[index];
     if (policy.second->matches(connection, headers, info)) {
       matched = true;
       if (effective_policy_id != nullptr) {
         *effective_policy_id = policy.first;
       }
-      break;
+      return false;
     }
-  }
+    return true;
+  });
 
   return matched;
 }
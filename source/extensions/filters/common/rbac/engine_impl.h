@@ -4,6 +4,7 @@
 
 #include "extensions/filters/common/rbac/engine.h"
 #include "extensions/filters/common/rbac/matchers.h"
+#include "extensions/filters/common/rbac/policy_index.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -46,7 +47,9 @@ private:
   const envoy::config::rbac::v3::RBAC::Action action_;
   const EnforcementMode mode_;
 
-  std::map<std::string, std::unique_ptr<PolicyMatcher>> policies_;
+  // Sorted by name, which is the order they are evaluated in.
+  std::vector<std::pair<std::string, std::unique_ptr<PolicyMatcher>>> policies_;
+  std::unique_ptr<PolicyIndex> index_;
 
   Protobuf::Arena constant_arena_;
   Expr::BuilderPtr builder_;
@@ -0,0 +1,319 @@
+#include "extensions/filters/common/rbac/policy_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "common/http/path_utility.h"
+#include "common/network/cidr_range.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+namespace {
+
+// Finds the entry of a header in a vector of (name, value) pairs.
+template <class Map>
+typename Map::value_type::second_type& findOrAdd(Map& map, const std::string& key) {
+  auto it = std::find_if(map.begin(), map.end(),
+                         [&key](const auto& entry) { return entry.first.get() == key; });
+  if (it == map.end()) {
+    map.emplace_back(Http::LowerCaseString(key), typename Map::value_type::second_type());
+    return map.back().second;
+  }
+  return it->second;
+}
+
+void insertAll(const std::vector<uint32_t>& policies, PolicySet& set) {
+  for (const uint32_t policy : policies) {
+    set.insert(policy);
+  }
+}
+
+} // namespace
+
+void PolicyIndex::PrefixTrie::add(absl::string_view prefix, uint32_t policy) {
+  uint32_t node = 0;
+  for (const char c : prefix) {
+    auto& children = nodes_[node].children_;
+    auto it = std::lower_bound(children.begin(), children.end(), c,
+                               [](const auto& child, char c) { return child.first < c; });
+    if (it != children.end() && it->first == c) {
+      node = it->second;
+    } else {
+      const uint32_t child = nodes_.size();
+      children.emplace(it, c, child);
+      // This invalidates children.
+      nodes_.emplace_back();
+      node = child;
+    }
+  }
+  nodes_[node].policies_.push_back(policy);
+}
+
+void PolicyIndex::PrefixTrie::find(absl::string_view value, PolicySet& policies) const {
+  uint32_t node = 0;
+  insertAll(nodes_[node].policies_, policies);
+  for (const char c : value) {
+    const auto& children = nodes_[node].children_;
+    auto it = std::lower_bound(children.begin(), children.end(), c,
+                               [](const auto& child, char c) { return child.first < c; });
+    if (it == children.end() || it->first != c) {
+      return;
+    }
+    node = it->second;
+    insertAll(nodes_[node].policies_, policies);
+  }
+}
+
+PolicyIndex::PolicyIndex(const std::vector<const envoy::config::rbac::v3::Policy*>& policies)
+    : size_(policies.size()), always_(size_) {
+  std::array<std::vector<std::pair<uint32_t, std::vector<Network::Address::CidrRange>>>, 4> ranges;
+
+  for (uint32_t policy = 0; policy < policies.size(); policy++) {
+    Rules rules;
+    if (!requiredRules(*policies[policy], rules)) {
+      always_.insert(policy);
+      continue;
+    }
+    indexed_policies_++;
+
+    for (const Rule& rule : rules) {
+      switch (rule.type_) {
+      case Rule::Type::Cidr:
+        ranges[rule.ip_type_].emplace_back(
+            policy, std::vector<Network::Address::CidrRange>{
+                        Network::Address::CidrRange::create(*rule.range_)});
+        break;
+      case Rule::Type::HeaderExact:
+        findOrAdd(exact_headers_, rule.header_)[rule.value_].push_back(policy);
+        break;
+      case Rule::Type::HeaderPrefix:
+        findOrAdd(prefix_headers_, rule.header_).add(rule.value_, policy);
+        break;
+      case Rule::Type::PathPrefix:
+        paths_.add(rule.value_, policy);
+        has_paths_ = true;
+        break;
+      }
+    }
+  }
+
+  for (size_t type = 0; type < ranges.size(); type++) {
+    if (!ranges[type].empty()) {
+      ip_tries_[type] = std::make_unique<Network::LcTrie::LcTrie<uint32_t>>(ranges[type]);
+    }
+  }
+}
+
+PolicySet PolicyIndex::candidates(const Network::Connection& connection,
+                                  const Envoy::Http::RequestHeaderMap& headers,
+                                  const StreamInfo::StreamInfo& info) const {
+  PolicySet candidates = always_;
+
+  for (size_t type = 0; type < ip_tries_.size(); type++) {
+    if (ip_tries_[type] == nullptr) {
+      continue;
+    }
+    // The addresses are the ones IPMatcher matches.
+    Network::Address::InstanceConstSharedPtr address;
+    switch (type) {
+    case IPMatcher::Type::ConnectionRemote:
+      address = connection.remoteAddress();
+      break;
+    case IPMatcher::Type::DownstreamLocal:
+      address = info.downstreamLocalAddress();
+      break;
+    case IPMatcher::Type::DownstreamDirectRemote:
+      address = info.downstreamDirectRemoteAddress();
+      break;
+    case IPMatcher::Type::DownstreamRemote:
+      address = info.downstreamRemoteAddress();
+      break;
+    }
+    if (address != nullptr && address->ip() != nullptr) {
+      for (const uint32_t policy : ip_tries_[type]->getData(address)) {
+        candidates.insert(policy);
+      }
+    }
+  }
+
+  // As for HeaderMatcher, only the first value of a header is matched.
+  for (const auto& exact_header : exact_headers_) {
+    const Http::HeaderEntry* header = headers.get(exact_header.first);
+    if (header != nullptr) {
+      const auto it = exact_header.second.find(header->value().getStringView());
+      if (it != exact_header.second.end()) {
+        insertAll(it->second, candidates);
+      }
+    }
+  }
+  for (const auto& prefix_header : prefix_headers_) {
+    const Http::HeaderEntry* header = headers.get(prefix_header.first);
+    if (header != nullptr) {
+      prefix_header.second.find(header->value().getStringView(), candidates);
+    }
+  }
+
+  if (has_paths_ && headers.Path() != nullptr) {
+    paths_.find(Http::PathUtil::removeQueryAndFragment(headers.getPathValue()), candidates);
+  }
+
+  return candidates;
+}
+
+template <class Alternatives>
+bool PolicyIndex::anyOf(const Alternatives& alternatives, Rules& rules) {
+  const size_t size = rules.size();
+  for (const auto& alternative : alternatives) {
+    if (!requiredRules(alternative, rules)) {
+      rules.erase(rules.begin() + size, rules.end());
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Conjuncts> bool PolicyIndex::allOf(const Conjuncts& conjuncts, Rules& rules) {
+  absl::optional<Rules> smallest;
+  for (const auto& conjunct : conjuncts) {
+    Rules conjunct_rules;
+    if (requiredRules(conjunct, conjunct_rules) &&
+        (!smallest.has_value() || conjunct_rules.size() < smallest->size())) {
+      smallest = std::move(conjunct_rules);
+    }
+  }
+  if (!smallest.has_value()) {
+    return false;
+  }
+  std::move(smallest->begin(), smallest->end(), std::back_inserter(rules));
+  return true;
+}
+
+bool PolicyIndex::requiredRules(const envoy::config::rbac::v3::Permission& permission,
+                                Rules& rules) {
+  switch (permission.rule_case()) {
+  case envoy::config::rbac::v3::Permission::RuleCase::kAndRules:
+    return allOf(permission.and_rules().rules(), rules);
+  case envoy::config::rbac::v3::Permission::RuleCase::kOrRules:
+    return anyOf(permission.or_rules().rules(), rules);
+  case envoy::config::rbac::v3::Permission::RuleCase::kHeader:
+    return headerRule(permission.header(), rules);
+  case envoy::config::rbac::v3::Permission::RuleCase::kDestinationIp:
+    return cidrRule(permission.destination_ip(), IPMatcher::Type::DownstreamLocal, rules);
+  case envoy::config::rbac::v3::Permission::RuleCase::kUrlPath:
+    return pathRule(permission.url_path(), rules);
+  default:
+    return false;
+  }
+}
+
+bool PolicyIndex::requiredRules(const envoy::config::rbac::v3::Principal& principal,
+                                Rules& rules) {
+  switch (principal.identifier_case()) {
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kAndIds:
+    return allOf(principal.and_ids().ids(), rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kOrIds:
+    return anyOf(principal.or_ids().ids(), rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kSourceIp:
+    return cidrRule(principal.source_ip(), IPMatcher::Type::ConnectionRemote, rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kDirectRemoteIp:
+    return cidrRule(principal.direct_remote_ip(), IPMatcher::Type::DownstreamDirectRemote, rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kRemoteIp:
+    return cidrRule(principal.remote_ip(), IPMatcher::Type::DownstreamRemote, rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kHeader:
+    return headerRule(principal.header(), rules);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kUrlPath:
+    return pathRule(principal.url_path(), rules);
+  default:
+    return false;
+  }
+}
+
+bool PolicyIndex::requiredRules(const envoy::config::rbac::v3::Policy& policy, Rules& rules) {
+  // Both the permissions and the principals must match, so either set of rules will do.
+  Rules permission_rules;
+  Rules principal_rules;
+  const bool permissions = anyOf(policy.permissions(), permission_rules);
+  const bool principals = anyOf(policy.principals(), principal_rules);
+  if (permissions && (!principals || permission_rules.size() <= principal_rules.size())) {
+    std::move(permission_rules.begin(), permission_rules.end(), std::back_inserter(rules));
+    return true;
+  }
+  if (principals) {
+    std::move(principal_rules.begin(), principal_rules.end(), std::back_inserter(rules));
+    return true;
+  }
+  return false;
+}
+
+bool PolicyIndex::headerRule(const envoy::config::route::v3::HeaderMatcher& header,
+                             Rules& rules) {
+  if (header.invert_match()) {
+    return false;
+  }
+  switch (header.header_match_specifier_case()) {
+  case envoy::config::route::v3::HeaderMatcher::HeaderMatchSpecifierCase::kExactMatch: {
+    // An empty exact match matches any value, as does an empty prefix.
+    Rule rule{header.exact_match().empty() ? Rule::Type::HeaderPrefix : Rule::Type::HeaderExact};
+    rule.header_ = Http::LowerCaseString(header.name()).get();
+    rule.value_ = header.exact_match();
+    rules.push_back(std::move(rule));
+    return true;
+  }
+  case envoy::config::route::v3::HeaderMatcher::HeaderMatchSpecifierCase::kPrefixMatch: {
+    Rule rule{Rule::Type::HeaderPrefix};
+    rule.header_ = Http::LowerCaseString(header.name()).get();
+    rule.value_ = header.prefix_match();
+    rules.push_back(std::move(rule));
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+bool PolicyIndex::cidrRule(const envoy::config::core::v3::CidrRange& range, IPMatcher::Type type,
+                           Rules& rules) {
+  // An invalid range never matches, and LcTrie doesn't take it.
+  if (!Network::Address::CidrRange::create(range).isValid()) {
+    return false;
+  }
+  Rule rule{Rule::Type::Cidr};
+  rule.range_ = &range;
+  rule.ip_type_ = type;
+  rules.push_back(std::move(rule));
+  return true;
+}
+
+bool PolicyIndex::pathRule(const envoy::type::matcher::v3::PathMatcher& path, Rules& rules) {
+  const auto& matcher = path.path();
+  if (matcher.ignore_case()) {
+    return false;
+  }
+  // An exact path is also a prefix of the paths it matches.
+  switch (matcher.match_pattern_case()) {
+  case envoy::type::matcher::v3::StringMatcher::MatchPatternCase::kExact:
+  case envoy::type::matcher::v3::StringMatcher::MatchPatternCase::kPrefix: {
+    Rule rule{Rule::Type::PathPrefix};
+    rule.value_ = matcher.match_pattern_case() ==
+                          envoy::type::matcher::v3::StringMatcher::MatchPatternCase::kExact
+                      ? matcher.exact()
+                      : matcher.prefix();
+    rules.push_back(std::move(rule));
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
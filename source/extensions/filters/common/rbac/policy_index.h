@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/network/connection.h"
+#include "envoy/stream_info/stream_info.h"
+
+#include "common/network/lc_trie.h"
+
+#include "extensions/filters/common/rbac/matchers.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+/**
+ * A set of policies, as a bit per policy in the order they were passed to the index.
+ */
+class PolicySet {
+public:
+  explicit PolicySet(size_t size) : words_((size + 63) / 64) {}
+
+  void insert(size_t policy) { words_[policy / 64] |= uint64_t(1) << (policy % 64); }
+  bool contains(size_t policy) const { return (words_[policy / 64] >> (policy % 64)) & 1; }
+
+  /**
+   * Calls cb with each policy of the set in order, until it returns false.
+   */
+  template <class Callback> void forEach(const Callback& cb) const {
+    for (size_t word = 0; word < words_.size(); word++) {
+      size_t policy = word * 64;
+      for (uint64_t bits = words_[word]; bits != 0; bits >>= 1, policy++) {
+        if ((bits & 1) && !cb(policy)) {
+          return;
+        }
+      }
+    }
+  }
+
+private:
+  // Inline for up to 512 policies, so that lookups don't allocate.
+  absl::InlinedVector<uint64_t, 8> words_;
+};
+
+/**
+ * An index over a list of policies, compiled from the rules which can be looked up without
+ * evaluating them one by one: CIDR ranges, exact header values, and header and URL path prefixes.
+ * For each policy, the index keeps a set of such rules of which at least one must match for the
+ * policy to match, taken from either its permissions or its principals.
+ *
+ * Looking up a request returns the policies which may match it, which are then evaluated with
+ * their matchers as before. Policies for which no such set of rules exists, e.g. because some
+ * alternative permission and some alternative principal are metadata matchers, are always
+ * returned. The index is immutable once built, and shared by all workers.
+ */
+class PolicyIndex {
+public:
+  /**
+   * @param policies supplies the policies to index, in the order they are evaluated.
+   */
+  explicit PolicyIndex(const std::vector<const envoy::config::rbac::v3::Policy*>& policies);
+
+  /**
+   * @return the policies which may match the request or connection.
+   */
+  PolicySet candidates(const Network::Connection& connection,
+                       const Envoy::Http::RequestHeaderMap& headers,
+                       const StreamInfo::StreamInfo& info) const;
+
+  /**
+   * @return the number of policies found through the index rather than always evaluated.
+   */
+  size_t indexedPolicies() const { return indexed_policies_; }
+
+private:
+  /**
+   * A rule which is looked up in the index.
+   */
+  struct Rule {
+    enum class Type { Cidr, HeaderExact, HeaderPrefix, PathPrefix };
+
+    Type type_;
+    const envoy::config::core::v3::CidrRange* range_{};
+    IPMatcher::Type ip_type_{};
+    std::string header_;
+    std::string value_;
+  };
+  using Rules = std::vector<Rule>;
+
+  /**
+   * A byte-wise trie of prefixes, which finds the policies of all prefixes of a value.
+   */
+  class PrefixTrie {
+  public:
+    PrefixTrie() : nodes_(1) {}
+
+    void add(absl::string_view prefix, uint32_t policy);
+    void find(absl::string_view value, PolicySet& policies) const;
+
+  private:
+    struct Node {
+      // Sorted by byte.
+      std::vector<std::pair<char, uint32_t>> children_;
+      std::vector<uint32_t> policies_;
+    };
+
+    std::vector<Node> nodes_;
+  };
+
+  // Each returns whether a set of rules, one of which must match for the permission, principal or
+  // policy to match, was found. If so, it is appended to rules.
+  static bool requiredRules(const envoy::config::rbac::v3::Permission& permission, Rules& rules);
+  static bool requiredRules(const envoy::config::rbac::v3::Principal& principal, Rules& rules);
+  static bool requiredRules(const envoy::config::rbac::v3::Policy& policy, Rules& rules);
+  static bool headerRule(const envoy::config::route::v3::HeaderMatcher& header, Rules& rules);
+  static bool cidrRule(const envoy::config::core::v3::CidrRange& range, IPMatcher::Type type,
+                       Rules& rules);
+  static bool pathRule(const envoy::type::matcher::v3::PathMatcher& path, Rules& rules);
+
+  // For alternatives, of which any may match: the rules of all of them are required.
+  template <class Alternatives> static bool anyOf(const Alternatives& alternatives, Rules& rules);
+  // For conjuncts, which all must match: the rules of any of them are required. Picks the
+  // smallest set of rules.
+  template <class Conjuncts> static bool allOf(const Conjuncts& conjuncts, Rules& rules);
+
+  const size_t size_;
+  PolicySet always_;
+  size_t indexed_policies_{};
+  // By IPMatcher::Type.
+  std::array<std::unique_ptr<Network::LcTrie::LcTrie<uint32_t>>, 4> ip_tries_;
+  std::vector<std::pair<Http::LowerCaseString,
+                        absl::flat_hash_map<std::string, std::vector<uint32_t>>>>
+      exact_headers_;
+  std::vector<std::pair<Http::LowerCaseString, PrefixTrie>> prefix_headers_;
+  PrefixTrie paths_;
+  bool has_paths_{};
+};
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,103 @@
+#include "extensions/filters/http/common/compressor/compression_thread_pool.h"
+
+#include <algorithm>
+
+#include "common/common/lock_guard.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+CompressionThreadPool::ThreadLocalDispatcher::ThreadLocalDispatcher(Event::Dispatcher& dispatcher)
+    : handle_(std::make_shared<DispatcherHandle>()) {
+  Thread::LockGuard lock(handle_->lock_);
+  handle_->dispatcher_ = &dispatcher;
+}
+
+CompressionThreadPool::ThreadLocalDispatcher::~ThreadLocalDispatcher() {
+  // The results of the jobs still running for this thread are dropped from now on.
+  Thread::LockGuard lock(handle_->lock_);
+  handle_->dispatcher_ = nullptr;
+}
+
+CompressionThreadPool::CompressionThreadPool(Thread::ThreadFactory& thread_factory,
+                                             ThreadLocal::SlotAllocator& tls, Stats::Scope& scope)
+    : thread_factory_(thread_factory), tls_slot_(tls.allocateSlot()),
+      stats_(generateStats(scope)) {
+  tls_slot_->set([](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalDispatcher>(dispatcher);
+  });
+}
+
+CompressionThreadPool::~CompressionThreadPool() {
+  std::deque<QueuedJob> dropped_jobs;
+  {
+    Thread::LockGuard lock(lock_);
+    exit_ = true;
+    dropped_jobs.swap(queue_);
+    stats_.queue_size_.sub(dropped_jobs.size());
+    job_queued_.notifyAll();
+  }
+  for (auto& thread : threads_) {
+    thread->join();
+  }
+  stats_.threads_.set(0);
+}
+
+void CompressionThreadPool::reserveThreads(uint32_t threads) {
+  threads = std::min(threads, MaxThreads);
+  while (threads_.size() < threads) {
+    threads_.push_back(thread_factory_.createThread([this]() -> void { threadRoutine(); },
+                                                    Thread::Options{"compressor"}));
+  }
+  stats_.threads_.set(threads_.size());
+}
+
+bool CompressionThreadPool::post(Job job, uint32_t max_queued_jobs) {
+  DispatcherHandleSharedPtr dispatcher = tls_slot_->getTyped<ThreadLocalDispatcher>().handle_;
+  Thread::LockGuard lock(lock_);
+  if (queue_.size() >= max_queued_jobs) {
+    return false;
+  }
+  queue_.push_back({std::move(job), std::move(dispatcher)});
+  // The gauge is updated under the lock, so that it is never decremented before being
+  // incremented.
+  stats_.queue_size_.inc();
+  job_queued_.notifyOne();
+  return true;
+}
+
+void CompressionThreadPool::threadRoutine() {
+  while (true) {
+    QueuedJob queued_job;
+    {
+      Thread::LockGuard lock(lock_);
+      while (queue_.empty() && !exit_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        job_queued_.wait(lock_);
+      }
+      if (exit_) {
+        return;
+      }
+      queued_job = std::move(queue_.front());
+      queue_.pop_front();
+      stats_.queue_size_.dec();
+    }
+    Event::PostCb callback = queued_job.job_();
+    // The job gives up its captures before the callback is posted, so that what the callback
+    // holds is released on the thread that queued the job.
+    queued_job.job_ = nullptr;
+    Thread::LockGuard lock(queued_job.dispatcher_->lock_);
+    if (queued_job.dispatcher_->dispatcher_ != nullptr) {
+      queued_job.dispatcher_->dispatcher_->post(std::move(callback));
+    }
+  }
+}
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread/thread.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/non_copyable.h"
+#include "common/common/thread.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+/**
+ * All compression thread pool stats. @see stats_macros.h
+ * "threads" is the number of helper threads, and "queue_size" the number of jobs waiting for one
+ * of them.
+ */
+#define ALL_COMPRESSION_THREAD_POOL_STATS(GAUGE)                                                   \
+  GAUGE(threads, NeverImport)                                                                      \
+  GAUGE(queue_size, NeverImport)
+
+/**
+ * Struct definition for compression thread pool stats. @see stats_macros.h
+ */
+struct CompressionThreadPoolStats {
+  ALL_COMPRESSION_THREAD_POOL_STATS(GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Pool of helper threads the compressor filters compress large response bodies on, so that the
+ * worker threads keep serving their other streams meanwhile. A single pool, owned through the
+ * singleton manager, is shared by all the filter configs. Jobs are run in the order they are
+ * queued, and their results are posted back to the thread that queued them. The queue is bounded:
+ * once it is full, jobs are rejected and the caller is expected to do the work itself. Jobs still
+ * queued when the pool is destroyed are dropped.
+ */
+class CompressionThreadPool : public Singleton::Instance, NonCopyable {
+public:
+  /**
+   * A job returns the callback to run on the thread that queued it, once the job is done.
+   */
+  using Job = std::function<Event::PostCb()>;
+
+  // Upper bound on the number of helper threads, whatever the configs ask for.
+  static constexpr uint32_t MaxThreads = 64;
+
+  CompressionThreadPool(Thread::ThreadFactory& thread_factory, ThreadLocal::SlotAllocator& tls,
+                        Stats::Scope& scope);
+  ~CompressionThreadPool() override;
+
+  /**
+   * Starts helper threads until there are at least the given number, up to MaxThreads. Called on
+   * the main thread.
+   */
+  void reserveThreads(uint32_t threads);
+
+  /**
+   * Queues a job. Called on a thread with a dispatcher, i.e. a worker or the main thread.
+   * @param job supplies the job, which is run on one of the helper threads.
+   * @param max_queued_jobs supplies the number of queued jobs over which the job is rejected.
+   * @return false if the queue is full, in which case the job is dropped.
+   */
+  bool post(Job job, uint32_t max_queued_jobs);
+
+private:
+  // The dispatcher of a thread jobs were queued from, or nullptr once the thread is shut down.
+  struct DispatcherHandle {
+    Thread::MutexBasicLockable lock_;
+    Event::Dispatcher* dispatcher_ ABSL_GUARDED_BY(lock_){};
+  };
+  using DispatcherHandleSharedPtr = std::shared_ptr<DispatcherHandle>;
+
+  struct ThreadLocalDispatcher : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalDispatcher(Event::Dispatcher& dispatcher);
+    ~ThreadLocalDispatcher() override;
+
+    const DispatcherHandleSharedPtr handle_;
+  };
+
+  struct QueuedJob {
+    Job job_;
+    DispatcherHandleSharedPtr dispatcher_;
+  };
+
+  static CompressionThreadPoolStats generateStats(Stats::Scope& scope) {
+    return CompressionThreadPoolStats{
+        ALL_COMPRESSION_THREAD_POOL_STATS(POOL_GAUGE_PREFIX(scope, "compressor_thread_pool."))};
+  }
+
+  void threadRoutine();
+
+  Thread::ThreadFactory& thread_factory_;
+  ThreadLocal::SlotPtr tls_slot_;
+  CompressionThreadPoolStats stats_;
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar job_queued_;
+  std::deque<QueuedJob> queue_ ABSL_GUARDED_BY(lock_);
+  bool exit_ ABSL_GUARDED_BY(lock_){};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+using CompressionThreadPoolSharedPtr = std::shared_ptr<CompressionThreadPool>;
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
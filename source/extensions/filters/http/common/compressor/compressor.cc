@@ -1,7 +1,14 @@
 #include "extensions/filters/http/common/compressor/compressor.h"
 
+#include <chrono>
+
+#include "envoy/event/dispatcher.h"
+
 #include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
+#include "common/crypto/utility.h"
 #include "common/http/header_map_impl.h"
+#include "common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -25,6 +32,19 @@ Http::RegisterCustomInlineHeader<Http::CustomInlineHeaderRegistry::Type::Respons
 // Default minimum length of an upstream response that allows compression.
 const uint64_t DefaultMinimumContentLength = 30;
 
+// Default number of bytes of a response body after which the rest of it is compressed on the
+// helper threads.
+const uint32_t DefaultOffloadMinBodySize = 1024 * 1024;
+
+// Default maximum number of compression jobs waiting for a helper thread.
+const uint32_t DefaultOffloadMaxQueuedJobs = 64;
+
+// Default maximum total size of the compressed bodies in the response cache.
+const uint64_t DefaultResponseCacheMaxBytes = 64 * 1024 * 1024;
+
+// Default maximum size of the response bodies which are cached.
+const uint32_t DefaultResponseCacheMaxBodySize = 1024 * 1024;
+
 // Default content types will be used if any is provided by the user.
 const std::vector<std::string>& defaultContentEncoding() {
   CONSTRUCT_ON_FIRST_USE(
@@ -35,6 +55,10 @@ const std::vector<std::string>& defaultContentEncoding() {
        "application/json", "image/svg+xml", "text/xml", "application/xhtml+xml"});
 }
 
+bool isStrongEtag(absl::string_view value) {
+  return value.length() > 2 && !((value[0] == 'w' || value[0] == 'W') && value[1] == '/');
+}
+
 // List of CompressorFilterConfig objects registered for a stream.
 struct CompressorRegistry : public StreamInfo::FilterState::Object {
   std::list<CompressorFilterConfigSharedPtr> filter_configs_;
@@ -48,13 +72,21 @@ const std::string& compressorRegistryKey() { CONSTRUCT_ON_FIRST_USE(std::string,
 CompressorFilterConfig::CompressorFilterConfig(
     const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
     const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-    const std::string& content_encoding)
+    const std::string& content_encoding, CompressionThreadPoolSharedPtr offload_pool)
     : content_length_(contentLengthUint(compressor.content_length().value())),
       content_type_values_(contentTypeSet(compressor.content_type())),
       disable_on_etag_header_(compressor.disable_on_etag_header()),
       remove_accept_encoding_header_(compressor.remove_accept_encoding_header()),
       stats_(generateStats(stats_prefix, scope)), enabled_(compressor.runtime_enabled(), runtime),
-      content_encoding_(content_encoding) {}
+      content_encoding_(content_encoding), offload_pool_(std::move(offload_pool)),
+      offload_stats_(generateOffloadStats(offload_pool_, stats_prefix, scope)),
+      offload_min_body_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(compressor.offload(), min_body_size,
+                                                             DefaultOffloadMinBodySize)),
+      offload_max_queued_jobs_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          compressor.offload(), max_queued_jobs, DefaultOffloadMaxQueuedJobs)),
+      response_cache_(createResponseCache(compressor, stats_prefix, scope)),
+      response_cache_max_body_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          compressor.response_cache(), max_body_size, DefaultResponseCacheMaxBodySize)) {}
 
 StringUtil::CaseUnorderedSet
 CompressorFilterConfig::contentTypeSet(const Protobuf::RepeatedPtrField<std::string>& types) {
@@ -68,9 +100,40 @@ uint32_t CompressorFilterConfig::contentLengthUint(Protobuf::uint32 length) {
   return length > 0 ? length : DefaultMinimumContentLength;
 }
 
+std::unique_ptr<CompressorOffloadStats>
+CompressorFilterConfig::generateOffloadStats(const CompressionThreadPoolSharedPtr& offload_pool,
+                                             const std::string& prefix, Stats::Scope& scope) {
+  if (offload_pool == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<CompressorOffloadStats>(CompressorOffloadStats{
+      ALL_COMPRESSOR_OFFLOAD_STATS(POOL_COUNTER_PREFIX(scope, prefix),
+                                   POOL_HISTOGRAM_PREFIX(scope, prefix))});
+}
+
+ResponseCachePtr CompressorFilterConfig::createResponseCache(
+    const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
+    const std::string& stats_prefix, Stats::Scope& scope) {
+  if (!compressor.has_response_cache()) {
+    return nullptr;
+  }
+  return std::make_unique<ResponseCache>(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(compressor.response_cache(), max_bytes,
+                                      DefaultResponseCacheMaxBytes),
+      stats_prefix, scope);
+}
+
 CompressorFilter::CompressorFilter(const CompressorFilterConfigSharedPtr config)
     : skip_compression_{true}, config_(std::move(config)) {}
 
+void CompressorFilter::onDestroy() {
+  if (offload_ != nullptr) {
+    // A chunk may still be compressed by a helper thread, whose result is then dropped.
+    offload_->filter_ = nullptr;
+    decoder_callbacks_->removeDownstreamWatermarkCallbacks(*this);
+  }
+}
+
 Http::FilterHeadersStatus CompressorFilter::decodeHeaders(Http::RequestHeaderMap& headers, bool) {
   const Http::HeaderEntry* accept_encoding = headers.getInline(accept_encoding_handle.handle());
   if (accept_encoding != nullptr) {
@@ -83,6 +146,11 @@ Http::FilterHeadersStatus CompressorFilter::decodeHeaders(Http::RequestHeaderMap
     headers.removeInline(accept_encoding_handle.handle());
   }
 
+  if (config_->responseCache() != nullptr) {
+    // Neither may contain a newline, so the key is unambiguous.
+    request_key_ = absl::StrCat(headers.getHostValue(), "\n", headers.getPathValue());
+  }
+
   return Http::FilterHeadersStatus::Continue;
 }
 
@@ -119,6 +187,7 @@ Http::FilterHeadersStatus CompressorFilter::encodeHeaders(Http::ResponseHeaderMa
   if (!end_stream && isEnabledAndContentLengthBigEnough && isAcceptEncodingAllowed(headers) &&
       isCompressible && isTransferEncodingAllowed(headers)) {
     skip_compression_ = false;
+    startResponseCache(headers);
     sanitizeEtagHeader(headers);
     headers.removeContentLength();
     headers.setInline(content_encoding_handle.handle(), config_->contentEncoding());
@@ -140,23 +209,300 @@ Http::FilterHeadersStatus CompressorFilter::encodeHeaders(Http::ResponseHeaderMa
 }
 
 Http::FilterDataStatus CompressorFilter::encodeData(Buffer::Instance& data, bool end_stream) {
-  if (!skip_compression_) {
-    config_->stats().total_uncompressed_bytes_.add(data.length());
+  if (skip_compression_) {
+    return Http::FilterDataStatus::Continue;
+  }
+
+  config_->stats().total_uncompressed_bytes_.add(data.length());
+  if (cache_state_ != CacheState::None) {
+    const absl::optional<Http::FilterDataStatus> status = encodeCachedData(data, end_stream);
+    if (status.has_value()) {
+      return status.value();
+    }
+  }
+  if (offload_ == nullptr && !shouldOffload(data.length())) {
     compressor_->compress(data, end_stream ? Envoy::Compression::Compressor::State::Finish
                                            : Envoy::Compression::Compressor::State::Flush);
     config_->stats().total_compressed_bytes_.add(data.length());
+    return Http::FilterDataStatus::Continue;
+  }
+
+  if (offload_ == nullptr) {
+    startOffload();
   }
-  return Http::FilterDataStatus::Continue;
+  pending_.move(data);
+  pending_end_stream_ = end_stream;
+  if (!offload_->in_flight_ && downstream_watermarks_ == 0 && !postOffloadJob()) {
+    // Nothing is in flight, so the data can be compressed on the worker thread and passed on as
+    // is.
+    compressPending(data);
+    return Http::FilterDataStatus::Continue;
+  }
+  updateWatermarks();
+  return Http::FilterDataStatus::StopIterationNoBuffer;
 }
 
 Http::FilterTrailersStatus CompressorFilter::encodeTrailers(Http::ResponseTrailerMap&) {
-  if (!skip_compression_) {
+  if (skip_compression_) {
+    return Http::FilterTrailersStatus::Continue;
+  }
+
+  if (cache_state_ != CacheState::None) {
+    Buffer::OwnedImpl data;
+    const absl::optional<Http::FilterDataStatus> status = encodeCachedData(data, true);
+    ASSERT(status.has_value());
+    encoder_callbacks_->addEncodedData(data, true);
+    return Http::FilterTrailersStatus::Continue;
+  }
+
+  if (offload_ == nullptr) {
     Buffer::OwnedImpl empty_buffer;
     compressor_->compress(empty_buffer, Envoy::Compression::Compressor::State::Finish);
     config_->stats().total_compressed_bytes_.add(empty_buffer.length());
     encoder_callbacks_->addEncodedData(empty_buffer, true);
+    return Http::FilterTrailersStatus::Continue;
+  }
+
+  // The trailers follow the end of the compressed body, once it is back from the helper thread.
+  pending_end_stream_ = true;
+  pending_trailers_ = true;
+  if (!offload_->in_flight_ && downstream_watermarks_ == 0 && !postOffloadJob()) {
+    Buffer::OwnedImpl data;
+    compressPending(data);
+    encoder_callbacks_->addEncodedData(data, true);
+    return Http::FilterTrailersStatus::Continue;
+  }
+  return Http::FilterTrailersStatus::StopIteration;
+}
+
+void CompressorFilter::onAboveWriteBufferHighWatermark() { ++downstream_watermarks_; }
+
+void CompressorFilter::onBelowWriteBufferLowWatermark() {
+  ASSERT(downstream_watermarks_ > 0);
+  if (--downstream_watermarks_ == 0) {
+    // Resuming may inject data into the filter chain, which is not done under the stack of a
+    // watermark callback.
+    encoder_callbacks_->dispatcher().post([offload = offload_]() {
+      if (offload->filter_ != nullptr) {
+        offload->filter_->resumeOffload();
+      }
+    });
   }
-  return Http::FilterTrailersStatus::Continue;
+}
+
+bool CompressorFilter::shouldOffload(uint64_t length) {
+  body_size_ += length;
+  return config_->offloadPool() != nullptr && body_size_ >= config_->offloadMinBodySize();
+}
+
+void CompressorFilter::startOffload() {
+  offload_ = std::make_shared<OffloadState>();
+  offload_->filter_ = this;
+  offload_->compressor_ = std::move(compressor_);
+  // No more chunks are compressed while the downstream is backed up, so that the pending data
+  // pushes back on the upstream instead of piling up in the codec.
+  decoder_callbacks_->addDownstreamWatermarkCallbacks(*this);
+}
+
+// Queues the pending data for a helper thread. Returns false if the queue is full, in which case
+// the data is left pending.
+bool CompressorFilter::postOffloadJob() {
+  ASSERT(!offload_->in_flight_ && !end_stream_posted_);
+  // The data is copied, so that the helper thread does not release slices of the upstream
+  // connection, e.g. fragments whose releasor is not thread safe.
+  offload_->data_.add(pending_);
+  pending_.drain(pending_.length());
+  offload_->state_ = pending_end_stream_ ? Envoy::Compression::Compressor::State::Finish
+                                         : Envoy::Compression::Compressor::State::Flush;
+  offload_->queued_time_ = encoder_callbacks_->dispatcher().timeSource().monotonicTime();
+
+  const bool posted = config_->offloadPool()->post(
+      [offload = offload_]() mutable -> Event::PostCb {
+        offload->compressor_->compress(offload->data_, offload->state_);
+        // The helper thread gives up its reference, so that the state, and so the compressor, is
+        // destroyed on the worker thread unless the worker is shut down meanwhile.
+        return [offload = std::move(offload)]() {
+          if (offload->filter_ != nullptr) {
+            offload->filter_->onOffloadJobComplete();
+          }
+        };
+      },
+      config_->offloadMaxQueuedJobs());
+  if (!posted) {
+    config_->offloadStats().offload_queue_full_.inc();
+    pending_.move(offload_->data_);
+    return false;
+  }
+  config_->offloadStats().offload_jobs_.inc();
+  offload_->in_flight_ = true;
+  end_stream_posted_ = pending_end_stream_;
+  return true;
+}
+
+// Compresses the pending data on the worker thread.
+void CompressorFilter::compressPending(Buffer::Instance& output) {
+  output.move(pending_);
+  offload_->compressor_->compress(output, pending_end_stream_
+                                              ? Envoy::Compression::Compressor::State::Finish
+                                              : Envoy::Compression::Compressor::State::Flush);
+  end_stream_posted_ = pending_end_stream_;
+  config_->stats().total_compressed_bytes_.add(output.length());
+}
+
+void CompressorFilter::onOffloadJobComplete() {
+  offload_->in_flight_ = false;
+  config_->offloadStats().offload_job_duration_us_.recordValue(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          encoder_callbacks_->dispatcher().timeSource().monotonicTime() - offload_->queued_time_)
+          .count());
+  config_->stats().total_compressed_bytes_.add(offload_->data_.length());
+
+  Buffer::OwnedImpl data;
+  data.move(offload_->data_);
+  injectCompressed(data, offload_->state_ == Envoy::Compression::Compressor::State::Finish);
+  // The stream may have been reset by the injection.
+  if (offload_->filter_ != nullptr) {
+    resumeOffload();
+  }
+}
+
+// Compresses the data received while a chunk was in flight or the downstream was backed up.
+void CompressorFilter::resumeOffload() {
+  if (offload_->in_flight_ || end_stream_posted_ || downstream_watermarks_ > 0) {
+    return;
+  }
+  if (pending_.length() > 0 || pending_end_stream_) {
+    if (!postOffloadJob()) {
+      Buffer::OwnedImpl data;
+      compressPending(data);
+      injectCompressed(data, pending_end_stream_);
+      if (offload_->filter_ == nullptr) {
+        return;
+      }
+    }
+  }
+  updateWatermarks();
+}
+
+void CompressorFilter::injectCompressed(Buffer::Instance& data, bool end_stream) {
+  if (end_stream && pending_trailers_) {
+    if (data.length() > 0) {
+      encoder_callbacks_->injectEncodedDataToFilterChain(data, false);
+    }
+    encoder_callbacks_->continueEncoding();
+  } else if (data.length() > 0 || end_stream) {
+    encoder_callbacks_->injectEncodedDataToFilterChain(data, end_stream);
+  }
+}
+
+// Pushes back on the upstream while the pending data is over the buffer limit.
+void CompressorFilter::updateWatermarks() {
+  const uint32_t limit = encoder_callbacks_->encoderBufferLimit();
+  if (limit == 0) {
+    return;
+  }
+  if (!above_high_watermark_ && pending_.length() > limit) {
+    above_high_watermark_ = true;
+    encoder_callbacks_->onEncoderFilterAboveWriteBufferHighWatermark();
+  } else if (above_high_watermark_ && pending_.length() <= limit / 2) {
+    above_high_watermark_ = false;
+    encoder_callbacks_->onEncoderFilterBelowWriteBufferLowWatermark();
+  }
+}
+
+// Looks up the response in the response cache by its strong ETag, or else prepares to buffer its
+// body to look it up by hash. Only a body whose length is known to fit in the cache is buffered,
+// so that streamed responses are not held back until they turn out to be too large.
+void CompressorFilter::startResponseCache(const Http::ResponseHeaderMap& headers) {
+  ResponseCache* cache = config_->responseCache();
+  if (cache == nullptr) {
+    return;
+  }
+  const Http::HeaderEntry* etag = headers.getInline(etag_handle.handle());
+  // The ETag of a partial response identifies the full body, not the part of it which is sent.
+  if (etag != nullptr && isStrongEtag(etag->value().getStringView()) &&
+      headers.getStatusValue() == "200") {
+    cache_key_ = absl::StrCat("etag:", request_key_, "\n", etag->value().getStringView());
+    cached_body_ = cache->lookup(cache_key_);
+    cache_state_ = cached_body_ != nullptr ? CacheState::Hit : CacheState::Capture;
+    return;
+  }
+  uint64_t length;
+  const Http::HeaderEntry* content_length = headers.ContentLength();
+  if (content_length != nullptr &&
+      absl::SimpleAtoi(content_length->value().getStringView(), &length) &&
+      length <= config_->responseCacheMaxBodySize()) {
+    cache_state_ = CacheState::Buffer;
+  }
+}
+
+// Handles the body of a response which may be cached. Returns nothing once the body turns out to
+// be too large to be cached, in which case the data is to be compressed as usual.
+absl::optional<Http::FilterDataStatus>
+CompressorFilter::encodeCachedData(Buffer::Instance& data, bool end_stream) {
+  switch (cache_state_) {
+  case CacheState::Hit:
+    // The body of the upstream is dropped in favor of the cached one.
+    data.drain(data.length());
+    if (!end_stream) {
+      return Http::FilterDataStatus::StopIterationNoBuffer;
+    }
+    addCachedBody(data);
+    return Http::FilterDataStatus::Continue;
+  case CacheState::Capture:
+    cache_body_size_ += data.length();
+    if (cache_body_size_ > config_->responseCacheMaxBodySize()) {
+      captured_body_ = std::string();
+      body_size_ = cache_body_size_ - data.length();
+      break;
+    }
+    compressor_->compress(data, end_stream ? Envoy::Compression::Compressor::State::Finish
+                                           : Envoy::Compression::Compressor::State::Flush);
+    config_->stats().total_compressed_bytes_.add(data.length());
+    captured_body_.append(data.toString());
+    if (end_stream) {
+      config_->responseCache()->insert(cache_key_, std::move(captured_body_));
+    }
+    return Http::FilterDataStatus::Continue;
+  case CacheState::Buffer:
+    cache_buffer_.move(data);
+    if (cache_buffer_.length() > config_->responseCacheMaxBodySize()) {
+      data.move(cache_buffer_);
+      break;
+    }
+    if (!end_stream) {
+      return Http::FilterDataStatus::StopIterationNoBuffer;
+    }
+    compressBufferedBody(data);
+    return Http::FilterDataStatus::Continue;
+  case CacheState::None:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+  cache_state_ = CacheState::None;
+  return absl::nullopt;
+}
+
+// Looks up the buffered body by its hash, compressing and caching it if it is not found.
+void CompressorFilter::compressBufferedBody(Buffer::Instance& output) {
+  // The hash is cryptographic, so that an upstream can't make the cache serve another body.
+  const std::string key = absl::StrCat(
+      "sha256:",
+      Hex::encode(Envoy::Common::Crypto::UtilitySingleton::get().getSha256Digest(cache_buffer_)));
+  cached_body_ = config_->responseCache()->lookup(key);
+  if (cached_body_ != nullptr) {
+    cache_buffer_.drain(cache_buffer_.length());
+    addCachedBody(output);
+    return;
+  }
+  output.move(cache_buffer_);
+  compressor_->compress(output, Envoy::Compression::Compressor::State::Finish);
+  config_->stats().total_compressed_bytes_.add(output.length());
+  config_->responseCache()->insert(key, output.toString());
+}
+
+void CompressorFilter::addCachedBody(Buffer::Instance& output) {
+  ResponseCache::addToBuffer(cached_body_, output);
+  config_->stats().total_compressed_bytes_.add(cached_body_->size());
 }
 
 bool CompressorFilter::hasCacheControlNoTransform(Http::ResponseHeaderMap& headers) const {
@@ -440,8 +786,7 @@ void CompressorFilter::insertVaryHeader(Http::ResponseHeaderMap& headers) {
 void CompressorFilter::sanitizeEtagHeader(Http::ResponseHeaderMap& headers) {
   const Http::HeaderEntry* etag = headers.getInline(etag_handle.handle());
   if (etag != nullptr) {
-    absl::string_view value(etag->value().getStringView());
-    if (value.length() > 2 && !((value[0] == 'w' || value[0] == 'W') && value[1] == '/')) {
+    if (isStrongEtag(etag->value().getStringView())) {
       headers.removeInline(etag_handle.handle());
     }
   }
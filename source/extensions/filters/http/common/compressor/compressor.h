@@ -1,16 +1,22 @@
 #pragma once
 
+#include "envoy/common/time.h"
 #include "envoy/compression/compressor/compressor.h"
 #include "envoy/extensions/filters/http/compressor/v3/compressor.pb.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/stream_info/filter_state.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/protobuf/protobuf.h"
 #include "common/runtime/runtime_protos.h"
 
+#include "extensions/filters/http/common/compressor/compression_thread_pool.h"
+#include "extensions/filters/http/common/compressor/response_cache.h"
 #include "extensions/filters/http/common/pass_through_filter.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace HttpFilters {
@@ -55,6 +61,25 @@ struct CompressorStats {
   ALL_COMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * All compressor filter offload stats. @see stats_macros.h
+ * "offload_jobs" is the number of chunks of response bodies queued for the helper threads, and
+ * "offload_queue_full" the number of chunks compressed on the worker thread instead because the
+ * queue was full. "offload_job_duration_us" is the time from queueing a chunk until its compressed
+ * data is back on the worker thread.
+ */
+#define ALL_COMPRESSOR_OFFLOAD_STATS(COUNTER, HISTOGRAM)                                           \
+  COUNTER(offload_jobs)                                                                            \
+  COUNTER(offload_queue_full)                                                                      \
+  HISTOGRAM(offload_job_duration_us, Microseconds)
+
+/**
+ * Struct definition for compressor filter offload stats. @see stats_macros.h
+ */
+struct CompressorOffloadStats {
+  ALL_COMPRESSOR_OFFLOAD_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
 // TODO(rojkov): merge this class with Compressor::CompressorFilterConfig when the filter
 // `envoy.filters.http.gzip` is fully deprecated and dropped.
 class CompressorFilterConfig {
@@ -71,12 +96,22 @@ public:
   bool removeAcceptEncodingHeader() const { return remove_accept_encoding_header_; }
   uint32_t minimumLength() const { return content_length_; }
   const std::string contentEncoding() const { return content_encoding_; };
+  // The pool of helper threads large bodies are compressed on, or nullptr if they are compressed
+  // on the worker thread.
+  CompressionThreadPool* offloadPool() const { return offload_pool_.get(); }
+  // Only set along with the offload pool.
+  CompressorOffloadStats& offloadStats() { return *offload_stats_; }
+  uint32_t offloadMinBodySize() const { return offload_min_body_size_; }
+  uint32_t offloadMaxQueuedJobs() const { return offload_max_queued_jobs_; }
+  // The cache of compressed response bodies, or nullptr if they are not cached.
+  ResponseCache* responseCache() const { return response_cache_.get(); }
+  uint32_t responseCacheMaxBodySize() const { return response_cache_max_body_size_; }
 
 protected:
   CompressorFilterConfig(
       const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
       const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-      const std::string& content_encoding);
+      const std::string& content_encoding, CompressionThreadPoolSharedPtr offload_pool = nullptr);
 
 private:
   static StringUtil::CaseUnorderedSet
@@ -84,10 +119,18 @@ private:
 
   static uint32_t contentLengthUint(Protobuf::uint32 length);
 
+  static ResponseCachePtr createResponseCache(
+      const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
+      const std::string& stats_prefix, Stats::Scope& scope);
+
   static CompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
     return CompressorStats{ALL_COMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
   }
 
+  static std::unique_ptr<CompressorOffloadStats>
+  generateOffloadStats(const CompressionThreadPoolSharedPtr& offload_pool,
+                       const std::string& prefix, Stats::Scope& scope);
+
   const uint32_t content_length_;
   const StringUtil::CaseUnorderedSet content_type_values_;
   const bool disable_on_etag_header_;
@@ -96,16 +139,35 @@ private:
   const CompressorStats stats_;
   Runtime::FeatureFlag enabled_;
   const std::string content_encoding_;
+  const CompressionThreadPoolSharedPtr offload_pool_;
+  const std::unique_ptr<CompressorOffloadStats> offload_stats_;
+  const uint32_t offload_min_body_size_;
+  const uint32_t offload_max_queued_jobs_;
+  const ResponseCachePtr response_cache_;
+  const uint32_t response_cache_max_body_size_;
 };
 using CompressorFilterConfigSharedPtr = std::shared_ptr<CompressorFilterConfig>;
 
 /**
  * A filter that compresses data dispatched from the upstream upon client request.
+ *
+ * If the config has an offload pool, the body is compressed on the helper threads of the pool once
+ * it has reached the minimum size. A stream then has at most one chunk being compressed at a time;
+ * the data received meanwhile is buffered, and the compressed data is injected back into the
+ * filter chain on the worker thread.
+ *
+ * If the config has a response cache, a response is looked up in it by its strong ETag, or else by
+ * the hash of its body, which is buffered until the end of the stream if its Content-Length is
+ * within the maximum body size. The body of a cached response is replaced with the cached
+ * compressed body.
  */
-class CompressorFilter : public Http::PassThroughFilter {
+class CompressorFilter : public Http::PassThroughFilter, public Http::DownstreamWatermarkCallbacks {
 public:
   explicit CompressorFilter(const CompressorFilterConfigSharedPtr config);
 
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
   // Http::StreamDecoderFilter
   Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& headers,
                                           bool end_stream) override;
@@ -117,6 +179,10 @@ public:
   Http::FilterDataStatus encodeData(Buffer::Instance& buffer, bool end_stream) override;
   Http::FilterTrailersStatus encodeTrailers(Http::ResponseTrailerMap&) override;
 
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
 private:
   // TODO(gsagula): This is here temporarily and just to facilitate testing. Ideally all
   // the logic in these private member functions would be available in another class.
@@ -148,10 +214,69 @@ private:
   std::unique_ptr<EncodingDecision> chooseEncoding(const Http::ResponseHeaderMap& headers) const;
   bool shouldCompress(const EncodingDecision& decision) const;
 
+  // The compressor of an offloaded stream, with the chunk being compressed by a helper thread.
+  // While the chunk is compressed, only the helper thread touches it.
+  struct OffloadState {
+    // The filter, or nullptr once it is destroyed.
+    CompressorFilter* filter_;
+    Envoy::Compression::Compressor::CompressorPtr compressor_;
+    Buffer::OwnedImpl data_;
+    Envoy::Compression::Compressor::State state_;
+    bool in_flight_{};
+    MonotonicTime queued_time_;
+  };
+  using OffloadStateSharedPtr = std::shared_ptr<OffloadState>;
+
+  bool shouldOffload(uint64_t length);
+  void startOffload();
+  bool postOffloadJob();
+  void compressPending(Buffer::Instance& output);
+  void onOffloadJobComplete();
+  void resumeOffload();
+  void injectCompressed(Buffer::Instance& data, bool end_stream);
+  void updateWatermarks();
+
+  // How the body of a response is handled by the response cache.
+  enum class CacheState {
+    // The body is not cached.
+    None,
+    // The body is buffered, to be looked up by its hash at the end of the stream.
+    Buffer,
+    // The body was not found by its ETag, and its compressed data is captured to be cached.
+    Capture,
+    // The body was found by its ETag, and is replaced with the cached one.
+    Hit,
+  };
+
+  void startResponseCache(const Http::ResponseHeaderMap& headers);
+  absl::optional<Http::FilterDataStatus> encodeCachedData(Buffer::Instance& data, bool end_stream);
+  void compressBufferedBody(Buffer::Instance& output);
+  void addCachedBody(Buffer::Instance& output);
+
   bool skip_compression_;
   Envoy::Compression::Compressor::CompressorPtr compressor_;
   const CompressorFilterConfigSharedPtr config_;
   std::unique_ptr<std::string> accept_encoding_;
+
+  // Offload state, @see OffloadState.
+  uint64_t body_size_{};
+  OffloadStateSharedPtr offload_;
+  // The data received while a chunk is compressed or while the downstream is backed up.
+  Buffer::OwnedImpl pending_;
+  bool pending_end_stream_{};
+  bool pending_trailers_{};
+  bool end_stream_posted_{};
+  bool above_high_watermark_{};
+  uint32_t downstream_watermarks_{};
+
+  // Response cache state, @see CacheState.
+  std::string request_key_;
+  CacheState cache_state_{CacheState::None};
+  std::string cache_key_;
+  ResponseCache::Entry cached_body_;
+  uint64_t cache_body_size_{};
+  Buffer::OwnedImpl cache_buffer_;
+  std::string captured_body_;
 };
 
 } // namespace Compressors
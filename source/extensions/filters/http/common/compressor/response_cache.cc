@@ -0,0 +1,77 @@
+#include "extensions/filters/http/common/compressor/response_cache.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/lock_guard.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+ResponseCache::ResponseCache(uint64_t max_bytes, const std::string& stats_prefix,
+                             Stats::Scope& scope)
+    : max_bytes_(max_bytes), stats_(generateStats(stats_prefix, scope)) {
+  ASSERT(max_bytes_ > 0);
+}
+
+ResponseCache::Entry ResponseCache::lookup(const std::string& key) {
+  Thread::LockGuard lock(lock_);
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    stats_.response_cache_miss_.inc();
+    return nullptr;
+  }
+  stats_.response_cache_hit_.inc();
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->body_;
+}
+
+void ResponseCache::insert(const std::string& key, std::string&& body) {
+  if (body.size() > max_bytes_) {
+    return;
+  }
+  auto entry = std::make_shared<const std::string>(std::move(body));
+
+  Thread::LockGuard lock(lock_);
+  // Another worker may have cached the same body meanwhile.
+  if (entries_.contains(key)) {
+    return;
+  }
+  while (bytes_ + entry->size() > max_bytes_) {
+    bytes_ -= lru_.back().body_->size();
+    stats_.response_cache_bytes_.sub(lru_.back().body_->size());
+    stats_.response_cache_evicted_.inc();
+    entries_.erase(lru_.back().key_);
+    lru_.pop_back();
+  }
+  bytes_ += entry->size();
+  stats_.response_cache_bytes_.add(entry->size());
+  stats_.response_cache_insert_.inc();
+  lru_.push_front(CacheEntry{key, std::move(entry)});
+  entries_.emplace(key, lru_.begin());
+}
+
+void ResponseCache::addToBuffer(const Entry& entry, Buffer::Instance& buffer) {
+  if (entry->empty()) {
+    return;
+  }
+  // The fragment holds a reference to the body until the slice is drained.
+  auto fragment = new Buffer::BufferFragmentImpl(
+      entry->data(), entry->size(),
+      [entry](const void*, size_t, const Buffer::BufferFragmentImpl* this_fragment) {
+        delete this_fragment;
+      });
+  buffer.addBufferFragment(*fragment);
+}
+
+size_t ResponseCache::size() {
+  Thread::LockGuard lock(lock_);
+  return entries_.size();
+}
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/non_copyable.h"
+#include "common/common/thread.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+/**
+ * All response cache stats. @see stats_macros.h
+ * "response_cache_bytes" is the total size of the compressed bodies in the cache. Evicted bodies
+ * which are still being sent are not included.
+ */
+#define ALL_RESPONSE_CACHE_STATS(COUNTER, GAUGE)                                                   \
+  COUNTER(response_cache_hit)                                                                      \
+  COUNTER(response_cache_miss)                                                                     \
+  COUNTER(response_cache_insert)                                                                   \
+  COUNTER(response_cache_evicted)                                                                  \
+  GAUGE(response_cache_bytes, NeverImport)
+
+/**
+ * Struct definition for response cache stats. @see stats_macros.h
+ */
+struct ResponseCacheStats {
+  ALL_RESPONSE_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Cache of the compressed bodies of responses, shared by the worker threads. Each filter config
+ * has its own cache, so the key only has to identify the uncompressed body: the encoding and the
+ * compression level are those of the config.
+ *
+ * The cache is bounded by the total size of its bodies; when it is full the least recently used
+ * bodies are evicted. The bodies are immutable and reference counted, so that they are added to
+ * the responses without being copied, and an evicted body lives on until it has been sent.
+ */
+class ResponseCache : NonCopyable {
+public:
+  using Entry = std::shared_ptr<const std::string>;
+
+  ResponseCache(uint64_t max_bytes, const std::string& stats_prefix, Stats::Scope& scope);
+
+  /**
+   * @param key supplies the key of the uncompressed body.
+   * @return the cached compressed body, or nullptr if there is none.
+   */
+  Entry lookup(const std::string& key);
+
+  /**
+   * Caches a compressed body, unless it is larger than the cache or the key is already cached.
+   * @param key supplies the key of the uncompressed body.
+   * @param body supplies the compressed body.
+   */
+  void insert(const std::string& key, std::string&& body);
+
+  /**
+   * Adds a cached body to a buffer as a slice referencing it.
+   */
+  static void addToBuffer(const Entry& entry, Buffer::Instance& buffer);
+
+  /**
+   * @return the number of cached bodies.
+   */
+  size_t size();
+
+private:
+  struct CacheEntry {
+    std::string key_;
+    Entry body_;
+  };
+  using CacheEntryList = std::list<CacheEntry>;
+
+  static ResponseCacheStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return ResponseCacheStats{ALL_RESPONSE_CACHE_STATS(POOL_COUNTER_PREFIX(scope, prefix),
+                                                       POOL_GAUGE_PREFIX(scope, prefix))};
+  }
+
+  const uint64_t max_bytes_;
+  ResponseCacheStats stats_;
+  Thread::MutexBasicLockable lock_;
+  uint64_t bytes_ ABSL_GUARDED_BY(lock_){};
+  // Most recently used entries are at the front of the list.
+  CacheEntryList lru_ ABSL_GUARDED_BY(lock_);
+  absl::flat_hash_map<std::string, CacheEntryList::iterator> entries_ ABSL_GUARDED_BY(lock_);
+};
+using ResponseCachePtr = std::unique_ptr<ResponseCache>;
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
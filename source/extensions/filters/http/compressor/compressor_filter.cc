@@ -5,15 +5,26 @@ namespace Extensions {
 namespace HttpFilters {
 namespace Compressor {
 
+namespace {
+
+std::string
+statsPrefix(const envoy::extensions::filters::http::compressor::v3::Compressor& generic_compressor,
+            const std::string& stats_prefix,
+            const Compression::Compressor::CompressorFactory& compressor_factory) {
+  return stats_prefix + "compressor." + generic_compressor.compressor_library().name() + "." +
+         compressor_factory.statsPrefix();
+}
+
+} // namespace
+
 CompressorFilterConfig::CompressorFilterConfig(
     const envoy::extensions::filters::http::compressor::v3::Compressor& generic_compressor,
     const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-    Compression::Compressor::CompressorFactoryPtr compressor_factory)
+    Compression::Compressor::CompressorFactoryPtr compressor_factory,
+    Common::Compressors::CompressionThreadPoolSharedPtr offload_pool)
     : Common::Compressors::CompressorFilterConfig(
-          generic_compressor,
-          stats_prefix + "compressor." + generic_compressor.compressor_library().name() + "." +
-              compressor_factory->statsPrefix(),
-          scope, runtime, compressor_factory->contentEncoding()),
+          generic_compressor, statsPrefix(generic_compressor, stats_prefix, *compressor_factory),
+          scope, runtime, compressor_factory->contentEncoding(), std::move(offload_pool)),
       compressor_factory_(std::move(compressor_factory)) {}
 
 Envoy::Compression::Compressor::CompressorPtr CompressorFilterConfig::makeCompressor() {
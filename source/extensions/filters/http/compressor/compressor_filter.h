@@ -21,7 +21,8 @@ public:
   CompressorFilterConfig(
       const envoy::extensions::filters::http::compressor::v3::Compressor& genereic_compressor,
       const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-      Envoy::Compression::Compressor::CompressorFactoryPtr compressor_factory);
+      Envoy::Compression::Compressor::CompressorFactoryPtr compressor_factory,
+      Common::Compressors::CompressionThreadPoolSharedPtr offload_pool = nullptr);
 
   Envoy::Compression::Compressor::CompressorPtr makeCompressor() override;
 
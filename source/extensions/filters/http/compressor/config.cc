@@ -1,8 +1,10 @@
 #include "extensions/filters/http/compressor/config.h"
 
 #include "envoy/compression/compressor/config.h"
+#include "envoy/singleton/manager.h"
 
 #include "common/config/utility.h"
+#include "common/protobuf/utility.h"
 
 #include "extensions/filters/http/compressor/compressor_filter.h"
 
@@ -11,6 +13,50 @@ namespace Extensions {
 namespace HttpFilters {
 namespace Compressor {
 
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(compression_thread_pool);
+
+namespace {
+
+// Default number of helper threads large bodies are compressed on.
+const uint32_t DefaultOffloadThreads = 1;
+
+// Returns the pool of helper threads shared by the compressor filters, with at least the threads
+// the config asks for, or nullptr if the config does not offload compression.
+Common::Compressors::CompressionThreadPoolSharedPtr
+getCompressionThreadPool(const envoy::extensions::filters::http::compressor::v3::Compressor& config,
+                         Server::Configuration::FactoryContext& context) {
+  if (!config.has_offload()) {
+    return nullptr;
+  }
+  auto pool = context.singletonManager().getTyped<Common::Compressors::CompressionThreadPool>(
+      SINGLETON_MANAGER_REGISTERED_NAME(compression_thread_pool), [&context] {
+        Thread::ThreadFactory& thread_factory = context.api().threadFactory();
+        Event::Dispatcher& main_dispatcher = context.dispatcher();
+        const Thread::ThreadId main_thread_id = thread_factory.currentThreadId();
+        // The last filter config may be released by a worker, e.g. along with its last stream
+        // after a listener update. The pool joins its threads and frees its thread local slot on
+        // destruction, which is only done on the main thread.
+        return std::shared_ptr<Common::Compressors::CompressionThreadPool>(
+            new Common::Compressors::CompressionThreadPool(
+                thread_factory, context.threadLocal(),
+                context.getServerFactoryContext().scope()),
+            [&thread_factory, &main_dispatcher,
+             main_thread_id](Common::Compressors::CompressionThreadPool* pool) {
+              if (thread_factory.currentThreadId() == main_thread_id) {
+                delete pool;
+              } else {
+                main_dispatcher.post([pool]() { delete pool; });
+              }
+            });
+      });
+  pool->reserveThreads(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.offload(), threads,
+                                                       DefaultOffloadThreads));
+  return pool;
+}
+
+} // namespace
+
 Http::FilterFactoryCb CompressorFilterFactory::createFilterFactoryFromProtoTyped(
     const envoy::extensions::filters::http::compressor::v3::Compressor& proto_config,
     const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
@@ -35,7 +81,8 @@ Http::FilterFactoryCb CompressorFilterFactory::createFilterFactoryFromProtoTyped
       config_factory->createCompressorFactoryFromProto(*message, context);
   Common::Compressors::CompressorFilterConfigSharedPtr config =
       std::make_shared<CompressorFilterConfig>(proto_config, stats_prefix, context.scope(),
-                                               context.runtime(), std::move(compressor_factory));
+                                               context.runtime(), std::move(compressor_factory),
+                                               getCompressionThreadPool(proto_config, context));
   return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamFilter(std::make_shared<Common::Compressors::CompressorFilter>(config));
   };
@@ -24,7 +24,8 @@ Http::FilterFactoryCb ExtAuthzFilterConfig::createFilterFactoryFromProtoTyped(
     const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
   const auto filter_config =
       std::make_shared<FilterConfig>(proto_config, context.localInfo(), context.scope(),
-                                     context.runtime(), context.httpContext(), stats_prefix);
+                                     context.runtime(), context.httpContext(), stats_prefix,
+                                     context.threadLocal(), context.dispatcher().timeSource());
   Http::FilterFactoryCb callback;
 
   if (proto_config.has_http_service()) {
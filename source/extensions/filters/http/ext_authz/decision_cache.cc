@@ -0,0 +1,102 @@
+#include "extensions/filters/http/ext_authz/decision_cache.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+
+using Filters::Common::ExtAuthz::CheckStatus;
+using Filters::Common::ExtAuthz::Response;
+using Filters::Common::ExtAuthz::ResponsePtr;
+
+DecisionCache::DecisionCache(TimeSource& time_source, uint32_t max_entries)
+    : time_source_(time_source), max_entries_(max_entries) {
+  ASSERT(max_entries_ > 0);
+}
+
+ResponsePtr DecisionCache::lookup(const std::string& key) {
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  const CacheEntryList::iterator entry = it->second;
+  if (time_source_.monotonicTime() >= entry->expiry_) {
+    entries_.erase(it);
+    lru_.erase(entry);
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, entry);
+  return std::make_unique<Response>(entry->response_);
+}
+
+bool DecisionCache::startCheck(const std::string& key, Waiter& waiter) {
+  const auto result = pending_.try_emplace(key);
+  if (result.second) {
+    return true;
+  }
+  result.first->second.push_back(&waiter);
+  return false;
+}
+
+void DecisionCache::removeWaiter(const std::string& key, Waiter& waiter) {
+  const auto it = pending_.find(key);
+  if (it != pending_.end()) {
+    it->second.remove(&waiter);
+  }
+}
+
+void DecisionCache::complete(const std::string& key, const Response& response,
+                             std::chrono::milliseconds ttl) {
+  if (response.status != CheckStatus::Error && ttl.count() > 0) {
+    insert(key, response, ttl);
+  }
+
+  // The waiters are taken off the list one at a time, as completing one may reset the stream of
+  // another, which then removes itself.
+  auto it = pending_.find(key);
+  while (it != pending_.end() && !it->second.empty()) {
+    Waiter* waiter = it->second.front();
+    it->second.pop_front();
+    waiter->onComplete(std::make_unique<Response>(response));
+    it = pending_.find(key);
+  }
+  if (it != pending_.end()) {
+    pending_.erase(it);
+  }
+}
+
+void DecisionCache::cancel(const std::string& key) {
+  const auto it = pending_.find(key);
+  if (it == pending_.end()) {
+    return;
+  }
+  if (it->second.empty()) {
+    pending_.erase(it);
+    return;
+  }
+  // The check stays registered, with the first waiter as its sender.
+  Waiter* waiter = it->second.front();
+  it->second.pop_front();
+  waiter->onCheckCancelled();
+}
+
+void DecisionCache::insert(const std::string& key, const Response& response,
+                           std::chrono::milliseconds ttl) {
+  const auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    lru_.erase(it->second);
+    entries_.erase(it);
+  } else if (entries_.size() >= max_entries_) {
+    entries_.erase(lru_.back().key_);
+    lru_.pop_back();
+  }
+  lru_.push_front(CacheEntry{key, response, time_source_.monotonicTime() + ttl});
+  entries_.emplace(key, lru_.begin());
+}
+
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
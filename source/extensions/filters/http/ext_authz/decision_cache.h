@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <string>
+
+#include "envoy/common/pure.h"
+#include "envoy/common/time.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "extensions/filters/common/ext_authz/ext_authz.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+
+/**
+ * Per worker cache of the decisions of the external authorization service, keyed by the request
+ * attributes the decisions depend on. It also tracks the checks in flight on the worker, so that
+ * requests with the same key wait for the decision of a single check instead of each sending one.
+ * It is not thread safe; each worker has its own instance.
+ *
+ * OK and denied decisions are cached for the TTL given on completion. Errors are never cached, but
+ * are passed on to the requests waiting for the check. When the cache is full the least recently
+ * used decision is evicted.
+ */
+class DecisionCache : public ThreadLocal::ThreadLocalObject {
+public:
+  /**
+   * A request waiting for the decision of a check sent for another request with the same key.
+   * The decision is passed to onComplete().
+   */
+  class Waiter : public Filters::Common::ExtAuthz::RequestCallbacks {
+  public:
+    /**
+     * Called instead of onComplete() when the check the waiter waits for is cancelled, e.g.
+     * because the request which sent it was reset. The waiter must send the check itself, and
+     * then call complete() or cancel() for the key.
+     */
+    virtual void onCheckCancelled() PURE;
+  };
+
+  DecisionCache(TimeSource& time_source, uint32_t max_entries);
+
+  /**
+   * @param key supplies the cache key of the request.
+   * @return a copy of the cached decision, or nullptr if there is none or it has expired.
+   */
+  Filters::Common::ExtAuthz::ResponsePtr lookup(const std::string& key);
+
+  /**
+   * Registers a check for the key, unless one is already in flight.
+   * @param key supplies the cache key of the request.
+   * @param waiter supplies the request, which waits for the check in flight if there is one.
+   * @return true if no check was in flight, in which case the caller must send it and then call
+   *         complete() or cancel(). false if the waiter was added to the check in flight.
+   */
+  bool startCheck(const std::string& key, Waiter& waiter);
+
+  /**
+   * Removes a waiter, e.g. because its request was reset.
+   */
+  void removeWaiter(const std::string& key, Waiter& waiter);
+
+  /**
+   * Completes the check in flight for the key, caching its decision and passing a copy of it to
+   * the waiters.
+   * @param response supplies the response to the check.
+   * @param ttl supplies how long the decision is cached. It isn't cached if 0.
+   */
+  void complete(const std::string& key, const Filters::Common::ExtAuthz::Response& response,
+                std::chrono::milliseconds ttl);
+
+  /**
+   * Cancels the check in flight for the key. If requests are waiting for it, the first one sends
+   * the check instead.
+   */
+  void cancel(const std::string& key);
+
+  /**
+   * @return the number of cached decisions, including expired ones which have not been purged yet.
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct CacheEntry {
+    std::string key_;
+    Filters::Common::ExtAuthz::Response response_;
+    MonotonicTime expiry_;
+  };
+  using CacheEntryList = std::list<CacheEntry>;
+
+  void insert(const std::string& key, const Filters::Common::ExtAuthz::Response& response,
+              std::chrono::milliseconds ttl);
+
+  TimeSource& time_source_;
+  const uint32_t max_entries_;
+  // Most recently used entries are at the front of the list.
+  CacheEntryList lru_;
+  absl::flat_hash_map<std::string, CacheEntryList::iterator> entries_;
+  // The requests waiting for each check in flight.
+  absl::flat_hash_map<std::string, std::list<Waiter*>> pending_;
+};
+
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -1,14 +1,21 @@
 #include "extensions/filters/http/ext_authz/ext_authz.h"
 
+#include <algorithm>
+
 #include "envoy/config/core/v3/base.pb.h"
 
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
+#include "common/http/header_utility.h"
 #include "common/http/utility.h"
+#include "common/protobuf/utility.h"
 #include "common/router/config_impl.h"
 
 #include "extensions/filters/http/well_known_names.h"
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace HttpFilters {
@@ -22,6 +29,106 @@ struct RcDetailsValues {
 };
 using RcDetails = ConstSingleton<RcDetailsValues>;
 
+namespace {
+
+constexpr uint32_t DefaultDecisionCacheMaxEntries = 10000;
+
+// Appends a value prefixed with its length, so that different values can't result in the same key.
+void appendKeyValue(std::string& key, absl::string_view value) {
+  absl::StrAppend(&key, value.size(), ":", value);
+}
+
+} // namespace
+
+void FilterConfig::initDecisionCache(
+    const envoy::extensions::filters::http::ext_authz::v3::DecisionCache& config,
+    ThreadLocal::SlotAllocator& tls, TimeSource& time_source) {
+  for (const auto& header : config.key_headers()) {
+    cache_key_headers_.emplace_back(header);
+  }
+  for (const auto& metadata_key : config.key_metadata()) {
+    cache_key_metadata_.emplace_back(metadata_key);
+  }
+  cache_ttl_ = std::chrono::milliseconds(DurationUtil::durationToMilliseconds(config.ttl()));
+  if (!config.ttl_header().empty()) {
+    cache_ttl_header_.emplace(config.ttl_header());
+  }
+
+  const uint32_t max_entries =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_entries, DefaultDecisionCacheMaxEntries);
+  decision_cache_slot_ = tls.allocateSlot();
+  decision_cache_slot_->set([&time_source, max_entries](Event::Dispatcher&) {
+    return std::make_shared<DecisionCache>(time_source, max_entries);
+  });
+}
+
+std::string
+FilterConfig::decisionCacheKey(const Http::RequestHeaderMap& headers,
+                               const Router::RouteConstSharedPtr& route,
+                               const Protobuf::Map<std::string, std::string>& context_extensions,
+                               const envoy::config::core::v3::Metadata& dynamic_metadata) const {
+  // Decisions are never shared between routes or methods, whatever the configured key.
+  std::string key;
+  const Router::RouteEntry* route_entry = route != nullptr ? route->routeEntry() : nullptr;
+  if (route_entry != nullptr) {
+    appendKeyValue(key, route_entry->virtualHost().name());
+    appendKeyValue(key, route_entry->routeName());
+  } else {
+    key.append(";");
+  }
+  appendKeyValue(key, headers.getMethodValue());
+
+  // Each list of values is prefixed with its size, so that e.g. a missing header is told apart
+  // from an empty one.
+  std::vector<absl::string_view> values;
+  for (const auto& header : cache_key_headers_) {
+    values.clear();
+    Http::HeaderUtility::getAllOfHeader(headers, header.get(), values);
+    absl::StrAppend(&key, values.size(), ";");
+    for (const absl::string_view value : values) {
+      appendKeyValue(key, value);
+    }
+  }
+  // The serialization of a struct value isn't deterministic, which at worst causes a cache miss.
+  for (const auto& metadata_key : cache_key_metadata_) {
+    appendKeyValue(
+        key, Config::Metadata::metadataValue(&dynamic_metadata, metadata_key).SerializeAsString());
+  }
+  // The iteration order of a protobuf map is unspecified.
+  std::vector<std::pair<absl::string_view, absl::string_view>> extensions(
+      context_extensions.begin(), context_extensions.end());
+  std::sort(extensions.begin(), extensions.end());
+  absl::StrAppend(&key, extensions.size(), ";");
+  for (const auto& extension : extensions) {
+    appendKeyValue(key, extension.first);
+    appendKeyValue(key, extension.second);
+  }
+  return key;
+}
+
+std::chrono::milliseconds
+FilterConfig::takeDecisionTtl(Filters::Common::ExtAuthz::Response& response) const {
+  std::chrono::milliseconds ttl = cache_ttl_;
+  if (!cache_ttl_header_.has_value()) {
+    return ttl;
+  }
+  for (Http::HeaderVector* headers :
+       {&response.headers_to_set, &response.headers_to_add, &response.headers_to_append}) {
+    for (auto it = headers->begin(); it != headers->end();) {
+      if (it->first == cache_ttl_header_.value()) {
+        uint32_t seconds;
+        if (absl::SimpleAtoi(it->second, &seconds)) {
+          ttl = std::chrono::seconds(seconds);
+        }
+        it = headers->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return ttl;
+}
+
 void FilterConfigPerRoute::merge(const FilterConfigPerRoute& other) {
   disabled_ = other.disabled_;
   auto begin_it = other.context_extensions_.begin();
@@ -31,12 +138,8 @@ void FilterConfigPerRoute::merge(const FilterConfigPerRoute& other) {
   }
 }
 
-void Filter::initiateCall(const Http::RequestHeaderMap& headers,
-                          const Router::RouteConstSharedPtr& route) {
-  if (filter_return_ == FilterReturn::StopDecoding) {
-    return;
-  }
-
+Protobuf::Map<std::string, std::string>
+Filter::contextExtensions(const Router::RouteConstSharedPtr& route) const {
   auto&& maybe_merged_per_route_config =
       Http::Utility::getMergedPerFilterConfig<FilterConfigPerRoute>(
           HttpFilterNames::get().ExtAuthorization, route,
@@ -48,7 +151,54 @@ void Filter::initiateCall(const Http::RequestHeaderMap& headers,
   if (maybe_merged_per_route_config) {
     context_extensions = maybe_merged_per_route_config.value().takeContextExtensions();
   }
+  return context_extensions;
+}
+
+void Filter::initiateCall(const Http::RequestHeaderMap& headers,
+                          const Router::RouteConstSharedPtr& route) {
+  if (filter_return_ == FilterReturn::StopDecoding) {
+    return;
+  }
 
+  Protobuf::Map<std::string, std::string> context_extensions = contextExtensions(route);
+
+  DecisionCache* decision_cache = config_->decisionCache();
+  if (decision_cache != nullptr) {
+    cache_key_ = config_->decisionCacheKey(headers, route, context_extensions,
+                                           callbacks_->streamInfo().dynamicMetadata());
+    filter_return_ = FilterReturn::StopDecoding;
+    cluster_ = callbacks_->clusterInfo();
+
+    Filters::Common::ExtAuthz::ResponsePtr cached = decision_cache->lookup(cache_key_);
+    if (cached != nullptr) {
+      ENVOY_STREAM_LOG(trace, "ext_authz filter found the decision in the cache", *callbacks_);
+      stats_.cache_hit_.inc();
+      state_ = State::Calling;
+      initiating_call_ = true;
+      onComplete(std::move(cached));
+      initiating_call_ = false;
+      return;
+    }
+    stats_.cache_miss_.inc();
+
+    if (!decision_cache->startCheck(cache_key_, *this)) {
+      ENVOY_STREAM_LOG(trace, "ext_authz filter waiting for the decision of a call in flight",
+                       *callbacks_);
+      stats_.cache_coalesced_.inc();
+      state_ = State::Waiting;
+      return;
+    }
+    cache_sender_ = true;
+  }
+
+  // A check which completes inline only changes the value decodeHeaders() or decodeData() returns.
+  initiating_call_ = true;
+  sendCheck(headers, std::move(context_extensions));
+  initiating_call_ = false;
+}
+
+void Filter::sendCheck(const Http::RequestHeaderMap& headers,
+                       Protobuf::Map<std::string, std::string>&& context_extensions) {
   // If metadata_context_namespaces is specified, pass matching metadata to the ext_authz service.
   envoy::config::core::v3::Metadata metadata_context;
   const auto& request_metadata = callbacks_->streamInfo().dynamicMetadata().filter_metadata();
@@ -68,9 +218,7 @@ void Filter::initiateCall(const Http::RequestHeaderMap& headers,
   filter_return_ = FilterReturn::StopDecoding; // Don't let the filter chain continue as we are
                                                // going to invoke check call.
   cluster_ = callbacks_->clusterInfo();
-  initiating_call_ = true;
   client_->check(*this, check_request_, callbacks_->activeSpan(), callbacks_->streamInfo());
-  initiating_call_ = false;
 }
 
 Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers, bool end_stream) {
@@ -154,11 +302,33 @@ void Filter::onDestroy() {
   if (state_ == State::Calling) {
     state_ = State::Complete;
     client_->cancel();
+    if (cache_sender_) {
+      // Hands the call over to a request waiting for its decision, if any.
+      cache_sender_ = false;
+      config_->decisionCache()->cancel(cache_key_);
+    }
+  } else if (state_ == State::Waiting) {
+    state_ = State::Complete;
+    config_->decisionCache()->removeWaiter(cache_key_, *this);
   }
 }
 
+void Filter::onCheckCancelled() {
+  ENVOY_STREAM_LOG(trace, "ext_authz filter taking over the call of a cancelled request",
+                   *callbacks_);
+  cache_sender_ = true;
+  // The request is stopped already, so a check which completes inline continues it like one which
+  // completes later.
+  sendCheck(*request_headers_, contextExtensions(callbacks_->route()));
+}
+
 void Filter::onComplete(Filters::Common::ExtAuthz::ResponsePtr&& response) {
   state_ = State::Complete;
+  if (cache_sender_) {
+    cache_sender_ = false;
+    const std::chrono::milliseconds ttl = config_->takeDecisionTtl(*response);
+    config_->decisionCache()->complete(cache_key_, *response, ttl);
+  }
   using Filters::Common::ExtAuthz::CheckStatus;
   Stats::StatName empty_stat_name;
 
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
+#include "envoy/config/core/v3/base.pb.h"
 #include "envoy/extensions/filters/http/ext_authz/v3/ext_authz.pb.h"
 #include "envoy/http/filter.h"
 #include "envoy/local_info/local_info.h"
@@ -12,11 +15,13 @@
 #include "envoy/service/auth/v3/external_auth.pb.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/common/assert.h"
 #include "common/common/logger.h"
 #include "common/common/matchers.h"
+#include "common/config/metadata.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
 #include "common/runtime/runtime_protos.h"
@@ -24,6 +29,7 @@
 #include "extensions/filters/common/ext_authz/ext_authz.h"
 #include "extensions/filters/common/ext_authz/ext_authz_grpc_impl.h"
 #include "extensions/filters/common/ext_authz/ext_authz_http_impl.h"
+#include "extensions/filters/http/ext_authz/decision_cache.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -43,7 +49,10 @@ enum class FilterRequestType { Internal, External, Both };
   COUNTER(ok)                                                                                      \
   COUNTER(denied)                                                                                  \
   COUNTER(error)                                                                                   \
-  COUNTER(failure_mode_allowed)
+  COUNTER(failure_mode_allowed)                                                                    \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(cache_coalesced)
 
 /**
  * Wrapper struct for ext_authz filter stats. @see stats_macros.h
@@ -59,7 +68,8 @@ class FilterConfig {
 public:
   FilterConfig(const envoy::extensions::filters::http::ext_authz::v3::ExtAuthz& config,
                const LocalInfo::LocalInfo&, Stats::Scope& scope, Runtime::Loader& runtime,
-               Http::Context& http_context, const std::string& stats_prefix)
+               Http::Context& http_context, const std::string& stats_prefix,
+               ThreadLocal::SlotAllocator& tls, TimeSource& time_source)
       : allow_partial_message_(config.with_request_body().allow_partial_message()),
         failure_mode_allow_(config.failure_mode_allow()),
         clear_route_cache_(config.clear_route_cache()),
@@ -81,7 +91,11 @@ public:
         stats_(generateStats(stats_prefix, scope)), ext_authz_ok_(pool_.add("ext_authz.ok")),
         ext_authz_denied_(pool_.add("ext_authz.denied")),
         ext_authz_error_(pool_.add("ext_authz.error")),
-        ext_authz_failure_mode_allowed_(pool_.add("ext_authz.failure_mode_allowed")) {}
+        ext_authz_failure_mode_allowed_(pool_.add("ext_authz.failure_mode_allowed")) {
+    if (config.has_decision_cache()) {
+      initDecisionCache(config.decision_cache(), tls, time_source);
+    }
+  }
 
   bool allowPartialMessage() const { return allow_partial_message_; }
 
@@ -117,7 +131,35 @@ public:
 
   bool includePeerCertificate() const { return include_peer_certificate_; }
 
+  /**
+   * @return the decision cache of the worker, or nullptr if decision caching isn't configured.
+   */
+  DecisionCache* decisionCache() {
+    return decision_cache_slot_ != nullptr ? &decision_cache_slot_->getTyped<DecisionCache>()
+                                           : nullptr;
+  }
+
+  /**
+   * @return the decision cache key of a request, made of its route and method, of the configured
+   *         headers and dynamic metadata values and of the context extensions of its route.
+   */
+  std::string decisionCacheKey(const Http::RequestHeaderMap& headers,
+                               const Router::RouteConstSharedPtr& route,
+                               const Protobuf::Map<std::string, std::string>& context_extensions,
+                               const envoy::config::core::v3::Metadata& dynamic_metadata) const;
+
+  /**
+   * Removes the configured TTL header from a response to a check.
+   * @return how long the decision of the response may be cached, which is given by the TTL header
+   *         if the response has one, and by the configured TTL otherwise.
+   */
+  std::chrono::milliseconds takeDecisionTtl(Filters::Common::ExtAuthz::Response& response) const;
+
 private:
+  void initDecisionCache(
+      const envoy::extensions::filters::http::ext_authz::v3::DecisionCache& config,
+      ThreadLocal::SlotAllocator& tls, TimeSource& time_source);
+
   static Http::Code toErrorCode(uint64_t status) {
     const auto code = static_cast<Http::Code>(status);
     if (code >= Http::Code::Continue && code <= Http::Code::NetworkAuthenticationRequired) {
@@ -153,6 +195,13 @@ private:
   // The stats for the filter.
   ExtAuthzFilterStats stats_;
 
+  // The decision cache settings, only set if decision caching is configured.
+  std::vector<Http::LowerCaseString> cache_key_headers_;
+  std::vector<Config::MetadataKey> cache_key_metadata_;
+  std::chrono::milliseconds cache_ttl_{};
+  absl::optional<Http::LowerCaseString> cache_ttl_header_;
+  ThreadLocal::SlotPtr decision_cache_slot_;
+
 public:
   // TODO(nezdolik): deprecate cluster scope stats counters in favor of filter scope stats
   // (ExtAuthzFilterStats stats_).
@@ -203,7 +252,7 @@ private:
  */
 class Filter : public Logger::Loggable<Logger::Id::filter>,
                public Http::StreamDecoderFilter,
-               public Filters::Common::ExtAuthz::RequestCallbacks {
+               public DecisionCache::Waiter {
 public:
   Filter(const FilterConfigSharedPtr& config, Filters::Common::ExtAuthz::ClientPtr&& client)
       : config_(config), client_(std::move(client)), stats_(config->stats()) {}
@@ -221,18 +270,26 @@ public:
   // ExtAuthz::RequestCallbacks
   void onComplete(Filters::Common::ExtAuthz::ResponsePtr&&) override;
 
+  // DecisionCache::Waiter
+  void onCheckCancelled() override;
+
 private:
   void addResponseHeaders(Http::HeaderMap& header_map, const Http::HeaderVector& headers);
   void initiateCall(const Http::RequestHeaderMap& headers,
                     const Router::RouteConstSharedPtr& route);
+  void sendCheck(const Http::RequestHeaderMap& headers,
+                 Protobuf::Map<std::string, std::string>&& context_extensions);
+  Protobuf::Map<std::string, std::string>
+  contextExtensions(const Router::RouteConstSharedPtr& route) const;
   void continueDecoding();
   bool isBufferFull() const;
   bool skipCheckForRoute(const Router::RouteConstSharedPtr& route) const;
 
   // State of this filter's communication with the external authorization service.
   // The filter has either not started calling the external service, in the middle of calling
-  // it or has completed.
-  enum class State { NotStarted, Calling, Complete };
+  // it, waiting for the decision of a call made for another request with the same decision cache
+  // key, or has completed.
+  enum class State { NotStarted, Calling, Waiting, Complete };
 
   // FilterReturn is used to capture what the return code should be to the filter chain.
   // if this filter is either in the middle of calling the service or the result is denied then
@@ -255,6 +312,11 @@ private:
   bool buffer_data_{};
   bool skip_check_{false};
   envoy::service::auth::v3::CheckRequest check_request_{};
+  // The decision cache key of the request, if decision caching is configured.
+  std::string cache_key_;
+  // Whether the call in flight was registered in the decision cache by this filter, which must then
+  // complete or cancel it there.
+  bool cache_sender_{};
 };
 
 } // namespace ExtAuthz
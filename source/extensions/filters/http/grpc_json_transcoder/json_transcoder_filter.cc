@@ -1,5 +1,6 @@
 #include "extensions/filters/http/grpc_json_transcoder/json_transcoder_filter.h"
 
+#include <limits>
 #include <memory>
 #include <unordered_set>
 
@@ -62,6 +63,24 @@ using RcDetails = ConstSingleton<RcDetailsValues>;
 
 namespace {
 
+// Bodies of HttpBody responses at least this large are added to the response without being
+// copied.
+const uint64_t MinHttpBodyFragmentSize = 1024;
+
+// Fragment owning the body of an HttpBody response.
+class HttpBodyFragmentImpl : public Buffer::BufferFragment {
+public:
+  explicit HttpBodyFragmentImpl(std::string&& body) : body_(std::move(body)) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return body_.data(); }
+  size_t size() const override { return body_.size(); }
+  void done() override { delete this; }
+
+private:
+  const std::string body_;
+};
+
 const Http::LowerCaseString& trailerHeader() {
   CONSTRUCT_ON_FIRST_USE(Http::LowerCaseString, "trailer");
 }
@@ -413,6 +432,12 @@ Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::RequestHeade
     if (checkIfTranscoderFailed(RcDetails::get().GrpcTranscodeFailed)) {
       return Http::FilterHeadersStatus::StopIteration;
     }
+
+    uint64_t content_length;
+    if (!end_stream && !method_->descriptor_->client_streaming() &&
+        absl::SimpleAtoi(headers.getContentLengthValue(), &content_length)) {
+      startHttpBodyRequestStreaming(content_length);
+    }
   }
 
   headers.removeContentLength();
@@ -454,13 +479,20 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
     return Http::FilterDataStatus::Continue;
   }
 
+  if (method_->request_type_is_http_body_ && http_body_remaining_.has_value()) {
+    if (!streamHttpBodyRequestData(data, end_stream)) {
+      return Http::FilterDataStatus::StopIterationNoBuffer;
+    }
+    return Http::FilterDataStatus::Continue;
+  }
+
   if (method_->request_type_is_http_body_) {
     request_data_.move(data);
     // TODO(euroelessar): Upper bound message size for streaming case.
     if (end_stream || method_->descriptor_->client_streaming()) {
       maybeSendHttpBodyRequestMessage();
     } else {
-      // TODO(euroelessar): Avoid buffering if content length is already known.
+      // The length of the body is unknown, so the message is sent once it is complete.
       return Http::FilterDataStatus::StopIterationAndBuffer;
     }
   } else {
@@ -486,7 +518,15 @@ Http::FilterTrailersStatus JsonTranscoderFilter::decodeTrailers(Http::RequestTra
     return Http::FilterTrailersStatus::Continue;
   }
 
-  if (method_->request_type_is_http_body_) {
+  if (method_->request_type_is_http_body_ && http_body_remaining_.has_value()) {
+    Buffer::OwnedImpl data;
+    if (!streamHttpBodyRequestData(data, true)) {
+      return Http::FilterTrailersStatus::StopIteration;
+    }
+    if (data.length() > 0) {
+      decoder_callbacks_->addDecodedData(data, true);
+    }
+  } else if (method_->request_type_is_http_body_) {
     maybeSendHttpBodyRequestMessage();
   } else {
     request_in_.finish();
@@ -701,6 +741,47 @@ void JsonTranscoderFilter::maybeSendHttpBodyRequestMessage() {
   first_request_sent_ = true;
 }
 
+// Builds the start of the request message, up to its body, so that the body is passed on as it is
+// received instead of being buffered until the end of the stream.
+void JsonTranscoderFilter::startHttpBodyRequestStreaming(uint64_t content_length) {
+  Buffer::OwnedImpl envelope;
+  HttpBodyUtils::appendHttpBodyEnvelope(envelope, method_->request_body_field_path, content_type_,
+                                        content_length);
+  const uint64_t message_length =
+      initial_request_data_.length() + envelope.length() + content_length;
+  if (message_length > std::numeric_limits<uint32_t>::max()) {
+    // Too large for a gRPC frame; the message is left to fail once buffered.
+    return;
+  }
+  std::array<uint8_t, 5> frame_header;
+  Grpc::Encoder().newFrame(Grpc::GRPC_FH_DEFAULT, message_length, frame_header);
+  http_body_request_prefix_.add(frame_header.data(), frame_header.size());
+  http_body_request_prefix_.move(initial_request_data_);
+  http_body_request_prefix_.move(envelope);
+  content_type_.clear();
+  http_body_remaining_ = content_length;
+}
+
+// Passes on data of a streamed HttpBody request, preceded by the start of the message. Returns
+// false if the body does not match its content length, in which case a local reply is sent.
+bool JsonTranscoderFilter::streamHttpBodyRequestData(Buffer::Instance& data, bool end_stream) {
+  if (data.length() > *http_body_remaining_ ||
+      (end_stream && data.length() != *http_body_remaining_)) {
+    ENVOY_LOG(debug, "HttpBody request body does not match its content length");
+    error_ = true;
+    decoder_callbacks_->sendLocalReply(
+        Http::Code::BadRequest, "Bad request", nullptr, absl::nullopt,
+        absl::StrCat(RcDetails::get().GrpcTranscodeFailed, "{BAD_REQUEST}"));
+    return false;
+  }
+  *http_body_remaining_ -= data.length();
+  if (!first_request_sent_) {
+    data.prepend(http_body_request_prefix_);
+    first_request_sent_ = true;
+  }
+  return true;
+}
+
 bool JsonTranscoderFilter::buildResponseFromHttpBodyOutput(
     Http::ResponseHeaderMap& response_headers, Buffer::Instance& data) {
   std::vector<Grpc::Frame> frames;
@@ -720,14 +801,17 @@ bool JsonTranscoderFilter::buildResponseFromHttpBodyOutput(
         encoder_callbacks_->resetStream();
         return true;
       }
-      const auto& body = http_body.data();
-
-      data.add(body);
+      const uint64_t body_size = http_body.data().size();
+      if (body_size >= MinHttpBodyFragmentSize) {
+        data.addBufferFragment(*new HttpBodyFragmentImpl(std::move(*http_body.mutable_data())));
+      } else {
+        data.add(http_body.data());
+      }
 
       if (!method_->descriptor_->server_streaming()) {
         // Non streaming case: single message with content type / length
         response_headers.setContentType(http_body.content_type());
-        response_headers.setContentLength(body.size());
+        response_headers.setContentLength(body_size);
         return true;
       } else if (!http_body_response_headers_set_) {
         // Streaming case: set content type only once from first HttpBody message
@@ -14,6 +14,7 @@
 
 #include "extensions/filters/http/grpc_json_transcoder/transcoder_input_stream_impl.h"
 
+#include "absl/types/optional.h"
 #include "grpc_transcoding/path_matcher.h"
 #include "grpc_transcoding/request_message_translator.h"
 #include "grpc_transcoding/transcoder.h"
@@ -167,6 +168,8 @@ private:
   bool checkIfTranscoderFailed(const std::string& details);
   bool readToBuffer(Protobuf::io::ZeroCopyInputStream& stream, Buffer::Instance& data);
   void maybeSendHttpBodyRequestMessage();
+  void startHttpBodyRequestStreaming(uint64_t content_length);
+  bool streamHttpBodyRequestData(Buffer::Instance& data, bool end_stream);
   /**
    * Builds response from HttpBody protobuf.
    * Returns true if at least one gRPC frame has processed.
@@ -193,6 +196,10 @@ private:
   Buffer::OwnedImpl request_data_;
   bool first_request_sent_{false};
   std::string content_type_;
+  // The start of a streamed HttpBody request message, and the number of bytes of its body yet to be
+  // received. Unset unless the length of the body is known up front.
+  Buffer::OwnedImpl http_body_request_prefix_;
+  absl::optional<uint64_t> http_body_remaining_;
 
   bool error_{false};
   bool has_body_{false};
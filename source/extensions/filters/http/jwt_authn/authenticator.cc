@@ -31,10 +31,10 @@ class AuthenticatorImpl : public Logger::Loggable<Logger::Id::jwt>,
 public:
   AuthenticatorImpl(const CheckAudience* check_audience,
                     const absl::optional<std::string>& provider, bool allow_failed,
-                    bool allow_missing, JwksCache& jwks_cache,
+                    bool allow_missing, JwksCache& jwks_cache, TokenCache& token_cache,
                     Upstream::ClusterManager& cluster_manager,
                     CreateJwksFetcherCb create_jwks_fetcher_cb, TimeSource& time_source)
-      : jwks_cache_(jwks_cache), cm_(cluster_manager),
+      : jwks_cache_(jwks_cache), token_cache_(token_cache), cm_(cluster_manager),
         create_jwks_fetcher_cb_(create_jwks_fetcher_cb), check_audience_(check_audience),
         provider_(provider), is_allow_failed_(allow_failed), is_allow_missing_(allow_missing),
         time_source_(time_source) {}
@@ -66,6 +66,8 @@ private:
 
   // The jwks cache object.
   JwksCache& jwks_cache_;
+  // The cache of verified tokens.
+  TokenCache& token_cache_;
   // the cluster manager object.
   Upstream::ClusterManager& cm_;
 
@@ -78,8 +80,11 @@ private:
   // The token data
   std::vector<JwtLocationConstPtr> tokens_;
   JwtLocationConstPtr curr_token_;
-  // The JWT object.
-  std::unique_ptr<::google::jwt_verify::Jwt> jwt_;
+  // The JWT object, which may be shared with the token cache.
+  JwtConstSharedPtr jwt_;
+  // If the token was found in the token cache, the Jwks it was verified with.
+  const JwksCache::JwksData* verified_jwks_data_{};
+  uint64_t verified_jwks_version_{};
   // The JWKS data object
   JwksCache::JwksData* jwks_data_{};
 
@@ -139,11 +144,20 @@ void AuthenticatorImpl::startVerify() {
   curr_token_ = std::move(tokens_.back());
   tokens_.pop_back();
 
-  jwt_ = std::make_unique<::google::jwt_verify::Jwt>();
-  const Status status = jwt_->parseFromString(curr_token_->token());
-  if (status != Status::Ok) {
-    doneWithStatus(status);
-    return;
+  const auto verified = token_cache_.find(curr_token_->token());
+  if (verified.has_value()) {
+    jwt_ = verified->jwt_;
+    verified_jwks_data_ = verified->jwks_data_;
+    verified_jwks_version_ = verified->jwks_version_;
+  } else {
+    auto jwt = std::make_shared<::google::jwt_verify::Jwt>();
+    const Status status = jwt->parseFromString(curr_token_->token());
+    if (status != Status::Ok) {
+      doneWithStatus(status);
+      return;
+    }
+    jwt_ = std::move(jwt);
+    verified_jwks_data_ = nullptr;
   }
 
   ENVOY_LOG(debug, "{}: Verifying JWT token of issuer {}", name(), jwt_->iss_);
@@ -237,10 +251,15 @@ void AuthenticatorImpl::onDestroy() {
 
 // Verify with a specific public key.
 void AuthenticatorImpl::verifyKey() {
-  const Status status = ::google::jwt_verify::verifyJwt(*jwt_, *jwks_data_->getJwksObj());
-  if (status != Status::Ok) {
-    doneWithStatus(status);
-    return;
+  // A cached token is still valid for the Jwks it was verified with, unless the Jwks has been
+  // fetched again since.
+  if (verified_jwks_data_ != jwks_data_ || verified_jwks_version_ != jwks_data_->getJwksVersion()) {
+    const Status status = ::google::jwt_verify::verifyJwt(*jwt_, *jwks_data_->getJwksObj());
+    if (status != Status::Ok) {
+      doneWithStatus(status);
+      return;
+    }
+    token_cache_.insert(curr_token_->token(), {jwt_, jwks_data_, jwks_data_->getJwksVersion()});
   }
 
   // Forward the payload
@@ -293,12 +312,13 @@ void AuthenticatorImpl::doneWithStatus(const Status& status) {
 AuthenticatorPtr Authenticator::create(const CheckAudience* check_audience,
                                        const absl::optional<std::string>& provider,
                                        bool allow_failed, bool allow_missing, JwksCache& jwks_cache,
+                                       TokenCache& token_cache,
                                        Upstream::ClusterManager& cluster_manager,
                                        CreateJwksFetcherCb create_jwks_fetcher_cb,
                                        TimeSource& time_source) {
   return std::make_unique<AuthenticatorImpl>(check_audience, provider, allow_failed, allow_missing,
-                                             jwks_cache, cluster_manager, create_jwks_fetcher_cb,
-                                             time_source);
+                                             jwks_cache, token_cache, cluster_manager,
+                                             create_jwks_fetcher_cb, time_source);
 }
 
 } // namespace JwtAuthn
@@ -14,7 +14,7 @@ void FilterConfigImpl::init() {
   auto shared_this = shared_from_this();
   tls_->set([shared_this](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return std::make_shared<ThreadLocalCache>(shared_this->proto_config_, shared_this->time_source_,
-                                              shared_this->api_);
+                                              shared_this->api_, shared_this->stats_);
   });
 
   for (const auto& rule : proto_config_.rules()) {
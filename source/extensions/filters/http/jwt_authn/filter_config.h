@@ -8,6 +8,8 @@
 #include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/protobuf/utility.h"
+
 #include "extensions/filters/http/jwt_authn/matcher.h"
 #include "extensions/filters/http/jwt_authn/verifier.h"
 
@@ -18,40 +20,52 @@ namespace Extensions {
 namespace HttpFilters {
 namespace JwtAuthn {
 
+/**
+ * All stats for the Jwt Authn filter. @see stats_macros.h
+ */
+#define ALL_JWT_AUTHN_FILTER_STATS(COUNTER)                                                        \
+  COUNTER(allowed)                                                                                 \
+  COUNTER(cors_preflight_bypassed)                                                                 \
+  COUNTER(denied)                                                                                  \
+  COUNTER(token_cache_hit)                                                                         \
+  COUNTER(token_cache_miss)
+
+/**
+ * Wrapper struct for jwt_authn filter stats. @see stats_macros.h
+ */
+struct JwtAuthnFilterStats {
+  ALL_JWT_AUTHN_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+// The default maximum number of verified tokens cached by each worker.
+constexpr uint32_t DefaultTokenCacheSize = 1000;
+
 /**
  * Making cache as a thread local object, its read/write operations don't need to be protected.
- * Now it only has jwks_cache, but in the future, it will have token cache: to cache the tokens
- * with their verification results.
+ * It has the jwks_cache, and the token cache of the tokens verified with its Jwks.
  */
 class ThreadLocalCache : public ThreadLocal::ThreadLocalObject {
 public:
   // Load the config from envoy config.
   ThreadLocalCache(const envoy::extensions::filters::http::jwt_authn::v3::JwtAuthentication& config,
-                   TimeSource& time_source, Api::Api& api) {
+                   TimeSource& time_source, Api::Api& api, JwtAuthnFilterStats& stats)
+      : token_cache_(
+            PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, token_cache_size, DefaultTokenCacheSize),
+            stats.token_cache_hit_, stats.token_cache_miss_) {
     jwks_cache_ = JwksCache::create(config, time_source, api);
   }
 
   // Get the JwksCache object.
   JwksCache& getJwksCache() { return *jwks_cache_; }
 
+  // Get the TokenCache object.
+  TokenCache& getTokenCache() { return token_cache_; }
+
 private:
   // The JwksCache object.
   JwksCachePtr jwks_cache_;
-};
-
-/**
- * All stats for the Jwt Authn filter. @see stats_macros.h
- */
-#define ALL_JWT_AUTHN_FILTER_STATS(COUNTER)                                                        \
-  COUNTER(allowed)                                                                                 \
-  COUNTER(cors_preflight_bypassed)                                                                 \
-  COUNTER(denied)
-
-/**
- * Wrapper struct for jwt_authn filter stats. @see stats_macros.h
- */
-struct JwtAuthnFilterStats {
-  ALL_JWT_AUTHN_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+  // The TokenCache object.
+  TokenCache token_cache_;
 };
 
 /**
@@ -128,8 +142,8 @@ public:
                           const absl::optional<std::string>& provider, bool allow_failed,
                           bool allow_missing) const override {
     return Authenticator::create(check_audience, provider, allow_failed, allow_missing,
-                                 getCache().getJwksCache(), cm(), Common::JwksFetcher::create,
-                                 timeSource());
+                                 getCache().getJwksCache(), getCache().getTokenCache(), cm(),
+                                 Common::JwksFetcher::create, timeSource());
   }
 
 private:
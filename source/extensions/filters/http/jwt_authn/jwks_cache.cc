@@ -59,6 +59,8 @@ public:
 
   bool isExpired() const override { return time_source_.monotonicTime() >= expiration_time_; }
 
+  uint64_t getJwksVersion() const override { return jwks_version_; }
+
   const ::google::jwt_verify::Jwks* setRemoteJwks(::google::jwt_verify::JwksPtr&& jwks) override {
     return setKey(std::move(jwks), getRemoteJwksExpirationTime());
   }
@@ -79,6 +81,7 @@ private:
   const ::google::jwt_verify::Jwks* setKey(::google::jwt_verify::JwksPtr&& jwks,
                                            MonotonicTime expire) {
     jwks_obj_ = std::move(jwks);
+    jwks_version_++;
     expiration_time_ = expire;
     return jwks_obj_.get();
   }
@@ -89,6 +92,8 @@ private:
   ::google::jwt_verify::CheckAudiencePtr audiences_;
   // The generated jwks object.
   ::google::jwt_verify::JwksPtr jwks_obj_;
+  // The version of the jwks object, for the tokens verified with it.
+  uint64_t jwks_version_{};
   TimeSource& time_source_;
   // The pubkey expiration time.
   MonotonicTime expiration_time_;
@@ -55,6 +55,9 @@ public:
     // Return true if jwks object is expired.
     virtual bool isExpired() const PURE;
 
+    // Get the version of the Jwks object, which is increased each time a Jwks is set.
+    virtual uint64_t getJwksVersion() const PURE;
+
     // Set a remote Jwks.
     virtual const ::google::jwt_verify::Jwks*
     setRemoteJwks(::google::jwt_verify::JwksPtr&& jwks) PURE;
@@ -0,0 +1,43 @@
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+absl::optional<TokenCache::VerifiedToken> TokenCache::find(const std::string& token) {
+  if (max_size_ == 0) {
+    return absl::nullopt;
+  }
+  const auto it = entries_.find(token);
+  if (it == entries_.end()) {
+    misses_.inc();
+    return absl::nullopt;
+  }
+  hits_.inc();
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->verified_;
+}
+
+void TokenCache::insert(const std::string& token, VerifiedToken verified) {
+  if (max_size_ == 0) {
+    return;
+  }
+  const auto it = entries_.find(token);
+  if (it != entries_.end()) {
+    it->second->verified_ = std::move(verified);
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return;
+  }
+  if (entries_.size() >= max_size_) {
+    entries_.erase(lru_.back().token_);
+    lru_.pop_back();
+  }
+  lru_.push_front(Entry{token, std::move(verified)});
+  entries_.emplace(lru_.front().token_, lru_.begin());
+}
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/stats/stats.h"
+
+#include "extensions/filters/http/jwt_authn/jwks_cache.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "jwt_verify_lib/jwt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+using JwtConstSharedPtr = std::shared_ptr<const ::google::jwt_verify::Jwt>;
+
+/**
+ * A bounded LRU cache of tokens which passed signature verification, so that a token seen again
+ * is neither parsed nor verified again. It is not thread safe; each worker has its own instance,
+ * next to its JwksCache.
+ *
+ * Only the parsing and the signature verification are cached. The claims of a cached token, such
+ * as its issuer, audiences, "exp" and "nbf", are checked on every request as before. A token is
+ * only considered verified with the same version of the same Jwks it was verified with, so that it
+ * is verified again once the Jwks of its provider has been fetched again.
+ */
+class TokenCache {
+public:
+  /**
+   * @param max_size the maximum number of tokens. 0 disables the cache.
+   * @param hits the counter of lookups which found the token.
+   * @param misses the counter of lookups which didn't.
+   */
+  TokenCache(uint32_t max_size, Stats::Counter& hits, Stats::Counter& misses)
+      : max_size_(max_size), hits_(hits), misses_(misses) {}
+
+  struct VerifiedToken {
+    // The parsed token.
+    JwtConstSharedPtr jwt_;
+    // The Jwks the token was verified with, and its version at the time.
+    const JwksCache::JwksData* jwks_data_;
+    uint64_t jwks_version_;
+  };
+
+  /**
+   * Looks up a token, and makes it the most recently used one.
+   * @param token the token, as extracted from the request.
+   * @return the cached token, if any. It is a copy, which stays valid as the cache changes.
+   */
+  absl::optional<VerifiedToken> find(const std::string& token);
+
+  /**
+   * Adds or replaces a verified token, evicting the least recently used one if the cache is full.
+   */
+  void insert(const std::string& token, VerifiedToken verified);
+
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    std::string token_;
+    VerifiedToken verified_;
+  };
+  using EntryList = std::list<Entry>;
+
+  const uint32_t max_size_;
+  Stats::Counter& hits_;
+  Stats::Counter& misses_;
+  // Most recently used tokens are at the front of the list.
+  EntryList lru_;
+  // Keyed by the token itself rather than a digest of it, so that two tokens can never share an
+  // entry. The keys point into lru_.
+  absl::flat_hash_map<absl::string_view, EntryList::iterator> entries_;
+};
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
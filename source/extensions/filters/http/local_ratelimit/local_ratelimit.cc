@@ -0,0 +1,150 @@
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+#include <chrono>
+
+#include "common/http/utility.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/filters/http/well_known_names.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+namespace {
+
+struct RcDetailsValues {
+  // The local rate limit filter rate limited the request.
+  const std::string RateLimited = "local_rate_limited";
+};
+using RcDetails = ConstSingleton<RcDetailsValues>;
+
+} // namespace
+
+FilterConfig::FilterConfig(
+    const envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit& config,
+    const LocalInfo::LocalInfo& local_info, TimeSource& time_source, Stats::Scope& scope,
+    Runtime::Loader& runtime)
+    : local_info_(local_info),
+      status_(config.has_status() ? static_cast<Http::Code>(config.status().code())
+                                  : Http::Code::TooManyRequests),
+      stage_(config.stage()), enabled_(config.runtime_enabled(), runtime),
+      stats_(generateStats(config.stat_prefix(), scope)),
+      token_bucket_(createTokenBucket(config.token_bucket(), time_source)) {
+  for (const auto& descriptor : config.descriptors()) {
+    Descriptor& new_descriptor = descriptors_.emplace_back();
+    for (const auto& entry : descriptor.entries()) {
+      new_descriptor.entries_.push_back({entry.key(), entry.value()});
+    }
+    new_descriptor.token_bucket_ = createTokenBucket(descriptor.token_bucket(), time_source);
+  }
+}
+
+LocalRateLimitStats FilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  const std::string final_prefix = absl::StrCat("http_local_rate_limit.", prefix, ".");
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+std::unique_ptr<AtomicTokenBucketImpl>
+FilterConfig::createTokenBucket(const envoy::type::v3::TokenBucket& config,
+                                TimeSource& time_source) {
+  const uint32_t tokens_per_fill = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, tokens_per_fill, 1);
+  const std::chrono::duration<double> fill_interval =
+      std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(config, fill_interval));
+  // The tokens of each fill interval are added continuously over the interval rather than all at
+  // once, which lets consumers refill the bucket without a timer.
+  return std::make_unique<AtomicTokenBucketImpl>(config.max_tokens(), time_source,
+                                                 tokens_per_fill / fill_interval.count());
+}
+
+bool FilterConfig::matches(const Descriptor& descriptor,
+                           const RateLimit::Descriptor& request_descriptor) {
+  if (descriptor.entries_.size() != request_descriptor.entries_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < descriptor.entries_.size(); i++) {
+    if (descriptor.entries_[i].key_ != request_descriptor.entries_[i].key_ ||
+        descriptor.entries_[i].value_ != request_descriptor.entries_[i].value_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FilterConfig::requestAllowed(
+    const std::vector<RateLimit::Descriptor>& request_descriptors) const {
+  for (const Descriptor& descriptor : descriptors_) {
+    for (const RateLimit::Descriptor& request_descriptor : request_descriptors) {
+      if (matches(descriptor, request_descriptor)) {
+        return descriptor.token_bucket_->consume(1, false) == 1;
+      }
+    }
+  }
+  return token_bucket_->consume(1, false) == 1;
+}
+
+Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers, bool) {
+  const FilterConfig& config = getConfig();
+  if (!config.enabled()) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  config.stats().enabled_.inc();
+
+  std::vector<RateLimit::Descriptor> descriptors;
+  if (config.hasDescriptors()) {
+    populateDescriptors(config, headers, descriptors);
+  }
+
+  if (config.requestAllowed(descriptors)) {
+    config.stats().ok_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  config.stats().rate_limited_.inc();
+  ENVOY_STREAM_LOG(trace, "local_rate_limit: rate limiting request", *decoder_callbacks_);
+  decoder_callbacks_->sendLocalReply(config.status(), "local_rate_limited", nullptr, absl::nullopt,
+                                     RcDetails::get().RateLimited);
+  decoder_callbacks_->streamInfo().setResponseFlag(StreamInfo::ResponseFlag::RateLimited);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+const FilterConfig& Filter::getConfig() const {
+  const auto* route_config = Http::Utility::resolveMostSpecificPerFilterConfig<FilterConfig>(
+      HttpFilterNames::get().LocalRateLimit, decoder_callbacks_->route());
+  return route_config != nullptr ? *route_config : *config_;
+}
+
+void Filter::populateDescriptors(const FilterConfig& config,
+                                 const Http::RequestHeaderMap& headers,
+                                 std::vector<RateLimit::Descriptor>& descriptors) const {
+  Router::RouteConstSharedPtr route = decoder_callbacks_->route();
+  if (route == nullptr || route->routeEntry() == nullptr) {
+    return;
+  }
+  const Router::RouteEntry* route_entry = route->routeEntry();
+  const Network::Address::Instance& remote_address =
+      *decoder_callbacks_->streamInfo().downstreamRemoteAddress();
+
+  for (const Router::RateLimitPolicyEntry& rate_limit :
+       route_entry->rateLimitPolicy().getApplicableRateLimit(config.stage())) {
+    rate_limit.populateDescriptors(*route_entry, descriptors, config.localInfo().clusterName(),
+                                   headers, remote_address,
+                                   &decoder_callbacks_->streamInfo().dynamicMetadata());
+  }
+  if (route_entry->includeVirtualHostRateLimits()) {
+    for (const Router::RateLimitPolicyEntry& rate_limit :
+         route_entry->virtualHost().rateLimitPolicy().getApplicableRateLimit(config.stage())) {
+      rate_limit.populateDescriptors(*route_entry, descriptors, config.localInfo().clusterName(),
+                                     headers, remote_address,
+                                     &decoder_callbacks_->streamInfo().dynamicMetadata());
+    }
+  }
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/extensions/filters/http/local_ratelimit/v3/local_rate_limit.pb.h"
+#include "envoy/http/codes.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/router/router.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/atomic_token_bucket_impl.h"
+#include "common/common/logger.h"
+#include "common/runtime/runtime_protos.h"
+
+#include "extensions/filters/http/common/pass_through_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * All local rate limit stats. @see stats_macros.h
+ */
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                        \
+  COUNTER(enabled)                                                                                 \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+
+/**
+ * Struct definition for all local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration of the filter, or of a route. Its token buckets are shared by all the workers,
+ * which consume from them without a lock. Must be thread safe.
+ */
+class FilterConfig : public Router::RouteSpecificFilterConfig {
+public:
+  FilterConfig(const envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit& config,
+               const LocalInfo::LocalInfo& local_info, TimeSource& time_source,
+               Stats::Scope& scope, Runtime::Loader& runtime);
+
+  bool enabled() const { return enabled_.enabled(); }
+  Http::Code status() const { return status_; }
+  uint64_t stage() const { return stage_; }
+  bool hasDescriptors() const { return !descriptors_.empty(); }
+  const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
+  LocalRateLimitStats& stats() const { return stats_; }
+
+  /**
+   * Consumes a token for a request, from the bucket of the first configured descriptor which is
+   * among the descriptors of the request, or from the default bucket if there is none.
+   * @param request_descriptors supplies the descriptors generated for the request.
+   * @return whether a token was available, i.e. whether the request is allowed.
+   */
+  bool requestAllowed(const std::vector<RateLimit::Descriptor>& request_descriptors) const;
+
+private:
+  struct Descriptor {
+    std::vector<RateLimit::DescriptorEntry> entries_;
+    std::unique_ptr<AtomicTokenBucketImpl> token_bucket_;
+  };
+
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+  static std::unique_ptr<AtomicTokenBucketImpl>
+  createTokenBucket(const envoy::type::v3::TokenBucket& config, TimeSource& time_source);
+  static bool matches(const Descriptor& descriptor,
+                      const RateLimit::Descriptor& request_descriptor);
+
+  const LocalInfo::LocalInfo& local_info_;
+  const Http::Code status_;
+  const uint64_t stage_;
+  const Runtime::FeatureFlag enabled_;
+  mutable LocalRateLimitStats stats_;
+  const std::unique_ptr<AtomicTokenBucketImpl> token_bucket_;
+  std::vector<Descriptor> descriptors_;
+};
+
+using FilterConfigSharedPtr = std::shared_ptr<FilterConfig>;
+
+/**
+ * HTTP local rate limit filter. Rate limits requests with the token buckets of the configuration
+ * of their route if it has one, and with those of the filter configuration otherwise.
+ */
+class Filter : public Http::PassThroughDecoderFilter, Logger::Loggable<Logger::Id::filter> {
+public:
+  Filter(const FilterConfigSharedPtr& config) : config_(config) {}
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& headers,
+                                          bool end_stream) override;
+
+private:
+  const FilterConfig& getConfig() const;
+  void populateDescriptors(const FilterConfig& config, const Http::RequestHeaderMap& headers,
+                           std::vector<RateLimit::Descriptor>& descriptors) const;
+
+  const FilterConfigSharedPtr config_;
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,50 @@
+#include "extensions/filters/http/wasm/config.h"
+
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.h"
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
+
+#include "extensions/filters/http/wasm/wasm_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(wasm_module_cache);
+
+Http::FilterFactoryCb WasmFilterConfig::createFilterFactoryFromProtoTyped(
+    const envoy::extensions::filters::http::wasm::v3::Wasm& proto_config, const std::string&,
+    Server::Configuration::FactoryContext& context) {
+  auto module_cache =
+      context.singletonManager().getTyped<Extensions::Common::Wasm::WasmModuleCache>(
+          SINGLETON_MANAGER_REGISTERED_NAME(wasm_module_cache), [&context] {
+            return std::make_shared<Extensions::Common::Wasm::WasmModuleCache>(
+                context.getServerFactoryContext().scope(), context.api());
+          });
+  auto filter_config = std::make_shared<FilterConfig>(proto_config, std::move(module_cache),
+                                                      context.threadLocal(), context.api());
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    WasmSharedPtr wasm = filter_config->wasm();
+    if (wasm == nullptr) {
+      // The module could not be started on this worker.
+      if (!filter_config->failOpen()) {
+        callbacks.addStreamDecoderFilter(std::make_shared<UnavailableFilter>());
+      }
+      return;
+    }
+    callbacks.addStreamFilter(std::make_shared<Filter>(filter_config, std::move(wasm)));
+  };
+}
+
+/**
+ * Static registration for the Wasm filter. @see RegisterFactory.
+ */
+REGISTER_FACTORY(WasmFilterConfig, Server::Configuration::NamedHttpFilterConfigFactory);
+
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.h"
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.validate.h"
+
+#include "extensions/filters/http/common/factory_base.h"
+#include "extensions/filters/http/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+
+/**
+ * Config registration for the Wasm filter. @see NamedHttpFilterConfigFactory.
+ */
+class WasmFilterConfig
+    : public Common::FactoryBase<envoy::extensions::filters::http::wasm::v3::Wasm> {
+public:
+  WasmFilterConfig() : FactoryBase(HttpFilterNames::get().Wasm) {}
+
+private:
+  Http::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoy::extensions::filters::http::wasm::v3::Wasm& proto_config, const std::string&,
+      Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
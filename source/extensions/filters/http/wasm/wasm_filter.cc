@@ -0,0 +1,200 @@
+#include "extensions/filters/http/wasm/wasm_filter.h"
+
+#include "envoy/http/codes.h"
+
+#include "common/common/assert.h"
+#include "common/config/datasource.h"
+#include "common/protobuf/utility.h"
+#include "common/singleton/const_singleton.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+
+namespace {
+
+struct HttpResponseCodeDetailValues {
+  const absl::string_view WasmResponse = "wasm_response";
+  const absl::string_view WasmFailed = "wasm_failed";
+};
+using HttpResponseCodeDetails = ConstSingleton<HttpResponseCodeDetailValues>;
+
+// Returns the configuration as passed to the module: Struct is serialized as JSON, BytesValue and
+// StringValue are passed without the wrapper.
+std::string configurationToString(const ProtobufWkt::Any& configuration) {
+  if (configuration.type_url().empty()) {
+    return "";
+  }
+  if (configuration.Is<ProtobufWkt::StringValue>()) {
+    ProtobufWkt::StringValue value;
+    configuration.UnpackTo(&value);
+    return value.value();
+  }
+  if (configuration.Is<ProtobufWkt::BytesValue>()) {
+    ProtobufWkt::BytesValue value;
+    configuration.UnpackTo(&value);
+    return value.value();
+  }
+  if (configuration.Is<ProtobufWkt::Struct>()) {
+    ProtobufWkt::Struct value;
+    configuration.UnpackTo(&value);
+    return MessageUtil::getJsonStringFromMessage(value);
+  }
+  throw EnvoyException(fmt::format("Wasm filter: unsupported configuration type {}",
+                                   configuration.type_url()));
+}
+
+void sendUnavailable(Http::StreamDecoderFilterCallbacks& callbacks) {
+  callbacks.sendLocalReply(Http::Code::ServiceUnavailable, "", nullptr, absl::nullopt,
+                           HttpResponseCodeDetails::get().WasmFailed);
+}
+
+} // namespace
+
+FilterConfig::FilterConfig(const envoy::extensions::filters::http::wasm::v3::Wasm& proto_config,
+                           WasmModuleCacheSharedPtr module_cache, ThreadLocal::SlotAllocator& tls,
+                           Api::Api& api)
+    : fail_open_(proto_config.config().fail_open()), module_cache_(std::move(module_cache)),
+      tls_slot_(tls.allocateSlot()) {
+  const auto& plugin_config = proto_config.config();
+  const auto& vm_config = plugin_config.inline_vm_config();
+  if (!vm_config.code().has_local()) {
+    throw EnvoyException("Wasm filter: only local code is supported");
+  }
+  // For the null runtime, the code is the name of the plugin.
+  const std::string code = Config::DataSource::read(vm_config.code().local(), false, api);
+  module_ = module_cache_->getOrLoad(vm_config.runtime(), code, vm_config.allow_precompiled(),
+                                     vm_config.compiled_module_cache_directory());
+
+  const std::string name = plugin_config.name();
+  const std::string vm_configuration = configurationToString(vm_config.configuration());
+  const std::string plugin_configuration = configurationToString(plugin_config.configuration());
+
+  // Start an instance on the main thread first, so that a module which can't start, or rejects
+  // its configuration, rejects the filter configuration.
+  createWasm(*module_, name, vm_configuration, plugin_configuration, api.timeSource());
+
+  WasmModuleSharedPtr module = module_;
+  tls_slot_->set([module, name, vm_configuration,
+                  plugin_configuration](Event::Dispatcher& dispatcher) {
+    WasmSharedPtr wasm;
+    try {
+      wasm = createWasm(*module, name, vm_configuration, plugin_configuration,
+                        dispatcher.timeSource());
+    } catch (const EnvoyException& e) {
+      ENVOY_LOG(critical, "Wasm filter {}: cannot start the module: {}", name, e.what());
+    }
+    return std::make_shared<ThreadLocalWasm>(std::move(wasm));
+  });
+}
+
+WasmSharedPtr FilterConfig::createWasm(const WasmModule& module, const std::string& name,
+                                       const std::string& vm_configuration,
+                                       const std::string& plugin_configuration,
+                                       TimeSource& time_source) {
+  auto wasm = std::make_shared<Extensions::Common::Wasm::Wasm>(
+      module.createVm(), vm_configuration, plugin_configuration, time_source);
+  wasm->initialize(name);
+  return wasm;
+}
+
+Http::FilterHeadersStatus UnavailableFilter::decodeHeaders(Http::RequestHeaderMap&, bool) {
+  sendUnavailable(*decoder_callbacks_);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+Filter::Filter(const FilterConfigSharedPtr& config, WasmSharedPtr wasm)
+    : Context(*wasm, wasm->rootContextId()), config_(config), wasm_(std::move(wasm)) {}
+
+void Filter::createContext() {
+  if (!context_created_) {
+    context_created_ = true;
+    wasm_->onContextCreate(*this);
+  }
+}
+
+Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
+                                                bool end_stream) {
+  request_headers_ = &headers;
+  createContext();
+  return doHeaders(wasm_->onRequestHeaders(*this, headers.size(), end_stream));
+}
+
+Http::FilterHeadersStatus Filter::encodeHeaders(Http::ResponseHeaderMap& headers,
+                                                bool end_stream) {
+  response_headers_ = &headers;
+  createContext();
+  return doHeaders(wasm_->onResponseHeaders(*this, headers.size(), end_stream));
+}
+
+Http::FilterHeadersStatus Filter::doHeaders(Extensions::Common::Wasm::FilterHeadersStatus status) {
+  if (local_response_sent_) {
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+  if (wasm_->failed()) {
+    if (config_->failOpen()) {
+      return Http::FilterHeadersStatus::Continue;
+    }
+    sendUnavailable(*decoder_callbacks_);
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+  // Streaming the body to the module isn't supported, so the module can't resume a stopped
+  // stream. Stopping iteration only makes sense after sending a local response.
+  if (status == Extensions::Common::Wasm::FilterHeadersStatus::StopIteration) {
+    ENVOY_LOG(debug, "Wasm filter {}: ignoring StopIteration without a local response",
+              wasm_->debugName());
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+void Filter::onDestroy() {
+  if (context_created_) {
+    wasm_->onDone(*this);
+  }
+}
+
+Http::HeaderMap* Filter::getMap(WasmHeaderMapType type) {
+  switch (type) {
+  case WasmHeaderMapType::RequestHeaders:
+    return request_headers_;
+  case WasmHeaderMapType::RequestTrailers:
+    return request_trailers_;
+  case WasmHeaderMapType::ResponseHeaders:
+    return response_headers_;
+  case WasmHeaderMapType::ResponseTrailers:
+    return response_trailers_;
+  }
+  return nullptr;
+}
+
+WasmResult Filter::sendLocalResponse(uint32_t status, absl::string_view body,
+                                     std::vector<std::pair<std::string, std::string>> headers,
+                                     absl::optional<uint32_t> grpc_status,
+                                     absl::string_view details) {
+  if (local_response_sent_ || status < 200 || status > 599 ||
+      (grpc_status.has_value() &&
+       grpc_status.value() > Grpc::Status::WellKnownGrpcStatus::MaximumKnown)) {
+    return WasmResult::BadArgument;
+  }
+  local_response_sent_ = true;
+  auto modify_headers = [headers = std::move(headers)](Http::ResponseHeaderMap& response_headers) {
+    for (const auto& header : headers) {
+      response_headers.addCopy(Http::LowerCaseString(header.first), header.second);
+    }
+  };
+  absl::optional<Grpc::Status::GrpcStatus> grpc_status_code;
+  if (grpc_status.has_value()) {
+    grpc_status_code = static_cast<Grpc::Status::GrpcStatus>(grpc_status.value());
+  }
+  decoder_callbacks_->sendLocalReply(static_cast<Http::Code>(status), body, modify_headers,
+                                     grpc_status_code,
+                                     details.empty() ? HttpResponseCodeDetails::get().WasmResponse
+                                                     : details);
+  return WasmResult::Ok;
+}
+
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
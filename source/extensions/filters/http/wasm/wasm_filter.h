@@ -0,0 +1,156 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/common/wasm/wasm.h"
+#include "extensions/common/wasm/wasm_module_cache.h"
+#include "extensions/filters/http/common/pass_through_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+
+using Envoy::Extensions::Common::Wasm::Context;
+using Envoy::Extensions::Common::Wasm::WasmHeaderMapType;
+using Envoy::Extensions::Common::Wasm::WasmModule;
+using Envoy::Extensions::Common::Wasm::WasmModuleCacheSharedPtr;
+using Envoy::Extensions::Common::Wasm::WasmModuleSharedPtr;
+using Envoy::Extensions::Common::Wasm::WasmResult;
+using Envoy::Extensions::Common::Wasm::WasmSharedPtr;
+
+/**
+ * Global configuration for the filter. The module is loaded through the module cache, and each
+ * worker runs its own instance of it, created from the loaded module.
+ */
+class FilterConfig : Logger::Loggable<Logger::Id::wasm> {
+public:
+  /**
+   * Throws EnvoyException if the module can't be loaded, or rejects its configuration.
+   */
+  FilterConfig(const envoy::extensions::filters::http::wasm::v3::Wasm& proto_config,
+               WasmModuleCacheSharedPtr module_cache,
+               ThreadLocal::SlotAllocator& tls, Api::Api& api);
+
+  /**
+   * @return the instance of the module of the current worker, or nullptr if it could not be
+   *         created.
+   */
+  WasmSharedPtr wasm() const { return tls_slot_->getTyped<ThreadLocalWasm>().wasm_; }
+
+  bool failOpen() const { return fail_open_; }
+
+private:
+  struct ThreadLocalWasm : public ThreadLocal::ThreadLocalObject {
+    explicit ThreadLocalWasm(WasmSharedPtr wasm) : wasm_(std::move(wasm)) {}
+
+    const WasmSharedPtr wasm_;
+  };
+
+  static WasmSharedPtr createWasm(const WasmModule& module, const std::string& name,
+                                  const std::string& vm_configuration,
+                                  const std::string& plugin_configuration,
+                                  TimeSource& time_source);
+
+  const bool fail_open_;
+  // Keeps the cache alive, so that configuration reloads find the module in it.
+  const WasmModuleCacheSharedPtr module_cache_;
+  WasmModuleSharedPtr module_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+using FilterConfigSharedPtr = std::shared_ptr<FilterConfig>;
+
+/**
+ * Replies 503 to all requests. Installed instead of the filter when the module has no instance on
+ * the worker and the filter fails closed.
+ */
+class UnavailableFilter : public Http::PassThroughDecoderFilter {
+public:
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& headers,
+                                          bool end_stream) override;
+};
+
+/**
+ * The HTTP Wasm filter. Each stream is a context of the instance of the module of the worker.
+ */
+class Filter : public Http::StreamFilter, public Context {
+public:
+  Filter(const FilterConfigSharedPtr& config, WasmSharedPtr wasm);
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& headers,
+                                          bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::RequestTrailerMap& trailers) override {
+    request_trailers_ = &trailers;
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::ResponseHeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::ResponseHeaderMap& headers,
+                                          bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus encodeTrailers(Http::ResponseTrailerMap& trailers) override {
+    response_trailers_ = &trailers;
+    return Http::FilterTrailersStatus::Continue;
+  }
+  Http::FilterMetadataStatus encodeMetadata(Http::MetadataMap&) override {
+    return Http::FilterMetadataStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+  // Common::Wasm::Context
+  Http::HeaderMap* getMap(WasmHeaderMapType type) override;
+  WasmResult sendLocalResponse(uint32_t status, absl::string_view body,
+                               std::vector<std::pair<std::string, std::string>> headers,
+                               absl::optional<uint32_t> grpc_status,
+                               absl::string_view details) override;
+
+private:
+  Http::FilterHeadersStatus doHeaders(Extensions::Common::Wasm::FilterHeadersStatus status);
+  void createContext();
+
+  const FilterConfigSharedPtr config_;
+  // Keeps the instance alive for the stream, if the configuration is removed meanwhile.
+  const WasmSharedPtr wasm_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  Http::RequestHeaderMap* request_headers_{};
+  Http::RequestTrailerMap* request_trailers_{};
+  Http::ResponseHeaderMap* response_headers_{};
+  Http::ResponseTrailerMap* response_trailers_{};
+  bool context_created_{};
+  bool local_response_sent_{};
+};
+
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -44,6 +44,8 @@ public:
   const std::string IpTagging = "envoy.filters.http.ip_tagging";
   // Rate limit filter
   const std::string RateLimit = "envoy.filters.http.ratelimit";
+  // Local rate limit filter
+  const std::string LocalRateLimit = "envoy.filters.http.local_ratelimit";
   // Router filter
   const std::string Router = "envoy.filters.http.router";
   // Health checking filter
@@ -78,6 +80,8 @@ public:
   const std::string AwsRequestSigning = "envoy.filters.http.aws_request_signing";
   // AWS Lambda filter
   const std::string AwsLambda = "envoy.filters.http.aws_lambda";
+  // Wasm filter
+  const std::string Wasm = "envoy.filters.http.wasm";
 };
 
 using HttpFilterNames = ConstSingleton<HttpFilterNameValues>;
@@ -443,6 +443,12 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
 
+  if (config.has_filter_timing()) {
+    filter_timing_ = std::make_unique<Http::FilterTimingConfig>(
+        config.filter_timing().sampling(), stats_prefix_, context_.scope(), context_.runtime(),
+        context_.dispatcher().timeSource());
+  }
+
   const auto& filters = config.http_filters();
   for (int32_t i = 0; i < filters.size(); i++) {
     processFilter(filters[i], i, "http", filter_factories_, "http", i == filters.size() - 1);
@@ -478,6 +484,9 @@ void HttpConnectionManagerConfig::processFilter(
     int i, absl::string_view prefix, FilterFactoriesList& filter_factories,
     const char* filter_chain_type, bool last_filter_in_current_config) {
   ENVOY_LOG(debug, "    {} filter #{}", prefix, i);
+  if (filter_timing_ != nullptr) {
+    filter_timing_->registerFilter(proto_config.name());
+  }
   if (proto_config.config_type_case() ==
       envoy::extensions::filters::network::http_connection_manager::v3::HttpFilter::ConfigTypeCase::
           kConfigDiscovery) {
@@ -609,11 +618,23 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
 
 void HttpConnectionManagerConfig::createFilterChainForFactories(
     Http::FilterChainFactoryCallbacks& callbacks, const FilterFactoriesList& filter_factories) {
+  // The filters of sampled streams are wrapped to time their callbacks.
+  absl::optional<Http::TimedFilterChainFactoryCallbacks> timed_callbacks;
+  if (filter_timing_ != nullptr && filter_timing_->sampleStream()) {
+    timed_callbacks.emplace(callbacks, filter_timing_->timeSource());
+  }
+
   bool added_missing_config_filter = false;
   for (const auto& filter_config_provider : filter_factories) {
     auto config = filter_config_provider->config();
     if (config.has_value()) {
-      config.value()(callbacks);
+      if (timed_callbacks.has_value()) {
+        timed_callbacks->setFilterStats(
+            filter_timing_->statsForFilter(filter_config_provider->name()));
+        config.value()(timed_callbacks.value());
+      } else {
+        config.value()(callbacks);
+      }
       continue;
     }
 
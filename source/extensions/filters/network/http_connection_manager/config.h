@@ -20,6 +20,7 @@
 #include "common/common/logger.h"
 #include "common/http/conn_manager_impl.h"
 #include "common/http/date_provider_impl.h"
+#include "common/http/filter_timing.h"
 #include "common/http/http1/codec_stats.h"
 #include "common/http/http2/codec_stats.h"
 #include "common/json/json_loader.h"
@@ -250,6 +251,7 @@ private:
   const envoy::config::core::v3::HttpProtocolOptions::HeadersWithUnderscoresAction
       headers_with_underscores_action_;
   const LocalReply::LocalReplyPtr local_reply_;
+  Http::FilterTimingConfigPtr filter_timing_;
 
   // Default idle timeout is 5 minutes if nothing is specified in the HCM config.
   static const uint64_t StreamIdleTimeoutMs = 5 * 60 * 1000;
@@ -14,13 +14,17 @@ namespace DnsFilter {
 
 static constexpr std::chrono::milliseconds DEFAULT_RESOLVER_TIMEOUT{500};
 static constexpr std::chrono::seconds DEFAULT_RESOLVER_TTL{300};
+static constexpr uint64_t DEFAULT_MAX_CACHED_RESPONSES{1024};
+static constexpr std::chrono::seconds DEFAULT_NEGATIVE_CACHE_TTL{30};
 
 DnsFilterEnvoyConfig::DnsFilterEnvoyConfig(
     Server::Configuration::ListenerFactoryContext& context,
     const envoy::extensions::filters::udp::dns_filter::v3alpha::DnsFilterConfig& config)
     : root_scope_(context.scope()), cluster_manager_(context.clusterManager()), api_(context.api()),
       stats_(generateStats(config.stat_prefix(), root_scope_)),
-      resolver_timeout_(DEFAULT_RESOLVER_TIMEOUT), random_(context.random()) {
+      resolver_timeout_(DEFAULT_RESOLVER_TIMEOUT), random_(context.random()),
+      cache_responses_(false), max_cached_responses_(DEFAULT_MAX_CACHED_RESPONSES),
+      negative_cache_ttl_(DEFAULT_NEGATIVE_CACHE_TTL) {
   using envoy::extensions::filters::udp::dns_filter::v3alpha::DnsFilterConfig;
 
   const auto& server_config = config.server_config();
@@ -87,6 +91,19 @@ DnsFilterEnvoyConfig::DnsFilterEnvoyConfig(
         client_config, resolver_timeout, DEFAULT_RESOLVER_TIMEOUT.count()));
 
     max_pending_lookups_ = client_config.max_pending_lookups();
+
+    cache_responses_ = client_config.has_response_cache();
+    if (cache_responses_) {
+      const auto& cache_config = client_config.response_cache();
+      max_cached_responses_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, max_entries,
+                                                              DEFAULT_MAX_CACHED_RESPONSES);
+      if (cache_config.has_max_ttl()) {
+        max_cache_ttl_ = std::chrono::seconds(cache_config.max_ttl().seconds());
+      }
+      if (cache_config.has_negative_ttl()) {
+        negative_cache_ttl_ = std::chrono::seconds(cache_config.negative_ttl().seconds());
+      }
+    }
   }
 }
 
@@ -125,11 +142,14 @@ DnsFilter::DnsFilter(Network::UdpReadFilterCallbacks& callbacks,
       cluster_manager_(config_->clusterManager()),
       message_parser_(config->forwardQueries(), listener_.dispatcher().timeSource(),
                       config->retryCount(), config->random(),
-                      config_->stats().downstream_rx_query_latency_) {
+                      config_->stats().downstream_rx_query_latency_),
+      response_cache_counters_(config_->stats().cache_hits_, config_->stats().cache_negative_hits_,
+                               config_->stats().cache_misses_, config_->stats().cache_insertions_,
+                               config_->stats().cache_evictions_) {
   // This callback is executed when the dns resolution completes. At that time of a response by the
   // resolver, we build an answer record from each IP returned then send a response to the client
   resolver_callback_ = [this](DnsQueryContextPtr context, const DnsQueryRecord* query,
-                              AddressConstPtrVec& iplist) -> void {
+                              std::list<Network::DnsResponse>& response) -> void {
     if (context->resolution_status_ != Network::DnsResolver::ResolutionStatus::Success &&
         context->retry_ > 0) {
       --context->retry_;
@@ -140,19 +160,37 @@ DnsFilter::DnsFilter(Network::UdpReadFilterCallbacks& callbacks,
     }
 
     config_->stats().externally_resolved_queries_.inc();
-    if (iplist.empty()) {
+    if (response.empty()) {
       config_->stats().unanswered_queries_.inc();
     }
 
+    // Externally resolved answers keep the TTL of the upstream answers, so that neither the client
+    // nor the response cache holds them longer than the upstream resolvers allow
     incrementExternalQueryTypeCount(query->type_);
-    for (const auto& ip : iplist) {
+    for (const auto& resp : response) {
       incrementExternalQueryTypeAnswerCount(query->type_);
-      const std::chrono::seconds ttl = getDomainTTL(query->name_);
-      message_parser_.buildDnsAnswerRecord(context, *query, ttl, std::move(ip));
+      message_parser_.buildDnsAnswerRecord(context, *query, resp.ttl_, resp.address_);
     }
-    sendDnsResponse(std::move(context));
+
+    if (response_cache_ == nullptr) {
+      sendDnsResponse(std::move(context));
+      return;
+    }
+
+    // Keep a copy of the serialized response so that subsequent queries for the same name are
+    // answered without resolving or serializing it again
+    Buffer::OwnedImpl response;
+    message_parser_.buildResponseBuffer(context, response);
+    response_cache_->insert(*context, response);
+    sendResponseBuffer(*context, response);
   };
 
+  if (config->cacheResponses()) {
+    response_cache_ = std::make_unique<DnsResponseCache>(
+        listener_.dispatcher().timeSource(), response_cache_counters_, config->maxCachedResponses(),
+        config->maxCacheTtl(), config->negativeCacheTtl());
+  }
+
   resolver_ = std::make_unique<DnsFilterResolver>(resolver_callback_, config->resolvers(),
                                                   config->resolverTimeout(), listener_.dispatcher(),
                                                   config->maxPendingLookups());
@@ -187,8 +225,8 @@ void DnsFilter::onData(Network::UdpRecvData& client_request) {
   }
 
   // Externally resolved. We'll respond to the client when the external DNS resolution callback
-  // is executed
-  if (response == DnsLookupResponseCode::External) {
+  // is executed. A response from the cache has already been sent.
+  if (response == DnsLookupResponseCode::External || response == DnsLookupResponseCode::Cached) {
     return;
   }
 
@@ -202,13 +240,30 @@ void DnsFilter::sendDnsResponse(DnsQueryContextPtr query_context) {
   // Serializes the generated response to the parsed query from the client. If there is a
   // parsing error or the incoming query is invalid, we will still generate a valid DNS response
   message_parser_.buildResponseBuffer(query_context, response);
+  sendResponseBuffer(*query_context, response);
+}
+
+void DnsFilter::sendResponseBuffer(const DnsQueryContext& context, Buffer::OwnedImpl& response) {
   config_->stats().downstream_tx_responses_.inc();
   config_->stats().downstream_tx_bytes_.recordValue(response.length());
-  Network::UdpSendData response_data{query_context->local_->ip(), *(query_context->peer_),
-                                     response};
+  Network::UdpSendData response_data{context.local_->ip(), *(context.peer_), response};
   listener_.send(response_data);
 }
 
+bool DnsFilter::sendCachedResponse(const DnsQueryContext& context) {
+  // Only responses to single question queries are cached
+  if (response_cache_ == nullptr || context.queries_.size() != 1) {
+    return false;
+  }
+
+  Buffer::OwnedImpl response;
+  if (!response_cache_->lookup(context, response)) {
+    return false;
+  }
+  sendResponseBuffer(context, response);
+  return true;
+}
+
 DnsLookupResponseCode DnsFilter::getResponseForQuery(DnsQueryContextPtr& context) {
   /* It appears to be a rare case where we would have more than one query in a single request.
    * It is allowed by the protocol but not widely supported:
@@ -234,6 +289,11 @@ DnsLookupResponseCode DnsFilter::getResponseForQuery(DnsQueryContextPtr& context
       }
     }
 
+    if (sendCachedResponse(*context)) {
+      ENVOY_LOG(debug, "answered query for name [{}] from the response cache", query->name_);
+      return DnsLookupResponseCode::Cached;
+    }
+
     ENVOY_LOG(debug, "resolving name [{}] via external resolvers", query->name_);
     resolver_->resolveExternalQuery(std::move(context), query.get());
 
@@ -12,6 +12,7 @@
 
 #include "extensions/filters/udp/dns_filter/dns_filter_resolver.h"
 #include "extensions/filters/udp/dns_filter/dns_parser.h"
+#include "extensions/filters/udp/dns_filter/dns_response_cache.h"
 
 #include "absl/container/flat_hash_set.h"
 
@@ -26,6 +27,11 @@ namespace DnsFilter {
 #define ALL_DNS_FILTER_STATS(COUNTER, HISTOGRAM)                                                   \
   COUNTER(a_record_queries)                                                                        \
   COUNTER(aaaa_record_queries)                                                                     \
+  COUNTER(cache_evictions)                                                                         \
+  COUNTER(cache_hits)                                                                              \
+  COUNTER(cache_insertions)                                                                        \
+  COUNTER(cache_misses)                                                                            \
+  COUNTER(cache_negative_hits)                                                                     \
   COUNTER(cluster_a_record_answers)                                                                \
   COUNTER(cluster_aaaa_record_answers)                                                             \
   COUNTER(cluster_unsupported_answers)                                                             \
@@ -89,6 +95,10 @@ public:
   uint64_t retryCount() const { return retry_count_; }
   Random::RandomGenerator& random() const { return random_; }
   uint64_t maxPendingLookups() const { return max_pending_lookups_; }
+  bool cacheResponses() const { return cache_responses_; }
+  uint64_t maxCachedResponses() const { return max_cached_responses_; }
+  const absl::optional<std::chrono::seconds>& maxCacheTtl() const { return max_cache_ttl_; }
+  std::chrono::seconds negativeCacheTtl() const { return negative_cache_ttl_; }
 
 private:
   static DnsFilterStats generateStats(const std::string& stat_prefix, Stats::Scope& scope) {
@@ -116,11 +126,15 @@ private:
   std::chrono::milliseconds resolver_timeout_;
   Random::RandomGenerator& random_;
   uint64_t max_pending_lookups_;
+  bool cache_responses_;
+  uint64_t max_cached_responses_;
+  absl::optional<std::chrono::seconds> max_cache_ttl_;
+  std::chrono::seconds negative_cache_ttl_;
 };
 
 using DnsFilterEnvoyConfigSharedPtr = std::shared_ptr<const DnsFilterEnvoyConfig>;
 
-enum class DnsLookupResponseCode { Success, Failure, External };
+enum class DnsLookupResponseCode { Success, Failure, External, Cached };
 
 /**
  * This class is responsible for handling incoming DNS datagrams and responding to the queries.
@@ -149,6 +163,22 @@ private:
    */
   void sendDnsResponse(DnsQueryContextPtr context);
 
+  /**
+   * Send an already serialized response to the client
+   *
+   * @param context contains the addressing information of the client
+   * @param response the serialized response. The buffer is drained when the response is sent
+   */
+  void sendResponseBuffer(const DnsQueryContext& context, Buffer::OwnedImpl& response);
+
+  /**
+   * @brief Answers the query from the response cache if a valid response is cached for it
+   *
+   * @param context object containing the query context
+   * @return bool true if a cached response was sent to the client
+   */
+  bool sendCachedResponse(const DnsQueryContext& context);
+
   /**
    * @brief Encapsulates all of the logic required to find an answer for a DNS query
    *
@@ -313,6 +343,10 @@ private:
   Network::Address::InstanceConstSharedPtr local_;
   Network::Address::InstanceConstSharedPtr peer_;
   DnsFilterResolverCallback resolver_callback_;
+  DnsResponseCacheCounters response_cache_counters_;
+  // Only present when response caching is enabled. Each worker owns a filter instance and therefore
+  // its own cache.
+  DnsResponseCachePtr response_cache_;
 };
 
 } // namespace DnsFilter
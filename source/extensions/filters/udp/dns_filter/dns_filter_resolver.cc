@@ -82,15 +82,15 @@ void DnsFilterResolver::resolveExternalQuery(DnsQueryContextPtr context,
     ctx.query_context->resolution_status_ = status;
     ctx.resolver_status = DnsFilterResolverStatus::Complete;
 
-    // C-ares doesn't expose the TTL in the data available here.
+    // The responses carry the TTLs of the upstream answers, which the answer records keep.
     if (status == Network::DnsResolver::ResolutionStatus::Success) {
-      ctx.resolved_hosts.reserve(response.size());
+      ctx.query_context->upstream_answered_ = true;
       for (const auto& resp : response) {
         ASSERT(resp.address_ != nullptr);
-        ENVOY_LOG(trace, "Resolved address: {} for {}", resp.address_->ip()->addressAsString(),
-                  ctx.query_rec->name_);
-        ctx.resolved_hosts.emplace_back(std::move(resp.address_));
+        ENVOY_LOG(trace, "Resolved address: {} for {} [ttl {}s]",
+                  resp.address_->ip()->addressAsString(), ctx.query_rec->name_, resp.ttl_.count());
       }
+      ctx.resolved_hosts = std::move(response);
     }
     // Invoke the filter callback notifying it of resolved addresses
     invokeCallback(ctx);
@@ -40,7 +40,7 @@ private:
     const DnsQueryRecord* query_rec;
     DnsQueryContextPtr query_context;
     uint64_t expiry;
-    AddressConstPtrVec resolved_hosts;
+    std::list<Network::DnsResponse> resolved_hosts;
     DnsFilterResolverStatus resolver_status;
     Event::TimerPtr timeout_timer;
   };
@@ -199,6 +199,7 @@ bool DnsMessageParser::parseDnsObject(DnsQueryContextPtr& context,
   }
 
   context->id_ = static_cast<uint16_t>(header_.id);
+  context->recursion_desired_ = header_.flags.rd;
   if (context->id_ == 0) {
     ENVOY_LOG(debug, "No ID in DNS query");
     return false;
@@ -100,7 +100,8 @@ public:
                   Network::Address::InstanceConstSharedPtr peer, DnsParserCounters& counters,
                   uint64_t retry_count)
       : local_(std::move(local)), peer_(std::move(peer)), counters_(counters), parse_status_(false),
-        response_code_(DNS_RESPONSE_CODE_NO_ERROR), retry_(retry_count) {}
+        response_code_(DNS_RESPONSE_CODE_NO_ERROR), retry_(retry_count),
+        recursion_desired_(false), upstream_answered_(false) {}
 
   const Network::Address::InstanceConstSharedPtr local_;
   const Network::Address::InstanceConstSharedPtr peer_;
@@ -109,14 +110,18 @@ public:
   uint16_t response_code_;
   uint64_t retry_;
   uint16_t id_;
+  bool recursion_desired_;
   Network::DnsResolver::ResolutionStatus resolution_status_;
+  // Whether the upstream resolvers answered the query, rather than it timing out or failing
+  bool upstream_answered_;
   DnsQueryPtrVec queries_;
   DnsAnswerMap answers_;
 };
 
 using DnsQueryContextPtr = std::unique_ptr<DnsQueryContext>;
-using DnsFilterResolverCallback = std::function<void(
-    DnsQueryContextPtr context, const DnsQueryRecord* current_query, AddressConstPtrVec& ipaddr)>;
+using DnsFilterResolverCallback =
+    std::function<void(DnsQueryContextPtr context, const DnsQueryRecord* current_query,
+                       std::list<Network::DnsResponse>& response)>;
 
 /**
  * This class orchestrates parsing a DNS query and building the response to be sent to a client.
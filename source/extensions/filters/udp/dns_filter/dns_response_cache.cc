@@ -0,0 +1,256 @@
+#include "extensions/filters/udp/dns_filter/dns_response_cache.h"
+
+#include "common/common/assert.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace DnsFilter {
+
+namespace {
+// Size of the transaction ID at the start of every DNS message.
+constexpr size_t DNS_ID_SIZE = sizeof(uint16_t);
+// The recursion desired flag is the least significant bit of the first flags byte, which directly
+// follows the transaction ID.
+constexpr uint8_t DNS_RD_FLAG = 0x01;
+// The header holds the transaction ID, the flags and the four record counts.
+constexpr size_t DNS_HEADER_SIZE = 12;
+constexpr size_t DNS_QUESTION_COUNT_OFFSET = 4;
+constexpr size_t DNS_ANSWER_COUNT_OFFSET = 6;
+// A name label whose two high bits are set is a pointer to the rest of the name.
+constexpr uint8_t DNS_NAME_POINTER = 0xc0;
+
+uint16_t readUint16(absl::string_view data, size_t offset) {
+  return static_cast<uint16_t>(static_cast<uint8_t>(data[offset]) << 8 |
+                               static_cast<uint8_t>(data[offset + 1]));
+}
+
+uint32_t readUint32(absl::string_view data, size_t offset) {
+  return static_cast<uint32_t>(readUint16(data, offset)) << 16 | readUint16(data, offset + 2);
+}
+
+// Advances the offset past a serialized name. Returns false if the name is truncated.
+bool skipName(absl::string_view data, size_t& offset) {
+  while (offset < data.size()) {
+    const uint8_t label_length = static_cast<uint8_t>(data[offset]);
+    if (label_length == 0) {
+      ++offset;
+      return true;
+    }
+    if ((label_length & DNS_NAME_POINTER) == DNS_NAME_POINTER) {
+      offset += sizeof(uint16_t);
+      return offset <= data.size();
+    }
+    offset += label_length + 1;
+  }
+  return false;
+}
+
+// Writes the name serialized at the offset of the response with the spelling of the given name,
+// which only differs from it in case.
+void addName(Buffer::Instance& buffer, absl::string_view response, size_t offset,
+             absl::string_view name) {
+  std::string serialized(response.substr(offset, name.size() + 2));
+  for (size_t i = 0; i < name.size(); i++) {
+    // Each separator is serialized as the length of the following label.
+    if (name[i] != '.') {
+      serialized[i + 1] = name[i];
+    }
+  }
+  buffer.add(serialized);
+}
+} // namespace
+
+DnsResponseCache::DnsResponseCache(TimeSource& time_source, DnsResponseCacheCounters& counters,
+                                   uint64_t max_entries,
+                                   absl::optional<std::chrono::seconds> max_ttl,
+                                   std::chrono::seconds negative_ttl)
+    : time_source_(time_source), counters_(counters), max_entries_(max_entries),
+      max_ttl_(max_ttl), negative_ttl_(negative_ttl) {
+  ASSERT(max_entries_ > 0);
+}
+
+bool DnsResponseCache::lookup(const DnsQueryContext& context, Buffer::Instance& buffer) {
+  ASSERT(context.queries_.size() == 1);
+  const auto& query = context.queries_.front();
+
+  const auto iter =
+      entries_.find(CacheKey{absl::AsciiStrToLower(query->name_), query->type_, query->class_});
+  if (iter == entries_.end()) {
+    counters_.misses.inc();
+    return false;
+  }
+
+  const CacheEntryList::iterator entry = iter->second;
+  if (time_source_.monotonicTime() >= entry->expiry_) {
+    ENVOY_LOG(trace, "Cached response for [{}] expired", query->name_);
+    entries_.erase(iter);
+    lru_.erase(entry);
+    counters_.misses.inc();
+    return false;
+  }
+
+  lru_.splice(lru_.begin(), lru_, entry);
+  if (entry->negative_) {
+    counters_.negative_hits.inc();
+  } else {
+    counters_.hits.inc();
+  }
+  ENVOY_LOG(trace, "Serving cached response for [{}] to query ID [{}]", query->name_,
+            context.id_);
+
+  // Only the transaction ID, the recursion desired flag, the spelling of the query name and the
+  // TTLs differ between queries sharing a cache entry. Everything else is sent as it was
+  // serialized. The query name is echoed as the client spelled it, as clients randomizing its case
+  // reject a response whose question doesn't match theirs (RFC 1035 section 7.3).
+  const std::string& response = entry->response_;
+  uint8_t header[DNS_ID_SIZE + 1];
+  header[0] = static_cast<uint8_t>(context.id_ >> 8);
+  header[1] = static_cast<uint8_t>(context.id_ & 0xff);
+  header[2] = static_cast<uint8_t>(response[DNS_ID_SIZE]);
+  if (context.recursion_desired_) {
+    header[2] |= DNS_RD_FLAG;
+  } else {
+    header[2] &= ~DNS_RD_FLAG;
+  }
+  buffer.add(header, sizeof(header));
+
+  // The entry expires with its smallest TTL, so every TTL is at least as long as the entry has been
+  // cached for.
+  const uint64_t elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                               time_source_.monotonicTime() - entry->inserted_)
+                               .count();
+  // Each answer name precedes the TTL of its answer, so both lists are walked in response order.
+  size_t offset = sizeof(header);
+  auto name = entry->names_.begin();
+  auto ttl = entry->ttls_.begin();
+  while (name != entry->names_.end() || ttl != entry->ttls_.end()) {
+    if (name != entry->names_.end() && (ttl == entry->ttls_.end() || *name < ttl->first)) {
+      buffer.add(response.data() + offset, *name - offset);
+      addName(buffer, response, *name, query->name_);
+      offset = *name + query->name_.size() + 2;
+      ++name;
+    } else {
+      buffer.add(response.data() + offset, ttl->first - offset);
+      buffer.writeBEInt<uint32_t>(ttl->second > elapsed ? ttl->second - elapsed : 0);
+      offset = ttl->first + sizeof(uint32_t);
+      ++ttl;
+    }
+  }
+  buffer.add(response.data() + offset, response.size() - offset);
+  return true;
+}
+
+void DnsResponseCache::insert(const DnsQueryContext& context, const Buffer::Instance& response) {
+  if (context.queries_.size() != 1 || response.length() <= DNS_ID_SIZE + 1) {
+    return;
+  }
+
+  const bool negative =
+      context.answers_.empty() || context.response_code_ != DNS_RESPONSE_CODE_NO_ERROR;
+  // A response without answers is only a negative answer if the upstream resolvers gave it. The
+  // resolver reports a name which does not exist like a timeout, so only responses without data
+  // for an existing name are negatively cached.
+  if (negative && !context.upstream_answered_) {
+    return;
+  }
+  const std::chrono::seconds lifetime = negative ? negative_ttl_ : cacheLifetime(context);
+  if (lifetime.count() <= 0) {
+    return;
+  }
+
+  const auto& query = context.queries_.front();
+  std::string serialized = response.toString();
+  std::vector<size_t> names;
+  std::vector<std::pair<size_t, uint32_t>> ttls;
+  if (!findAnswerTtls(serialized, query->name_.size(), names, ttls)) {
+    ENVOY_LOG(debug, "Unable to find the answer TTLs of the response, not caching it");
+    return;
+  }
+
+  CacheKey key{absl::AsciiStrToLower(query->name_), query->type_, query->class_};
+  const auto iter = entries_.find(key);
+  if (iter != entries_.end()) {
+    lru_.erase(iter->second);
+    entries_.erase(iter);
+  } else if (entries_.size() >= max_entries_) {
+    const CacheEntry& oldest = lru_.back();
+    ENVOY_LOG(trace, "Evicting cached response for [{}]", oldest.key_.name_);
+    entries_.erase(oldest.key_);
+    lru_.pop_back();
+    counters_.evictions.inc();
+  }
+
+  const MonotonicTime now = time_source_.monotonicTime();
+  lru_.push_front(CacheEntry{key, std::move(serialized), now, now + lifetime, negative,
+                            std::move(names), std::move(ttls)});
+  entries_.emplace(std::move(key), lru_.begin());
+  counters_.insertions.inc();
+}
+
+std::chrono::seconds DnsResponseCache::cacheLifetime(const DnsQueryContext& context) const {
+  std::chrono::seconds lifetime = std::chrono::seconds::max();
+  for (const auto& answer : context.answers_) {
+    lifetime = std::min(lifetime, answer.second->ttl_);
+  }
+  if (max_ttl_.has_value()) {
+    lifetime = std::min(lifetime, max_ttl_.value());
+  }
+  return lifetime;
+}
+
+bool DnsResponseCache::findAnswerTtls(absl::string_view response, size_t query_name_size,
+                                      std::vector<size_t>& names,
+                                      std::vector<std::pair<size_t, uint32_t>>& ttls) {
+  if (response.size() < DNS_HEADER_SIZE) {
+    return false;
+  }
+  const uint16_t questions = readUint16(response, DNS_QUESTION_COUNT_OFFSET);
+  const uint16_t answers = readUint16(response, DNS_ANSWER_COUNT_OFFSET);
+
+  size_t offset = DNS_HEADER_SIZE;
+  for (uint16_t i = 0; i < questions; i++) {
+    // Each question is followed by its type and class
+    const size_t name_offset = offset;
+    if (!skipName(response, offset)) {
+      return false;
+    }
+    if (offset - name_offset == query_name_size + 2) {
+      names.push_back(name_offset);
+    }
+    offset += 2 * sizeof(uint16_t);
+  }
+  // The query name serialized in the question, which the answers are named after.
+  const absl::string_view question_name =
+      names.empty() ? absl::string_view() : response.substr(names.front(), query_name_size + 2);
+
+  ttls.reserve(answers);
+  for (uint16_t i = 0; i < answers; i++) {
+    // Each answer name is followed by the type, the class, the TTL, the data length and the data
+    const size_t name_offset = offset;
+    if (!skipName(response, offset)) {
+      return false;
+    }
+    if (!question_name.empty() &&
+        absl::EqualsIgnoreCase(response.substr(name_offset, offset - name_offset),
+                               question_name)) {
+      names.push_back(name_offset);
+    }
+    offset += 2 * sizeof(uint16_t);
+    if (offset + sizeof(uint32_t) + sizeof(uint16_t) > response.size()) {
+      return false;
+    }
+    ttls.emplace_back(offset, readUint32(response, offset));
+    offset += sizeof(uint32_t);
+    offset += sizeof(uint16_t) + readUint16(response, offset);
+  }
+  return offset <= response.size();
+}
+
+} // namespace DnsFilter
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
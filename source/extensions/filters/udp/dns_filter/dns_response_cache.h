@@ -0,0 +1,153 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/time.h"
+#include "envoy/stats/stats.h"
+
+#include "extensions/filters/udp/dns_filter/dns_parser.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace DnsFilter {
+
+/**
+ * @brief This struct is used to hold pointers to the counters that are relevant to the response
+ * cache. This is done to prevent dependency loops between the cache and filter headers
+ */
+struct DnsResponseCacheCounters {
+  Stats::Counter& hits;
+  Stats::Counter& negative_hits;
+  Stats::Counter& misses;
+  Stats::Counter& insertions;
+  Stats::Counter& evictions;
+
+  DnsResponseCacheCounters(Stats::Counter& cache_hits, Stats::Counter& cache_negative_hits,
+                           Stats::Counter& cache_misses, Stats::Counter& cache_insertions,
+                           Stats::Counter& cache_evictions)
+      : hits(cache_hits), negative_hits(cache_negative_hits), misses(cache_misses),
+        insertions(cache_insertions), evictions(cache_evictions) {}
+};
+
+/**
+ * DnsResponseCache holds fully serialized responses to externally resolved queries so that
+ * repeated queries for the same name are answered without an upstream round trip and without
+ * re-encoding any records. The cache is not thread safe; each worker owns its own instance.
+ *
+ * Responses are keyed by the query name, which is case insensitive, type and class. A cached
+ * response is served with the query name spelled as in the incoming query. A response
+ * containing answers is cached for the smallest TTL of its answer records, optionally capped by a
+ * configured maximum, and the TTLs it is served with are decremented by the time it was cached
+ * for. A response without answers is cached for the configured negative TTL, but only if the
+ * upstream resolvers answered the query: timeouts and resolution failures are not cached. When the
+ * cache is full the least recently used response is evicted.
+ */
+class DnsResponseCache : public Logger::Loggable<Logger::Id::filter> {
+public:
+  DnsResponseCache(TimeSource& time_source, DnsResponseCacheCounters& counters,
+                   uint64_t max_entries, absl::optional<std::chrono::seconds> max_ttl,
+                   std::chrono::seconds negative_ttl);
+
+  /**
+   * @brief Looks up a cached response for the query in the supplied context. On a hit, the cached
+   * response is written to the buffer with the transaction ID and the recursion desired flag of
+   * the incoming query, and with the TTLs its answers have left.
+   *
+   * @param context the query context for which a response is sought. It must contain exactly one
+   * query
+   * @param buffer the buffer to which the cached response is written
+   * @return bool true if a valid cached response was written to the buffer
+   */
+  bool lookup(const DnsQueryContext& context, Buffer::Instance& buffer);
+
+  /**
+   * @brief Stores the serialized response to the query in the supplied context. Responses to
+   * contexts with more than one query, responses whose lifetime is zero and responses without
+   * answers which the upstream resolvers did not give are not cached.
+   *
+   * @param context the query context for which the response was generated
+   * @param response the serialized response sent to the client
+   */
+  void insert(const DnsQueryContext& context, const Buffer::Instance& response);
+
+  /**
+   * @return size_t the number of responses currently cached, including expired responses that
+   * have not been purged yet
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct CacheKey {
+    std::string name_;
+    uint16_t type_;
+    uint16_t class_;
+
+    bool operator==(const CacheKey& rhs) const {
+      return type_ == rhs.type_ && class_ == rhs.class_ && name_ == rhs.name_;
+    }
+
+    template <typename H> friend H AbslHashValue(H h, const CacheKey& key) {
+      return H::combine(std::move(h), key.name_, key.type_, key.class_);
+    }
+  };
+
+  struct CacheEntry {
+    CacheKey key_;
+    std::string response_;
+    MonotonicTime inserted_;
+    MonotonicTime expiry_;
+    bool negative_;
+    // Offsets of the query name in the question and in the answers named after it in response_.
+    std::vector<size_t> names_;
+    // Offsets of the TTL of each answer record in response_, and the TTLs when it was cached.
+    std::vector<std::pair<size_t, uint32_t>> ttls_;
+  };
+
+  using CacheEntryList = std::list<CacheEntry>;
+
+  /**
+   * @return std::chrono::seconds the time for which a response containing answers may be served
+   * from the cache
+   */
+  std::chrono::seconds cacheLifetime(const DnsQueryContext& context) const;
+
+  /**
+   * @brief Finds the query name and the TTL of each answer record in a serialized response
+   *
+   * @param response the serialized response
+   * @param query_name_size the size of the query name, in its dotted form
+   * @param names receives the offset of the query name in the question and in each answer record
+   * named after it
+   * @param ttls receives the offset and the value of each TTL
+   * @return bool true if the response could be walked up to the end of its answer records
+   */
+  static bool findAnswerTtls(absl::string_view response, size_t query_name_size,
+                             std::vector<size_t>& names,
+                             std::vector<std::pair<size_t, uint32_t>>& ttls);
+
+  TimeSource& time_source_;
+  DnsResponseCacheCounters& counters_;
+  const uint64_t max_entries_;
+  const absl::optional<std::chrono::seconds> max_ttl_;
+  const std::chrono::seconds negative_ttl_;
+  // Most recently used entries are at the front of the list.
+  CacheEntryList lru_;
+  absl::flat_hash_map<CacheKey, CacheEntryList::iterator> entries_;
+};
+
+using DnsResponseCachePtr = std::unique_ptr<DnsResponseCache>;
+
+} // namespace DnsFilter
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
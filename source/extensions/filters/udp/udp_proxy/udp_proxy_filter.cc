@@ -2,6 +2,8 @@
 
 #include "envoy/network/listener.h"
 
+#include "common/api/os_sys_calls_impl.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace UdpFilters {
@@ -158,9 +160,29 @@ UdpProxyFilter::ActiveSession::ActiveSession(ClusterInfo& cluster,
       // NOTE: The socket call can only fail due to memory/fd exhaustion. No local ephemeral port
       //       is bound until the first packet is sent to the upstream host.
       io_handle_(cluster.filter_.createIoHandle(host)),
+      upstream_writer_(cluster.filter_.config_->batchUpstreamWrites() &&
+                               Api::OsSysCallsSingleton::get().supportsMmsg()
+                           ? std::make_unique<Network::UdpBatchWriter>(
+                                 *io_handle_, cluster.cluster_.info()->statsScope())
+                           : nullptr),
+      flush_cb_(upstream_writer_ != nullptr
+                    ? cluster.filter_.read_callbacks_->udpListener()
+                          .dispatcher()
+                          .createSchedulableCallback([this] { flushUpstream(); })
+                    : nullptr),
       socket_event_(cluster.filter_.read_callbacks_->udpListener().dispatcher().createFileEvent(
-          io_handle_->fd(), [this](uint32_t) { onReadReady(); }, Event::PlatformDefaultTriggerType,
-          Event::FileReadyType::Read)) {
+          io_handle_->fd(),
+          [this](uint32_t events) {
+            if (events & Event::FileReadyType::Read) {
+              onReadReady();
+            }
+            if (events & Event::FileReadyType::Write) {
+              onWriteReady();
+            }
+          },
+          Event::PlatformDefaultTriggerType,
+          Event::FileReadyType::Read |
+              (upstream_writer_ != nullptr ? Event::FileReadyType::Write : 0))) {
   ENVOY_LOG(debug, "creating new session: downstream={} local={} upstream={}",
             addresses_.peer_->asStringView(), addresses_.local_->asStringView(),
             host->address()->asStringView());
@@ -179,6 +201,10 @@ UdpProxyFilter::ActiveSession::ActiveSession(ClusterInfo& cluster,
 }
 
 UdpProxyFilter::ActiveSession::~ActiveSession() {
+  if (upstream_writer_ != nullptr) {
+    // Do not lose datagrams that were accepted during the current event loop iteration.
+    flushUpstream();
+  }
   ENVOY_LOG(debug, "deleting the session: downstream={} local={} upstream={}",
             addresses_.peer_->asStringView(), addresses_.local_->asStringView(),
             host_->address()->asStringView());
@@ -228,7 +254,12 @@ void UdpProxyFilter::ActiveSession::write(const Buffer::Instance& buffer) {
   // NOTE: We do not specify the local IP to use for the sendmsg call. We allow the OS to select
   //       the right IP based on outbound routing rules.
   Api::IoCallUint64Result rc =
-      Network::Utility::writeToSocket(*io_handle_, buffer, nullptr, *host_->address());
+      upstream_writer_ != nullptr
+          ? upstream_writer_->writePacket(buffer, nullptr, *host_->address())
+          : Network::Utility::writeToSocket(*io_handle_, buffer, nullptr, *host_->address());
+  if (upstream_writer_ != nullptr && !flush_cb_->enabled()) {
+    flush_cb_->scheduleCallbackCurrentIteration();
+  }
   if (!rc.ok()) {
     cluster_.cluster_stats_.sess_tx_errors_.inc();
   } else {
@@ -237,6 +268,24 @@ void UdpProxyFilter::ActiveSession::write(const Buffer::Instance& buffer) {
   }
 }
 
+void UdpProxyFilter::ActiveSession::onWriteReady() {
+  if (upstream_writer_ != nullptr && upstream_writer_->isWriteBlocked()) {
+    upstream_writer_->setWritable();
+    flushUpstream();
+  }
+}
+
+void UdpProxyFilter::ActiveSession::flushUpstream() {
+  // Datagrams were counted as transmitted when they were accepted by the writer. A failed flush
+  // is accounted once as a transmit error. Datagrams left behind by a write blocked socket are
+  // retried from onWriteReady().
+  const Api::IoCallUint64Result rc = upstream_writer_->flush();
+  if (!rc.ok() && rc.err_->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+    ENVOY_LOG(trace, "failed to flush batched datagrams upstream: {}", rc.err_->getErrorDetails());
+    cluster_.cluster_stats_.sess_tx_errors_.inc();
+  }
+}
+
 void UdpProxyFilter::ActiveSession::processPacket(Network::Address::InstanceConstSharedPtr,
                                                   Network::Address::InstanceConstSharedPtr,
                                                   Buffer::InstancePtr buffer, MonotonicTime) {
@@ -7,6 +7,7 @@
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/network/socket_interface_impl.h"
+#include "common/network/udp_batch_writer.h"
 #include "common/network/utility.h"
 
 #include "absl/container/flat_hash_set.h"
@@ -63,11 +64,13 @@ public:
                        const envoy::extensions::filters::udp::udp_proxy::v3::UdpProxyConfig& config)
       : cluster_manager_(cluster_manager), time_source_(time_source), cluster_(config.cluster()),
         session_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, idle_timeout, 60 * 1000)),
+        batch_upstream_writes_(config.batch_upstream_writes()),
         stats_(generateStats(config.stat_prefix(), root_scope)) {}
 
   const std::string& cluster() const { return cluster_; }
   Upstream::ClusterManager& clusterManager() const { return cluster_manager_; }
   std::chrono::milliseconds sessionTimeout() const { return session_timeout_; }
+  bool batchUpstreamWrites() const { return batch_upstream_writes_; }
   UdpProxyDownstreamStats& stats() const { return stats_; }
   TimeSource& timeSource() const { return time_source_; }
 
@@ -83,6 +86,7 @@ private:
   TimeSource& time_source_;
   const std::string cluster_;
   const std::chrono::milliseconds session_timeout_;
+  const bool batch_upstream_writes_;
   mutable UdpProxyDownstreamStats stats_;
 };
 
@@ -122,6 +126,8 @@ private:
   private:
     void onIdleTimer();
     void onReadReady();
+    void onWriteReady();
+    void flushUpstream();
 
     // Network::UdpPacketProcessor
     void processPacket(Network::Address::InstanceConstSharedPtr local_address,
@@ -147,6 +153,10 @@ private:
     // packets from the upstream host. Note that a a local ephemeral port is bound on the first
     // write to the upstream host.
     const Network::IoHandlePtr io_handle_;
+    // Only set when upstream writes are batched. Datagrams are buffered in the writer and flushed
+    // by flush_cb_ once the current event loop iteration has processed all of its events.
+    const Network::UdpPacketWriterPtr upstream_writer_;
+    const Event::SchedulableCallbackPtr flush_cb_;
     const Event::FileEventPtr socket_event_;
   };
 
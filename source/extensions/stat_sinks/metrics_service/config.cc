@@ -37,7 +37,9 @@ MetricsServiceSinkFactory::createStatsSink(const Protobuf::Message& config,
 
   return std::make_unique<MetricsServiceSink>(
       grpc_metrics_streamer, server.timeSource(),
-      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, report_counters_as_deltas, false));
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, report_counters_as_deltas, false),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, report_changed_metrics_only, false),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, report_metric_ids, false));
 }
 
 ProtobufTypes::MessagePtr MetricsServiceSinkFactory::createEmptyConfigProto() {
@@ -1,5 +1,7 @@
 #include "extensions/stat_sinks/metrics_service/grpc_metrics_service_impl.h"
 
+#include <algorithm>
+
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/service/metrics/v3/metrics_service.pb.h"
@@ -10,12 +12,24 @@
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 #include "common/config/utility.h"
+#include "common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace StatSinks {
 namespace MetricsService {
 
+namespace {
+
+// The first block of the message arena grows to the size the largest message took, within these
+// bounds. Larger messages grow the arena past its first block, by blocks of at most
+// MaxArenaBlockSize.
+constexpr uint64_t MinArenaBlockSize = 4 * 1024;
+constexpr uint64_t MaxArenaInitialBlockSize = 16 * 1024 * 1024;
+constexpr uint64_t MaxArenaBlockSize = 1024 * 1024;
+
+} // namespace
+
 GrpcMetricsStreamerImpl::GrpcMetricsStreamerImpl(
     Grpc::AsyncClientFactoryPtr&& factory, const LocalInfo::LocalInfo& local_info,
     envoy::config::core::v3::ApiVersion transport_api_version)
@@ -39,19 +53,61 @@ void GrpcMetricsStreamerImpl::send(envoy::service::metrics::v3::StreamMetricsMes
 
 MetricsServiceSink::MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
                                        TimeSource& time_source,
-                                       const bool report_counters_as_deltas)
-    : grpc_metrics_streamer_(grpc_metrics_streamer), time_source_(time_source),
-      report_counters_as_deltas_(report_counters_as_deltas) {}
+                                       const bool report_counters_as_deltas,
+                                       const bool report_changed_metrics_only,
+                                       const bool report_metric_ids)
+    : grpc_metrics_streamer_(grpc_metrics_streamer), arena_initial_block_(MinArenaBlockSize),
+      arena_(std::make_unique<Protobuf::Arena>(
+          ArenaUtil::options(arena_initial_block_, MaxArenaBlockSize))),
+      time_source_(time_source), report_counters_as_deltas_(report_counters_as_deltas),
+      report_changed_metrics_only_(report_changed_metrics_only),
+      report_metric_ids_(report_metric_ids) {
+  resetMessage();
+}
+
+void MetricsServiceSink::resetMessage() {
+  const uint64_t initial_block_size = std::min(arena_->SpaceAllocated(), MaxArenaInitialBlockSize);
+  if (initial_block_size > arena_initial_block_.size()) {
+    // The message didn't fit in the first block, which only an arena built anew can grow.
+    arena_.reset();
+    arena_initial_block_.resize(initial_block_size);
+    arena_ = std::make_unique<Protobuf::Arena>(
+        ArenaUtil::options(arena_initial_block_, MaxArenaBlockSize));
+  } else {
+    // Frees the whole message at once, rather than metric by metric.
+    arena_->Reset();
+  }
+  message_ =
+      Protobuf::Arena::CreateMessage<envoy::service::metrics::v3::StreamMetricsMessage>(
+          arena_.get());
+}
+
+// Adds a metric family to the message, identified by its name or by the id of its name. The name of
+// an id is only added the first time the id is sent on the stream.
+io::prometheus::client::MetricFamily* MetricsServiceSink::addMetricFamily(std::string name) {
+  io::prometheus::client::MetricFamily* metrics_family = message_->add_envoy_metrics();
+  if (!report_metric_ids_) {
+    metrics_family->set_name(std::move(name));
+    return metrics_family;
+  }
+  const auto result = metric_ids_.try_emplace(std::move(name), metric_ids_.size());
+  const uint64_t id = result.first->second;
+  if (result.second) {
+    auto* metric_name = message_->add_metric_names();
+    metric_name->set_id(id);
+    metric_name->set_name(result.first->first);
+  }
+  message_->add_envoy_metric_ids(id);
+  return metrics_family;
+}
 
 void MetricsServiceSink::flushCounter(
     const Stats::MetricSnapshot::CounterSnapshot& counter_snapshot) {
-  io::prometheus::client::MetricFamily* metrics_family = message_.add_envoy_metrics();
+  io::prometheus::client::MetricFamily* metrics_family =
+      addMetricFamily(counter_snapshot.counter_.get().name());
   metrics_family->set_type(io::prometheus::client::MetricType::COUNTER);
-  metrics_family->set_name(counter_snapshot.counter_.get().name());
   auto* metric = metrics_family->add_metric();
-  metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                               time_source_.systemTime().time_since_epoch())
-                               .count());
+  metric->set_timestamp_ms(flush_timestamp_ms_);
   auto* counter_metric = metric->mutable_counter();
   if (report_counters_as_deltas_) {
     counter_metric->set_value(counter_snapshot.delta_);
@@ -61,13 +117,10 @@ void MetricsServiceSink::flushCounter(
 }
 
 void MetricsServiceSink::flushGauge(const Stats::Gauge& gauge) {
-  io::prometheus::client::MetricFamily* metrics_family = message_.add_envoy_metrics();
+  io::prometheus::client::MetricFamily* metrics_family = addMetricFamily(gauge.name());
   metrics_family->set_type(io::prometheus::client::MetricType::GAUGE);
-  metrics_family->set_name(gauge.name());
   auto* metric = metrics_family->add_metric();
-  metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                               time_source_.systemTime().time_since_epoch())
-                               .count());
+  metric->set_timestamp_ms(flush_timestamp_ms_);
   auto* gauge_metric = metric->mutable_gauge();
   gauge_metric->set_value(gauge.value());
 }
@@ -77,14 +130,13 @@ void MetricsServiceSink::flushHistogram(const Stats::ParentHistogram& envoy_hist
   // information. We should make this configurable if it turns out that sending both affects
   // performance.
 
+  const std::string name = envoy_histogram.name();
+
   // Add summary information for histograms.
-  io::prometheus::client::MetricFamily* summary_metrics_family = message_.add_envoy_metrics();
+  io::prometheus::client::MetricFamily* summary_metrics_family = addMetricFamily(name);
   summary_metrics_family->set_type(io::prometheus::client::MetricType::SUMMARY);
-  summary_metrics_family->set_name(envoy_histogram.name());
   auto* summary_metric = summary_metrics_family->add_metric();
-  summary_metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       time_source_.systemTime().time_since_epoch())
-                                       .count());
+  summary_metric->set_timestamp_ms(flush_timestamp_ms_);
   auto* summary = summary_metric->mutable_summary();
   const Stats::HistogramStatistics& hist_stats = envoy_histogram.intervalStatistics();
   for (size_t i = 0; i < hist_stats.supportedQuantiles().size(); i++) {
@@ -94,13 +146,10 @@ void MetricsServiceSink::flushHistogram(const Stats::ParentHistogram& envoy_hist
   }
 
   // Add bucket information for histograms.
-  io::prometheus::client::MetricFamily* histogram_metrics_family = message_.add_envoy_metrics();
+  io::prometheus::client::MetricFamily* histogram_metrics_family = addMetricFamily(name);
   histogram_metrics_family->set_type(io::prometheus::client::MetricType::HISTOGRAM);
-  histogram_metrics_family->set_name(envoy_histogram.name());
   auto* histogram_metric = histogram_metrics_family->add_metric();
-  histogram_metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                         time_source_.systemTime().time_since_epoch())
-                                         .count());
+  histogram_metric->set_timestamp_ms(flush_timestamp_ms_);
   auto* histogram = histogram_metric->mutable_histogram();
   histogram->set_sample_count(hist_stats.sampleCount());
   histogram->set_sample_sum(hist_stats.sampleSum());
@@ -111,37 +160,81 @@ void MetricsServiceSink::flushHistogram(const Stats::ParentHistogram& envoy_hist
   }
 }
 
+bool MetricsServiceSink::gaugeChanged(const Stats::Gauge& gauge) {
+  const uint64_t value = gauge.value();
+  auto it = reported_gauges_.find(&gauge);
+  if (it == reported_gauges_.end()) {
+    // The reference only keeps the gauge alive, the gauge isn't modified.
+    reported_gauges_.emplace(
+        &gauge,
+        ReportedGauge{Stats::GaugeSharedPtr(const_cast<Stats::Gauge*>(&gauge)), value, flushes_});
+    return true;
+  }
+  it->second.flush_ = flushes_;
+  if (it->second.value_ == value) {
+    return false;
+  }
+  it->second.value_ = value;
+  return true;
+}
+
 void MetricsServiceSink::flush(Stats::MetricSnapshot& snapshot) {
-  message_.clear_envoy_metrics();
+  flush_timestamp_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            time_source_.systemTime().time_since_epoch())
+                            .count();
+  const bool new_stream = (report_changed_metrics_only_ || report_metric_ids_) &&
+                          !grpc_metrics_streamer_->isStreamStarted();
+  // All the metrics are reported on a new stream, so that the receiver starts from their current
+  // values. Afterwards, only the changed ones are reported if configured to do so.
+  const bool report_all = !report_changed_metrics_only_ || new_stream;
+  if (new_stream) {
+    // The receiver of a new stream doesn't know any metric name yet.
+    metric_ids_.clear();
+  }
+  flushes_++;
+  if (report_all) {
+    reported_gauges_.clear();
+    // TODO(mrice32): there's probably some more sophisticated preallocation we can do here where
+    // we actually preallocate the submessages and then pass ownership to the proto (rather than
+    // just preallocating the pointer array).
+    message_->mutable_envoy_metrics()->Reserve(
+        snapshot.counters().size() + snapshot.gauges().size() + snapshot.histograms().size());
+  }
 
-  // TODO(mrice32): there's probably some more sophisticated preallocation we can do here where we
-  // actually preallocate the submessages and then pass ownership to the proto (rather than just
-  // preallocating the pointer array).
-  message_.mutable_envoy_metrics()->Reserve(snapshot.counters().size() + snapshot.gauges().size() +
-                                            snapshot.histograms().size());
   for (const auto& counter : snapshot.counters()) {
-    if (counter.counter_.get().used()) {
+    if (counter.counter_.get().used() && (report_all || counter.delta_ > 0)) {
       flushCounter(counter);
     }
   }
 
   for (const auto& gauge : snapshot.gauges()) {
-    if (gauge.get().used()) {
-      flushGauge(gauge.get());
+    if (!gauge.get().used()) {
+      continue;
     }
+    // The gauge is tracked even if all the metrics are reported.
+    if (report_changed_metrics_only_ && !gaugeChanged(gauge.get()) && !report_all) {
+      continue;
+    }
+    flushGauge(gauge.get());
   }
 
   for (const auto& histogram : snapshot.histograms()) {
-    if (histogram.get().used()) {
+    // A histogram whose last interval has no sample has nothing new to report.
+    if (histogram.get().used() &&
+        (report_all || histogram.get().intervalStatistics().sampleCount() > 0)) {
       flushHistogram(histogram.get());
     }
   }
 
-  grpc_metrics_streamer_->send(message_);
-  // for perf reasons, clear the identifier after the first flush.
-  if (message_.has_identifier()) {
-    message_.clear_identifier();
+  if (report_changed_metrics_only_) {
+    // Releases the gauges which are no longer in the snapshot, e.g. because they were removed.
+    absl::erase_if(reported_gauges_, [this](const auto& reported_gauge) {
+      return reported_gauge.second.flush_ != flushes_;
+    });
   }
+
+  grpc_metrics_streamer_->send(*message_);
+  resetMessage();
 }
 
 } // namespace MetricsService
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "envoy/grpc/async_client.h"
 #include "envoy/local_info/local_info.h"
@@ -14,6 +15,9 @@
 
 #include "common/buffer/buffer_impl.h"
 #include "common/grpc/typed_async_client.h"
+#include "common/protobuf/protobuf.h"
+
+#include "absl/container/flat_hash_map.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -34,6 +38,12 @@ public:
    */
   virtual void send(envoy::service::metrics::v3::StreamMetricsMessage& message) PURE;
 
+  /**
+   * @return whether the stream is started, i.e. whether the next message is sent on the same stream
+   *         as the previous one.
+   */
+  virtual bool isStreamStarted() const PURE;
+
   // Grpc::AsyncStreamCallbacks
   void onCreateInitialMetadata(Http::RequestHeaderMap&) override {}
   void onReceiveInitialMetadata(Http::ResponseHeaderMapPtr&&) override {}
@@ -57,6 +67,7 @@ public:
 
   // GrpcMetricsStreamer
   void send(envoy::service::metrics::v3::StreamMetricsMessage& message) override;
+  bool isStreamStarted() const override { return stream_ != nullptr; }
 
   // Grpc::AsyncStreamCallbacks
   void onRemoteClose(Grpc::Status::GrpcStatus, const std::string&) override { stream_ = nullptr; }
@@ -80,19 +91,51 @@ class MetricsServiceSink : public Stats::Sink {
 public:
   // MetricsService::Sink
   MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
-                     TimeSource& time_system, const bool report_counters_as_deltas);
+                     TimeSource& time_system, const bool report_counters_as_deltas,
+                     const bool report_changed_metrics_only, const bool report_metric_ids);
   void flush(Stats::MetricSnapshot& snapshot) override;
   void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
+  // All the metrics are needed on a new stream.
+  bool changedMetricsOnly() const override {
+    return report_changed_metrics_only_ && grpc_metrics_streamer_->isStreamStarted();
+  }
 
   void flushCounter(const Stats::MetricSnapshot::CounterSnapshot& counter_snapshot);
   void flushGauge(const Stats::Gauge& gauge);
   void flushHistogram(const Stats::ParentHistogram& envoy_histogram);
 
 private:
+  void resetMessage();
+  io::prometheus::client::MetricFamily* addMetricFamily(std::string name);
+  bool gaugeChanged(const Stats::Gauge& gauge);
+
   GrpcMetricsStreamerSharedPtr grpc_metrics_streamer_;
-  envoy::service::metrics::v3::StreamMetricsMessage message_;
+  // The message is allocated on an arena, which is reset after each flush. The first block of the
+  // arena is kept and grows with the messages, so that flushing a steady set of metrics doesn't
+  // allocate memory.
+  std::vector<char> arena_initial_block_;
+  std::unique_ptr<Protobuf::Arena> arena_;
+  envoy::service::metrics::v3::StreamMetricsMessage* message_{};
   TimeSource& time_source_;
+  int64_t flush_timestamp_ms_{};
   const bool report_counters_as_deltas_;
+  const bool report_changed_metrics_only_;
+  const bool report_metric_ids_;
+
+  // When only the changed metrics are reported, the last value reported on the stream for each
+  // gauge. The gauges are referenced until they no longer are in a snapshot, so that a new gauge
+  // isn't mistaken for a freed one.
+  struct ReportedGauge {
+    Stats::GaugeSharedPtr gauge_;
+    uint64_t value_;
+    uint64_t flush_;
+  };
+  absl::flat_hash_map<const Stats::Gauge*, ReportedGauge> reported_gauges_;
+  uint64_t flushes_{};
+
+  // When metrics are reported by id, the ids of the metric names sent on the current stream. The
+  // names are sent again on a new stream, so the ids are only forgotten then.
+  absl::flat_hash_map<std::string, uint64_t> metric_ids_;
 };
 
 } // namespace MetricsService
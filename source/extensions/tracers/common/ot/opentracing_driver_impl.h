@@ -42,6 +42,7 @@ public:
   void setSampled(bool) override;
   std::string getBaggage(absl::string_view key) override;
   void setBaggage(absl::string_view key, absl::string_view value) override;
+  bool isRecording() const override { return true; }
 
 private:
   OpenTracingDriver& driver_;
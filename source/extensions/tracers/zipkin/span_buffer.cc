@@ -2,20 +2,23 @@
 
 #include "envoy/config/trace/v3/zipkin.pb.h"
 
-#include "common/protobuf/utility.h"
+#include "common/buffer/buffer_impl.h"
+#include "common/common/byte_order.h"
+#include "common/common/utility.h"
 
 #include "extensions/tracers/zipkin/util.h"
 #include "extensions/tracers/zipkin/zipkin_core_constants.h"
 #include "extensions/tracers/zipkin/zipkin_json_field_names.h"
 
 #include "absl/strings/str_join.h"
-#include "absl/strings/str_replace.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace Tracers {
 namespace Zipkin {
 
+using Protobuf::io::CodedOutputStream;
+
 SpanBuffer::SpanBuffer(
     const envoy::config::trace::v3::ZipkinConfig::CollectorEndpointVersion& version,
     const bool shared_span_context)
@@ -28,6 +31,12 @@ SpanBuffer::SpanBuffer(
   allocateBuffer(size);
 }
 
+std::string SpanBuffer::serialize() const {
+  Buffer::OwnedImpl output;
+  serialize(output);
+  return output.toString();
+}
+
 bool SpanBuffer::addSpan(Span&& span) {
   const auto& annotations = span.annotations();
   if (span_buffer_.size() == span_buffer_.capacity() || annotations.empty() ||
@@ -60,218 +69,464 @@ SerializerPtr SpanBuffer::makeSerializer(
   }
 }
 
-std::string JsonV1Serializer::serialize(const std::vector<Span>& zipkin_spans) {
+void JsonV1Serializer::serialize(const std::vector<Span>& zipkin_spans, Buffer::Instance& output) {
   const std::string serialized_elements =
       absl::StrJoin(zipkin_spans, ",", [](std::string* element, const Span& zipkin_span) {
         absl::StrAppend(element, zipkin_span.toJson());
       });
-  return absl::StrCat("[", serialized_elements, "]");
+  output.add(absl::StrCat("[", serialized_elements, "]"));
 }
 
-JsonV2Serializer::JsonV2Serializer(const bool shared_span_context)
-    : shared_span_context_{shared_span_context} {}
+namespace {
 
-std::string JsonV2Serializer::serialize(const std::vector<Span>& zipkin_spans) {
-  Util::Replacements replacements;
-  const std::string serialized_elements = absl::StrJoin(
-      zipkin_spans, ",", [this, &replacements](std::string* out, const Span& zipkin_span) {
-        const auto& replacement_values = replacements;
-        absl::StrAppend(
-            out, absl::StrJoin(
-                     toListOfSpans(zipkin_span, replacements), ",",
-                     [&replacement_values](std::string* element, const ProtobufWkt::Struct& span) {
-                       const std::string json = MessageUtil::getJsonStringFromMessage(
-                           span, /* pretty_print */ false,
-                           /* always_print_primitive_fields */ true);
-
-                       // The Zipkin API V2 specification mandates to store timestamp value as int64
-                       // https://github.com/openzipkin/zipkin-api/blob/228fabe660f1b5d1e28eac9df41f7d1deed4a1c2/zipkin2-api.yaml#L447-L463
-                       // (often translated as uint64 in some of the official implementations:
-                       // https://github.com/openzipkin/zipkin-go/blob/62dc8b26c05e0e8b88eb7536eff92498e65bbfc3/model/span.go#L114,
-                       // and see the discussion here:
-                       // https://github.com/openzipkin/zipkin-go/pull/161#issuecomment-598558072).
-                       // However, when the timestamp is stored as number value in a protobuf
-                       // struct, it is stored as a double. Because of how protobuf serializes
-                       // doubles, there is a possibility that the value will be rendered as a
-                       // number with scientific notation as reported in:
-                       // https://github.com/envoyproxy/envoy/issues/9341#issuecomment-566912973. To
-                       // deal with that issue, here we do a workaround by storing the timestamp as
-                       // string and keeping track of that with the corresponding integer
-                       // replacements, and do the replacement here so we can meet the Zipkin API V2
-                       // requirements.
-                       //
-                       // TODO(dio): The right fix for this is to introduce additional knob when
-                       // serializing double in protobuf DoubleToBuffer function, and make it
-                       // available to be controlled at caller site.
-                       // https://github.com/envoyproxy/envoy/issues/10411).
-                       absl::StrAppend(element, absl::StrReplaceAll(json, replacement_values));
-                     }));
-      });
-  return absl::StrCat("[", serialized_elements, "]");
-}
+constexpr char HexDigits[] = "0123456789abcdef";
 
-const std::vector<ProtobufWkt::Struct>
-JsonV2Serializer::toListOfSpans(const Span& zipkin_span, Util::Replacements& replacements) const {
-  std::vector<ProtobufWkt::Struct> spans;
-  spans.reserve(zipkin_span.annotations().size());
-  for (const auto& annotation : zipkin_span.annotations()) {
-    ProtobufWkt::Struct span;
-    auto* fields = span.mutable_fields();
-
-    if (annotation.value() == CLIENT_SEND) {
-      (*fields)[SPAN_KIND] = ValueUtil::stringValue(KIND_CLIENT);
-    } else if (annotation.value() == SERVER_RECV) {
-      if (shared_span_context_ && zipkin_span.annotations().size() > 1) {
-        (*fields)[SPAN_SHARED] = ValueUtil::boolValue(true);
-      }
-      (*fields)[SPAN_KIND] = ValueUtil::stringValue(KIND_SERVER);
-    } else {
+// Appends a JSON string, escaping the quotation marks, the reverse solidi and the control
+// characters.
+void addJsonString(absl::string_view value, Buffer::Instance& output) {
+  output.add("\"", 1);
+  size_t unescaped = 0;
+  for (size_t i = 0; i < value.size(); i++) {
+    const uint8_t c = value[i];
+    if (c != '"' && c != '\\' && c >= 0x20) {
       continue;
     }
-
-    if (annotation.isSetEndpoint()) {
-      // Usually we store number to a ProtobufWkt::Struct object via ValueUtil::numberValue.
-      // However, due to the possibility of rendering that to a number with scientific notation, we
-      // chose to store it as a string and keeping track the corresponding replacement. For example,
-      // we have 1584324295476870 if we stored it as a double value, MessageToJsonString gives
-      // us 1.58432429547687e+15. Instead we store it as the string of 1584324295476870 (when it is
-      // serialized: "1584324295476870"), and replace it post MessageToJsonString serialization with
-      // integer (1584324295476870 without `"`), see: JsonV2Serializer::serialize.
-      (*fields)[SPAN_TIMESTAMP] =
-          Util::uint64Value(annotation.timestamp(), SPAN_TIMESTAMP, replacements);
-      (*fields)[SPAN_LOCAL_ENDPOINT] =
-          ValueUtil::structValue(toProtoEndpoint(annotation.endpoint()));
+    output.add(value.data() + unescaped, i - unescaped);
+    unescaped = i + 1;
+    switch (c) {
+    case '"':
+      output.add("\\\"", 2);
+      break;
+    case '\\':
+      output.add("\\\\", 2);
+      break;
+    case '\n':
+      output.add("\\n", 2);
+      break;
+    case '\r':
+      output.add("\\r", 2);
+      break;
+    case '\t':
+      output.add("\\t", 2);
+      break;
+    default: {
+      const char escaped[] = {'\\', 'u', '0', '0', HexDigits[c >> 4], HexDigits[c & 0xf]};
+      output.add(escaped, sizeof(escaped));
+      break;
     }
-
-    (*fields)[SPAN_TRACE_ID] = ValueUtil::stringValue(zipkin_span.traceIdAsHexString());
-    if (zipkin_span.isSetParentId()) {
-      (*fields)[SPAN_PARENT_ID] = ValueUtil::stringValue(zipkin_span.parentIdAsHexString());
     }
+  }
+  output.add(value.data() + unescaped, value.size() - unescaped);
+  output.add("\"", 1);
+}
 
-    (*fields)[SPAN_ID] = ValueUtil::stringValue(zipkin_span.idAsHexString());
+// Writes the 16 hex digits of an id as rendered by Hex::uint64ToHex, returning the end of them.
+char* writeHex(uint64_t value, char* out) {
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    *out++ = HexDigits[(value >> shift) & 0xf];
+  }
+  return out;
+}
 
-    const auto& span_name = zipkin_span.name();
-    if (!span_name.empty()) {
-      (*fields)[SPAN_NAME] = ValueUtil::stringValue(span_name);
-    }
+void addJsonId(uint64_t id, Buffer::Instance& output) {
+  char json[18];
+  json[0] = '"';
+  *writeHex(id, json + 1) = '"';
+  output.add(json, sizeof(json));
+}
 
-    if (zipkin_span.isSetDuration()) {
-      // Since SPAN_DURATION has the same data type with SPAN_TIMESTAMP, we use Util::uint64Value to
-      // store it.
-      (*fields)[SPAN_DURATION] =
-          Util::uint64Value(zipkin_span.duration(), SPAN_DURATION, replacements);
-    }
+void addJsonTraceId(const Span& zipkin_span, Buffer::Instance& output) {
+  char json[34];
+  char* out = json;
+  *out++ = '"';
+  if (zipkin_span.isSetTraceIdHigh()) {
+    out = writeHex(zipkin_span.traceIdHigh(), out);
+  }
+  out = writeHex(zipkin_span.traceId(), out);
+  *out++ = '"';
+  output.add(json, out - json);
+}
 
-    const auto& binary_annotations = zipkin_span.binaryAnnotations();
-    if (!binary_annotations.empty()) {
-      ProtobufWkt::Struct tags;
-      auto* tag_fields = tags.mutable_fields();
-      for (const auto& binary_annotation : binary_annotations) {
-        (*tag_fields)[binary_annotation.key()] = ValueUtil::stringValue(binary_annotation.value());
-      }
-      (*fields)[SPAN_TAGS] = ValueUtil::structValue(tags);
+/**
+ * Writes the fields of a JSON object into a buffer.
+ */
+class JsonObjectWriter {
+public:
+  explicit JsonObjectWriter(Buffer::Instance& output) : output_(output) { output_.add("{", 1); }
+
+  /**
+   * Starts a field.
+   * @return the buffer the value of the field is to be appended to.
+   */
+  Buffer::Instance& field(absl::string_view key) {
+    if (has_fields_) {
+      output_.add(",", 1);
     }
-
-    spans.push_back(std::move(span));
+    has_fields_ = true;
+    addJsonString(key, output_);
+    output_.add(":", 1);
+    return output_;
   }
-  return spans;
-}
 
-const ProtobufWkt::Struct JsonV2Serializer::toProtoEndpoint(const Endpoint& zipkin_endpoint) const {
-  ProtobufWkt::Struct endpoint;
-  auto* fields = endpoint.mutable_fields();
+  void addString(absl::string_view key, absl::string_view value) {
+    addJsonString(value, field(key));
+  }
 
-  Network::Address::InstanceConstSharedPtr address = zipkin_endpoint.address();
-  if (address) {
-    if (address->ip()->version() == Network::Address::IpVersion::v4) {
-      (*fields)[ENDPOINT_IPV4] = ValueUtil::stringValue(address->ip()->addressAsString());
-    } else {
-      (*fields)[ENDPOINT_IPV6] = ValueUtil::stringValue(address->ip()->addressAsString());
-    }
-    (*fields)[ENDPOINT_PORT] = ValueUtil::numberValue(address->ip()->port());
+  // The Zipkin API V2 specification mandates to store timestamp value as int64, so the numbers are
+  // rendered as integers rather than as the doubles of a ProtobufWkt::Struct, see
+  // https://github.com/envoyproxy/envoy/issues/9341#issuecomment-566912973.
+  void addNumber(absl::string_view key, uint64_t value) {
+    char number[StringUtil::MIN_ITOA_OUT_LEN];
+    field(key).add(number, StringUtil::itoa(number, sizeof(number), value));
   }
 
-  const std::string& service_name = zipkin_endpoint.serviceName();
-  if (!service_name.empty()) {
-    (*fields)[ENDPOINT_SERVICE_NAME] = ValueUtil::stringValue(service_name);
+  void addBool(absl::string_view key, bool value) {
+    field(key).add(value ? absl::string_view("true") : absl::string_view("false"));
   }
 
-  return endpoint;
-}
+  void close() { output_.add("}", 1); }
 
-ProtobufSerializer::ProtobufSerializer(const bool shared_span_context)
+private:
+  Buffer::Instance& output_;
+  bool has_fields_{};
+};
+
+} // namespace
+
+JsonV2Serializer::JsonV2Serializer(const bool shared_span_context)
     : shared_span_context_{shared_span_context} {}
 
-std::string ProtobufSerializer::serialize(const std::vector<Span>& zipkin_spans) {
-  zipkin::proto3::ListOfSpans spans;
+void JsonV2Serializer::serialize(const std::vector<Span>& zipkin_spans, Buffer::Instance& output) {
+  output.add("[", 1);
+  bool first = true;
   for (const Span& zipkin_span : zipkin_spans) {
-    spans.MergeFrom(toListOfSpans(zipkin_span));
+    for (const auto& annotation : zipkin_span.annotations()) {
+      if (annotation.value() != CLIENT_SEND && annotation.value() != SERVER_RECV) {
+        continue;
+      }
+      if (!first) {
+        output.add(",", 1);
+      }
+      first = false;
+      addSpan(zipkin_span, annotation, output);
+    }
   }
-  std::string serialized;
-  spans.SerializeToString(&serialized);
-  return serialized;
+  output.add("]", 1);
 }
 
-const zipkin::proto3::ListOfSpans ProtobufSerializer::toListOfSpans(const Span& zipkin_span) const {
-  zipkin::proto3::ListOfSpans spans;
-  for (const auto& annotation : zipkin_span.annotations()) {
-    zipkin::proto3::Span span;
-    if (annotation.value() == CLIENT_SEND) {
-      span.set_kind(zipkin::proto3::Span::CLIENT);
-    } else if (annotation.value() == SERVER_RECV) {
-      span.set_shared(shared_span_context_ && zipkin_span.annotations().size() > 1);
-      span.set_kind(zipkin::proto3::Span::SERVER);
-    } else {
-      continue;
-    }
+void JsonV2Serializer::addSpan(const Span& zipkin_span, const Annotation& annotation,
+                               Buffer::Instance& output) const {
+  JsonObjectWriter span(output);
 
-    if (annotation.isSetEndpoint()) {
-      span.set_timestamp(annotation.timestamp());
-      span.mutable_local_endpoint()->MergeFrom(toProtoEndpoint(annotation.endpoint()));
-    }
+  addJsonTraceId(zipkin_span, span.field(SPAN_TRACE_ID));
+  if (zipkin_span.isSetParentId()) {
+    addJsonId(zipkin_span.parentId(), span.field(SPAN_PARENT_ID));
+  }
+  addJsonId(zipkin_span.id(), span.field(SPAN_ID));
 
-    span.set_trace_id(zipkin_span.traceIdAsByteString());
-    if (zipkin_span.isSetParentId()) {
-      span.set_parent_id(zipkin_span.parentIdAsByteString());
-    }
+  const bool server = annotation.value() == SERVER_RECV;
+  span.addString(SPAN_KIND, server ? KIND_SERVER : KIND_CLIENT);
 
-    span.set_id(zipkin_span.idAsByteString());
-    span.set_name(zipkin_span.name());
+  const auto& span_name = zipkin_span.name();
+  if (!span_name.empty()) {
+    span.addString(SPAN_NAME, span_name);
+  }
+
+  if (annotation.isSetEndpoint()) {
+    span.addNumber(SPAN_TIMESTAMP, annotation.timestamp());
+  }
+  if (zipkin_span.isSetDuration()) {
+    span.addNumber(SPAN_DURATION, zipkin_span.duration());
+  }
 
-    if (zipkin_span.isSetDuration()) {
-      span.set_duration(zipkin_span.duration());
+  if (annotation.isSetEndpoint()) {
+    const Endpoint& zipkin_endpoint = annotation.endpoint();
+    JsonObjectWriter endpoint(span.field(SPAN_LOCAL_ENDPOINT));
+    const std::string& service_name = zipkin_endpoint.serviceName();
+    if (!service_name.empty()) {
+      endpoint.addString(ENDPOINT_SERVICE_NAME, service_name);
     }
+    Network::Address::InstanceConstSharedPtr address = zipkin_endpoint.address();
+    if (address) {
+      endpoint.addString(address->ip()->version() == Network::Address::IpVersion::v4
+                             ? ENDPOINT_IPV4
+                             : ENDPOINT_IPV6,
+                         address->ip()->addressAsString());
+      endpoint.addNumber(ENDPOINT_PORT, address->ip()->port());
+    }
+    endpoint.close();
+  }
 
-    auto& tags = *span.mutable_tags();
-    for (const auto& binary_annotation : zipkin_span.binaryAnnotations()) {
-      tags[binary_annotation.key()] = binary_annotation.value();
+  const auto& binary_annotations = zipkin_span.binaryAnnotations();
+  if (!binary_annotations.empty()) {
+    JsonObjectWriter tags(span.field(SPAN_TAGS));
+    for (const auto& binary_annotation : binary_annotations) {
+      tags.addString(binary_annotation.key(), binary_annotation.value());
     }
+    tags.close();
+  }
 
-    auto* mutable_span = spans.add_spans();
-    mutable_span->MergeFrom(span);
+  if (server && shared_span_context_ && zipkin_span.annotations().size() > 1) {
+    span.addBool(SPAN_SHARED, true);
   }
-  return spans;
+
+  span.close();
+}
+
+namespace {
+
+// See https://developers.google.com/protocol-buffers/docs/encoding#structure.
+constexpr uint32_t ProtobufVarintField = 0;
+constexpr uint32_t ProtobufFixed64Field = 1;
+constexpr uint32_t ProtobufLengthDelimitedField = 2;
+
+// The fields of the entries of map<string, string> tags.
+constexpr uint32_t TagKeyFieldNumber = 1;
+constexpr uint32_t TagValueFieldNumber = 2;
+
+uint32_t makeTag(uint32_t field_number, uint32_t wire_type) {
+  return (field_number << 3) | wire_type;
+}
+
+size_t varintFieldSize(uint32_t field_number, uint64_t value) {
+  return CodedOutputStream::VarintSize32(makeTag(field_number, ProtobufVarintField)) +
+         CodedOutputStream::VarintSize64(value);
+}
+
+size_t fixed64FieldSize(uint32_t field_number) {
+  return CodedOutputStream::VarintSize32(makeTag(field_number, ProtobufFixed64Field)) +
+         sizeof(uint64_t);
+}
+
+size_t lengthDelimitedFieldSize(uint32_t field_number, size_t length) {
+  return CodedOutputStream::VarintSize32(makeTag(field_number, ProtobufLengthDelimitedField)) +
+         CodedOutputStream::VarintSize64(length) + length;
 }
 
-const zipkin::proto3::Endpoint
-ProtobufSerializer::toProtoEndpoint(const Endpoint& zipkin_endpoint) const {
-  zipkin::proto3::Endpoint endpoint;
+void writeVarintField(uint32_t field_number, uint64_t value, CodedOutputStream& stream) {
+  stream.WriteTag(makeTag(field_number, ProtobufVarintField));
+  stream.WriteVarint64(value);
+}
+
+void writeFixed64Field(uint32_t field_number, uint64_t value, CodedOutputStream& stream) {
+  stream.WriteTag(makeTag(field_number, ProtobufFixed64Field));
+  stream.WriteLittleEndian64(value);
+}
+
+// Writes the key and the length of a length-delimited field, which is to be followed by its
+// contents.
+void writeLengthDelimitedField(uint32_t field_number, size_t length, CodedOutputStream& stream) {
+  stream.WriteTag(makeTag(field_number, ProtobufLengthDelimitedField));
+  stream.WriteVarint64(length);
+}
+
+void writeBytesField(uint32_t field_number, const void* data, size_t length,
+                     CodedOutputStream& stream) {
+  writeLengthDelimitedField(field_number, length, stream);
+  stream.WriteRaw(data, length);
+}
+
+zipkin::proto3::Span::Kind spanKind(const Annotation& annotation) {
+  if (annotation.value() == CLIENT_SEND) {
+    return zipkin::proto3::Span::CLIENT;
+  }
+  if (annotation.value() == SERVER_RECV) {
+    return zipkin::proto3::Span::SERVER;
+  }
+  return zipkin::proto3::Span::SPAN_KIND_UNSPECIFIED;
+}
+
+// https://github.com/openzipkin/zipkin-api/blob/v0.2.1/zipkin.proto#L60-L61: the trace id is
+// big-endian, with the high 64 bits first.
+size_t traceIdSize(const Span& zipkin_span) {
+  return zipkin_span.isSetTraceIdHigh() ? 2 * sizeof(uint64_t) : sizeof(uint64_t);
+}
+
+void writeTraceId(const Span& zipkin_span, CodedOutputStream& stream) {
+  writeLengthDelimitedField(zipkin::proto3::Span::kTraceIdFieldNumber, traceIdSize(zipkin_span),
+                            stream);
+  if (zipkin_span.isSetTraceIdHigh()) {
+    const uint64_t high = toEndianness<ByteOrder::BigEndian>(zipkin_span.traceIdHigh());
+    stream.WriteRaw(&high, sizeof(high));
+  }
+  const uint64_t low = toEndianness<ByteOrder::BigEndian>(zipkin_span.traceId());
+  stream.WriteRaw(&low, sizeof(low));
+}
+
+size_t endpointSize(const Endpoint& zipkin_endpoint) {
+  size_t size = 0;
+  const std::string& service_name = zipkin_endpoint.serviceName();
+  if (!service_name.empty()) {
+    size += lengthDelimitedFieldSize(zipkin::proto3::Endpoint::kServiceNameFieldNumber,
+                                     service_name.size());
+  }
   Network::Address::InstanceConstSharedPtr address = zipkin_endpoint.address();
   if (address) {
     if (address->ip()->version() == Network::Address::IpVersion::v4) {
-      endpoint.set_ipv4(Util::toByteString(address->ip()->ipv4()->address()));
+      size += lengthDelimitedFieldSize(zipkin::proto3::Endpoint::kIpv4FieldNumber,
+                                       sizeof(address->ip()->ipv4()->address()));
     } else {
-      endpoint.set_ipv6(Util::toByteString(address->ip()->ipv6()->address()));
+      size += lengthDelimitedFieldSize(zipkin::proto3::Endpoint::kIpv6FieldNumber,
+                                       sizeof(address->ip()->ipv6()->address()));
+    }
+    if (address->ip()->port() != 0) {
+      size += varintFieldSize(zipkin::proto3::Endpoint::kPortFieldNumber, address->ip()->port());
     }
-    endpoint.set_port(address->ip()->port());
   }
+  return size;
+}
 
+void writeEndpoint(const Endpoint& zipkin_endpoint, CodedOutputStream& stream) {
   const std::string& service_name = zipkin_endpoint.serviceName();
   if (!service_name.empty()) {
-    endpoint.set_service_name(service_name);
+    writeBytesField(zipkin::proto3::Endpoint::kServiceNameFieldNumber, service_name.data(),
+                    service_name.size(), stream);
+  }
+  Network::Address::InstanceConstSharedPtr address = zipkin_endpoint.address();
+  if (address) {
+    // The addresses are in network byte order, as in Util::toByteString.
+    if (address->ip()->version() == Network::Address::IpVersion::v4) {
+      const auto ipv4 = address->ip()->ipv4()->address();
+      writeBytesField(zipkin::proto3::Endpoint::kIpv4FieldNumber, &ipv4, sizeof(ipv4), stream);
+    } else {
+      const auto ipv6 = address->ip()->ipv6()->address();
+      writeBytesField(zipkin::proto3::Endpoint::kIpv6FieldNumber, &ipv6, sizeof(ipv6), stream);
+    }
+    if (address->ip()->port() != 0) {
+      writeVarintField(zipkin::proto3::Endpoint::kPortFieldNumber, address->ip()->port(), stream);
+    }
+  }
+}
+
+size_t tagSize(const BinaryAnnotation& binary_annotation) {
+  return lengthDelimitedFieldSize(TagKeyFieldNumber, binary_annotation.key().size()) +
+         lengthDelimitedFieldSize(TagValueFieldNumber, binary_annotation.value().size());
+}
+
+} // namespace
+
+ProtobufSerializer::ProtobufSerializer(const bool shared_span_context)
+    : shared_span_context_{shared_span_context} {}
+
+void ProtobufSerializer::serialize(const std::vector<Span>& zipkin_spans,
+                                   Buffer::Instance& output) {
+  // The sizes of the spans are computed first, so that the whole list is encoded into a single
+  // slice.
+  size_t size = 0;
+  for (const Span& zipkin_span : zipkin_spans) {
+    for (const auto& annotation : zipkin_span.annotations()) {
+      const auto kind = spanKind(annotation);
+      if (kind != zipkin::proto3::Span::SPAN_KIND_UNSPECIFIED) {
+        size += lengthDelimitedFieldSize(zipkin::proto3::ListOfSpans::kSpansFieldNumber,
+                                         spanSize(zipkin_span, annotation, kind));
+      }
+    }
+  }
+  if (size == 0) {
+    return;
+  }
+
+  Buffer::RawSlice iovec;
+  output.reserve(size, &iovec, 1);
+  ASSERT(iovec.len_ >= size);
+  iovec.len_ = size;
+  {
+    Protobuf::io::ArrayOutputStream array_stream(iovec.mem_, size, -1);
+    CodedOutputStream stream(&array_stream);
+    for (const Span& zipkin_span : zipkin_spans) {
+      for (const auto& annotation : zipkin_span.annotations()) {
+        const auto kind = spanKind(annotation);
+        if (kind != zipkin::proto3::Span::SPAN_KIND_UNSPECIFIED) {
+          writeLengthDelimitedField(zipkin::proto3::ListOfSpans::kSpansFieldNumber,
+                                    spanSize(zipkin_span, annotation, kind), stream);
+          writeSpan(zipkin_span, annotation, kind, stream);
+        }
+      }
+    }
+    ASSERT(static_cast<size_t>(stream.ByteCount()) == size);
+  }
+  output.commit(&iovec, 1);
+}
+
+bool ProtobufSerializer::isShared(const Span& zipkin_span, zipkin::proto3::Span::Kind kind) const {
+  return kind == zipkin::proto3::Span::SERVER && shared_span_context_ &&
+         zipkin_span.annotations().size() > 1;
+}
+
+// The fields are sized and written in the order of their numbers, and those with default values
+// are skipped, as zipkin::proto3::Span::SerializeToString would do.
+size_t ProtobufSerializer::spanSize(const Span& zipkin_span, const Annotation& annotation,
+                                    zipkin::proto3::Span::Kind kind) const {
+  size_t size = lengthDelimitedFieldSize(zipkin::proto3::Span::kTraceIdFieldNumber,
+                                         traceIdSize(zipkin_span));
+  if (zipkin_span.isSetParentId()) {
+    size += lengthDelimitedFieldSize(zipkin::proto3::Span::kParentIdFieldNumber, sizeof(uint64_t));
+  }
+  size += lengthDelimitedFieldSize(zipkin::proto3::Span::kIdFieldNumber, sizeof(uint64_t));
+  size += varintFieldSize(zipkin::proto3::Span::kKindFieldNumber, kind);
+  if (!zipkin_span.name().empty()) {
+    size += lengthDelimitedFieldSize(zipkin::proto3::Span::kNameFieldNumber,
+                                     zipkin_span.name().size());
+  }
+  if (annotation.isSetEndpoint() && annotation.timestamp() != 0) {
+    size += fixed64FieldSize(zipkin::proto3::Span::kTimestampFieldNumber);
+  }
+  if (zipkin_span.isSetDuration() && zipkin_span.duration() != 0) {
+    size += varintFieldSize(zipkin::proto3::Span::kDurationFieldNumber, zipkin_span.duration());
+  }
+  if (annotation.isSetEndpoint()) {
+    size += lengthDelimitedFieldSize(zipkin::proto3::Span::kLocalEndpointFieldNumber,
+                                     endpointSize(annotation.endpoint()));
+  }
+  for (const auto& binary_annotation : zipkin_span.binaryAnnotations()) {
+    size += lengthDelimitedFieldSize(zipkin::proto3::Span::kTagsFieldNumber,
+                                     tagSize(binary_annotation));
+  }
+  if (isShared(zipkin_span, kind)) {
+    size += varintFieldSize(zipkin::proto3::Span::kSharedFieldNumber, 1);
   }
+  return size;
+}
 
-  return endpoint;
+void ProtobufSerializer::writeSpan(const Span& zipkin_span, const Annotation& annotation,
+                                   zipkin::proto3::Span::Kind kind,
+                                   CodedOutputStream& stream) const {
+  writeTraceId(zipkin_span, stream);
+  // The span ids are in host byte order, as in Util::toByteString.
+  if (zipkin_span.isSetParentId()) {
+    const uint64_t parent_id = zipkin_span.parentId();
+    writeBytesField(zipkin::proto3::Span::kParentIdFieldNumber, &parent_id, sizeof(parent_id),
+                    stream);
+  }
+  const uint64_t id = zipkin_span.id();
+  writeBytesField(zipkin::proto3::Span::kIdFieldNumber, &id, sizeof(id), stream);
+  writeVarintField(zipkin::proto3::Span::kKindFieldNumber, kind, stream);
+  const std::string& name = zipkin_span.name();
+  if (!name.empty()) {
+    writeBytesField(zipkin::proto3::Span::kNameFieldNumber, name.data(), name.size(), stream);
+  }
+  if (annotation.isSetEndpoint() && annotation.timestamp() != 0) {
+    writeFixed64Field(zipkin::proto3::Span::kTimestampFieldNumber, annotation.timestamp(), stream);
+  }
+  if (zipkin_span.isSetDuration() && zipkin_span.duration() != 0) {
+    writeVarintField(zipkin::proto3::Span::kDurationFieldNumber, zipkin_span.duration(), stream);
+  }
+  if (annotation.isSetEndpoint()) {
+    writeLengthDelimitedField(zipkin::proto3::Span::kLocalEndpointFieldNumber,
+                              endpointSize(annotation.endpoint()), stream);
+    writeEndpoint(annotation.endpoint(), stream);
+  }
+  for (const auto& binary_annotation : zipkin_span.binaryAnnotations()) {
+    const std::string& key = binary_annotation.key();
+    const std::string& value = binary_annotation.value();
+    writeLengthDelimitedField(zipkin::proto3::Span::kTagsFieldNumber, tagSize(binary_annotation),
+                              stream);
+    writeBytesField(TagKeyFieldNumber, key.data(), key.size(), stream);
+    writeBytesField(TagValueFieldNumber, value.data(), value.size(), stream);
+  }
+  if (isShared(zipkin_span, kind)) {
+    writeVarintField(zipkin::proto3::Span::kSharedFieldNumber, 1, stream);
+  }
 }
 
 } // namespace Zipkin
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/config/trace/v3/zipkin.pb.h"
 
 #include "common/protobuf/protobuf.h"
@@ -72,14 +73,19 @@ public:
   uint64_t pendingSpans() { return span_buffer_.size(); }
 
   /**
-   * Serializes std::vector<Span> span_buffer_ to std::string as payload for the reporter when the
-   * reporter does spans flushing. This function does only serialization and does not clear
-   * span_buffer_.
+   * Serializes std::vector<Span> span_buffer_ into the payload for the reporter when the reporter
+   * does spans flushing. This function does only serialization and does not clear span_buffer_.
    *
+   * @param output supplies the buffer the collection of serialized pending Zipkin spans is
+   * appended to.
+   */
+  void serialize(Buffer::Instance& output) const { serializer_->serialize(span_buffer_, output); }
+
+  /**
    * @return std::string the contents of the buffer, a collection of serialized pending Zipkin
    * spans.
    */
-  std::string serialize() const { return serializer_->serialize(span_buffer_); }
+  std::string serialize() const;
 
 private:
   SerializerPtr
@@ -103,14 +109,14 @@ public:
 
   /**
    * Serialize list of Zipkin spans into Zipkin v1 JSON array.
-   * @return std::string serialized pending spans as Zipkin v1 JSON array.
    */
-  std::string serialize(const std::vector<Span>& pending_spans) override;
+  void serialize(const std::vector<Span>& pending_spans, Buffer::Instance& output) override;
 };
 
 /**
  * JsonV2Serializer implements Zipkin::Serializer that serializes list of Zipkin spans into JSON
- * Zipkin v2 array.
+ * Zipkin v2 array. The JSON is written straight into the output buffer, without building a
+ * ProtobufWkt::Struct for each span first.
  */
 class JsonV2Serializer : public Serializer {
 public:
@@ -118,21 +124,20 @@ public:
 
   /**
    * Serialize list of Zipkin spans into Zipkin v2 JSON array.
-   * @return std::string serialized pending spans as Zipkin v2 JSON array.
    */
-  std::string serialize(const std::vector<Span>& pending_spans) override;
+  void serialize(const std::vector<Span>& pending_spans, Buffer::Instance& output) override;
 
 private:
-  const std::vector<ProtobufWkt::Struct> toListOfSpans(const Span& zipkin_span,
-                                                       Util::Replacements& replacements) const;
-  const ProtobufWkt::Struct toProtoEndpoint(const Endpoint& zipkin_endpoint) const;
+  void addSpan(const Span& zipkin_span, const Annotation& annotation,
+               Buffer::Instance& output) const;
 
   const bool shared_span_context_;
 };
 
 /**
  * ProtobufSerializer implements Zipkin::Serializer that serializes list of Zipkin spans into
- * stringified (SerializeToString) protobuf message.
+ * zipkin::proto3::ListOfSpans in the protobuf wire format. The fields are encoded straight into
+ * the output buffer, without building the zipkin::proto3::ListOfSpans message first.
  */
 class ProtobufSerializer : public Serializer {
 public:
@@ -140,13 +145,15 @@ public:
 
   /**
    * Serialize list of Zipkin spans into Zipkin v2 zipkin::proto3::ListOfSpans.
-   * @return std::string serialized pending spans as Zipkin zipkin::proto3::ListOfSpans.
    */
-  std::string serialize(const std::vector<Span>& pending_spans) override;
+  void serialize(const std::vector<Span>& pending_spans, Buffer::Instance& output) override;
 
 private:
-  const zipkin::proto3::ListOfSpans toListOfSpans(const Span& zipkin_span) const;
-  const zipkin::proto3::Endpoint toProtoEndpoint(const Endpoint& zipkin_endpoint) const;
+  bool isShared(const Span& zipkin_span, zipkin::proto3::Span::Kind kind) const;
+  size_t spanSize(const Span& zipkin_span, const Annotation& annotation,
+                  zipkin::proto3::Span::Kind kind) const;
+  void writeSpan(const Span& zipkin_span, const Annotation& annotation,
+                 zipkin::proto3::Span::Kind kind, Protobuf::io::CodedOutputStream& stream) const;
 
   const bool shared_span_context_;
 };
@@ -123,6 +123,61 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
   return span_ptr;
 }
 
+SpanContext Tracer::startSpanContext(bool sampled) {
+  const uint64_t random_number = random_generator_.random();
+  const uint64_t trace_id_high = trace_id_128bit_ ? random_generator_.random() : 0;
+  return {trace_id_high, random_number, random_number, 0, sampled};
+}
+
+SpanContext Tracer::startSpanContext(const Tracing::Config& config,
+                                     const SpanContext& previous_context) {
+  if (config.operationName() == Tracing::OperationName::Egress || !shared_span_context_) {
+    // A child of the previous span.
+    return {previous_context.traceIdHigh(), previous_context.traceId(), random_generator_.random(),
+            previous_context.id(), previous_context.sampled()};
+  }
+  // A span sharing the context of the previous span.
+  return {previous_context.traceIdHigh(), previous_context.traceId(), previous_context.id(),
+          previous_context.parentId(), previous_context.sampled()};
+}
+
+SpanPtr Tracer::startSpan(Tracing::OperationName operation_name, const std::string& span_name,
+                          SystemTime timestamp, const SpanContext& context, bool root) {
+  SpanPtr span_ptr = std::make_unique<Span>(time_source_);
+  span_ptr->setName(span_name);
+  span_ptr->setId(context.id());
+  if (context.parentId()) {
+    span_ptr->setParentId(context.parentId());
+  }
+  span_ptr->setTraceId(context.traceId());
+  if (context.is128BitTraceId()) {
+    span_ptr->setTraceIdHigh(context.traceIdHigh());
+  }
+  span_ptr->setSampled(context.sampled());
+
+  const uint64_t timestamp_micro =
+      std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+  Annotation annotation;
+  if (!root && operation_name == Tracing::OperationName::Ingress && shared_span_context_) {
+    // A span sharing the context of the previous span.
+    annotation.setValue(SERVER_RECV);
+  } else {
+    annotation.setValue(root && operation_name == Tracing::OperationName::Ingress ? SERVER_RECV
+                                                                                 : CLIENT_SEND);
+    span_ptr->setTimestamp(timestamp_micro);
+  }
+  annotation.setEndpoint(Endpoint(service_name_, address_));
+  annotation.setTimestamp(timestamp_micro);
+  span_ptr->addAnnotation(std::move(annotation));
+
+  span_ptr->setStartTime(std::chrono::duration_cast<std::chrono::microseconds>(
+                             time_source_.monotonicTime().time_since_epoch())
+                             .count());
+  span_ptr->setTracer(this);
+
+  return span_ptr;
+}
+
 void Tracer::reportSpan(Span&& span) {
   if (reporter_ && span.sampled()) {
     reporter_->reportSpan(std::move(span));
@@ -88,6 +88,41 @@ public:
   SpanPtr startSpan(const Tracing::Config&, const std::string& span_name, SystemTime timestamp,
                     const SpanContext& previous_context);
 
+  /**
+   * Creates the context of a "root" span which is only propagated, since its trace is not sampled.
+   * The ids are those startSpan() would give to the span, but no span is created.
+   *
+   * @param sampled The sampling decision to propagate.
+   * @return SpanContext The context of the root span.
+   */
+  SpanContext startSpanContext(bool sampled);
+
+  /**
+   * Depending on the given context, creates the context of either a "child" or a "shared-context"
+   * span which is only propagated, since its trace is not sampled. The ids are those startSpan()
+   * would give to the span, but no span is created.
+   *
+   * @param config The tracing configuration
+   * @param previous_context The context of the span preceding the one to be created.
+   * @return SpanContext The context of the child span.
+   */
+  SpanContext startSpanContext(const Tracing::Config& config, const SpanContext& previous_context);
+
+  /**
+   * Creates the span of a context made by startSpanContext(), once the sampling decision of the
+   * span which was only propagated is overridden. The span keeps the ids of the context, and gets
+   * the annotation startSpan() would have given it.
+   *
+   * @param operation_name The operation of the span.
+   * @param span_name Name of the new span.
+   * @param timestamp The timestamp of the span.
+   * @param context The context of the span.
+   * @param root Whether the context was made for a "root" span.
+   * @return SpanPtr The new span.
+   */
+  SpanPtr startSpan(Tracing::OperationName operation_name, const std::string& span_name,
+                    SystemTime timestamp, const SpanContext& context, bool root);
+
   /**
    * TracerInterface::reportSpan.
    *
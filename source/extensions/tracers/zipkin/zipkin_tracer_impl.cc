@@ -4,11 +4,13 @@
 
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/config/utility.h"
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/http/utility.h"
+#include "common/runtime/runtime_features.h"
 #include "common/tracing/http_tracer_impl.h"
 
 #include "extensions/tracers/zipkin/span_context_extractor.h"
@@ -65,6 +67,89 @@ Tracing::SpanPtr ZipkinSpan::spawnChild(const Tracing::Config& config, const std
       *tracer_.startSpan(config, name, start_time, previous_context), tracer_);
 }
 
+ZipkinPropagationSpan::ZipkinPropagationSpan(const SpanContext& context, Zipkin::Tracer& tracer,
+                                             Tracing::OperationName operation_name,
+                                             const std::string& name, SystemTime start_time,
+                                             bool root)
+    : context_(context), sampled_(context.sampled()), tracer_(tracer),
+      operation_name_(operation_name), name_(name), start_time_(start_time), root_(root) {}
+
+void ZipkinPropagationSpan::setOperation(absl::string_view operation) {
+  if (recording_span_ != nullptr) {
+    recording_span_->setOperation(operation);
+  } else {
+    name_ = std::string(operation);
+  }
+}
+
+void ZipkinPropagationSpan::setTag(absl::string_view name, absl::string_view value) {
+  if (recording_span_ != nullptr) {
+    recording_span_->setTag(name, value);
+  }
+}
+
+void ZipkinPropagationSpan::log(SystemTime timestamp, const std::string& event) {
+  if (recording_span_ != nullptr) {
+    recording_span_->log(timestamp, event);
+  }
+}
+
+void ZipkinPropagationSpan::finishSpan() {
+  if (recording_span_ != nullptr) {
+    recording_span_->finishSpan();
+  }
+}
+
+void ZipkinPropagationSpan::injectContext(Http::RequestHeaderMap& request_headers) {
+  if (recording_span_ != nullptr) {
+    recording_span_->injectContext(request_headers);
+    return;
+  }
+  request_headers.setReferenceKey(
+      ZipkinCoreConstants::get().X_B3_TRACE_ID,
+      context_.is128BitTraceId()
+          ? absl::StrCat(Hex::uint64ToHex(context_.traceIdHigh()),
+                         Hex::uint64ToHex(context_.traceId()))
+          : Hex::uint64ToHex(context_.traceId()));
+  request_headers.setReferenceKey(ZipkinCoreConstants::get().X_B3_SPAN_ID,
+                                  Hex::uint64ToHex(context_.id()));
+  if (context_.parentId()) {
+    request_headers.setReferenceKey(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID,
+                                    Hex::uint64ToHex(context_.parentId()));
+  }
+  request_headers.setReferenceKey(ZipkinCoreConstants::get().X_B3_SAMPLED,
+                                  sampled_ ? SAMPLED : NOT_SAMPLED);
+}
+
+Tracing::SpanPtr ZipkinPropagationSpan::spawnChild(const Tracing::Config& config,
+                                                   const std::string& name,
+                                                   SystemTime start_time) {
+  if (recording_span_ != nullptr) {
+    return recording_span_->spawnChild(config, name, start_time);
+  }
+  if (sampled_) {
+    return std::make_unique<ZipkinSpan>(*tracer_.startSpan(config, name, start_time, context()),
+                                        tracer_);
+  }
+  return std::make_unique<ZipkinPropagationSpan>(tracer_.startSpanContext(config, context()),
+                                                 tracer_, config.operationName(), name, start_time,
+                                                 false);
+}
+
+void ZipkinPropagationSpan::setSampled(bool sampled) {
+  sampled_ = sampled;
+  if (recording_span_ != nullptr) {
+    recording_span_->setSampled(sampled);
+  } else if (sampled) {
+    recording_span_ = std::make_unique<ZipkinSpan>(
+        *tracer_.startSpan(operation_name_, name_, start_time_, context(), root_), tracer_);
+  }
+}
+
+SpanContext ZipkinPropagationSpan::context() const {
+  return {context_.traceIdHigh(), context_.traceId(), context_.id(), context_.parentId(), sampled_};
+}
+
 Driver::TlsTracer::TlsTracer(TracerPtr&& tracer, Driver& driver)
     : tracer_(std::move(tracer)), driver_(driver) {}
 
@@ -114,6 +199,19 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config,
   bool sampled{extractor.extractSampled(tracing_decision)};
   try {
     auto ret_span_context = extractor.extractSpanContext(sampled);
+    if (!sampled &&
+        Runtime::runtimeFeatureEnabled("envoy.reloadable_features.zipkin_propagation_only_spans")) {
+      // The trace is not sampled, so only its context is propagated.
+      const std::string name(request_headers.getHostValue());
+      if (!ret_span_context.second) {
+        return std::make_unique<ZipkinPropagationSpan>(tracer.startSpanContext(sampled), tracer,
+                                                       config.operationName(), name, start_time,
+                                                       true);
+      }
+      return std::make_unique<ZipkinPropagationSpan>(
+          tracer.startSpanContext(config, ret_span_context.first), tracer, config.operationName(),
+          name, start_time, false);
+    }
     if (!ret_span_context.second) {
       // Create a root Zipkin span. No context was found in the headers.
       new_zipkin_span =
@@ -176,7 +274,6 @@ void ReporterImpl::enableTimer() {
 void ReporterImpl::flushSpans() {
   if (span_buffer_->pendingSpans()) {
     driver_.tracerStats().spans_sent_.add(span_buffer_->pendingSpans());
-    const std::string request_body = span_buffer_->serialize();
     Http::RequestMessagePtr message = std::make_unique<Http::RequestMessageImpl>();
     message->headers().setReferenceMethod(Http::Headers::get().MethodValues.Post);
     message->headers().setPath(collector_.endpoint_);
@@ -187,7 +284,7 @@ void ReporterImpl::flushSpans() {
             : Http::Headers::get().ContentTypeValues.Json);
 
     Buffer::InstancePtr body = std::make_unique<Buffer::OwnedImpl>();
-    body->add(request_body);
+    span_buffer_->serialize(*body);
     message->body() = std::move(body);
 
     const uint64_t timeout =
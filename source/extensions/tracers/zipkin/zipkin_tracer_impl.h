@@ -11,6 +11,7 @@
 #include "common/http/async_client_utility.h"
 #include "common/http/header_map_impl.h"
 #include "common/json/json_loader.h"
+#include "common/tracing/http_tracer_impl.h"
 #include "common/upstream/cluster_update_tracker.h"
 
 #include "extensions/tracers/zipkin/span_buffer.h"
@@ -80,6 +81,8 @@ public:
   void setBaggage(absl::string_view, absl::string_view) override;
   std::string getBaggage(absl::string_view) override;
 
+  bool isRecording() const override { return true; }
+
   /**
    * @return a reference to the Zipkin::Span object.
    */
@@ -92,6 +95,63 @@ private:
 
 using ZipkinSpanPtr = std::unique_ptr<ZipkinSpan>;
 
+/**
+ * Lightweight span of a Zipkin trace which is not sampled. It only holds the context to inject in
+ * the B3 headers, so that no Zipkin::Span object is built and no tag is computed for it. If its
+ * sampling decision is overridden, e.g. by the async client or the request mirroring of the
+ * router, the span is built and is recorded from then on.
+ */
+class ZipkinPropagationSpan : public Tracing::PropagationSpan {
+public:
+  /**
+   * @param context The context to propagate.
+   * @param tracer The tracer the span is built with, if it is sampled.
+   * @param operation_name The operation of the span.
+   * @param name The name of the span.
+   * @param start_time The start time of the span.
+   * @param root Whether the context is the one of a "root" span, @see Tracer::startSpanContext().
+   */
+  ZipkinPropagationSpan(const SpanContext& context, Zipkin::Tracer& tracer,
+                        Tracing::OperationName operation_name, const std::string& name,
+                        SystemTime start_time, bool root);
+
+  // Tracing::Span
+  void setOperation(absl::string_view operation) override;
+  void setTag(absl::string_view name, absl::string_view value) override;
+  void log(SystemTime timestamp, const std::string& event) override;
+  void finishSpan() override;
+  void injectContext(Http::RequestHeaderMap& request_headers) override;
+  bool isRecording() const override { return recording_span_ != nullptr; }
+
+  /**
+   * The children are propagation-only as well, unless the sampling decision has been overridden.
+   */
+  Tracing::SpanPtr spawnChild(const Tracing::Config& config, const std::string& name,
+                              SystemTime start_time) override;
+
+  /**
+   * Overrides the sampling decision. Once the trace is sampled, the span is built, and it is
+   * reported when finished.
+   */
+  void setSampled(bool sampled) override;
+
+  /**
+   * @return the context to propagate.
+   */
+  SpanContext context() const;
+
+private:
+  const SpanContext context_;
+  bool sampled_;
+  Zipkin::Tracer& tracer_;
+  const Tracing::OperationName operation_name_;
+  std::string name_;
+  const SystemTime start_time_;
+  const bool root_;
+  // The span, once the trace is sampled.
+  ZipkinSpanPtr recording_span_;
+};
+
 /**
  * Class for a Zipkin-specific Driver.
  */
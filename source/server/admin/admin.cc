@@ -710,6 +710,8 @@ AdminImpl::AdminImpl(const std::string& profile_path, Server::Instance& server)
            MAKE_ADMIN_HANDLER(logs_handler_.handlerLogging), false, true},
           {"/memory", "print current allocation/heap usage",
            MAKE_ADMIN_HANDLER(server_info_handler_.handlerMemory), false, false},
+          {"/pprof/profile", "print a CPU profile of the last seconds in pprof format",
+           MAKE_ADMIN_HANDLER(profiling_handler_.handlerPprofProfile), false, false},
           {"/quitquitquit", "exit the server",
            MAKE_ADMIN_HANDLER(server_cmd_handler_.handlerQuitQuitQuit), false, true},
           {"/reset_counters", "reset all counters to zero",
@@ -718,6 +720,12 @@ AdminImpl::AdminImpl(const std::string& profile_path, Server::Instance& server)
            MAKE_ADMIN_HANDLER(listeners_handler_.handlerDrainListeners), false, true},
           {"/server_info", "print server version/status information",
            MAKE_ADMIN_HANDLER(server_info_handler_.handlerServerInfo), false, false},
+          {"/slow_callbacks", "print the event loop callbacks that exceeded the threshold",
+           MAKE_ADMIN_HANDLER(profiling_handler_.handlerSlowCallbacks), false, false},
+          {"/slow_callbacks/disable", "stop recording slow event loop callbacks",
+           MAKE_ADMIN_HANDLER(profiling_handler_.handlerSlowCallbacksDisable), false, true},
+          {"/slow_callbacks/enable", "start recording slow event loop callbacks",
+           MAKE_ADMIN_HANDLER(profiling_handler_.handlerSlowCallbacksEnable), false, true},
           {"/ready", "print server state, return 200 if LIVE, otherwise return 503",
            MAKE_ADMIN_HANDLER(server_info_handler_.handlerReady), false, false},
           {"/stats", "print server stats", MAKE_ADMIN_HANDLER(stats_handler_.handlerStats), false,
@@ -930,6 +938,13 @@ Http::Code AdminImpl::request(absl::string_view path_and_query, absl::string_vie
   Buffer::OwnedImpl response;
 
   Http::Code code = runCallback(path_and_query, response_headers, response, filter);
+  // There is no stream to send chunks to, so a chunked response is generated in full right away.
+  if (filter.chunkGenerator()) {
+    bool more = true;
+    while (more) {
+      more = filter.chunkGenerator()(response);
+    }
+  }
   Utility::populateFallbackResponseHeaders(code, response_headers);
   body = response.toString();
   return code;
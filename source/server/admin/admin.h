@@ -9,6 +9,7 @@
 
 #include "envoy/admin/v3/config_dump.pb.h"
 #include "envoy/admin/v3/server_info.pb.h"
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
 #include "envoy/config/core/v3/base.pb.h"
 #include "envoy/config/route/v3/route.pb.h"
 #include "envoy/extensions/filters/network/http_connection_manager/v3/http_connection_manager.pb.h"
@@ -186,6 +187,14 @@ public:
   void addListenerToHandler(Network::ConnectionHandler* handler) override;
   Server::Instance& server() { return server_; }
 
+  /**
+   * Starts the continuous profiler served by /pprof/profile. Throws EnvoyException on failure.
+   */
+  void
+  startContinuousProfiler(const envoy::config::bootstrap::v3::Admin::ContinuousProfiler& config) {
+    profiling_handler_.startContinuousProfiler(config, server_.dispatcher(), server_.timeSource());
+  }
+
   AdminFilter::AdminServerCallbackFunction createCallbackFunction() {
     return [this](absl::string_view path_and_query, Http::ResponseHeaderMap& response_headers,
                   Buffer::OwnedImpl& response, AdminFilter& filter) -> Http::Code {
@@ -38,6 +38,9 @@ Http::FilterTrailersStatus AdminFilter::decodeTrailers(Http::RequestTrailerMap&)
 }
 
 void AdminFilter::onDestroy() {
+  if (chunk_generator_) {
+    finishChunkedResponse();
+  }
   for (const auto& callback : on_destroy_callbacks_) {
     callback();
   }
@@ -72,6 +75,22 @@ void AdminFilter::onComplete() {
   Utility::populateFallbackResponseHeaders(code, *header_map);
   decoder_callbacks_->streamInfo().setResponseCodeDetails(
       StreamInfo::ResponseCodeDetails::get().AdminFilterResponse);
+  if (chunk_generator_) {
+    // The rest of the body is generated one chunk per dispatcher iteration, so that the main
+    // thread is not blocked and the whole body is never buffered at once.
+    decoder_callbacks_->encodeHeaders(std::move(header_map), false);
+    if (response.length() > 0) {
+      decoder_callbacks_->encodeData(response, false);
+    }
+    decoder_callbacks_->addDownstreamWatermarkCallbacks(*this);
+    next_chunk_cb_ = decoder_callbacks_->dispatcher().createSchedulableCallback(
+        [this]() -> void { onNextChunk(); });
+    if (high_watermark_count_ == 0) {
+      next_chunk_cb_->scheduleCallbackNextIteration();
+    }
+    return;
+  }
+
   decoder_callbacks_->encodeHeaders(std::move(header_map),
                                     end_stream_on_complete_ && response.length() == 0);
 
@@ -80,5 +99,38 @@ void AdminFilter::onComplete() {
   }
 }
 
+void AdminFilter::onNextChunk() {
+  ASSERT(chunk_generator_);
+  Buffer::OwnedImpl chunk;
+  const bool more = chunk_generator_(chunk);
+  if (!more) {
+    finishChunkedResponse();
+  }
+  decoder_callbacks_->encodeData(chunk, !more);
+
+  // Encoding may have pushed the connection above its high watermark, or reset the stream.
+  if (more && chunk_generator_ && high_watermark_count_ == 0) {
+    next_chunk_cb_->scheduleCallbackNextIteration();
+  }
+}
+
+void AdminFilter::finishChunkedResponse() {
+  if (next_chunk_cb_ != nullptr) {
+    next_chunk_cb_->cancel();
+    decoder_callbacks_->removeDownstreamWatermarkCallbacks(*this);
+  }
+  chunk_generator_ = nullptr;
+}
+
+void AdminFilter::onAboveWriteBufferHighWatermark() { ++high_watermark_count_; }
+
+void AdminFilter::onBelowWriteBufferLowWatermark() {
+  ASSERT(high_watermark_count_ > 0);
+  --high_watermark_count_;
+  if (high_watermark_count_ == 0 && chunk_generator_ && next_chunk_cb_ != nullptr) {
+    next_chunk_cb_->scheduleCallbackNextIteration();
+  }
+}
+
 } // namespace Server
 } // namespace Envoy
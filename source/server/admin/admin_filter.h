@@ -3,6 +3,7 @@
 #include <functional>
 #include <list>
 
+#include "envoy/event/schedulable_cb.h"
 #include "envoy/http/filter.h"
 #include "envoy/server/admin.h"
 
@@ -23,6 +24,7 @@ namespace Server {
  */
 class AdminFilter : public Http::PassThroughFilter,
                     public AdminStream,
+                    public Http::DownstreamWatermarkCallbacks,
                     Logger::Loggable<Logger::Id::admin> {
 public:
   using AdminServerCallbackFunction = std::function<Http::Code(
@@ -52,16 +54,38 @@ public:
   Http::Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override {
     return encoder_callbacks_->http1StreamEncoderOptions();
   }
+  void setChunkedResponse(ChunkGenerator generator) override {
+    chunk_generator_ = std::move(generator);
+  }
+
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
+  /**
+   * @return const ChunkGenerator& the generator set by the handler, if any. Used to produce the
+   * whole response when there is no downstream stream to send chunks to.
+   */
+  const ChunkGenerator& chunkGenerator() const { return chunk_generator_; }
 
 private:
   /**
    * Called when an admin request has been completely received.
    */
   void onComplete();
+  /**
+   * Encodes the next chunk of a chunked response and schedules the one after it, if any.
+   */
+  void onNextChunk();
+  void finishChunkedResponse();
+
   AdminServerCallbackFunction admin_server_callback_func_;
   Http::RequestHeaderMap* request_headers_{};
   std::list<std::function<void()>> on_destroy_callbacks_;
   bool end_stream_on_complete_ = true;
+  ChunkGenerator chunk_generator_;
+  Event::SchedulableCallbackPtr next_chunk_cb_;
+  uint32_t high_watermark_count_{};
 };
 
 } // namespace Server
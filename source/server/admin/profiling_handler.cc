@@ -1,9 +1,17 @@
 #include "server/admin/profiling_handler.h"
 
+#include "common/common/utility.h"
+#include "common/event/slow_callback_tracer.h"
+#include "common/http/headers.h"
 #include "common/profiler/profiler.h"
 
 #include "server/admin/utils.h"
 
+#include "absl/debugging/symbolize.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_replace.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -19,6 +27,11 @@ Http::Code ProfilingHandler::handlerCpuProfiler(absl::string_view url, Http::Res
   }
 
   bool enable = query_params.begin()->second == "y";
+  if (enable && continuous_profiler_ != nullptr) {
+    // Both profilers sample with SIGPROF.
+    response.add("the CPU profiler cannot run with the continuous profiler\n");
+    return Http::Code::BadRequest;
+  }
   if (enable && !Profiler::Cpu::profilerEnabled()) {
     if (!Profiler::Cpu::startProfiler(profile_path_)) {
       response.add("failure to start the profiler");
@@ -80,5 +93,98 @@ Http::Code ProfilingHandler::handlerHeapProfiler(absl::string_view url, Http::Re
   return res;
 }
 
+Http::Code ProfilingHandler::handlerSlowCallbacks(absl::string_view, Http::ResponseHeaderMap&,
+                                                  Buffer::Instance& response, AdminStream&) {
+  using Event::SlowCallbackTracer;
+  response.add(
+      fmt::format("tracing: {}\n", SlowCallbackTracer::enabled() ? "enabled" : "disabled"));
+  SlowCallbackTracer::forEachTracer([&response](const SlowCallbackTracer& tracer) {
+    const std::vector<SlowCallbackTracer::SlowCallback> slow_callbacks = tracer.slowCallbacks();
+    response.add(fmt::format("{}: {} slow callbacks\n", tracer.name(), slow_callbacks.size()));
+    for (const SlowCallbackTracer::SlowCallback& slow_callback : slow_callbacks) {
+      response.add(fmt::format("  {} {} {}us\n",
+                               AccessLogDateTimeFormatter::fromTime(slow_callback.start_time_),
+                               SlowCallbackTracer::callbackTypeName(slow_callback.type_),
+                               slow_callback.duration_.count()));
+      if (!slow_callback.scope_.empty()) {
+        response.add("    scope:\n      ");
+        response.add(absl::StrReplaceAll(absl::StripTrailingAsciiWhitespace(slow_callback.scope_),
+                                         {{"\n", "\n      "}}));
+        response.add("\n");
+      }
+      if (!slow_callback.stack_.empty()) {
+        response.add("    stack:\n");
+        for (size_t i = 0; i < slow_callback.stack_.size(); ++i) {
+          char symbol[1024];
+          if (absl::Symbolize(slow_callback.stack_[i], symbol, sizeof(symbol))) {
+            response.add(fmt::format("      #{} {} [{}]\n", i, symbol, slow_callback.stack_[i]));
+          } else {
+            response.add(fmt::format("      #{} [{}]\n", i, slow_callback.stack_[i]));
+          }
+        }
+      }
+    }
+  });
+  return Http::Code::OK;
+}
+
+Http::Code ProfilingHandler::handlerSlowCallbacksEnable(absl::string_view url,
+                                                        Http::ResponseHeaderMap&,
+                                                        Buffer::Instance& response, AdminStream&) {
+  Http::Utility::QueryParams query_params = Http::Utility::parseAndDecodeQueryString(url);
+  uint64_t threshold_us = DefaultSlowCallbackThresholdUs;
+  const auto it = query_params.find("threshold_us");
+  if (query_params.size() > 1 || (query_params.size() == 1 && it == query_params.end()) ||
+      (it != query_params.end() && !absl::SimpleAtoi(it->second, &threshold_us))) {
+    response.add("?threshold_us=<microseconds>\n");
+    return Http::Code::BadRequest;
+  }
+
+  Event::SlowCallbackTracer::enable(std::chrono::microseconds(threshold_us));
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code ProfilingHandler::handlerSlowCallbacksDisable(absl::string_view,
+                                                         Http::ResponseHeaderMap&,
+                                                         Buffer::Instance& response, AdminStream&) {
+  Event::SlowCallbackTracer::disable();
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code ProfilingHandler::handlerPprofProfile(absl::string_view url,
+                                                 Http::ResponseHeaderMap& response_headers,
+                                                 Buffer::Instance& response, AdminStream&) {
+  if (continuous_profiler_ == nullptr) {
+    response.add("The continuous profiler is not configured\n");
+    return Http::Code::NotFound;
+  }
+
+  Http::Utility::QueryParams query_params = Http::Utility::parseAndDecodeQueryString(url);
+  uint64_t seconds = DefaultPprofProfileSeconds;
+  const auto it = query_params.find("seconds");
+  if (query_params.size() > 1 || (query_params.size() == 1 && it == query_params.end()) ||
+      (it != query_params.end() && (!absl::SimpleAtoi(it->second, &seconds) || seconds == 0))) {
+    response.add("?seconds=<seconds>\n");
+    return Http::Code::BadRequest;
+  }
+
+  response_headers.setReferenceContentType(Http::Headers::get().ContentTypeValues.Protobuf);
+  const std::chrono::milliseconds max_duration = continuous_profiler_->maxDuration();
+  continuous_profiler_->writeProfile(
+      seconds < static_cast<uint64_t>(max_duration.count() / 1000) ? std::chrono::seconds(seconds)
+                                                                    : max_duration,
+      response);
+  return Http::Code::OK;
+}
+
+void ProfilingHandler::startContinuousProfiler(
+    const envoy::config::bootstrap::v3::Admin::ContinuousProfiler& config,
+    Event::Dispatcher& dispatcher, TimeSource& time_source) {
+  continuous_profiler_ =
+      std::make_unique<Profiler::ContinuousProfiler>(config, dispatcher, time_source);
+}
+
 } // namespace Server
 } // namespace Envoy
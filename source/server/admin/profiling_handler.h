@@ -1,10 +1,14 @@
 #pragma once
 
 #include "envoy/buffer/buffer.h"
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/http/codes.h"
 #include "envoy/http/header_map.h"
 #include "envoy/server/admin.h"
 
+#include "common/profiler/continuous_profiler.h"
+
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -23,8 +27,37 @@ public:
                                  Http::ResponseHeaderMap& response_headers,
                                  Buffer::Instance& response, AdminStream&);
 
+  Http::Code handlerSlowCallbacks(absl::string_view path_and_query,
+                                  Http::ResponseHeaderMap& response_headers,
+                                  Buffer::Instance& response, AdminStream&);
+
+  Http::Code handlerSlowCallbacksEnable(absl::string_view path_and_query,
+                                        Http::ResponseHeaderMap& response_headers,
+                                        Buffer::Instance& response, AdminStream&);
+
+  Http::Code handlerSlowCallbacksDisable(absl::string_view path_and_query,
+                                         Http::ResponseHeaderMap& response_headers,
+                                         Buffer::Instance& response, AdminStream&);
+
+  Http::Code handlerPprofProfile(absl::string_view path_and_query,
+                                 Http::ResponseHeaderMap& response_headers,
+                                 Buffer::Instance& response, AdminStream&);
+
+  /**
+   * Starts the continuous profiler served by /pprof/profile. Throws EnvoyException on failure.
+   */
+  void
+  startContinuousProfiler(const envoy::config::bootstrap::v3::Admin::ContinuousProfiler& config,
+                          Event::Dispatcher& dispatcher, TimeSource& time_source);
+
+  // The threshold used by /slow_callbacks/enable when none is given.
+  static constexpr uint64_t DefaultSlowCallbackThresholdUs = 10000;
+  // The duration of the profile served by /pprof/profile when none is given.
+  static constexpr uint64_t DefaultPprofProfileSeconds = 30;
+
 private:
   const std::string profile_path_;
+  Profiler::ContinuousProfilerPtr continuous_profiler_;
 };
 
 } // namespace Server
@@ -1,8 +1,12 @@
 #include "server/admin/prometheus_stats.h"
 
+#include <functional>
+#include <map>
+
 #include "common/common/empty_string.h"
 #include "common/common/macros.h"
 #include "common/stats/histogram_impl.h"
+#include "common/stats/symbol_table_impl.h"
 
 #include "absl/strings/str_cat.h"
 
@@ -48,88 +52,6 @@ struct MetricLessThan {
   }
 };
 
-/**
- * Processes a stat type (counter, gauge, histogram) by generating all output lines, sorting
- * them by tag-extracted metric name, and then outputting them in the correct sorted order into
- * response.
- *
- * @param response The buffer to put the output into.
- * @param used_only Whether to only output stats that are used.
- * @param regex A filter on which stats to output.
- * @param metrics The metrics to output stats for. This must contain all stats of the given type
- *        to be included in the same output.
- * @param generate_output A function which returns the output text for this metric.
- * @param type The name of the prometheus metric type for used in TYPE annotations.
- */
-template <class StatType>
-uint64_t outputStatType(
-    Buffer::Instance& response, const bool used_only, const absl::optional<std::regex>& regex,
-    const std::vector<Stats::RefcountPtr<StatType>>& metrics,
-    const std::function<std::string(
-        const StatType& metric, const std::string& prefixed_tag_extracted_name)>& generate_output,
-    absl::string_view type) {
-
-  /*
-   * From
-   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
-   *
-   * All lines for a given metric must be provided as one single group, with the optional HELP and
-   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
-   * expositions is preferred but not required, i.e. do not sort if the computational cost is
-   * prohibitive.
-   */
-
-  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
-  // refcount; ownership is held throughout by `metrics`). It is unsorted for efficiency, but will
-  // be sorted before producing the final output to satisfy the "preferred" ordering from the
-  // prometheus spec: metrics will be sorted by their tags' textual representation, which will be
-  // consistent across calls.
-  using StatTypeUnsortedCollection = std::vector<const StatType*>;
-
-  // Return early to avoid crashing when getting the symbol table from the first metric.
-  if (metrics.empty()) {
-    return 0;
-  }
-
-  // There should only be one symbol table for all of the stats in the admin
-  // interface. If this assumption changes, the name comparisons in this function
-  // will have to change to compare to convert all StatNames to strings before
-  // comparison.
-  const Stats::SymbolTable& global_symbol_table = metrics.front()->constSymbolTable();
-
-  // Sorted collection of metrics sorted by their tagExtractedName, to satisfy the requirements
-  // of the exposition format.
-  std::map<Stats::StatName, StatTypeUnsortedCollection, Stats::StatNameLessThan> groups(
-      global_symbol_table);
-
-  for (const auto& metric : metrics) {
-    ASSERT(&global_symbol_table == &metric->constSymbolTable());
-
-    if (!shouldShowMetric(*metric, used_only, regex)) {
-      continue;
-    }
-
-    groups[metric->tagExtractedStatName()].push_back(metric.get());
-  }
-
-  for (auto& group : groups) {
-    const std::string prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(global_symbol_table.toString(group.first));
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name, type));
-
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), MetricLessThan());
-
-    for (const auto& metric : group.second) {
-      response.add(generate_output(*metric, prefixed_tag_extracted_name));
-    }
-    response.add("\n");
-  }
-  return groups.size();
-}
-
 /*
  * Return the prometheus output for a numeric Stat (Counter or Gauge).
  */
@@ -182,6 +104,119 @@ absl::flat_hash_set<std::string>& prometheusNamespaces() {
 
 } // namespace
 
+/**
+ * Streams one stat type (counter, gauge, histogram), one group of metrics sharing a tag-extracted
+ * name at a time.
+ */
+template <class StatType>
+class PrometheusStatsStreamer::StatTypeStreamerImpl : public StatTypeStreamer {
+public:
+  using GenerateOutput = std::function<std::string(const StatType& metric,
+                                                   const std::string& prefixed_tag_extracted_name)>;
+
+  StatTypeStreamerImpl(std::vector<Stats::RefcountPtr<StatType>>&& metrics, const bool used_only,
+                       const absl::optional<std::regex>& regex, GenerateOutput generate_output,
+                       absl::string_view type, uint64_t& metric_name_count)
+      : metrics_(std::move(metrics)), used_only_(used_only), regex_(regex),
+        generate_output_(std::move(generate_output)), type_(type),
+        metric_name_count_(metric_name_count) {}
+
+  // PrometheusStatsStreamer::StatTypeStreamer
+  bool nextChunk(Buffer::Instance& response, uint64_t limit) override {
+    if (!grouped_) {
+      groupMetrics();
+      grouped_ = true;
+    }
+    // Return early to avoid crashing when getting the symbol table from the first metric.
+    if (metrics_.empty()) {
+      return false;
+    }
+
+    auto group = groups_->begin();
+    while (group != groups_->end()) {
+      outputGroup(group->first, group->second, response);
+      group = groups_->erase(group);
+      ++metric_name_count_;
+      if (response.length() >= limit) {
+        break;
+      }
+    }
+    return group != groups_->end();
+  }
+
+private:
+  /*
+   * From
+   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
+   *
+   * All lines for a given metric must be provided as one single group, with the optional HELP and
+   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
+   * expositions is preferred but not required, i.e. do not sort if the computational cost is
+   * prohibitive.
+   */
+
+  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
+  // refcount; ownership is held throughout by `metrics_`). It is unsorted for efficiency, but will
+  // be sorted before producing the output of the group to satisfy the "preferred" ordering from
+  // the prometheus spec.
+  using StatTypeUnsortedCollection = std::vector<const StatType*>;
+  // Collection of metrics sorted by their tagExtractedName, to satisfy the requirements of the
+  // exposition format.
+  using Groups = std::map<Stats::StatName, StatTypeUnsortedCollection, Stats::StatNameLessThan>;
+
+  void groupMetrics() {
+    // Drop the metrics that are not shown before grouping, so that only the shown ones are held
+    // for the rest of the response.
+    std::vector<Stats::RefcountPtr<StatType>> shown;
+    for (auto& metric : metrics_) {
+      if (shouldShowMetric(*metric, used_only_, regex_)) {
+        shown.push_back(std::move(metric));
+      }
+    }
+    metrics_.swap(shown);
+
+    // There should only be one symbol table for all of the stats in the admin interface. If this
+    // assumption changes, the name comparisons here will have to convert all StatNames to strings
+    // before comparison.
+    if (metrics_.empty()) {
+      return;
+    }
+    symbol_table_ = &metrics_.front()->constSymbolTable();
+    groups_ = std::make_unique<Groups>(*symbol_table_);
+    for (const auto& metric : metrics_) {
+      ASSERT(symbol_table_ == &metric->constSymbolTable());
+      (*groups_)[metric->tagExtractedStatName()].push_back(metric.get());
+    }
+  }
+
+  void outputGroup(Stats::StatName tag_extracted_name, StatTypeUnsortedCollection& metrics,
+                   Buffer::Instance& response) {
+    const std::string prefixed_tag_extracted_name =
+        PrometheusStatsFormatter::metricName(symbol_table_->toString(tag_extracted_name));
+    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name, type_));
+
+    // Sort before producing the output to satisfy the "preferred" ordering from the prometheus
+    // spec: metrics will be sorted by their tags' textual representation, which will be
+    // consistent across calls.
+    std::sort(metrics.begin(), metrics.end(), MetricLessThan());
+
+    for (const auto& metric : metrics) {
+      response.add(generate_output_(*metric, prefixed_tag_extracted_name));
+    }
+    response.add("\n");
+  }
+
+  std::vector<Stats::RefcountPtr<StatType>> metrics_;
+  const bool used_only_;
+  const absl::optional<std::regex> regex_;
+  const GenerateOutput generate_output_;
+  const absl::string_view type_;
+  uint64_t& metric_name_count_;
+  bool grouped_{};
+  const Stats::SymbolTable* symbol_table_{};
+  std::unique_ptr<Groups> groups_;
+};
+
 std::string PrometheusStatsFormatter::formattedTags(const std::vector<Stats::Tag>& tags) {
   std::vector<std::string> buf;
   buf.reserve(tags.size());
@@ -208,23 +243,49 @@ std::string PrometheusStatsFormatter::metricName(const std::string& extracted_na
 }
 
 // TODO(efimki): Add support of text readouts stats.
+PrometheusStatsStreamer::PrometheusStatsStreamer(
+    std::vector<Stats::CounterSharedPtr> counters, std::vector<Stats::GaugeSharedPtr> gauges,
+    std::vector<Stats::ParentHistogramSharedPtr> histograms, const bool used_only,
+    const absl::optional<std::regex>& regex) {
+  streamers_.push_back(std::make_unique<StatTypeStreamerImpl<Stats::Counter>>(
+      std::move(counters), used_only, regex, generateNumericOutput<Stats::Counter>, "counter",
+      metric_name_count_));
+  streamers_.push_back(std::make_unique<StatTypeStreamerImpl<Stats::Gauge>>(
+      std::move(gauges), used_only, regex, generateNumericOutput<Stats::Gauge>, "gauge",
+      metric_name_count_));
+  streamers_.push_back(std::make_unique<StatTypeStreamerImpl<Stats::ParentHistogram>>(
+      std::move(histograms), used_only, regex, generateHistogramOutput, "histogram",
+      metric_name_count_));
+}
+
+PrometheusStatsStreamer::~PrometheusStatsStreamer() = default;
+
+bool PrometheusStatsStreamer::nextChunk(Buffer::Instance& response, uint64_t chunk_size) {
+  const uint64_t limit = response.length() + chunk_size;
+  while (current_streamer_ < streamers_.size()) {
+    if (streamers_[current_streamer_]->nextChunk(response, limit)) {
+      return true;
+    }
+    // Release the metrics of the completed type right away.
+    streamers_[current_streamer_++].reset();
+    if (response.length() >= limit) {
+      break;
+    }
+  }
+  return current_streamer_ < streamers_.size();
+}
+
 uint64_t PrometheusStatsFormatter::statsAsPrometheus(
     const std::vector<Stats::CounterSharedPtr>& counters,
     const std::vector<Stats::GaugeSharedPtr>& gauges,
     const std::vector<Stats::ParentHistogramSharedPtr>& histograms, Buffer::Instance& response,
     const bool used_only, const absl::optional<std::regex>& regex) {
-
-  uint64_t metric_name_count = 0;
-  metric_name_count += outputStatType<Stats::Counter>(
-      response, used_only, regex, counters, generateNumericOutput<Stats::Counter>, "counter");
-
-  metric_name_count += outputStatType<Stats::Gauge>(response, used_only, regex, gauges,
-                                                    generateNumericOutput<Stats::Gauge>, "gauge");
-
-  metric_name_count += outputStatType<Stats::ParentHistogram>(
-      response, used_only, regex, histograms, generateHistogramOutput, "histogram");
-
-  return metric_name_count;
+  PrometheusStatsStreamer streamer(counters, gauges, histograms, used_only, regex);
+  bool more = true;
+  while (more) {
+    more = streamer.nextChunk(response, 0);
+  }
+  return streamer.metricNameCount();
 }
 
 bool PrometheusStatsFormatter::registerPrometheusNamespace(absl::string_view prometheus_namespace) {
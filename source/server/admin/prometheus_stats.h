@@ -1,14 +1,69 @@
 #pragma once
 
+#include <memory>
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/stats.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Server {
+
+/**
+ * Produces the Prometheus exposition of counters, gauges and histograms in chunks, so that the
+ * output for a large number of metrics can be sent across several dispatcher iterations. Metrics
+ * are filtered before any output is produced for them. The metrics of one type are grouped by
+ * tag-extracted name only when that type is reached, and each group is sorted right before it is
+ * emitted and released right after, so the sorting work and the memory held are spread over the
+ * chunks. The concatenated chunks are identical to the output of
+ * PrometheusStatsFormatter::statsAsPrometheus().
+ */
+class PrometheusStatsStreamer {
+public:
+  PrometheusStatsStreamer(std::vector<Stats::CounterSharedPtr> counters,
+                          std::vector<Stats::GaugeSharedPtr> gauges,
+                          std::vector<Stats::ParentHistogramSharedPtr> histograms,
+                          const bool used_only, const absl::optional<std::regex>& regex);
+  ~PrometheusStatsStreamer();
+
+  /**
+   * Appends the next chunk of output to the response. A chunk is complete once it holds at least
+   * chunk_size bytes; it always ends on a metric group boundary.
+   * @param response supplies the buffer to append to.
+   * @param chunk_size supplies the minimum size of a chunk. A chunk_size of zero produces one
+   *        metric group per chunk.
+   * @return bool true if more chunks follow.
+   */
+  bool nextChunk(Buffer::Instance& response, uint64_t chunk_size);
+
+  /**
+   * @return uint64_t total number of metric types emitted so far.
+   */
+  uint64_t metricNameCount() const { return metric_name_count_; }
+
+private:
+  class StatTypeStreamer {
+  public:
+    virtual ~StatTypeStreamer() = default;
+
+    /**
+     * Appends metric groups until the response holds at least limit bytes.
+     * @return bool true if groups of this type remain.
+     */
+    virtual bool nextChunk(Buffer::Instance& response, uint64_t limit) PURE;
+  };
+  template <class StatType> class StatTypeStreamerImpl;
+
+  std::vector<std::unique_ptr<StatTypeStreamer>> streamers_;
+  size_t current_streamer_{};
+  uint64_t metric_name_count_{};
+};
 /**
  * Formatter for metric/labels exported to Prometheus.
  *
@@ -14,6 +14,165 @@ namespace Envoy {
 namespace Server {
 
 const uint64_t RecentLookupsCapacity = 100;
+// Minimum size of each chunk of a streamed stats response.
+const uint64_t StatsChunkSize = 1024 * 1024;
+
+StatsTextStreamer::StatsTextStreamer(Stats::Store& store, const bool used_only,
+                                     const absl::optional<std::regex>& regex,
+                                     uint64_t max_sorted_scope_size)
+    : store_(store), used_only_(used_only), regex_(regex),
+      max_sorted_scope_size_(max_sorted_scope_size) {}
+
+bool StatsTextStreamer::nextChunk(Buffer::Instance& response, uint64_t chunk_size) {
+  const uint64_t limit = response.length() + chunk_size;
+  do {
+    if (pending_scopes_.empty()) {
+      if (!startNextPhase()) {
+        return false;
+      }
+      continue;
+    }
+
+    Scope scope = std::move(pending_scopes_.back());
+    pending_scopes_.pop_back();
+    if (scope.complete_name_ || scope.entries_.size() <= max_sorted_scope_size_) {
+      outputScope(scope, response);
+    } else {
+      partitionScope(scope);
+    }
+  } while (response.length() < limit);
+  return !pending_scopes_.empty() || next_phase_ != Phase::Done;
+}
+
+bool StatsTextStreamer::startNextPhase() {
+  Scope scope;
+  switch (next_phase_) {
+  case Phase::TextReadouts:
+    text_readouts_ = store_.textReadouts();
+    addEntries(text_readouts_, Type::TextReadout, scope.entries_);
+    next_phase_ = Phase::Numeric;
+    break;
+  case Phase::Numeric:
+    text_readouts_.clear();
+    counters_ = store_.counters();
+    gauges_ = store_.gauges();
+    // Counters are added first so that they take precedence over gauges with the same name.
+    addEntries(counters_, Type::Counter, scope.entries_);
+    addEntries(gauges_, Type::Gauge, scope.entries_);
+    next_phase_ = Phase::Histograms;
+    break;
+  case Phase::Histograms:
+    counters_.clear();
+    gauges_.clear();
+    histograms_ = store_.histograms();
+    addEntries(histograms_, Type::Histogram, scope.entries_);
+    next_phase_ = Phase::Done;
+    break;
+  case Phase::Done:
+    histograms_.clear();
+    return false;
+  }
+  pending_scopes_.push_back(std::move(scope));
+  return true;
+}
+
+template <class StatType>
+void StatsTextStreamer::addEntries(const std::vector<Stats::RefcountPtr<StatType>>& metrics,
+                                   Type type, std::vector<Entry>& entries) const {
+  for (uint32_t i = 0; i < metrics.size(); ++i) {
+    if (!used_only_ || metrics[i]->used()) {
+      entries.push_back(Entry{i, type});
+    }
+  }
+}
+
+void StatsTextStreamer::partitionScope(Scope& scope) {
+  // Sub-scopes are keyed by the next name segment including its trailing dot, or by the rest of the
+  // name for the last segment. Sorting names by these keys and then within each key gives the same
+  // order as sorting the full names, because no key is a prefix of another key ending in a dot.
+  std::map<std::string, std::vector<Entry>> sub_scopes;
+  for (const Entry& entry : scope.entries_) {
+    const std::string entry_name = name(entry);
+    if (!scope.filtered_ && !matches(entry_name)) {
+      continue;
+    }
+    const size_t dot = entry_name.find('.', scope.prefix_length_);
+    const size_t key_end = dot == std::string::npos ? entry_name.size() : dot + 1;
+    sub_scopes[entry_name.substr(scope.prefix_length_, key_end - scope.prefix_length_)].push_back(
+        entry);
+  }
+
+  for (auto it = sub_scopes.rbegin(); it != sub_scopes.rend(); ++it) {
+    Scope sub_scope;
+    sub_scope.prefix_length_ = scope.prefix_length_ + it->first.size();
+    sub_scope.entries_ = std::move(it->second);
+    sub_scope.filtered_ = true;
+    sub_scope.complete_name_ = it->first.empty() || it->first.back() != '.';
+    pending_scopes_.push_back(std::move(sub_scope));
+  }
+}
+
+void StatsTextStreamer::outputScope(const Scope& scope, Buffer::Instance& response) const {
+  std::vector<std::pair<std::string, Entry>> named_entries;
+  named_entries.reserve(scope.entries_.size());
+  for (const Entry& entry : scope.entries_) {
+    std::string entry_name = name(entry);
+    if (scope.filtered_ || matches(entry_name)) {
+      named_entries.emplace_back(std::move(entry_name), entry);
+    }
+  }
+  std::stable_sort(named_entries.begin(), named_entries.end(),
+                   [](const std::pair<std::string, Entry>& a,
+                      const std::pair<std::string, Entry>& b) { return a.first < b.first; });
+
+  const std::string* previous_name = nullptr;
+  for (const auto& [entry_name, entry] : named_entries) {
+    // Only the first metric with a given name is shown.
+    if (previous_name != nullptr && *previous_name == entry_name) {
+      continue;
+    }
+    outputEntry(entry, entry_name, response);
+    previous_name = &entry_name;
+  }
+}
+
+void StatsTextStreamer::outputEntry(const Entry& entry, const std::string& name,
+                                    Buffer::Instance& response) const {
+  switch (entry.type_) {
+  case Type::TextReadout:
+    response.add(fmt::format("{}: \"{}\"\n", name,
+                             Html::Utility::sanitize(text_readouts_[entry.index_]->value())));
+    break;
+  case Type::Counter:
+    response.add(fmt::format("{}: {}\n", name, counters_[entry.index_]->value()));
+    break;
+  case Type::Gauge:
+    ASSERT(gauges_[entry.index_]->importMode() != Stats::Gauge::ImportMode::Uninitialized);
+    response.add(fmt::format("{}: {}\n", name, gauges_[entry.index_]->value()));
+    break;
+  case Type::Histogram:
+    response.add(fmt::format("{}: {}\n", name, histograms_[entry.index_]->quantileSummary()));
+    break;
+  }
+}
+
+std::string StatsTextStreamer::name(const Entry& entry) const {
+  switch (entry.type_) {
+  case Type::TextReadout:
+    return text_readouts_[entry.index_]->name();
+  case Type::Counter:
+    return counters_[entry.index_]->name();
+  case Type::Gauge:
+    return gauges_[entry.index_]->name();
+  case Type::Histogram:
+    return histograms_[entry.index_]->name();
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+bool StatsTextStreamer::matches(const std::string& name) const {
+  return !regex_.has_value() || std::regex_search(name, regex_.value());
+}
 
 StatsHandler::StatsHandler(Server::Instance& server) : HandlerContextBase(server) {}
 
@@ -80,29 +239,29 @@ Http::Code StatsHandler::handlerStats(absl::string_view url,
     return Http::Code::BadRequest;
   }
 
-  std::map<std::string, uint64_t> all_stats;
-  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    if (shouldShowMetric(*counter, used_only, regex)) {
-      all_stats.emplace(counter->name(), counter->value());
-    }
-  }
+  if (const auto format_value = Utility::formatParam(params)) {
+    if (format_value.value() == "json") {
+      std::map<std::string, uint64_t> all_stats;
+      for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
+        if (shouldShowMetric(*counter, used_only, regex)) {
+          all_stats.emplace(counter->name(), counter->value());
+        }
+      }
 
-  for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
-    if (shouldShowMetric(*gauge, used_only, regex)) {
-      ASSERT(gauge->importMode() != Stats::Gauge::ImportMode::Uninitialized);
-      all_stats.emplace(gauge->name(), gauge->value());
-    }
-  }
+      for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
+        if (shouldShowMetric(*gauge, used_only, regex)) {
+          ASSERT(gauge->importMode() != Stats::Gauge::ImportMode::Uninitialized);
+          all_stats.emplace(gauge->name(), gauge->value());
+        }
+      }
 
-  std::map<std::string, std::string> text_readouts;
-  for (const auto& text_readout : server_.stats().textReadouts()) {
-    if (shouldShowMetric(*text_readout, used_only, regex)) {
-      text_readouts.emplace(text_readout->name(), text_readout->value());
-    }
-  }
+      std::map<std::string, std::string> text_readouts;
+      for (const auto& text_readout : server_.stats().textReadouts()) {
+        if (shouldShowMetric(*text_readout, used_only, regex)) {
+          text_readouts.emplace(text_readout->name(), text_readout->value());
+        }
+      }
 
-  if (const auto format_value = Utility::formatParam(params)) {
-    if (format_value.value() == "json") {
       response_headers.setReferenceContentType(Http::Headers::get().ContentTypeValues.Json);
       response.add(
           statsAsJson(all_stats, text_readouts, server_.stats().histograms(), used_only, regex));
@@ -114,30 +273,18 @@ Http::Code StatsHandler::handlerStats(absl::string_view url,
       rc = Http::Code::NotFound;
     }
   } else { // Display plain stats if format query param is not there.
-    for (const auto& text_readout : text_readouts) {
-      response.add(fmt::format("{}: \"{}\"\n", text_readout.first,
-                               Html::Utility::sanitize(text_readout.second)));
-    }
-    for (const auto& stat : all_stats) {
-      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
-    }
-    std::map<std::string, std::string> all_histograms;
-    for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
-      if (shouldShowMetric(*histogram, used_only, regex)) {
-        auto insert = all_histograms.emplace(histogram->name(), histogram->quantileSummary());
-        ASSERT(insert.second); // No duplicates expected.
-      }
-    }
-    for (const auto& histogram : all_histograms) {
-      response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
-    }
+    auto streamer = std::make_shared<StatsTextStreamer>(server_.stats(), used_only, regex);
+    admin_stream.setChunkedResponse([streamer](Buffer::Instance& chunk) -> bool {
+      return streamer->nextChunk(chunk, StatsChunkSize);
+    });
   }
   return rc;
 }
 
 Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query,
                                                 Http::ResponseHeaderMap&,
-                                                Buffer::Instance& response, AdminStream&) {
+                                                Buffer::Instance& response,
+                                                AdminStream& admin_stream) {
   const Http::Utility::QueryParams params =
       Http::Utility::parseAndDecodeQueryString(path_and_query);
   const bool used_only = params.find("usedonly") != params.end();
@@ -145,9 +292,12 @@ Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query
   if (!Utility::filterParam(params, response, regex)) {
     return Http::Code::BadRequest;
   }
-  PrometheusStatsFormatter::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
-                                              server_.stats().histograms(), response, used_only,
-                                              regex);
+  auto streamer = std::make_shared<PrometheusStatsStreamer>(
+      server_.stats().counters(), server_.stats().gauges(), server_.stats().histograms(),
+      used_only, regex);
+  admin_stream.setChunkedResponse([streamer](Buffer::Instance& chunk) -> bool {
+    return streamer->nextChunk(chunk, StatsChunkSize);
+  });
   return Http::Code::OK;
 }
 
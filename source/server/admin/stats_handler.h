@@ -2,12 +2,14 @@
 
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/codes.h"
 #include "envoy/http/header_map.h"
 #include "envoy/server/admin.h"
 #include "envoy/server/instance.h"
+#include "envoy/stats/store.h"
 
 #include "common/stats/histogram_impl.h"
 
@@ -18,6 +20,84 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * Produces the plain text /stats output in chunks, so that the output for a large number of stats
+ * can be sent across several dispatcher iterations. Text readouts are emitted first, then counters
+ * and gauges, then histograms, each in name order. Unused metrics are dropped up front and the
+ * filter regex is applied the first time a metric name is built, before any output is produced.
+ *
+ * Sorting is incremental: a set of metrics sharing a scope is sorted by name only when it is small
+ * enough, otherwise it is partitioned by the next dot separated name segment and each sub-scope is
+ * handled the same way when it is reached. Only the scope being emitted has its names
+ * materialized, and the concatenated chunks are identical to a one pass output.
+ */
+class StatsTextStreamer {
+public:
+  static constexpr uint64_t DefaultMaxSortedScopeSize = 4096;
+
+  /**
+   * @param store supplies the store whose metrics are emitted. The metrics are snapshotted when
+   *        they are first needed; metrics created afterwards are not emitted.
+   * @param used_only supplies whether only metrics that have been used are emitted.
+   * @param regex supplies an optional filter on metric names.
+   * @param max_sorted_scope_size supplies the number of metrics above which a scope is partitioned
+   *        into sub-scopes instead of being sorted as a whole.
+   */
+  StatsTextStreamer(Stats::Store& store, bool used_only, const absl::optional<std::regex>& regex,
+                    uint64_t max_sorted_scope_size = DefaultMaxSortedScopeSize);
+
+  /**
+   * Appends the next chunk of output to the response. A chunk is complete once it holds at least
+   * chunk_size bytes; it always ends on a scope boundary.
+   * @param response supplies the buffer to append to.
+   * @param chunk_size supplies the minimum size of a chunk.
+   * @return bool true if more chunks follow.
+   */
+  bool nextChunk(Buffer::Instance& response, uint64_t chunk_size);
+
+private:
+  enum class Phase : uint8_t { TextReadouts, Numeric, Histograms, Done };
+  enum class Type : uint8_t { TextReadout, Counter, Gauge, Histogram };
+
+  struct Entry {
+    // Index of the metric in the vector of its type.
+    uint32_t index_;
+    Type type_;
+  };
+
+  // Metrics whose names share a prefix of prefix_length_ characters.
+  struct Scope {
+    size_t prefix_length_{};
+    std::vector<Entry> entries_;
+    // Whether the regex has been applied to the entries.
+    bool filtered_{};
+    // Whether all entries have the same name, so that the scope can't be partitioned further.
+    bool complete_name_{};
+  };
+
+  bool startNextPhase();
+  template <class StatType>
+  void addEntries(const std::vector<Stats::RefcountPtr<StatType>>& metrics, Type type,
+                  std::vector<Entry>& entries) const;
+  void partitionScope(Scope& scope);
+  void outputScope(const Scope& scope, Buffer::Instance& response) const;
+  void outputEntry(const Entry& entry, const std::string& name, Buffer::Instance& response) const;
+  std::string name(const Entry& entry) const;
+  bool matches(const std::string& name) const;
+
+  Stats::Store& store_;
+  const bool used_only_;
+  const absl::optional<std::regex> regex_;
+  const uint64_t max_sorted_scope_size_;
+  Phase next_phase_{Phase::TextReadouts};
+  std::vector<Stats::TextReadoutSharedPtr> text_readouts_;
+  std::vector<Stats::CounterSharedPtr> counters_;
+  std::vector<Stats::GaugeSharedPtr> gauges_;
+  std::vector<Stats::ParentHistogramSharedPtr> histograms_;
+  // Scopes of the current phase still to be emitted, in reverse name order.
+  std::vector<Scope> pending_scopes_;
+};
+
 class StatsHandler : public HandlerContextBase {
 
 public:
@@ -40,10 +120,10 @@ public:
                                              Buffer::Instance& response, AdminStream&);
   Http::Code handlerStats(absl::string_view path_and_query,
                           Http::ResponseHeaderMap& response_headers, Buffer::Instance& response,
-                          AdminStream&);
+                          AdminStream& admin_stream);
   Http::Code handlerPrometheusStats(absl::string_view path_and_query,
                                     Http::ResponseHeaderMap& response_headers,
-                                    Buffer::Instance& response, AdminStream&);
+                                    Buffer::Instance& response, AdminStream& admin_stream);
   Http::Code handlerContention(absl::string_view path_and_query,
                                Http::ResponseHeaderMap& response_headers,
                                Buffer::Instance& response, AdminStream&);
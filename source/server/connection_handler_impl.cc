@@ -595,6 +595,10 @@ void ActiveRawUdpListener::onWriteReady(const Network::Socket&) {
 
   // Clear write_blocked_ status for udpPacketWriter
   udp_packet_writer_->setWritable();
+  if (udp_packet_writer_->isBatchMode()) {
+    // Retry the datagrams left buffered when the socket became write blocked.
+    udp_packet_writer_->flush();
+  }
 }
 
 void ActiveRawUdpListener::onReceiveError(Api::IoError::IoErrorCode error_code) {
@@ -63,6 +63,8 @@ protected:
   static Stats::Gauge& hotRestartGeneration(Stats::Scope& scope);
 
 private:
+  // Returns the fd a message passes as control data, or -1.
+  int fdToPass(const envoy::HotRestartMessage& proto) const;
   void getPassedFdIfPresent(envoy::HotRestartMessage* out, msghdr* message);
   std::unique_ptr<envoy::HotRestartMessage> parseProtoAndResetState();
   void initRecvBufIfNewMessage();
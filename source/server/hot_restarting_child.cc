@@ -1,5 +1,7 @@
 #include "server/hot_restarting_child.h"
 
+#include <sys/mman.h>
+
 #include "common/common/utility.h"
 
 namespace Envoy {
@@ -38,7 +40,7 @@ std::unique_ptr<HotRestartMessage> HotRestartingChild::getParentStats() {
   }
 
   HotRestartMessage wrapped_request;
-  wrapped_request.mutable_request()->mutable_stats();
+  wrapped_request.mutable_request()->mutable_stats()->set_accept_snapshot(true);
   sendHotRestartMessage(parent_address_, wrapped_request);
 
   std::unique_ptr<HotRestartMessage> wrapped_reply = receiveHotRestartMessage(Blocking::Yes);
@@ -101,6 +103,11 @@ void HotRestartingChild::mergeParentStats(Stats::Store& stats_store,
     hot_restart_generation_stat_name_ = hotRestartGeneration(stats_store).statName();
   }
 
+  if (stats_proto.snapshot_size() > 0) {
+    mergeParentStatsSnapshot(stats_proto.snapshot_fd(), stats_proto.snapshot_size());
+    return;
+  }
+
   // Convert the protobuf for serialized dynamic spans into the structure
   // required by StatMerger.
   Stats::StatMerger::DynamicsMap dynamics;
@@ -114,5 +121,18 @@ void HotRestartingChild::mergeParentStats(Stats::Store& stats_store,
   stat_merger_->mergeStats(stats_proto.counter_deltas(), stats_proto.gauges(), dynamics);
 }
 
+void HotRestartingChild::mergeParentStatsSnapshot(int fd, uint64_t size) {
+  RELEASE_ASSERT(fd != -1, "Hot restart parent sent a stats snapshot without its memory file.");
+  void* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  RELEASE_ASSERT(memory != MAP_FAILED,
+                 fmt::format("cannot map the stats snapshot, errno = {}", errno));
+  const Stats::StatsSnapshot snapshot(
+      absl::MakeConstSpan(static_cast<const uint8_t*>(memory), size));
+  RELEASE_ASSERT(snapshot.valid(), "Hot restart parent sent a malformed stats snapshot.");
+  stat_merger_->mergeSnapshot(snapshot);
+  munmap(memory, size);
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -1,10 +1,13 @@
 #include "server/hot_restarting_parent.h"
 
+#include <sys/mman.h>
+
 #include "envoy/server/instance.h"
 
 #include "common/memory/stats.h"
 #include "common/network/utility.h"
 #include "common/stats/stat_merger.h"
+#include "common/stats/stats_snapshot.h"
 #include "common/stats/symbol_table_impl.h"
 #include "common/stats/utility.h"
 
@@ -56,8 +59,13 @@ void HotRestartingParent::onSocketEvent() {
 
     case HotRestartMessage::Request::kStats: {
       HotRestartMessage wrapped_reply;
-      internal_->exportStatsToChild(wrapped_reply.mutable_reply()->mutable_stats());
+      HotRestartMessage::Reply::Stats* stats = wrapped_reply.mutable_reply()->mutable_stats();
+      internal_->exportStatsToChild(stats, wrapped_request->request().stats().accept_snapshot());
       sendHotRestartMessage(child_address_, wrapped_reply);
+      if (stats->snapshot_size() > 0) {
+        // The child has its own reference to the memory file now.
+        close(stats->snapshot_fd());
+      }
       break;
     }
 
@@ -121,30 +129,77 @@ HotRestartingParent::Internal::getListenSocketsForChild(const HotRestartMessage:
 // TODO(fredlas) if there are enough stats for stat name length to become an issue, this current
 // implementation can negate the benefit of symbolized stat names by periodically reaching the
 // magnitude of memory usage that they are meant to avoid, since this map holds full-string
-// names. The problem can be solved by splitting the export up over many chunks.
-void HotRestartingParent::Internal::exportStatsToChild(HotRestartMessage::Reply::Stats* stats) {
+// names. The problem can be solved by splitting the export up over many chunks. Children that
+// accept a snapshot avoid the maps altogether.
+void HotRestartingParent::Internal::exportStatsToChild(HotRestartMessage::Reply::Stats* stats,
+                                                       bool accept_snapshot) {
+  if (!accept_snapshot || !exportStatsSnapshot(stats)) {
+    for (const auto& gauge : server_->stats().gauges()) {
+      if (gauge->used()) {
+        const std::string name = gauge->name();
+        (*stats->mutable_gauges())[name] = gauge->value();
+        recordDynamics(stats, name, gauge->statName());
+      }
+    }
+
+    for (const auto& counter : server_->stats().counters()) {
+      if (counter->used()) {
+        // The hot restart parent is expected to have stopped its normal stat exporting (and so
+        // latching) by the time it begins exporting to the hot restart child.
+        uint64_t latched_value = counter->latch();
+        if (latched_value > 0) {
+          const std::string name = counter->name();
+          (*stats->mutable_counter_deltas())[name] = latched_value;
+          recordDynamics(stats, name, counter->statName());
+        }
+      }
+    }
+  }
+  stats->set_memory_allocated(Memory::Stats::totalCurrentlyAllocated());
+  stats->set_num_connections(server_->listenerManager().numConnections());
+}
+
+bool HotRestartingParent::Internal::exportStatsSnapshot(HotRestartMessage::Reply::Stats* stats) {
+  // The memory file is sized and mapped before any counter is latched, so that a failure can still
+  // fall back to the maps. The counter records are added with a placeholder delta for that.
+  Stats::StatsSnapshot::Builder snapshot(server_->stats().symbolTable());
   for (const auto& gauge : server_->stats().gauges()) {
     if (gauge->used()) {
-      const std::string name = gauge->name();
-      (*stats->mutable_gauges())[name] = gauge->value();
-      recordDynamics(stats, name, gauge->statName());
+      snapshot.addGauge(gauge->statName(), gauge->value());
     }
   }
-
+  std::vector<std::pair<Stats::CounterSharedPtr, uint32_t>> counters;
   for (const auto& counter : server_->stats().counters()) {
     if (counter->used()) {
-      // The hot restart parent is expected to have stopped its normal stat exporting (and so
-      // latching) by the time it begins exporting to the hot restart child.
-      uint64_t latched_value = counter->latch();
-      if (latched_value > 0) {
-        const std::string name = counter->name();
-        (*stats->mutable_counter_deltas())[name] = latched_value;
-        recordDynamics(stats, name, counter->statName());
-      }
+      counters.emplace_back(counter, snapshot.addCounter(counter->statName(), 0));
     }
   }
-  stats->set_memory_allocated(Memory::Stats::totalCurrentlyAllocated());
-  stats->set_num_connections(server_->listenerManager().numConnections());
+
+  const uint64_t size = snapshot.size();
+  const int fd = memfd_create("envoy_stats_snapshot", MFD_CLOEXEC);
+  void* memory = MAP_FAILED;
+  if (fd != -1 && ftruncate(fd, size) == 0) {
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (memory == MAP_FAILED) {
+    ENVOY_LOG_MISC(warn, "cannot create a stats snapshot, errno = {}; sending stats in the message",
+                   errno);
+    if (fd != -1) {
+      close(fd);
+    }
+    return false;
+  }
+
+  // The hot restart parent is expected to have stopped its normal stat exporting (and so
+  // latching) by the time it begins exporting to the hot restart child.
+  for (const auto& counter : counters) {
+    snapshot.setValue(counter.second, counter.first->latch());
+  }
+  snapshot.write(static_cast<uint8_t*>(memory));
+  munmap(memory, size);
+  stats->set_snapshot_size(size);
+  stats->set_snapshot_fd(fd);
+  return true;
 }
 
 void HotRestartingParent::Internal::recordDynamics(HotRestartMessage::Reply::Stats* stats,
@@ -29,12 +29,20 @@ public:
     envoy::HotRestartMessage
     getListenSocketsForChild(const envoy::HotRestartMessage::Request& request);
     // 'stats' is a field in the reply protobuf to be sent to the child, which we should populate.
-    void exportStatsToChild(envoy::HotRestartMessage::Reply::Stats* stats);
+    // If 'accept_snapshot' is set, counters and gauges are exported in a stats snapshot rather
+    // than in the protobuf maps, unless no memory file can be created. The snapshot fd must be
+    // closed once the reply is sent.
+    void exportStatsToChild(envoy::HotRestartMessage::Reply::Stats* stats,
+                            bool accept_snapshot = false);
     void recordDynamics(envoy::HotRestartMessage::Reply::Stats* stats, const std::string& name,
                         Stats::StatName stat_name);
     void drainListeners();
 
   private:
+    // Exports the counters and gauges in a stats snapshot. Returns false, without latching any
+    // counter, if no memory file could be created.
+    bool exportStatsSnapshot(envoy::HotRestartMessage::Reply::Stats* stats);
+
     Server::Instance* const server_{};
   };
 
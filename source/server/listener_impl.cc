@@ -382,8 +382,13 @@ void ListenerImpl::buildUdpListenerFactory(Network::Socket::Type socket_type,
 void ListenerImpl::buildUdpWriterFactory(Network::Socket::Type socket_type) {
   if (socket_type == Network::Socket::Type::Datagram) {
     auto udp_writer_config = config_.udp_writer_config();
-    if (!Api::OsSysCallsSingleton::get().supportsUdpGso() ||
-        udp_writer_config.typed_config().type_url().empty()) {
+    // The GSO batch writer cannot work without kernel support, fall back to the default writer
+    // in that case. Other writers (e.g. the generic batch writer) degrade on their own.
+    const bool gso_writer_unsupported =
+        !Api::OsSysCallsSingleton::get().supportsUdpGso() &&
+        udp_writer_config.typed_config().type_url() ==
+            "type.googleapis.com/envoy.config.listener.v3.UdpGsoBatchWriterOptions";
+    if (gso_writer_unsupported || udp_writer_config.typed_config().type_url().empty()) {
       const std::string default_type_url =
           "type.googleapis.com/envoy.config.listener.v3.UdpDefaultWriterOptions";
       udp_writer_config.mutable_typed_config()->set_type_url(default_type_url);
@@ -1,5 +1,6 @@
 #include "server/server.h"
 
+#include <algorithm>
 #include <csignal>
 #include <cstdint>
 #include <functional>
@@ -174,15 +175,113 @@ MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store) {
   }
 }
 
+ChangedMetricSnapshotImpl::ChangedMetricSnapshotImpl(Stats::Store& store)
+    : changed_(store.collectChangedMetrics()) {
+  // A counter which was only reset has no delta, the sinks report the counters which incremented.
+  counters_.reserve(changed_.counters_.size());
+  for (const auto& counter : changed_.counters_) {
+    const uint64_t delta = counter->latch();
+    if (delta > 0) {
+      counters_.push_back({delta, *counter});
+    }
+  }
+
+  snapGauges();
+
+  snapped_histograms_ = store.histograms();
+  for (const auto& histogram : snapped_histograms_) {
+    addHistogramIfChanged(*histogram);
+  }
+
+  snapped_text_readouts_ = store.textReadouts();
+  text_readouts_.reserve(snapped_text_readouts_.size());
+  for (const auto& text_readout : snapped_text_readouts_) {
+    text_readouts_.push_back(*text_readout);
+  }
+}
+
+ChangedMetricSnapshotImpl::ChangedMetricSnapshotImpl(Stats::Store& store,
+                                                     Stats::MetricSnapshot& full_snapshot)
+    : changed_(store.collectChangedMetrics()) {
+  // The changed counters were latched by the full snapshot, which has their deltas.
+  for (const auto& counter : full_snapshot.counters()) {
+    if (counter.delta_ > 0) {
+      counters_.push_back(counter);
+    }
+  }
+  changed_.counters_.clear();
+
+  snapGauges();
+
+  for (const auto& histogram : full_snapshot.histograms()) {
+    addHistogramIfChanged(histogram.get());
+  }
+
+  text_readouts_ = full_snapshot.textReadouts();
+}
+
+void ChangedMetricSnapshotImpl::snapGauges() {
+  gauges_.reserve(changed_.gauges_.size());
+  for (const auto& gauge : changed_.gauges_) {
+    ASSERT(gauge->importMode() != Stats::Gauge::ImportMode::Uninitialized);
+    gauges_.push_back(*gauge);
+  }
+}
+
+void ChangedMetricSnapshotImpl::addHistogramIfChanged(const Stats::ParentHistogram& histogram) {
+  if (histogram.used() && histogram.intervalStatistics().sampleCount() > 0) {
+    histograms_.push_back(histogram);
+  }
+}
+
 void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks,
                                        Stats::Store& store) {
+  // The sinks are asked before any of them is flushed, as flushing may change their answer.
+  std::vector<bool> changed_metrics_only;
+  changed_metrics_only.reserve(sinks.size());
+  for (const auto& sink : sinks) {
+    changed_metrics_only.push_back(sink->changedMetricsOnly());
+  }
+  const bool any_changed_only =
+      std::find(changed_metrics_only.begin(), changed_metrics_only.end(), true) !=
+      changed_metrics_only.end();
+  const bool all_changed_only =
+      any_changed_only && std::find(changed_metrics_only.begin(), changed_metrics_only.end(),
+                                    false) == changed_metrics_only.end();
+
   // Create a snapshot and flush to all sinks.
   // NOTE: Even if there are no sinks, creating the snapshot has the important property that it
   //       latches all counters on a periodic basis. The hot restart code assumes this is being
-  //       done so this should not be removed.
+  //       done so this should not be removed. The snapshot of the changed metrics latches all the
+  //       counters which have something to latch.
+  if (!any_changed_only) {
+    MetricSnapshotImpl snapshot(store);
+    for (const auto& sink : sinks) {
+      sink->flush(snapshot);
+    }
+    return;
+  }
+
+  // Tracking starts with the first flush to a sink which opts in, so that it costs nothing when no
+  // sink does. The first collection returns all the counters and gauges.
+  store.trackChangedMetrics();
+  if (all_changed_only) {
+    ChangedMetricSnapshotImpl snapshot(store);
+    for (const auto& sink : sinks) {
+      sink->flush(snapshot);
+    }
+    return;
+  }
+
   MetricSnapshotImpl snapshot(store);
+  ChangedMetricSnapshotImpl changed_snapshot(store, snapshot);
+  auto changed_only = changed_metrics_only.begin();
   for (const auto& sink : sinks) {
-    sink->flush(snapshot);
+    if (*changed_only++) {
+      sink->flush(changed_snapshot);
+    } else {
+      sink->flush(snapshot);
+    }
   }
 }
 
@@ -444,6 +543,9 @@ void InstanceImpl::initialize(const Options& options,
   } else {
     ENVOY_LOG(warn, "No admin address given, so no admin HTTP server started.");
   }
+  if (bootstrap_.admin().has_continuous_profiler()) {
+    admin_->startContinuousProfiler(bootstrap_.admin().continuous_profiler());
+  }
   config_tracker_entry_ =
       admin_->getConfigTracker().add("bootstrap", [this] { return dumpBootstrapConfig(); });
   if (initial_config.admin().address()) {
@@ -408,5 +408,40 @@ private:
   std::vector<std::reference_wrapper<const Stats::TextReadout>> text_readouts_;
 };
 
+// Snapshot of the counters and gauges which changed since the previous flush, for the sinks which
+// opt in with Stats::Sink::changedMetricsOnly(). The store must track the changed metrics.
+class ChangedMetricSnapshotImpl : public Stats::MetricSnapshot {
+public:
+  // Latches the changed counters. The counters which did not change have nothing to latch.
+  explicit ChangedMetricSnapshotImpl(Stats::Store& store);
+  // Used when a full snapshot is also flushed, which has already latched all the counters. The
+  // full snapshot must outlive this one.
+  ChangedMetricSnapshotImpl(Stats::Store& store, Stats::MetricSnapshot& full_snapshot);
+
+  // Stats::MetricSnapshot
+  const std::vector<CounterSnapshot>& counters() override { return counters_; }
+  const std::vector<std::reference_wrapper<const Stats::Gauge>>& gauges() override {
+    return gauges_;
+  };
+  const std::vector<std::reference_wrapper<const Stats::ParentHistogram>>& histograms() override {
+    return histograms_;
+  }
+  const std::vector<std::reference_wrapper<const Stats::TextReadout>>& textReadouts() override {
+    return text_readouts_;
+  }
+
+private:
+  void snapGauges();
+  void addHistogramIfChanged(const Stats::ParentHistogram& histogram);
+
+  Stats::Store::ChangedMetrics changed_;
+  std::vector<CounterSnapshot> counters_;
+  std::vector<std::reference_wrapper<const Stats::Gauge>> gauges_;
+  std::vector<Stats::ParentHistogramSharedPtr> snapped_histograms_;
+  std::vector<std::reference_wrapper<const Stats::ParentHistogram>> histograms_;
+  std::vector<Stats::TextReadoutSharedPtr> snapped_text_readouts_;
+  std::vector<std::reference_wrapper<const Stats::TextReadout>> text_readouts_;
+};
+
 } // namespace Server
 } // namespace Envoy
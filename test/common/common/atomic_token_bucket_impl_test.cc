@@ -0,0 +1,140 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/common/atomic_token_bucket_impl.h"
+
+#include "test/test_common/simulated_time_system.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+class AtomicTokenBucketImplTest : public testing::Test {
+protected:
+  Event::SimulatedTimeSystem time_system_;
+};
+
+// Verifies AtomicTokenBucket initialization.
+TEST_F(AtomicTokenBucketImplTest, Initialization) {
+  AtomicTokenBucketImpl token_bucket{1, time_system_, -1.0};
+
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+}
+
+// Verifies AtomicTokenBucket's maximum capacity.
+TEST_F(AtomicTokenBucketImplTest, MaxBucketSize) {
+  AtomicTokenBucketImpl token_bucket{3, time_system_, 1};
+
+  EXPECT_EQ(3, token_bucket.consume(3, false));
+  time_system_.setMonotonicTime(std::chrono::seconds(10));
+  EXPECT_EQ(0, token_bucket.consume(4, false));
+  EXPECT_EQ(3, token_bucket.consume(3, false));
+}
+
+// Verifies that AtomicTokenBucket can consume tokens.
+TEST_F(AtomicTokenBucketImplTest, Consume) {
+  AtomicTokenBucketImpl token_bucket{10, time_system_, 1};
+
+  EXPECT_EQ(0, token_bucket.consume(20, false));
+  EXPECT_EQ(9, token_bucket.consume(9, false));
+
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(999));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(5999));
+  EXPECT_EQ(0, token_bucket.consume(6, false));
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(6000));
+  EXPECT_EQ(6, token_bucket.consume(6, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+}
+
+// Verifies that AtomicTokenBucket can refill tokens.
+TEST_F(AtomicTokenBucketImplTest, Refill) {
+  AtomicTokenBucketImpl token_bucket{1, time_system_, 0.5};
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(500));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  time_system_.setMonotonicTime(std::chrono::milliseconds(1500));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  time_system_.setMonotonicTime(std::chrono::milliseconds(2000));
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+}
+
+TEST_F(AtomicTokenBucketImplTest, NextTokenAvailable) {
+  AtomicTokenBucketImpl token_bucket{10, time_system_, 5};
+  EXPECT_EQ(9, token_bucket.consume(9, false));
+  EXPECT_EQ(std::chrono::milliseconds(0), token_bucket.nextTokenAvailable());
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  EXPECT_EQ(std::chrono::milliseconds(200), token_bucket.nextTokenAvailable());
+
+  // Unlike TokenBucketImpl, the time already elapsed towards the next token is accounted for.
+  time_system_.advanceTimeWait(std::chrono::milliseconds(100));
+  EXPECT_EQ(std::chrono::milliseconds(100), token_bucket.nextTokenAvailable());
+}
+
+// Test partial consumption of tokens.
+TEST_F(AtomicTokenBucketImplTest, PartialConsumption) {
+  AtomicTokenBucketImpl token_bucket{16, time_system_, 16};
+  EXPECT_EQ(16, token_bucket.consume(18, true));
+  EXPECT_EQ(std::chrono::milliseconds(63), token_bucket.nextTokenAvailable());
+  time_system_.advanceTimeWait(std::chrono::milliseconds(62));
+  EXPECT_EQ(0, token_bucket.consume(1, true));
+  time_system_.advanceTimeWait(std::chrono::milliseconds(1));
+  EXPECT_EQ(1, token_bucket.consume(2, true));
+  EXPECT_EQ(0, token_bucket.consume(1, true));
+}
+
+// Test reset functionality.
+TEST_F(AtomicTokenBucketImplTest, Reset) {
+  AtomicTokenBucketImpl token_bucket{16, time_system_, 16};
+  token_bucket.reset(1);
+  EXPECT_EQ(1, token_bucket.consume(2, true));
+  EXPECT_EQ(std::chrono::milliseconds(63), token_bucket.nextTokenAvailable());
+}
+
+// Verifies that a consumer racing with another one retries with the updated bucket.
+TEST_F(AtomicTokenBucketImplTest, CasFailure) {
+  AtomicTokenBucketImpl token_bucket{2, time_system_, 1};
+  token_bucket.synchronizer().enable();
+
+  // Start a thread which consumes both tokens. This will wait pre-CAS.
+  token_bucket.synchronizer().waitOn("consume_pre_cas");
+  std::thread t1([&] { EXPECT_EQ(1, token_bucket.consume(2, true)); });
+  // Wait until the thread is actually waiting.
+  token_bucket.synchronizer().barrierOn("consume_pre_cas");
+
+  // Consume a token on this thread, which should cause the CAS to fail on the other thread, which
+  // then only finds one token left.
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+  token_bucket.synchronizer().signal("consume_pre_cas");
+  t1.join();
+
+  EXPECT_EQ(0, token_bucket.consume(1, true));
+}
+
+// Verifies that concurrent consumers never get more tokens than the bucket holds.
+TEST_F(AtomicTokenBucketImplTest, ConcurrentConsumers) {
+  AtomicTokenBucketImpl token_bucket{10000, time_system_, 1};
+  std::atomic<uint64_t> consumed{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 2000; j++) {
+        consumed += token_bucket.consume(1, false);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(10000, consumed);
+}
+
+} // namespace Envoy
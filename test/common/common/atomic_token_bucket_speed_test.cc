@@ -0,0 +1,75 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Compares the contention of worker threads consuming from one shared token bucket, using
+// AtomicTokenBucketImpl or a TokenBucketImpl behind a mutex.
+
+#include "common/common/assert.h"
+#include "common/common/atomic_token_bucket_impl.h"
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/common/token_bucket_impl.h"
+#include "common/common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+
+// A TokenBucketImpl shared by threads, as buckets were before AtomicTokenBucketImpl.
+class MutexTokenBucket {
+public:
+  MutexTokenBucket(uint64_t max_tokens, TimeSource& time_source, double fill_rate)
+      : bucket_(max_tokens, time_source, fill_rate) {}
+
+  uint64_t consume(uint64_t tokens, bool allow_partial) {
+    Thread::LockGuard lock(mutex_);
+    return bucket_.consume(tokens, allow_partial);
+  }
+
+private:
+  Thread::MutexBasicLockable mutex_;
+  TokenBucketImpl bucket_ ABSL_GUARDED_BY(mutex_);
+};
+
+} // namespace Envoy
+
+// The buckets never run out of tokens, so that every consume succeeds.
+static constexpr uint64_t MaxTokens = 1ULL << 40;
+static constexpr double FillRate = 1e9;
+
+static Envoy::RealTimeSource time_source;
+
+// Shared by all threads of a benchmark. Created and destroyed by thread 0; the benchmark library
+// synchronizes all threads before and after the timed loop.
+static Envoy::AtomicTokenBucketImpl* atomic_bucket = nullptr;
+static Envoy::MutexTokenBucket* mutex_bucket = nullptr;
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_AtomicTokenBucket(benchmark::State& state) {
+  if (state.thread_index == 0) {
+    atomic_bucket = new Envoy::AtomicTokenBucketImpl(MaxTokens, time_source, FillRate);
+  }
+  for (auto _ : state) {
+    RELEASE_ASSERT(atomic_bucket->consume(1, false) == 1, "");
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) {
+    delete atomic_bucket;
+  }
+}
+BENCHMARK(BM_AtomicTokenBucket)->ThreadRange(1, 16)->UseRealTime();
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_MutexTokenBucket(benchmark::State& state) {
+  if (state.thread_index == 0) {
+    mutex_bucket = new Envoy::MutexTokenBucket(MaxTokens, time_source, FillRate);
+  }
+  for (auto _ : state) {
+    RELEASE_ASSERT(mutex_bucket->consume(1, false) == 1, "");
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) {
+    delete mutex_bucket;
+  }
+}
+BENCHMARK(BM_MutexTokenBucket)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,78 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the encoding and decoding of inputs of various sizes, which go through the vectorized
+// code paths of the CPU, if any, from a few dozen bytes on.
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/base64.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+
+static std::string makeInput(size_t size) {
+  std::string input;
+  input.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    input.push_back(static_cast<char>(i * 37));
+  }
+  return input;
+}
+
+static void BM_Base64Encode(benchmark::State& state) {
+  const std::string input = makeInput(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Base64::encode(input.data(), input.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Base64Encode)->Range(16, 1 << 20);
+
+static void BM_Base64EncodeBuffer(benchmark::State& state) {
+  const std::string input = makeInput(state.range(0));
+  Buffer::OwnedImpl buffer(input);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Base64::encode(buffer, buffer.length()));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Base64EncodeBuffer)->Range(16, 1 << 20);
+
+static void BM_Base64Decode(benchmark::State& state) {
+  const std::string input = makeInput(state.range(0));
+  const std::string encoded = Base64::encode(input.data(), input.size());
+  for (auto _ : state) {
+    const std::string decoded = Base64::decode(encoded);
+    RELEASE_ASSERT(decoded.size() == input.size(), "");
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK(BM_Base64Decode)->Range(16, 1 << 20);
+
+static void BM_Base64UrlEncode(benchmark::State& state) {
+  const std::string input = makeInput(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Base64Url::encode(input.data(), input.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Base64UrlEncode)->Range(16, 1 << 20);
+
+static void BM_Base64UrlDecode(benchmark::State& state) {
+  const std::string input = makeInput(state.range(0));
+  const std::string encoded = Base64Url::encode(input.data(), input.size());
+  for (auto _ : state) {
+    const std::string decoded = Base64Url::decode(encoded);
+    RELEASE_ASSERT(decoded.size() == input.size(), "");
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK(BM_Base64UrlDecode)->Range(16, 1 << 20);
+
+} // namespace Envoy
@@ -132,6 +132,60 @@ TEST(Base64Test, BinaryBufferEncode) {
   EXPECT_EQ("AAECAwgKCQCqvN4=", Base64::encode(buffer, 30));
 }
 
+// Long inputs are encoded and decoded a block at a time with vector instructions, where the CPU
+// supports them. The inputs below cover every character at every position of a block, as well as
+// the remainders handled one character at a time.
+TEST(Base64Test, LongInput) {
+  std::string alphabet;
+  for (int i = 0; i < 5; ++i) {
+    alphabet += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  }
+  for (size_t length = 0; length <= alphabet.size(); length += 4) {
+    const std::string encoded = alphabet.substr(alphabet.size() - length);
+    const std::string decoded = Base64::decode(encoded);
+    EXPECT_EQ(length / 4 * 3, decoded.size());
+    EXPECT_EQ(encoded, Base64::encode(decoded.data(), decoded.size()));
+  }
+
+  std::string input;
+  for (size_t length = 0; length < 200; ++length) {
+    const std::string encoded = Base64::encode(input.data(), input.size());
+    EXPECT_EQ(input, Base64::decode(encoded));
+    EXPECT_EQ(input, Base64::decodeWithoutPadding(Base64::encode(input.data(), length, false)));
+    input.push_back(static_cast<char>(length * 37));
+  }
+
+  EXPECT_EQ(std::string(128, 'A'), Base64::encode(std::string(96, '\0').data(), 96));
+  EXPECT_EQ(std::string(128, '/'), Base64::encode(std::string(96, '\xff').data(), 96));
+  EXPECT_EQ(std::string(96, '\xff'), Base64::decode(std::string(128, '/')));
+}
+
+TEST(Base64Test, LongInputDecodeFailure) {
+  const std::string encoded = Base64::encode(std::string(96, '\xfb').data(), 96);
+  for (const char invalid : {'.', '=', '-', '_', '\0', '\x80', '\xff'}) {
+    for (size_t i = 0; i < encoded.size(); ++i) {
+      std::string corrupted = encoded;
+      corrupted[i] = invalid;
+      EXPECT_EQ("", Base64::decode(corrupted)) << "at " << i;
+    }
+  }
+}
+
+TEST(Base64Test, LongMultiSlicesBufferEncode) {
+  std::string input;
+  for (int i = 0; i < 300; ++i) {
+    input.push_back(static_cast<char>(i * 13));
+  }
+  Buffer::OwnedImpl buffer;
+  // Slices of varying sizes, so that they start at every position of a 3 byte group.
+  for (size_t start = 0, size = 1; start < input.size(); start += size, size += 7) {
+    buffer.appendSliceForTest(input.substr(start, size));
+  }
+  for (uint64_t length : {50, 100, 173, 299, 300}) {
+    EXPECT_EQ(Base64::encode(input.data(), length), Base64::encode(buffer, length));
+  }
+}
+
 TEST(Base64UrlTest, EncodeString) {
   EXPECT_EQ("", Base64Url::encode("", 0));
   EXPECT_EQ("AAA", Base64Url::encode("\0\0", 2));
@@ -186,4 +240,37 @@ TEST(Base64UrlTest, DecodeFailure) {
   EXPECT_EQ("", Base64Url::decode("Zm9")); // 011001 100110 111101 <- unused bit at tail
   EXPECT_EQ("", Base64Url::decode("A"));
 }
+
+TEST(Base64UrlTest, LongInput) {
+  std::string alphabet;
+  for (int i = 0; i < 5; ++i) {
+    alphabet += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  }
+  for (size_t length = 0; length <= alphabet.size(); length += 4) {
+    const std::string encoded = alphabet.substr(alphabet.size() - length);
+    const std::string decoded = Base64Url::decode(encoded);
+    EXPECT_EQ(length / 4 * 3, decoded.size());
+    EXPECT_EQ(encoded, Base64Url::encode(decoded.data(), decoded.size()));
+  }
+
+  std::string input;
+  for (size_t length = 0; length < 200; ++length) {
+    EXPECT_EQ(input, Base64Url::decode(Base64Url::encode(input.data(), input.size())));
+    input.push_back(static_cast<char>(length * 37));
+  }
+
+  EXPECT_EQ(std::string(128, '_'), Base64Url::encode(std::string(96, '\xff').data(), 96));
+  EXPECT_EQ(std::string(96, '\xff'), Base64Url::decode(std::string(128, '_')));
+}
+
+TEST(Base64UrlTest, LongInputDecodeFailure) {
+  const std::string encoded = Base64Url::encode(std::string(96, '\xfb').data(), 96);
+  for (const char invalid : {'.', '=', '+', '/', '\0', '\x80', '\xff'}) {
+    for (size_t i = 0; i < encoded.size(); ++i) {
+      std::string corrupted = encoded;
+      corrupted[i] = invalid;
+      EXPECT_EQ("", Base64Url::decode(corrupted)) << "at " << i;
+    }
+  }
+}
 } // namespace Envoy
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/api/api_impl.h"
+#include "common/event/dispatcher_impl.h"
+#include "common/event/slow_callback_tracer.h"
+
+#include "test/mocks/common.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Event {
+namespace {
+
+class SlowCallbackTracerTest : public testing::Test {
+public:
+  ~SlowCallbackTracerTest() override { SlowCallbackTracer::disable(); }
+
+  void runCallback(SlowCallbackTracer::CallbackType type, std::chrono::microseconds duration) {
+    SlowCallbackTracer::CallbackScope scope(&tracer_, type);
+    time_system_.advanceTimeWait(duration);
+  }
+
+  SimulatedTimeSystem time_system_;
+  SlowCallbackTracer tracer_{"worker_0", time_system_};
+};
+
+// Nothing is recorded while tracing is disabled.
+TEST_F(SlowCallbackTracerTest, Disabled) {
+  EXPECT_FALSE(SlowCallbackTracer::enabled());
+  runCallback(SlowCallbackTracer::CallbackType::Timer, std::chrono::seconds(1));
+  EXPECT_FALSE(tracer_.active());
+  EXPECT_TRUE(tracer_.slowCallbacks().empty());
+}
+
+// Only the callbacks that reach the threshold are recorded.
+TEST_F(SlowCallbackTracerTest, Threshold) {
+  SlowCallbackTracer::enable(std::chrono::milliseconds(1));
+  runCallback(SlowCallbackTracer::CallbackType::FileEvent, std::chrono::microseconds(999));
+  runCallback(SlowCallbackTracer::CallbackType::Timer, std::chrono::milliseconds(2));
+
+  const std::vector<SlowCallbackTracer::SlowCallback> slow_callbacks = tracer_.slowCallbacks();
+  ASSERT_EQ(1, slow_callbacks.size());
+  EXPECT_EQ(SlowCallbackTracer::CallbackType::Timer, slow_callbacks[0].type_);
+  EXPECT_EQ(std::chrono::microseconds(2000), slow_callbacks[0].duration_);
+  EXPECT_TRUE(slow_callbacks[0].scope_.empty());
+  EXPECT_TRUE(slow_callbacks[0].stack_.empty());
+  EXPECT_EQ("timer", SlowCallbackTracer::callbackTypeName(slow_callbacks[0].type_));
+
+  // Enabling again starts a fresh trace.
+  SlowCallbackTracer::enable(std::chrono::milliseconds(1));
+  EXPECT_TRUE(tracer_.slowCallbacks().empty());
+
+  // Disabling keeps what was recorded.
+  runCallback(SlowCallbackTracer::CallbackType::DeferredDelete, std::chrono::milliseconds(1));
+  SlowCallbackTracer::disable();
+  EXPECT_EQ(1, tracer_.slowCallbacks().size());
+}
+
+// The tracked object replaced after the threshold is exceeded is captured with a stack sample.
+TEST_F(SlowCallbackTracerTest, TrackedObject) {
+  SlowCallbackTracer::enable(std::chrono::milliseconds(1));
+  MockScopedTrackedObject connection;
+  MockScopedTrackedObject stream;
+  EXPECT_CALL(connection, dumpState(_, _)).Times(0);
+  EXPECT_CALL(stream, dumpState(_, _)).WillOnce(Invoke([](std::ostream& os, int) {
+    os << "ActiveStream\n  stream_id_: 1\n";
+  }));
+  {
+    SlowCallbackTracer::CallbackScope scope(&tracer_, SlowCallbackTracer::CallbackType::FileEvent);
+    EXPECT_TRUE(tracer_.active());
+    // Not captured before the threshold.
+    tracer_.onTrackedObjectChange(&connection);
+    time_system_.advanceTimeWait(std::chrono::milliseconds(3));
+    // Nested callbacks are attributed to the outer one.
+    SlowCallbackTracer::CallbackScope nested(&tracer_, SlowCallbackTracer::CallbackType::Timer);
+    tracer_.onTrackedObjectChange(nullptr);
+    tracer_.onTrackedObjectChange(&stream);
+    // Only the first object is captured.
+    tracer_.onTrackedObjectChange(&connection);
+  }
+
+  const std::vector<SlowCallbackTracer::SlowCallback> slow_callbacks = tracer_.slowCallbacks();
+  ASSERT_EQ(1, slow_callbacks.size());
+  EXPECT_EQ(SlowCallbackTracer::CallbackType::FileEvent, slow_callbacks[0].type_);
+  EXPECT_EQ("ActiveStream\n  stream_id_: 1\n", slow_callbacks[0].scope_);
+  EXPECT_FALSE(slow_callbacks[0].stack_.empty());
+  EXPECT_LE(slow_callbacks[0].stack_.size(), SlowCallbackTracer::MaxStackDepth);
+}
+
+// The ring keeps the most recent slow callbacks.
+TEST_F(SlowCallbackTracerTest, Ring) {
+  SlowCallbackTracer::enable(std::chrono::microseconds(1));
+  for (size_t i = 0; i < SlowCallbackTracer::MaxSlowCallbacks + 2; ++i) {
+    runCallback(SlowCallbackTracer::CallbackType::Timer, std::chrono::microseconds(i + 1));
+  }
+  const std::vector<SlowCallbackTracer::SlowCallback> slow_callbacks = tracer_.slowCallbacks();
+  ASSERT_EQ(SlowCallbackTracer::MaxSlowCallbacks, slow_callbacks.size());
+  EXPECT_EQ(std::chrono::microseconds(3), slow_callbacks.front().duration_);
+  EXPECT_EQ(std::chrono::microseconds(SlowCallbackTracer::MaxSlowCallbacks + 2),
+            slow_callbacks.back().duration_);
+}
+
+// Live tracers are visited by name.
+TEST_F(SlowCallbackTracerTest, ForEachTracer) {
+  std::vector<std::string> names;
+  SlowCallbackTracer::forEachTracer(
+      [&names](const SlowCallbackTracer& tracer) { names.push_back(tracer.name()); });
+  EXPECT_THAT(names, testing::Contains("worker_0"));
+}
+
+class TestDeferredDeletable : public DeferredDeletable {};
+
+// The deferred deletion and timer callbacks of a dispatcher are recorded by its tracer.
+TEST_F(SlowCallbackTracerTest, Dispatcher) {
+  Api::ApiPtr api = Api::createApiForTest();
+  DispatcherPtr dispatcher = api->allocateDispatcher("test_thread");
+  SlowCallbackTracer& tracer = static_cast<DispatcherImpl*>(dispatcher.get())->slowCallbackTracer();
+  EXPECT_EQ("test_thread", tracer.name());
+  // Every callback reaches a zero threshold.
+  SlowCallbackTracer::enable(std::chrono::microseconds(0));
+
+  dispatcher->deferredDelete(std::make_unique<TestDeferredDeletable>());
+  dispatcher->run(Dispatcher::RunType::NonBlock);
+
+  MockScopedTrackedObject scope;
+  EXPECT_CALL(scope, dumpState(_, _)).WillOnce(Invoke([](std::ostream& os, int) {
+    os << "ConnectionImpl";
+  }));
+  bool timer_called = false;
+  TimerPtr timer = dispatcher->createTimer([&timer_called]() { timer_called = true; });
+  timer->enableTimer(std::chrono::milliseconds(0), &scope);
+  while (!timer_called) {
+    dispatcher->run(Dispatcher::RunType::NonBlock);
+  }
+
+  const std::vector<SlowCallbackTracer::SlowCallback> slow_callbacks = tracer.slowCallbacks();
+  ASSERT_EQ(2, slow_callbacks.size());
+  EXPECT_EQ(SlowCallbackTracer::CallbackType::DeferredDelete, slow_callbacks[0].type_);
+  EXPECT_TRUE(slow_callbacks[0].scope_.empty());
+  EXPECT_EQ(SlowCallbackTracer::CallbackType::Timer, slow_callbacks[1].type_);
+  EXPECT_EQ("ConnectionImpl", slow_callbacks[1].scope_);
+  EXPECT_FALSE(slow_callbacks[1].stack_.empty());
+}
+
+} // namespace
+} // namespace Event
+} // namespace Envoy
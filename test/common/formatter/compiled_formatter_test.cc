@@ -0,0 +1,186 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/formatter/compiled_formatter.h"
+#include "common/formatter/substitution_formatter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Formatter {
+namespace {
+
+class CompiledFormatterTest : public testing::Test {
+public:
+  CompiledFormatterTest() {
+    stream_info_.protocol_ = Http::Protocol::Http11;
+    stream_info_.response_code_ = 200;
+    stream_info_.bytes_received_ = 12;
+    stream_info_.bytes_sent_ = 3456;
+    stream_info_.end_time_ = std::chrono::milliseconds(25);
+    stream_info_.last_downstream_rx_byte_received_ = std::chrono::microseconds(1500);
+    stream_info_.response_code_details_ = "via_upstream";
+  }
+
+  std::string formatText(const std::string& format) {
+    CompiledFormatter formatter(format);
+    const std::string output = formatter.format(request_headers_, response_headers_,
+                                                response_trailers_, stream_info_, body_);
+
+    // The buffer and string paths always agree.
+    Buffer::OwnedImpl buffer("prefix:");
+    formatter.formatToBuffer(request_headers_, response_headers_, response_trailers_, stream_info_,
+                             body_, buffer);
+    EXPECT_EQ("prefix:" + output, buffer.toString());
+    return output;
+  }
+
+  std::string expectedText(const std::string& format) {
+    return FormatterImpl(format).format(request_headers_, response_headers_, response_trailers_,
+                                        stream_info_, body_);
+  }
+
+  void expectSameJson(const absl::flat_hash_map<std::string, std::string>& format_mapping,
+                      bool preserve_types) {
+    CompiledJsonFormatter formatter(format_mapping, preserve_types);
+    const std::string output = formatter.format(request_headers_, response_headers_,
+                                                response_trailers_, stream_info_, body_);
+    const std::string expected =
+        JsonFormatterImpl(format_mapping, preserve_types)
+            .format(request_headers_, response_headers_, response_trailers_, stream_info_, body_);
+
+    // Exactly one trailing newline, like JsonFormatterImpl.
+    EXPECT_EQ(output.find('\n'), output.length() - 1);
+    EXPECT_TRUE(TestUtility::jsonStringEqual(output, expected)) << output << " vs " << expected;
+
+    Buffer::OwnedImpl buffer;
+    formatter.formatToBuffer(request_headers_, response_headers_, response_trailers_, stream_info_,
+                             body_, buffer);
+    EXPECT_EQ(output, buffer.toString());
+  }
+
+  Http::TestRequestHeaderMapImpl request_headers_{{":method", "GET"},
+                                                  {":path", "/some/path"},
+                                                  {":authority", "example.com"},
+                                                  {"user-agent", "curl/7.64 \"quoted\""},
+                                                  {"x-forwarded-proto", "https"}};
+  Http::TestResponseHeaderMapImpl response_headers_{{"x-envoy-upstream-service-time", "10"}};
+  Http::TestResponseTrailerMapImpl response_trailers_{{"grpc-status", "0"}};
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  std::string body_{"local reply"};
+};
+
+// Text output matches FormatterImpl for inline and provider backed commands alike.
+TEST_F(CompiledFormatterTest, TextMatchesFormatterImpl) {
+  const std::vector<std::string> formats = {
+      "",
+      "plain text only",
+      "%PROTOCOL%",
+      "[%START_TIME(%Y/%m/%d)%] \"%REQ(:METHOD)% %REQ(X-ENVOY-ORIGINAL-PATH?:PATH)% %PROTOCOL%\" "
+      "%RESPONSE_CODE% %RESPONSE_FLAGS% %BYTES_RECEIVED% %BYTES_SENT% %DURATION% "
+      "%RESP(X-ENVOY-UPSTREAM-SERVICE-TIME)% \"%REQ(X-FORWARDED-FOR)%\" \"%REQ(USER-AGENT)%\" "
+      "\"%REQ(:AUTHORITY)%\" \"%UPSTREAM_HOST%\"\n",
+      "%REQ(:path):5%|%REQ(missing?:authority):3%|%RESP(missing)%|%TRAILER(grpc-status)%",
+      "%REQUEST_DURATION% %RESPONSE_DURATION% %RESPONSE_CODE_DETAILS% %LOCAL_REPLY_BODY%",
+      "%DOWNSTREAM_REMOTE_ADDRESS% %DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT% "
+      "%DOWNSTREAM_LOCAL_ADDRESS% %DOWNSTREAM_LOCAL_ADDRESS_WITHOUT_PORT% %DOWNSTREAM_LOCAL_PORT%",
+      "grpc %GRPC_STATUS%",
+  };
+  for (const std::string& format : formats) {
+    EXPECT_EQ(expectedText(format), formatText(format)) << format;
+  }
+
+  // Unset values are rendered as unspecified.
+  stream_info_.protocol_.reset();
+  stream_info_.response_code_.reset();
+  stream_info_.end_time_.reset();
+  stream_info_.host_ = nullptr;
+  const std::string format = "%PROTOCOL% %RESPONSE_CODE% %DURATION% %UPSTREAM_HOST%";
+  EXPECT_EQ("- 0 - -", formatText(format));
+  EXPECT_EQ(expectedText(format), formatText(format));
+}
+
+// Common commands are evaluated inline; everything else goes through a FormatterProvider.
+TEST_F(CompiledFormatterTest, Plan) {
+  CompiledFormat format("a%REQ(:path)%b%PROTOCOL%%BYTES_SENT%c%UPSTREAM_CLUSTER%d");
+  EXPECT_EQ(8, format.size());
+  EXPECT_EQ(1, format.providerSteps());
+
+  CompiledFormat literals("only literals");
+  EXPECT_EQ(1, literals.size());
+  EXPECT_EQ(0, literals.providerSteps());
+}
+
+// Invalid formats are rejected with the same errors as SubstitutionFormatParser.
+TEST_F(CompiledFormatterTest, InvalidFormat) {
+  EXPECT_THROW_WITH_MESSAGE(CompiledFormatter("%NOT_A_COMMAND%"), EnvoyException,
+                            "Not supported field in StreamInfo: NOT_A_COMMAND");
+  EXPECT_THROW_WITH_MESSAGE(
+      CompiledFormatter("text %REQ("), EnvoyException,
+      "Incorrect configuration: text %REQ(. Couldn't find valid command at position 5");
+  EXPECT_THROW_WITH_MESSAGE(CompiledFormatter("%REQ(a?b?c)%"), EnvoyException,
+                            "More than 1 alternative header specified in token: REQ(a?b?c)");
+  EXPECT_THROW(CompiledFormatter("%REQ(:path):abc%"), EnvoyException);
+}
+
+// JSON output parses to the same document as JsonFormatterImpl, typed and untyped.
+TEST_F(CompiledFormatterTest, JsonMatchesJsonFormatterImpl) {
+  const absl::flat_hash_map<std::string, std::string> format_mapping = {
+      {"plain", "plain \"text\"\twith\\escapes\x01"},
+      {"method", "%REQ(:METHOD)%"},
+      {"url", "%REQ(X-FORWARDED-PROTO)%://%REQ(:AUTHORITY)%%REQ(X-ENVOY-ORIGINAL-PATH?:PATH)%"},
+      {"missing", "%REQ(missing)%"},
+      {"protocol", "%PROTOCOL%"},
+      {"response_code", "%RESPONSE_CODE%"},
+      {"bytes_sent", "%BYTES_SENT%"},
+      {"duration", "%DURATION%"},
+      {"response_duration", "%RESPONSE_DURATION%"},
+      {"user-agent", "%REQ(USER-AGENT)%"},
+      {"details", "%RESPONSE_CODE_DETAILS%"},
+      {"remote", "%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT%"},
+      {"key with \"quotes\"", "%LOCAL_REPLY_BODY%"},
+      {"markup", "<b>%REQ(:PATH)%</b>\x7f"},
+  };
+  expectSameJson(format_mapping, false);
+  expectSameJson(format_mapping, true);
+  expectSameJson({}, true);
+}
+
+// Strings are escaped exactly as the protobuf JSON printer escapes them. With a single key the
+// whole document is the same, byte for byte.
+TEST_F(CompiledFormatterTest, JsonEscapingMatchesJsonFormatterImpl) {
+  const absl::flat_hash_map<std::string, std::string> format_mapping = {
+      {"<key>", "plain \"text\"\twith\\escapes\x01\x1f <b>markup</b> \x7f %REQ(USER-AGENT)%"}};
+  for (const bool preserve_types : {false, true}) {
+    EXPECT_EQ(JsonFormatterImpl(format_mapping, preserve_types)
+                  .format(request_headers_, response_headers_, response_trailers_, stream_info_,
+                          body_),
+              CompiledJsonFormatter(format_mapping, preserve_types)
+                  .format(request_headers_, response_headers_, response_trailers_, stream_info_,
+                          body_));
+  }
+}
+
+// Typed JSON keeps numbers and nulls and stringifies multi step values.
+TEST_F(CompiledFormatterTest, TypedJson) {
+  CompiledJsonFormatter formatter({{"code", "%RESPONSE_CODE%"},
+                                   {"duration", "%RESPONSE_DURATION%"},
+                                   {"mixed", "%RESPONSE_CODE% ms"},
+                                   {"path", "%REQ(:PATH)%"}},
+                                  true);
+  EXPECT_EQ("{\"code\":200,\"duration\":null,\"mixed\":\"200 ms\",\"path\":\"/some/path\"}\n",
+            formatter.format(request_headers_, response_headers_, response_trailers_, stream_info_,
+                             body_));
+}
+
+} // namespace
+} // namespace Formatter
+} // namespace Envoy
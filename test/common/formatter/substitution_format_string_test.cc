@@ -1,5 +1,6 @@
 #include "envoy/config/core/v3/substitution_format_string.pb.validate.h"
 
+#include "common/formatter/compiled_formatter.h"
 #include "common/formatter/substitution_format_string.h"
 
 #include "test/mocks/http/mocks.h"
@@ -58,6 +59,7 @@ TEST_F(SubstitutionFormatStringUtilsTest, TestFromProtoConfigJson) {
   TestUtility::loadFromYaml(yaml, config_);
 
   auto formatter = SubstitutionFormatStringUtils::fromProtoConfig(config_);
+  EXPECT_NE(nullptr, dynamic_cast<CompiledJsonFormatter*>(formatter.get()));
   const auto out_json = formatter->format(request_headers_, response_headers_, response_trailers_,
                                           stream_info_, body_);
 
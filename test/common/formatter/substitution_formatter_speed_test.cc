@@ -1,3 +1,5 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/formatter/compiled_formatter.h"
 #include "common/formatter/substitution_formatter.h"
 #include "common/network/address_impl.h"
 
@@ -10,8 +12,14 @@ namespace Envoy {
 
 namespace {
 
-std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> makeJsonFormatter(bool typed) {
-  absl::flat_hash_map<std::string, std::string> JsonLogFormat = {
+const char* const LogFormat =
+    "%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT% %START_TIME(%Y/%m/%dT%H:%M:%S%z %s)% "
+    "%REQ(:METHOD)% "
+    "%REQ(X-FORWARDED-PROTO)%://%REQ(:AUTHORITY)%%REQ(X-ENVOY-ORIGINAL-PATH?:PATH)% %PROTOCOL% "
+    "s%RESPONSE_CODE% %BYTES_SENT% %DURATION% %REQ(REFERER)% \"%REQ(USER-AGENT)%\" - - -\n";
+
+absl::flat_hash_map<std::string, std::string> jsonLogFormat() {
+  return {
       {"remote_address", "%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT%"},
       {"start_time", "%START_TIME(%Y/%m/%dT%H:%M:%S%z %s)%"},
       {"method", "%REQ(:METHOD)%"},
@@ -22,8 +30,14 @@ std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> makeJsonFormatter(bool type
       {"duration", "%DURATION%"},
       {"referer", "%REQ(REFERER)%"},
       {"user-agent", "%REQ(USER-AGENT)%"}};
+}
 
-  return std::make_unique<Envoy::Formatter::JsonFormatterImpl>(JsonLogFormat, typed);
+std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> makeJsonFormatter(bool typed) {
+  return std::make_unique<Envoy::Formatter::JsonFormatterImpl>(jsonLogFormat(), typed);
+}
+
+std::unique_ptr<Envoy::Formatter::CompiledJsonFormatter> makeCompiledJsonFormatter(bool typed) {
+  return std::make_unique<Envoy::Formatter::CompiledJsonFormatter>(jsonLogFormat(), typed);
 }
 
 std::unique_ptr<Envoy::TestStreamInfo> makeStreamInfo() {
@@ -38,12 +52,6 @@ std::unique_ptr<Envoy::TestStreamInfo> makeStreamInfo() {
 // NOLINTNEXTLINE(readability-identifier-naming)
 static void BM_AccessLogFormatter(benchmark::State& state) {
   std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo();
-  static const char* LogFormat =
-      "%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT% %START_TIME(%Y/%m/%dT%H:%M:%S%z %s)% "
-      "%REQ(:METHOD)% "
-      "%REQ(X-FORWARDED-PROTO)%://%REQ(:AUTHORITY)%%REQ(X-ENVOY-ORIGINAL-PATH?:PATH)% %PROTOCOL% "
-      "s%RESPONSE_CODE% %BYTES_SENT% %DURATION% %REQ(REFERER)% \"%REQ(USER-AGENT)%\" - - -\n";
-
   std::unique_ptr<Envoy::Formatter::FormatterImpl> formatter =
       std::make_unique<Envoy::Formatter::FormatterImpl>(LogFormat);
 
@@ -102,4 +110,79 @@ static void BM_TypedJsonAccessLogFormatter(benchmark::State& state) {
 }
 BENCHMARK(BM_TypedJsonAccessLogFormatter);
 
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompiledAccessLogFormatter(benchmark::State& state) {
+  std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo();
+  std::unique_ptr<Envoy::Formatter::CompiledFormatter> formatter =
+      std::make_unique<Envoy::Formatter::CompiledFormatter>(LogFormat);
+
+  size_t output_bytes = 0;
+  Http::TestRequestHeaderMapImpl request_headers;
+  Http::TestResponseHeaderMapImpl response_headers;
+  Http::TestResponseTrailerMapImpl response_trailers;
+  std::string body;
+  for (auto _ : state) {
+    output_bytes +=
+        formatter->format(request_headers, response_headers, response_trailers, *stream_info, body)
+            .length();
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_CompiledAccessLogFormatter);
+
+// Formats into one reused buffer, as an access logger batching lines into a write buffer would.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompiledAccessLogFormatterToBuffer(benchmark::State& state) {
+  std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo();
+  std::unique_ptr<Envoy::Formatter::CompiledFormatter> formatter =
+      std::make_unique<Envoy::Formatter::CompiledFormatter>(LogFormat);
+
+  size_t output_bytes = 0;
+  Http::TestRequestHeaderMapImpl request_headers;
+  Http::TestResponseHeaderMapImpl response_headers;
+  Http::TestResponseTrailerMapImpl response_trailers;
+  std::string body;
+  Buffer::OwnedImpl output;
+  for (auto _ : state) {
+    formatter->formatToBuffer(request_headers, response_headers, response_trailers, *stream_info,
+                              body, output);
+    output_bytes += output.length();
+    output.drain(output.length());
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_CompiledAccessLogFormatterToBuffer);
+
+static void compiledJsonAccessLogFormatter(benchmark::State& state, bool typed) {
+  std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo();
+  std::unique_ptr<Envoy::Formatter::CompiledJsonFormatter> json_formatter =
+      makeCompiledJsonFormatter(typed);
+
+  size_t output_bytes = 0;
+  Http::TestRequestHeaderMapImpl request_headers;
+  Http::TestResponseHeaderMapImpl response_headers;
+  Http::TestResponseTrailerMapImpl response_trailers;
+  std::string body;
+  Buffer::OwnedImpl output;
+  for (auto _ : state) {
+    json_formatter->formatToBuffer(request_headers, response_headers, response_trailers,
+                                   *stream_info, body, output);
+    output_bytes += output.length();
+    output.drain(output.length());
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompiledJsonAccessLogFormatter(benchmark::State& state) {
+  compiledJsonAccessLogFormatter(state, false);
+}
+BENCHMARK(BM_CompiledJsonAccessLogFormatter);
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompiledTypedJsonAccessLogFormatter(benchmark::State& state) {
+  compiledJsonAccessLogFormatter(state, true);
+}
+BENCHMARK(BM_CompiledTypedJsonAccessLogFormatter);
+
 } // namespace Envoy
@@ -0,0 +1,96 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Compares the cost of running decoder filter callbacks directly, as for streams that are not
+// sampled, with the cost of running them through TimedStreamFilter, as for sampled streams.
+
+#include <memory>
+#include <vector>
+
+#include "envoy/config/core/v3/base.pb.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/http/filter_timing.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+class NoopDecoderFilter : public StreamDecoderFilter {
+public:
+  // Http::StreamFilterBase
+  void onDestroy() override {}
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(RequestHeaderMap&, bool) override {
+    return FilterHeadersStatus::Continue;
+  }
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(RequestTrailerMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks&) override {}
+};
+
+class CollectingCallbacks : public FilterChainFactoryCallbacks {
+public:
+  void addStreamDecoderFilter(StreamDecoderFilterSharedPtr filter) override {
+    filters_.push_back(std::move(filter));
+  }
+  void addStreamEncoderFilter(StreamEncoderFilterSharedPtr) override {}
+  void addStreamFilter(StreamFilterSharedPtr filter) override { filters_.push_back(filter); }
+  void addAccessLogHandler(AccessLog::InstanceSharedPtr) override {}
+
+  std::vector<StreamDecoderFilterSharedPtr> filters_;
+};
+
+void runFilters(benchmark::State& state, bool timed) {
+  Stats::IsolatedStoreImpl store;
+  testing::NiceMock<Runtime::MockLoader> runtime;
+  RealTimeSource time_source;
+  FilterTimingConfig config(envoy::config::core::v3::RuntimeFractionalPercent(), "http.bench.",
+                            store, runtime, time_source);
+  config.registerFilter("noop");
+
+  CollectingCallbacks callbacks;
+  TimedFilterChainFactoryCallbacks timed_callbacks(callbacks, time_source);
+  timed_callbacks.setFilterStats(config.statsForFilter("noop"));
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    auto filter = std::make_shared<NoopDecoderFilter>();
+    if (timed) {
+      timed_callbacks.addStreamDecoderFilter(filter);
+    } else {
+      callbacks.addStreamDecoderFilter(filter);
+    }
+  }
+
+  TestRequestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}};
+  Buffer::OwnedImpl data("hello");
+  for (auto _ : state) { // NOLINT
+    for (const auto& filter : callbacks.filters_) {
+      benchmark::DoNotOptimize(filter->decodeHeaders(headers, false));
+      benchmark::DoNotOptimize(filter->decodeData(data, true));
+    }
+  }
+}
+
+// Filter callbacks of streams that are not sampled.
+void bmUntimedFilters(benchmark::State& state) { runFilters(state, false); }
+BENCHMARK(bmUntimedFilters)->Arg(1)->Arg(10);
+
+// Filter callbacks of sampled streams.
+void bmTimedFilters(benchmark::State& state) { runFilters(state, true); }
+BENCHMARK(bmTimedFilters)->Arg(1)->Arg(10);
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
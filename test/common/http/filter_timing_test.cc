@@ -0,0 +1,182 @@
+#include <chrono>
+#include <memory>
+
+#include "envoy/config/core/v3/base.pb.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter_timing.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/stats/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Property;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+class FilterTimingTest : public testing::Test {
+public:
+  FilterTimingTest() {
+    envoy::config::core::v3::RuntimeFractionalPercent sampling;
+    sampling.set_runtime_key("filter_timing.sampling");
+    sampling.mutable_default_value()->set_numerator(25);
+    config_ = std::make_unique<FilterTimingConfig>(sampling, "http.test.", stats_, runtime_,
+                                                   time_system_);
+    config_->registerFilter("envoy.filters.http.foo");
+  }
+
+  void expectHistogram(const std::string& name, testing::Matcher<uint64_t> value) {
+    EXPECT_CALL(stats_, deliverHistogramToSinks(Property(&Stats::Metric::name, name), value));
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<Stats::MockIsolatedStatsStore> stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  std::unique_ptr<FilterTimingConfig> config_;
+};
+
+// Streams are sampled according to the configured runtime fractional percent.
+TEST_F(FilterTimingTest, Sampling) {
+  EXPECT_CALL(runtime_.snapshot_,
+              featureEnabled("filter_timing.sampling",
+                             testing::Matcher<const envoy::type::v3::FractionalPercent&>(_)))
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+  EXPECT_TRUE(config_->sampleStream());
+  EXPECT_FALSE(config_->sampleStream());
+}
+
+// Registering a filter twice keeps the same stats.
+TEST_F(FilterTimingTest, RegisterFilter) {
+  const FilterTimingStats& stats = config_->statsForFilter("envoy.filters.http.foo");
+  config_->registerFilter("envoy.filters.http.foo");
+  EXPECT_EQ(&stats, &config_->statsForFilter("envoy.filters.http.foo"));
+  EXPECT_EQ("http.test.filter_timing.envoy.filters.http.foo.decode_wall_us",
+            stats.decode_wall_us_.name());
+  EXPECT_EQ(Stats::Histogram::Unit::Microseconds, stats.decode_wall_us_.unit());
+}
+
+// A decoder filter is wrapped, its callbacks are forwarded and timed in the decode histograms.
+TEST_F(FilterTimingTest, DecoderFilter) {
+  NiceMock<MockFilterChainFactoryCallbacks> parent;
+  TimedFilterChainFactoryCallbacks callbacks(parent, time_system_);
+  callbacks.setFilterStats(config_->statsForFilter("envoy.filters.http.foo"));
+
+  auto filter = std::make_shared<MockStreamDecoderFilter>();
+  StreamDecoderFilterSharedPtr timed_filter;
+  EXPECT_CALL(parent, addStreamDecoderFilter(_)).WillOnce(SaveArg<0>(&timed_filter));
+  callbacks.addStreamDecoderFilter(filter);
+  ASSERT_NE(nullptr, timed_filter);
+  EXPECT_NE(filter, timed_filter);
+
+  NiceMock<MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  EXPECT_CALL(*filter, setDecoderFilterCallbacks(_));
+  timed_filter->setDecoderFilterCallbacks(decoder_callbacks);
+
+  TestRequestHeaderMapImpl headers;
+  EXPECT_CALL(*filter, decodeHeaders(_, false)).WillOnce(Invoke([&](RequestHeaderMap&, bool) {
+    time_system_.advanceTimeWait(std::chrono::milliseconds(5));
+    return FilterHeadersStatus::StopIteration;
+  }));
+  expectHistogram("http.test.filter_timing.envoy.filters.http.foo.decode_wall_us", 5000);
+  expectHistogram("http.test.filter_timing.envoy.filters.http.foo.decode_cpu_us", _);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, timed_filter->decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(*filter, decodeData(_, false)).WillOnce(Return(FilterDataStatus::Continue));
+  EXPECT_CALL(*filter, decodeMetadata(_)).WillOnce(Return(FilterMetadataStatus::Continue));
+  TestRequestTrailerMapImpl trailers;
+  EXPECT_CALL(*filter, decodeTrailers(_)).WillOnce(Return(FilterTrailersStatus::Continue));
+  EXPECT_CALL(*filter, decodeComplete());
+  EXPECT_CALL(stats_, deliverHistogramToSinks(_, _)).Times(6);
+  EXPECT_EQ(FilterDataStatus::Continue, timed_filter->decodeData(data, false));
+  MetadataMap metadata_map;
+  EXPECT_EQ(FilterMetadataStatus::Continue, timed_filter->decodeMetadata(metadata_map));
+  EXPECT_EQ(FilterTrailersStatus::Continue, timed_filter->decodeTrailers(trailers));
+  timed_filter->decodeComplete();
+
+  EXPECT_CALL(*filter, onDestroy());
+  timed_filter->onDestroy();
+}
+
+// An encoder filter is timed in the encode histograms.
+TEST_F(FilterTimingTest, EncoderFilter) {
+  NiceMock<MockFilterChainFactoryCallbacks> parent;
+  TimedFilterChainFactoryCallbacks callbacks(parent, time_system_);
+  callbacks.setFilterStats(config_->statsForFilter("envoy.filters.http.foo"));
+
+  auto filter = std::make_shared<MockStreamEncoderFilter>();
+  StreamEncoderFilterSharedPtr timed_filter;
+  EXPECT_CALL(parent, addStreamEncoderFilter(_)).WillOnce(SaveArg<0>(&timed_filter));
+  callbacks.addStreamEncoderFilter(filter);
+  ASSERT_NE(nullptr, timed_filter);
+
+  TestResponseHeaderMapImpl headers;
+  EXPECT_CALL(*filter, encodeHeaders(_, true)).WillOnce(Invoke([&](ResponseHeaderMap&, bool) {
+    time_system_.advanceTimeWait(std::chrono::milliseconds(2));
+    return FilterHeadersStatus::Continue;
+  }));
+  expectHistogram("http.test.filter_timing.envoy.filters.http.foo.encode_wall_us", 2000);
+  expectHistogram("http.test.filter_timing.envoy.filters.http.foo.encode_cpu_us", _);
+  EXPECT_EQ(FilterHeadersStatus::Continue, timed_filter->encodeHeaders(headers, true));
+
+  EXPECT_CALL(*filter, onDestroy());
+  timed_filter->onDestroy();
+}
+
+// A dual filter is added once as a stream filter and destroyed once.
+TEST_F(FilterTimingTest, DualFilter) {
+  NiceMock<MockFilterChainFactoryCallbacks> parent;
+  TimedFilterChainFactoryCallbacks callbacks(parent, time_system_);
+  callbacks.setFilterStats(config_->statsForFilter("envoy.filters.http.foo"));
+
+  auto filter = std::make_shared<NiceMock<MockStreamFilter>>();
+  StreamFilterSharedPtr timed_filter;
+  EXPECT_CALL(parent, addStreamFilter(_)).WillOnce(SaveArg<0>(&timed_filter));
+  callbacks.addStreamFilter(filter);
+  ASSERT_NE(nullptr, timed_filter);
+
+  {
+    InSequence s;
+    EXPECT_CALL(*filter, decodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::Continue));
+    EXPECT_CALL(*filter, encodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::Continue));
+    EXPECT_CALL(*filter, onDestroy());
+  }
+  TestRequestHeaderMapImpl request_headers;
+  TestResponseHeaderMapImpl response_headers;
+  EXPECT_EQ(FilterHeadersStatus::Continue, timed_filter->decodeHeaders(request_headers, true));
+  EXPECT_EQ(FilterHeadersStatus::Continue, timed_filter->encodeHeaders(response_headers, true));
+  timed_filter->onDestroy();
+}
+
+// Access log handlers are passed through unchanged.
+TEST_F(FilterTimingTest, AccessLogHandler) {
+  MockFilterChainFactoryCallbacks parent;
+  TimedFilterChainFactoryCallbacks callbacks(parent, time_system_);
+  AccessLog::InstanceSharedPtr handler = std::make_shared<AccessLog::MockInstance>();
+  EXPECT_CALL(parent, addAccessLogHandler(handler));
+  callbacks.addAccessLogHandler(handler);
+}
+
+TEST(ThreadCpuTimeTest, Monotonic) {
+  const std::chrono::nanoseconds start = threadCpuTime();
+  EXPECT_LE(start, threadCpuTime());
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
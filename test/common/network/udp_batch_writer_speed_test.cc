@@ -0,0 +1,69 @@
+// Loopback packets-per-second comparison of the default (one sendmsg() per datagram) and the
+// batching (sendmmsg()/UDP GSO) UDP packet writers.
+
+#include <string>
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/buffer/buffer_impl.h"
+#include "common/network/udp_batch_writer.h"
+#include "common/network/udp_packet_writer_handler_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/test_common/network_utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Network {
+
+// Drain everything queued on the receiving socket so that the sender never sees a full receive
+// buffer.
+static uint64_t drainReceiver(Socket& receiver) {
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  char buf[MAX_UDP_PACKET_SIZE];
+  uint64_t received = 0;
+  while (os_sys_calls.recv(receiver.ioHandle().fd(), buf, sizeof(buf), 0).rc_ >= 0) {
+    ++received;
+  }
+  return received;
+}
+
+static void sendBatches(benchmark::State& state, bool batched) {
+  const uint64_t datagrams_per_batch = state.range(0);
+  const std::string payload(state.range(1), 'a');
+  auto receiver = Test::bindFreeLoopbackPort(Address::IpVersion::v4, Socket::Type::Datagram);
+  auto sender = Test::bindFreeLoopbackPort(Address::IpVersion::v4, Socket::Type::Datagram);
+  Stats::IsolatedStoreImpl store;
+  UdpPacketWriterPtr writer;
+  if (batched) {
+    writer = std::make_unique<UdpBatchWriter>(sender.second->ioHandle(), store,
+                                              datagrams_per_batch);
+  } else {
+    writer = std::make_unique<UdpDefaultWriter>(sender.second->ioHandle());
+  }
+
+  uint64_t sent = 0;
+  uint64_t received = 0;
+  for (auto _ : state) {
+    for (uint64_t i = 0; i < datagrams_per_batch; ++i) {
+      Buffer::OwnedImpl buffer(payload);
+      if (writer->writePacket(buffer, nullptr, *receiver.first).ok()) {
+        ++sent;
+      }
+    }
+    writer->flush();
+    writer->setWritable();
+    received += drainReceiver(*receiver.second);
+  }
+  state.SetItemsProcessed(sent);
+  state.counters["received"] = received;
+}
+
+static void bmDefaultWriter(benchmark::State& state) { sendBatches(state, false); }
+BENCHMARK(bmDefaultWriter)->Args({16, 64})->Args({16, 1200})->Args({64, 64})->Args({64, 1200});
+
+static void bmBatchWriter(benchmark::State& state) { sendBatches(state, true); }
+BENCHMARK(bmBatchWriter)->Args({16, 64})->Args({16, 1200})->Args({64, 64})->Args({64, 1200});
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,181 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/address_impl.h"
+#include "common/network/udp_batch_writer.h"
+#include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/api/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/threadsafe_singleton_injector.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class UdpBatchWriterTest : public testing::TestWithParam<Address::IpVersion> {
+protected:
+  UdpBatchWriterTest()
+      : peer_(GetParam()),
+        client_(Test::bindFreeLoopbackPort(GetParam(), Socket::Type::Datagram).second) {}
+
+  void SetUp() override {
+    if (!Api::OsSysCallsSingleton::get().supportsMmsg()) {
+      GTEST_SKIP() << "sendmmsg() is not supported on this platform";
+    }
+  }
+
+  Api::IoCallUint64Result write(UdpBatchWriter& writer, const std::string& payload) {
+    Buffer::OwnedImpl buffer(payload);
+    return writer.writePacket(buffer, nullptr, *peer_.localAddress());
+  }
+
+  void expectReceived(const std::vector<std::string>& payloads) {
+    for (const std::string& payload : payloads) {
+      UdpRecvData datagram;
+      peer_.recv(datagram);
+      EXPECT_EQ(payload, datagram.buffer_->toString());
+    }
+  }
+
+  uint64_t counter(const std::string& name) {
+    return TestUtility::findCounter(store_, "udp_batch_writer." + name)->value();
+  }
+
+  Test::UdpSyncPeer peer_;
+  SocketPtr client_;
+  Stats::IsolatedStoreImpl store_;
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, UdpBatchWriterTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                         TestUtility::ipTestParamsToString);
+
+// Datagrams are only handed to the kernel on flush() and arrive in order.
+TEST_P(UdpBatchWriterTest, BuffersUntilFlush) {
+  UdpBatchWriter writer(client_->ioHandle(), store_);
+  EXPECT_TRUE(writer.isBatchMode());
+
+  // Equal sized datagrams followed by a shorter and a longer one exercise both GSO runs (when the
+  // kernel supports it) and run breaks.
+  const std::vector<std::string> payloads{"aaaa", "bbbb", "cccc", "dd", "eeeeeeee", "f"};
+  uint64_t total_bytes = 0;
+  for (const std::string& payload : payloads) {
+    const Api::IoCallUint64Result rc = write(writer, payload);
+    EXPECT_TRUE(rc.ok());
+    EXPECT_EQ(payload.size(), rc.rc_);
+    total_bytes += payload.size();
+  }
+  EXPECT_EQ(payloads.size(), writer.bufferedDatagrams());
+  EXPECT_EQ(0, counter("tx_datagrams"));
+
+  const Api::IoCallUint64Result rc = writer.flush();
+  EXPECT_TRUE(rc.ok());
+  EXPECT_EQ(total_bytes, rc.rc_);
+  EXPECT_EQ(0, writer.bufferedDatagrams());
+  EXPECT_EQ(payloads.size(), counter("tx_datagrams"));
+  EXPECT_EQ(total_bytes, counter("tx_bytes"));
+  EXPECT_EQ(1, counter("tx_syscalls"));
+  expectReceived(payloads);
+
+  // Flushing an empty writer is a no-op.
+  EXPECT_TRUE(writer.flush().ok());
+  EXPECT_EQ(1, counter("tx_syscalls"));
+}
+
+// Reaching the datagram limit flushes the batch before buffering the next datagram.
+TEST_P(UdpBatchWriterTest, FlushesWhenFull) {
+  UdpBatchWriter writer(client_->ioHandle(), store_, 2);
+  EXPECT_TRUE(write(writer, "one").ok());
+  EXPECT_TRUE(write(writer, "two").ok());
+  EXPECT_EQ(2, writer.bufferedDatagrams());
+  EXPECT_TRUE(write(writer, "three").ok());
+  EXPECT_EQ(1, writer.bufferedDatagrams());
+  EXPECT_EQ(2, counter("tx_datagrams"));
+  EXPECT_TRUE(writer.flush().ok());
+  expectReceived({"one", "two", "three"});
+}
+
+// Datagrams larger than the batch buffer bypass it without reordering.
+TEST_P(UdpBatchWriterTest, OversizedDatagram) {
+  UdpBatchWriter writer(client_->ioHandle(), store_, 1);
+  EXPECT_TRUE(write(writer, "small").ok());
+  const std::string large(MAX_UDP_PACKET_SIZE + 1, 'x');
+  const Api::IoCallUint64Result rc = write(writer, large);
+  EXPECT_TRUE(rc.ok());
+  EXPECT_EQ(large.size(), rc.rc_);
+  EXPECT_EQ(0, writer.bufferedDatagrams());
+  expectReceived({"small", large});
+}
+
+// EAGAIN keeps the batch buffered until the socket becomes writable again.
+TEST_P(UdpBatchWriterTest, WriteBlocked) {
+  UdpBatchWriter writer(client_->ioHandle(), store_);
+  EXPECT_TRUE(write(writer, "first").ok());
+
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+  EXPECT_CALL(os_sys_calls, sendmmsg(_, _, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{-1, SOCKET_ERROR_AGAIN}));
+  const Api::IoCallUint64Result rc = writer.flush();
+  EXPECT_FALSE(rc.ok());
+  EXPECT_EQ(Api::IoError::IoErrorCode::Again, rc.err_->getErrorCode());
+  EXPECT_TRUE(writer.isWriteBlocked());
+  EXPECT_EQ(1, writer.bufferedDatagrams());
+
+  // Writes are rejected while blocked.
+  const Api::IoCallUint64Result blocked_rc = write(writer, "dropped");
+  EXPECT_FALSE(blocked_rc.ok());
+  EXPECT_EQ(Api::IoError::IoErrorCode::Again, blocked_rc.err_->getErrorCode());
+
+  writer.setWritable();
+  EXPECT_CALL(os_sys_calls, sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](os_fd_t, struct mmsghdr* msgvec, unsigned int vlen,
+                          int) -> Api::SysCallIntResult {
+        EXPECT_EQ(1, vlen);
+        EXPECT_EQ(5, msgvec[0].msg_hdr.msg_iov[0].iov_len);
+        msgvec[0].msg_len = 5;
+        return {1, 0};
+      }));
+  EXPECT_TRUE(writer.flush().ok());
+  EXPECT_EQ(0, writer.bufferedDatagrams());
+}
+
+// A datagram rejected by the kernel is dropped and the rest of the batch is still sent.
+TEST_P(UdpBatchWriterTest, SendError) {
+  UdpBatchWriter writer(client_->ioHandle(), store_);
+  EXPECT_TRUE(write(writer, "a").ok());
+  EXPECT_TRUE(write(writer, "bb").ok());
+
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+  EXPECT_CALL(os_sys_calls, sendmmsg(_, _, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{-1, EMSGSIZE}))
+      .WillOnce(Invoke([](os_fd_t, struct mmsghdr* msgvec, unsigned int vlen,
+                          int) -> Api::SysCallIntResult {
+        EXPECT_EQ(1, vlen);
+        msgvec[0].msg_len = 2;
+        return {1, 0};
+      }));
+  const Api::IoCallUint64Result rc = writer.flush();
+  EXPECT_FALSE(rc.ok());
+  EXPECT_FALSE(writer.isWriteBlocked());
+  EXPECT_EQ(0, writer.bufferedDatagrams());
+  EXPECT_EQ(1, counter("tx_errors"));
+  EXPECT_EQ(1, counter("tx_datagrams"));
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,263 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "envoy/common/exception.h"
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/profiler/continuous_profiler.h"
+#include "common/protobuf/protobuf.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Profiler {
+
+class ContinuousProfilerPeer {
+public:
+  static void addSample(ContinuousProfiler& profiler, std::vector<uintptr_t> stack) {
+    profiler.addSample(std::move(stack));
+  }
+};
+
+namespace {
+
+std::vector<uint64_t> parsePacked(const std::string& bytes) {
+  Protobuf::io::CodedInputStream stream(reinterpret_cast<const uint8_t*>(bytes.data()),
+                                        bytes.size());
+  std::vector<uint64_t> values;
+  uint64_t value;
+  while (stream.ReadVarint64(&value)) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+// The parts of a pprof profile the tests look at.
+struct ParsedProfile {
+  explicit ParsedProfile(const std::string& bytes) {
+    Protobuf::UnknownFieldSet profile;
+    EXPECT_TRUE(profile.ParseFromString(bytes));
+    for (int i = 0; i < profile.field_count(); ++i) {
+      const Protobuf::UnknownField& field = profile.field(i);
+      switch (field.number()) {
+      case 2: { // sample
+        Protobuf::UnknownFieldSet sample;
+        EXPECT_TRUE(sample.ParseFromString(field.length_delimited()));
+        std::vector<uint64_t> location_ids;
+        std::vector<uint64_t> values;
+        for (int j = 0; j < sample.field_count(); ++j) {
+          if (sample.field(j).number() == 1) {
+            location_ids = parsePacked(sample.field(j).length_delimited());
+          } else if (sample.field(j).number() == 2) {
+            values = parsePacked(sample.field(j).length_delimited());
+          }
+        }
+        EXPECT_EQ(2, values.size());
+        samples_.push_back({location_ids, values});
+        break;
+      }
+      case 4: { // location
+        Protobuf::UnknownFieldSet location;
+        EXPECT_TRUE(location.ParseFromString(field.length_delimited()));
+        uint64_t id = 0;
+        uint64_t address = 0;
+        for (int j = 0; j < location.field_count(); ++j) {
+          if (location.field(j).number() == 1) {
+            id = location.field(j).varint();
+          } else if (location.field(j).number() == 3) {
+            address = location.field(j).varint();
+          }
+        }
+        addresses_[id] = address;
+        break;
+      }
+      case 6: // string_table
+        strings_.push_back(field.length_delimited());
+        break;
+      case 10: // duration_nanos
+        duration_nanos_ = field.varint();
+        break;
+      case 12: // period
+        period_ = field.varint();
+        break;
+      }
+    }
+  }
+
+  // @return the number of samples.
+  uint64_t total() const {
+    uint64_t total = 0;
+    for (const auto& sample : samples_) {
+      total += sample.second[0];
+    }
+    return total;
+  }
+
+  // @return the number of samples whose stack is exactly the supplied addresses.
+  uint64_t count(const std::vector<uint64_t>& stack) const {
+    uint64_t count = 0;
+    for (const auto& sample : samples_) {
+      std::vector<uint64_t> sample_stack;
+      for (const uint64_t location_id : sample.first) {
+        sample_stack.push_back(addresses_.at(location_id));
+      }
+      if (sample_stack == stack) {
+        count += sample.second[0];
+      }
+    }
+    return count;
+  }
+
+  std::vector<std::pair<std::vector<uint64_t>, std::vector<uint64_t>>> samples_;
+  absl::flat_hash_map<uint64_t, uint64_t> addresses_;
+  std::vector<std::string> strings_;
+  uint64_t duration_nanos_{};
+  uint64_t period_{};
+};
+
+class ContinuousProfilerTest : public testing::Test {
+public:
+  ContinuousProfilerTest() { config_.mutable_window_count()->set_value(3); }
+
+  ParsedProfile profile(std::chrono::milliseconds duration) {
+    Buffer::OwnedImpl output;
+    profiler_->writeProfile(duration, output);
+    return ParsedProfile(output.toString());
+  }
+
+  envoy::config::bootstrap::v3::Admin::ContinuousProfiler config_;
+  Event::SimulatedTimeSystem time_system_;
+  testing::NiceMock<Event::MockDispatcher> dispatcher_;
+  ContinuousProfilerPtr profiler_;
+};
+
+// The process CPU time is sampled.
+TEST_F(ContinuousProfilerTest, Sampling) {
+  config_.mutable_frequency_hz()->set_value(1000);
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+  EXPECT_TRUE(ContinuousProfiler::running());
+
+  // Burn CPU until a few samples were taken, draining the buffers as the timer would.
+  ParsedProfile parsed("");
+  const MonotonicTime deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  volatile uint64_t sink = 0;
+  while (parsed.total() < 3 && std::chrono::steady_clock::now() < deadline) {
+    for (uint64_t i = 0; i < 10000000; ++i) {
+      sink = sink + i;
+    }
+    parsed = profile(std::chrono::seconds(10));
+  }
+  ASSERT_GE(parsed.total(), 3);
+  EXPECT_EQ(1000000, parsed.period_);
+  EXPECT_EQ("", parsed.strings_[0]);
+  EXPECT_THAT(parsed.strings_, testing::IsSupersetOf({"samples", "count", "cpu", "nanoseconds"}));
+  for (const auto& sample : parsed.samples_) {
+    EXPECT_FALSE(sample.first.empty());
+    EXPECT_EQ(sample.second[0] * parsed.period_, sample.second[1]);
+  }
+
+  profiler_.reset();
+  EXPECT_FALSE(ContinuousProfiler::running());
+}
+
+// Samples older than the requested duration, or than all the windows, are left out.
+TEST_F(ContinuousProfilerTest, Windows) {
+  // Real samples never have these stacks, a low frequency just keeps them few.
+  config_.mutable_frequency_hz()->set_value(1);
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+  EXPECT_EQ(std::chrono::seconds(30), profiler_->maxDuration());
+
+  ContinuousProfilerPeer::addSample(*profiler_, {1, 2});
+  ContinuousProfilerPeer::addSample(*profiler_, {1, 2});
+  time_system_.advanceTimeWait(std::chrono::seconds(10));
+  profiler_->collectSamples();
+  ContinuousProfilerPeer::addSample(*profiler_, {1, 2});
+  ContinuousProfilerPeer::addSample(*profiler_, {1, 3});
+  time_system_.advanceTimeWait(std::chrono::seconds(5));
+
+  // Durations are rounded up to whole windows.
+  ParsedProfile last_window = profile(std::chrono::seconds(1));
+  EXPECT_EQ(1, last_window.count({1, 2}));
+  EXPECT_EQ(1, last_window.count({1, 3}));
+  EXPECT_EQ(5000000000, last_window.duration_nanos_);
+  ParsedProfile all_windows = profile(std::chrono::seconds(60));
+  EXPECT_EQ(3, all_windows.count({1, 2}));
+  EXPECT_EQ(1, all_windows.count({1, 3}));
+  EXPECT_EQ(15000000000, all_windows.duration_nanos_);
+
+  // The first window is dropped once three newer ones exist.
+  time_system_.advanceTimeWait(std::chrono::seconds(20));
+  EXPECT_EQ(1, profile(std::chrono::seconds(60)).count({1, 2}));
+
+  // Nothing is left after all windows expired.
+  time_system_.advanceTimeWait(std::chrono::seconds(60));
+  ParsedProfile expired = profile(std::chrono::seconds(60));
+  EXPECT_EQ(0, expired.count({1, 2}));
+  EXPECT_EQ(0, expired.count({1, 3}));
+}
+
+// The buffers are drained often enough for the configured frequency.
+TEST_F(ContinuousProfilerTest, CollectInterval) {
+  auto* timer = new testing::NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000), testing::_));
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+  profiler_.reset();
+
+  config_.mutable_frequency_hz()->set_value(1000);
+  timer = new testing::NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(32), testing::_)).Times(2);
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+  timer->invokeCallback();
+}
+
+#ifdef __linux__
+// The buffer of a thread is freed for other threads once the thread exited.
+TEST_F(ContinuousProfilerTest, ThreadBufferReclaimed) {
+  config_.mutable_frequency_hz()->set_value(1000);
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+
+  // Burns CPU until the calling thread was sampled, which shows as one more buffer in use.
+  const auto burn_until_sampled = [](uint32_t in_use) {
+    const MonotonicTime deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    volatile uint64_t sink = 0;
+    while (ContinuousProfiler::threadBuffersInUse() <= in_use &&
+           std::chrono::steady_clock::now() < deadline) {
+      for (uint64_t i = 0; i < 1000000; ++i) {
+        sink = sink + i;
+      }
+    }
+  };
+  if (ContinuousProfiler::threadBuffersInUse() == 0) {
+    burn_until_sampled(0);
+  }
+  const uint32_t in_use = ContinuousProfiler::threadBuffersInUse();
+  ASSERT_GE(in_use, 1);
+
+  std::thread thread([&burn_until_sampled, in_use]() { burn_until_sampled(in_use); });
+  thread.join();
+  ASSERT_EQ(in_use + 1, ContinuousProfiler::threadBuffersInUse());
+  profiler_->collectSamples();
+  EXPECT_EQ(in_use, ContinuousProfiler::threadBuffersInUse());
+}
+#endif
+
+// SIGPROF can only be used by one profiler at a time.
+TEST_F(ContinuousProfilerTest, AlreadyRunning) {
+  profiler_ = std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_);
+  EXPECT_THROW_WITH_MESSAGE(
+      std::make_unique<ContinuousProfiler>(config_, dispatcher_, time_system_), EnvoyException,
+      "a continuous profiler is already running");
+  EXPECT_TRUE(ContinuousProfiler::running());
+}
+
+} // namespace
+} // namespace Profiler
+} // namespace Envoy
@@ -1428,6 +1428,24 @@ TEST(DurationUtilTest, OutOfRange) {
   }
 }
 
+// The first messages are allocated in the block of the caller, whose memory is reused once the
+// arena is reset.
+TEST(ArenaUtilTest, InitialBlock) {
+  std::vector<char> initial_block(4096);
+  Protobuf::Arena arena(ArenaUtil::options(initial_block, 8192));
+  const auto in_initial_block = [&initial_block](const void* message) {
+    const char* address = static_cast<const char*>(message);
+    return address >= initial_block.data() &&
+           address < initial_block.data() + initial_block.size();
+  };
+
+  auto* value = Protobuf::Arena::CreateMessage<ProtobufWkt::StringValue>(&arena);
+  EXPECT_TRUE(in_initial_block(value));
+  arena.Reset();
+  value = Protobuf::Arena::CreateMessage<ProtobufWkt::StringValue>(&arena);
+  EXPECT_TRUE(in_initial_block(value));
+}
+
 class DeprecatedFieldsTest : public testing::TestWithParam<bool> {
 protected:
   DeprecatedFieldsTest()
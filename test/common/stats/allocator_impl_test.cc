@@ -6,7 +6,10 @@
 #include "test/test_common/logging.h"
 #include "test/test_common/thread_factory_for_test.h"
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -128,6 +131,187 @@ TEST_F(AllocatorImplTest, RefCountDecAllocRaceSynchronized) {
   EXPECT_FALSE(alloc_.isMutexLockedForTest());
 }
 
+TEST_F(AllocatorImplTest, ChangedStats) {
+  CounterSharedPtr c1 = alloc_.makeCounter(makeStat("c1"), StatName(), {});
+  CounterSharedPtr c2 = alloc_.makeCounter(makeStat("c2"), StatName(), {});
+  GaugeSharedPtr g1 =
+      alloc_.makeGauge(makeStat("g1"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  GaugeSharedPtr g2 =
+      alloc_.makeGauge(makeStat("g2"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  c1->inc();
+
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  auto collect = [&]() {
+    counters.clear();
+    gauges.clear();
+    alloc_.collectChangedStats(counters, gauges);
+  };
+
+  // The stats which changed before the tracking started are not known, so all are collected.
+  alloc_.trackChangedStats();
+  collect();
+  EXPECT_EQ(2U, counters.size());
+  EXPECT_EQ(2U, gauges.size());
+  collect();
+  EXPECT_TRUE(counters.empty());
+  EXPECT_TRUE(gauges.empty());
+
+  c2->add(2);
+  c2->inc();
+  g1->set(5);
+  g2->inc();
+  g2->dec();
+  collect();
+  ASSERT_EQ(1U, counters.size());
+  EXPECT_EQ(c2.get(), counters[0].get());
+  EXPECT_EQ(2U, gauges.size());
+
+  // Tracking again doesn't collect all the stats again.
+  alloc_.trackChangedStats();
+  c1->reset();
+  g1->sub(5);
+  collect();
+  ASSERT_EQ(1U, counters.size());
+  EXPECT_EQ(c1.get(), counters[0].get());
+  ASSERT_EQ(1U, gauges.size());
+  EXPECT_EQ(g1.get(), gauges[0].get());
+}
+
+// A changed stat which is freed before the collection is not collected, while the stats which
+// changed before and after it still are.
+TEST_F(AllocatorImplTest, ChangedStatFreed) {
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter"), StatName(), {});
+  CounterSharedPtr before = alloc_.makeCounter(makeStat("before"), StatName(), {});
+  CounterSharedPtr after = alloc_.makeCounter(makeStat("after"), StatName(), {});
+  GaugeSharedPtr gauge =
+      alloc_.makeGauge(makeStat("gauge"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  alloc_.trackChangedStats();
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  alloc_.collectChangedStats(counters, gauges);
+  counters.clear();
+  gauges.clear();
+
+  before->inc();
+  counter->inc();
+  gauge->inc();
+  counter.reset();
+  gauge.reset();
+  after->inc();
+  alloc_.collectChangedStats(counters, gauges);
+  ASSERT_EQ(2U, counters.size());
+  EXPECT_THAT(counters, testing::UnorderedElementsAre(before, after));
+  EXPECT_TRUE(gauges.empty());
+
+  // The freed counter doesn't leave the others marked.
+  counters.clear();
+  alloc_.collectChangedStats(counters, gauges);
+  EXPECT_TRUE(counters.empty());
+  before->inc();
+  alloc_.collectChangedStats(counters, gauges);
+  ASSERT_EQ(1U, counters.size());
+  EXPECT_EQ(before, counters[0]);
+}
+
+// A gauge whose import mode is set after it changed is marked changed again, as the store doesn't
+// collect the gauges whose import mode is uninitialized.
+TEST_F(AllocatorImplTest, ChangedGaugeImportModeSet) {
+  GaugeSharedPtr gauge =
+      alloc_.makeGauge(makeStat("gauge"), StatName(), {}, Gauge::ImportMode::Uninitialized);
+  alloc_.trackChangedStats();
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  alloc_.collectChangedStats(counters, gauges);
+  gauges.clear();
+
+  gauge->setParentValue(5);
+  alloc_.collectChangedStats(counters, gauges);
+  ASSERT_EQ(1U, gauges.size());
+  EXPECT_EQ(Gauge::ImportMode::Uninitialized, gauges[0]->importMode());
+  gauges.clear();
+
+  gauge->mergeImportMode(Gauge::ImportMode::Accumulate);
+  alloc_.collectChangedStats(counters, gauges);
+  ASSERT_EQ(1U, gauges.size());
+  EXPECT_EQ(Gauge::ImportMode::Accumulate, gauges[0]->importMode());
+  EXPECT_EQ(5, gauges[0]->value());
+}
+
+// Updates from several threads mark a stat changed once per collection.
+TEST_F(AllocatorImplTest, ChangedStatsThreads) {
+  alloc_.trackChangedStats();
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  alloc_.collectChangedStats(counters, gauges);
+
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter"), StatName(), {});
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+  std::vector<Thread::ThreadPtr> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.push_back(thread_factory.createThread([&counter]() {
+      for (int j = 0; j < 1000; ++j) {
+        counter->inc();
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  alloc_.collectChangedStats(counters, gauges);
+  ASSERT_EQ(1U, counters.size());
+  EXPECT_EQ(4000, counters[0]->value());
+  counters.clear();
+  alloc_.collectChangedStats(counters, gauges);
+  EXPECT_TRUE(counters.empty());
+}
+
+// More stats than fit in a segment of the changed logs change at once, from several threads.
+TEST_F(AllocatorImplTest, ChangedStatsManySegments) {
+  std::vector<CounterSharedPtr> all_counters;
+  for (int i = 0; i < 3000; ++i) {
+    all_counters.push_back(alloc_.makeCounter(makeStat(absl::StrCat("c", i)), StatName(), {}));
+  }
+  alloc_.trackChangedStats();
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  alloc_.collectChangedStats(counters, gauges);
+
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+  // The drained segments are reused by the second round.
+  for (int round = 0; round < 2; ++round) {
+    std::vector<Thread::ThreadPtr> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.push_back(thread_factory.createThread([&all_counters]() {
+        for (CounterSharedPtr& counter : all_counters) {
+          counter->inc();
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+    counters.clear();
+    alloc_.collectChangedStats(counters, gauges);
+    absl::flat_hash_set<Counter*> distinct_counters;
+    for (const CounterSharedPtr& counter : counters) {
+      distinct_counters.insert(counter.get());
+    }
+    EXPECT_EQ(3000U, counters.size());
+    EXPECT_EQ(3000U, distinct_counters.size());
+  }
+
+  // Freeing changed stats drains the logs, and leaves the other changed stats in them.
+  for (CounterSharedPtr& counter : all_counters) {
+    counter->inc();
+  }
+  counters.clear();
+  all_counters.resize(1000);
+  alloc_.collectChangedStats(counters, gauges);
+  EXPECT_EQ(1000U, counters.size());
+}
+
 } // namespace
 } // namespace Stats
 } // namespace Envoy
@@ -0,0 +1,99 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/protobuf/protobuf.h"
+#include "common/stats/isolated_store_impl.h"
+#include "common/stats/stat_merger.h"
+#include "common/stats/stats_snapshot.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "test/common/stats/stat_test_utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Stats {
+
+// The stats of a hot restart parent, as the counter deltas and gauges it sends to the child.
+class StatMergerPerf {
+public:
+  explicit StatMergerPerf(int num_clusters) : pool_(parent_symbol_table_) {
+    StatsSnapshot::Builder builder(parent_symbol_table_);
+    uint64_t value = 0;
+    TestUtil::forEachSampleStat(num_clusters, [this, &builder, &value](absl::string_view name) {
+      ++value;
+      const StatName stat_name = pool_.add(name);
+      if (value % 2 == 0) {
+        counter_deltas_[std::string(name)] = value;
+        builder.addCounter(stat_name, value);
+      } else {
+        gauges_[std::string(name)] = value;
+        builder.addGauge(stat_name, value);
+      }
+    });
+    snapshot_.resize(builder.size() / sizeof(uint64_t));
+    builder.write(reinterpret_cast<uint8_t*>(snapshot_.data()));
+  }
+
+  uint64_t numStats() const { return counter_deltas_.size() + gauges_.size(); }
+
+  // Merges the stats as parsed from HotRestartMessage maps.
+  void mergeMaps(StatMerger& stat_merger) { stat_merger.mergeStats(counter_deltas_, gauges_); }
+
+  // Merges the stats from shared memory.
+  void mergeSnapshot(StatMerger& stat_merger) {
+    const StatsSnapshot snapshot(absl::MakeConstSpan(
+        reinterpret_cast<const uint8_t*>(snapshot_.data()), snapshot_.size() * sizeof(uint64_t)));
+    stat_merger.mergeSnapshot(snapshot);
+  }
+
+private:
+  SymbolTableImpl parent_symbol_table_;
+  StatNamePool pool_;
+  Protobuf::Map<std::string, uint64_t> counter_deltas_;
+  Protobuf::Map<std::string, uint64_t> gauges_;
+  std::vector<uint64_t> snapshot_;
+};
+
+// Runs a merge into a fresh child store per iteration, as on the first merge after a hot restart.
+void runMerges(benchmark::State& state, bool snapshot) {
+  StatMergerPerf context(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto child_symbol_table = std::make_unique<SymbolTableImpl>();
+    auto child_store = std::make_unique<IsolatedStoreImpl>(*child_symbol_table);
+    auto stat_merger = std::make_unique<StatMerger>(*child_store);
+    state.ResumeTiming();
+
+    if (snapshot) {
+      context.mergeSnapshot(*stat_merger);
+    } else {
+      context.mergeMaps(*stat_merger);
+    }
+
+    state.PauseTiming();
+    stat_merger.reset();
+    child_store.reset();
+    child_symbol_table.reset();
+    state.ResumeTiming();
+  }
+  state.counters["stats"] = context.numStats();
+}
+
+} // namespace Stats
+} // namespace Envoy
+
+// Tests merging counter deltas and gauges from string keyed maps. The argument is the number of
+// clusters, each of which has about 80 stats.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_MergeMaps(benchmark::State& state) { Envoy::Stats::runMerges(state, false); }
+BENCHMARK(BM_MergeMaps)->Arg(10)->Arg(100)->Arg(1000);
+
+// Tests merging the same stats from a snapshot.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_MergeSnapshot(benchmark::State& state) { Envoy::Stats::runMerges(state, true); }
+BENCHMARK(BM_MergeSnapshot)->Arg(10)->Arg(100)->Arg(1000);
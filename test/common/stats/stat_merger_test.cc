@@ -2,6 +2,7 @@
 
 #include "common/stats/isolated_store_impl.h"
 #include "common/stats/stat_merger.h"
+#include "common/stats/stats_snapshot.h"
 #include "common/stats/symbol_table_creator.h"
 #include "common/stats/thread_local_store.h"
 
@@ -14,6 +15,18 @@ namespace Envoy {
 namespace Stats {
 namespace {
 
+// Writes the snapshot of a builder into 8 byte aligned storage.
+std::vector<uint64_t> writeSnapshot(const StatsSnapshot::Builder& builder) {
+  std::vector<uint64_t> storage(builder.size() / sizeof(uint64_t));
+  builder.write(reinterpret_cast<uint8_t*>(storage.data()));
+  return storage;
+}
+
+StatsSnapshot viewSnapshot(const std::vector<uint64_t>& storage) {
+  return StatsSnapshot(absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(storage.data()),
+                                           storage.size() * sizeof(uint64_t)));
+}
+
 class StatMergerTest : public testing::Test {
 public:
   StatMergerTest()
@@ -210,6 +223,66 @@ TEST_F(StatMergerTest, GaugeMergeImportMode) {
   mergeTest("s2.version", Gauge::ImportMode::Uninitialized, Gauge::ImportMode::NeverImport);
 }
 
+// A snapshot is merged like the equivalent maps.
+TEST_F(StatMergerTest, SnapshotMerge) {
+  store_.counterFromString("draculaer").inc();
+  store_.gaugeFromString("neverimport", Gauge::ImportMode::NeverImport).set(3);
+
+  StatNamePool pool(store_.symbolTable());
+  StatsSnapshot::Builder builder(store_.symbolTable());
+  builder.addCounter(pool.add("draculaer"), 2);
+  builder.addCounter(pool.add("cluster.a.upstream_rq"), 3);
+  builder.addCounter(pool.add("cluster.b.upstream_rq"), 4);
+  builder.addGauge(pool.add("whywassixafraidofseven"), 111);
+  builder.addGauge(pool.add("cluster.a.membership_total"), 7);
+  builder.addGauge(pool.add("neverimport"), 100);
+  builder.addCounter(pool.add("empty..segment"), 5);
+  const std::vector<uint64_t> storage = writeSnapshot(builder);
+  const StatsSnapshot snapshot = viewSnapshot(storage);
+  ASSERT_TRUE(snapshot.valid());
+  // "cluster", "a" and "upstream_rq" are stored once.
+  EXPECT_EQ(11, snapshot.numTokens());
+
+  stat_merger_.mergeSnapshot(snapshot);
+  EXPECT_EQ(3, store_.counterFromString("draculaer").value());
+  EXPECT_EQ(3, store_.counterFromString("cluster.a.upstream_rq").value());
+  EXPECT_EQ(4, store_.counterFromString("cluster.b.upstream_rq").value());
+  EXPECT_EQ(789, whywassixafraidofseven_.value());
+  EXPECT_EQ(7, store_.gaugeFromString("cluster.a.membership_total", Gauge::ImportMode::Accumulate)
+                   .value());
+  EXPECT_EQ(3, store_.gaugeFromString("neverimport", Gauge::ImportMode::NeverImport).value());
+  EXPECT_EQ(5, store_.counterFromString("empty..segment").value());
+}
+
+// Malformed snapshots are rejected rather than read out of bounds.
+TEST_F(StatMergerTest, SnapshotValidation) {
+  StatNamePool pool(store_.symbolTable());
+  StatsSnapshot::Builder builder(store_.symbolTable());
+  builder.addCounter(pool.add("a.b"), 1);
+  std::vector<uint64_t> storage = writeSnapshot(builder);
+  EXPECT_TRUE(viewSnapshot(storage).valid());
+
+  // Truncated.
+  const auto* bytes = reinterpret_cast<const uint8_t*>(storage.data());
+  EXPECT_FALSE(StatsSnapshot(absl::MakeConstSpan(bytes, storage.size() * sizeof(uint64_t) - 8))
+                   .valid());
+  EXPECT_FALSE(StatsSnapshot(absl::MakeConstSpan(bytes, 4)).valid());
+  // Misaligned.
+  EXPECT_FALSE(StatsSnapshot(absl::MakeConstSpan(bytes + 1, 16)).valid());
+  // Wrong version.
+  std::vector<uint64_t> bad_magic = storage;
+  bad_magic[0] = StatsSnapshot::Magic + 1;
+  EXPECT_FALSE(viewSnapshot(bad_magic).valid());
+  // The words are the header (0-2), the record (3-4), the token references (5), the token ends
+  // (6) and the characters (7). Only the record value and the characters may be anything.
+  ASSERT_EQ(8, storage.size());
+  for (size_t i = 1; i < storage.size(); ++i) {
+    std::vector<uint64_t> corrupted = storage;
+    corrupted[i] = ~uint64_t(0);
+    EXPECT_EQ(i == 3 || i == 7, viewSnapshot(corrupted).valid()) << i;
+  }
+}
+
 class StatMergerDynamicTest : public testing::Test {
 public:
   void init(SymbolTablePtr&& symbol_table) { symbol_table_ = std::move(symbol_table); }
@@ -267,10 +340,29 @@ public:
     StatName decoded = dynamic_context.makeDynamicStatName(name, dynamic_map);
     EXPECT_EQ(name, symbol_table_->toString(decoded)) << "input=" << input_descriptor;
     EXPECT_TRUE(stat_name == decoded) << "input=" << input_descriptor << ", name=" << name;
+    snapshotMergeTest(stat_name, input_descriptor);
 
     return size;
   }
 
+  // Checks that merging a snapshot recreates the same StatName, dynamic spans included.
+  void snapshotMergeTest(StatName stat_name, absl::string_view input_descriptor) {
+    StatsSnapshot::Builder builder(*symbol_table_);
+    builder.addCounter(stat_name, 5);
+    const std::vector<uint64_t> storage = writeSnapshot(builder);
+    const StatsSnapshot snapshot = viewSnapshot(storage);
+    ASSERT_TRUE(snapshot.valid()) << "input=" << input_descriptor;
+
+    IsolatedStoreImpl store(*symbol_table_);
+    {
+      StatMerger stat_merger(store);
+      stat_merger.mergeSnapshot(snapshot);
+    }
+    ASSERT_EQ(1, store.counters().size()) << "input=" << input_descriptor;
+    EXPECT_TRUE(stat_name == store.counters()[0]->statName()) << "input=" << input_descriptor;
+    EXPECT_EQ(5, store.counters()[0]->value()) << "input=" << input_descriptor;
+  }
+
   SymbolTablePtr symbol_table_;
 };
 
@@ -12,6 +12,7 @@
 #include "test/common/stats/make_elements_helper.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "benchmark/benchmark.h"
 
@@ -58,6 +59,63 @@ static void BM_CreateRace(benchmark::State& state) {
 }
 BENCHMARK(BM_CreateRace);
 
+// Shared by all threads of the BM_EncodeParallel* benchmarks. Created and destroyed by thread 0;
+// the benchmark library synchronizes all threads before and after the timed loop.
+static Envoy::Stats::SymbolTableImpl* parallel_table = nullptr;
+static std::vector<Envoy::Stats::StatNameStorage>* parallel_pinned = nullptr;
+
+static std::vector<std::string> makeParallelStatNames(absl::string_view scope, int count) {
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    names.push_back(absl::StrCat("cluster.upstream_", i % 8, ".grpc.", scope, ".method_", i,
+                                 ".success"));
+  }
+  return names;
+}
+
+// Each iteration encodes and frees one stat name per thread, modeling workers that create
+// per-request dynamic stats. When existing is true every name is pinned up front, so all
+// encodes find their tokens in the table. Otherwise each thread's method tokens are unique to it
+// and are inserted and erased on every iteration.
+static void encodeParallel(benchmark::State& state, bool existing) {
+  constexpr int num_names = 64;
+  if (state.thread_index == 0) {
+    parallel_table = new Envoy::Stats::SymbolTableImpl;
+    parallel_pinned = new std::vector<Envoy::Stats::StatNameStorage>;
+    if (existing) {
+      for (const std::string& name : makeParallelStatNames("shared", num_names)) {
+        parallel_pinned->emplace_back(name, *parallel_table);
+      }
+    }
+  }
+  const std::vector<std::string> names = makeParallelStatNames(
+      existing ? "shared" : absl::StrCat("thread_", state.thread_index), num_names);
+
+  size_t index = 0;
+  for (auto _ : state) {
+    Envoy::Stats::StatNameStorage storage(names[index++ % num_names], *parallel_table);
+    storage.free(*parallel_table);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index == 0) {
+    for (Envoy::Stats::StatNameStorage& storage : *parallel_pinned) {
+      storage.free(*parallel_table);
+    }
+    delete parallel_pinned;
+    delete parallel_table;
+  }
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_EncodeParallelExisting(benchmark::State& state) { encodeParallel(state, true); }
+BENCHMARK(BM_EncodeParallelExisting)->ThreadRange(1, 16)->UseRealTime();
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_EncodeParallelNew(benchmark::State& state) { encodeParallel(state, false); }
+BENCHMARK(BM_EncodeParallelNew)->ThreadRange(1, 16)->UseRealTime();
+
 // NOLINTNEXTLINE(readability-identifier-naming)
 static void BM_JoinStatNames(benchmark::State& state) {
   Envoy::Stats::SymbolTableImpl symbol_table;
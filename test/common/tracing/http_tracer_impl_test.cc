@@ -725,11 +725,56 @@ TEST_F(HttpConnManFinalizerImplTest, GrpcTrailersOnly) {
                                             &response_trailers, stream_info, config);
 }
 
+// The tags of a span which is not recording are not even computed.
+TEST_F(HttpConnManFinalizerImplTest, SpanNotRecording) {
+  Http::TestRequestHeaderMapImpl request_headers{{":path", "/test"}, {"x-request-id", "id"}};
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+
+  EXPECT_CALL(span, isRecording()).WillRepeatedly(Return(false));
+  EXPECT_CALL(span, setTag(_, _)).Times(0);
+  EXPECT_CALL(span, log(_, _)).Times(0);
+  EXPECT_CALL(stream_info, bytesReceived()).Times(0);
+  EXPECT_CALL(stream_info, responseCode()).Times(0);
+  EXPECT_CALL(span, finishSpan()).Times(2);
+
+  HttpTracerUtility::finalizeDownstreamSpan(span, &request_headers, &response_headers, nullptr,
+                                            stream_info, config);
+  HttpTracerUtility::finalizeUpstreamSpan(span, &response_headers, nullptr, stream_info, config);
+}
+
 TEST(HttpTracerUtilityTest, operationTypeToString) {
   EXPECT_EQ("ingress", HttpTracerUtility::toString(OperationName::Ingress));
   EXPECT_EQ("egress", HttpTracerUtility::toString(OperationName::Egress));
 }
 
+TEST(PropagationSpanTest, NotRecording) {
+  class TestPropagationSpan : public PropagationSpan {
+  public:
+    void injectContext(Http::RequestHeaderMap& request_headers) override {
+      request_headers.addCopy(Http::LowerCaseString("x-trace"), "1");
+    }
+    SpanPtr spawnChild(const Config&, const std::string&, SystemTime) override {
+      return std::make_unique<TestPropagationSpan>();
+    }
+    void setSampled(bool) override {}
+  };
+
+  MockConfig config;
+  Http::TestRequestHeaderMapImpl request_headers;
+  TestPropagationSpan span;
+  EXPECT_FALSE(span.isRecording());
+  span.setOperation("foo");
+  span.setTag("foo", "bar");
+  span.log(SystemTime(), "event");
+  span.setBaggage("key", "value");
+  EXPECT_EQ("", span.getBaggage("key"));
+  span.injectContext(request_headers);
+  EXPECT_EQ("1", request_headers.get_("x-trace"));
+  span.finishSpan();
+
+  EXPECT_FALSE(span.spawnChild(config, "foo", SystemTime())->isRecording());
+}
+
 TEST(HttpNullTracerTest, BasicFunctionality) {
   HttpNullTracer null_tracer;
   MockConfig config;
@@ -794,6 +839,19 @@ TEST_F(HttpTracerImplTest, BasicFunctionalityNodeSet) {
   tracer_->startSpan(config_, request_headers_, stream_info_, {Reason::Sampling, true});
 }
 
+TEST_F(HttpTracerImplTest, NodeNotSetOnSpanNotRecording) {
+  EXPECT_CALL(stream_info_, startTime());
+  EXPECT_CALL(config_, operationName()).Times(2);
+
+  NiceMock<MockSpan>* span = new NiceMock<MockSpan>();
+  EXPECT_CALL(*driver_, startSpan_(_, _, "ingress", stream_info_.start_time_, _))
+      .WillOnce(Return(span));
+  EXPECT_CALL(*span, isRecording()).WillRepeatedly(Return(false));
+  EXPECT_CALL(*span, setTag(_, _)).Times(0);
+
+  tracer_->startSpan(config_, request_headers_, stream_info_, {Reason::Sampling, false});
+}
+
 } // namespace
 } // namespace Tracing
 } // namespace Envoy
@@ -0,0 +1,106 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures logging HTTP access log entries through a gRPC access logger, including the batching
+// and the serialization of the batches, with entries built in place in the batch or built apart
+// and moved in.
+
+#include <memory>
+#include <string>
+
+#include "envoy/config/core/v3/grpc_service.pb.h"
+#include "envoy/data/accesslog/v3/accesslog.pb.h"
+
+#include "extensions/access_loggers/grpc/grpc_access_log_impl.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace GrpcCommon {
+namespace {
+
+// A gRPC access logger sending its batches to a stream which drops them.
+class TestLogger {
+public:
+  TestLogger() {
+    new NiceMock<Event::MockTimer>(&dispatcher_);
+    ON_CALL(*async_client_, startRaw(_, _, _, _)).WillByDefault(Return(&stream_));
+    ON_CALL(stream_, isAboveWriteBufferHighWatermark()).WillByDefault(Return(false));
+    logger_ = std::make_unique<GrpcAccessLoggerImpl>(
+        Grpc::RawAsyncClientPtr{async_client_}, "test_log_name", std::chrono::milliseconds(1000),
+        16384, dispatcher_, local_info_, stats_store_, envoy::config::core::v3::ApiVersion::V3);
+  }
+
+  Stats::TestUtil::TestStore stats_store_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Grpc::MockAsyncStream> stream_;
+  NiceMock<Grpc::MockAsyncClient>* async_client_{new NiceMock<Grpc::MockAsyncClient>};
+  std::unique_ptr<GrpcAccessLoggerImpl> logger_;
+};
+
+// Fills in an entry with the properties which the HTTP gRPC access log usually sets.
+void buildEntry(envoy::data::accesslog::v3::HTTPAccessLogEntry& entry, uint64_t i) {
+  auto* common_properties = entry.mutable_common_properties();
+  common_properties->mutable_start_time()->set_seconds(1600000000 + i);
+  common_properties->mutable_time_to_last_rx_byte()->set_nanos(1000);
+  common_properties->mutable_time_to_last_downstream_tx_byte()->set_nanos(2000000);
+  common_properties->set_upstream_cluster("upstream_cluster");
+  entry.set_protocol_version(envoy::data::accesslog::v3::HTTPAccessLogEntry::HTTP11);
+  auto* request = entry.mutable_request();
+  request->set_scheme("https");
+  request->set_authority("www.example.com");
+  request->set_path("/api/v1/resources/1234567890?filter=active&sort=name");
+  request->set_user_agent("Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)");
+  request->set_request_id("6a6d63c4-8e8c-4d6b-9a3a-0f6c5e1d2b7f");
+  request->set_request_headers_bytes(512);
+  request->set_request_method(envoy::config::core::v3::GET);
+  (*request->mutable_request_headers())["x-tenant"] = "tenant-1";
+  auto* response = entry.mutable_response();
+  response->mutable_response_code()->set_value(200);
+  response->set_response_headers_bytes(128);
+  response->set_response_body_bytes(4096 + i % 1024);
+  (*response->mutable_response_headers())["content-type"] = "application/json";
+}
+
+static void BM_LogEntryBuiltInPlace(benchmark::State& state) {
+  TestLogger test_logger;
+  uint64_t i = 0;
+  for (auto _ : state) {
+    test_logger.logger_->log(
+        [i](envoy::data::accesslog::v3::HTTPAccessLogEntry& entry) { buildEntry(entry, i); });
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogEntryBuiltInPlace);
+
+static void BM_LogEntryMoved(benchmark::State& state) {
+  TestLogger test_logger;
+  uint64_t i = 0;
+  for (auto _ : state) {
+    envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+    buildEntry(entry, i++);
+    test_logger.logger_->log(std::move(entry));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogEntryMoved);
+
+} // namespace
+} // namespace GrpcCommon
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -309,6 +309,78 @@ http_logs:
   logger_->log(envoy::data::accesslog::v3::HTTPAccessLogEntry(entry));
 }
 
+// Test that log entries built in place are batched, and that the batch is cleared once sent.
+TEST_F(GrpcAccessLoggerImplTest, BatchingEntriesBuiltInPlace) {
+  InSequence s;
+  initLogger(FlushInterval, 100);
+
+  MockAccessLogStream stream;
+  AccessLogCallbacks* callbacks;
+  expectStreamStart(stream, &callbacks);
+  EXPECT_CALL(local_info_, node());
+  const std::string path1(30, '1');
+  const std::string path2(80, '2');
+  expectStreamMessage(stream, fmt::format(R"EOF(
+identifier:
+  node:
+    id: node_name
+    cluster: cluster_name
+    locality:
+      zone: zone_name
+  log_name: test_log_name
+http_logs:
+  log_entry:
+  - request:
+      path: "{}"
+  - request:
+      path: "{}"
+)EOF",
+                                          path1, path2));
+  logger_->log([&path1](envoy::data::accesslog::v3::HTTPAccessLogEntry& entry) {
+    entry.mutable_request()->set_path(path1);
+  });
+  logger_->log([&path2](envoy::data::accesslog::v3::HTTPAccessLogEntry& entry) {
+    entry.mutable_request()->set_path(path2);
+  });
+
+  expectStreamMessage(stream, R"EOF(
+tcp_logs:
+  log_entry:
+    connection_properties:
+      received_bytes: 123456789
+      sent_bytes: 987654321
+)EOF");
+  logger_->log([](envoy::data::accesslog::v3::TCPAccessLogEntry& entry) {
+    entry.mutable_connection_properties()->set_received_bytes(123456789);
+    entry.mutable_connection_properties()->set_sent_bytes(987654321);
+  });
+  EXPECT_CALL(*timer_, enableTimer(FlushInterval, _));
+  timer_->invokeCallback();
+}
+
+// Test that log entries which are dropped are not built.
+TEST_F(GrpcAccessLoggerImplTest, DroppedEntryNotBuilt) {
+  InSequence s;
+  initLogger(FlushInterval, 1);
+
+  MockAccessLogStream stream;
+  AccessLogCallbacks* callbacks;
+  expectStreamStart(stream, &callbacks);
+  EXPECT_CALL(local_info_, node());
+  EXPECT_CALL(stream, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  logger_->log([](envoy::data::accesslog::v3::HTTPAccessLogEntry& entry) {
+    entry.mutable_request()->set_path("/test/path1");
+  });
+
+  EXPECT_CALL(stream, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  bool built = false;
+  logger_->log([&built](envoy::data::accesslog::v3::HTTPAccessLogEntry&) { built = true; });
+  EXPECT_FALSE(built);
+  EXPECT_EQ(
+      1,
+      TestUtility::findCounter(stats_store_, "access_logs.grpc_access_log.logs_dropped")->value());
+}
+
 // Test that log entries are flushed periodically.
 TEST_F(GrpcAccessLoggerImplTest, Flushing) {
   InSequence s;
@@ -36,6 +36,16 @@ using envoy::data::accesslog::v3::HTTPAccessLogEntry;
 class MockGrpcAccessLogger : public GrpcCommon::GrpcAccessLogger {
 public:
   // GrpcAccessLogger
+  void log(const GrpcCommon::HttpLogEntryBuilder& build) override {
+    HTTPAccessLogEntry entry;
+    build(entry);
+    log(std::move(entry));
+  }
+  void log(const GrpcCommon::TcpLogEntryBuilder& build) override {
+    envoy::data::accesslog::v3::TCPAccessLogEntry entry;
+    build(entry);
+    log(std::move(entry));
+  }
   MOCK_METHOD(void, log, (HTTPAccessLogEntry && entry));
   MOCK_METHOD(void, log, (envoy::data::accesslog::v3::TCPAccessLogEntry && entry));
 };
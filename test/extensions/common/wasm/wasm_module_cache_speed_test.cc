@@ -0,0 +1,138 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/common/wasm/wasm_module_cache.h"
+
+#include "test/benchmark/main.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+
+using Envoy::benchmark::skipExpensiveBenchmarks;
+
+static void appendVarint(uint32_t value, std::string& out) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    if (value != 0) {
+      byte |= 0x80;
+    }
+    out.push_back(byte);
+  } while (value != 0);
+}
+
+static void appendSection(uint8_t id, const std::string& contents, std::string& out) {
+  out.push_back(id);
+  appendVarint(contents.size(), out);
+  out.append(contents);
+}
+
+// Returns a valid module of about 5 MB: 1000 functions, each of which pushes and drops a constant
+// about 1700 times. The module is much smaller when expensive benchmarks are skipped.
+static std::string largeModule() {
+  const uint32_t num_functions = skipExpensiveBenchmarks() ? 10 : 1000;
+  const uint32_t num_instructions = 1700;
+
+  std::string module("\0asm\x01\0\0\0", 8);
+  // One type: () -> ().
+  appendSection(1, std::string("\x01\x60\x00\x00", 4), module);
+  std::string functions;
+  appendVarint(num_functions, functions);
+  functions.append(num_functions, '\0');
+  appendSection(3, functions, module);
+
+  // No locals, i32.const 1 and drop repeated, end.
+  std::string body("\0", 1);
+  for (uint32_t i = 0; i < num_instructions; ++i) {
+    body.append("\x41\x01\x1a");
+  }
+  body.push_back('\x0b');
+  std::string code;
+  appendVarint(num_functions, code);
+  for (uint32_t i = 0; i < num_functions; ++i) {
+    appendVarint(body.size(), code);
+    code.append(body);
+  }
+  appendSection(10, code, module);
+  return module;
+}
+
+class WasmModuleCachePerf {
+public:
+  WasmModuleCachePerf()
+      : api_(Api::createApiForTest(stats_store_)),
+        cache_(std::make_unique<WasmModuleCache>(stats_store_, *api_)) {}
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Api::ApiPtr api_;
+  std::unique_ptr<WasmModuleCache> cache_;
+};
+
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
+
+using Envoy::Extensions::Common::Wasm::largeModule;
+using Envoy::Extensions::Common::Wasm::WasmModuleCache;
+using Envoy::Extensions::Common::Wasm::WasmModuleCachePerf;
+using Envoy::Extensions::Common::Wasm::WasmModuleSharedPtr;
+
+// Tests loading the module and creating the VM of one worker without the cache, as on every
+// configuration update before.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompileModule(benchmark::State& state) {
+  WasmModuleCachePerf context;
+  const std::string code = largeModule();
+  for (auto _ : state) {
+    // A fresh cache compiles the module.
+    WasmModuleCache cache(context.stats_store_, *context.api_);
+    WasmModuleSharedPtr module = cache.getOrLoad("envoy.wasm.runtime.v8", code, false, "");
+    benchmark::DoNotOptimize(module->createVm());
+  }
+  state.counters["module_bytes"] = code.size();
+}
+BENCHMARK(BM_CompileModule)->Unit(benchmark::kMillisecond);
+
+// Tests a configuration update which finds the module in the cache.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CachedModule(benchmark::State& state) {
+  WasmModuleCachePerf context;
+  const std::string code = largeModule();
+  const WasmModuleSharedPtr in_use =
+      context.cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, "");
+  for (auto _ : state) {
+    WasmModuleSharedPtr module =
+        context.cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, "");
+    benchmark::DoNotOptimize(module->createVm());
+  }
+}
+BENCHMARK(BM_CachedModule)->Unit(benchmark::kMillisecond);
+
+// Tests a restart which finds the compiled module in the directory.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompiledModuleFromDirectory(benchmark::State& state) {
+  WasmModuleCachePerf context;
+  const std::string directory = Envoy::TestEnvironment::temporaryPath("wasm_module_cache_perf");
+  Envoy::TestEnvironment::removePath(directory);
+  Envoy::TestEnvironment::createPath(directory);
+  const std::string code = largeModule();
+  context.cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+  for (auto _ : state) {
+    WasmModuleCache cache(context.stats_store_, *context.api_);
+    WasmModuleSharedPtr module = cache.getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+    benchmark::DoNotOptimize(module->createVm());
+  }
+}
+BENCHMARK(BM_CompiledModuleFromDirectory)->Unit(benchmark::kMillisecond);
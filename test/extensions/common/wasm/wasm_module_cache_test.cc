@@ -0,0 +1,211 @@
+#include <sys/stat.h>
+
+#include "envoy/registry/registry.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
+#include "common/crypto/utility.h"
+
+#include "extensions/common/wasm/null/null_vm_plugin.h"
+#include "extensions/common/wasm/wasm_module_cache.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/logging.h"
+#include "test/test_common/registry.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace Wasm {
+namespace {
+
+class PluginFactory : public Null::NullVmPluginFactory {
+public:
+  std::string name() const override { return "test_module_cache_plugin"; }
+  Null::NullVmPluginPtr create() const override { return std::make_unique<Null::NullVmPlugin>(); }
+};
+
+class WasmModuleCacheTest : public testing::Test {
+public:
+  WasmModuleCacheTest()
+      : registration_(factory_), api_(Api::createApiForTest(stats_store_)),
+        cache_(std::make_unique<WasmModuleCache>(stats_store_, *api_)) {}
+
+  uint64_t counter(absl::string_view name) {
+    return stats_store_.counter(absl::StrCat("wasm.module_cache.", name)).value();
+  }
+
+  static std::string readTestModule() {
+    return TestEnvironment::readFileToStringForTest(TestEnvironment::substitute(
+        "{{ test_rundir }}/test/extensions/common/wasm/test_data/test_rust.wasm"));
+  }
+
+  // Cached code is only loaded from directories that no other user can write.
+  static std::string createCacheDirectory(const std::string& name) {
+    const std::string directory = TestEnvironment::temporaryPath(name);
+    TestEnvironment::removePath(directory);
+    TestEnvironment::createPath(directory);
+    RELEASE_ASSERT(::chmod(directory.c_str(), 0755) == 0, "");
+    return directory;
+  }
+
+  static std::string digest(const std::string& code) {
+    return Hex::encode(Envoy::Common::Crypto::UtilitySingleton::get().getSha256Digest(
+        Buffer::OwnedImpl(code)));
+  }
+
+  PluginFactory factory_;
+  Registry::InjectFactory<Null::NullVmPluginFactory> registration_;
+  Stats::TestUtil::TestStore stats_store_;
+  Api::ApiPtr api_;
+  std::unique_ptr<WasmModuleCache> cache_;
+};
+
+TEST_F(WasmModuleCacheTest, LoadsModuleOnce) {
+  WasmModuleSharedPtr module =
+      cache_->getOrLoad("envoy.wasm.runtime.null", "test_module_cache_plugin", false, "");
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ("envoy.wasm.runtime.null", module->runtime());
+  EXPECT_EQ(1, counter("miss"));
+  EXPECT_EQ(0, counter("hit"));
+
+  EXPECT_EQ(module,
+            cache_->getOrLoad("envoy.wasm.runtime.null", "test_module_cache_plugin", false, ""));
+  EXPECT_EQ(1, counter("miss"));
+  EXPECT_EQ(1, counter("hit"));
+
+  // Whether precompiled code is allowed is part of the key.
+  EXPECT_NE(module,
+            cache_->getOrLoad("envoy.wasm.runtime.null", "test_module_cache_plugin", true, ""));
+  EXPECT_EQ(2, counter("miss"));
+
+  WasmVmPtr vm = module->createVm();
+  ASSERT_NE(nullptr, vm);
+  EXPECT_EQ("envoy.wasm.runtime.null", vm->runtime());
+}
+
+TEST_F(WasmModuleCacheTest, ForgetsUnusedModule) {
+  WasmModuleSharedPtr module =
+      cache_->getOrLoad("envoy.wasm.runtime.null", "test_module_cache_plugin", false, "");
+  module.reset();
+  module = cache_->getOrLoad("envoy.wasm.runtime.null", "test_module_cache_plugin", false, "");
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(2, counter("miss"));
+  EXPECT_EQ(0, counter("hit"));
+}
+
+TEST_F(WasmModuleCacheTest, BadModule) {
+  EXPECT_THROW_WITH_MESSAGE(
+      cache_->getOrLoad("envoy.wasm.runtime.null", "unknown_plugin", false, ""), WasmException,
+      "Failed to load Wasm code with the envoy.wasm.runtime.null runtime");
+  EXPECT_THROW(cache_->getOrLoad("envoy.wasm.runtime.v8", "bad code", false, ""), WasmException);
+}
+
+TEST_F(WasmModuleCacheTest, V8CompiledModuleDirectory) {
+  const std::string directory = createCacheDirectory("wasm_module_cache");
+  const std::string code = readTestModule();
+
+  WasmModuleSharedPtr module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(0, counter("disk_hit"));
+  EXPECT_EQ(0, counter("disk_write_failed"));
+
+  WasmVmPtr vm = module->createVm();
+  const std::string section_name(vm->getPrecompiledSectionName());
+  if (section_name.empty()) {
+    // This V8 build can't precompile modules.
+    return;
+  }
+  const std::string path = absl::StrCat(directory, "/", digest(code), "_", section_name, ".wasm");
+  EXPECT_TRUE(api_->fileSystem().fileExists(path));
+
+  // A new process finds the compiled module in the directory.
+  cache_ = std::make_unique<WasmModuleCache>(stats_store_, *api_);
+  module.reset();
+  module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+  ASSERT_NE(nullptr, module);
+  ASSERT_NE(nullptr, module->createVm());
+#ifdef NDEBUG
+  // V8 rejects precompiled code in debug builds, as its flags differ.
+  EXPECT_EQ(1, counter("disk_hit"));
+#endif
+}
+
+TEST_F(WasmModuleCacheTest, V8CorruptCompiledModule) {
+  const std::string directory = createCacheDirectory("wasm_module_cache_corrupt");
+  const std::string code = readTestModule();
+
+  const std::string section_name(
+      createWasmVm("envoy.wasm.runtime.v8", stats_store_.createScope("wasm."))
+          ->getPrecompiledSectionName());
+  if (section_name.empty()) {
+    return;
+  }
+  const std::string path = absl::StrCat(directory, "/", digest(code), "_", section_name, ".wasm");
+  TestEnvironment::writeStringToFileForTest(path, "corrupt", true);
+  ASSERT_EQ(0, ::chmod(path.c_str(), 0644));
+
+  // The module is compiled again, and the file replaced.
+  WasmModuleSharedPtr module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(0, counter("disk_hit"));
+  EXPECT_NE("corrupt", TestEnvironment::readFileToStringForTest(path));
+}
+
+TEST_F(WasmModuleCacheTest, V8TamperedCompiledModule) {
+  const std::string directory = createCacheDirectory("wasm_module_cache_tampered");
+  const std::string code = readTestModule();
+
+  WasmModuleSharedPtr module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory);
+  ASSERT_NE(nullptr, module);
+  const std::string section_name(module->createVm()->getPrecompiledSectionName());
+  if (section_name.empty()) {
+    return;
+  }
+  const std::string path = absl::StrCat(directory, "/", digest(code), "_", section_name, ".wasm");
+  module.reset();
+
+  // A file which others can write may have been replaced, so it is compiled again instead.
+  TestEnvironment::writeStringToFileForTest(path, "tampered", true);
+  ASSERT_EQ(0, ::chmod(path.c_str(), 0666));
+  cache_ = std::make_unique<WasmModuleCache>(stats_store_, *api_);
+  EXPECT_LOG_CONTAINS("warn", "ignoring compiled Wasm module",
+                      module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory));
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(0, counter("disk_hit"));
+  EXPECT_EQ(1, counter("disk_untrusted"));
+  EXPECT_NE("tampered", TestEnvironment::readFileToStringForTest(path));
+  struct stat info;
+  ASSERT_EQ(0, ::stat(path.c_str(), &info));
+  EXPECT_EQ(0, info.st_mode & (S_IWGRP | S_IWOTH));
+  module.reset();
+
+  // So is a file in a directory which others can write.
+  ASSERT_EQ(0, ::chmod(directory.c_str(), 0777));
+  cache_ = std::make_unique<WasmModuleCache>(stats_store_, *api_);
+  EXPECT_LOG_CONTAINS("warn", "ignoring compiled Wasm module",
+                      module = cache_->getOrLoad("envoy.wasm.runtime.v8", code, false, directory));
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(0, counter("disk_hit"));
+  EXPECT_EQ(2, counter("disk_untrusted"));
+}
+
+TEST_F(WasmModuleCacheTest, V8UnwritableDirectory) {
+  WasmModuleSharedPtr module = cache_->getOrLoad("envoy.wasm.runtime.v8", readTestModule(), false,
+                                                 "/nonexistent/wasm_module_cache");
+  ASSERT_NE(nullptr, module);
+  if (!module->createVm()->getPrecompiledSectionName().empty()) {
+    EXPECT_EQ(1, counter("disk_write_failed"));
+  }
+}
+
+} // namespace
+} // namespace Wasm
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
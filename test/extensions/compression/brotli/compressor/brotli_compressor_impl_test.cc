@@ -0,0 +1,116 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/compression/brotli/compressor/brotli_compressor_impl.h"
+#include "extensions/compression/brotli/compressor/config.h"
+#include "extensions/compression/brotli/decompressor/brotli_decompressor_impl.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Compressor {
+namespace {
+
+class BrotliCompressorImplTest : public testing::Test {
+protected:
+  // Compresses 30 chunks of random text, flushing after each of them, and verifies that they
+  // decompress to the original text.
+  void verifyRoundTrip(Envoy::Compression::Compressor::Compressor& compressor) {
+    Buffer::OwnedImpl buffer;
+    Buffer::OwnedImpl accumulation_buffer;
+    std::string original_text;
+    for (uint64_t i = 0; i < 30; ++i) {
+      TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size * i, i);
+      original_text.append(buffer.toString());
+      compressor.compress(buffer, Envoy::Compression::Compressor::State::Flush);
+      accumulation_buffer.add(buffer);
+      buffer.drain(buffer.length());
+    }
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    accumulation_buffer.add(buffer);
+    buffer.drain(buffer.length());
+
+    Stats::IsolatedStoreImpl stats_store;
+    Decompressor::BrotliDecompressorImpl decompressor{stats_store, "test.", false, 4096};
+    decompressor.decompress(accumulation_buffer, buffer);
+    EXPECT_FALSE(decompressor.decompression_error_);
+    EXPECT_EQ(original_text, buffer.toString());
+  }
+
+  static constexpr uint32_t default_quality{3};
+  static constexpr uint32_t default_window_bits{18};
+  static constexpr uint32_t default_input_block_bits{24};
+  static constexpr uint64_t default_input_size{796};
+};
+
+TEST_F(BrotliCompressorImplTest, CompressAndDecompress) {
+  BrotliCompressorImpl compressor{default_quality,
+                                  default_window_bits,
+                                  default_input_block_bits,
+                                  false,
+                                  BrotliCompressorImpl::EncoderMode::Default,
+                                  4096};
+  verifyRoundTrip(compressor);
+}
+
+// Verifies that output larger than a chunk is flushed chunk by chunk.
+TEST_F(BrotliCompressorImplTest, CompressWithSmallChunkSize) {
+  BrotliCompressorImpl compressor{0, default_window_bits, default_input_block_bits, false,
+                                  BrotliCompressorImpl::EncoderMode::Default, 16};
+  verifyRoundTrip(compressor);
+}
+
+TEST_F(BrotliCompressorImplTest, CompressWithNotCommonParams) {
+  BrotliCompressorImpl compressor{11, 10, 16, true, BrotliCompressorImpl::EncoderMode::Text, 4096};
+  verifyRoundTrip(compressor);
+}
+
+TEST_F(BrotliCompressorImplTest, CallingFinishOnly) {
+  BrotliCompressorImpl compressor{default_quality,
+                                  default_window_bits,
+                                  default_input_block_bits,
+                                  false,
+                                  BrotliCompressorImpl::EncoderMode::Default,
+                                  4096};
+  Buffer::OwnedImpl buffer;
+  compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+  // The stream still has a header and an empty last meta-block.
+  EXPECT_NE(0, buffer.length());
+
+  Buffer::OwnedImpl output_buffer;
+  Stats::IsolatedStoreImpl stats_store;
+  Decompressor::BrotliDecompressorImpl decompressor{stats_store, "test.", false, 4096};
+  decompressor.decompress(buffer, output_buffer);
+  EXPECT_FALSE(decompressor.decompression_error_);
+  EXPECT_EQ(0, output_buffer.length());
+}
+
+TEST(BrotliCompressorFactoryTest, CreateCompressor) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  envoy::extensions::compression::brotli::compressor::v3::Brotli config;
+  TestUtility::loadFromYaml(R"EOF(
+quality: 5
+encoder_mode: TEXT
+window_bits: 20
+)EOF",
+                            config);
+  BrotliCompressorLibraryFactory library_factory;
+  Envoy::Compression::Compressor::CompressorFactoryPtr factory =
+      library_factory.createCompressorFactoryFromProto(config, context);
+  EXPECT_EQ("br", factory->contentEncoding());
+  EXPECT_EQ("brotli.", factory->statsPrefix());
+  EXPECT_NE(nullptr, factory->createCompressor());
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,75 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/compression/brotli/compressor/brotli_compressor_impl.h"
+#include "extensions/compression/brotli/decompressor/brotli_decompressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Brotli {
+namespace Decompressor {
+namespace {
+
+class BrotliDecompressorImplTest : public testing::Test {
+protected:
+  // Returns a brotli stream of the text, compressed in one go.
+  static Buffer::OwnedImpl compress(const std::string& text) {
+    Compressor::BrotliCompressorImpl compressor{
+        3, 18, 24, false, Compressor::BrotliCompressorImpl::EncoderMode::Default, 4096};
+    Buffer::OwnedImpl buffer(text);
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    return buffer;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+};
+
+// Verifies that the decompressor can be fed one byte at a time, and that output larger than a
+// chunk is flushed chunk by chunk.
+TEST_F(BrotliDecompressorImplTest, DecompressInPieces) {
+  Buffer::OwnedImpl original;
+  TestUtility::feedBufferWithRandomCharacters(original, 10000);
+  const std::string original_text = original.toString();
+  const std::string compressed = compress(original_text).toString();
+
+  BrotliDecompressorImpl decompressor{stats_store_, "test.", false, 16};
+  Buffer::OwnedImpl output_buffer;
+  for (const char c : compressed) {
+    Buffer::OwnedImpl input_buffer(&c, 1);
+    decompressor.decompress(input_buffer, output_buffer);
+  }
+  EXPECT_FALSE(decompressor.decompression_error_);
+  EXPECT_EQ(original_text, output_buffer.toString());
+}
+
+TEST_F(BrotliDecompressorImplTest, DisableRingBufferReallocation) {
+  Buffer::OwnedImpl input_buffer = compress("hello hello hello hello");
+  BrotliDecompressorImpl decompressor{stats_store_, "test.", true, 4096};
+  Buffer::OwnedImpl output_buffer;
+  decompressor.decompress(input_buffer, output_buffer);
+  EXPECT_FALSE(decompressor.decompression_error_);
+  EXPECT_EQ("hello hello hello hello", output_buffer.toString());
+}
+
+TEST_F(BrotliDecompressorImplTest, DecompressCorruptedInput) {
+  // The stream header announces a large window, which is not part of the standard format.
+  Buffer::OwnedImpl corrupted_buffer("\x11\x22\x33\x44");
+
+  BrotliDecompressorImpl decompressor{stats_store_, "test.", false, 4096};
+  Buffer::OwnedImpl output_buffer;
+  decompressor.decompress(corrupted_buffer, output_buffer);
+  EXPECT_TRUE(decompressor.decompression_error_);
+  EXPECT_EQ(1, stats_store_.counterFromString("test.brotli_error").value());
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace Brotli
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
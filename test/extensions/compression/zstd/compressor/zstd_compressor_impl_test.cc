@@ -0,0 +1,192 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/compression/zstd/compressor/config.h"
+#include "extensions/compression/zstd/compressor/zstd_compressor_impl.h"
+#include "extensions/compression/zstd/decompressor/zstd_decompressor_impl.h"
+
+#include "test/extensions/compression/zstd/test_utility.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+namespace {
+
+class ZstdCompressorImplTest : public testing::Test {
+protected:
+  // Returns a pool of contexts with the given compression level, counting the contexts it creates.
+  CompressorContextPoolSharedPtr createPool(int compression_level, uint32_t max_idle = 8) {
+    return std::make_shared<CompressorContextPool>(
+        [this, compression_level]() {
+          created_contexts_++;
+          CompressorContextPool::ContextPtr context(ZSTD_createCCtx());
+          ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, compression_level);
+          ZSTD_CCtx_setParameter(context.get(), ZSTD_c_checksumFlag, 1);
+          return context;
+        },
+        max_idle);
+  }
+
+  static std::string decompress(const std::string& compressed) {
+    Stats::IsolatedStoreImpl stats_store;
+    auto pool = std::make_shared<Decompressor::DecompressorContextPool>(
+        []() { return Decompressor::DecompressorContextPool::ContextPtr(ZSTD_createDCtx()); }, 1);
+    Decompressor::ZstdDecompressorImpl decompressor{
+        stats_store, "test.", pool, std::make_shared<const Decompressor::DictionaryMap>(), 4096};
+    Buffer::OwnedImpl input_buffer(compressed);
+    Buffer::OwnedImpl output_buffer;
+    decompressor.decompress(input_buffer, output_buffer);
+    EXPECT_FALSE(decompressor.decompression_error_);
+    return output_buffer.toString();
+  }
+
+  // Compresses 30 chunks of random text, flushing after each of them, and verifies that they
+  // decompress to the original text.
+  void verifyRoundTrip(Envoy::Compression::Compressor::Compressor& compressor) {
+    Buffer::OwnedImpl buffer;
+    Buffer::OwnedImpl accumulation_buffer;
+    std::string original_text;
+    for (uint64_t i = 0; i < 30; ++i) {
+      TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size * i, i);
+      original_text.append(buffer.toString());
+      compressor.compress(buffer, Envoy::Compression::Compressor::State::Flush);
+      accumulation_buffer.add(buffer);
+      buffer.drain(buffer.length());
+    }
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    accumulation_buffer.add(buffer);
+
+    EXPECT_EQ(original_text, decompress(accumulation_buffer.toString()));
+  }
+
+  static std::string compress(ZstdCompressorImpl& compressor, const std::string& text) {
+    Buffer::OwnedImpl buffer(text);
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    return buffer.toString();
+  }
+
+  static constexpr uint64_t default_input_size{796};
+  uint32_t created_contexts_{};
+};
+
+TEST_F(ZstdCompressorImplTest, CompressAndDecompress) {
+  ZstdCompressorImpl compressor{createPool(ZSTD_CLEVEL_DEFAULT), 4096};
+  verifyRoundTrip(compressor);
+}
+
+// Verifies that output larger than a chunk is flushed chunk by chunk.
+TEST_F(ZstdCompressorImplTest, CompressWithSmallChunkSize) {
+  ZstdCompressorImpl compressor{createPool(1), 16};
+  verifyRoundTrip(compressor);
+}
+
+TEST_F(ZstdCompressorImplTest, CallingFinishOnly) {
+  ZstdCompressorImpl compressor{createPool(ZSTD_CLEVEL_DEFAULT), 4096};
+  const std::string compressed = compress(compressor, "");
+  // The frame still has a header and an empty last block.
+  EXPECT_NE(0, compressed.size());
+  EXPECT_EQ("", decompress(compressed));
+}
+
+// Verifies that the context of a compressor is given back to the pool when it is destroyed, and
+// that a reused context compresses exactly like a new one.
+TEST_F(ZstdCompressorImplTest, ReuseContext) {
+  CompressorContextPoolSharedPtr pool = createPool(ZSTD_CLEVEL_DEFAULT);
+  const std::string text = jsonSample(1) + jsonSample(2) + jsonSample(3);
+
+  std::string first;
+  {
+    ZstdCompressorImpl compressor{pool, 4096};
+    first = compress(compressor, text);
+  }
+  EXPECT_EQ(1, created_contexts_);
+  EXPECT_EQ(1, pool->idleSize());
+
+  // A stream abandoned in the middle of a frame, e.g. because it was reset.
+  {
+    ZstdCompressorImpl compressor{pool, 4096};
+    EXPECT_EQ(0, pool->idleSize());
+    Buffer::OwnedImpl buffer(text);
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Flush);
+  }
+  EXPECT_EQ(1, pool->idleSize());
+
+  ZstdCompressorImpl compressor{pool, 4096};
+  EXPECT_EQ(first, compress(compressor, text));
+  EXPECT_EQ(text, decompress(first));
+  EXPECT_EQ(1, created_contexts_);
+}
+
+TEST_F(ZstdCompressorImplTest, PoolKeepsAtMostMaxIdleContexts) {
+  CompressorContextPoolSharedPtr pool = createPool(1, 2);
+  {
+    ZstdCompressorImpl compressor1{pool, 4096};
+    ZstdCompressorImpl compressor2{pool, 4096};
+    ZstdCompressorImpl compressor3{pool, 4096};
+  }
+  EXPECT_EQ(3, created_contexts_);
+  EXPECT_EQ(2, pool->idleSize());
+}
+
+class ZstdCompressorFactoryTest : public ZstdCompressorImplTest {
+protected:
+  Envoy::Compression::Compressor::CompressorFactoryPtr createFactory() {
+    ZstdCompressorLibraryFactory library_factory;
+    return library_factory.createCompressorFactoryFromProto(config_, context_);
+  }
+
+  NiceMock<Server::Configuration::MockFactoryContext> context_;
+  envoy::extensions::compression::zstd::compressor::v3::Zstd config_;
+};
+
+TEST_F(ZstdCompressorFactoryTest, CreateCompressor) {
+  TestUtility::loadFromYaml(R"EOF(
+compression_level: 19
+enable_checksum: true
+strategy: BTULTRA2
+)EOF",
+                            config_);
+  Envoy::Compression::Compressor::CompressorFactoryPtr factory = createFactory();
+  EXPECT_EQ("zstd", factory->contentEncoding());
+  EXPECT_EQ("zstd.", factory->statsPrefix());
+
+  const std::string text = jsonSample(1);
+  Buffer::OwnedImpl buffer(text);
+  factory->createCompressor()->compress(buffer, Envoy::Compression::Compressor::State::Finish);
+
+  ZSTD_frameHeader header;
+  const std::string compressed = buffer.toString();
+  ASSERT_EQ(0, ZSTD_getFrameHeader(&header, compressed.data(), compressed.size()));
+  EXPECT_EQ(1, header.checksumFlag);
+  EXPECT_EQ(text, decompress(compressed));
+}
+
+// Verifies that the ID of the dictionary is written in the frame header.
+TEST_F(ZstdCompressorFactoryTest, CreateCompressorWithDictionary) {
+  config_.mutable_dictionary()->set_inline_bytes(trainedDictionary(42));
+  Envoy::Compression::Compressor::CompressorFactoryPtr factory = createFactory();
+
+  Buffer::OwnedImpl buffer(jsonSample(1));
+  factory->createCompressor()->compress(buffer, Envoy::Compression::Compressor::State::Finish);
+  const std::string compressed = buffer.toString();
+  EXPECT_EQ(42, ZSTD_getDictID_fromFrame(compressed.data(), compressed.size()));
+}
+
+TEST_F(ZstdCompressorFactoryTest, DictionaryWithoutId) {
+  config_.mutable_dictionary()->set_inline_bytes("raw content dictionary");
+  EXPECT_THROW_WITH_MESSAGE(createFactory(), EnvoyException,
+                            "zstd compressor: the dictionary must have an ID");
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
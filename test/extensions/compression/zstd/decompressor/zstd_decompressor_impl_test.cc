@@ -0,0 +1,252 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/compression/zstd/decompressor/config.h"
+#include "extensions/compression/zstd/decompressor/zstd_decompressor_impl.h"
+
+#include "test/extensions/compression/zstd/test_utility.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+namespace {
+
+class ZstdDecompressorImplTest : public testing::Test {
+protected:
+  // Returns a zstd frame of the text, compressed with the dictionary if not empty.
+  static std::string compress(const std::string& text, const std::string& dictionary = "") {
+    std::string compressed(ZSTD_compressBound(text.size()), '\0');
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    const size_t size =
+        ZSTD_compress_usingDict(context, &compressed[0], compressed.size(), text.data(),
+                                text.size(), dictionary.data(), dictionary.size(), 3);
+    ZSTD_freeCCtx(context);
+    RELEASE_ASSERT(!ZSTD_isError(size), ZSTD_getErrorName(size));
+    compressed.resize(size);
+    return compressed;
+  }
+
+  // Returns a zstd frame of the text declaring a window of 2^window_log bytes. The frame header
+  // does not record the size of the text, so that the window is not shrunk to fit it.
+  static std::string compressWithWindowLog(const std::string& text, int window_log) {
+    std::string compressed(ZSTD_compressBound(text.size()) + ZSTD_CStreamOutSize(), '\0');
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(context, ZSTD_c_windowLog, window_log);
+    ZSTD_outBuffer output{&compressed[0], compressed.size(), 0};
+    ZSTD_inBuffer input{text.data(), text.size(), 0};
+    // Starting without ZSTD_e_end leaves the frame content size unknown.
+    size_t result = ZSTD_compressStream2(context, &output, &input, ZSTD_e_continue);
+    while (!ZSTD_isError(result)) {
+      result = ZSTD_compressStream2(context, &output, &input, ZSTD_e_end);
+      if (result == 0) {
+        break;
+      }
+    }
+    ZSTD_freeCCtx(context);
+    RELEASE_ASSERT(!ZSTD_isError(result), ZSTD_getErrorName(result));
+    compressed.resize(output.pos);
+    return compressed;
+  }
+
+  void setWindowLogMax(int window_log_max) {
+    pool_ = std::make_shared<DecompressorContextPool>(
+        [window_log_max]() {
+          DecompressorContextPool::ContextPtr context(ZSTD_createDCtx());
+          ZSTD_DCtx_setParameter(context.get(), ZSTD_d_windowLogMax, window_log_max);
+          return context;
+        },
+        8);
+  }
+
+  std::unique_ptr<ZstdDecompressorImpl> createDecompressor(uint32_t chunk_size = 4096) {
+    return std::make_unique<ZstdDecompressorImpl>(stats_store_, "test.", pool_, dictionaries_,
+                                                  chunk_size);
+  }
+
+  void addDictionary(const std::string& dictionary) {
+    auto dictionaries = std::make_shared<DictionaryMap>(*dictionaries_);
+    dictionaries->emplace(
+        ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size()),
+        std::shared_ptr<const ZSTD_DDict>(ZSTD_createDDict(dictionary.data(), dictionary.size()),
+                                          &ZSTD_freeDDict));
+    dictionaries_ = std::move(dictionaries);
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  DecompressorContextPoolSharedPtr pool_{std::make_shared<DecompressorContextPool>(
+      []() { return DecompressorContextPool::ContextPtr(ZSTD_createDCtx()); }, 8)};
+  DictionaryMapConstSharedPtr dictionaries_{std::make_shared<const DictionaryMap>()};
+};
+
+// Verifies that the decompressor can be fed one byte at a time, and that output larger than a
+// chunk is flushed chunk by chunk.
+TEST_F(ZstdDecompressorImplTest, DecompressInPieces) {
+  Buffer::OwnedImpl original;
+  TestUtility::feedBufferWithRandomCharacters(original, 10000);
+  const std::string original_text = original.toString();
+  const std::string compressed = compress(original_text);
+
+  auto decompressor = createDecompressor(16);
+  Buffer::OwnedImpl output_buffer;
+  for (const char c : compressed) {
+    Buffer::OwnedImpl input_buffer(&c, 1);
+    decompressor->decompress(input_buffer, output_buffer);
+  }
+  EXPECT_FALSE(decompressor->decompression_error_);
+  EXPECT_EQ(original_text, output_buffer.toString());
+}
+
+// Verifies that the dictionary of each frame is selected from the ID in its header.
+TEST_F(ZstdDecompressorImplTest, SelectDictionaryOfEachFrame) {
+  const std::string dictionary1 = trainedDictionary(1);
+  const std::string dictionary2 = trainedDictionary(2);
+  addDictionary(dictionary1);
+  addDictionary(dictionary2);
+
+  const std::string text = jsonSample(1) + jsonSample(2);
+  // The frames compress better with a dictionary.
+  EXPECT_LT(compress(text, dictionary1).size(), compress(text).size());
+
+  auto decompressor = createDecompressor();
+  Buffer::OwnedImpl input_buffer(compress(text, dictionary1) + compress(text) +
+                                 compress(text, dictionary2));
+  Buffer::OwnedImpl output_buffer;
+  decompressor->decompress(input_buffer, output_buffer);
+  EXPECT_FALSE(decompressor->decompression_error_);
+  EXPECT_EQ(text + text + text, output_buffer.toString());
+}
+
+// Verifies that the dictionary is selected from the whole frame header, even when it is split
+// across calls.
+TEST_F(ZstdDecompressorImplTest, SelectDictionaryInPieces) {
+  const std::string dictionary = trainedDictionary(1);
+  addDictionary(dictionary);
+
+  const std::string text = jsonSample(1);
+  const std::string compressed = compress(text, dictionary) + compress(text);
+  auto decompressor = createDecompressor();
+  Buffer::OwnedImpl output_buffer;
+  for (const char c : compressed) {
+    Buffer::OwnedImpl input_buffer(&c, 1);
+    decompressor->decompress(input_buffer, output_buffer);
+  }
+  EXPECT_FALSE(decompressor->decompression_error_);
+  EXPECT_EQ(text + text, output_buffer.toString());
+}
+
+TEST_F(ZstdDecompressorImplTest, MissingDictionary) {
+  addDictionary(trainedDictionary(1));
+
+  auto decompressor = createDecompressor();
+  Buffer::OwnedImpl input_buffer(compress(jsonSample(1), trainedDictionary(2)));
+  Buffer::OwnedImpl output_buffer;
+  decompressor->decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor->decompression_error_);
+  EXPECT_EQ(1, stats_store_.counterFromString("test.zstd_dictionary_error").value());
+}
+
+TEST_F(ZstdDecompressorImplTest, DecompressCorruptedInput) {
+  auto decompressor = createDecompressor();
+  // Not a zstd frame.
+  Buffer::OwnedImpl input_buffer("\x11\x22\x33\x44\x55\x66\x77\x88");
+  Buffer::OwnedImpl output_buffer;
+  decompressor->decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor->decompression_error_);
+  EXPECT_EQ(1, stats_store_.counterFromString("test.zstd_generic_error").value());
+}
+
+// Verifies that a context given back in the middle of a frame, e.g. because the stream was reset,
+// is reset before being reused.
+TEST_F(ZstdDecompressorImplTest, ReuseContext) {
+  const std::string compressed = compress(jsonSample(1));
+  {
+    auto decompressor = createDecompressor();
+    Buffer::OwnedImpl input_buffer(compressed.substr(0, compressed.size() / 2));
+    Buffer::OwnedImpl output_buffer;
+    decompressor->decompress(input_buffer, output_buffer);
+  }
+  EXPECT_EQ(1, pool_->idleSize());
+
+  auto decompressor = createDecompressor();
+  EXPECT_EQ(0, pool_->idleSize());
+  Buffer::OwnedImpl input_buffer(compressed);
+  Buffer::OwnedImpl output_buffer;
+  decompressor->decompress(input_buffer, output_buffer);
+  EXPECT_FALSE(decompressor->decompression_error_);
+  EXPECT_EQ(jsonSample(1), output_buffer.toString());
+}
+
+// Verifies that frames declaring a window larger than the limit of the contexts are rejected, and
+// that the limit survives the reuse of the context.
+TEST_F(ZstdDecompressorImplTest, WindowLogMax) {
+  setWindowLogMax(20);
+  const std::string text = jsonSample(1);
+  {
+    auto decompressor = createDecompressor();
+    Buffer::OwnedImpl input_buffer(compressWithWindowLog(text, 20));
+    Buffer::OwnedImpl output_buffer;
+    decompressor->decompress(input_buffer, output_buffer);
+    EXPECT_FALSE(decompressor->decompression_error_);
+    EXPECT_EQ(text, output_buffer.toString());
+  }
+  EXPECT_EQ(1, pool_->idleSize());
+
+  auto decompressor = createDecompressor();
+  Buffer::OwnedImpl input_buffer(compressWithWindowLog(text, 21));
+  Buffer::OwnedImpl output_buffer;
+  decompressor->decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor->decompression_error_);
+  EXPECT_EQ(1, stats_store_.counterFromString("test.zstd_generic_error").value());
+}
+
+class ZstdDecompressorFactoryTest : public testing::Test {
+protected:
+  Envoy::Compression::Decompressor::DecompressorFactoryPtr createFactory() {
+    ZstdDecompressorLibraryFactory library_factory;
+    return library_factory.createDecompressorFactoryFromProto(config_, context_);
+  }
+
+  NiceMock<Server::Configuration::MockFactoryContext> context_;
+  envoy::extensions::compression::zstd::decompressor::v3::Zstd config_;
+};
+
+TEST_F(ZstdDecompressorFactoryTest, CreateDecompressor) {
+  config_.add_dictionaries()->set_inline_bytes(trainedDictionary(1));
+  config_.add_dictionaries()->set_inline_bytes(trainedDictionary(2));
+  Envoy::Compression::Decompressor::DecompressorFactoryPtr factory = createFactory();
+  EXPECT_EQ("zstd", factory->contentEncoding());
+  EXPECT_EQ("zstd.", factory->statsPrefix());
+  EXPECT_NE(nullptr, factory->createDecompressor("test."));
+}
+
+TEST_F(ZstdDecompressorFactoryTest, WindowLogMax) {
+  config_.mutable_window_log_max()->set_value(20);
+  Envoy::Compression::Decompressor::DecompressorFactoryPtr factory = createFactory();
+  EXPECT_NE(nullptr, factory->createDecompressor("test."));
+}
+
+TEST_F(ZstdDecompressorFactoryTest, DuplicateDictionaryId) {
+  config_.add_dictionaries()->set_inline_bytes(trainedDictionary(1));
+  config_.add_dictionaries()->set_inline_bytes(trainedDictionary(1));
+  EXPECT_THROW_WITH_MESSAGE(createFactory(), EnvoyException,
+                            "zstd decompressor: duplicate dictionary ID 1");
+}
+
+TEST_F(ZstdDecompressorFactoryTest, DictionaryWithoutId) {
+  config_.add_dictionaries()->set_inline_bytes("raw content dictionary");
+  EXPECT_THROW_WITH_MESSAGE(createFactory(), EnvoyException,
+                            "zstd decompressor: the dictionaries must have an ID");
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
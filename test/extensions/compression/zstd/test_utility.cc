@@ -0,0 +1,50 @@
+#include "test/extensions/compression/zstd/test_utility.h"
+
+#include <vector>
+
+#include "common/common/assert.h"
+
+#include "absl/strings/str_cat.h"
+#include "zdict.h"
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+
+std::string jsonSample(uint32_t index) {
+  return absl::StrCat(R"({"id":)", index, R"(,"name":"user-)", index * 7919 % 1000,
+                      R"(","email":"user)", index, R"(@example.com","roles":["reader","writer"],)",
+                      R"("active":)", index % 2 == 0 ? "true" : "false", R"(,"created_at":")",
+                      2000 + index % 20, R"(-01-01T00:00:00Z"})");
+}
+
+std::string trainedDictionary(uint32_t dictionary_id) {
+  std::string samples;
+  std::vector<size_t> sample_sizes;
+  for (uint32_t i = 0; i < 2000; i++) {
+    const std::string sample = jsonSample(i);
+    samples.append(sample);
+    sample_sizes.push_back(sample.size());
+  }
+
+  std::string dictionary(4096, '\0');
+  const size_t size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(), samples.data(),
+                                            sample_sizes.data(), sample_sizes.size());
+  RELEASE_ASSERT(!ZDICT_isError(size), ZDICT_getErrorName(size));
+  dictionary.resize(size);
+
+  // The ID follows the 4 bytes of the magic number, in little endian order.
+  for (size_t i = 0; i < 4; i++) {
+    dictionary[4 + i] = static_cast<char>((dictionary_id >> (8 * i)) & 0xff);
+  }
+  RELEASE_ASSERT(ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size()) == dictionary_id,
+                 "");
+  return dictionary;
+}
+
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
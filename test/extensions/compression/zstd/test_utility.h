@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+
+/**
+ * @return a zstd dictionary with the given ID, trained on samples of JSON documents such as those
+ *         of jsonSample().
+ */
+std::string trainedDictionary(uint32_t dictionary_id);
+
+/**
+ * @return a small JSON document, which compresses much better with a trained dictionary.
+ */
+std::string jsonSample(uint32_t index);
+
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -159,6 +159,33 @@ TEST_F(LuaTest, MarkDead) {
   lua_gc(cr1->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// The worker state is loaded from the bytecode of the script, which runs its top level code and
+// keeps the chunk name and line numbers for error messages.
+TEST_F(LuaTest, LoadedFromBytecode) {
+  const std::string SCRIPT{R"EOF(
+    local greeting = "hello"
+    function callMe(object)
+      error(greeting)
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("callMe")));
+
+  CoroutinePtr cr(state_->createCoroutine());
+  EXPECT_THROW_WITH_MESSAGE(cr->start(state_->getGlobalRef(0), 0, yield_callback_), LuaException,
+                            "[string \"...\"]:4: hello");
+}
+
+// Errors while parsing or running the top level code of the script are load errors.
+TEST_F(LuaTest, ScriptLoadError) {
+  EXPECT_THROW_WITH_MESSAGE(setup("callMe("), LuaException,
+                            "script load error: [string \"callMe(\"]:1: unexpected symbol near "
+                            "'<eof>'");
+  EXPECT_THROW_WITH_MESSAGE(setup("error('boom')"), LuaException,
+                            "script load error: [string \"error('boom')\"]:1: boom");
+}
+
 class ThreadSafeTest : public testing::Test {
 public:
   ThreadSafeTest()
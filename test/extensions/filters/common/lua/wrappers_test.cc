@@ -16,7 +16,13 @@ namespace Common {
 namespace Lua {
 namespace {
 
-class LuaBufferWrapperTest : public LuaWrappersTestBase<BufferWrapper> {};
+class LuaBufferWrapperTest : public LuaWrappersTestBase<BufferWrapper> {
+public:
+  void setup(const std::string& script) override {
+    LuaWrappersTestBase<BufferWrapper>::setup(script);
+    state_->registerType<BufferSliceIterator>();
+  }
+};
 
 class LuaMetadataMapWrapperTest : public LuaWrappersTestBase<MetadataMapWrapper> {
 public:
@@ -104,6 +110,109 @@ TEST_F(LuaBufferWrapperTest, GetBytesInvalidParams) {
       "[string \"...\"]:3: index/length must be >= 0 and (index + length) must be <= buffer size");
 }
 
+// Search the buffer across slices.
+TEST_F(LuaBufferWrapperTest, Search) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      testPrint(object:search("world"))
+      testPrint(object:search("o", 5))
+      testPrint(tostring(object:search("o", 8)))
+      testPrint(tostring(object:search("planet")))
+    end
+  )EOF"};
+
+  testing::InSequence s;
+  setup(SCRIPT);
+  Buffer::OwnedImpl data;
+  data.appendSliceForTest("hello wo");
+  data.appendSliceForTest("rld");
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_CALL(printer_, testPrint("6"));
+  EXPECT_CALL(printer_, testPrint("7"));
+  EXPECT_CALL(printer_, testPrint("nil"));
+  EXPECT_CALL(printer_, testPrint("nil"));
+  start("callMe");
+}
+
+// Invalid params for the buffer wrapper search() call.
+TEST_F(LuaBufferWrapperTest, SearchInvalidParams) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      object:search("hello", -1)
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data("hello world");
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_THROW_WITH_MESSAGE(start("callMe"), LuaException,
+                            "[string \"...\"]:3: index must be >= 0");
+}
+
+// Iterate over the slices of the buffer, reading them through the FFI.
+TEST_F(LuaBufferWrapperTest, Slices) {
+  const std::string SCRIPT{R"EOF(
+    local ffi = require("ffi")
+
+    function callMe(object)
+      for pointer, length in object:slices() do
+        testPrint(string.format("%d %s", length, ffi.string(pointer, length)))
+        testPrint(ffi.cast("const uint8_t*", pointer)[0])
+      end
+    end
+  )EOF"};
+
+  testing::InSequence s;
+  setup(SCRIPT);
+  Buffer::OwnedImpl data;
+  data.appendSliceForTest("hello ");
+  data.appendSliceForTest("world");
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_CALL(printer_, testPrint("6 hello "));
+  EXPECT_CALL(printer_, testPrint("104"));
+  EXPECT_CALL(printer_, testPrint("5 world"));
+  EXPECT_CALL(printer_, testPrint("119"));
+  start("callMe");
+}
+
+// An empty buffer has no slices.
+TEST_F(LuaBufferWrapperTest, NoSlices) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      for pointer, length in object:slices() do
+        testPrint("slice")
+      end
+      testPrint("done")
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data;
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_CALL(printer_, testPrint("done"));
+  start("callMe");
+}
+
+// Don't finish iterating over the slices.
+TEST_F(LuaBufferWrapperTest, DontFinishSlicesIteration) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      iterator = object:slices()
+      pointer, length = iterator()
+      iterator2 = object:slices()
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data;
+  data.appendSliceForTest("hello ");
+  data.appendSliceForTest("world");
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_THROW_WITH_MESSAGE(
+      start("callMe"), LuaException,
+      "[string \"...\"]:5: cannot create a second iterator before completing the first");
+}
+
 // Basic methods test for the metadata wrapper.
 TEST_F(LuaMetadataMapWrapperTest, Methods) {
   const std::string SCRIPT{R"EOF(
@@ -0,0 +1,156 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Compares evaluating every policy in order, as the engine did before, with evaluating the
+// candidates found through the policy index.
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+
+#include "common/network/utility.h"
+#include "common/stream_info/stream_info_impl.h"
+
+#include "extensions/filters/common/rbac/engine_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+// A mix of remote IP, exact header and path prefix policies, with one unindexed metadata policy
+// in every 100.
+static envoy::config::rbac::v3::RBAC policies(int count) {
+  envoy::config::rbac::v3::RBAC rbac;
+  rbac.set_action(envoy::config::rbac::v3::RBAC::ALLOW);
+  for (int i = 0; i < count; i++) {
+    envoy::config::rbac::v3::Policy& policy =
+        (*rbac.mutable_policies())[fmt::format("policy-{:05}", i)];
+    auto* permission = policy.add_permissions();
+    auto* principal = policy.add_principals();
+    if (i % 100 == 99) {
+      auto* metadata = permission->mutable_metadata();
+      metadata->set_filter("envoy.filters.http.rbac");
+      metadata->add_path()->set_key("tenant");
+      metadata->mutable_value()->mutable_string_match()->set_exact(absl::StrCat("tenant-", i));
+      principal->set_any(true);
+      continue;
+    }
+    switch (i % 3) {
+    case 0: {
+      permission->set_any(true);
+      auto* range = principal->mutable_remote_ip();
+      range->set_address_prefix(fmt::format("10.{}.{}.0", (i / 256) % 256, i % 256));
+      range->mutable_prefix_len()->set_value(24);
+      break;
+    }
+    case 1: {
+      auto* header = permission->mutable_header();
+      header->set_name("x-tenant");
+      header->set_exact_match(absl::StrCat("tenant-", i));
+      principal->set_any(true);
+      break;
+    }
+    case 2:
+      permission->mutable_url_path()->mutable_path()->set_prefix(
+          absl::StrCat("/service-", i, "/"));
+      principal->set_any(true);
+      break;
+    }
+  }
+  return rbac;
+}
+
+// The path of a request which matches the last path prefix policy, so that the policies before it
+// are all evaluated by a linear scan.
+static std::string lastPolicyPath(int count) {
+  int last = count - 1;
+  while (last % 3 != 2 || last % 100 == 99) {
+    last--;
+  }
+  return fmt::format("/service-{}/users?id=1", last);
+}
+
+class RbacPerf {
+public:
+  RbacPerf(int count)
+      : rbac_(policies(count)), info_(time_system_),
+        headers_{{":method", "GET"},
+                 {":path", lastPolicyPath(count)},
+                 {":authority", "example.com"},
+                 {"x-tenant", "unknown"}} {
+    info_.setDownstreamRemoteAddress(
+        Network::Utility::parseInternetAddress("192.168.0.1", 1234, false));
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  const envoy::config::rbac::v3::RBAC rbac_;
+  StreamInfo::StreamInfoImpl info_;
+  testing::NiceMock<Network::MockConnection> connection_;
+  Http::TestRequestHeaderMapImpl headers_;
+};
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
+
+using Envoy::Extensions::Filters::Common::RBAC::PolicyMatcher;
+using Envoy::Extensions::Filters::Common::RBAC::RbacPerf;
+using Envoy::Extensions::Filters::Common::RBAC::RoleBasedAccessControlEngineImpl;
+
+// Tests evaluating every policy in order, until one matches.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_LinearScan(benchmark::State& state) {
+  RbacPerf context(state.range(0));
+  std::map<std::string, std::unique_ptr<PolicyMatcher>> policies;
+  for (const auto& policy : context.rbac_.policies()) {
+    policies.emplace(policy.first, std::make_unique<PolicyMatcher>(policy.second, nullptr));
+  }
+  for (auto _ : state) {
+    bool matched = false;
+    for (const auto& policy : policies) {
+      if (policy.second->matches(context.connection_, context.headers_, context.info_)) {
+        matched = true;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(matched);
+  }
+}
+BENCHMARK(BM_LinearScan)->Arg(20)->Arg(200)->Arg(2000);
+
+// Tests the engine, which evaluates the candidates found through the policy index.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_Engine(benchmark::State& state) {
+  RbacPerf context(state.range(0));
+  RoleBasedAccessControlEngineImpl engine(context.rbac_);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        engine.handleAction(context.connection_, context.headers_, context.info_, nullptr));
+  }
+}
+BENCHMARK(BM_Engine)->Arg(20)->Arg(200)->Arg(2000);
+
+// Tests compiling the policies into the engine, as on each configuration update.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CompileEngine(benchmark::State& state) {
+  RbacPerf context(state.range(0));
+  for (auto _ : state) {
+    RoleBasedAccessControlEngineImpl engine(context.rbac_);
+    benchmark::DoNotOptimize(&engine);
+  }
+}
+BENCHMARK(BM_CompileEngine)->Arg(2000)->Unit(benchmark::kMillisecond);
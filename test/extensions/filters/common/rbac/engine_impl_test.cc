@@ -208,6 +208,38 @@ TEST(RoleBasedAccessControlEngineImpl, DeniedDenylist) {
   checkEngine(engine, true, LogResult::Undecided, info, conn, headers);
 }
 
+// Policies found through the index and policies always evaluated keep the order of their names.
+TEST(RoleBasedAccessControlEngineImpl, IndexedPoliciesOrder) {
+  envoy::config::rbac::v3::RBAC rbac = TestUtility::parseYaml<envoy::config::rbac::v3::RBAC>(R"EOF(
+action: ALLOW
+policies:
+  a:
+    permissions:
+    - metadata: {filter: foo, path: [{key: bar}], value: {string_match: {exact: baz}}}
+    principals: [{any: true}]
+  b:
+    permissions: [{header: {name: x-tenant, exact_match: blue}}]
+    principals: [{any: true}]
+  c:
+    permissions: [{any: true}]
+    principals: [{any: true}]
+  d:
+    permissions: [{header: {name: x-tenant, exact_match: red}}]
+    principals: [{any: true}]
+)EOF");
+  RBAC::RoleBasedAccessControlEngineImpl engine(rbac);
+
+  Envoy::Network::MockConnection conn;
+  NiceMock<StreamInfo::MockStreamInfo> info;
+  std::string effective_policy_id;
+  EXPECT_TRUE(engine.handleAction(conn, Envoy::Http::TestRequestHeaderMapImpl{{"x-tenant", "blue"}},
+                                  info, &effective_policy_id));
+  EXPECT_EQ("b", effective_policy_id);
+  EXPECT_TRUE(engine.handleAction(conn, Envoy::Http::TestRequestHeaderMapImpl{{"x-tenant", "red"}},
+                                  info, &effective_policy_id));
+  EXPECT_EQ("c", effective_policy_id);
+}
+
 TEST(RoleBasedAccessControlEngineImpl, BasicCondition) {
   envoy::config::rbac::v3::Policy policy;
   policy.add_permissions()->set_any(true);
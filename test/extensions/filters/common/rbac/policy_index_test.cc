@@ -0,0 +1,210 @@
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+
+#include "common/network/address_impl.h"
+#include "common/network/utility.h"
+
+#include "extensions/filters/common/rbac/policy_index.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+namespace {
+
+class PolicyIndexTest : public testing::Test {
+public:
+  void addPolicy(const std::string& yaml) {
+    policies_.push_back(TestUtility::parseYaml<envoy::config::rbac::v3::Policy>(yaml));
+  }
+
+  void build() {
+    std::vector<const envoy::config::rbac::v3::Policy*> policies;
+    for (const auto& policy : policies_) {
+      policies.push_back(&policy);
+    }
+    index_ = std::make_unique<PolicyIndex>(policies);
+  }
+
+  std::vector<size_t> candidates(const Http::RequestHeaderMap& headers) {
+    std::vector<size_t> result;
+    index_->candidates(connection_, headers, info_).forEach([&result](size_t policy) {
+      result.push_back(policy);
+      return true;
+    });
+    return result;
+  }
+
+  std::vector<size_t> candidates() { return candidates(Http::TestRequestHeaderMapImpl()); }
+
+  std::vector<envoy::config::rbac::v3::Policy> policies_;
+  std::unique_ptr<PolicyIndex> index_;
+  NiceMock<Network::MockConnection> connection_;
+  NiceMock<StreamInfo::MockStreamInfo> info_;
+};
+
+TEST_F(PolicyIndexTest, Cidr) {
+  addPolicy(R"EOF(
+permissions: [{any: true}]
+principals: [{source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{any: true}]
+principals:
+- source_ip: {address_prefix: 10.1.0.0, prefix_len: 16}
+- source_ip: {address_prefix: "2001:db8::", prefix_len: 32}
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{destination_ip: {address_prefix: 10.1.0.0, prefix_len: 16}}]
+principals: [{any: true}]
+)EOF");
+  build();
+  EXPECT_EQ(3, index_->indexedPolicies());
+
+  connection_.remote_address_ = Network::Utility::parseInternetAddress("10.1.2.3");
+  info_.downstream_local_address_ = Network::Utility::parseInternetAddress("192.168.0.1");
+  EXPECT_EQ(std::vector<size_t>({0, 1}), candidates());
+
+  connection_.remote_address_ = Network::Utility::parseInternetAddress("10.2.2.3");
+  EXPECT_EQ(std::vector<size_t>({0}), candidates());
+
+  connection_.remote_address_ = Network::Utility::parseInternetAddress("2001:db8::1");
+  info_.downstream_local_address_ = Network::Utility::parseInternetAddress("10.1.0.1");
+  EXPECT_EQ(std::vector<size_t>({1, 2}), candidates());
+
+  connection_.remote_address_ = std::make_shared<Network::Address::PipeInstance>("/foo");
+  info_.downstream_local_address_ = Network::Utility::parseInternetAddress("10.2.0.1");
+  EXPECT_EQ(std::vector<size_t>(), candidates());
+}
+
+TEST_F(PolicyIndexTest, Headers) {
+  addPolicy(R"EOF(
+permissions: [{header: {name: X-Tenant, exact_match: blue}}]
+principals: [{any: true}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{header: {name: x-tenant, exact_match: red}}]
+principals: [{any: true}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{header: {name: :authority, prefix_match: api.}}]
+principals: [{any: true}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{header: {name: x-tenant, exact_match: ""}}]
+principals: [{any: true}]
+)EOF");
+  build();
+  EXPECT_EQ(4, index_->indexedPolicies());
+
+  EXPECT_EQ(std::vector<size_t>({0, 3}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-tenant", "blue"}}));
+  EXPECT_EQ(std::vector<size_t>({1, 2, 3}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-tenant", "red"},
+                                                      {":authority", "api.example.com"}}));
+  EXPECT_EQ(std::vector<size_t>({3}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-tenant", "blu"}}));
+  // Only the first value is matched.
+  EXPECT_EQ(std::vector<size_t>({0, 3}), candidates(Http::TestRequestHeaderMapImpl{
+                                             {"x-tenant", "blue"}, {"x-tenant", "red"}}));
+  EXPECT_EQ(std::vector<size_t>(),
+            candidates(Http::TestRequestHeaderMapImpl{{":authority", "www.example.com"}}));
+}
+
+TEST_F(PolicyIndexTest, Paths) {
+  addPolicy(R"EOF(
+permissions: [{url_path: {path: {prefix: /api/}}}]
+principals: [{any: true}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{url_path: {path: {exact: /api/v1/users}}}]
+principals: [{any: true}]
+)EOF");
+  addPolicy(R"EOF(
+permissions: [{url_path: {path: {prefix: /API/, ignore_case: true}}}]
+principals: [{any: true}]
+)EOF");
+  build();
+  EXPECT_EQ(2, index_->indexedPolicies());
+
+  // Policies the index can't tell apart are candidates as well. The query string isn't matched.
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}),
+            candidates(Http::TestRequestHeaderMapImpl{{":path", "/api/v1/users?id=1"}}));
+  EXPECT_EQ(std::vector<size_t>({0, 2}),
+            candidates(Http::TestRequestHeaderMapImpl{{":path", "/api/v2/users"}}));
+  EXPECT_EQ(std::vector<size_t>({2}),
+            candidates(Http::TestRequestHeaderMapImpl{{":path", "/static?/api/"}}));
+  EXPECT_EQ(std::vector<size_t>({2}), candidates());
+}
+
+TEST_F(PolicyIndexTest, Composition) {
+  // The header is required in both alternative permissions.
+  addPolicy(R"EOF(
+permissions:
+- and_rules:
+    rules:
+    - destination_port: 80
+    - header: {name: x-tenant, exact_match: blue}
+- header: {name: x-tenant, exact_match: red}
+principals: [{any: true}]
+)EOF");
+  // A metadata permission can't be indexed, but the principals can.
+  addPolicy(R"EOF(
+permissions:
+- metadata: {filter: foo, path: [{key: bar}], value: {string_match: {exact: baz}}}
+principals:
+- or_ids:
+    ids:
+    - source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}
+    - header: {name: x-tenant, exact_match: green}
+)EOF");
+  // Neither can be indexed.
+  addPolicy(R"EOF(
+permissions:
+- header: {name: x-tenant, exact_match: blue}
+- not_rule: {header: {name: x-tenant, exact_match: red}}
+principals: [{authenticated: {}}]
+)EOF");
+  build();
+  EXPECT_EQ(2, index_->indexedPolicies());
+
+  connection_.remote_address_ = Network::Utility::parseInternetAddress("192.168.0.1");
+  EXPECT_EQ(std::vector<size_t>({0, 2}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-tenant", "blue"}}));
+  EXPECT_EQ(std::vector<size_t>({1, 2}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-tenant", "green"}}));
+  connection_.remote_address_ = Network::Utility::parseInternetAddress("10.0.0.1");
+  EXPECT_EQ(std::vector<size_t>({1, 2}), candidates());
+}
+
+TEST_F(PolicyIndexTest, ManyPolicies) {
+  for (int i = 0; i < 200; i++) {
+    addPolicy(fmt::format(R"EOF(
+permissions: [{{header: {{name: x-id, exact_match: "{}"}}}}]
+principals: [{{any: true}}]
+)EOF",
+                          i));
+  }
+  build();
+
+  EXPECT_EQ(std::vector<size_t>({150}),
+            candidates(Http::TestRequestHeaderMapImpl{{"x-id", "150"}}));
+  EXPECT_EQ(std::vector<size_t>({63}), candidates(Http::TestRequestHeaderMapImpl{{"x-id", "63"}}));
+  EXPECT_EQ(std::vector<size_t>({64}), candidates(Http::TestRequestHeaderMapImpl{{"x-id", "64"}}));
+}
+
+} // namespace
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
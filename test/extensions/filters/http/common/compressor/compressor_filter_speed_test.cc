@@ -1,15 +1,26 @@
+#include <algorithm>
+#include <chrono>
+
 #include "envoy/extensions/filters/http/compressor/v3/compressor.pb.h"
 
+#include "common/thread_local/thread_local_impl.h"
+
+#include "extensions/compression/brotli/compressor/brotli_compressor_impl.h"
 #include "extensions/compression/gzip/compressor/zlib_compressor_impl.h"
+#include "extensions/compression/zstd/compressor/zstd_compressor_impl.h"
+#include "extensions/filters/http/common/compressor/compression_thread_pool.h"
 #include "extensions/filters/http/common/compressor/compressor.h"
 
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/test_common/utility.h"
 
+#include "absl/strings/str_cat.h"
 #include "benchmark/benchmark.h"
 #include "gmock/gmock.h"
 
+using testing::_;
 using testing::Return;
 
 namespace Envoy {
@@ -18,30 +29,24 @@ namespace HttpFilters {
 namespace Common {
 namespace Compressors {
 
+using CompressorCreateCb = std::function<Envoy::Compression::Compressor::CompressorPtr()>;
+
 class MockCompressorFilterConfig : public CompressorFilterConfig {
 public:
   MockCompressorFilterConfig(
       const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
       const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-      const std::string& compressor_name,
-      Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel level,
-      Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy strategy,
-      int64_t window_bits, uint64_t memory_level)
+      const std::string& compressor_name, CompressorCreateCb create_compressor,
+      CompressionThreadPoolSharedPtr offload_pool = nullptr)
       : CompressorFilterConfig(compressor, stats_prefix + compressor_name + ".", scope, runtime,
-                               compressor_name),
-        level_(level), strategy_(strategy), window_bits_(window_bits), memory_level_(memory_level) {
-  }
+                               compressor_name, std::move(offload_pool)),
+        create_compressor_(std::move(create_compressor)) {}
 
   Envoy::Compression::Compressor::CompressorPtr makeCompressor() override {
-    auto compressor = std::make_unique<Compression::Gzip::Compressor::ZlibCompressorImpl>();
-    compressor->init(level_, strategy_, window_bits_, memory_level_);
-    return compressor;
+    return create_compressor_();
   }
 
-  const Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel level_;
-  const Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy strategy_;
-  const int64_t window_bits_;
-  const uint64_t memory_level_;
+  const CompressorCreateCb create_compressor_;
 };
 
 using CompressionParams =
@@ -88,7 +93,8 @@ struct Result {
   uint64_t total_compressed_bytes = 0;
 };
 
-static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionParams params,
+static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks,
+                           const std::string& compressor_name, CompressorCreateCb create_compressor,
                            NiceMock<Http::MockStreamDecoderFilterCallbacks>& decoder_callbacks,
                            benchmark::State& state) {
   auto start = std::chrono::high_resolution_clock::now();
@@ -96,12 +102,8 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
   testing::NiceMock<Runtime::MockLoader> runtime;
   envoy::extensions::filters::http::compressor::v3::Compressor compressor;
 
-  const auto level = std::get<0>(params);
-  const auto strategy = std::get<1>(params);
-  const auto window_bits = std::get<2>(params);
-  const auto memory_level = std::get<3>(params);
   CompressorFilterConfigSharedPtr config = std::make_shared<MockCompressorFilterConfig>(
-      compressor, "test.", stats, runtime, "gzip", level, strategy, window_bits, memory_level);
+      compressor, "test.", stats, runtime, compressor_name, std::move(create_compressor));
 
   ON_CALL(runtime.snapshot_, featureEnabled("test.filter_enabled", 100))
       .WillByDefault(Return(true));
@@ -109,7 +111,8 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
   auto filter = std::make_unique<CompressorFilter>(config);
   filter->setDecoderFilterCallbacks(decoder_callbacks);
 
-  Http::TestRequestHeaderMapImpl headers = {{":method", "get"}, {"accept-encoding", "gzip"}};
+  Http::TestRequestHeaderMapImpl headers = {{":method", "get"},
+                                            {"accept-encoding", compressor_name}};
   filter->decodeHeaders(headers, false);
 
   Http::TestResponseHeaderMapImpl response_headers = {
@@ -133,12 +136,13 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
     ++idx;
   }
 
+  const std::string prefix = "test." + compressor_name + ".";
   EXPECT_EQ(res.total_uncompressed_bytes,
-            stats.counterFromString("test.gzip.total_uncompressed_bytes").value());
+            stats.counterFromString(prefix + "total_uncompressed_bytes").value());
   EXPECT_EQ(res.total_compressed_bytes,
-            stats.counterFromString("test.gzip.total_compressed_bytes").value());
+            stats.counterFromString(prefix + "total_compressed_bytes").value());
 
-  EXPECT_EQ(1U, stats.counterFromString("test.gzip.compressed").value());
+  EXPECT_EQ(1U, stats.counterFromString(prefix + "compressed").value());
   auto end = std::chrono::high_resolution_clock::now();
   const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
   state.SetIterationTime(elapsed.count());
@@ -146,6 +150,20 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
   return res;
 }
 
+static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionParams params,
+                           NiceMock<Http::MockStreamDecoderFilterCallbacks>& decoder_callbacks,
+                           benchmark::State& state) {
+  return compressWith(
+      std::move(chunks), "gzip",
+      [params]() {
+        auto compressor = std::make_unique<Compression::Gzip::Compressor::ZlibCompressorImpl>();
+        compressor->init(std::get<0>(params), std::get<1>(params), std::get<2>(params),
+                         std::get<3>(params));
+        return compressor;
+      },
+      decoder_callbacks, state);
+}
+
 // SPELLCHECKER(off)
 /*
 Running ./bazel-bin/test/extensions/filters/http/common/compressor/compressor_filter_speed_test
@@ -286,6 +304,173 @@ static void compressChunks1024(benchmark::State& state) {
 }
 BENCHMARK(compressChunks1024)->DenseRange(0, 8, 1)->UseManualTime()->Unit(benchmark::kMillisecond);
 
+// Compares the algorithms at the levels commonly used for dynamic content, on JSON documents
+// rather than random characters, reporting the compression ratio along with the throughput.
+static Buffer::OwnedImpl generateJsonTestData() {
+  Buffer::OwnedImpl data;
+  for (uint64_t i = 0; data.length() < TestDataSize; ++i) {
+    data.add(absl::StrCat(R"({"id":)", i, R"(,"name":"user-)", i * 7919 % 1000,
+                          R"(","roles":["reader","writer"],"active":)",
+                          i % 2 == 0 ? "true" : "false", "}\n"));
+  }
+  return data;
+}
+
+static std::vector<std::pair<std::string, CompressorCreateCb>> algorithms = {
+    {"gzip",
+     []() {
+       auto compressor = std::make_unique<Compression::Gzip::Compressor::ZlibCompressorImpl>();
+       compressor->init(
+           Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+           Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 15, 8);
+       return compressor;
+     }},
+    {"br",
+     []() {
+       return std::make_unique<Compression::Brotli::Compressor::BrotliCompressorImpl>(
+           3, 18, 24, false,
+           Compression::Brotli::Compressor::BrotliCompressorImpl::EncoderMode::Text, 4096);
+     }},
+    {"zstd", []() {
+       // A single context, reused across iterations as a worker reuses the contexts of its pool.
+       static auto pool = std::make_shared<Compression::Zstd::Compressor::CompressorContextPool>(
+           []() {
+             Compression::Zstd::Compressor::CompressorContextPool::ContextPtr context(
+                 ZSTD_createCCtx());
+             ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, 3);
+             return context;
+           },
+           1);
+       return std::make_unique<Compression::Zstd::Compressor::ZstdCompressorImpl>(pool, 4096);
+     }}};
+
+static void compressJsonChunks4096(benchmark::State& state) {
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  const auto& algorithm = algorithms[state.range(0)];
+  const Buffer::OwnedImpl json = generateJsonTestData();
+
+  Result res;
+  for (auto _ : state) {
+    std::vector<Buffer::OwnedImpl> chunks;
+    for (uint64_t offset = 0; offset < TestDataSize; offset += 4096) {
+      Buffer::OwnedImpl chunk;
+      std::unique_ptr<char[]> data(new char[4096]);
+      json.copyOut(offset, 4096, data.get());
+      chunk.add(absl::string_view(data.get(), 4096));
+      chunks.push_back(std::move(chunk));
+    }
+    res = compressWith(std::move(chunks), algorithm.first, algorithm.second, decoder_callbacks,
+                       state);
+  }
+  state.SetLabel(algorithm.first);
+  state.SetBytesProcessed(state.iterations() * res.total_uncompressed_bytes);
+  state.counters["ratio"] =
+      static_cast<double>(res.total_uncompressed_bytes) / res.total_compressed_bytes;
+}
+BENCHMARK(compressJsonChunks4096)
+    ->DenseRange(0, 2, 1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Measures how long small requests served by the same worker wait while a large response is
+// compressed at the best level, either on the worker thread (0) or on a helper thread (1). A
+// callback standing for a small request is posted to the dispatcher before each chunk of the
+// large response is passed to the filter, and its latency is reported in percentiles.
+static void compressLargeWithSmallRequests(benchmark::State& state) {
+  const bool offload = state.range(0) == 1;
+  Api::ApiPtr api = Api::createApiForTest();
+  Event::DispatcherPtr dispatcher = api->allocateDispatcher("test_thread");
+  ThreadLocal::InstanceImpl tls;
+  tls.registerThread(*dispatcher, true);
+  Stats::IsolatedStoreImpl stats;
+  CompressionThreadPoolSharedPtr pool;
+  if (offload) {
+    pool = std::make_shared<CompressionThreadPool>(api->threadFactory(), tls, stats);
+    pool->reserveThreads(1);
+  }
+  testing::NiceMock<Runtime::MockLoader> runtime;
+  ON_CALL(runtime.snapshot_, featureEnabled("test.filter_enabled", 100))
+      .WillByDefault(Return(true));
+
+  envoy::extensions::filters::http::compressor::v3::Compressor compressor;
+  compressor.mutable_offload()->mutable_min_body_size()->set_value(0);
+  CompressorFilterConfigSharedPtr config = std::make_shared<MockCompressorFilterConfig>(
+      compressor, "test.", stats, runtime, "gzip",
+      []() {
+        auto compressor = std::make_unique<Compression::Gzip::Compressor::ZlibCompressorImpl>();
+        compressor->init(
+            Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel::Best,
+            Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 15, 9);
+        return compressor;
+      },
+      pool);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks;
+  ON_CALL(encoder_callbacks, dispatcher()).WillByDefault(testing::ReturnRef(*dispatcher));
+  ON_CALL(encoder_callbacks, injectEncodedDataToFilterChain(_, _))
+      .WillByDefault(testing::Invoke([&dispatcher](Buffer::Instance& data, bool end_stream) {
+        data.drain(data.length());
+        if (end_stream) {
+          dispatcher->exit();
+        }
+      }));
+
+  std::vector<std::chrono::nanoseconds> latencies;
+  for (auto _ : state) {
+    // 1 MiB, in chunks of 16 KiB.
+    std::vector<Buffer::OwnedImpl> chunks;
+    for (uint64_t i = 0; i < 64; ++i) {
+      Buffer::OwnedImpl chunk;
+      std::unique_ptr<char[]> data(new char[16384]);
+      testData().copyOut((i % 7) * 16384, 16384, data.get());
+      chunk.add(absl::string_view(data.get(), 16384));
+      chunks.push_back(std::move(chunk));
+    }
+
+    auto filter = std::make_unique<CompressorFilter>(config);
+    filter->setDecoderFilterCallbacks(decoder_callbacks);
+    filter->setEncoderFilterCallbacks(encoder_callbacks);
+    Http::TestRequestHeaderMapImpl headers = {{":method", "get"}, {"accept-encoding", "gzip"}};
+    filter->decodeHeaders(headers, false);
+    Http::TestResponseHeaderMapImpl response_headers = {
+        {":method", "get"},
+        {"content-length", "1048576"},
+        {"content-type", "application/json;charset=utf-8"}};
+    filter->encodeHeaders(response_headers, false);
+
+    for (uint64_t i = 0; i < chunks.size(); ++i) {
+      const MonotonicTime posted = api->timeSource().monotonicTime();
+      dispatcher->post([&latencies, &api, posted]() {
+        latencies.push_back(api->timeSource().monotonicTime() - posted);
+      });
+      filter->encodeData(chunks[i], i == chunks.size() - 1);
+      dispatcher->run(Event::Dispatcher::RunType::NonBlock);
+    }
+    if (offload) {
+      // Waits for the end of the body.
+      dispatcher->run(Event::Dispatcher::RunType::RunUntilExit);
+    }
+    filter->onDestroy();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](double p) {
+    return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+               latencies[static_cast<size_t>(p * (latencies.size() - 1))])
+        .count();
+  };
+  state.counters["small_request_p50_us"] = percentile(0.5);
+  state.counters["small_request_p99_us"] = percentile(0.99);
+  state.counters["small_request_max_us"] = percentile(1);
+
+  config.reset();
+  pool.reset();
+  tls.shutdownGlobalThreading();
+  tls.shutdownThread();
+}
+BENCHMARK(compressLargeWithSmallRequests)->DenseRange(0, 1, 1)->Unit(benchmark::kMillisecond);
+
 } // namespace Compressors
 } // namespace Common
 } // namespace HttpFilters
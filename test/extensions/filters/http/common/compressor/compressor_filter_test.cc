@@ -3,6 +3,7 @@
 #include "envoy/extensions/filters/http/compressor/v3/compressor.pb.h"
 
 #include "common/protobuf/utility.h"
+#include "common/thread_local/thread_local_impl.h"
 
 #include "extensions/filters/http/common/compressor/compressor.h"
 
@@ -13,6 +14,8 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/ascii.h"
+#include "absl/synchronization/notification.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -22,7 +25,9 @@ namespace Common {
 namespace Compressors {
 
 using testing::_;
+using testing::Invoke;
 using testing::Return;
+using testing::ReturnRef;
 
 class TestCompressorFilterConfig : public CompressorFilterConfig {
 public:
@@ -1057,6 +1062,448 @@ TEST_F(CompressorFilterTest, RemoveAcceptEncodingHeader) {
   }
 }
 
+// Compressor which upper cases the data, and marks the end of the stream with a '$'. It runs the
+// hook before compressing, which the tests use to keep a chunk in flight.
+class UpperCaseCompressor : public Envoy::Compression::Compressor::Compressor {
+public:
+  explicit UpperCaseCompressor(std::function<void()> hook) : hook_(std::move(hook)) {}
+
+  void compress(Buffer::Instance& buffer, Envoy::Compression::Compressor::State state) override {
+    hook_();
+    const std::string data = absl::AsciiStrToUpper(buffer.toString());
+    buffer.drain(buffer.length());
+    buffer.add(data);
+    if (state == Envoy::Compression::Compressor::State::Finish) {
+      buffer.add("$");
+    }
+  }
+
+private:
+  const std::function<void()> hook_;
+};
+
+class OffloadCompressorFilterConfig : public CompressorFilterConfig {
+public:
+  OffloadCompressorFilterConfig(
+      const envoy::extensions::filters::http::compressor::v3::Compressor& compressor,
+      Stats::Scope& scope, Runtime::Loader& runtime, CompressionThreadPoolSharedPtr pool,
+      std::function<void()> hook)
+      : CompressorFilterConfig(compressor, "test.test.", scope, runtime, "test", std::move(pool)),
+        hook_(std::move(hook)) {}
+
+  Envoy::Compression::Compressor::CompressorPtr makeCompressor() override {
+    return std::make_unique<UpperCaseCompressor>(hook_);
+  }
+
+private:
+  const std::function<void()> hook_;
+};
+
+class CompressorFilterOffloadTest : public testing::Test {
+protected:
+  CompressorFilterOffloadTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")) {
+    ON_CALL(runtime_.snapshot_, featureEnabled("test.filter_enabled", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(encoder_callbacks_, dispatcher()).WillByDefault(ReturnRef(*dispatcher_));
+    tls_.registerThread(*dispatcher_, true);
+  }
+
+  ~CompressorFilterOffloadTest() override {
+    filter_.reset();
+    config_.reset();
+    shutdownThread();
+  }
+
+  void setUpFilter(uint32_t max_queued_jobs = 8) {
+    envoy::extensions::filters::http::compressor::v3::Compressor compressor;
+    compressor.mutable_offload()->mutable_min_body_size()->set_value(10);
+    compressor.mutable_offload()->mutable_max_queued_jobs()->set_value(max_queued_jobs);
+    auto pool = std::make_shared<CompressionThreadPool>(api_->threadFactory(), tls_, stats_);
+    pool->reserveThreads(1);
+    config_ = std::make_shared<OffloadCompressorFilterConfig>(
+        compressor, stats_, runtime_, std::move(pool), [this]() {
+          if (block_) {
+            block_ = false;
+            release_.WaitForNotification();
+          }
+        });
+    filter_ = std::make_unique<CompressorFilter>(config_);
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+
+    Http::TestRequestHeaderMapImpl request_headers{{":method", "get"},
+                                                   {"accept-encoding", "deflate, test"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+    Http::TestResponseHeaderMapImpl headers{{":method", "get"}, {"content-length", "256"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ("test", headers.get_("content-encoding"));
+  }
+
+  Http::FilterDataStatus encodeData(const std::string& data, bool end_stream) {
+    Buffer::OwnedImpl buffer(data);
+    const Http::FilterDataStatus status = filter_->encodeData(buffer, end_stream);
+    if (status == Http::FilterDataStatus::StopIterationNoBuffer) {
+      EXPECT_EQ(0, buffer.length());
+    } else {
+      continued_data_ += buffer.toString();
+    }
+    return status;
+  }
+
+  // Runs the dispatcher until the next chunk is injected into the filter chain.
+  void expectInjected(const std::string& data, bool end_stream) {
+    EXPECT_CALL(encoder_callbacks_, injectEncodedDataToFilterChain(_, end_stream))
+        .WillOnce(Invoke([this, data](Buffer::Instance& buffer, bool) {
+          EXPECT_EQ(data, buffer.toString());
+          buffer.drain(buffer.length());
+          dispatcher_->exit();
+        }));
+    dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  }
+
+  // Waits until the jobs queued so far have run and posted their results to the dispatcher, and
+  // runs the dispatcher until the results are handled.
+  void drainPool() {
+    config_->offloadPool()->post(
+        [this]() -> Event::PostCb { return [this]() { dispatcher_->exit(); }; }, 8);
+    dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  }
+
+  // Shuts down the thread local storage of the test thread, as when a worker exits.
+  void shutdownThread() {
+    if (!tls_shut_down_) {
+      tls_shut_down_ = true;
+      tls_.shutdownGlobalThreading();
+      tls_.shutdownThread();
+    }
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  ThreadLocal::InstanceImpl tls_;
+  bool tls_shut_down_{};
+  Stats::TestUtil::TestStore stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  std::atomic<bool> block_{};
+  absl::Notification release_;
+  std::shared_ptr<OffloadCompressorFilterConfig> config_;
+  std::unique_ptr<CompressorFilter> filter_;
+  std::string continued_data_;
+};
+
+// Verifies that the body is compressed on the worker thread until it reaches the minimum size,
+// and on the helper threads afterwards.
+TEST_F(CompressorFilterOffloadTest, OffloadLargeBody) {
+  setUpFilter();
+  EXPECT_EQ(Http::FilterDataStatus::Continue, encodeData("small", false));
+  EXPECT_EQ("SMALL", continued_data_);
+
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("large body", false));
+  expectInjected("LARGE BODY", false);
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("end", true));
+  expectInjected("END$", true);
+
+  EXPECT_EQ(2, stats_.counter("test.test.offload_jobs").value());
+  EXPECT_EQ(18, stats_.counter("test.test.total_uncompressed_bytes").value());
+  EXPECT_EQ(19, stats_.counter("test.test.total_compressed_bytes").value());
+  EXPECT_EQ(0, stats_
+                   .gauge("compressor_thread_pool.queue_size",
+                          Stats::Gauge::ImportMode::NeverImport)
+                   .value());
+  filter_->onDestroy();
+}
+
+// Verifies that the data received while a chunk is in flight is buffered, pushing back on the
+// upstream over the buffer limit, and that the trailers wait for the end of the body.
+TEST_F(CompressorFilterOffloadTest, BufferWhileInFlight) {
+  setUpFilter();
+  ON_CALL(encoder_callbacks_, encoderBufferLimit()).WillByDefault(Return(8));
+  block_ = true;
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("first chunk", false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("second", false));
+  EXPECT_CALL(encoder_callbacks_, onEncoderFilterAboveWriteBufferHighWatermark());
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData(" chunk", false));
+
+  Http::TestResponseTrailerMapImpl trailers;
+  EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_->encodeTrailers(trailers));
+
+  // Once the first chunk is back, the pending data is compressed along with the end of the body.
+  EXPECT_CALL(encoder_callbacks_, onEncoderFilterBelowWriteBufferLowWatermark());
+  release_.Notify();
+  expectInjected("FIRST CHUNK", false);
+
+  EXPECT_CALL(encoder_callbacks_, continueEncoding()).WillOnce(Invoke([this]() {
+    dispatcher_->exit();
+  }));
+  EXPECT_CALL(encoder_callbacks_, injectEncodedDataToFilterChain(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& buffer, bool) {
+        EXPECT_EQ("SECOND CHUNK$", buffer.toString());
+        buffer.drain(buffer.length());
+      }));
+  dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  EXPECT_EQ(2, stats_.counter("test.test.offload_jobs").value());
+  filter_->onDestroy();
+}
+
+// Verifies that no chunk is compressed while the downstream is backed up.
+TEST_F(CompressorFilterOffloadTest, DownstreamWatermarks) {
+  setUpFilter();
+  block_ = true;
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("first chunk", false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("second chunk", true));
+  filter_->onAboveWriteBufferHighWatermark();
+  release_.Notify();
+  expectInjected("FIRST CHUNK", false);
+  drainPool();
+  EXPECT_EQ(1, stats_.counter("test.test.offload_jobs").value());
+
+  filter_->onBelowWriteBufferLowWatermark();
+  expectInjected("SECOND CHUNK$", true);
+  filter_->onDestroy();
+}
+
+// Verifies that the data is compressed on the worker thread when the queue is full.
+TEST_F(CompressorFilterOffloadTest, QueueFull) {
+  setUpFilter(1);
+  absl::Notification running;
+  absl::Notification release;
+  EXPECT_TRUE(config_->offloadPool()->post(
+      [&]() -> Event::PostCb {
+        running.Notify();
+        release.WaitForNotification();
+        return []() {};
+      },
+      1));
+  running.WaitForNotification();
+  absl::Notification queued_job_done;
+  EXPECT_TRUE(config_->offloadPool()->post(
+      [&]() -> Event::PostCb {
+        queued_job_done.Notify();
+        return []() {};
+      },
+      1));
+
+  EXPECT_EQ(Http::FilterDataStatus::Continue, encodeData("large body", false));
+  EXPECT_EQ("LARGE BODY", continued_data_);
+  EXPECT_EQ(1, stats_.counter("test.test.offload_queue_full").value());
+
+  release.Notify();
+  queued_job_done.WaitForNotification();
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("end", true));
+  expectInjected("END$", true);
+  filter_->onDestroy();
+}
+
+// Verifies that the result of a chunk in flight when the stream is destroyed is dropped.
+TEST_F(CompressorFilterOffloadTest, DestroyedWhileInFlight) {
+  setUpFilter();
+  block_ = true;
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, encodeData("large body", true));
+  filter_->onDestroy();
+  filter_.reset();
+
+  EXPECT_CALL(encoder_callbacks_, injectEncodedDataToFilterChain(_, _)).Times(0);
+  release_.Notify();
+  drainPool();
+}
+
+// Verifies that the results of the jobs queued by a thread are dropped once the thread is shut
+// down, instead of being posted to its dispatcher.
+TEST_F(CompressorFilterOffloadTest, ThreadShutDownWhileInFlight) {
+  setUpFilter();
+  absl::Notification running;
+  absl::Notification release;
+  bool callback_run = false;
+  EXPECT_TRUE(config_->offloadPool()->post(
+      [&]() -> Event::PostCb {
+        running.Notify();
+        release.WaitForNotification();
+        return [&callback_run]() { callback_run = true; };
+      },
+      8));
+  running.WaitForNotification();
+  shutdownThread();
+  release.Notify();
+
+  // The pool joins its thread on destruction, so the job is done once the pool is gone.
+  filter_.reset();
+  config_.reset();
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(callback_run);
+}
+
+// Verifies that the pool only grows, and up to the maximum number of threads.
+TEST_F(CompressorFilterOffloadTest, ReserveThreads) {
+  CompressionThreadPool pool(api_->threadFactory(), tls_, stats_);
+  pool.reserveThreads(2);
+  pool.reserveThreads(1);
+  EXPECT_EQ(2, stats_
+                   .gauge("compressor_thread_pool.threads", Stats::Gauge::ImportMode::NeverImport)
+                   .value());
+  pool.reserveThreads(CompressionThreadPool::MaxThreads + 1);
+  EXPECT_EQ(CompressionThreadPool::MaxThreads,
+            stats_.gauge("compressor_thread_pool.threads", Stats::Gauge::ImportMode::NeverImport)
+                .value());
+}
+
+class CompressorFilterResponseCacheTest : public testing::Test {
+protected:
+  CompressorFilterResponseCacheTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("test.filter_enabled", 100))
+        .WillByDefault(Return(true));
+    envoy::extensions::filters::http::compressor::v3::Compressor compressor;
+    compressor.mutable_content_length()->set_value(1);
+    compressor.mutable_response_cache()->mutable_max_body_size()->set_value(16);
+    config_ = std::make_shared<OffloadCompressorFilterConfig>(compressor, stats_, runtime_, nullptr,
+                                                              [this]() { ++compress_calls_; });
+  }
+
+  // Starts a response with the given Content-Length, or a chunked one if there is none.
+  void startResponse(CompressorFilter& filter, const std::string& path, const std::string& status,
+                     const std::string& etag, absl::optional<uint64_t> content_length) {
+    filter.setDecoderFilterCallbacks(decoder_callbacks_);
+    filter.setEncoderFilterCallbacks(encoder_callbacks_);
+    Http::TestRequestHeaderMapImpl request_headers{
+        {":method", "get"}, {":authority", "host"}, {":path", path}, {"accept-encoding", "test"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter.decodeHeaders(request_headers, false));
+    Http::TestResponseHeaderMapImpl headers{{":status", status}};
+    if (content_length.has_value()) {
+      headers.setContentLength(content_length.value());
+    } else {
+      headers.addCopy("transfer-encoding", "chunked");
+    }
+    if (!etag.empty()) {
+      headers.addCopy("etag", etag);
+    }
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter.encodeHeaders(headers, false));
+    EXPECT_EQ("test", headers.get_("content-encoding"));
+  }
+
+  // Sends a response through a new filter, and returns the data it passes on.
+  std::string respond(const std::vector<std::string>& chunks, const std::string& etag = "",
+                      const std::string& path = "/", const std::string& status = "200") {
+    CompressorFilter filter(config_);
+    uint64_t content_length = 0;
+    for (const std::string& chunk : chunks) {
+      content_length += chunk.size();
+    }
+    startResponse(filter, path, status, etag, content_length);
+    std::string output;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      Buffer::OwnedImpl buffer(chunks[i]);
+      if (filter.encodeData(buffer, i == chunks.size() - 1) ==
+          Http::FilterDataStatus::StopIterationNoBuffer) {
+        EXPECT_EQ(0, buffer.length());
+      }
+      output += buffer.toString();
+    }
+    filter.onDestroy();
+    return output;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_.counter("test.test." + name).value();
+  }
+
+  Stats::TestUtil::TestStore stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  std::shared_ptr<OffloadCompressorFilterConfig> config_;
+  uint32_t compress_calls_{};
+};
+
+// Verifies that a response with a strong ETag is compressed as it streams, and that the body of
+// the next response with the same ETag is replaced with the cached one.
+TEST_F(CompressorFilterResponseCacheTest, Etag) {
+  EXPECT_EQ("HELLO WORLD$", respond({"hello", " world"}, "\"v1\""));
+  EXPECT_EQ(2, compress_calls_);
+  EXPECT_EQ("HELLO WORLD$", respond({"ignored", " body"}, "\"v1\""));
+  EXPECT_EQ(2, compress_calls_);
+  EXPECT_EQ(1, counter("response_cache_hit"));
+
+  // The ETag only identifies the body for the same resource.
+  EXPECT_EQ("OTHER$", respond({"other"}, "\"v1\"", "/other"));
+  EXPECT_EQ("NEW$", respond({"new"}, "\"v2\""));
+  EXPECT_EQ(3, counter("response_cache_miss"));
+  EXPECT_EQ(3, counter("response_cache_insert"));
+}
+
+// Verifies that a response without a strong ETag is looked up by the hash of its body.
+TEST_F(CompressorFilterResponseCacheTest, BodyHash) {
+  EXPECT_EQ("HELLO WORLD$", respond({"hello", " world"}));
+  EXPECT_EQ(1, compress_calls_);
+  EXPECT_EQ("HELLO WORLD$", respond({"hello w", "orld"}, "W/\"weak\""));
+  EXPECT_EQ(1, compress_calls_);
+  EXPECT_EQ("OTHER$", respond({"other"}));
+  EXPECT_EQ(2, compress_calls_);
+
+  EXPECT_EQ(1, counter("response_cache_hit"));
+  EXPECT_EQ(27, counter("total_uncompressed_bytes"));
+  EXPECT_EQ(30, counter("total_compressed_bytes"));
+}
+
+// Verifies that the ETag of a partial response is not used as a key, as it identifies the full
+// body.
+TEST_F(CompressorFilterResponseCacheTest, PartialResponse) {
+  EXPECT_EQ("HELLO$", respond({"hello"}, "\"v1\""));
+  EXPECT_EQ("PART$", respond({"part"}, "\"v1\"", "/", "206"));
+  EXPECT_EQ(2, compress_calls_);
+}
+
+// Verifies that bodies larger than the maximum size are compressed as usual.
+TEST_F(CompressorFilterResponseCacheTest, LargeBody) {
+  EXPECT_EQ("ABCDEFGHIJKLMNOPQRSTEND$", respond({"abcdefghij", "klmnopqrst", "end"}));
+  EXPECT_EQ(3, compress_calls_);
+  EXPECT_EQ("ABCDEFGHIJKLMNOPQRST$", respond({"abcdefghij", "klmnopqrst"}, "\"v1\""));
+  EXPECT_EQ(5, compress_calls_);
+  EXPECT_EQ(0, counter("response_cache_insert"));
+  EXPECT_EQ(45, counter("total_compressed_bytes"));
+}
+
+// Verifies that a response without a Content-Length nor a strong ETag streams through uncached,
+// as its body may turn out to be too large to be cached only once it has been buffered.
+TEST_F(CompressorFilterResponseCacheTest, ChunkedBody) {
+  for (int i = 0; i < 2; ++i) {
+    CompressorFilter filter(config_);
+    startResponse(filter, "/", "200", "", absl::nullopt);
+    Buffer::OwnedImpl buffer("hello");
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter.encodeData(buffer, false));
+    EXPECT_EQ("HELLO", buffer.toString());
+    buffer.add(" world");
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter.encodeData(buffer, true));
+    EXPECT_EQ(" WORLD$", buffer.toString());
+    filter.onDestroy();
+  }
+  EXPECT_EQ(4, compress_calls_);
+  EXPECT_EQ(0, counter("response_cache_hit"));
+  EXPECT_EQ(0, counter("response_cache_insert"));
+}
+
+// Verifies that the cached body is added before the trailers.
+TEST_F(CompressorFilterResponseCacheTest, Trailers) {
+  EXPECT_EQ("HELLO$", respond({"hello"}, "\"v1\""));
+  EXPECT_EQ("HELLO$", respond({"hello"}));
+
+  for (const std::string etag : {"\"v1\"", ""}) {
+    CompressorFilter filter(config_);
+    startResponse(filter, "/", "200", etag, 5);
+    Buffer::OwnedImpl buffer("hello");
+    EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter.encodeData(buffer, false));
+    EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+        .WillOnce(Invoke(
+            [](Buffer::Instance& data, bool) { EXPECT_EQ("HELLO$", data.toString()); }));
+    Http::TestResponseTrailerMapImpl trailers;
+    EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter.encodeTrailers(trailers));
+    filter.onDestroy();
+  }
+  EXPECT_EQ(2, compress_calls_);
+  EXPECT_EQ(2, counter("response_cache_hit"));
+}
+
 } // namespace Compressors
 } // namespace Common
 } // namespace HttpFilters
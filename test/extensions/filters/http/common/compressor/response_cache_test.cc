@@ -0,0 +1,99 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/common/compressor/response_cache.h"
+
+#include "test/common/stats/stat_test_utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+namespace {
+
+class ResponseCacheTest : public testing::Test {
+protected:
+  uint64_t bytes() {
+    return stats_.gauge("test.response_cache_bytes", Stats::Gauge::ImportMode::NeverImport).value();
+  }
+
+  Stats::TestUtil::TestStore stats_;
+  ResponseCache cache_{10, "test.", stats_};
+};
+
+TEST_F(ResponseCacheTest, CachesBody) {
+  EXPECT_EQ(nullptr, cache_.lookup("key"));
+  cache_.insert("key", "body");
+
+  ResponseCache::Entry entry = cache_.lookup("key");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("body", *entry);
+  EXPECT_EQ(4, bytes());
+
+  // A body cached meanwhile by another stream is kept.
+  cache_.insert("key", "other");
+  EXPECT_EQ("body", *cache_.lookup("key"));
+
+  EXPECT_EQ(2, stats_.counter("test.response_cache_hit").value());
+  EXPECT_EQ(1, stats_.counter("test.response_cache_miss").value());
+  EXPECT_EQ(1, stats_.counter("test.response_cache_insert").value());
+}
+
+TEST_F(ResponseCacheTest, EvictsLeastRecentlyUsed) {
+  cache_.insert("a", "aaaa");
+  cache_.insert("b", "bbbb");
+  // Makes "b" the least recently used body.
+  EXPECT_NE(nullptr, cache_.lookup("a"));
+
+  cache_.insert("c", "cccc");
+  EXPECT_EQ(2U, cache_.size());
+  EXPECT_EQ(8, bytes());
+  EXPECT_NE(nullptr, cache_.lookup("a"));
+  EXPECT_EQ(nullptr, cache_.lookup("b"));
+  EXPECT_NE(nullptr, cache_.lookup("c"));
+
+  // Several bodies may be evicted to make room for a large one.
+  cache_.insert("d", "dddddddddd");
+  EXPECT_EQ(1U, cache_.size());
+  EXPECT_EQ(10, bytes());
+  EXPECT_EQ(3, stats_.counter("test.response_cache_evicted").value());
+}
+
+TEST_F(ResponseCacheTest, DoesNotCacheBodyLargerThanCache) {
+  cache_.insert("a", "aaaa");
+  cache_.insert("key", "larger than the cache");
+  EXPECT_EQ(nullptr, cache_.lookup("key"));
+  EXPECT_NE(nullptr, cache_.lookup("a"));
+  EXPECT_EQ(4, bytes());
+}
+
+// Verifies that a body added to a buffer is referenced rather than copied, and outlives its
+// eviction until the buffer is drained.
+TEST_F(ResponseCacheTest, AddToBufferReferencesBody) {
+  cache_.insert("a", "aaaaaaaa");
+  ResponseCache::Entry entry = cache_.lookup("a");
+
+  Buffer::OwnedImpl buffer("prefix ");
+  ResponseCache::addToBuffer(entry, buffer);
+  EXPECT_EQ("prefix aaaaaaaa", buffer.toString());
+  EXPECT_EQ(3, entry.use_count());
+
+  cache_.insert("b", "bbbb");
+  EXPECT_EQ(nullptr, cache_.lookup("a"));
+  EXPECT_EQ(2, entry.use_count());
+
+  buffer.drain(buffer.length());
+  EXPECT_EQ(1, entry.use_count());
+}
+
+} // namespace
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
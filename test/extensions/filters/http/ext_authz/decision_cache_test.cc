@@ -0,0 +1,163 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "extensions/filters/http/ext_authz/decision_cache.h"
+
+#include "test/test_common/simulated_time_system.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+namespace {
+
+using Filters::Common::ExtAuthz::CheckStatus;
+using Filters::Common::ExtAuthz::Response;
+using Filters::Common::ExtAuthz::ResponsePtr;
+
+class MockWaiter : public DecisionCache::Waiter {
+public:
+  void onComplete(ResponsePtr&& response) override { onComplete_(response); }
+
+  MOCK_METHOD(void, onComplete_, (ResponsePtr & response));
+  MOCK_METHOD(void, onCheckCancelled, ());
+};
+
+class DecisionCacheTest : public testing::Test {
+protected:
+  Response response(CheckStatus status) {
+    Response response{};
+    response.status = status;
+    response.headers_to_set = Http::HeaderVector{{Http::LowerCaseString{"x-user"}, "alice"}};
+    return response;
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  DecisionCache cache_{time_system_, 2};
+  MockWaiter sender_;
+};
+
+TEST_F(DecisionCacheTest, CachesDecisionUntilExpiry) {
+  EXPECT_EQ(nullptr, cache_.lookup("key"));
+
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+  cache_.complete("key", response(CheckStatus::Denied), std::chrono::seconds(10));
+
+  ResponsePtr cached = cache_.lookup("key");
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(CheckStatus::Denied, cached->status);
+  EXPECT_EQ("alice", cached->headers_to_set[0].second);
+
+  time_system_.advanceTimeWait(std::chrono::seconds(9));
+  EXPECT_NE(nullptr, cache_.lookup("key"));
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(nullptr, cache_.lookup("key"));
+  EXPECT_EQ(0U, cache_.size());
+
+  // The check is no longer in flight.
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+}
+
+TEST_F(DecisionCacheTest, DoesNotCacheErrorsOrZeroTtl) {
+  EXPECT_TRUE(cache_.startCheck("error", sender_));
+  cache_.complete("error", response(CheckStatus::Error), std::chrono::seconds(10));
+  EXPECT_EQ(nullptr, cache_.lookup("error"));
+
+  EXPECT_TRUE(cache_.startCheck("no_ttl", sender_));
+  cache_.complete("no_ttl", response(CheckStatus::OK), std::chrono::seconds(0));
+  EXPECT_EQ(nullptr, cache_.lookup("no_ttl"));
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(DecisionCacheTest, EvictsLeastRecentlyUsed) {
+  cache_.complete("a", response(CheckStatus::OK), std::chrono::seconds(10));
+  cache_.complete("b", response(CheckStatus::OK), std::chrono::seconds(10));
+  // Makes "b" the least recently used decision.
+  EXPECT_NE(nullptr, cache_.lookup("a"));
+
+  cache_.complete("c", response(CheckStatus::OK), std::chrono::seconds(10));
+  EXPECT_EQ(2U, cache_.size());
+  EXPECT_NE(nullptr, cache_.lookup("a"));
+  EXPECT_EQ(nullptr, cache_.lookup("b"));
+  EXPECT_NE(nullptr, cache_.lookup("c"));
+
+  // Completing a key again replaces its decision.
+  cache_.complete("a", response(CheckStatus::Denied), std::chrono::seconds(10));
+  EXPECT_EQ(2U, cache_.size());
+  EXPECT_EQ(CheckStatus::Denied, cache_.lookup("a")->status);
+}
+
+TEST_F(DecisionCacheTest, CompletesWaiters) {
+  MockWaiter waiter1;
+  MockWaiter waiter2;
+  MockWaiter removed;
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+  EXPECT_FALSE(cache_.startCheck("key", waiter1));
+  EXPECT_FALSE(cache_.startCheck("key", removed));
+  EXPECT_FALSE(cache_.startCheck("key", waiter2));
+  cache_.removeWaiter("key", removed);
+
+  // Errors are passed on to the waiters too.
+  EXPECT_CALL(removed, onComplete_(_)).Times(0);
+  EXPECT_CALL(waiter1, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::Error, response->status);
+  }));
+  EXPECT_CALL(waiter2, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::Error, response->status);
+  }));
+  cache_.complete("key", response(CheckStatus::Error), std::chrono::seconds(10));
+
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+}
+
+// A waiter may be removed while another one is completed, e.g. if its stream is reset.
+TEST_F(DecisionCacheTest, WaiterRemovedDuringCompletion) {
+  MockWaiter waiter1;
+  MockWaiter waiter2;
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+  EXPECT_FALSE(cache_.startCheck("key", waiter1));
+  EXPECT_FALSE(cache_.startCheck("key", waiter2));
+
+  EXPECT_CALL(waiter1, onComplete_(_)).WillOnce(Invoke([&](ResponsePtr&) {
+    cache_.removeWaiter("key", waiter2);
+  }));
+  EXPECT_CALL(waiter2, onComplete_(_)).Times(0);
+  cache_.complete("key", response(CheckStatus::OK), std::chrono::seconds(10));
+}
+
+TEST_F(DecisionCacheTest, CancelHandsCheckOverToWaiter) {
+  MockWaiter waiter1;
+  MockWaiter waiter2;
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+  EXPECT_FALSE(cache_.startCheck("key", waiter1));
+  EXPECT_FALSE(cache_.startCheck("key", waiter2));
+
+  EXPECT_CALL(waiter1, onCheckCancelled());
+  cache_.cancel("key");
+
+  // The first waiter now sends the check, which the other waiter still waits for.
+  EXPECT_CALL(waiter1, onComplete_(_)).Times(0);
+  EXPECT_CALL(waiter2, onComplete_(_));
+  cache_.complete("key", response(CheckStatus::OK), std::chrono::seconds(10));
+  EXPECT_NE(nullptr, cache_.lookup("key"));
+}
+
+TEST_F(DecisionCacheTest, CancelWithoutWaiters) {
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+  cache_.cancel("key");
+  EXPECT_EQ(nullptr, cache_.lookup("key"));
+  EXPECT_TRUE(cache_.startCheck("key", sender_));
+}
+
+} // namespace
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
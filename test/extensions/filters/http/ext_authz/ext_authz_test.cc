@@ -26,9 +26,11 @@
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/router/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/simulated_time_system.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -60,7 +62,7 @@ public:
       TestUtility::loadFromYaml(yaml, proto_config);
     }
     config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, http_context_,
-                                   "ext_authz_prefix"));
+                                   "ext_authz_prefix", tls_, time_system_));
     client_ = new Filters::Common::ExtAuthz::MockClient();
     filter_ = std::make_unique<Filter>(config_, Filters::Common::ExtAuthz::ClientPtr{client_});
     filter_->setDecoderFilterCallbacks(filter_callbacks_);
@@ -73,6 +75,7 @@ public:
     EXPECT_CALL(connection_, localAddress()).WillOnce(ReturnRef(addr_));
   }
 
+  Event::SimulatedTimeSystem time_system_;
   NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
   FilterConfigSharedPtr config_;
   Filters::Common::ExtAuthz::MockClient* client_;
@@ -88,6 +91,7 @@ public:
   Network::Address::InstanceConstSharedPtr addr_;
   NiceMock<Envoy::Network::MockConnection> connection_;
   Http::ContextImpl http_context_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
 };
 
 class HttpFilterTest : public HttpFilterTestBase<testing::Test> {
@@ -1545,6 +1549,305 @@ TEST_P(HttpFilterTestParam, NoCluster) {
   filter_->decodeHeaders(request_headers_, false);
 }
 
+// A request with its own filter, which shares the configuration, and so the decision cache, of the
+// test.
+struct DecisionCacheTestRequest {
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks_;
+  Filters::Common::ExtAuthz::MockClient* client_{new Filters::Common::ExtAuthz::MockClient()};
+  std::unique_ptr<Filter> filter_;
+  Filters::Common::ExtAuthz::RequestCallbacks* request_callbacks_{};
+  Http::TestRequestHeaderMapImpl headers_;
+};
+using DecisionCacheTestRequestPtr = std::unique_ptr<DecisionCacheTestRequest>;
+
+class DecisionCacheFilterTest : public HttpFilterTest {
+public:
+  void SetUp() override {
+    initialize(R"EOF(
+    grpc_service:
+      envoy_grpc:
+        cluster_name: "ext_authz_server"
+    decision_cache:
+      key_headers: ["x-user"]
+      ttl: 10s
+      ttl_header: "x-authz-ttl"
+    )EOF");
+    ON_CALL(connection_, remoteAddress()).WillByDefault(ReturnRef(addr_));
+    ON_CALL(connection_, localAddress()).WillByDefault(ReturnRef(addr_));
+  }
+
+  DecisionCacheTestRequestPtr createRequest(const std::string& user) {
+    auto request = std::make_unique<DecisionCacheTestRequest>();
+    request->filter_ =
+        std::make_unique<Filter>(config_, Filters::Common::ExtAuthz::ClientPtr{request->client_});
+    request->filter_->setDecoderFilterCallbacks(request->callbacks_);
+    ON_CALL(request->callbacks_, connection()).WillByDefault(Return(&connection_));
+    request->headers_.addCopy("x-user", user);
+    return request;
+  }
+
+  // Decodes the headers of a request which sends a check.
+  void sendCheck(DecisionCacheTestRequest& request) {
+    EXPECT_CALL(*request.client_, check(_, _, _, _))
+        .WillOnce(
+            WithArgs<0>(Invoke([&](Filters::Common::ExtAuthz::RequestCallbacks& callbacks) -> void {
+              request.request_callbacks_ = &callbacks;
+            })));
+    EXPECT_EQ(Http::FilterHeadersStatus::StopAllIterationAndWatermark,
+              request.filter_->decodeHeaders(request.headers_, true));
+  }
+
+  Filters::Common::ExtAuthz::ResponsePtr okResponse(const std::string& ttl = "") {
+    auto response = std::make_unique<Filters::Common::ExtAuthz::Response>();
+    response->status = Filters::Common::ExtAuthz::CheckStatus::OK;
+    response->headers_to_set = Http::HeaderVector{{Http::LowerCaseString{"x-authz-user"}, "ok"}};
+    if (!ttl.empty()) {
+      response->headers_to_set.emplace_back(Http::LowerCaseString{"x-authz-ttl"}, ttl);
+    }
+    return response;
+  }
+};
+
+// Verifies that a cached decision is applied without calling the authorization service.
+TEST_F(DecisionCacheFilterTest, Hit) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  EXPECT_CALL(first->callbacks_, continueDecoding());
+  first->request_callbacks_->onComplete(okResponse());
+  EXPECT_EQ("ok", first->headers_.get_("x-authz-user"));
+
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  EXPECT_CALL(*second->client_, check(_, _, _, _)).Times(0);
+  EXPECT_CALL(second->callbacks_, continueDecoding()).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_->decodeHeaders(second->headers_, true));
+  EXPECT_EQ("ok", second->headers_.get_("x-authz-user"));
+
+  // Another user isn't authorized by the cached decision.
+  DecisionCacheTestRequestPtr other = createRequest("bob");
+  sendCheck(*other);
+
+  EXPECT_EQ(1U, config_->stats().cache_hit_.value());
+  EXPECT_EQ(2U, config_->stats().cache_miss_.value());
+  EXPECT_EQ(2U, config_->stats().ok_.value());
+}
+
+// Verifies that a denied decision is cached as well.
+TEST_F(DecisionCacheFilterTest, DeniedHit) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  auto response = std::make_unique<Filters::Common::ExtAuthz::Response>();
+  response->status = Filters::Common::ExtAuthz::CheckStatus::Denied;
+  response->status_code = Http::Code::Forbidden;
+  EXPECT_CALL(first->callbacks_, sendLocalReply(Http::Code::Forbidden, _, _, _, _));
+  first->request_callbacks_->onComplete(std::move(response));
+
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  EXPECT_CALL(*second->client_, check(_, _, _, _)).Times(0);
+  EXPECT_CALL(second->callbacks_, sendLocalReply(Http::Code::Forbidden, _, _, _, _));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopAllIterationAndWatermark,
+            second->filter_->decodeHeaders(second->headers_, true));
+  EXPECT_EQ(2U, config_->stats().denied_.value());
+}
+
+// Verifies that errors aren't cached.
+TEST_F(DecisionCacheFilterTest, ErrorNotCached) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  auto response = std::make_unique<Filters::Common::ExtAuthz::Response>();
+  response->status = Filters::Common::ExtAuthz::CheckStatus::Error;
+  first->request_callbacks_->onComplete(std::move(response));
+
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  sendCheck(*second);
+  EXPECT_EQ(0U, config_->stats().cache_hit_.value());
+}
+
+// Verifies that a decision expires after the configured TTL.
+TEST_F(DecisionCacheFilterTest, Expiry) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  first->request_callbacks_->onComplete(okResponse());
+
+  time_system_.advanceTimeWait(std::chrono::seconds(10));
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  sendCheck(*second);
+  EXPECT_EQ(0U, config_->stats().cache_hit_.value());
+}
+
+// Verifies that the TTL header of a response overrides the configured TTL, and is removed.
+TEST_F(DecisionCacheFilterTest, TtlHeader) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  first->request_callbacks_->onComplete(okResponse("1"));
+  EXPECT_FALSE(first->headers_.has("x-authz-ttl"));
+
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  EXPECT_CALL(*second->client_, check(_, _, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_->decodeHeaders(second->headers_, true));
+  EXPECT_FALSE(second->headers_.has("x-authz-ttl"));
+
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  DecisionCacheTestRequestPtr third = createRequest("alice");
+  sendCheck(*third);
+
+  // A TTL of 0 disables caching the decision.
+  third->request_callbacks_->onComplete(okResponse("0"));
+  DecisionCacheTestRequestPtr fourth = createRequest("alice");
+  sendCheck(*fourth);
+}
+
+// Verifies that concurrent requests with the same key wait for the decision of the first one.
+TEST_F(DecisionCacheFilterTest, Coalescing) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  EXPECT_CALL(*second->client_, check(_, _, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopAllIterationAndWatermark,
+            second->filter_->decodeHeaders(second->headers_, true));
+  EXPECT_EQ(1U, config_->stats().cache_coalesced_.value());
+
+  EXPECT_CALL(first->callbacks_, continueDecoding());
+  EXPECT_CALL(second->callbacks_, continueDecoding());
+  first->request_callbacks_->onComplete(okResponse());
+  EXPECT_EQ("ok", second->headers_.get_("x-authz-user"));
+  EXPECT_EQ(2U, config_->stats().ok_.value());
+}
+
+// Verifies that the check of a reset request is sent again by a request waiting for it.
+TEST_F(DecisionCacheFilterTest, SenderReset) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  second->filter_->decodeHeaders(second->headers_, true);
+  DecisionCacheTestRequestPtr third = createRequest("alice");
+  third->filter_->decodeHeaders(third->headers_, true);
+
+  EXPECT_CALL(*first->client_, cancel());
+  EXPECT_CALL(*second->client_, check(_, _, _, _))
+      .WillOnce(
+          WithArgs<0>(Invoke([&](Filters::Common::ExtAuthz::RequestCallbacks& callbacks) -> void {
+            second->request_callbacks_ = &callbacks;
+          })));
+  first->filter_->onDestroy();
+
+  EXPECT_CALL(second->callbacks_, continueDecoding());
+  EXPECT_CALL(third->callbacks_, continueDecoding());
+  second->request_callbacks_->onComplete(okResponse());
+}
+
+// Verifies that a waiting request taking over the check of a reset request is continued when the
+// check fails inline.
+TEST_F(DecisionCacheFilterTest, SenderResetCheckFailsInline) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  failure_mode_allow: true
+  decision_cache:
+    key_headers: ["x-user"]
+    ttl: 10s
+  )EOF");
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopAllIterationAndWatermark,
+            second->filter_->decodeHeaders(second->headers_, true));
+
+  EXPECT_CALL(*first->client_, cancel());
+  EXPECT_CALL(*second->client_, check(_, _, _, _))
+      .WillOnce(
+          WithArgs<0>(Invoke([&](Filters::Common::ExtAuthz::RequestCallbacks& callbacks) -> void {
+            auto response = std::make_unique<Filters::Common::ExtAuthz::Response>();
+            response->status = Filters::Common::ExtAuthz::CheckStatus::Error;
+            callbacks.onComplete(std::move(response));
+          })));
+  EXPECT_CALL(second->callbacks_, continueDecoding());
+  first->filter_->onDestroy();
+  EXPECT_EQ(1U, config_->stats().failure_mode_allowed_.value());
+}
+
+// Verifies that a reset request no longer waits for a decision.
+TEST_F(DecisionCacheFilterTest, WaiterReset) {
+  DecisionCacheTestRequestPtr first = createRequest("alice");
+  sendCheck(*first);
+  DecisionCacheTestRequestPtr second = createRequest("alice");
+  second->filter_->decodeHeaders(second->headers_, true);
+
+  EXPECT_CALL(*second->client_, cancel()).Times(0);
+  second->filter_->onDestroy();
+
+  EXPECT_CALL(second->callbacks_, continueDecoding()).Times(0);
+  first->request_callbacks_->onComplete(okResponse());
+  EXPECT_EQ(1U, config_->stats().ok_.value());
+}
+
+// Verifies the attributes the decision cache key is made of.
+TEST_F(HttpFilterTest, DecisionCacheKey) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  decision_cache:
+    key_headers: ["x-user", "x-tenant"]
+    key_metadata:
+    - key: "jwt"
+      path:
+      - key: "sub"
+    ttl: 10s
+  )EOF");
+
+  envoy::config::core::v3::Metadata metadata;
+  TestUtility::loadFromYaml(R"EOF(
+  filter_metadata:
+    jwt:
+      sub: alice
+  )EOF",
+                            metadata);
+  auto route = std::make_shared<NiceMock<Router::MockRoute>>();
+  Protobuf::Map<std::string, std::string> extensions;
+  extensions["route"] = "a";
+  const auto cache_key = [&](const Http::TestRequestHeaderMapImpl& headers) {
+    return config_->decisionCacheKey(headers, route, extensions, metadata);
+  };
+  const std::string key = cache_key({{":method", "GET"}, {"x-user", "alice"}, {"x-other", "1"}});
+
+  // Other headers aren't part of the key.
+  EXPECT_EQ(key, cache_key({{":method", "GET"}, {"x-user", "alice"}}));
+  // A missing header differs from an empty one.
+  EXPECT_NE(key, cache_key({{":method", "GET"}, {"x-user", "alice"}, {"x-tenant", ""}}));
+  // Values can't be shifted from one header to another.
+  EXPECT_NE(cache_key({{":method", "GET"}, {"x-user", "ab"}, {"x-tenant", "c"}}),
+            cache_key({{":method", "GET"}, {"x-user", "a"}, {"x-tenant", "bc"}}));
+  // The method is always part of the key.
+  EXPECT_NE(key, cache_key({{":method", "POST"}, {"x-user", "alice"}}));
+
+  Protobuf::Map<std::string, std::string> other_extensions;
+  other_extensions["route"] = "b";
+  EXPECT_NE(key, config_->decisionCacheKey(
+                     Http::TestRequestHeaderMapImpl{{":method", "GET"}, {"x-user", "alice"}},
+                     route, other_extensions, metadata));
+
+  envoy::config::core::v3::Metadata other_metadata;
+  EXPECT_NE(key, config_->decisionCacheKey(
+                     Http::TestRequestHeaderMapImpl{{":method", "GET"}, {"x-user", "alice"}},
+                     route, extensions, other_metadata));
+
+  // The route is always part of the key.
+  auto other_route = std::make_shared<NiceMock<Router::MockRoute>>();
+  other_route->route_entry_.route_name_ = "other_route";
+  EXPECT_NE(key, config_->decisionCacheKey(
+                     Http::TestRequestHeaderMapImpl{{":method", "GET"}, {"x-user", "alice"}},
+                     other_route, extensions, metadata));
+  other_route->route_entry_.route_name_ = route->route_entry_.route_name_;
+  other_route->route_entry_.virtual_host_.name_ = "other_vhost";
+  EXPECT_NE(key, config_->decisionCacheKey(
+                     Http::TestRequestHeaderMapImpl{{":method", "GET"}, {"x-user", "alice"}},
+                     other_route, extensions, metadata));
+}
+
 } // namespace
 } // namespace ExtAuthz
 } // namespace HttpFilters
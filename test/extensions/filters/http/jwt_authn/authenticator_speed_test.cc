@@ -0,0 +1,93 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Compares authenticating a request carrying an RS256 token with and without the token cache.
+
+#include <memory>
+#include <string>
+
+#include "envoy/extensions/filters/http/jwt_authn/v3/config.pb.h"
+
+#include "common/common/assert.h"
+#include "common/stats/isolated_store_impl.h"
+#include "common/tracing/http_tracer_impl.h"
+
+#include "extensions/filters/http/jwt_authn/authenticator.h"
+
+#include "test/extensions/filters/http/jwt_authn/test_common.h"
+#include "test/mocks/upstream/cluster_manager.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+// Authenticates requests with the provider of ExampleConfig, using its public key as local JWKS.
+class AuthenticatorPerf {
+public:
+  AuthenticatorPerf(uint32_t token_cache_size)
+      : api_(Api::createApiForTest()),
+        token_cache_(token_cache_size, store_.counter("hits"), store_.counter("misses")) {
+    TestUtility::loadFromYaml(ExampleConfig, config_);
+    auto& provider = (*config_.mutable_providers())[std::string(ProviderName)];
+    provider.clear_remote_jwks();
+    provider.mutable_local_jwks()->set_inline_string(PublicKey);
+    jwks_cache_ = JwksCache::create(config_, api_->timeSource(), *api_);
+    extractor_ = Extractor::create(JwtProviderList{&provider});
+  }
+
+  bool verify(Http::RequestHeaderMap& headers) {
+    bool ok = false;
+    AuthenticatorPtr auth = Authenticator::create(
+        nullptr, std::string(ProviderName), false, false, *jwks_cache_, token_cache_, cm_,
+        [](Upstream::ClusterManager&) { return nullptr; }, api_->timeSource());
+    auth->verify(headers, Tracing::NullSpan::instance(), extractor_->extract(headers), nullptr,
+                 [&ok](const ::google::jwt_verify::Status& status) {
+                   ok = status == ::google::jwt_verify::Status::Ok;
+                 });
+    return ok;
+  }
+
+  Api::ApiPtr api_;
+  Stats::IsolatedStoreImpl store_;
+  envoy::extensions::filters::http::jwt_authn::v3::JwtAuthentication config_;
+  JwksCachePtr jwks_cache_;
+  TokenCache token_cache_;
+  ExtractorConstPtr extractor_;
+  testing::NiceMock<Upstream::MockClusterManager> cm_;
+};
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
+
+using Envoy::Extensions::HttpFilters::JwtAuthn::AuthenticatorPerf;
+using Envoy::Extensions::HttpFilters::JwtAuthn::GoodToken;
+
+// Tests parsing and verifying the token on every request, as the filter did before.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_VerifyUncached(benchmark::State& state) {
+  AuthenticatorPerf context(0);
+  for (auto _ : state) {
+    Envoy::Http::TestRequestHeaderMapImpl headers{
+        {"Authorization", "Bearer " + std::string(GoodToken)}};
+    RELEASE_ASSERT(context.verify(headers), "");
+  }
+}
+BENCHMARK(BM_VerifyUncached);
+
+// Tests finding the token in the token cache, after the first request.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_VerifyCached(benchmark::State& state) {
+  AuthenticatorPerf context(1000);
+  for (auto _ : state) {
+    Envoy::Http::TestRequestHeaderMapImpl headers{
+        {"Authorization", "Bearer " + std::string(GoodToken)}};
+    RELEASE_ASSERT(context.verify(headers), "");
+  }
+}
+BENCHMARK(BM_VerifyCached);
@@ -48,8 +48,8 @@ public:
     fetcher_.reset(raw_fetcher_);
     auth_ = Authenticator::create(
         check_audience, provider, allow_failed, allow_missing,
-        filter_config_->getCache().getJwksCache(), filter_config_->cm(),
-        [this](Upstream::ClusterManager&) { return std::move(fetcher_); },
+        filter_config_->getCache().getJwksCache(), filter_config_->getCache().getTokenCache(),
+        filter_config_->cm(), [this](Upstream::ClusterManager&) { return std::move(fetcher_); },
         filter_config_->timeSource());
     jwks_ = Jwks::createFrom(PublicKey, Jwks::JWKS);
     EXPECT_TRUE(jwks_->getStatus() == Status::Ok);
@@ -495,6 +495,98 @@ TEST_F(AuthenticatorTest, TestInvalidPubkeyKey) {
   expectVerifyStatus(Status::JwksPemBadBase64, headers);
 }
 
+// This test verifies that a verified token is cached, and that a cached token is still forwarded
+// and removed as configured.
+TEST_F(AuthenticatorTest, TestTokenCache) {
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _, _))
+      .WillOnce(Invoke([this](const envoy::config::core::v3::HttpUri&, Tracing::Span&,
+                              JwksFetcher::JwksReceiver& receiver) {
+        receiver.onJwksSuccess(std::move(jwks_));
+      }));
+
+  for (int i = 0; i < 3; i++) {
+    Http::TestRequestHeaderMapImpl headers{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    expectVerifyStatus(Status::Ok, headers);
+
+    EXPECT_EQ(headers.get_("sec-istio-auth-userinfo"), ExpectedPayloadValue);
+    EXPECT_FALSE(headers.has(Http::CustomHeaders::get().Authorization));
+  }
+  EXPECT_EQ(1U, filter_config_->stats().token_cache_miss_.value());
+  EXPECT_EQ(2U, filter_config_->stats().token_cache_hit_.value());
+  EXPECT_EQ(1U, filter_config_->getCache().getTokenCache().size());
+
+  // A token which fails verification is not cached.
+  Http::TestRequestHeaderMapImpl headers{
+      {"Authorization", "Bearer " + std::string(NonExistKidToken)}};
+  expectVerifyStatus(Status::JwtVerificationFail, headers);
+  EXPECT_EQ(1U, filter_config_->getCache().getTokenCache().size());
+}
+
+// This test verifies that the claims of a cached token are still checked.
+TEST_F(AuthenticatorTest, TestTokenCacheChecksClaims) {
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _, _))
+      .WillOnce(Invoke([this](const envoy::config::core::v3::HttpUri&, Tracing::Span&,
+                              JwksFetcher::JwksReceiver& receiver) {
+        receiver.onJwksSuccess(std::move(jwks_));
+      }));
+
+  Http::TestRequestHeaderMapImpl headers1{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::Ok, headers1);
+
+  // An authenticator of the same filter, which shares its token cache, with other audiences.
+  auto check_audience = std::make_unique<::google::jwt_verify::CheckAudience>(
+      std::vector<std::string>{"other_service"});
+  auth_ = Authenticator::create(check_audience.get(), std::string(ProviderName), false, false,
+                                filter_config_->getCache().getJwksCache(),
+                                filter_config_->getCache().getTokenCache(), filter_config_->cm(),
+                                Common::JwksFetcher::create, filter_config_->timeSource());
+
+  Http::TestRequestHeaderMapImpl headers2{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::JwtAudienceNotAllowed, headers2);
+  EXPECT_EQ(1U, filter_config_->stats().token_cache_hit_.value());
+}
+
+// This test verifies that a cached token is verified again once the Jwks has been set again.
+TEST_F(AuthenticatorTest, TestTokenCacheJwksRotation) {
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _, _))
+      .WillOnce(Invoke([this](const envoy::config::core::v3::HttpUri&, Tracing::Span&,
+                              JwksFetcher::JwksReceiver& receiver) {
+        receiver.onJwksSuccess(std::move(jwks_));
+      }));
+
+  Http::TestRequestHeaderMapImpl headers1{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::Ok, headers1);
+
+  // The key which signed the token is no longer in the Jwks.
+  auto* jwks_data =
+      filter_config_->getCache().getJwksCache().findByProvider(std::string(ProviderName));
+  jwks_data->setRemoteJwks(Jwks::createFrom(OtherPublicKey, Jwks::JWKS));
+
+  Http::TestRequestHeaderMapImpl headers2{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::JwtVerificationFail, headers2);
+  EXPECT_EQ(1U, filter_config_->stats().token_cache_hit_.value());
+  EXPECT_TRUE(headers2.has(Http::CustomHeaders::get().Authorization));
+}
+
+// This test verifies that tokens are not cached if token_cache_size is 0.
+TEST_F(AuthenticatorTest, TestTokenCacheDisabled) {
+  proto_config_.mutable_token_cache_size()->set_value(0);
+  createAuthenticator();
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _, _))
+      .WillOnce(Invoke([this](const envoy::config::core::v3::HttpUri&, Tracing::Span&,
+                              JwksFetcher::JwksReceiver& receiver) {
+        receiver.onJwksSuccess(std::move(jwks_));
+      }));
+
+  for (int i = 0; i < 2; i++) {
+    Http::TestRequestHeaderMapImpl headers{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    expectVerifyStatus(Status::Ok, headers);
+  }
+  EXPECT_EQ(0U, filter_config_->stats().token_cache_hit_.value());
+  EXPECT_EQ(0U, filter_config_->stats().token_cache_miss_.value());
+  EXPECT_EQ(0U, filter_config_->getCache().getTokenCache().size());
+}
+
 } // namespace
 } // namespace JwtAuthn
 } // namespace HttpFilters
@@ -77,6 +77,18 @@ TEST_F(JwksCacheTest, TestSetRemoteJwksWithDefaultCacheDuration) {
   EXPECT_FALSE(jwks->isExpired());
 }
 
+// Test the version of the jwks is increased each time a remote jwks is set.
+TEST_F(JwksCacheTest, TestJwksVersion) {
+  auto jwks = cache_->findByIssuer("https://example.com");
+  EXPECT_EQ(0U, jwks->getJwksVersion());
+
+  jwks->setRemoteJwks(std::move(jwks_));
+  EXPECT_EQ(1U, jwks->getJwksVersion());
+  jwks->setRemoteJwks(
+      google::jwt_verify::Jwks::createFrom(PublicKey, google::jwt_verify::Jwks::JWKS));
+  EXPECT_EQ(2U, jwks->getJwksVersion());
+}
+
 // Test a good local jwks
 TEST_F(JwksCacheTest, TestGoodInlineJwks) {
   auto& provider0 = (*config_.mutable_providers())[std::string(ProviderName)];
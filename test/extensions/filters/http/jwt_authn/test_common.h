@@ -59,6 +59,22 @@ const char PublicKey[] = R"(
 }
 )";
 
+// A public key which didn't sign any of the tokens below.
+const char OtherPublicKey[] = R"(
+{
+  "keys": [
+    {
+      "kty": "RSA",
+      "alg": "RS256",
+      "use": "sig",
+      "kid": "0f6e3d0b2c5e47b3a9f5b8e1c4d2a7f6e9b1c3d5",
+      "n": "5SjkQ4d8RdFi2oWkwfvfawsslA2ecADKr51qdzu1BaZmUKA76W8vAr6EWISIbdVaKKfTBbw6jAGgi-yZ6OVyMCBDF4VDLSnmefEYTN5tbNYIil_kpX9sc6A9wGPOcGZ376XGhBY19MM0QqUjOqfyLvV1Qq4k9KrrFZuHRmIQ8fX8XO3NbPiHmwepeyrwv45xylLkA7JW8oFFWvdAx_KaDwF-X5mUc4C7tNwIQHi-y7YNGgnkZz1QTPHqc5OhY22D2R8Zjv9gFV4XoUpWq_WaW-OmmG_hZvJoMoOl7conx-h2Fkd6Ot89EmdbVYYvZja1epL0K_qR4nX1pUduC9aznQ",
+      "e": "AQAB"
+    }
+  ]
+}
+)";
+
 // A good config.
 const char ExampleConfig[] = R"(
 providers:
@@ -0,0 +1,83 @@
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+#include "test/extensions/filters/http/jwt_authn/test_common.h"
+
+#include "gtest/gtest.h"
+
+using ::google::jwt_verify::Jwt;
+using ::google::jwt_verify::Status;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+namespace {
+
+class TokenCacheTest : public testing::Test {
+protected:
+  TokenCacheTest() : hits_(store_.counter("hits")), misses_(store_.counter("misses")) {}
+
+  void createCache(uint32_t max_size) {
+    cache_ = std::make_unique<TokenCache>(max_size, hits_, misses_);
+  }
+
+  TokenCache::VerifiedToken verified(const std::string& token, uint64_t jwks_version = 1) {
+    auto jwt = std::make_shared<Jwt>();
+    EXPECT_EQ(Status::Ok, jwt->parseFromString(token));
+    return {jwt, nullptr, jwks_version};
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  Stats::Counter& hits_;
+  Stats::Counter& misses_;
+  std::unique_ptr<TokenCache> cache_;
+};
+
+TEST_F(TokenCacheTest, FindAndInsert) {
+  createCache(10);
+  EXPECT_FALSE(cache_->find(GoodToken).has_value());
+  EXPECT_EQ(1U, misses_.value());
+
+  cache_->insert(GoodToken, verified(GoodToken));
+  const auto found = cache_->find(GoodToken);
+  ASSERT_TRUE(found.has_value());
+  EXPECT_EQ("https://example.com", found->jwt_->iss_);
+  EXPECT_EQ(1U, found->jwks_version_);
+  EXPECT_EQ(1U, hits_.value());
+
+  // Inserting a token again replaces it.
+  cache_->insert(GoodToken, verified(GoodToken, 2));
+  EXPECT_EQ(1U, cache_->size());
+  EXPECT_EQ(2U, cache_->find(GoodToken)->jwks_version_);
+}
+
+TEST_F(TokenCacheTest, EvictsLeastRecentlyUsed) {
+  createCache(2);
+  cache_->insert(GoodToken, verified(GoodToken));
+  cache_->insert(OtherGoodToken, verified(OtherGoodToken));
+  // Makes the other token the least recently used one.
+  EXPECT_TRUE(cache_->find(GoodToken).has_value());
+
+  cache_->insert(ExpiredToken, verified(ExpiredToken));
+  EXPECT_EQ(2U, cache_->size());
+  EXPECT_TRUE(cache_->find(GoodToken).has_value());
+  EXPECT_FALSE(cache_->find(OtherGoodToken).has_value());
+  EXPECT_TRUE(cache_->find(ExpiredToken).has_value());
+}
+
+TEST_F(TokenCacheTest, Disabled) {
+  createCache(0);
+  cache_->insert(GoodToken, verified(GoodToken));
+  EXPECT_EQ(0U, cache_->size());
+  EXPECT_FALSE(cache_->find(GoodToken).has_value());
+  EXPECT_EQ(0U, hits_.value());
+  EXPECT_EQ(0U, misses_.value());
+}
+
+} // namespace
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,77 @@
+#include "envoy/extensions/filters/http/local_ratelimit/v3/local_rate_limit.pb.h"
+#include "envoy/extensions/filters/http/local_ratelimit/v3/local_rate_limit.pb.validate.h"
+
+#include "extensions/filters/http/local_ratelimit/config.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+TEST(LocalRateLimitFilterConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW(LocalRateLimitFilterConfig().createFilterFactoryFromProto(
+                   envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit(),
+                   "stats", context),
+               ProtoValidationException);
+}
+
+TEST(LocalRateLimitFilterConfigTest, CorrectProto) {
+  const std::string yaml = R"EOF(
+  stat_prefix: test
+  token_bucket:
+    max_tokens: 10
+    tokens_per_fill: 5
+    fill_interval: 1s
+  descriptors:
+  - entries:
+    - key: client
+      value: a
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  )EOF";
+
+  envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit proto_config;
+  TestUtility::loadFromYamlAndValidate(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  LocalRateLimitFilterConfig factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(LocalRateLimitFilterConfigTest, RouteSpecificConfig) {
+  const std::string yaml = R"EOF(
+  stat_prefix: test
+  token_bucket:
+    max_tokens: 1
+    fill_interval: 1s
+  )EOF";
+
+  envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit proto_config;
+  TestUtility::loadFromYamlAndValidate(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockServerFactoryContext> context;
+  LocalRateLimitFilterConfig factory;
+  const auto route_config = factory.createRouteSpecificFilterConfig(
+      proto_config, context, ProtobufMessage::getNullValidationVisitor());
+  EXPECT_NE(nullptr, dynamic_cast<const FilterConfig*>(route_config.get()));
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
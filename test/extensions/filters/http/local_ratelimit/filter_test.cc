@@ -0,0 +1,187 @@
+#include "envoy/extensions/filters/http/local_ratelimit/v3/local_rate_limit.pb.h"
+#include "envoy/extensions/filters/http/local_ratelimit/v3/local_rate_limit.pb.validate.h"
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+#include "extensions/filters/http/well_known_names.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/router/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::SetArgReferee;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+const std::string config_yaml = R"EOF(
+stat_prefix: test
+token_bucket:
+  max_tokens: 1
+  tokens_per_fill: 1
+  fill_interval: 1s
+)EOF";
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  void setup(const std::string& yaml) {
+    config_ = createConfig(yaml);
+    filter_ = createFilter();
+  }
+
+  FilterConfigSharedPtr createConfig(const std::string& yaml) {
+    envoy::extensions::filters::http::local_ratelimit::v3::LocalRateLimit proto_config;
+    TestUtility::loadFromYamlAndValidate(yaml, proto_config);
+    return std::make_shared<FilterConfig>(proto_config, local_info_, time_system_, stats_,
+                                          runtime_);
+  }
+
+  std::unique_ptr<Filter> createFilter() {
+    auto filter = std::make_unique<Filter>(config_);
+    filter->setDecoderFilterCallbacks(decoder_callbacks_);
+    return filter;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return TestUtility::findCounter(stats_, "http_local_rate_limit.test." + name)->value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::IsolatedStoreImpl stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  Http::TestRequestHeaderMapImpl headers_;
+  FilterConfigSharedPtr config_;
+  std::unique_ptr<Filter> filter_;
+};
+
+TEST_F(LocalRateLimitFilterTest, RateLimited) {
+  setup(config_yaml);
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(Http::Code::TooManyRequests, "local_rate_limited",
+                                                 _, _, "local_rate_limited"));
+  EXPECT_CALL(decoder_callbacks_.stream_info_,
+              setResponseFlag(StreamInfo::ResponseFlag::RateLimited));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers_, false));
+
+  // The bucket is refilled over time, without a timer.
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+
+  EXPECT_EQ(3U, counter("enabled"));
+  EXPECT_EQ(2U, counter("ok"));
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, Status) {
+  setup(config_yaml + R"EOF(
+status:
+  code: ServiceUnavailable
+)EOF");
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(Http::Code::ServiceUnavailable, _, _, _, _));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers_, false));
+}
+
+TEST_F(LocalRateLimitFilterTest, Disabled) {
+  setup(config_yaml + R"EOF(
+runtime_enabled:
+  runtime_key: test_enabled
+  default_value: false
+)EOF");
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(_, _, _, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(0U, counter("enabled"));
+}
+
+// Verifies that the filters of all the workers consume from the same buckets.
+TEST_F(LocalRateLimitFilterTest, SharedBucket) {
+  setup(config_yaml);
+  std::unique_ptr<Filter> other_filter = createFilter();
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            other_filter->decodeHeaders(headers_, false));
+}
+
+TEST_F(LocalRateLimitFilterTest, Descriptors) {
+  setup(R"EOF(
+stat_prefix: test
+token_bucket:
+  max_tokens: 10
+  fill_interval: 1s
+descriptors:
+- entries:
+  - key: client
+    value: a
+  token_bucket:
+    max_tokens: 1
+    fill_interval: 1s
+)EOF");
+
+  NiceMock<Router::MockRateLimitPolicyEntry> rate_limit;
+  decoder_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.clear();
+  decoder_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.emplace_back(
+      rate_limit);
+
+  const std::vector<RateLimit::Descriptor> client_a{{{{"client", "a"}}}};
+  const std::vector<RateLimit::Descriptor> client_b{{{{"client", "b"}}}};
+  EXPECT_CALL(rate_limit, populateDescriptors(_, _, _, _, _, _))
+      .WillOnce(SetArgReferee<1>(client_a))
+      .WillOnce(SetArgReferee<1>(client_a))
+      .WillOnce(SetArgReferee<1>(client_b));
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers_, false));
+  // Requests without a matching descriptor use the default bucket.
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+}
+
+// Verifies that the configuration of a route replaces the one of the filter.
+TEST_F(LocalRateLimitFilterTest, RouteConfig) {
+  setup(R"EOF(
+stat_prefix: test
+token_bucket:
+  max_tokens: 10
+  fill_interval: 1s
+)EOF");
+  FilterConfigSharedPtr route_config = createConfig(R"EOF(
+stat_prefix: route
+token_bucket:
+  max_tokens: 1
+  fill_interval: 1s
+)EOF");
+  ON_CALL(*decoder_callbacks_.route_, perFilterConfig(HttpFilterNames::get().LocalRateLimit))
+      .WillByDefault(Return(route_config.get()));
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers_, false));
+  EXPECT_EQ(1U,
+            TestUtility::findCounter(stats_, "http_local_rate_limit.route.rate_limited")->value());
+  EXPECT_EQ(0U, counter("enabled"));
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
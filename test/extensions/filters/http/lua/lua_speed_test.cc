@@ -0,0 +1,195 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/common/lua/wrappers.h"
+#include "extensions/filters/http/lua/wrappers.h"
+
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Lua {
+
+using Filters::Common::Lua::BufferSliceIterator;
+using Filters::Common::Lua::BufferWrapper;
+using Filters::Common::Lua::CoroutinePtr;
+using Filters::Common::Lua::LuaDeathRef;
+using Filters::Common::Lua::ThreadLocalState;
+
+const std::string SCRIPT{R"EOF(
+  local ffi = require("ffi")
+
+  function rewriteHeaders(headers)
+    headers:replace("x-forwarded-proto", "https")
+    headers:remove("x-debug")
+    headers:add("x-rewritten", headers:get(":path"))
+  end
+
+  function scanGetBytes(body)
+    return string.find(body:getBytes(0, body:length()), "needle", 1, true) ~= nil
+  end
+
+  function scanSlices(body)
+    -- Looks for the first byte of the needle, without copying the body into Lua strings.
+    for pointer, length in body:slices() do
+      local bytes = ffi.cast("const uint8_t*", pointer)
+      for i = 0, length - 1 do
+        if bytes[i] == 110 then
+          return true
+        end
+      end
+    end
+    return false
+  end
+
+  function scanSearch(body)
+    return body:search("needle") ~= nil
+  end
+)EOF"};
+
+// Runs one function of the script per stream, as the filter does.
+class LuaPerf {
+public:
+  LuaPerf() : state_(SCRIPT, tls_) {
+    state_.registerType<BufferWrapper>();
+    state_.registerType<BufferSliceIterator>();
+    state_.registerType<HeaderMapWrapper>();
+    state_.registerType<HeaderMapIterator>();
+  }
+
+  uint64_t registerGlobal(const std::string& function) { return state_.registerGlobal(function); }
+
+  template <class T, typename... Args> void run(uint64_t slot, Args&&... args) {
+    CoroutinePtr coroutine = state_.createCoroutine();
+    LuaDeathRef<T> wrapper(T::create(coroutine->luaState(), std::forward<Args>(args)...), true);
+    coroutine->start(state_.getGlobalRef(slot), 1, [] {});
+  }
+
+  testing::NiceMock<ThreadLocal::MockInstance> tls_;
+  ThreadLocalState state_;
+};
+
+// Fills a body of the given size in 16 KiB slices, which ends with the needle.
+static void fillBody(uint64_t size, Buffer::OwnedImpl& data) {
+  const uint64_t slice_size = 16384;
+  for (uint64_t added = 0; added < size; added += slice_size) {
+    data.appendSliceForTest(std::string(std::min(slice_size, size - added), 'x'));
+  }
+  data.add("needle");
+}
+
+} // namespace Lua
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
+
+using Envoy::Extensions::Filters::Common::Lua::BufferWrapper;
+using Envoy::Extensions::HttpFilters::Lua::fillBody;
+using Envoy::Extensions::HttpFilters::Lua::HeaderMapWrapper;
+using Envoy::Extensions::HttpFilters::Lua::LuaPerf;
+using Envoy::Extensions::HttpFilters::Lua::SCRIPT;
+
+// Tests parsing the script, as each worker did before.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_LoadSource(benchmark::State& state) {
+  for (auto _ : state) {
+    lua_State* lua = lua_open();
+    luaL_openlibs(lua);
+    luaL_loadbuffer(lua, SCRIPT.data(), SCRIPT.size(), SCRIPT.c_str());
+    lua_close(lua);
+  }
+}
+BENCHMARK(BM_LoadSource);
+
+// Tests loading the bytecode of the script, as each worker does now.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_LoadBytecode(benchmark::State& state) {
+  std::string bytecode;
+  lua_State* main = lua_open();
+  luaL_loadbuffer(main, SCRIPT.data(), SCRIPT.size(), SCRIPT.c_str());
+  lua_dump(
+      main,
+      [](lua_State*, const void* chunk, size_t size, void* data) {
+        static_cast<std::string*>(data)->append(static_cast<const char*>(chunk), size);
+        return 0;
+      },
+      &bytecode);
+  lua_close(main);
+
+  for (auto _ : state) {
+    lua_State* lua = lua_open();
+    luaL_openlibs(lua);
+    luaL_loadbuffer(lua, bytecode.data(), bytecode.size(), SCRIPT.c_str());
+    lua_close(lua);
+  }
+}
+BENCHMARK(BM_LoadBytecode);
+
+// Tests a script which rewrites the request headers. The header map is created in the loop.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_RewriteHeaders(benchmark::State& state) {
+  LuaPerf context;
+  const uint64_t slot = context.registerGlobal("rewriteHeaders");
+  for (auto _ : state) {
+    Envoy::Http::TestRequestHeaderMapImpl headers{{":method", "GET"},
+                                                  {":path", "/index.html"},
+                                                  {":authority", "example.com"},
+                                                  {"x-forwarded-proto", "http"},
+                                                  {"x-debug", "true"}};
+    context.run<HeaderMapWrapper>(slot, headers, [] { return true; });
+    benchmark::DoNotOptimize(headers.size());
+  }
+}
+BENCHMARK(BM_RewriteHeaders);
+
+// Tests scanning a body by copying it into a Lua string, as scripts had to before.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ScanBodyGetBytes(benchmark::State& state) {
+  LuaPerf context;
+  const uint64_t slot = context.registerGlobal("scanGetBytes");
+  Envoy::Buffer::OwnedImpl data;
+  fillBody(state.range(0), data);
+  for (auto _ : state) {
+    context.run<BufferWrapper>(slot, data);
+  }
+  state.SetBytesProcessed(state.iterations() * data.length());
+}
+BENCHMARK(BM_ScanBodyGetBytes)->Arg(16384)->Arg(1 << 20);
+
+// Tests scanning a body slice by slice through the FFI.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ScanBodySlices(benchmark::State& state) {
+  LuaPerf context;
+  const uint64_t slot = context.registerGlobal("scanSlices");
+  Envoy::Buffer::OwnedImpl data;
+  fillBody(state.range(0), data);
+  for (auto _ : state) {
+    context.run<BufferWrapper>(slot, data);
+  }
+  state.SetBytesProcessed(state.iterations() * data.length());
+}
+BENCHMARK(BM_ScanBodySlices)->Arg(16384)->Arg(1 << 20);
+
+// Tests searching a body in C++.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ScanBodySearch(benchmark::State& state) {
+  LuaPerf context;
+  const uint64_t slot = context.registerGlobal("scanSearch");
+  Envoy::Buffer::OwnedImpl data;
+  fillBody(state.range(0), data);
+  for (auto _ : state) {
+    context.run<BufferWrapper>(slot, data);
+  }
+  state.SetBytesProcessed(state.iterations() * data.length());
+}
+BENCHMARK(BM_ScanBodySearch)->Arg(16384)->Arg(1 << 20);
@@ -0,0 +1,128 @@
+#include <string>
+
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.h"
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/common/wasm/null/null_vm_plugin.h"
+#include "extensions/filters/http/wasm/config.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/registry.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+namespace {
+
+class TestPluginFactory : public Envoy::Extensions::Common::Wasm::Null::NullVmPluginFactory {
+public:
+  std::string name() const override { return "test_wasm_config_plugin"; }
+  Envoy::Extensions::Common::Wasm::Null::NullVmPluginPtr create() const override {
+    return std::make_unique<Envoy::Extensions::Common::Wasm::Null::NullVmPlugin>();
+  }
+};
+
+class WasmFilterConfigTest : public testing::Test {
+public:
+  WasmFilterConfigTest() : registration_(factory_) {}
+
+  Http::FilterFactoryCb createFilterFactory(const std::string& yaml) {
+    envoy::extensions::filters::http::wasm::v3::Wasm proto_config;
+    TestUtility::loadFromYaml(yaml, proto_config);
+    return WasmFilterConfig().createFilterFactoryFromProto(proto_config, "stats", context_);
+  }
+
+  TestPluginFactory factory_;
+  Registry::InjectFactory<Envoy::Extensions::Common::Wasm::Null::NullVmPluginFactory>
+      registration_;
+  NiceMock<Server::Configuration::MockFactoryContext> context_;
+};
+
+TEST_F(WasmFilterConfigTest, NullVmPlugin) {
+  Http::FilterFactoryCb cb = createFilterFactory(R"EOF(
+  config:
+    inline_vm_config:
+      runtime: envoy.wasm.runtime.null
+      code:
+        local:
+          inline_string: test_wasm_config_plugin
+  )EOF");
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST_F(WasmFilterConfigTest, StructConfiguration) {
+  Http::FilterFactoryCb cb = createFilterFactory(R"EOF(
+  config:
+    inline_vm_config:
+      runtime: envoy.wasm.runtime.null
+      code:
+        local:
+          inline_string: test_wasm_config_plugin
+    configuration:
+      "@type": type.googleapis.com/google.protobuf.Struct
+      value:
+        key: value
+  )EOF");
+  EXPECT_NE(nullptr, cb);
+}
+
+TEST_F(WasmFilterConfigTest, UnsupportedConfiguration) {
+  EXPECT_THROW_WITH_MESSAGE(createFilterFactory(R"EOF(
+  config:
+    inline_vm_config:
+      runtime: envoy.wasm.runtime.null
+      code:
+        local:
+          inline_string: test_wasm_config_plugin
+    configuration:
+      "@type": type.googleapis.com/google.protobuf.UInt32Value
+      value: 1
+  )EOF"),
+                            EnvoyException,
+                            "Wasm filter: unsupported configuration type "
+                            "type.googleapis.com/google.protobuf.UInt32Value");
+}
+
+TEST_F(WasmFilterConfigTest, RemoteCode) {
+  EXPECT_THROW_WITH_MESSAGE(createFilterFactory(R"EOF(
+  config:
+    inline_vm_config:
+      runtime: envoy.wasm.runtime.v8
+      code:
+        remote:
+          http_uri:
+            uri: https://example.com/filter.wasm
+            cluster: wasm
+            timeout: 1s
+          sha256: abc
+  )EOF"),
+                            EnvoyException, "Wasm filter: only local code is supported");
+}
+
+TEST_F(WasmFilterConfigTest, UnknownPlugin) {
+  EXPECT_THROW(createFilterFactory(R"EOF(
+  config:
+    inline_vm_config:
+      runtime: envoy.wasm.runtime.null
+      code:
+        local:
+          inline_string: unknown_plugin
+  )EOF"),
+               Envoy::Extensions::Common::Wasm::WasmException);
+}
+
+} // namespace
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
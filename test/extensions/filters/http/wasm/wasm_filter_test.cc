@@ -0,0 +1,364 @@
+#include <cstdlib>
+#include <limits>
+
+#include "envoy/extensions/filters/http/wasm/v3/wasm.pb.h"
+#include "envoy/registry/registry.h"
+
+#include "common/common/byte_order.h"
+
+#include "extensions/common/wasm/null/null_vm_plugin.h"
+#include "extensions/filters/http/wasm/wasm_filter.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/registry.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Eq;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Wasm {
+namespace {
+
+namespace Exports = Envoy::Extensions::Common::Wasm::Exports;
+using Envoy::Extensions::Common::Wasm::WasmBufferType;
+using Envoy::Extensions::Common::Wasm::WasmCallVoid;
+using Envoy::Extensions::Common::Wasm::WasmCallWord;
+using Envoy::Extensions::Common::Wasm::WasmException;
+using Envoy::Extensions::Common::Wasm::WasmModuleCache;
+using Envoy::Extensions::Common::Wasm::Word;
+
+// What the test plugin saw, across all its instances.
+struct TestPluginState {
+  std::string vm_configuration;
+  std::string plugin_configuration;
+  uint32_t contexts_created{};
+  uint32_t contexts_done{};
+};
+
+TestPluginState* g_plugin_state = nullptr;
+
+// The helpers below call the host functions as the proxy-wasm SDK would.
+
+std::string getBuffer(WasmBufferType type) {
+  char* data = nullptr;
+  uint64_t size = 0;
+  EXPECT_EQ(0, Exports::getBufferBytes(nullptr, static_cast<uint32_t>(type), 0,
+                                       std::numeric_limits<uint32_t>::max(),
+                                       reinterpret_cast<uint64_t>(&data),
+                                       reinterpret_cast<uint64_t>(&size))
+                   .u64_);
+  std::string buffer(data, size);
+  ::free(data);
+  return buffer;
+}
+
+std::string getRequestHeader(absl::string_view key) {
+  char* value = nullptr;
+  uint64_t size = 0;
+  if (Exports::getHeaderMapValue(nullptr, 0, reinterpret_cast<uint64_t>(key.data()), key.size(),
+                                 reinterpret_cast<uint64_t>(&value),
+                                 reinterpret_cast<uint64_t>(&size))
+          .u64_ != 0) {
+    return "";
+  }
+  std::string result(value, size);
+  ::free(value);
+  return result;
+}
+
+void addHeader(uint32_t type, absl::string_view key, absl::string_view value) {
+  Exports::addHeaderMapValue(nullptr, type, reinterpret_cast<uint64_t>(key.data()), key.size(),
+                             reinterpret_cast<uint64_t>(value.data()), value.size());
+}
+
+void replaceHeader(uint32_t type, absl::string_view key, absl::string_view value) {
+  Exports::replaceHeaderMapValue(nullptr, type, reinterpret_cast<uint64_t>(key.data()),
+                                 key.size(), reinterpret_cast<uint64_t>(value.data()),
+                                 value.size());
+}
+
+void removeHeader(uint32_t type, absl::string_view key) {
+  Exports::removeHeaderMapValue(nullptr, type, reinterpret_cast<uint64_t>(key.data()),
+                                key.size());
+}
+
+void sendLocalResponse(uint32_t status, absl::string_view details, absl::string_view body,
+                       absl::string_view header_name, absl::string_view header_value) {
+  std::string headers;
+  auto append_size = [&headers](uint32_t size) {
+    size = toEndianness<ByteOrder::LittleEndian>(size);
+    headers.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  };
+  append_size(1);
+  append_size(header_name.size());
+  append_size(header_value.size());
+  headers.append(std::string(header_name)).push_back('\0');
+  headers.append(std::string(header_value)).push_back('\0');
+  Exports::sendLocalResponse(
+      nullptr, status, reinterpret_cast<uint64_t>(details.data()), details.size(),
+      reinterpret_cast<uint64_t>(body.data()), body.size(),
+      reinterpret_cast<uint64_t>(headers.data()), headers.size(), static_cast<uint32_t>(-1));
+}
+
+class TestPlugin : public Envoy::Extensions::Common::Wasm::Null::NullVmPlugin {
+public:
+  using NullVmPlugin::getFunction;
+
+  void getFunction(absl::string_view name, WasmCallWord<1>* f) override {
+    if (name == "malloc") {
+      *f = [](Context*, Word size) -> Word {
+        return reinterpret_cast<uint64_t>(::malloc(size.u64_));
+      };
+    } else if (name == "proxy_on_done") {
+      *f = [](Context*, Word) -> Word {
+        g_plugin_state->contexts_done++;
+        return 1;
+      };
+    } else {
+      *f = nullptr;
+    }
+  }
+
+  void getFunction(absl::string_view name, WasmCallWord<2>* f) override {
+    if (name == "proxy_on_vm_start") {
+      *f = [](Context*, Word, Word) -> Word {
+        g_plugin_state->vm_configuration = getBuffer(WasmBufferType::VmConfiguration);
+        return g_plugin_state->vm_configuration != "reject";
+      };
+    } else if (name == "proxy_on_configure") {
+      *f = [](Context*, Word, Word) -> Word {
+        g_plugin_state->plugin_configuration = getBuffer(WasmBufferType::PluginConfiguration);
+        return 1;
+      };
+    } else {
+      *f = nullptr;
+    }
+  }
+
+  void getFunction(absl::string_view name, WasmCallVoid<2>* f) override {
+    if (name == "proxy_on_context_create") {
+      *f = [](Context*, Word, Word) { g_plugin_state->contexts_created++; };
+    } else {
+      *f = nullptr;
+    }
+  }
+
+  void getFunction(absl::string_view name, WasmCallWord<3>* f) override {
+    if (name == "proxy_on_request_headers") {
+      *f = [](Context*, Word, Word, Word) -> Word {
+        const std::string action = getRequestHeader("x-action");
+        if (action == "add") {
+          addHeader(0, "x-wasm", "added");
+        } else if (action == "replace") {
+          replaceHeader(0, ":path", "/wasm");
+        } else if (action == "remove") {
+          removeHeader(0, "x-remove");
+        } else if (action == "deny") {
+          sendLocalResponse(403, "denied", "denied by wasm", "x-wasm", "denied");
+          return 1;
+        } else if (action == "trap") {
+          throw WasmException("trap");
+        }
+        return 0;
+      };
+    } else if (name == "proxy_on_response_headers") {
+      *f = [](Context*, Word, Word, Word) -> Word {
+        replaceHeader(2, "server", "wasm");
+        return 0;
+      };
+    } else {
+      *f = nullptr;
+    }
+  }
+};
+
+class TestPluginFactory : public Envoy::Extensions::Common::Wasm::Null::NullVmPluginFactory {
+public:
+  std::string name() const override { return "test_wasm_filter_plugin"; }
+  Envoy::Extensions::Common::Wasm::Null::NullVmPluginPtr create() const override {
+    return std::make_unique<TestPlugin>();
+  }
+};
+
+class WasmFilterTest : public testing::Test {
+public:
+  WasmFilterTest()
+      : registration_(factory_), api_(Api::createApiForTest(stats_store_)),
+        module_cache_(std::make_shared<WasmModuleCache>(stats_store_, *api_)) {
+    g_plugin_state = &plugin_state_;
+  }
+
+  ~WasmFilterTest() override { g_plugin_state = nullptr; }
+
+  void setupConfig(const std::string& vm_configuration, bool fail_open) {
+    const std::string yaml = fmt::format(R"EOF(
+config:
+  name: test
+  inline_vm_config:
+    runtime: envoy.wasm.runtime.null
+    code:
+      local:
+        inline_string: test_wasm_filter_plugin
+    configuration:
+      "@type": type.googleapis.com/google.protobuf.StringValue
+      value: "{}"
+  configuration:
+    "@type": type.googleapis.com/google.protobuf.StringValue
+    value: "plugin configuration"
+  fail_open: {}
+)EOF",
+                                         vm_configuration, fail_open);
+    envoy::extensions::filters::http::wasm::v3::Wasm proto_config;
+    TestUtility::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<FilterConfig>(proto_config, module_cache_, tls_, *api_);
+  }
+
+  void setupFilter() {
+    filter_ = std::make_unique<Filter>(config_, config_->wasm());
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  void setup(bool fail_open = false) {
+    setupConfig("vm configuration", fail_open);
+    setupFilter();
+  }
+
+  TestPluginState plugin_state_;
+  TestPluginFactory factory_;
+  Registry::InjectFactory<Envoy::Extensions::Common::Wasm::Null::NullVmPluginFactory>
+      registration_;
+  Stats::TestUtil::TestStore stats_store_;
+  Api::ApiPtr api_;
+  std::shared_ptr<WasmModuleCache> module_cache_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  FilterConfigSharedPtr config_;
+  std::unique_ptr<Filter> filter_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+TEST_F(WasmFilterTest, PassesConfiguration) {
+  setup();
+  EXPECT_EQ("vm configuration", plugin_state_.vm_configuration);
+  EXPECT_EQ("plugin configuration", plugin_state_.plugin_configuration);
+}
+
+TEST_F(WasmFilterTest, RejectedConfiguration) {
+  EXPECT_THROW_WITH_MESSAGE(setupConfig("reject", false), WasmException,
+                            "Wasm module test rejected its VM configuration");
+}
+
+TEST_F(WasmFilterTest, ModifiesRequestHeaders) {
+  setup();
+  const uint32_t root_contexts = plugin_state_.contexts_created;
+  Http::TestRequestHeaderMapImpl headers{{":path", "/"}, {"x-action", "add"}, {"x-remove", "yes"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+  EXPECT_EQ("added", headers.get_("x-wasm"));
+  EXPECT_EQ(root_contexts + 1, plugin_state_.contexts_created);
+
+  headers.setCopy(Http::LowerCaseString("x-action"), "replace");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+  EXPECT_EQ("/wasm", headers.get_(":path"));
+
+  headers.setCopy(Http::LowerCaseString("x-action"), "remove");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+  EXPECT_FALSE(headers.has("x-remove"));
+
+  filter_->onDestroy();
+  EXPECT_EQ(1, plugin_state_.contexts_done);
+}
+
+TEST_F(WasmFilterTest, ModifiesResponseHeaders) {
+  setup();
+  Http::TestResponseHeaderMapImpl headers{{":status", "200"}, {"server", "envoy"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, true));
+  EXPECT_EQ("wasm", headers.get_("server"));
+}
+
+TEST_F(WasmFilterTest, SendsLocalResponse) {
+  setup();
+  EXPECT_CALL(decoder_callbacks_,
+              sendLocalReply(Http::Code::Forbidden, "denied by wasm", _, Eq(absl::nullopt),
+                             "denied"))
+      .WillOnce(Invoke([](Http::Code, absl::string_view,
+                          std::function<void(Http::ResponseHeaderMap & headers)> modify_headers,
+                          const absl::optional<Grpc::Status::GrpcStatus>, absl::string_view) {
+        Http::TestResponseHeaderMapImpl response_headers;
+        modify_headers(response_headers);
+        EXPECT_EQ("denied", response_headers.get_("x-wasm"));
+      }));
+  Http::TestRequestHeaderMapImpl headers{{":path", "/"}, {"x-action", "deny"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers, true));
+}
+
+// Statuses outside of the valid ranges are rejected without sending anything.
+TEST_F(WasmFilterTest, LocalResponseStatusRange) {
+  setup();
+  EXPECT_EQ(WasmResult::BadArgument, filter_->sendLocalResponse(199, "", {}, absl::nullopt, ""));
+  EXPECT_EQ(WasmResult::BadArgument, filter_->sendLocalResponse(600, "", {}, absl::nullopt, ""));
+  EXPECT_EQ(WasmResult::BadArgument, filter_->sendLocalResponse(200, "", {}, 17, ""));
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(Http::Code::OK, "", _,
+                                                 Eq(Grpc::Status::WellKnownGrpcStatus::Ok), _));
+  EXPECT_EQ(WasmResult::Ok, filter_->sendLocalResponse(200, "", {}, 0, ""));
+}
+
+TEST_F(WasmFilterTest, TrapFailsClosed) {
+  setup();
+  EXPECT_CALL(decoder_callbacks_,
+              sendLocalReply(Http::Code::ServiceUnavailable, "", _, _, "wasm_failed"))
+      .Times(2);
+  Http::TestRequestHeaderMapImpl headers{{":path", "/"}, {"x-action", "trap"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers, true));
+  EXPECT_TRUE(config_->wasm()->failed());
+
+  // The module isn't called anymore.
+  setupFilter();
+  Http::TestRequestHeaderMapImpl other_headers{{":path", "/"}, {"x-action", "add"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(other_headers, true));
+  EXPECT_FALSE(other_headers.has("x-wasm"));
+}
+
+TEST_F(WasmFilterTest, TrapFailsOpen) {
+  setup(true);
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(_, _, _, _, _)).Times(0);
+  Http::TestRequestHeaderMapImpl headers{{":path", "/"}, {"x-action", "trap"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+  EXPECT_TRUE(config_->wasm()->failed());
+}
+
+TEST_F(WasmFilterTest, UnavailableFilter) {
+  UnavailableFilter filter;
+  filter.setDecoderFilterCallbacks(decoder_callbacks_);
+  EXPECT_CALL(decoder_callbacks_,
+              sendLocalReply(Http::Code::ServiceUnavailable, "", _, _, "wasm_failed"));
+  Http::TestRequestHeaderMapImpl headers{{":path", "/"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter.decodeHeaders(headers, true));
+}
+
+TEST_F(WasmFilterTest, SharesLoadedModule) {
+  setup();
+  FilterConfigSharedPtr first_config = config_;
+  setupConfig("vm configuration", false);
+  EXPECT_EQ(1, stats_store_.counter("wasm.module_cache.miss").value());
+  EXPECT_EQ(1, stats_store_.counter("wasm.module_cache.hit").value());
+  // Each configuration runs its own instances of the module.
+  EXPECT_NE(first_config->wasm(), config_->wasm());
+}
+
+} // namespace
+} // namespace Wasm
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -30,6 +30,7 @@
 using testing::_;
 using testing::An;
 using testing::Eq;
+using testing::Not;
 using testing::NotNull;
 using testing::Pointee;
 using testing::Return;
@@ -1971,6 +1972,38 @@ TEST_F(FilterChainTest, CreateFilterChain) {
   config.createFilterChain(callbacks);
 }
 
+MATCHER(IsTimedFilter, "") {
+  return dynamic_cast<const Http::TimedStreamFilter*>(arg.get()) != nullptr;
+}
+
+// The filters of sampled streams are wrapped for timing, the filters of other streams are not.
+TEST_F(FilterChainTest, CreateTimedFilterChain) {
+  auto hcm_config = parseHttpConnectionManagerFromYaml(basic_config_);
+  hcm_config.mutable_filter_timing()->mutable_sampling()->set_runtime_key("filter_timing");
+  HttpConnectionManagerConfig config(hcm_config, context_, date_provider_,
+                                     route_config_provider_manager_,
+                                     scoped_routes_config_provider_manager_, http_tracer_manager_,
+                                     filter_config_provider_manager_);
+
+  EXPECT_CALL(context_.runtime_loader_.snapshot_,
+              featureEnabled("filter_timing", An<const envoy::type::v3::FractionalPercent&>()))
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+
+  {
+    Http::MockFilterChainFactoryCallbacks callbacks;
+    EXPECT_CALL(callbacks, addStreamFilter(IsTimedFilter()));
+    EXPECT_CALL(callbacks, addStreamDecoderFilter(IsTimedFilter()));
+    config.createFilterChain(callbacks);
+  }
+  {
+    Http::MockFilterChainFactoryCallbacks callbacks;
+    EXPECT_CALL(callbacks, addStreamFilter(Not(IsTimedFilter())));
+    EXPECT_CALL(callbacks, addStreamDecoderFilter(Not(IsTimedFilter())));
+    config.createFilterChain(callbacks);
+  }
+}
+
 TEST_F(FilterChainTest, CreateDynamicFilterChain) {
   const std::string yaml_string = R"EOF(
 codec_type: http1
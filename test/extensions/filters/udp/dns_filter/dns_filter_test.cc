@@ -201,6 +201,32 @@ server_config:
             - "10.0.0.1"
 )EOF";
 
+  const std::string forward_query_on_cache_config = R"EOF(
+stat_prefix: "my_prefix"
+client_config:
+  resolver_timeout: 1s
+  upstream_resolvers:
+  - socket_address:
+      address: "1.1.1.1"
+      port_value: 53
+  max_pending_lookups: 1
+  response_cache:
+    max_entries: 1
+    max_ttl: 60s
+    negative_ttl: 5s
+server_config:
+  inline_dns_table:
+    external_retry_count: 0
+    known_suffixes:
+    - suffix: foo1.com
+    virtual_domains:
+      - name: "www.foo1.com"
+        endpoint:
+          address_list:
+            address:
+            - "10.0.0.1"
+)EOF";
+
   const std::string external_dns_table_config = R"EOF(
 stat_prefix: "my_prefix"
 client_config:
@@ -783,6 +809,202 @@ TEST_F(DnsFilterTest, ExternalResolutionTimeout2) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
 }
 
+TEST_F(DnsFilterTest, ExternalResolutionCachedResponse) {
+  const std::string expected_address("130.207.244.251");
+  const std::string domain("www.foobaz.com");
+  setup(forward_query_on_cache_config);
+
+  auto timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  Network::DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve(domain, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+
+  const std::string query1 =
+      Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+  ASSERT_FALSE(query1.empty());
+  sendQueryFromClient("10.0.0.1:1000", query1);
+  EXPECT_CALL(*timeout_timer, disableTimer()).Times(AnyNumber());
+  resolve_cb(Network::DnsResolver::ResolutionStatus::Success,
+             TestUtility::makeDnsResponse({expected_address}, std::chrono::seconds(30)));
+  const std::string response1 = udp_response_.buffer_->toString();
+  udp_response_.buffer_->drain(udp_response_.buffer_->length());
+  EXPECT_EQ(1, config_->stats().cache_misses_.value());
+  EXPECT_EQ(1, config_->stats().cache_insertions_.value());
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+
+  // A second query for the same name is answered from the cache without resolving the name again.
+  // Only the transaction ID differs from the first response
+  EXPECT_CALL(*resolver_, resolve(_, _, _)).Times(0);
+  std::string query2 =
+      Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+  query2[0] = ~query1[0];
+  sendQueryFromClient("10.0.0.1:1001", query2);
+  const std::string response2 = udp_response_.buffer_->toString();
+  EXPECT_EQ(query2.substr(0, 2), response2.substr(0, 2));
+  EXPECT_EQ(response1.substr(2), response2.substr(2));
+
+  query_ctx_ = response_parser_->createQueryContext(udp_response_, counters_);
+  EXPECT_TRUE(query_ctx_->parse_status_);
+  EXPECT_EQ(DNS_RESPONSE_CODE_NO_ERROR, response_parser_->getQueryResponseCode());
+  std::list<std::string> expected{expected_address};
+  for (const auto& answer : query_ctx_->answers_) {
+    EXPECT_EQ(answer.first, domain);
+    EXPECT_EQ(std::chrono::seconds(30), answer.second->ttl_);
+    Utils::verifyAddress(expected, answer.second);
+  }
+  EXPECT_EQ(1, query_ctx_->answers_.size());
+  udp_response_.buffer_->drain(udp_response_.buffer_->length());
+
+  // The TTL of a cached answer is decremented by the time it has been cached for
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  sendQueryFromClient("10.0.0.1:1001", query2);
+  query_ctx_ = response_parser_->createQueryContext(udp_response_, counters_);
+  EXPECT_TRUE(query_ctx_->parse_status_);
+  ASSERT_EQ(1, query_ctx_->answers_.size());
+  EXPECT_EQ(std::chrono::seconds(20), query_ctx_->answers_.begin()->second->ttl_);
+
+  // Validate stats
+  EXPECT_EQ(3, config_->stats().downstream_rx_queries_.value());
+  EXPECT_EQ(3, config_->stats().downstream_tx_responses_.value());
+  EXPECT_EQ(1, config_->stats().externally_resolved_queries_.value());
+  EXPECT_EQ(2, config_->stats().cache_hits_.value());
+  EXPECT_EQ(0, config_->stats().cache_negative_hits_.value());
+  EXPECT_EQ(1, config_->stats().cache_misses_.value());
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+}
+
+TEST_F(DnsFilterTest, ExternalResolutionNegativeCachedResponse) {
+  const std::string domain("www.foobaz.com");
+  setup(forward_query_on_cache_config);
+
+  auto timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  Network::DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve(domain, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+
+  const std::string query =
+      Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+  ASSERT_FALSE(query.empty());
+  sendQueryFromClient("10.0.0.1:1000", query);
+  EXPECT_CALL(*timeout_timer, disableTimer()).Times(AnyNumber());
+  resolve_cb(Network::DnsResolver::ResolutionStatus::Success, TestUtility::makeDnsResponse({}));
+  udp_response_.buffer_->drain(udp_response_.buffer_->length());
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+
+  // The name error is served from the cache until the negative TTL expires
+  EXPECT_CALL(*resolver_, resolve(_, _, _)).Times(0);
+  sendQueryFromClient("10.0.0.1:1000", query);
+  query_ctx_ = response_parser_->createQueryContext(udp_response_, counters_);
+  EXPECT_TRUE(query_ctx_->parse_status_);
+  EXPECT_EQ(DNS_RESPONSE_CODE_NAME_ERROR, response_parser_->getQueryResponseCode());
+  EXPECT_EQ(0, query_ctx_->answers_.size());
+  udp_response_.buffer_->drain(udp_response_.buffer_->length());
+  EXPECT_EQ(1, config_->stats().cache_negative_hits_.value());
+  EXPECT_EQ(0, config_->stats().cache_hits_.value());
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+
+  // Once the negative TTL expires the name is resolved again
+  simTime().advanceTimeWait(std::chrono::seconds(5));
+  timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*resolver_, resolve(domain, _, _)).WillOnce(Return(&resolver_->active_query_));
+  sendQueryFromClient("10.0.0.1:1000", query);
+  EXPECT_EQ(2, config_->stats().cache_misses_.value());
+  EXPECT_EQ(1, config_->stats().cache_negative_hits_.value());
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+}
+
+TEST_F(DnsFilterTest, ExternalResolutionCacheIgnoresCase) {
+  setup(forward_query_on_cache_config);
+
+  auto timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  Network::DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve("www.foobaz.com", _, _))
+      .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+  const std::string query1 =
+      Utils::buildQueryForDomain("www.foobaz.com", DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+  sendQueryFromClient("10.0.0.1:1000", query1);
+  EXPECT_CALL(*timeout_timer, disableTimer()).Times(AnyNumber());
+  resolve_cb(Network::DnsResolver::ResolutionStatus::Success,
+             TestUtility::makeDnsResponse({"130.207.244.251"}, std::chrono::seconds(30)));
+  udp_response_.buffer_->drain(udp_response_.buffer_->length());
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+
+  // The cached response echoes the query name as each client spelled it
+  EXPECT_CALL(*resolver_, resolve(_, _, _)).Times(0);
+  for (const std::string domain : {"WWW.FooBaz.com", "wWw.fOObAZ.CoM"}) {
+    const std::string query =
+        Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+    sendQueryFromClient("10.0.0.1:1000", query);
+    // The question section directly follows the header in both the query and the response
+    const std::string response = udp_response_.buffer_->toString();
+    EXPECT_EQ(query.substr(12, domain.size() + 2), response.substr(12, domain.size() + 2));
+
+    query_ctx_ = response_parser_->createQueryContext(udp_response_, counters_);
+    EXPECT_TRUE(query_ctx_->parse_status_);
+    ASSERT_EQ(1, query_ctx_->queries_.size());
+    EXPECT_EQ(domain, query_ctx_->queries_.front()->name_);
+    ASSERT_EQ(1, query_ctx_->answers_.size());
+    EXPECT_EQ(domain, query_ctx_->answers_.begin()->first);
+    std::list<std::string> expected{"130.207.244.251"};
+    Utils::verifyAddress(expected, query_ctx_->answers_.begin()->second);
+    udp_response_.buffer_->drain(udp_response_.buffer_->length());
+  }
+  EXPECT_EQ(2, config_->stats().cache_hits_.value());
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+}
+
+// Failed resolutions, e.g. upstream timeouts, are not negatively cached
+TEST_F(DnsFilterTest, ExternalResolutionFailureNotCached) {
+  const std::string domain("www.foobaz.com");
+  setup(forward_query_on_cache_config);
+
+  const std::string query =
+      Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN);
+  for (int i = 0; i < 2; i++) {
+    auto timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+    Network::DnsResolver::ResolveCb resolve_cb;
+    EXPECT_CALL(*resolver_, resolve(domain, _, _))
+        .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+    sendQueryFromClient("10.0.0.1:1000", query);
+    EXPECT_CALL(*timeout_timer, disableTimer()).Times(AnyNumber());
+    resolve_cb(Network::DnsResolver::ResolutionStatus::Failure, TestUtility::makeDnsResponse({}));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+  }
+
+  EXPECT_EQ(0, config_->stats().cache_insertions_.value());
+  EXPECT_EQ(0, config_->stats().cache_negative_hits_.value());
+  EXPECT_EQ(2, config_->stats().cache_misses_.value());
+}
+
+TEST_F(DnsFilterTest, ExternalResolutionCacheEviction) {
+  setup(forward_query_on_cache_config);
+
+  // The cache holds a single entry, so caching the second name evicts the first
+  for (const std::string domain : {"www.foobaz.com", "www.foobar.com"}) {
+    auto timeout_timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+    Network::DnsResolver::ResolveCb resolve_cb;
+    EXPECT_CALL(*resolver_, resolve(domain, _, _))
+        .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+    sendQueryFromClient("10.0.0.1:1000",
+                        Utils::buildQueryForDomain(domain, DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN));
+    EXPECT_CALL(*timeout_timer, disableTimer()).Times(AnyNumber());
+    resolve_cb(Network::DnsResolver::ResolutionStatus::Success,
+               TestUtility::makeDnsResponse({"130.207.244.251"}, std::chrono::seconds(30)));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(resolver_.get()));
+  }
+
+  EXPECT_EQ(2, config_->stats().cache_insertions_.value());
+  EXPECT_EQ(1, config_->stats().cache_evictions_.value());
+
+  // Names resolved from the local configuration never consult the cache
+  sendQueryFromClient("10.0.0.1:1000", Utils::buildQueryForDomain(
+                                           "www.foo1.com", DNS_RECORD_TYPE_A, DNS_RECORD_CLASS_IN));
+  EXPECT_EQ(2, config_->stats().cache_misses_.value());
+  EXPECT_EQ(0, config_->stats().cache_hits_.value());
+}
+
 TEST_F(DnsFilterTest, ExternalResolutionExceedMaxPendingLookups) {
   InSequence s;
 
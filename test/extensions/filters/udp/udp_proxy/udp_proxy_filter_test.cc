@@ -3,8 +3,10 @@
 
 #include "extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
 
+#include "test/mocks/api/mocks.h"
 #include "test/mocks/network/io_handle.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/threadsafe_singleton_injector.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -294,6 +296,62 @@ cluster: fake_cluster
                    ->value());
 }
 
+// With batched upstream writes, datagrams received during an event loop iteration are forwarded
+// upstream with a single sendmmsg() call once the iteration completes.
+TEST_F(UdpProxyFilterTest, BatchedUpstreamWrites) {
+  if (!Api::OsSysCallsSingleton::get().supportsMmsg()) {
+    return;
+  }
+
+  setup(R"EOF(
+stat_prefix: foo
+cluster: fake_cluster
+batch_upstream_writes: true
+  )EOF");
+
+  test_sessions_.emplace_back(*this, upstream_address_);
+  TestSession& session = test_sessions_.back();
+  session.idle_timer_ = new Event::MockTimer(&callbacks_.udp_listener_.dispatcher_);
+  EXPECT_CALL(*filter_, createIoHandle(_))
+      .WillOnce(Return(ByMove(Network::IoHandlePtr{session.io_handle_})));
+  EXPECT_CALL(*session.io_handle_, fd()).Times(AtLeast(1));
+  auto* flush_cb = new Event::MockSchedulableCallback(&callbacks_.udp_listener_.dispatcher_);
+  EXPECT_CALL(callbacks_.udp_listener_.dispatcher_,
+              createFileEvent_(_, _, Event::PlatformDefaultTriggerType,
+                               Event::FileReadyType::Read | Event::FileReadyType::Write))
+      .WillOnce(DoAll(SaveArg<1>(&session.file_event_cb_), Return(nullptr)));
+
+  EXPECT_CALL(*session.idle_timer_, enableTimer(config_->sessionTimeout(), nullptr)).Times(2);
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "world!");
+  checkTransferStats(11 /*rx_bytes*/, 2 /*rx_datagrams*/, 0 /*tx_bytes*/, 0 /*tx_datagrams*/);
+
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+  EXPECT_CALL(os_sys_calls, sendmmsg(_, _, 2, _))
+      .WillOnce(Invoke([](os_fd_t, struct mmsghdr* msgvec, unsigned int vlen,
+                          int) -> Api::SysCallIntResult {
+        EXPECT_EQ("hello",
+                  absl::string_view(static_cast<char*>(msgvec[0].msg_hdr.msg_iov[0].iov_base),
+                                    msgvec[0].msg_hdr.msg_iov[0].iov_len));
+        EXPECT_EQ("world!",
+                  absl::string_view(static_cast<char*>(msgvec[1].msg_hdr.msg_iov[0].iov_base),
+                                    msgvec[1].msg_hdr.msg_iov[0].iov_len));
+        for (unsigned int i = 0; i < vlen; ++i) {
+          msgvec[i].msg_len = msgvec[i].msg_hdr.msg_iov[0].iov_len;
+        }
+        return {static_cast<int>(vlen), 0};
+      }));
+  flush_cb->invokeCallback();
+  EXPECT_EQ(2, TestUtility::findCounter(
+                   cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_,
+                   "udp.sess_tx_datagrams")
+                   ->value());
+  EXPECT_EQ(11, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_
+                    .upstream_cx_tx_bytes_total_.value());
+}
+
 // No upstream host handling.
 TEST_F(UdpProxyFilterTest, NoUpstreamHost) {
   InSequence s;
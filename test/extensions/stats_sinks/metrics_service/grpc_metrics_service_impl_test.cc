@@ -1,5 +1,7 @@
 #include "envoy/service/metrics/v3/metrics_service.pb.h"
 
+#include "common/stats/histogram_impl.h"
+
 #include "extensions/stat_sinks/metrics_service/grpc_metrics_service_impl.h"
 
 #include "test/mocks/common.h"
@@ -9,11 +11,15 @@
 #include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/simulated_time_system.h"
 
+#include "circllhist.h"
+
 using namespace std::chrono_literals;
 using testing::_;
 using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
 
 namespace Envoy {
 namespace Extensions {
@@ -63,7 +69,9 @@ TEST_F(GrpcMetricsStreamerImplTest, BasicFlow) {
   EXPECT_CALL(local_info_, node());
   EXPECT_CALL(stream1, sendMessageRaw_(_, false));
   envoy::service::metrics::v3::StreamMetricsMessage message_metrics1;
+  EXPECT_FALSE(streamer_->isStreamStarted());
   streamer_->send(message_metrics1);
+  EXPECT_TRUE(streamer_->isStreamStarted());
   // Verify that sending an empty response message doesn't do anything bad.
   callbacks1->onReceiveMessage(
       std::make_unique<envoy::service::metrics::v3::StreamMetricsResponse>());
@@ -83,12 +91,62 @@ TEST_F(GrpcMetricsStreamerImplTest, StreamFailure) {
   EXPECT_CALL(local_info_, node());
   envoy::service::metrics::v3::StreamMetricsMessage message_metrics1;
   streamer_->send(message_metrics1);
+  EXPECT_FALSE(streamer_->isStreamStarted());
+}
+
+// Test that the metric names are sent again on a new stream when metrics are reported by id.
+TEST_F(GrpcMetricsStreamerImplTest, MetricNamesResentOnNewStream) {
+  MockMetricsStream stream1;
+  MockMetricsStream stream2;
+  MetricsServiceCallbacks* callbacks1;
+  MetricsServiceCallbacks* callbacks2;
+  std::vector<envoy::service::metrics::v3::StreamMetricsMessage> messages;
+  auto capture_message = [&messages](Buffer::InstancePtr& request, bool) {
+    messages.emplace_back();
+    EXPECT_TRUE(messages.back().ParseFromString(request->toString()));
+  };
+
+  NiceMock<Stats::MockMetricSnapshot> snapshot;
+  NiceMock<Stats::MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.used_ = true;
+  snapshot.counters_.push_back({1, counter});
+  Event::SimulatedTimeSystem time_system;
+  MetricsServiceSink sink(std::move(streamer_), time_system, false, false, true);
+
+  expectStreamStart(stream1, &callbacks1);
+  EXPECT_CALL(stream1, sendMessageRaw_(_, false)).Times(2).WillRepeatedly(Invoke(capture_message));
+  sink.flush(snapshot);
+  sink.flush(snapshot);
+
+  // The stream is closed, so the next flush starts a new one.
+  callbacks1->onRemoteClose(Grpc::Status::Internal, "bad");
+  expectStreamStart(stream2, &callbacks2);
+  EXPECT_CALL(stream2, sendMessageRaw_(_, false)).WillOnce(Invoke(capture_message));
+  sink.flush(snapshot);
+
+  ASSERT_EQ(3U, messages.size());
+  for (const auto& message : messages) {
+    ASSERT_EQ(1, message.envoy_metrics_size());
+    EXPECT_EQ("", message.envoy_metrics(0).name());
+    ASSERT_EQ(1, message.envoy_metric_ids_size());
+    EXPECT_EQ(0U, message.envoy_metric_ids(0));
+  }
+  // The name is sent with the first message of each stream only.
+  ASSERT_EQ(1, messages[0].metric_names_size());
+  EXPECT_EQ(0U, messages[0].metric_names(0).id());
+  EXPECT_EQ("test_counter", messages[0].metric_names(0).name());
+  EXPECT_EQ(0, messages[1].metric_names_size());
+  ASSERT_EQ(1, messages[2].metric_names_size());
+  EXPECT_EQ(0U, messages[2].metric_names(0).id());
+  EXPECT_EQ("test_counter", messages[2].metric_names(0).name());
 }
 
 class MockGrpcMetricsStreamer : public GrpcMetricsStreamer {
 public:
   // GrpcMetricsStreamer
   MOCK_METHOD(void, send, (envoy::service::metrics::v3::StreamMetricsMessage & message));
+  MOCK_METHOD(bool, isStreamStarted, (), (const));
 };
 
 class MetricsServiceSinkTest : public testing::Test {
@@ -101,7 +159,7 @@ public:
 };
 
 TEST_F(MetricsServiceSinkTest, CheckSendCall) {
-  MetricsServiceSink sink(streamer_, time_system_, false);
+  MetricsServiceSink sink(streamer_, time_system_, false, false, false);
 
   auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
   counter->name_ = "test_counter";
@@ -125,7 +183,7 @@ TEST_F(MetricsServiceSinkTest, CheckSendCall) {
 }
 
 TEST_F(MetricsServiceSinkTest, CheckStatsCount) {
-  MetricsServiceSink sink(streamer_, time_system_, false);
+  MetricsServiceSink sink(streamer_, time_system_, false, false, false);
 
   auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
   counter->name_ = "test_counter";
@@ -156,7 +214,7 @@ TEST_F(MetricsServiceSinkTest, CheckStatsCount) {
 
 // Test that verifies counters are correctly reported as current value when configured to do so.
 TEST_F(MetricsServiceSinkTest, ReportCountersValues) {
-  MetricsServiceSink sink(streamer_, time_system_, false);
+  MetricsServiceSink sink(streamer_, time_system_, false, false, false);
 
   auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
   counter->name_ = "test_counter";
@@ -174,7 +232,7 @@ TEST_F(MetricsServiceSinkTest, ReportCountersValues) {
 
 // Test that verifies counters are reported as the delta between flushes when configured to do so.
 TEST_F(MetricsServiceSinkTest, ReportCountersAsDeltas) {
-  MetricsServiceSink sink(streamer_, time_system_, true);
+  MetricsServiceSink sink(streamer_, time_system_, true, false, false);
 
   auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
   counter->name_ = "test_counter";
@@ -190,6 +248,179 @@ TEST_F(MetricsServiceSinkTest, ReportCountersAsDeltas) {
   sink.flush(snapshot_);
 }
 
+// Test that only the changed metrics are reported when configured to do so, except on a new stream.
+TEST_F(MetricsServiceSinkTest, ReportChangedMetricsOnly) {
+  // The sink references the gauge, so it must not be owned by a shared_ptr.
+  Stats::GaugeSharedPtr gauge_ptr(new NiceMock<Stats::MockGauge>());
+  auto& gauge = dynamic_cast<Stats::MockGauge&>(*gauge_ptr);
+  gauge.name_ = "test_gauge";
+  gauge.value_ = 1;
+  gauge.used_ = true;
+  snapshot_.gauges_.push_back(gauge);
+
+  NiceMock<Stats::MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.value_ = 100;
+  counter.used_ = true;
+  snapshot_.counters_.push_back({1, counter});
+
+  NiceMock<Stats::MockParentHistogram> histogram;
+  histogram.name_ = "test_histogram";
+  histogram.used_ = true;
+  snapshot_.histograms_.push_back(histogram);
+
+  MetricsServiceSink sink(streamer_, time_system_, false, true, false);
+
+  // Everything is reported on a new stream.
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(false));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        // The histogram is reported as a summary and as a histogram.
+        EXPECT_EQ(4, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+
+  // Nothing changed.
+  snapshot_.counters_[0].delta_ = 0;
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(true));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(0, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+
+  // The counter was incremented and the gauge changed.
+  snapshot_.counters_[0].delta_ = 2;
+  gauge.value_ = 2;
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(true));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        ASSERT_EQ(2, message.envoy_metrics_size());
+        EXPECT_EQ("test_counter", message.envoy_metrics(0).name());
+        EXPECT_EQ(100, message.envoy_metrics(0).metric(0).counter().value());
+        EXPECT_EQ("test_gauge", message.envoy_metrics(1).name());
+        EXPECT_EQ(2, message.envoy_metrics(1).metric(0).gauge().value());
+      }));
+  sink.flush(snapshot_);
+
+  // The histogram recorded values.
+  snapshot_.counters_[0].delta_ = 0;
+  histogram_t* samples = hist_alloc();
+  hist_insert_intscale(samples, 10, 0, 1);
+  Stats::HistogramStatisticsImpl interval_statistics(samples);
+  hist_free(samples);
+  EXPECT_CALL(histogram, intervalStatistics()).WillRepeatedly(ReturnRef(interval_statistics));
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(true));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        ASSERT_EQ(2, message.envoy_metrics_size());
+        EXPECT_EQ("test_histogram", message.envoy_metrics(0).name());
+        EXPECT_EQ(1U, message.envoy_metrics(1).metric(0).histogram().sample_count());
+      }));
+  sink.flush(snapshot_);
+
+  // Everything is reported again when the stream is restarted.
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(false));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(4, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+}
+
+// Test that a gauge is reported again once it is back in a snapshot.
+TEST_F(MetricsServiceSinkTest, ReportChangedMetricsOnlyGaugeRemoved) {
+  Stats::GaugeSharedPtr gauge_ptr(new NiceMock<Stats::MockGauge>());
+  auto& gauge = dynamic_cast<Stats::MockGauge&>(*gauge_ptr);
+  gauge.name_ = "test_gauge";
+  gauge.value_ = 1;
+  gauge.used_ = true;
+
+  MetricsServiceSink sink(streamer_, time_system_, false, true, false);
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillRepeatedly(Return(true));
+
+  snapshot_.gauges_.push_back(gauge);
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(1, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+  // The sink no longer references the gauge once it isn't in a snapshot.
+  EXPECT_EQ(2U, gauge_ptr->use_count());
+
+  snapshot_.gauges_.clear();
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(0, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+  EXPECT_EQ(1U, gauge_ptr->use_count());
+
+  snapshot_.gauges_.push_back(gauge);
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(1, message.envoy_metrics_size());
+      }));
+  sink.flush(snapshot_);
+}
+
+// Test that metrics are identified by the ids of their names when configured to do so.
+TEST_F(MetricsServiceSinkTest, ReportMetricIds) {
+  NiceMock<Stats::MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.used_ = true;
+  snapshot_.counters_.push_back({1, counter});
+
+  NiceMock<Stats::MockParentHistogram> histogram;
+  histogram.name_ = "test_histogram";
+  histogram.used_ = true;
+  snapshot_.histograms_.push_back(histogram);
+
+  MetricsServiceSink sink(streamer_, time_system_, false, false, true);
+
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(false));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        ASSERT_EQ(3, message.envoy_metrics_size());
+        for (const auto& metrics_family : message.envoy_metrics()) {
+          EXPECT_EQ("", metrics_family.name());
+        }
+        // The summary and the histogram share the id of the histogram name.
+        ASSERT_EQ(3, message.envoy_metric_ids_size());
+        EXPECT_EQ(0U, message.envoy_metric_ids(0));
+        EXPECT_EQ(1U, message.envoy_metric_ids(1));
+        EXPECT_EQ(1U, message.envoy_metric_ids(2));
+        ASSERT_EQ(2, message.metric_names_size());
+        EXPECT_EQ(0U, message.metric_names(0).id());
+        EXPECT_EQ("test_counter", message.metric_names(0).name());
+        EXPECT_EQ(1U, message.metric_names(1).id());
+        EXPECT_EQ("test_histogram", message.metric_names(1).name());
+      }));
+  sink.flush(snapshot_);
+
+  // The names were sent on this stream already.
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(true));
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        EXPECT_EQ(3, message.envoy_metric_ids_size());
+        EXPECT_EQ(0, message.metric_names_size());
+      }));
+  sink.flush(snapshot_);
+}
+
+// The sink asks the server for the changed metrics only while it reports them on a started stream.
+TEST_F(MetricsServiceSinkTest, ChangedMetricsOnly) {
+  MetricsServiceSink sink(streamer_, time_system_, false, true, false);
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(false));
+  EXPECT_FALSE(sink.changedMetricsOnly());
+  EXPECT_CALL(*streamer_, isStreamStarted()).WillOnce(Return(true));
+  EXPECT_TRUE(sink.changedMetricsOnly());
+
+  MetricsServiceSink all_metrics_sink(streamer_, time_system_, false, false, false);
+  EXPECT_CALL(*streamer_, isStreamStarted()).Times(0);
+  EXPECT_FALSE(all_metrics_sink.changedMetricsOnly());
+}
+
 } // namespace
 } // namespace MetricsService
 } // namespace StatSinks
@@ -0,0 +1,110 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the serialization of a batch of buffered Zipkin spans with each collector endpoint
+// version.
+
+#include <string>
+#include <vector>
+
+#include "envoy/config/trace/v3/zipkin.pb.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/utility.h"
+
+#include "extensions/tracers/zipkin/span_buffer.h"
+#include "extensions/tracers/zipkin/zipkin_core_constants.h"
+
+#include "test/test_common/simulated_time_system.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace Zipkin {
+namespace {
+
+// Creates a client span with the tags which the HTTP connection manager usually sets.
+Span createSpan(TimeSource& time_source, uint64_t i) {
+  Endpoint endpoint;
+  endpoint.setAddress(Network::Utility::parseInternetAddress("10.0.0.1", 8080, false));
+  endpoint.setServiceName("frontend");
+
+  Annotation annotation;
+  annotation.setValue(CLIENT_SEND);
+  annotation.setTimestamp(1600000000000000 + i);
+  annotation.setEndpoint(endpoint);
+
+  std::vector<BinaryAnnotation> tags;
+  for (const auto& [key, value] : std::vector<std::pair<std::string, std::string>>{
+           {"component", "proxy"},
+           {"node_id", "frontend-6d4cf56db6-x7k2p"},
+           {"guid:x-request-id", "6a6d63c4-8e8c-4d6b-9a3a-0f6c5e1d2b7f"},
+           {"http.url", "https://www.example.com/api/v1/resources/1234567890?filter=active"},
+           {"http.method", "GET"},
+           {"downstream_cluster", "-"},
+           {"user_agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36"},
+           {"http.protocol", "HTTP/1.1"},
+           {"upstream_cluster", "backend"},
+           {"http.status_code", "200"},
+           {"response_size", "4096"},
+           {"response_flags", "-"}}) {
+    BinaryAnnotation tag;
+    tag.setKey(key);
+    tag.setValue(value);
+    tags.push_back(tag);
+  }
+
+  Span span(time_source);
+  span.setTraceIdHigh(0x463ac35c9f6413ad);
+  span.setTraceId(0x48485a3953bb6124 + i);
+  span.setId(0x1a2b3c4d5e6f7a8b + i);
+  span.setParentId(0x0102030405060708);
+  span.setName("www.example.com");
+  span.setDuration(2500 + i % 1000);
+  span.setAnnotations({annotation});
+  span.setBinaryAnnotations(tags);
+  return span;
+}
+
+void serializeSpans(benchmark::State& state,
+                    envoy::config::trace::v3::ZipkinConfig::CollectorEndpointVersion version) {
+  Event::SimulatedTimeSystem time_system;
+  const uint64_t num_spans = state.range(0);
+  SpanBuffer span_buffer(version, false, num_spans);
+  for (uint64_t i = 0; i < num_spans; i++) {
+    span_buffer.addSpan(createSpan(time_system, i));
+  }
+
+  uint64_t bytes = 0;
+  for (auto _ : state) {
+    Buffer::OwnedImpl output;
+    span_buffer.serialize(output);
+    bytes += output.length();
+  }
+  state.SetItemsProcessed(state.iterations() * num_spans);
+  state.SetBytesProcessed(bytes);
+}
+
+static void BM_SerializeJsonV1(benchmark::State& state) {
+  serializeSpans(state,
+                 envoy::config::trace::v3::ZipkinConfig::hidden_envoy_deprecated_HTTP_JSON_V1);
+}
+BENCHMARK(BM_SerializeJsonV1)->Arg(5)->Arg(100);
+
+static void BM_SerializeJsonV2(benchmark::State& state) {
+  serializeSpans(state, envoy::config::trace::v3::ZipkinConfig::HTTP_JSON);
+}
+BENCHMARK(BM_SerializeJsonV2)->Arg(5)->Arg(100);
+
+static void BM_SerializeProtobuf(benchmark::State& state) {
+  serializeSpans(state, envoy::config::trace::v3::ZipkinConfig::HTTP_PROTO);
+}
+BENCHMARK(BM_SerializeProtobuf)->Arg(5)->Arg(100);
+
+} // namespace
+} // namespace Zipkin
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
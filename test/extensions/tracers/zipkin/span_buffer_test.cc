@@ -401,6 +401,79 @@ TEST(ZipkinSpanBufferTest, SerializeSpan) {
             serializedMessageToJson<zipkin::proto3::ListOfSpans>(buffer6.serialize()));
 }
 
+Span createSpanWithEscapedStrings() {
+  Span span = createSpan({"cs", "sr"}, IpType::V6);
+  span.setTraceIdHigh(2);
+  span.setParentId(3);
+  span.setName("get \"/\\\"\n");
+  BinaryAnnotation tag;
+  tag.setKey("error\t");
+  tag.setValue(std::string("\x01\x1f", 2));
+  span.setBinaryAnnotations({createTag(), tag});
+  return span;
+}
+
+TEST(ZipkinSpanBufferTest, SerializeSpanWithEscapedStrings) {
+  SpanBuffer buffer(envoy::config::trace::v3::ZipkinConfig::HTTP_JSON, true, 2);
+  buffer.addSpan(createSpanWithEscapedStrings());
+  const std::string expected_span = R"("traceId":"00000000000000020000000000000001",)"
+                                    R"("parentId":"0000000000000003",)"
+                                    R"("id":"0000000000000001",)"
+                                    R"("name":"get \"/\\\"\n",)"
+                                    R"("timestamp":DEFAULT_TEST_TIMESTAMP,)"
+                                    R"("duration":DEFAULT_TEST_DURATION,)"
+                                    R"("localEndpoint":{)"
+                                    R"("serviceName":"service1",)"
+                                    R"("ipv6":"2001:db8:85a3::8a2e:370:4444",)"
+                                    R"("port":7334},)"
+                                    R"("tags":{)"
+                                    R"("response_size":"DEFAULT_TEST_DURATION",)"
+                                    R"("error\t":"\u0001\u001f"})";
+  EXPECT_THAT(wrapAsObject(absl::StrCat(R"([{"kind":"CLIENT",)", expected_span, "},",
+                                        R"({"kind":"SERVER","shared":true,)", expected_span, "}]")),
+              JsonStringEq(wrapAsObject(buffer.serialize())));
+}
+
+// The protobuf wire format written by the serializer is the one of zipkin::proto3::ListOfSpans.
+TEST(ZipkinSpanBufferTest, SerializeSpanAsListOfSpans) {
+  SpanBuffer buffer(envoy::config::trace::v3::ZipkinConfig::HTTP_PROTO, true, 2);
+  EXPECT_EQ("", buffer.serialize());
+  buffer.addSpan(createSpanWithEscapedStrings());
+
+  zipkin::proto3::ListOfSpans expected;
+  for (const auto kind : {zipkin::proto3::Span::CLIENT, zipkin::proto3::Span::SERVER}) {
+    auto* span = expected.add_spans();
+    span->set_trace_id(absl::StrCat(Util::toBigEndianByteString<uint64_t>(2),
+                                    Util::toBigEndianByteString<uint64_t>(1)));
+    span->set_parent_id(Util::toByteString<uint64_t>(3));
+    span->set_id(Util::toByteString<uint64_t>(1));
+    span->set_kind(kind);
+    span->set_name("get \"/\\\"\n");
+    span->set_timestamp(DEFAULT_TEST_TIMESTAMP);
+    span->set_duration(DEFAULT_TEST_DURATION);
+    auto* endpoint = span->mutable_local_endpoint();
+    endpoint->set_service_name("service1");
+    endpoint->set_ipv6(Util::toByteString(
+        Envoy::Network::Utility::parseInternetAddress("2001:db8:85a3::8a2e:370:4444", 7334, true)
+            ->ip()
+            ->ipv6()
+            ->address()));
+    endpoint->set_port(7334);
+    (*span->mutable_tags())["error\t"] = std::string("\x01\x1f", 2);
+    span->set_shared(kind == zipkin::proto3::Span::SERVER);
+  }
+
+  // The message has a single tag, so that its serialization does not depend on the order of the
+  // tags map.
+  buffer.clear();
+  Span span = createSpanWithEscapedStrings();
+  span.setBinaryAnnotations({span.binaryAnnotations()[1]});
+  buffer.addSpan(std::move(span));
+  std::string serialized;
+  expected.SerializeToString(&serialized);
+  EXPECT_EQ(serialized, buffer.serialize());
+}
+
 TEST(ZipkinSpanBufferTest, TestSerializeTimestampInTheFuture) {
   ProtobufWkt::Struct objectWithScientificNotation;
   auto* objectWithScientificNotationFields = objectWithScientificNotation.mutable_fields();
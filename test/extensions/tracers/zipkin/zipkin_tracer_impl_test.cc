@@ -21,6 +21,7 @@
 #include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -29,6 +30,7 @@
 using testing::_;
 using testing::DoAll;
 using testing::Eq;
+using testing::HasSubstr;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
@@ -486,6 +488,9 @@ TEST_F(ZipkinDriverTest, NoB3ContextSampledTrue) {
 }
 
 TEST_F(ZipkinDriverTest, NoB3ContextSampledFalse) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.zipkin_propagation_only_spans", "false"}});
   setupValidDriver("HTTP_JSON_V1");
 
   EXPECT_EQ(nullptr, request_headers_.get(ZipkinCoreConstants::get().X_B3_SPAN_ID));
@@ -516,6 +521,9 @@ TEST_F(ZipkinDriverTest, PropagateB3NoSampleDecisionSampleTrue) {
 }
 
 TEST_F(ZipkinDriverTest, PropagateB3NoSampleDecisionSampleFalse) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.zipkin_propagation_only_spans", "false"}});
   setupValidDriver("HTTP_JSON_V1");
 
   request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_TRACE_ID,
@@ -597,6 +605,9 @@ TEST_F(ZipkinDriverTest, PropagateB3SampledWithTrue) {
 }
 
 TEST_F(ZipkinDriverTest, PropagateB3SampleFalse) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.zipkin_propagation_only_spans", "false"}});
   setupValidDriver("HTTP_JSON_V1");
 
   request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_TRACE_ID,
@@ -878,6 +889,140 @@ TEST_F(ZipkinDriverTest, DuplicatedHeader) {
       });
 }
 
+TEST_F(ZipkinDriverTest, PropagationOnlySpanSharedContext) {
+  setupValidDriver("HTTP_JSON_V1");
+
+  const std::string trace_id = Hex::uint64ToHex(generateRandom64());
+  const std::string span_id = Hex::uint64ToHex(generateRandom64());
+  const std::string parent_id = Hex::uint64ToHex(generateRandom64());
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_TRACE_ID, trace_id);
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_SPAN_ID, span_id);
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID, parent_id);
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_SAMPLED, NOT_SAMPLED);
+
+  Tracing::SpanPtr span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                             start_time_, {Tracing::Reason::Sampling, true});
+  EXPECT_FALSE(span->isRecording());
+
+  // The ingress span shares the context of the downstream span.
+  Http::TestRequestHeaderMapImpl injected_headers;
+  span->injectContext(injected_headers);
+  EXPECT_EQ(trace_id, injected_headers.get_(ZipkinCoreConstants::get().X_B3_TRACE_ID));
+  EXPECT_EQ(span_id, injected_headers.get_(ZipkinCoreConstants::get().X_B3_SPAN_ID));
+  EXPECT_EQ(parent_id, injected_headers.get_(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID));
+  EXPECT_EQ(NOT_SAMPLED, injected_headers.get_(ZipkinCoreConstants::get().X_B3_SAMPLED));
+
+  // The egress child gets a new id, and is not recorded either.
+  config_.operation_name_ = Tracing::OperationName::Egress;
+  EXPECT_CALL(random_, random()).WillOnce(Return(42));
+  Tracing::SpanPtr child = span->spawnChild(config_, "child", start_time_);
+  EXPECT_FALSE(child->isRecording());
+
+  Http::TestRequestHeaderMapImpl child_headers;
+  child->injectContext(child_headers);
+  EXPECT_EQ(trace_id, child_headers.get_(ZipkinCoreConstants::get().X_B3_TRACE_ID));
+  EXPECT_EQ(Hex::uint64ToHex(42), child_headers.get_(ZipkinCoreConstants::get().X_B3_SPAN_ID));
+  EXPECT_EQ(span_id, child_headers.get_(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID));
+  EXPECT_EQ(NOT_SAMPLED, child_headers.get_(ZipkinCoreConstants::get().X_B3_SAMPLED));
+
+  // Nothing is reported.
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.min_flush_spans", _)).Times(0);
+  child->setTag("key", "value");
+  child->finishSpan();
+  span->finishSpan();
+}
+
+TEST_F(ZipkinDriverTest, PropagationOnlyRootSpanSetSampled) {
+  setupValidDriver("HTTP_JSON_V1");
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(7)).WillOnce(Return(8));
+  Tracing::SpanPtr span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                             start_time_, {Tracing::Reason::Sampling, false});
+  EXPECT_FALSE(span->isRecording());
+
+  Http::TestRequestHeaderMapImpl injected_headers;
+  span->injectContext(injected_headers);
+  EXPECT_EQ(Hex::uint64ToHex(7), injected_headers.get_(ZipkinCoreConstants::get().X_B3_TRACE_ID));
+  EXPECT_EQ(Hex::uint64ToHex(7), injected_headers.get_(ZipkinCoreConstants::get().X_B3_SPAN_ID));
+  EXPECT_FALSE(injected_headers.has(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID));
+  EXPECT_EQ(NOT_SAMPLED, injected_headers.get_(ZipkinCoreConstants::get().X_B3_SAMPLED));
+
+  // Overriding the sampling decision is propagated, and the span and its children are recorded.
+  span->setSampled(true);
+  EXPECT_TRUE(span->isRecording());
+  span->injectContext(injected_headers);
+  EXPECT_EQ(SAMPLED, injected_headers.get_(ZipkinCoreConstants::get().X_B3_SAMPLED));
+
+  config_.operation_name_ = Tracing::OperationName::Egress;
+  Tracing::SpanPtr child = span->spawnChild(config_, "child", start_time_);
+  EXPECT_TRUE(child->isRecording());
+
+  ZipkinSpanPtr zipkin_child(dynamic_cast<ZipkinSpan*>(child.release()));
+  EXPECT_EQ(7U, zipkin_child->span().traceId());
+  EXPECT_EQ(8U, zipkin_child->span().id());
+  EXPECT_EQ(7U, zipkin_child->span().parentId());
+  EXPECT_TRUE(zipkin_child->span().sampled());
+}
+
+// Verifies the pattern of the async client and of the request mirroring of the router: a child
+// of a span which is not sampled is spawned, and its sampling decision is overridden. The child
+// is then recorded and reported.
+TEST_F(ZipkinDriverTest, PropagationOnlySpanChildSetSampled) {
+  setupValidDriver("HTTP_JSON_V1");
+
+  const std::string trace_id = Hex::uint64ToHex(generateRandom64());
+  const std::string span_id = Hex::uint64ToHex(generateRandom64());
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_TRACE_ID, trace_id);
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_SPAN_ID, span_id);
+  request_headers_.addReferenceKey(ZipkinCoreConstants::get().X_B3_SAMPLED, NOT_SAMPLED);
+
+  Tracing::SpanPtr span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                             start_time_, {Tracing::Reason::Sampling, true});
+  EXPECT_FALSE(span->isRecording());
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(42));
+  Tracing::SpanPtr child =
+      span->spawnChild(Tracing::EgressConfig::get(), "async fake_cluster egress", start_time_);
+  EXPECT_FALSE(child->isRecording());
+  child->setSampled(true);
+  EXPECT_TRUE(child->isRecording());
+
+  Http::TestRequestHeaderMapImpl child_headers;
+  child->injectContext(child_headers);
+  EXPECT_EQ(trace_id, child_headers.get_(ZipkinCoreConstants::get().X_B3_TRACE_ID));
+  EXPECT_EQ(Hex::uint64ToHex(42), child_headers.get_(ZipkinCoreConstants::get().X_B3_SPAN_ID));
+  EXPECT_EQ(span_id, child_headers.get_(ZipkinCoreConstants::get().X_B3_PARENT_SPAN_ID));
+  EXPECT_EQ(SAMPLED, child_headers.get_(ZipkinCoreConstants::get().X_B3_SAMPLED));
+
+  // Only the child is reported.
+  Http::MockAsyncClientRequest request(&cm_.async_client_);
+  Http::AsyncClient::Callbacks* callback;
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::RequestMessagePtr& message, Http::AsyncClient::Callbacks& callbacks,
+                     const Http::AsyncClient::RequestOptions&) -> Http::AsyncClient::Request* {
+            callback = &callbacks;
+            const std::string body = message->bodyAsString();
+            EXPECT_THAT(body, HasSubstr("\"name\":\"async fake_cluster egress\""));
+            EXPECT_THAT(body, HasSubstr("\"id\":\"" + Hex::uint64ToHex(42) + "\""));
+            EXPECT_THAT(body, HasSubstr("\"value\":\"cs\""));
+            EXPECT_THAT(body, HasSubstr("\"value\":\"cr\""));
+            return &request;
+          }));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.min_flush_spans", 5))
+      .WillOnce(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.request_timeout", 5000U))
+      .WillOnce(Return(5000U));
+  child->setTag("key", "value");
+  child->finishSpan();
+  span->finishSpan();
+
+  Http::ResponseMessagePtr msg(new Http::ResponseMessageImpl(
+      Http::ResponseHeaderMapPtr{new Http::TestResponseHeaderMapImpl{{":status", "202"}}}));
+  callback->onSuccess(request, std::move(msg));
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
+}
+
 } // namespace
 } // namespace Zipkin
 } // namespace Tracers
@@ -350,6 +350,14 @@ public:
     Thread::LockGuard lock(lock_);
     return store_.textReadouts();
   }
+  void trackChangedMetrics() override {
+    Thread::LockGuard lock(lock_);
+    store_.trackChangedMetrics();
+  }
+  ChangedMetrics collectChangedMetrics() override {
+    Thread::LockGuard lock(lock_);
+    return store_.collectChangedMetrics();
+  }
 
   bool iterate(const IterateFn<Counter>& fn) const override { return store_.iterate(fn); }
   bool iterate(const IterateFn<Gauge>& fn) const override { return store_.iterate(fn); }
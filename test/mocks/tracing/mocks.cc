@@ -8,7 +8,7 @@ using testing::Return;
 namespace Envoy {
 namespace Tracing {
 
-MockSpan::MockSpan() = default;
+MockSpan::MockSpan() { ON_CALL(*this, isRecording()).WillByDefault(Return(true)); }
 MockSpan::~MockSpan() = default;
 
 MockConfig::MockConfig() {
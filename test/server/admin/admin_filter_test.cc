@@ -1,5 +1,7 @@
 #include "server/admin/admin_filter.h"
 
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/server/instance.h"
 #include "test/test_common/environment.h"
 
@@ -7,6 +9,7 @@
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::Mock;
 using testing::NiceMock;
 
 namespace Envoy {
@@ -77,5 +80,69 @@ TEST_P(AdminFilterTest, Trailers) {
   EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_.decodeTrailers(request_trailers));
 }
 
+// A handler can send the rest of its response in chunks, one per dispatcher iteration, which are
+// paused while the downstream connection is above its high watermark.
+TEST_P(AdminFilterTest, ChunkedResponse) {
+  uint32_t chunks_left = 2;
+  AdminFilter filter([&chunks_left](absl::string_view, Http::ResponseHeaderMap&,
+                                    Buffer::OwnedImpl& response, AdminFilter& filter) {
+    response.add("head\n");
+    filter.setChunkedResponse([&chunks_left](Buffer::Instance& chunk) -> bool {
+      chunk.add(absl::StrCat("chunk", chunks_left, "\n"));
+      return --chunks_left > 0;
+    });
+    return Http::Code::OK;
+  });
+  filter.setDecoderFilterCallbacks(callbacks_);
+  auto* next_chunk = new NiceMock<Event::MockSchedulableCallback>(&callbacks_.dispatcher_);
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("head\n"), false));
+  EXPECT_CALL(callbacks_, addDownstreamWatermarkCallbacks(_));
+  EXPECT_CALL(*next_chunk, scheduleCallbackNextIteration());
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter.decodeHeaders(request_headers_, true));
+  Mock::VerifyAndClearExpectations(&callbacks_);
+
+  // The scheduled chunk is still sent, but the next one waits for the low watermark.
+  filter.onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("chunk2\n"), false));
+  EXPECT_CALL(*next_chunk, scheduleCallbackNextIteration()).Times(0);
+  next_chunk->invokeCallback();
+  Mock::VerifyAndClearExpectations(next_chunk);
+
+  EXPECT_CALL(*next_chunk, scheduleCallbackNextIteration());
+  filter.onBelowWriteBufferLowWatermark();
+
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("chunk1\n"), true));
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  next_chunk->invokeCallback();
+  EXPECT_FALSE(filter.chunkGenerator());
+  filter.onDestroy();
+}
+
+// Chunk generation stops when the stream is destroyed before the response is complete.
+TEST_P(AdminFilterTest, ChunkedResponseDestroyed) {
+  AdminFilter filter([](absl::string_view, Http::ResponseHeaderMap&, Buffer::OwnedImpl&,
+                        AdminFilter& filter) {
+    filter.setChunkedResponse([](Buffer::Instance& chunk) -> bool {
+      chunk.add("chunk\n");
+      return true;
+    });
+    return Http::Code::OK;
+  });
+  filter.setDecoderFilterCallbacks(callbacks_);
+  auto* next_chunk = new NiceMock<Event::MockSchedulableCallback>(&callbacks_.dispatcher_);
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(_, _)).Times(0);
+  filter.decodeHeaders(request_headers_, true);
+  EXPECT_TRUE(next_chunk->enabled_);
+
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  filter.onDestroy();
+  EXPECT_FALSE(next_chunk->enabled_);
+  EXPECT_FALSE(filter.chunkGenerator());
+}
+
 } // namespace Server
 } // namespace Envoy
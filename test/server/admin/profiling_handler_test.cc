@@ -1,7 +1,12 @@
+#include "common/event/slow_callback_tracer.h"
+#include "common/profiler/continuous_profiler.h"
 #include "common/profiler/profiler.h"
 
 #include "test/server/admin/admin_instance.h"
 #include "test/test_common/logging.h"
+#include "test/test_common/simulated_time_system.h"
+
+using testing::HasSubstr;
 
 namespace Envoy {
 namespace Server {
@@ -78,5 +83,65 @@ TEST_P(AdminInstanceTest, AdminBadProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminSlowCallbacks) {
+  Buffer::OwnedImpl data;
+  Http::TestResponseHeaderMapImpl header_map;
+
+  EXPECT_EQ(Http::Code::BadRequest,
+            postCallback("/slow_callbacks/enable?threshold_us=abc", header_map, data));
+  EXPECT_EQ(Http::Code::BadRequest, postCallback("/slow_callbacks/enable?foo=1", header_map, data));
+  EXPECT_FALSE(Event::SlowCallbackTracer::enabled());
+
+  data.drain(data.length());
+  EXPECT_EQ(Http::Code::OK,
+            postCallback("/slow_callbacks/enable?threshold_us=0", header_map, data));
+  EXPECT_TRUE(Event::SlowCallbackTracer::enabled());
+
+  // A tracer records every callback with a zero threshold.
+  Event::SimulatedTimeSystem time_system;
+  Event::SlowCallbackTracer tracer("worker_0", time_system);
+  {
+    Event::SlowCallbackTracer::CallbackScope scope(&tracer,
+                                                   Event::SlowCallbackTracer::CallbackType::Timer);
+    time_system.advanceTimeWait(std::chrono::microseconds(1500));
+  }
+
+  data.drain(data.length());
+  EXPECT_EQ(Http::Code::OK, getCallback("/slow_callbacks", header_map, data));
+  EXPECT_THAT(data.toString(), HasSubstr("tracing: enabled\n"));
+  EXPECT_THAT(data.toString(), HasSubstr("worker_0: 1 slow callbacks\n"));
+  EXPECT_THAT(data.toString(), HasSubstr(" timer 1500us\n"));
+
+  EXPECT_EQ(Http::Code::OK, postCallback("/slow_callbacks/disable", header_map, data));
+  EXPECT_FALSE(Event::SlowCallbackTracer::enabled());
+  data.drain(data.length());
+  EXPECT_EQ(Http::Code::OK, getCallback("/slow_callbacks", header_map, data));
+  EXPECT_THAT(data.toString(), HasSubstr("tracing: disabled\n"));
+  EXPECT_THAT(data.toString(), HasSubstr("worker_0: 1 slow callbacks\n"));
+}
+
+TEST_P(AdminInstanceTest, AdminPprofProfile) {
+  Buffer::OwnedImpl data;
+  Http::TestResponseHeaderMapImpl header_map;
+
+  EXPECT_EQ(Http::Code::NotFound, getCallback("/pprof/profile", header_map, data));
+
+  admin_.startContinuousProfiler({});
+  EXPECT_TRUE(Profiler::ContinuousProfiler::running());
+  EXPECT_EQ(Http::Code::BadRequest, getCallback("/pprof/profile?seconds=0", header_map, data));
+  EXPECT_EQ(Http::Code::BadRequest, getCallback("/pprof/profile?foo=1", header_map, data));
+
+  data.drain(data.length());
+  EXPECT_EQ(Http::Code::OK, getCallback("/pprof/profile?seconds=10", header_map, data));
+  EXPECT_EQ(Http::Headers::get().ContentTypeValues.Protobuf, header_map.getContentTypeValue());
+  Protobuf::UnknownFieldSet profile;
+  EXPECT_TRUE(profile.ParseFromString(data.toString()));
+  EXPECT_LT(0, profile.field_count());
+
+  // Both profilers sample with SIGPROF.
+  EXPECT_EQ(Http::Code::BadRequest, postCallback("/cpuprofiler?enable=y", header_map, data));
+  EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -701,5 +701,46 @@ envoy_cluster_test_1_upstream_cx_total{a_tag_name="a.tag-value"} 0
   EXPECT_EQ(expected_output, response.toString());
 }
 
+// The streamed chunks add up to the statsAsPrometheus() output, with a chunk size of zero
+// producing one metric group per chunk.
+TEST_F(PrometheusStatsFormatterTest, StreamerChunks) {
+  for (const char* cluster : {"ccc", "aaa"}) {
+    const Stats::StatNameTagVector tags{{makeStat("cluster"), makeStat(cluster)}};
+    addCounter("cluster.upstream_cx_total", tags);
+    addCounter("cluster.upstream_cx_connect_fail", tags);
+    addGauge("cluster.upstream_cx_active", tags);
+  }
+  addCounter("filtered.out", {});
+  const absl::optional<std::regex> regex{std::regex("cluster")};
+
+  Buffer::OwnedImpl expected;
+  EXPECT_EQ(3UL, PrometheusStatsFormatter::statsAsPrometheus(counters_, gauges_, histograms_,
+                                                             expected, false, regex));
+
+  PrometheusStatsStreamer streamer(counters_, gauges_, histograms_, false, regex);
+  std::vector<std::string> chunks;
+  bool more = true;
+  while (more) {
+    Buffer::OwnedImpl chunk;
+    more = streamer.nextChunk(chunk, 0);
+    chunks.push_back(chunk.toString());
+  }
+  EXPECT_EQ(3UL, streamer.metricNameCount());
+  EXPECT_EQ(expected.toString(), absl::StrJoin(chunks, ""));
+  // Two counter groups and one gauge group; the final chunk is empty as there are no histograms.
+  ASSERT_EQ(4, chunks.size());
+  EXPECT_EQ("# TYPE envoy_cluster_upstream_cx_connect_fail counter\n"
+            "envoy_cluster_upstream_cx_connect_fail{cluster=\"aaa\"} 0\n"
+            "envoy_cluster_upstream_cx_connect_fail{cluster=\"ccc\"} 0\n\n",
+            chunks[0]);
+  EXPECT_EQ("", chunks[3]);
+
+  // A large chunk holds everything.
+  PrometheusStatsStreamer single_chunk_streamer(counters_, gauges_, histograms_, false, regex);
+  Buffer::OwnedImpl response;
+  EXPECT_FALSE(single_chunk_streamer.nextChunk(response, 1024 * 1024));
+  EXPECT_EQ(expected.toString(), response.toString());
+}
+
 } // namespace Server
 } // namespace Envoy
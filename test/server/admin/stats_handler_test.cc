@@ -506,6 +506,55 @@ TEST_P(AdminStatsTest, UsedOnlyStatsAsJsonFilterString) {
   store_->shutdownThreading();
 }
 
+// The streamed text output is in full name order although metrics are sorted one scope at a time,
+// and counters take precedence over gauges with the same name.
+TEST_P(AdminStatsTest, TextStreamerOutput) {
+  store_->textReadoutFromString("b.version").set("1.0 <a>");
+  for (const char* name : {"c.z", "c-d.a", "c.a.y", "c.a.x", "c", "c.a-b", "c.b.y", "c_d", "a"}) {
+    store_->counterFromString(name).inc();
+  }
+  store_->counterFromString("unused");
+  store_->gaugeFromString("c.z", Stats::Gauge::ImportMode::Accumulate).set(5);
+  store_->gaugeFromString("c.g", Stats::Gauge::ImportMode::Accumulate).set(7);
+  store_->histogramFromString("h.a", Stats::Histogram::Unit::Unspecified);
+
+  auto stream = [this](bool used_only, const absl::optional<std::regex>& regex,
+                       uint64_t max_sorted_scope_size, uint64_t chunk_size) -> std::string {
+    StatsTextStreamer streamer(*store_, used_only, regex, max_sorted_scope_size);
+    std::string output;
+    bool more = true;
+    while (more) {
+      Buffer::OwnedImpl chunk;
+      more = streamer.nextChunk(chunk, chunk_size);
+      output += chunk.toString();
+    }
+    return output;
+  };
+
+  const std::string used_output = "a: 1\n"
+                                  "c: 1\n"
+                                  "c-d.a: 1\n"
+                                  "c.a-b: 1\n"
+                                  "c.a.x: 1\n"
+                                  "c.a.y: 1\n"
+                                  "c.b.y: 1\n"
+                                  "c.g: 7\n"
+                                  "c.z: 1\n"
+                                  "c_d: 1\n";
+  const std::string output = absl::StrCat("b.version: \"1.0 &lt;a&gt;\"\n", used_output,
+                                          "unused: 0\n"
+                                          "h.a: No recorded values\n");
+  EXPECT_EQ(output,
+            stream(false, absl::nullopt, StatsTextStreamer::DefaultMaxSortedScopeSize, 1 << 20));
+  // Partitioning every scope and sending a chunk per scope does not change the output.
+  EXPECT_EQ(output, stream(false, absl::nullopt, 1, 0));
+  EXPECT_EQ(output, stream(false, absl::nullopt, 2, 16));
+  EXPECT_EQ(used_output, stream(true, absl::nullopt, 1, 0));
+  EXPECT_EQ("c.a.x: 1\nc.a.y: 1\n", stream(false, std::regex("^c\\.a\\."), 1, 0));
+  EXPECT_EQ("c.z: 1\n", stream(true, std::regex("z"), 1, 1 << 20));
+  EXPECT_EQ("", stream(false, std::regex("nothing"), 1, 0));
+}
+
 INSTANTIATE_TEST_SUITE_P(IpVersions, AdminInstanceTest,
                          testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
                          TestUtility::ipTestParamsToString);
@@ -0,0 +1,96 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/sink.h"
+
+#include "common/stats/allocator_impl.h"
+#include "common/stats/symbol_table_creator.h"
+#include "common/stats/thread_local_store.h"
+
+#include "server/server.h"
+
+#include "test/common/stats/stat_test_utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Server {
+
+class NullSink : public Stats::Sink {
+public:
+  explicit NullSink(bool changed_metrics_only) : changed_metrics_only_(changed_metrics_only) {}
+
+  // Stats::Sink
+  void flush(Stats::MetricSnapshot& snapshot) override {
+    benchmark::DoNotOptimize(snapshot.counters().size() + snapshot.gauges().size());
+  }
+  void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
+  bool changedMetricsOnly() const override { return changed_metrics_only_; }
+
+private:
+  const bool changed_metrics_only_;
+};
+
+class FlushMetricsPerf {
+public:
+  FlushMetricsPerf(int num_clusters, bool changed_metrics_only)
+      : symbol_table_(Stats::SymbolTableCreator::makeSymbolTable()), alloc_(*symbol_table_),
+        store_(alloc_) {
+    Stats::TestUtil::forEachSampleStat(num_clusters, [this](absl::string_view name) {
+      counters_.push_back(&store_.counterFromString(std::string(name)));
+      gauges_.push_back(&store_.gaugeFromString(absl::StrCat(name, ".gauge"),
+                                                Stats::Gauge::ImportMode::Accumulate));
+    });
+    sinks_.push_back(std::make_unique<NullSink>(changed_metrics_only));
+    // The first flush of the changed metrics has all of them.
+    InstanceUtil::flushMetricsToSinks(sinks_, store_);
+  }
+
+  ~FlushMetricsPerf() { store_.shutdownThreading(); }
+
+  // Changes one in a hundred of the counters and gauges, as in a large configuration most of the
+  // clusters get no traffic during a flush interval, and flushes them.
+  void flush() {
+    for (size_t i = offset_; i < counters_.size(); i += 100) {
+      counters_[i]->inc();
+      gauges_[i]->inc();
+    }
+    offset_ = (offset_ + 1) % 100;
+    InstanceUtil::flushMetricsToSinks(sinks_, store_);
+  }
+
+private:
+  Stats::SymbolTablePtr symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::ThreadLocalStoreImpl store_;
+  std::vector<Stats::Counter*> counters_;
+  std::vector<Stats::Gauge*> gauges_;
+  std::list<Stats::SinkPtr> sinks_;
+  size_t offset_{};
+};
+
+} // namespace Server
+} // namespace Envoy
+
+// Flushes all the metrics to a sink.
+static void BM_FlushAllMetrics(benchmark::State& state) {
+  Envoy::Server::FlushMetricsPerf context(state.range(0), false);
+  for (auto _ : state) {
+    context.flush();
+  }
+}
+BENCHMARK(BM_FlushAllMetrics)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+// Flushes the changed metrics to a sink which opts in.
+static void BM_FlushChangedMetrics(benchmark::State& state) {
+  Envoy::Server::FlushMetricsPerf context(state.range(0), true);
+  for (auto _ : state) {
+    context.flush();
+  }
+}
+BENCHMARK(BM_FlushChangedMetrics)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
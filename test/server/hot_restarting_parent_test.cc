@@ -152,6 +152,56 @@ TEST_F(HotRestartingParentTest, RetainDynamicStats) {
   }
 }
 
+// A child that accepts a snapshot gets the stats in a memory file, dynamic segments included.
+TEST_F(HotRestartingParentTest, ExportStatsSnapshotToChild) {
+  MockListenerManager listener_manager;
+  Stats::SymbolTableImpl parent_symbol_table;
+  Stats::TestUtil::TestStore parent_store(parent_symbol_table);
+
+  EXPECT_CALL(server_, listenerManager()).WillRepeatedly(ReturnRef(listener_manager));
+  EXPECT_CALL(listener_manager, numConnections()).WillRepeatedly(Return(0));
+  EXPECT_CALL(server_, stats()).WillRepeatedly(ReturnRef(parent_store));
+
+  HotRestartMessage::Reply::Stats stats_proto;
+  {
+    Stats::StatNameDynamicPool dynamic(parent_store.symbolTable());
+    parent_store.counter("c1").inc();
+    parent_store.counterFromStatName(dynamic.add("c2.x")).add(2);
+    parent_store.gauge("g1", Stats::Gauge::ImportMode::Accumulate).set(123);
+    parent_store.gaugeFromStatName(dynamic.add("g2"), Stats::Gauge::ImportMode::Accumulate).set(42);
+    // Used, but without a delta to send.
+    parent_store.counter("c3").inc();
+    parent_store.counter("c3").latch();
+    hot_restarting_parent_.exportStatsToChild(&stats_proto, true);
+    EXPECT_EQ(0, parent_store.counter("c1").latch());
+  }
+  EXPECT_GT(stats_proto.snapshot_size(), 0);
+  EXPECT_NE(-1, stats_proto.snapshot_fd());
+  EXPECT_TRUE(stats_proto.counter_deltas().empty());
+  EXPECT_TRUE(stats_proto.gauges().empty());
+  EXPECT_TRUE(stats_proto.dynamics().empty());
+
+  {
+    Stats::SymbolTableImpl child_symbol_table;
+    Stats::TestUtil::TestStore child_store(child_symbol_table);
+    Stats::StatNameDynamicPool dynamic(child_store.symbolTable());
+    Stats::Counter& c1 = child_store.counter("c1");
+    Stats::Counter& c2 = child_store.counterFromStatName(dynamic.add("c2.x"));
+    Stats::Gauge& g1 = child_store.gauge("g1", Stats::Gauge::ImportMode::Accumulate);
+    Stats::Gauge& g2 =
+        child_store.gaugeFromStatName(dynamic.add("g2"), Stats::Gauge::ImportMode::Accumulate);
+
+    // The child maps and closes the memory file.
+    HotRestartingChild hot_restarting_child(0, 0);
+    hot_restarting_child.mergeParentStats(child_store, stats_proto);
+    EXPECT_EQ(1, c1.value());
+    EXPECT_EQ(2, c2.value());
+    EXPECT_EQ(123, g1.value());
+    EXPECT_EQ(42, g2.value());
+    EXPECT_FALSE(child_store.findCounterByString("c3").has_value());
+  }
+}
+
 TEST_F(HotRestartingParentTest, DrainListeners) {
   EXPECT_CALL(server_, drainListeners());
   hot_restarting_parent_.drainListeners();
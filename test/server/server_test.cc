@@ -95,6 +95,70 @@ TEST(ServerInstanceUtil, flushHelper) {
   InstanceUtil::flushMetricsToSinks(sinks, mock_store);
 }
 
+class ChangedMetricsSink : public Stats::MockSink {
+public:
+  bool changedMetricsOnly() const override { return true; }
+};
+
+TEST(ServerInstanceUtil, flushChangedMetrics) {
+  InSequence s;
+
+  Stats::TestUtil::TestStore store;
+  Stats::Counter& c1 = store.counter("c1");
+  Stats::Counter& c2 = store.counter("c2");
+  Stats::Gauge& g1 = store.gauge("g1", Stats::Gauge::ImportMode::Accumulate);
+  Stats::Gauge& g2 = store.gauge("g2", Stats::Gauge::ImportMode::Accumulate);
+  store.textReadout("text").set("is important");
+  c1.inc();
+  g1.set(5);
+
+  std::list<Stats::SinkPtr> sinks;
+  Stats::MockSink* changed_sink = new StrictMock<ChangedMetricsSink>();
+  sinks.emplace_back(changed_sink);
+
+  // All the gauges are in the first snapshot, as the stats which changed before the first flush
+  // are not known. Only the counters which incremented are.
+  EXPECT_CALL(*changed_sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.counters().size(), 1);
+    EXPECT_EQ(snapshot.counters()[0].counter_.get().name(), "c1");
+    EXPECT_EQ(snapshot.counters()[0].delta_, 1);
+    EXPECT_EQ(snapshot.gauges().size(), 2);
+    EXPECT_EQ(snapshot.textReadouts().size(), 1);
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+
+  EXPECT_CALL(*changed_sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.counters().size(), 1);
+    EXPECT_EQ(snapshot.counters()[0].counter_.get().name(), "c2");
+    EXPECT_EQ(snapshot.counters()[0].delta_, 2);
+    ASSERT_EQ(snapshot.gauges().size(), 1);
+    EXPECT_EQ(snapshot.gauges()[0].get().name(), "g2");
+    EXPECT_EQ(snapshot.textReadouts().size(), 1);
+  }));
+  c2.add(2);
+  g2.set(3);
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+
+  // A sink which doesn't opt in still gets all the metrics.
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
+  sinks.emplace_back(sink);
+  EXPECT_CALL(*changed_sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.counters().size(), 1);
+    EXPECT_EQ(snapshot.counters()[0].counter_.get().name(), "c1");
+    EXPECT_EQ(snapshot.counters()[0].delta_, 1);
+    EXPECT_TRUE(snapshot.gauges().empty());
+    EXPECT_EQ(snapshot.textReadouts().size(), 1);
+  }));
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_EQ(snapshot.counters().size(), 2);
+    EXPECT_EQ(snapshot.gauges().size(), 2);
+    EXPECT_EQ(snapshot.textReadouts().size(), 1);
+  }));
+  c1.inc();
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+  EXPECT_EQ(0, c1.latch());
+}
+
 class RunHelperTest : public testing::Test {
 public:
   RunHelperTest() {
@@ -220,6 +220,10 @@ def FormatHeaderFromFile(source_code_info, file_proto, empty_file):
   if file_proto.service:
     options.java_generic_services = True
 
+  # Arena allocation is opted into by the files whose messages are built on hot paths.
+  if file_proto.options.cc_enable_arenas:
+    options.cc_enable_arenas = True
+
   if file_proto.options.HasExtension(migrate_pb2.file_migrate):
     options.Extensions[migrate_pb2.file_migrate].CopyFrom(
         file_proto.options.Extensions[migrate_pb2.file_migrate])